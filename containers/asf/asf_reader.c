@@ -60,6 +60,7 @@ Defines.
 #define ASF_UNKNOWN_PTS ((uint32_t)(-1))
 #define ASF_MAX_CONSECUTIVE_CORRUPTED_PACKETS 100
 #define ASF_MAX_SEARCH_PACKETS 1000
+#define ASF_SIMPLE_INDEX_CACHE_MAX_ENTRIES (1<<18) /* i.e. at most 1MB of cached index */
 
 #define ASF_SKIP_GUID(ctx, size, n) (size -= 16, SKIP_GUID(ctx,n))
 #define ASF_SKIP_U8(ctx, size, n)   (size -= 1, SKIP_U8(ctx,n))
@@ -151,6 +152,10 @@ typedef struct VC_CONTAINER_TRACK_MODULE_T
       uint32_t num_entries;
       int64_t  time_interval; /* in uS */
       bool     incomplete;    /* The index does not go to the end of the file */
+      uint32_t *packet_nums;  /**< Packet numbers of all the entries, cached in
+                                   memory at open time; NULL if the index was too
+                                   big to cache, in which case entries are read
+                                   from the file on demand */
    } simple_index;
 
 } VC_CONTAINER_TRACK_MODULE_T;
@@ -823,7 +828,24 @@ static VC_CONTAINER_STATUS_T asf_read_object_simple_index( VC_CONTAINER_T *p_ctx
    }
    size = i * 6;
 #else
-   size = CACHE_BYTES(p_ctx, count * 6);
+   /* Cache the packet numbers in memory so that seeking doesn't have to go
+      back to the index on disk. If the index is too big to cache (or we're out
+      of memory), seeking falls back to reading entries on demand. */
+   if(count <= ASF_SIMPLE_INDEX_CACHE_MAX_ENTRIES)
+      track_module->simple_index.packet_nums = malloc(count * sizeof(uint32_t));
+
+   if(track_module->simple_index.packet_nums)
+   {
+      for(i = 0; i < count; i++)
+      {
+         track_module->simple_index.packet_nums[i] = ASF_READ_U32(p_ctx, size, "Packet Number");
+         ASF_SKIP_U16(p_ctx, size, "Packet Count");
+         if(STREAM_STATUS(p_ctx) != VC_CONTAINER_SUCCESS) break;
+      }
+      size = i * 6;
+   }
+   else
+      size = CACHE_BYTES(p_ctx, count * 6);
 #endif
 
    /* Check that the index is complete */
@@ -1479,43 +1501,51 @@ static VC_CONTAINER_STATUS_T asf_reader_read( VC_CONTAINER_T *p_ctx,
       SEEK(p_ctx, state_pos);
    }
 
-   /* Look at the next payload header */
-   status = asf_read_next_payload_header( p_ctx, p_state, &track, &data_size );
-   if((status == VC_CONTAINER_ERROR_CORRUPTED)
-      && (p_state->bad_packets < ASF_MAX_CONSECUTIVE_CORRUPTED_PACKETS))
+   /* Look at the next payload header. Payloads for invalid or disabled tracks
+      are skipped in one pass here rather than returning to the caller for
+      each of them in turn. */
+   for(;;)
    {
-      /* If the current packet is corrupted we will try to search for the next packet */
-      uint32_t corrupted = p_state->bad_packets;
-      LOG_DEBUG(p_ctx, "packet offset %"PRIi64" is corrupted", p_state->start);
-      memset(p_state, 0, sizeof(*p_state));
-      p_state->bad_packets = corrupted + 1;
+      status = asf_read_next_payload_header( p_ctx, p_state, &track, &data_size );
+      if((status == VC_CONTAINER_ERROR_CORRUPTED)
+         && (p_state->bad_packets < ASF_MAX_CONSECUTIVE_CORRUPTED_PACKETS))
+      {
+         /* If the current packet is corrupted we will try to search for the next packet */
+         uint32_t corrupted = p_state->bad_packets;
+         LOG_DEBUG(p_ctx, "packet offset %"PRIi64" is corrupted", p_state->start);
+         memset(p_state, 0, sizeof(*p_state));
+         p_state->bad_packets = corrupted + 1;
 
-      /* TODO: flag discontinuity */
+         /* TODO: flag discontinuity */
 
-      if(asf_find_packet_header(p_ctx, p_state) == VC_CONTAINER_SUCCESS)
+         if(asf_find_packet_header(p_ctx, p_state) == VC_CONTAINER_SUCCESS)
+         {
+            p_state->start = STREAM_POSITION(p_ctx);
+            return VC_CONTAINER_ERROR_CONTINUE;
+         }
+      }
+      if(status == VC_CONTAINER_ERROR_EOS) p_state->eos = true;
+      if(status == VC_CONTAINER_ERROR_CORRUPTED) p_state->corrupted = true;
+      if(status != VC_CONTAINER_SUCCESS)
       {
-         p_state->start = STREAM_POSITION(p_ctx);
-         return VC_CONTAINER_ERROR_CONTINUE;
+         return status;
       }
-   }
-   if(status == VC_CONTAINER_ERROR_EOS) p_state->eos = true;
-   if(status == VC_CONTAINER_ERROR_CORRUPTED) p_state->corrupted = true;
-   if(status != VC_CONTAINER_SUCCESS)
-   {
-      return status;
-   }
 
-   p_state->bad_packets = 0;
+      p_state->bad_packets = 0;
 
-   /* bad track number or track is disabled */
-   if(track >= p_ctx->tracks_num || !p_ctx->tracks[track]->is_enabled)
-   {
-      LOG_DEBUG(p_ctx, "skipping packet because track %u is invalid or disabled", track);
+      /* bad track number or track is disabled */
+      if(track >= p_ctx->tracks_num || !p_ctx->tracks[track]->is_enabled)
+      {
+         LOG_DEBUG(p_ctx, "skipping packet because track %u is invalid or disabled", track);
 
-      /* Skip payload by reading with a null buffer */
-      status = asf_read_next_payload(p_ctx, p_state, 0, &data_size );
-      if(status != VC_CONTAINER_SUCCESS) return status;
-      return VC_CONTAINER_ERROR_CONTINUE;
+         /* Skip payload by reading with a null buffer and move straight on to
+            the next payload */
+         status = asf_read_next_payload(p_ctx, p_state, 0, &data_size );
+         if(status != VC_CONTAINER_SUCCESS) return status;
+         continue;
+      }
+
+      break;
    }
 
    track_module = p_ctx->tracks[track]->priv->module;
@@ -1660,11 +1690,17 @@ static VC_CONTAINER_STATUS_T asf_reader_index_find_time( VC_CONTAINER_T *p_ctx,
       eos = true;
    }
 
-   /* Fetch the entry from the index */
-   status = SEEK(p_ctx, track_module->simple_index.offset + 6 * entry);
-   if(status != VC_CONTAINER_SUCCESS) return status;
-   *packet_num = READ_U32(p_ctx, "Packet Number");
-   if(STREAM_STATUS(p_ctx) != VC_CONTAINER_SUCCESS) return STREAM_STATUS(p_ctx);
+   /* Fetch the entry from the in-memory cache, or from the index on disk if
+      it couldn't be cached */
+   if(track_module->simple_index.packet_nums)
+      *packet_num = track_module->simple_index.packet_nums[entry];
+   else
+   {
+      status = SEEK(p_ctx, track_module->simple_index.offset + 6 * entry);
+      if(status != VC_CONTAINER_SUCCESS) return status;
+      *packet_num = READ_U32(p_ctx, "Packet Number");
+      if(STREAM_STATUS(p_ctx) != VC_CONTAINER_SUCCESS) return STREAM_STATUS(p_ctx);
+   }
 
    /* When asking for the following keyframe we need to find the next entry with a greater
     * packet number */
@@ -1672,6 +1708,11 @@ static VC_CONTAINER_STATUS_T asf_reader_index_find_time( VC_CONTAINER_T *p_ctx,
    while(!eos && forward && previous_packet_num == *packet_num)
    {
       if(++entry == track_module->simple_index.num_entries) {eos = true; break;}
+      if(track_module->simple_index.packet_nums)
+      {
+         *packet_num = track_module->simple_index.packet_nums[entry];
+         continue;
+      }
       status = SEEK(p_ctx, track_module->simple_index.offset + 6 * entry);
       if(status != VC_CONTAINER_SUCCESS) break;
       *packet_num = READ_U32(p_ctx, "Packet Number");
@@ -2107,7 +2148,11 @@ static VC_CONTAINER_STATUS_T asf_reader_close( VC_CONTAINER_T *p_ctx )
    p_ctx->meta_num = 0;
 */
    for(i = 0; i < p_ctx->tracks_num; i++)
+   {
+      if(p_ctx->tracks[i]->priv->module->simple_index.packet_nums)
+         free(p_ctx->tracks[i]->priv->module->simple_index.packet_nums);
       vc_container_free_track(p_ctx, p_ctx->tracks[i]);
+   }
    p_ctx->tracks_num = 0;
    free(module);
    return VC_CONTAINER_SUCCESS;
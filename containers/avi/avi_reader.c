@@ -55,6 +55,8 @@ Defines.
  
 #define AVI_TRACKS_MAX 16 /*< We won't try to handle streams with more tracks than this */
 
+#define AVI_INDEX_CACHE_LEN 512 /*< Maximum number of legacy index checkpoints kept per track */
+
 #define AVI_TWOCC(a,b) ((a) | (b << 8))
 
 #define AVI_SYNC_CHUNK(ctx)                               \
@@ -96,6 +98,16 @@ typedef struct AVI_TRACK_CHUNK_STATE_T
    AVI_TRACK_STREAM_STATE_T *state;
 } AVI_TRACK_CHUNK_STATE_T;
 
+typedef struct AVI_INDEX_CACHE_ENTRY_T
+{
+   int64_t  time_pos;      /**< pts of the checkpointed keyframe chunk */
+   uint64_t entry_offset;  /**< offset of the keyframe's entry within 'idx1' */
+   uint64_t chunk_index;   /**< chunk state when the entry was scanned */
+   uint64_t chunk_offs;
+   uint32_t chunk_flags;
+   int64_t  base_offset;   /**< base the index offsets are relative to */
+} AVI_INDEX_CACHE_ENTRY_T;
+
 typedef struct VC_CONTAINER_TRACK_MODULE_T
 {
    int64_t  time_start;    /**< i.e. 'dwStart' in 'strh' (converted to microseconds) */
@@ -105,10 +117,15 @@ typedef struct VC_CONTAINER_TRACK_MODULE_T
                                 samples (or frames) / second for audio (or video) */
    uint32_t sample_size;   /**< i.e. 'dwSampleSize' in 'strh' */
 
-   uint64_t index_offset;  /**< Offset to the start of an OpenDML index i.e. 'indx' 
+   uint64_t index_offset;  /**< Offset to the start of an OpenDML index i.e. 'indx'
                                 (if available) */
    uint32_t index_size;    /**< Size of the OpenDML index chunk */
    AVI_TRACK_CHUNK_STATE_T chunk;
+
+   AVI_INDEX_CACHE_ENTRY_T *index_cache; /**< Sorted checkpoints into the legacy index
+                                              (allocated on first use) */
+   unsigned index_cache_len;             /**< Number of checkpoints currently stored */
+   int64_t index_cache_step;             /**< Minimum time between checkpoints */
 } VC_CONTAINER_TRACK_MODULE_T;
 
 typedef struct VC_CONTAINER_MODULE_T
@@ -565,20 +582,112 @@ static int avi_compare_seek_time(int64_t chunk_time, int64_t seek_time,
    return -1;
 }
 
+/** The legacy 'idx1' chunk has no internal structure we could binary search so
+    each seek used to scan it from the very start, which on large files costs
+    seconds. While scanning we now checkpoint the scan state at regular
+    keyframes; subsequent seeks binary search the checkpoints and resume the
+    scan from the closest one before the requested time. Memory is bounded;
+    when a table fills up it is decimated in place and the interval between
+    checkpoints doubled (the same scheme as containers_index.c, which we can't
+    use directly as resuming a scan needs more state than a time / offset
+    pair). */
+static AVI_INDEX_CACHE_ENTRY_T *avi_index_cache_find(VC_CONTAINER_TRACK_MODULE_T *track_module,
+   int64_t time)
+{
+   AVI_INDEX_CACHE_ENTRY_T *cache = track_module->index_cache;
+   unsigned start = 0, end = track_module->index_cache_len;
+
+   if (!cache || !end || cache[0].time_pos > time)
+      return NULL;
+
+   /* Find the last checkpoint with a time not greater than the requested one */
+   while (end - start > 1)
+   {
+      unsigned mid = (start + end) / 2;
+      if (cache[mid].time_pos > time) end = mid;
+      else start = mid;
+   }
+
+   return &cache[start];
+}
+
+static void avi_index_cache_add(VC_CONTAINER_TRACK_MODULE_T *track_module,
+   uint64_t entry_offset, int64_t base_offset)
+{
+   AVI_INDEX_CACHE_ENTRY_T *entry;
+
+   if (!track_module->index_cache)
+   {
+      /* Not being able to allocate the cache isn't fatal, seeking will just
+         remain slow */
+      track_module->index_cache =
+         malloc(AVI_INDEX_CACHE_LEN * sizeof(*track_module->index_cache));
+      if (!track_module->index_cache) return;
+      track_module->index_cache_len = 0;
+      track_module->index_cache_step = INT64_C(0);
+   }
+
+   /* The table is kept sorted by only ever appending past the last checkpoint */
+   if (track_module->index_cache_len &&
+       track_module->chunk.time_pos <
+          track_module->index_cache[track_module->index_cache_len - 1].time_pos +
+          track_module->index_cache_step)
+      return;
+
+   if (track_module->index_cache_len == AVI_INDEX_CACHE_LEN)
+   {
+      /* Table is full, decimate it in place and double the checkpoint interval */
+      unsigned i;
+      for (i = 1; i < AVI_INDEX_CACHE_LEN / 2; i++)
+         track_module->index_cache[i] = track_module->index_cache[2 * i];
+      track_module->index_cache_len = AVI_INDEX_CACHE_LEN / 2;
+      track_module->index_cache_step = 2 *
+         (track_module->index_cache[track_module->index_cache_len - 1].time_pos -
+          track_module->index_cache[0].time_pos) / (AVI_INDEX_CACHE_LEN / 2);
+      if (!track_module->index_cache_step) track_module->index_cache_step = INT64_C(1);
+   }
+
+   entry = &track_module->index_cache[track_module->index_cache_len++];
+   entry->time_pos = track_module->chunk.time_pos;
+   entry->entry_offset = entry_offset;
+   entry->chunk_index = track_module->chunk.index;
+   entry->chunk_offs = track_module->chunk.offs;
+   entry->chunk_flags = track_module->chunk.flags;
+   entry->base_offset = base_offset;
+}
+
 static VC_CONTAINER_STATUS_T avi_scan_legacy_index_chunk(VC_CONTAINER_T *p_ctx, int seek_track_num,
    int64_t *time, VC_CONTAINER_SEEK_FLAGS_T flags, uint64_t *pos)
 {
    VC_CONTAINER_MODULE_T *module = p_ctx->priv->module;
    VC_CONTAINER_STATUS_T status;
    VC_CONTAINER_TRACK_MODULE_T *track_module;
+   AVI_INDEX_CACHE_ENTRY_T *cached;
    AVI_TRACK_CHUNK_STATE_T selected_chunk;
    int64_t base_offset = module->data_offset;
    int64_t selected_chunk_offset = base_offset + 4;
    int32_t extra_offset = 0;
    int first_chunk_offset = 1;
-   uint64_t position;
+   int has_extra_data = 0;
+   uint64_t position, entry_offset;
+
+   /* If we have already scanned past here before, resume the scan from the
+      last checkpointed keyframe before the requested time instead of the
+      start of the index; its entry is re-read so it gets selected as normal */
+   cached = avi_index_cache_find(p_ctx->tracks[seek_track_num]->priv->module, *time);
+   if (cached)
+   {
+      track_module = p_ctx->tracks[seek_track_num]->priv->module;
+      track_module->chunk.index = cached->chunk_index;
+      track_module->chunk.offs = cached->chunk_offs;
+      track_module->chunk.flags = cached->chunk_flags;
+      track_module->chunk.time_pos = cached->time_pos;
+      base_offset = cached->base_offset;
+      selected_chunk_offset = base_offset + 4;
+      first_chunk_offset = 0;
+   }
 
-   SEEK(p_ctx, module->index_offset);
+   SEEK(p_ctx, cached ? cached->entry_offset : module->index_offset);
    memset(&selected_chunk, 0, sizeof(selected_chunk));
 
    while((status = STREAM_STATUS(p_ctx)) == VC_CONTAINER_SUCCESS &&
@@ -588,6 +697,7 @@ static VC_CONTAINER_STATUS_T avi_scan_legacy_index_chunk(VC_CONTAINER_T *p_ctx,
       uint16_t data_type, track_num;
       uint32_t chunk_flags, offset, size;
 
+      entry_offset = STREAM_POSITION(p_ctx);
       chunk_id     = READ_FOURCC(p_ctx, "Chunk ID");
       chunk_flags  = READ_U32(p_ctx, "dwFlags");
       offset       = READ_U32(p_ctx, "dwOffset");
@@ -626,6 +736,7 @@ static VC_CONTAINER_STATUS_T avi_scan_legacy_index_chunk(VC_CONTAINER_T *p_ctx,
       if ((chunk_flags & (AVIIF_LIST | AVIIF_NOTIME)) || data_type == AVI_TWOCC('d','d'))
          continue;
    
+      has_extra_data = extra_offset != 0;
       position = base_offset + offset + extra_offset;
       extra_offset = INT64_C(0);
 
@@ -654,6 +765,11 @@ static VC_CONTAINER_STATUS_T avi_scan_legacy_index_chunk(VC_CONTAINER_T *p_ctx,
          {
             selected_chunk_offset = position;
             selected_chunk = track_module->chunk;
+            /* Checkpoint the scan state here for later seeks; not when the
+               chunk is preceded by in-band data since re-reading the index
+               entry on its own would lose the extra offset */
+            if (!has_extra_data)
+               avi_index_cache_add(track_module, entry_offset, base_offset);
          }
 
          if (res == 0)
@@ -685,7 +801,38 @@ static VC_CONTAINER_STATUS_T avi_scan_legacy_index_chunk(VC_CONTAINER_T *p_ctx,
    return VC_CONTAINER_ERROR_NOT_FOUND;
 }
 
-static VC_CONTAINER_STATUS_T avi_scan_standard_index_chunk(VC_CONTAINER_T *p_ctx, uint64_t index_offset, 
+/** Prime the index checkpoint cache by scanning the legacy index once at open
+    time, so that not even the first seek has to walk it from the start. Only
+    worth doing for the track seeking will favor. */
+static void avi_preload_legacy_index(VC_CONTAINER_T *p_ctx)
+{
+   VC_CONTAINER_TRACK_MODULE_T *track_module;
+   int64_t time = INT64_MAX;
+   uint64_t pos;
+   unsigned i;
+
+   /* Same choice of track as avi_reader_seek */
+   for(i = 0; i < p_ctx->tracks_num; i++)
+      if(p_ctx->tracks[i]->is_enabled &&
+         p_ctx->tracks[i]->format->es_type == VC_CONTAINER_ES_TYPE_VIDEO) break;
+   if(i == p_ctx->tracks_num)
+      for(i = 0; i < p_ctx->tracks_num; i++)
+         if(p_ctx->tracks[i]->is_enabled) break;
+   if(i == p_ctx->tracks_num) return;
+
+   track_module = p_ctx->tracks[i]->priv->module;
+   track_module->chunk.time_pos = track_module->time_start;
+   avi_scan_legacy_index_chunk(p_ctx, i, &time, 0, &pos);
+
+   /* The scan was only run to fill the cache, discard its result; the chunk
+      state is fully reset by the next seek operation anyway */
+   track_module->chunk.index = UINT64_C(0);
+   track_module->chunk.offs = UINT64_C(0);
+   track_module->chunk.flags = 0;
+   track_module->chunk.time_pos = track_module->time_start;
+}
+
+static VC_CONTAINER_STATUS_T avi_scan_standard_index_chunk(VC_CONTAINER_T *p_ctx, uint64_t index_offset,
    unsigned seek_track_num, int64_t *time, VC_CONTAINER_SEEK_FLAGS_T flags, uint64_t *pos) 
 {
    VC_CONTAINER_STATUS_T status = VC_CONTAINER_ERROR_NOT_FOUND;
@@ -1319,11 +1466,15 @@ static VC_CONTAINER_STATUS_T avi_reader_close( VC_CONTAINER_T *p_ctx )
    unsigned int i;
 
    for(i = 0; i < p_ctx->tracks_num; i++)
+   {
+      if (p_ctx->tracks[i]->priv->module->index_cache)
+         free(p_ctx->tracks[i]->priv->module->index_cache);
       vc_container_free_track(p_ctx, p_ctx->tracks[i]);
+   }
    p_ctx->tracks = NULL;
    p_ctx->tracks_num = 0;
    free(module);
-   p_ctx->priv->module = 0;  
+   p_ctx->priv->module = 0;
    return VC_CONTAINER_SUCCESS;
 }
 
@@ -1474,8 +1625,11 @@ VC_CONTAINER_STATUS_T avi_reader_open( VC_CONTAINER_T *p_ctx )
             module->index_size = chunk_size;
             p_ctx->capabilities |= VC_CONTAINER_CAPS_HAS_INDEX;
             p_ctx->capabilities |= VC_CONTAINER_CAPS_DATA_HAS_KEYFRAME_FLAG;
+
+            /* We're reading the index anyway, checkpoint it for fast seeking */
+            avi_preload_legacy_index(p_ctx);
          }
-   
+
          /* Seek back to the start of the data */
          SEEK(p_ctx, module->data_offset);
       }
@@ -1504,7 +1658,11 @@ VC_CONTAINER_STATUS_T avi_reader_open( VC_CONTAINER_T *p_ctx )
 error:
    LOG_DEBUG(p_ctx, "error opening stream (%i)", status);
    for(i = 0; i < p_ctx->tracks_num; i++)
+   {
+      if (p_ctx->tracks[i]->priv->module->index_cache)
+         free(p_ctx->tracks[i]->priv->module->index_cache);
       vc_container_free_track(p_ctx, p_ctx->tracks[i]);
+   }
    p_ctx->tracks = NULL;
    p_ctx->tracks_num = 0;
    if (module) free(module);
@@ -845,16 +845,28 @@ static VC_CONTAINER_STATUS_T avi_writer_write( VC_CONTAINER_T *p_ctx,
          module->chunk_size = 0;
       }
 
-      WRITE_FOURCC(p_ctx, chunk_id, "Chunk ID");
       if(STREAM_SEEKABLE(p_ctx) || p_packet->flags & VC_CONTAINER_PACKET_FLAG_FRAME_END)
       {
          /* If the output stream can seek we can fix up the frame size later, and if the
-          * packet holds the whole frame we won't need to, so write data straight out. */
-         WRITE_U32(p_ctx, chunk_size, "Chunk Size");
-         WRITE_BYTES(p_ctx, p_packet->data, p_packet->size);
+          * packet holds the whole frame we won't need to, so write the chunk header and
+          * the data straight out as a single gathered write. */
+         uint8_t chunk_header[8];
+         VC_CONTAINER_IO_VEC_T vec[2];
+
+         memcpy(chunk_header, &chunk_id, 4);
+         chunk_header[4] = (uint8_t)chunk_size;
+         chunk_header[5] = (uint8_t)(chunk_size >> 8);
+         chunk_header[6] = (uint8_t)(chunk_size >> 16);
+         chunk_header[7] = (uint8_t)(chunk_size >> 24);
+         vec[0].buffer = chunk_header;
+         vec[0].size = sizeof(chunk_header);
+         vec[1].buffer = p_packet->data;
+         vec[1].size = p_packet->size;
+         vc_container_io_writev(p_ctx->priv->io, vec, 2);
       }
       else
       {
+         WRITE_FOURCC(p_ctx, chunk_id, "Chunk ID");
          vc_container_assert(module->avi_frame_buffer);
          if(p_packet->size > AVI_FRAME_BUFFER_SIZE)
             return VC_CONTAINER_ERROR_OUT_OF_RESOURCES;
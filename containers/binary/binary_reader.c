@@ -155,6 +155,23 @@ static VC_CONTAINER_STATUS_T binary_reader_read( VC_CONTAINER_T *p_ctx,
    if(flags & VC_CONTAINER_READ_FLAG_INFO)
       return VC_CONTAINER_SUCCESS;
 
+   if(flags & VC_CONTAINER_READ_FLAG_BORROW)
+   {
+      size_t borrowed = module->block_size;
+      const uint8_t *data = vc_container_io_borrow(p_ctx->priv->io, &borrowed);
+
+      if(data)
+      {
+         packet->data = (uint8_t *)data;
+         packet->size = borrowed;
+         packet->flags |= VC_CONTAINER_PACKET_FLAG_BORROWED;
+         module->block_size -= borrowed;
+         module->status = VC_CONTAINER_SUCCESS;
+         return module->status;
+      }
+      /* Fall back to copying into the supplied buffer */
+   }
+
    size = MIN(module->block_size, packet->buffer_size);
    size = READ_BYTES(p_ctx, packet->data, size);
    module->block_size -= size;
@@ -314,6 +314,8 @@ typedef struct VC_CONTAINER_PACKET_T
 #define VC_CONTAINER_PACKET_FLAG_DISCONTINUITY  0x08   /**< Packet comes after a discontinuity in the stream. Decoders might have to be flushed */
 #define VC_CONTAINER_PACKET_FLAG_ENCRYPTED      0x10   /**< Packet contains DRM encrypted data */
 #define VC_CONTAINER_PACKET_FLAG_CONFIG         0x20   /**< Packet contains stream specific config data */
+#define VC_CONTAINER_PACKET_FLAG_BORROWED       0x40   /**< Packet data points into internal i/o buffers and
+                                                            must be released using \ref VC_CONTAINER_CONTROL_PACKET_RELEASE */
 /* @} */
 
 /** \name Special Unknown Time Value
@@ -489,6 +491,9 @@ typedef uint32_t VC_CONTAINER_READ_FLAGS_T;
 #define VC_CONTAINER_READ_FLAG_SKIP   2
 /** Force the container to read data from the specified track */
 #define VC_CONTAINER_READ_FLAG_FORCE_TRACK 4
+/** Ask the container to return a packet pointing directly into its internal buffers
+ * instead of copying the data into the buffer supplied by the caller */
+#define VC_CONTAINER_READ_FLAG_BORROW 8
 /* @} */
 
 /** Reads a data packet from a container reader.
@@ -504,6 +509,11 @@ typedef uint32_t VC_CONTAINER_READ_FLAGS_T;
  * \ref VC_CONTAINER_READ_FLAG_SKIP will instruct the reader to skip the next packet. In this case
  * it isn't necessary for the caller to pass a pointer to a \ref VC_CONTAINER_PACKET_T structure
  * unless the \ref VC_CONTAINER_READ_FLAG_INFO is also given.\n
+ * \ref VC_CONTAINER_READ_FLAG_BORROW will ask the reader to return a packet whose data pointer
+ * refers to the reader's internal buffers instead of copying the data into the supplied buffer.
+ * Readers which cannot honour this just ignore the flag. Packets which come back with the
+ * \ref VC_CONTAINER_PACKET_FLAG_BORROWED flag set must be released using the
+ * \ref VC_CONTAINER_CONTROL_PACKET_RELEASE operation before the next operation on the container.\n
  * A combination of all these flags can be used.
  *
  * \param  context   Pointer to the context of the reader to use
@@ -597,6 +607,17 @@ typedef struct VC_CONTAINER_WRITE_STATS_T
    /** This logs the length of time that we wait for a flush command to complete. */
    VC_CONTAINER_STATS_T flush;
 } VC_CONTAINER_WRITE_STATS_T;
+
+/** This type represents the statistics saved by the io layer on the read side. */
+typedef struct VC_CONTAINER_READ_STATS_T
+{
+   uint64_t bytes;          /**< Total number of bytes returned to the parser */
+   uint32_t reads;          /**< Number of read calls made by the parser */
+   uint32_t cache_hits;     /**< Read calls served entirely from the cache */
+   uint32_t actual_reads;   /**< Read calls which reached the underlying io */
+   uint32_t seeks;          /**< Number of seek calls made by the parser */
+   uint32_t read_time;      /**< Time spent waiting for the underlying io to read (us) */
+} VC_CONTAINER_READ_STATS_T;
    
 
 /** Control operations which can be done on containers. */
@@ -711,12 +732,81 @@ typedef enum
     * Arguments: none */
    VC_CONTAINER_CONTROL_IO_FLUSH,
 
+   /** Causes the io to be flushed all the way to durable storage.\n
+    * Arguments: none */
+   VC_CONTAINER_CONTROL_IO_SYNC,
+
    /** Request the container reader to packetize data for the specified track.
     * Arguments:\n
     *   arg1= unsigned long: track number
     *   arg2= VC_CONTAINER_FOURCC_T: codec variant to output */
    VC_CONTAINER_CONTROL_TRACK_PACKETIZE,
 
+   /** Enable or disable the pipelined read mode of a container reader.
+    * When enabled, demuxing and per-track packetization run on worker threads
+    * connected by bounded queues instead of on the caller's thread.
+    * Arguments:\n
+    *   arg1= unsigned long: 1 to enable, 0 to disable */
+   VC_CONTAINER_CONTROL_SET_PIPELINED_READ,
+
+   /** Hand a packet of data to a reader opened in pushed-packet mode.
+    * The buffer is borrowed rather than copied, so it must remain valid and
+    * unmodified until the reader has consumed the packet, which is the case
+    * once a read reports that no more data is available.
+    * Arguments:\n
+    *   arg1= uint8_t *: pointer to the start of the packet
+    *   arg2= uint32_t: size of the packet in bytes */
+   VC_CONTAINER_CONTROL_PACKET_PUSH,
+
+   /** Set the number of audio frames delivered per packet by readers of raw
+    * audio streams. Larger packets reduce the per-packet overhead when reading
+    * high sample rate multichannel content.\n
+    * Arguments:\n
+    *   arg1= uint32_t: number of audio frames per packet (0 restores the default) */
+   VC_CONTAINER_CONTROL_SET_FRAMES_PER_PACKET,
+
+   /** Release the data of a packet which was read in borrowed mode (i.e. which
+    * has the \ref VC_CONTAINER_PACKET_FLAG_BORROWED flag set). This must be done
+    * before the next read or seek on the container.\n
+    * Arguments:\n
+    *   arg1= VC_CONTAINER_PACKET_T *: packet to release */
+   VC_CONTAINER_CONTROL_PACKET_RELEASE,
+
+   /** Enables or disables the recording of statistics by the io layer on the
+    * read side. Enabling also resets the counters.\n
+    * Arguments:\n
+    *   arg1= int: 1 to enable, 0 to disable */
+   VC_CONTAINER_CONTROL_SET_IO_READ_STATS,
+
+   /** Collects the statistics recorded by the io layer on the read side.\n
+    * Arguments:\n
+    *   arg1= VC_CONTAINER_READ_STATS_T *: */
+   VC_CONTAINER_CONTROL_GET_IO_READ_STATS,
+
+   /** Retrieves the number of packets and bytes read so far for a track.\n
+    * Arguments:\n
+    *   arg1= uint32_t: track number
+    *   arg2= uint32_t *: updated with the number of packets read
+    *   arg3= uint64_t *: updated with the number of bytes read */
+   VC_CONTAINER_CONTROL_GET_TRACK_STATS,
+
+   /** Asks the reader to deliver a whole laced block of frames as a single packet
+    * instead of one packet per frame, where the container format supports it.
+    * The layout of such a packet can be retrieved with
+    * \ref VC_CONTAINER_CONTROL_GET_BLOCK_LACE_SIZES.\n
+    * Arguments:\n
+    *   arg1= uint32_t: 1 to enable, 0 to disable */
+   VC_CONTAINER_CONTROL_SET_WHOLE_BLOCK_DELIVERY,
+
+   /** Retrieves the sizes of the individual frames making up the last laced block
+    * parsed in whole-block delivery mode. The sizes add up to the size of the packet
+    * and thus double as a table of offsets into its data. A count of 0 means the
+    * last packet was not laced. The table is only valid until the next read.\n
+    * Arguments:\n
+    *   arg1= uint32_t *: updated with the number of frames in the block
+    *   arg2= const uint32_t **: updated with a pointer to the table of frame sizes */
+   VC_CONTAINER_CONTROL_GET_BLOCK_LACE_SIZES,
+
    /** Private user extensions must be above this number */
    VC_CONTAINER_CONTROL_USER_EXTENSIONS = 0x1000
 
@@ -31,6 +31,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "containers/core/containers_private.h"
 #include "containers/core/containers_io.h"
 #include "containers/core/containers_filters.h"
+#include "containers/core/containers_pipeline.h"
 #include "containers/core/containers_loader.h"
 #include "containers/core/containers_logging.h"
 #include "containers/core/containers_utils.h"
@@ -184,6 +185,7 @@ VC_CONTAINER_STATUS_T vc_container_close( VC_CONTAINER_T *p_ctx )
    if(!p_ctx)
       return VC_CONTAINER_ERROR_INVALID_ARGUMENT;
 
+   vc_container_pipeline_stop(p_ctx);
    for(i = 0; i < p_ctx->tracks_num; i++)
       if(p_ctx->tracks[i]->priv->packetizer)
          vc_packetizer_close(p_ctx->tracks[i]->priv->packetizer);
@@ -201,7 +203,7 @@ VC_CONTAINER_STATUS_T vc_container_close( VC_CONTAINER_T *p_ctx )
 }
 
 /*****************************************************************************/
-static VC_CONTAINER_STATUS_T container_read_packet( VC_CONTAINER_T *p_ctx,
+VC_CONTAINER_STATUS_T vc_container_read_packet( VC_CONTAINER_T *p_ctx,
    VC_CONTAINER_PACKET_T *p_packet, uint32_t flags )
 {
    VC_CONTAINER_STATUS_T status;
@@ -263,10 +265,19 @@ VC_CONTAINER_STATUS_T vc_container_read( VC_CONTAINER_T *p_ctx, VC_CONTAINER_PAC
    if(!p_packet)
       p_packet = &p_ctx->priv->packetizer_packet;
 
+   /* When the pipelined read mode is on, the data comes from the pipeline */
+   if(p_ctx->priv->pipeline)
+   {
+      if(force)
+         return VC_CONTAINER_ERROR_UNSUPPORTED_OPERATION;
+      status = vc_container_pipeline_read( p_ctx, p_packet, flags );
+      goto end;
+   }
+
    /* Simple/Fast case first */
    if(!p_ctx->priv->packetizing)
    {
-      status = container_read_packet( p_ctx, p_packet, flags );
+      status = vc_container_read_packet( p_ctx, p_packet, flags );
       goto end;
    }
 
@@ -299,13 +310,13 @@ VC_CONTAINER_STATUS_T vc_container_read( VC_CONTAINER_T *p_ctx, VC_CONTAINER_PAC
       tmp->track = p_packet->track;
 
       /* Let's check what the container has to offer */
-      status = container_read_packet( p_ctx, tmp, force|VC_PACKETIZER_FLAG_INFO );
+      status = vc_container_read_packet( p_ctx, tmp, force|VC_PACKETIZER_FLAG_INFO );
       if(status != VC_CONTAINER_SUCCESS)
          return status;
 
       if(!p_ctx->tracks[tmp->track]->priv->packetizer)
       {
-         status = container_read_packet( p_ctx, p_packet, flags );
+         status = vc_container_read_packet( p_ctx, p_packet, flags );
          break;
       }
 
@@ -315,7 +326,7 @@ VC_CONTAINER_STATUS_T vc_container_read( VC_CONTAINER_T *p_ctx, VC_CONTAINER_PAC
       tmp->data = p_ctx->priv->packetizer_buffer;
       tmp->buffer_size = PACKETIZER_BUFFER_SIZE;
       tmp->size = 0;
-      status = container_read_packet( p_ctx, tmp, force );
+      status = vc_container_read_packet( p_ctx, tmp, force );
       if(status != VC_CONTAINER_SUCCESS)
          return status;
 
@@ -337,9 +348,59 @@ VC_CONTAINER_STATUS_T vc_container_read( VC_CONTAINER_T *p_ctx, VC_CONTAINER_PAC
    if(p_packet && p_packet->pts > p_ctx->position)
       p_ctx->position = p_packet->pts;
 
+   /* Keep count of the packets delivered for each track */
+   if(!(flags & (VC_CONTAINER_READ_FLAG_INFO | VC_CONTAINER_READ_FLAG_SKIP)) &&
+      p_packet->track < p_ctx->tracks_num)
+   {
+      p_ctx->tracks[p_packet->track]->priv->packets_read++;
+      p_ctx->tracks[p_packet->track]->priv->bytes_read += p_packet->size;
+   }
+
    return VC_CONTAINER_SUCCESS;
 }
 
+/*****************************************************************************/
+static VC_CONTAINER_STATUS_T vc_container_write_packetized( VC_CONTAINER_T *p_ctx,
+   VC_CONTAINER_PACKET_T *p_packet )
+{
+   VC_PACKETIZER_T *packetizer = p_ctx->tracks[p_packet->track]->priv->packetizer;
+   VC_CONTAINER_STATUS_T status = VC_CONTAINER_SUCCESS;
+   unsigned int track = p_packet->track;
+   VC_CONTAINER_PACKET_T *released, out;
+
+   if(!p_ctx->priv->packetizer_buffer)
+   {
+      p_ctx->priv->packetizer_buffer = malloc(PACKETIZER_BUFFER_SIZE);
+      if(!p_ctx->priv->packetizer_buffer)
+         return VC_CONTAINER_ERROR_OUT_OF_MEMORY;
+   }
+
+   /* The caller's packet stays valid for the whole of this call, so the
+    * packetizer consumes its payload in place; only whatever is left over at
+    * the end is copied internally by the forced release below. */
+   vc_packetizer_push(packetizer, p_packet);
+
+   while(status == VC_CONTAINER_SUCCESS)
+   {
+      memset(&out, 0, sizeof(out));
+      out.data = p_ctx->priv->packetizer_buffer;
+      out.buffer_size = PACKETIZER_BUFFER_SIZE;
+      status = vc_packetizer_read(packetizer, &out, 0);
+      if(status != VC_CONTAINER_SUCCESS)
+         break;
+
+      out.track = track;
+      p_ctx->priv->writer_packetizing = true;
+      status = vc_container_write(p_ctx, &out);
+      p_ctx->priv->writer_packetizing = false;
+   }
+
+   vc_packetizer_pop(packetizer, &released, VC_PACKETIZER_FLAG_FORCE_RELEASE_INPUT);
+
+   /* Running out of packetized data just means more input is needed */
+   return status == VC_CONTAINER_ERROR_INCOMPLETE_DATA ? VC_CONTAINER_SUCCESS : status;
+}
+
 /*****************************************************************************/
 VC_CONTAINER_STATUS_T vc_container_write( VC_CONTAINER_T *p_ctx, VC_CONTAINER_PACKET_T *p_packet )
 {
@@ -348,13 +409,19 @@ VC_CONTAINER_STATUS_T vc_container_write( VC_CONTAINER_T *p_ctx, VC_CONTAINER_PA
    uint32_t metadata_length = 0;
 
    /* TODO: check other similar argument errors and non-stateless errors */
-   if (!p_packet || !p_packet->data || p_packet->track >= p_ctx->tracks_num) 
+   if (!p_packet || !p_packet->data || p_packet->track >= p_ctx->tracks_num)
       return VC_CONTAINER_ERROR_INVALID_ARGUMENT;
 
    /* Check for a previous error */
    if(p_ctx->priv->status != VC_CONTAINER_SUCCESS && p_ctx->priv->status != VC_CONTAINER_ERROR_NOT_READY)
       return p_ctx->priv->status;
 
+   /* If the track has a write-side packetizer attached, the packet is
+    * converted into the track's output format on the fly and the result
+    * written out instead */
+   if(p_ctx->tracks[p_packet->track]->priv->packetizer && !p_ctx->priv->writer_packetizing)
+      return vc_container_write_packetized(p_ctx, p_packet);
+
    /* Check we have enough space to write the data */
    if(p_ctx->priv->max_size &&
       p_ctx->size + p_packet->size + WRITER_SPACE_SAFETY_MARGIN > p_ctx->priv->max_size)
@@ -415,8 +482,14 @@ VC_CONTAINER_STATUS_T vc_container_seek( VC_CONTAINER_T *p_ctx, int64_t *p_offse
 {
    VC_CONTAINER_STATUS_T status;
    int64_t offset = *p_offset;
+   bool pipelined = p_ctx->priv->pipeline != NULL;
    unsigned int i;
 
+   /* The pipeline threads need to be out of the way while we seek.
+    * It is restarted, empty, once the container has moved. */
+   if(pipelined)
+      vc_container_pipeline_stop(p_ctx);
+
    /* Reset all packetizers */
    for(i = 0; i < p_ctx->tracks_num; i++)
       if(p_ctx->tracks[i]->priv->packetizer)
@@ -438,6 +511,9 @@ VC_CONTAINER_STATUS_T vc_container_seek( VC_CONTAINER_T *p_ctx, int64_t *p_offse
       }
    }
 
+   if(pipelined)
+      vc_container_pipeline_start(p_ctx);
+
    return status;
 }
 
@@ -497,6 +573,21 @@ VC_CONTAINER_STATUS_T vc_container_control( VC_CONTAINER_T *p_ctx, VC_CONTAINER_
          status = vc_container_filter_control(p_ctx->priv->drm_filter, operation, args);
       break;
 
+   case VC_CONTAINER_CONTROL_PACKET_RELEASE:
+      {
+         VC_CONTAINER_PACKET_T *p_packet = va_arg(args, VC_CONTAINER_PACKET_T *);
+
+         if(!p_packet || !(p_packet->flags & VC_CONTAINER_PACKET_FLAG_BORROWED))
+         {
+            status = VC_CONTAINER_ERROR_INVALID_ARGUMENT;
+            break;
+         }
+         vc_container_io_release(p_ctx->priv->io, p_packet->data, p_packet->size);
+         p_packet->flags &= ~VC_CONTAINER_PACKET_FLAG_BORROWED;
+         status = VC_CONTAINER_SUCCESS;
+      }
+      break;
+
    case VC_CONTAINER_CONTROL_SET_MAXIMUM_SIZE:
       p_ctx->priv->max_size = (uint64_t)va_arg( args, uint64_t );
       if(p_ctx->priv->io->max_size &&
@@ -546,6 +637,32 @@ VC_CONTAINER_STATUS_T vc_container_control( VC_CONTAINER_T *p_ctx, VC_CONTAINER_
       }
       break;
 
+   case VC_CONTAINER_CONTROL_SET_PIPELINED_READ:
+      if(va_arg(args, uint32_t))
+         status = vc_container_pipeline_start(p_ctx);
+      else
+      {
+         vc_container_pipeline_stop(p_ctx);
+         status = VC_CONTAINER_SUCCESS;
+      }
+      break;
+
+   case VC_CONTAINER_CONTROL_GET_TRACK_STATS:
+      {
+         uint32_t track_num = va_arg(args, uint32_t);
+         uint32_t *p_packets = va_arg(args, uint32_t *);
+         uint64_t *p_bytes = va_arg(args, uint64_t *);
+         if(track_num >= p_ctx->tracks_num || !p_packets || !p_bytes)
+         {
+            status = VC_CONTAINER_ERROR_INVALID_ARGUMENT;
+            break;
+         }
+         *p_packets = p_ctx->tracks[track_num]->priv->packets_read;
+         *p_bytes = p_ctx->tracks[track_num]->priv->bytes_read;
+         status = VC_CONTAINER_SUCCESS;
+      }
+      break;
+
    default: break;
    }
 
@@ -0,0 +1,181 @@
+/*
+Copyright (c) 2012, Broadcom Europe Ltd
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "containers/containers.h"
+#include "containers/core/containers_common.h"
+#include "containers/core/containers_arena.h"
+
+/* Every block is rounded up to one of these power of two size classes and
+ * carries a small header remembering which.  Freed blocks go onto the free
+ * list of their class, where the next allocation of that class picks them up
+ * again.  Chunks are bump-allocated and only released by reset / destroy. */
+
+#define ARENA_MIN_CLASS 5                    /* Smallest blocks are 32 bytes */
+#define ARENA_NUM_CLASSES 20
+#define ARENA_MAX_CLASS (ARENA_MIN_CLASS + ARENA_NUM_CLASSES - 1)
+#define ARENA_OVERSIZE_CLASS 0xFFFFFFFF      /* Marks blocks which came from malloc */
+
+/** Block header, kept to the size of the strictest alignment requirement */
+typedef union ARENA_BLOCK_T
+{
+   struct {
+      union ARENA_BLOCK_T *next;   /**< Next block in the free list */
+      uint32_t size_class;
+   } h;
+   int64_t align;
+
+} ARENA_BLOCK_T;
+
+typedef struct ARENA_CHUNK_T
+{
+   struct ARENA_CHUNK_T *next;
+   size_t used;                    /**< Bump pointer into data */
+   /* Chunk data follows */
+
+} ARENA_CHUNK_T;
+
+struct VC_CONTAINER_ARENA_T
+{
+   size_t chunk_size;              /**< Usable bytes per chunk */
+   ARENA_CHUNK_T *chunks;          /**< All chunks, most recent first */
+   ARENA_BLOCK_T *free_lists[ARENA_NUM_CLASSES];
+};
+
+/*****************************************************************************/
+static unsigned int arena_size_class( size_t size )
+{
+   unsigned int size_class = ARENA_MIN_CLASS;
+   while(((size_t)1 << size_class) < size)
+      size_class++;
+   return size_class;
+}
+
+/*****************************************************************************/
+VC_CONTAINER_ARENA_T *vc_container_arena_create( size_t chunk_size )
+{
+   VC_CONTAINER_ARENA_T *arena = malloc(sizeof(*arena));
+   if(!arena)
+      return NULL;
+
+   memset(arena, 0, sizeof(*arena));
+   arena->chunk_size = chunk_size;
+   return arena;
+}
+
+/*****************************************************************************/
+void *vc_container_arena_alloc( VC_CONTAINER_ARENA_T *arena, size_t size )
+{
+   unsigned int size_class = arena_size_class(size + sizeof(ARENA_BLOCK_T));
+   size_t block_size = (size_t)1 << size_class;
+   ARENA_BLOCK_T *block;
+   ARENA_CHUNK_T *chunk;
+
+   /* Anything which doesn't fit in a chunk goes straight to malloc */
+   if(block_size > arena->chunk_size || size_class > ARENA_MAX_CLASS)
+   {
+      block = malloc(sizeof(*block) + size);
+      if(!block)
+         return NULL;
+      block->h.size_class = ARENA_OVERSIZE_CLASS;
+      return block + 1;
+   }
+
+   /* Recycled block of the right class available ? */
+   block = arena->free_lists[size_class - ARENA_MIN_CLASS];
+   if(block)
+   {
+      arena->free_lists[size_class - ARENA_MIN_CLASS] = block->h.next;
+      return block + 1;
+   }
+
+   /* Carve a new block out of the current chunk */
+   chunk = arena->chunks;
+   if(!chunk || arena->chunk_size - chunk->used < block_size)
+   {
+      chunk = malloc(sizeof(*chunk) + arena->chunk_size);
+      if(!chunk)
+         return NULL;
+      chunk->used = 0;
+      chunk->next = arena->chunks;
+      arena->chunks = chunk;
+   }
+
+   block = (ARENA_BLOCK_T *)((uint8_t *)(chunk + 1) + chunk->used);
+   chunk->used += block_size;
+   block->h.size_class = size_class;
+   return block + 1;
+}
+
+/*****************************************************************************/
+void vc_container_arena_free( VC_CONTAINER_ARENA_T *arena, void *ptr )
+{
+   ARENA_BLOCK_T *block;
+
+   if(!ptr)
+      return;
+
+   block = (ARENA_BLOCK_T *)ptr - 1;
+   if(block->h.size_class == ARENA_OVERSIZE_CLASS)
+   {
+      free(block);
+      return;
+   }
+
+   vc_container_assert(block->h.size_class >= ARENA_MIN_CLASS &&
+      block->h.size_class <= ARENA_MAX_CLASS);
+   block->h.next = arena->free_lists[block->h.size_class - ARENA_MIN_CLASS];
+   arena->free_lists[block->h.size_class - ARENA_MIN_CLASS] = block;
+}
+
+/*****************************************************************************/
+void vc_container_arena_reset( VC_CONTAINER_ARENA_T *arena )
+{
+   ARENA_CHUNK_T *chunk;
+
+   for(chunk = arena->chunks; chunk; chunk = chunk->next)
+      chunk->used = 0;
+   memset(arena->free_lists, 0, sizeof(arena->free_lists));
+}
+
+/*****************************************************************************/
+void vc_container_arena_destroy( VC_CONTAINER_ARENA_T *arena )
+{
+   ARENA_CHUNK_T *chunk, *next;
+
+   if(!arena)
+      return;
+
+   for(chunk = arena->chunks; chunk; chunk = next)
+   {
+      next = chunk->next;
+      free(chunk);
+   }
+   free(arena);
+}
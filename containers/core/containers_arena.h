@@ -0,0 +1,81 @@
+/*
+Copyright (c) 2012, Broadcom Europe Ltd
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef VC_CONTAINERS_ARENA_H
+#define VC_CONTAINERS_ARENA_H
+
+/** \file containers_arena.h
+ * Arena allocator for the small, short-lived allocations made on the data
+ * path (one or more per packet).  Memory is carved out of large chunks which
+ * are only ever returned to the system in bulk, and freed blocks are recycled
+ * through size-class free lists, so steady-state operation does not touch
+ * malloc at all.  An arena is single threaded: each user owns its own.
+ */
+
+#include "containers/containers.h"
+
+struct VC_CONTAINER_ARENA_T;
+typedef struct VC_CONTAINER_ARENA_T VC_CONTAINER_ARENA_T;
+
+/**
+ * Creates an arena.
+ * @param chunk_size  Size of the chunks the arena requests from malloc.
+ *                    Allocations bigger than this fall back to malloc.
+ * @return            The arena, or NULL on failure.
+ */
+VC_CONTAINER_ARENA_T *vc_container_arena_create( size_t chunk_size );
+
+/**
+ * Allocates a block from an arena.
+ * @param arena  Pointer to a valid arena.
+ * @param size   Number of bytes to allocate.
+ * @return       Pointer to the block, or NULL on failure.
+ */
+void *vc_container_arena_alloc( VC_CONTAINER_ARENA_T *arena, size_t size );
+
+/**
+ * Returns a block to its arena.  The memory is recycled for later
+ * allocations but not returned to the system.
+ * @param arena  Arena the block was allocated from.
+ * @param block  Block to free.  NULL is ignored.
+ */
+void vc_container_arena_free( VC_CONTAINER_ARENA_T *arena, void *block );
+
+/**
+ * Resets an arena.  All blocks allocated from it become invalid and all of
+ * its memory becomes available again, without being returned to the system.
+ * @param arena  Pointer to a valid arena.
+ */
+void vc_container_arena_reset( VC_CONTAINER_ARENA_T *arena );
+
+/**
+ * Destroys an arena and returns all of its memory to the system.
+ * All blocks allocated from it become invalid.
+ * @param arena  Arena to destroy.  NULL is ignored.
+ */
+void vc_container_arena_destroy( VC_CONTAINER_ARENA_T *arena );
+
+#endif /* VC_CONTAINERS_ARENA_H */
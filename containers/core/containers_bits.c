@@ -111,54 +111,59 @@ static uint32_t vc_container_bits_get_leading_zero_bits( VC_CONTAINER_BITS_T *bi
    uint32_t leading_zero_bits;
    uint32_t bits_left = vc_container_bits_available(bit_stream);
    uint32_t bits;
-   uint8_t mask, current_byte;
+   uint8_t current_byte;
 
    if (!bits_left)
       return vc_container_bits_invalidate(bit_stream);
 
    /* Cache 'bits' field to avoid repeated pointer access */
    bits = bit_stream->bits;
-   if (bits)
-   {
-      current_byte = *bit_stream->buffer;
-      mask = 1 << (bits - 1);
-   } else {
-      /* Initialize variables to placate the compiler */
-      current_byte = 0;
-      mask = 0;
-   }
 
    /* Scan for the first one bit, counting the number of zeroes. This gives the
     * number of further bits after the one that are part of the value. See
-    * section 9.1 of ITU-T REC H.264 201003 for more details. */
+    * section 9.1 of ITU-T REC H.264 201003 for more details.
+    * The scan works on whole bytes, using count-leading-zeroes to find the
+    * marker bit, rather than shifting a mask one bit at a time. */
 
-   for (leading_zero_bits = 0; leading_zero_bits < bits_left; leading_zero_bits++)
+   /* Unconsumed bits of the current byte */
+   current_byte = bits ? (uint8_t)(*bit_stream->buffer & ((1 << bits) - 1)) : 0;
+
+   if (current_byte)
    {
-      if (!bits)
+      uint32_t top = 31 - __builtin_clz(current_byte);
+      leading_zero_bits = bits - 1 - top;
+      bits = top;
+   }
+   else
+   {
+      uint32_t top;
+
+      leading_zero_bits = bits;
+      for (;;)
       {
          if (!bit_stream->bytes)
             return vc_container_bits_invalidate(bit_stream);
          bit_stream->bytes--;
          current_byte = *(++bit_stream->buffer);
-         bits = 8;
-         mask = 0x80;
+         if (current_byte)
+            break;
+         leading_zero_bits += 8;
       }
-
-      bits--;
-      bits_left--;
-      if (current_byte & mask)
-         break;      /* Found the marker bit */
-
-      mask >>= 1;
+      top = 31 - __builtin_clz(current_byte);
+      leading_zero_bits += 7 - top;
+      bits = top;
    }
 
+   /* Account for the zero bits and the marker bit just consumed */
+   bits_left -= leading_zero_bits + 1;
+
    /* Check enough bits are left in the stream for the value. */
    if (leading_zero_bits > bits_left)
       return vc_container_bits_invalidate(bit_stream);
 
    /* Return cached value of bits to the stream */
    bit_stream->bits = bits;
-   
+
    return leading_zero_bits;
 }
 
@@ -312,6 +317,21 @@ uint32_t vc_container_bits_read_u32(VC_CONTAINER_BITS_T *bit_stream,
       return vc_container_bits_invalidate(bit_stream);
 
    bits = bit_stream->bits;
+
+   /* Fast path: byte aligned value made of whole bytes */
+   if (!bits && !(value_bits & 7))
+   {
+      bit_stream->bytes -= value_bits >> 3;
+      switch (value_bits >> 3)
+      {
+      case 4: value = *(++bit_stream->buffer); /* fall through */
+      case 3: value = (value << 8) | *(++bit_stream->buffer); /* fall through */
+      case 2: value = (value << 8) | *(++bit_stream->buffer); /* fall through */
+      case 1: value = (value << 8) | *(++bit_stream->buffer);
+      }
+      return value;
+   }
+
    while (needed)
    {
       uint32_t take;
@@ -390,6 +410,32 @@ int32_t vc_container_bits_read_s32_exp_golomb(VC_CONTAINER_BITS_T *bit_stream)
    return ((int32_t)((uval & 1) << 1) - 1) * (int32_t)((uval >> 1) + (uval & 1));
 }
 
+/*****************************************************************************/
+uint32_t vc_container_bits_find_emulation_prevention(const uint8_t *buffer,
+      uint32_t length)
+{
+   uint32_t offset = 0;
+
+   /* An emulation prevention byte needs two zero bytes before it, so whole
+    * words without any zero byte can be skipped in one go using the usual
+    * has-zero-byte trick. A zero byte can never be skipped over as part of
+    * a word since a pattern always starts with one. */
+   while (offset + sizeof(uint32_t) + 2 <= length)
+   {
+      uint32_t word;
+      memcpy(&word, buffer + offset, sizeof(word));
+      if ((word - 0x01010101UL) & ~word & 0x80808080UL)
+         break;
+      offset += sizeof(uint32_t);
+   }
+
+   for (; offset + 2 < length; offset++)
+      if (!buffer[offset] && !buffer[offset + 1] && buffer[offset + 2] == 3)
+         return offset + 2;
+
+   return length;
+}
+
 #ifdef    ENABLE_CONTAINERS_LOG_FORMAT
 
 /*****************************************************************************/
@@ -227,6 +227,21 @@ uint32_t vc_container_bits_read_u32_exp_golomb(VC_CONTAINER_BITS_T *bit_stream);
  */
 int32_t vc_container_bits_read_s32_exp_golomb(VC_CONTAINER_BITS_T *bit_stream);
 
+/** Find the next emulation prevention byte in a buffer.
+ * Scans the buffer for the first 0x00 0x00 0x03 sequence, a word at a time.
+ * This is intended for H.264/MPEG style packetizers which need to strip the
+ * emulation prevention byte before parsing a payload with a bit stream
+ * object.
+ *
+ * \pre  buffer is not NULL.
+ *
+ * \param buffer  Pointer to the start of the byte buffer.
+ * \param length  Number of bytes in the buffer.
+ * \return  The offset of the emulation prevention byte (the 0x03), or length
+ *          if the buffer does not contain the sequence.
+ */
+uint32_t vc_container_bits_find_emulation_prevention(const uint8_t *buffer, uint32_t length);
+
 /******************************************************************************
  * Macros reduce function name length and enable logging of some operations   *
  ******************************************************************************/
@@ -44,6 +44,25 @@ typedef struct VC_CONTAINER_BYTESTREAM_T
 
 } VC_CONTAINER_BYTESTREAM_T;
 
+/** Contiguous slice of bytestream data, as returned by a vectored peek */
+typedef struct VC_CONTAINER_BYTESTREAM_SLICE_T
+{
+   const uint8_t *data; /**< start of the slice */
+   size_t size;         /**< size of the slice in bytes */
+
+} VC_CONTAINER_BYTESTREAM_SLICE_T;
+
+/** Saved read position of a bytestream.
+ * A checkpoint only stays valid for as long as the packets it refers to are
+ * in the chain, i.e. until the next call to bytestream_pop. */
+typedef struct VC_CONTAINER_BYTESTREAM_CHECKPOINT_T
+{
+   VC_CONTAINER_PACKET_T *current; /**< saved current packet */
+   size_t current_offset; /**< saved position of current packet (in bytes) */
+   size_t offset; /**< saved position within the current packet */
+
+} VC_CONTAINER_BYTESTREAM_CHECKPOINT_T;
+
 /*****************************************************************************/
 STATIC_INLINE void bytestream_init( VC_CONTAINER_BYTESTREAM_T *stream )
 {
@@ -272,6 +291,88 @@ STATIC_INLINE VC_CONTAINER_STATUS_T bytestream_peek_at( VC_CONTAINER_BYTESTREAM_
    return VC_CONTAINER_SUCCESS;
 }
 
+/** Save the current read position so that speculative parsing can cheaply be
+ * undone with bytestream_rollback. */
+STATIC_INLINE void bytestream_checkpoint( VC_CONTAINER_BYTESTREAM_T *stream,
+   VC_CONTAINER_BYTESTREAM_CHECKPOINT_T *checkpoint )
+{
+   checkpoint->current = stream->current;
+   checkpoint->current_offset = stream->current_offset;
+   checkpoint->offset = stream->offset;
+}
+
+/** Restore a read position previously saved with bytestream_checkpoint.
+ * The packets covered by the checkpoint must not have been popped since. */
+STATIC_INLINE void bytestream_rollback( VC_CONTAINER_BYTESTREAM_T *stream,
+   VC_CONTAINER_BYTESTREAM_CHECKPOINT_T *checkpoint )
+{
+   stream->current = checkpoint->current;
+   stream->current_offset = checkpoint->current_offset;
+   stream->offset = checkpoint->offset;
+}
+
+/** Peek the requested amount of data as a list of contiguous slices pointing
+ * straight into the underlying packets, avoiding any copying.
+ * Returns VC_CONTAINER_ERROR_EOS if not enough data is available and
+ * VC_CONTAINER_ERROR_OUT_OF_RESOURCES if the data spans more packets than
+ * there are slices, in which case the slices are filled with as much of the
+ * data as they can describe. */
+STATIC_INLINE VC_CONTAINER_STATUS_T bytestream_peek_vector( VC_CONTAINER_BYTESTREAM_T *stream,
+   size_t size, VC_CONTAINER_BYTESTREAM_SLICE_T *slices, unsigned int max_slices,
+   unsigned int *num_slices )
+{
+   VC_CONTAINER_PACKET_T *packet;
+   size_t offset;
+   unsigned int slice = 0;
+
+   *num_slices = 0;
+
+   if( !size )
+      return VC_CONTAINER_SUCCESS; /* Nothing to do */
+   if( stream->bytes - stream->current_offset - stream->offset < size )
+      return VC_CONTAINER_ERROR_EOS; /* Not enough data */
+
+   for( packet = stream->current, offset = stream->offset; size;
+        packet = packet->next, offset = 0 )
+   {
+      if( packet->size == offset )
+         continue; /* Nothing left in this packet */
+
+      if( slice == max_slices )
+         return VC_CONTAINER_ERROR_OUT_OF_RESOURCES;
+
+      slices[slice].data = packet->data + offset;
+      slices[slice].size = MIN( packet->size - offset, size );
+      size -= slices[slice].size;
+      *num_slices = ++slice;
+   }
+
+   return VC_CONTAINER_SUCCESS;
+}
+
+/** Peek the requested amount of data as a single contiguous block.
+ * When the data does not straddle a packet boundary, a pointer straight into
+ * the packet is returned and no copying takes place. Only when the data is
+ * actually split is it linearized into the caller's bounce buffer, which must
+ * be at least size bytes big.
+ * Returns NULL if not enough data is available. */
+STATIC_INLINE const uint8_t *bytestream_peek_linear( VC_CONTAINER_BYTESTREAM_T *stream,
+   uint8_t *bounce, size_t size )
+{
+   VC_CONTAINER_PACKET_T *packet;
+   size_t offset;
+
+   /* Fast path first */
+   packet = bytestream_get_packet( stream, &offset );
+   if( packet && packet->size - offset >= size )
+      return packet->data + offset;
+
+   if( bytestream_peek( stream, bounce, size ) != VC_CONTAINER_SUCCESS )
+      return NULL;
+
+   return bounce;
+}
+
 STATIC_INLINE VC_CONTAINER_STATUS_T bytestream_skip_byte( VC_CONTAINER_BYTESTREAM_T *stream )
 {
    VC_CONTAINER_PACKET_T *packet = stream->current;
@@ -354,6 +455,25 @@ STATIC_INLINE VC_CONTAINER_STATUS_T bytestream_find_startcode( VC_CONTAINER_BYTE
    {
       for( ; offset < packet->size; offset++ )
       {
+         /* Fast path: start codes begin with a zero byte so runs of bytes
+          * which cannot start a match can be skipped 8 at a time by testing
+          * a whole word for the presence of a zero byte */
+         if( !match && !startcode[0] )
+         {
+            while( offset + sizeof(uint64_t) <= packet->size )
+            {
+               uint64_t word;
+               memcpy( &word, packet->data + offset, sizeof(word) );
+               if( (word - UINT64_C(0x0101010101010101)) & ~word &
+                   UINT64_C(0x8080808080808080) )
+                  break;
+               offset += sizeof(uint64_t);
+               position += sizeof(uint64_t);
+            }
+            if( offset == packet->size )
+               break;
+         }
+
          if( packet->data[offset] != startcode[match] )
          {
             if ( match ) /* False positive */
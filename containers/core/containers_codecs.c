@@ -30,180 +30,287 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "containers/containers.h"
 #include "containers/containers_codecs.h"
+#include "containers/core/containers_common.h"
+#include "containers/core/containers_list.h"
 #include "containers/core/containers_utils.h"
 
+/* The mappings below are searched by binary sub-division, so each direction
+ * has its own table, sorted by the numerical value of its key (the first
+ * field).  The mappings are not one-to-one: where several keys map to the
+ * same value, or did so in the old linear tables, only the first match is
+ * kept in the reverse direction. */
+
+/** Entry of a codec mapping table.
+ * The meaning of key and value depends on the direction of the table. */
+typedef struct codec_map_entry_tag
+{
+   uint32_t key;     /**< WaveFormat id, fourcc or codec to map from */
+   uint32_t value;   /**< WaveFormat id, fourcc or codec mapped to */
+} CODEC_MAP_ENTRY_T;
+
+/** Comparator for codec mapping entries. */
+static int codec_map_comparator(const CODEC_MAP_ENTRY_T *a, const CODEC_MAP_ENTRY_T *b)
+{
+   if(a->key == b->key) return 0;
+   return a->key < b->key ? -1 : 1;
+}
+
 /*****************************************************************************/
-static struct {
-   VC_CONTAINER_FOURCC_T codec;
-   uint16_t id;
-} codec_to_wf_table[] =
+static CODEC_MAP_ENTRY_T wf_to_codec_table[] =
 {
-   {VC_CONTAINER_CODEC_PCM_SIGNED_LE, WAVE_FORMAT_PCM},
-   {VC_CONTAINER_CODEC_ALAW, WAVE_FORMAT_ALAW},
-   {VC_CONTAINER_CODEC_MULAW, WAVE_FORMAT_MULAW},
-   {VC_CONTAINER_CODEC_ADPCM_MS, WAVE_FORMAT_ADPCM},
-   {VC_CONTAINER_CODEC_MPGA, WAVE_FORMAT_MPEG},
-   {VC_CONTAINER_CODEC_MPGA, WAVE_FORMAT_MPEGLAYER3},
-   {VC_CONTAINER_CODEC_WMA1, WAVE_FORMAT_WMAUDIO1},
-   {VC_CONTAINER_CODEC_WMA2, WAVE_FORMAT_WMAUDIO2},
-   {VC_CONTAINER_CODEC_WMAP, WAVE_FORMAT_WMAUDIOPRO},
-   {VC_CONTAINER_CODEC_WMAL, WAVE_FORMAT_WMAUDIO_LOSSLESS},
-   {VC_CONTAINER_CODEC_WMAV, WAVE_FORMAT_WMAUDIO_VOICE},
-   {VC_CONTAINER_CODEC_AC3,  WAVE_FORMAT_DVM},
-   {VC_CONTAINER_CODEC_AC3,  WAVE_FORMAT_DOLBY_AC3_SPDIF}, /**< AC-3 padded for S/PDIF */
-   {VC_CONTAINER_CODEC_AC3,  WAVE_FORMAT_RAW_SPORT},       /**< AC-3 padded for S/PDIF */
-   {VC_CONTAINER_CODEC_AC3,  WAVE_FORMAT_ESST_AC3},        /**< AC-3 padded for S/PDIF */
-   {VC_CONTAINER_CODEC_EAC3, WAVE_FORMAT_DVM},
-   {VC_CONTAINER_CODEC_DTS, WAVE_FORMAT_DTS},
+   {WAVE_FORMAT_PCM,                    VC_CONTAINER_CODEC_PCM_SIGNED_LE},
+   {WAVE_FORMAT_ADPCM,                  VC_CONTAINER_CODEC_ADPCM_MS},
+   {WAVE_FORMAT_ALAW,                   VC_CONTAINER_CODEC_ALAW},
+   {WAVE_FORMAT_MULAW,                  VC_CONTAINER_CODEC_MULAW},
+   {WAVE_FORMAT_DTS,                    VC_CONTAINER_CODEC_DTS},
+   {WAVE_FORMAT_WMAUDIO_VOICE,          VC_CONTAINER_CODEC_WMAV},
+   {WAVE_FORMAT_MPEG,                   VC_CONTAINER_CODEC_MPGA},
+   {WAVE_FORMAT_MPEGLAYER3,             VC_CONTAINER_CODEC_MPGA},
+   {WAVE_FORMAT_DOLBY_AC3_SPDIF,        VC_CONTAINER_CODEC_AC3},    /**< AC-3 padded for S/PDIF */
+   {WAVE_FORMAT_MP4A,                   VC_CONTAINER_CODEC_MP4A},
+   {WAVE_FORMAT_WMAUDIO1,               VC_CONTAINER_CODEC_WMA1},
+   {WAVE_FORMAT_WMAUDIO2,               VC_CONTAINER_CODEC_WMA2},
+   {WAVE_FORMAT_WMAUDIOPRO,             VC_CONTAINER_CODEC_WMAP},
+   {WAVE_FORMAT_WMAUDIO_LOSSLESS,       VC_CONTAINER_CODEC_WMAL},
+   {WAVE_FORMAT_RAW_SPORT,              VC_CONTAINER_CODEC_AC3},    /**< AC-3 padded for S/PDIF */
+   {WAVE_FORMAT_ESST_AC3,               VC_CONTAINER_CODEC_AC3},    /**< AC-3 padded for S/PDIF */
+   {WAVE_FORMAT_SONY_SCX,               VC_CONTAINER_CODEC_ATRAC3},
+   {WAVE_FORMAT_DVM,                    VC_CONTAINER_CODEC_AC3},
 #if 0
-   {CODEC_G726, WAVE_FORMAT_G726_ADPCM},
-   {CODEC_G726, WAVE_FORMAT_DF_G726},
-   {CODEC_G726, WAVE_FORMAT_G726ADPCM},
-   {CODEC_G726, WAVE_FORMAT_PANASONIC_G726},
+   {WAVE_FORMAT_G726_ADPCM,             CODEC_G726},
+   {WAVE_FORMAT_DF_G726,                CODEC_G726},
+   {WAVE_FORMAT_G726ADPCM,              CODEC_G726},
+   {WAVE_FORMAT_PANASONIC_G726,         CODEC_G726},
 #endif
-   {VC_CONTAINER_CODEC_MP4A, WAVE_FORMAT_AAC},
-   {VC_CONTAINER_CODEC_MP4A, WAVE_FORMAT_MP4A},
-   {VC_CONTAINER_CODEC_ATRAC3, WAVE_FORMAT_SONY_SCX},
-   {VC_CONTAINER_CODEC_UNKNOWN, WAVE_FORMAT_UNKNOWN}
+   {WAVE_FORMAT_AAC,                    VC_CONTAINER_CODEC_MP4A},
 };
+VC_CONTAINERS_STATIC_LIST(wf_to_codec_map, wf_to_codec_table, codec_map_comparator);
 
-VC_CONTAINER_FOURCC_T waveformat_to_codec(uint16_t waveformat_id)
+static CODEC_MAP_ENTRY_T codec_to_wf_table[] =
 {
-   unsigned int i;
-   for(i = 0; codec_to_wf_table[i].codec != VC_CONTAINER_CODEC_UNKNOWN; i++)
-      if(codec_to_wf_table[i].id == waveformat_id) break;
-   return codec_to_wf_table[i].codec;
-}
+   {VC_CONTAINER_CODEC_ADPCM_MS,        WAVE_FORMAT_ADPCM},
+   {VC_CONTAINER_CODEC_AC3,             WAVE_FORMAT_DVM},
+   {VC_CONTAINER_CODEC_DTS,             WAVE_FORMAT_DTS},
+   {VC_CONTAINER_CODEC_WMA1,            WAVE_FORMAT_WMAUDIO1},
+   {VC_CONTAINER_CODEC_WMA2,            WAVE_FORMAT_WMAUDIO2},
+   {VC_CONTAINER_CODEC_EAC3,            WAVE_FORMAT_DVM},
+   {VC_CONTAINER_CODEC_ATRAC3,          WAVE_FORMAT_SONY_SCX},
+   {VC_CONTAINER_CODEC_MP4A,            WAVE_FORMAT_AAC},
+   {VC_CONTAINER_CODEC_MPGA,            WAVE_FORMAT_MPEG},
+   {VC_CONTAINER_CODEC_WMAL,            WAVE_FORMAT_WMAUDIO_LOSSLESS},
+   {VC_CONTAINER_CODEC_WMAP,            WAVE_FORMAT_WMAUDIOPRO},
+   {VC_CONTAINER_CODEC_PCM_SIGNED_LE,   WAVE_FORMAT_PCM},
+   {VC_CONTAINER_CODEC_WMAV,            WAVE_FORMAT_WMAUDIO_VOICE},
+   {VC_CONTAINER_CODEC_ALAW,            WAVE_FORMAT_ALAW},
+   {VC_CONTAINER_CODEC_MULAW,           WAVE_FORMAT_MULAW},
+};
+VC_CONTAINERS_STATIC_LIST(codec_to_wf_map, codec_to_wf_table, codec_map_comparator);
 
-uint16_t codec_to_waveformat(VC_CONTAINER_FOURCC_T codec)
+/*****************************************************************************/
+
+/* We are legally required to not play DivX in RELEASE mode. See Jira SW-3138 */
+#if defined(ENABLE_CONTAINERS_STANDALONE) || !defined(NDEBUG)
+#define DIVX_ENTRY(key, value) {key, value},
+#else
+#define DIVX_ENTRY(key, value)
+#endif
+
+static CODEC_MAP_ENTRY_T vfw_to_codec_table[] =
 {
-   unsigned int i;
-   for(i = 0; codec_to_wf_table[i].codec != VC_CONTAINER_CODEC_UNKNOWN; i++)
-      if(codec_to_wf_table[i].codec == codec) break;
-   return codec_to_wf_table[i].id;
-}
+   DIVX_ENTRY(VC_FOURCC('D','X','5','0'), VC_CONTAINER_CODEC_MP4V)
+   {VC_FOURCC('V','P','7','0'),          VC_CONTAINER_CODEC_VP7},
+   {VC_FOURCC('v','p','7','0'),          VC_CONTAINER_CODEC_VP7},
+   {VC_FOURCC('A','V','C','1'),          VC_CONTAINER_CODEC_H264},
+   {VC_FOURCC('W','V','C','1'),          VC_CONTAINER_CODEC_WVC1},
+   {VC_FOURCC('M','P','G','1'),          VC_CONTAINER_CODEC_MP1V},
+   {VC_FOURCC('F','L','V','1'),          VC_CONTAINER_CODEC_SPARK},
+   {VC_FOURCC('W','M','V','1'),          VC_CONTAINER_CODEC_WMV1},
+   {VC_FOURCC('a','v','c','1'),          VC_CONTAINER_CODEC_H264},
+   {VC_FOURCC('w','v','c','1'),          VC_CONTAINER_CODEC_WVC1},
+   {VC_FOURCC('m','p','g','1'),          VC_CONTAINER_CODEC_MP1V},
+   {VC_FOURCC('f','l','v','1'),          VC_CONTAINER_CODEC_SPARK},
+   {VC_FOURCC('w','m','v','1'),          VC_CONTAINER_CODEC_WMV1},
+   {VC_FOURCC('M','P','G','2'),          VC_CONTAINER_CODEC_MP2V},
+   {VC_FOURCC('M','4','S','2'),          VC_CONTAINER_CODEC_MP4V},
+   {VC_FOURCC('W','M','V','2'),          VC_CONTAINER_CODEC_WMV2},
+   {VC_FOURCC('m','p','g','2'),          VC_CONTAINER_CODEC_MP2V},
+   {VC_FOURCC('m','4','s','2'),          VC_CONTAINER_CODEC_MP4V},
+   {VC_FOURCC('w','m','v','2'),          VC_CONTAINER_CODEC_WMV2},
+   {VC_FOURCC('M','P','4','3'),          VC_CONTAINER_CODEC_DIV3},
+   {VC_FOURCC('m','p','4','3'),          VC_CONTAINER_CODEC_DIV3},
+   {VC_FOURCC('H','2','6','3'),          VC_CONTAINER_CODEC_H263},
+   {VC_FOURCC('h','2','6','3'),          VC_CONTAINER_CODEC_H263},
+   DIVX_ENTRY(VC_FOURCC('D','I','V','3'), VC_CONTAINER_CODEC_DIV3)
+   {VC_FOURCC('W','M','V','3'),          VC_CONTAINER_CODEC_WMV3},
+   DIVX_ENTRY(VC_FOURCC('d','i','v','3'), VC_CONTAINER_CODEC_DIV3)
+   {VC_FOURCC('w','m','v','3'),          VC_CONTAINER_CODEC_WMV3},
+   {VC_FOURCC('H','2','6','4'),          VC_CONTAINER_CODEC_H264},
+   {VC_FOURCC('h','2','6','4'),          VC_CONTAINER_CODEC_H264},
+   {VC_FOURCC('F','M','P','4'),          VC_CONTAINER_CODEC_MP4V},
+   DIVX_ENTRY(VC_FOURCC('D','I','V','4'), VC_CONTAINER_CODEC_DIV4)
+   DIVX_ENTRY(VC_FOURCC('d','i','v','4'), VC_CONTAINER_CODEC_DIV4)
+   {VC_FOURCC('W','M','V','A'),          VC_CONTAINER_CODEC_WMVA},
+   {VC_FOURCC('X','V','I','D'),          VC_CONTAINER_CODEC_MP4V},
+   {VC_FOURCC('V','P','6','F'),          VC_CONTAINER_CODEC_VP6},
+   {VC_FOURCC('M','J','P','G'),          VC_CONTAINER_CODEC_MJPEG},
+   {VC_FOURCC('M','P','4','S'),          VC_CONTAINER_CODEC_MP4V},
+   {VC_FOURCC('M','P','4','V'),          VC_CONTAINER_CODEC_MP4V},
+   DIVX_ENTRY(VC_FOURCC('D','I','V','X'), VC_CONTAINER_CODEC_MP4V)
+   {VC_FOURCC('w','m','v','a'),          VC_CONTAINER_CODEC_WMVA},
+   {VC_FOURCC('x','v','i','d'),          VC_CONTAINER_CODEC_MP4V},
+   {VC_FOURCC('v','p','6','f'),          VC_CONTAINER_CODEC_VP6},
+   {VC_FOURCC('m','j','p','g'),          VC_CONTAINER_CODEC_MJPEG},
+   {VC_FOURCC('m','p','4','s'),          VC_CONTAINER_CODEC_MP4V},
+   {VC_FOURCC('m','p','4','v'),          VC_CONTAINER_CODEC_MP4V},
+   DIVX_ENTRY(VC_FOURCC('d','i','v','x'), VC_CONTAINER_CODEC_MP4V)
+};
+VC_CONTAINERS_STATIC_LIST(vfw_to_codec_map, vfw_to_codec_table, codec_map_comparator);
 
-static struct {
-   VC_CONTAINER_FOURCC_T codec;
-   uint32_t fourcc;
-} codec_to_vfw_table[] =
+static CODEC_MAP_ENTRY_T codec_to_vfw_table[] =
 {
+   {VC_CONTAINER_CODEC_VP6,             VC_FOURCC('V','P','6','F')},
+   {VC_CONTAINER_CODEC_VP7,             VC_FOURCC('V','P','7','0')},
+   {VC_CONTAINER_CODEC_WVC1,            VC_FOURCC('W','V','C','1')},
+   {VC_CONTAINER_CODEC_WMV1,            VC_FOURCC('W','M','V','1')},
+   {VC_CONTAINER_CODEC_WMV2,            VC_FOURCC('W','M','V','2')},
+   {VC_CONTAINER_CODEC_H263,            VC_FOURCC('H','2','6','3')},
 #if defined(ENABLE_CONTAINERS_STANDALONE) || !defined(NDEBUG)
-   /* We are legally required to not play DivX in RELEASE mode. See Jira SW-3138 */
-   {VC_CONTAINER_CODEC_DIV3,             VC_FOURCC('D','I','V','3')},
-   {VC_CONTAINER_CODEC_DIV3,             VC_FOURCC('d','i','v','3')},
-   {VC_CONTAINER_CODEC_DIV4,             VC_FOURCC('D','I','V','4')},
-   {VC_CONTAINER_CODEC_DIV4,             VC_FOURCC('d','i','v','4')},
-   {VC_CONTAINER_CODEC_MP4V,             VC_FOURCC('D','X','5','0')},
-   {VC_CONTAINER_CODEC_MP4V,             VC_FOURCC('D','I','V','X')},
-   {VC_CONTAINER_CODEC_MP4V,             VC_FOURCC('d','i','v','x')},
-#endif /* ENABLE_CONTAINERS_STANDALONE || !NDEBUG */
-   {VC_CONTAINER_CODEC_MP4V,             VC_FOURCC('M','P','4','V')},
-   {VC_CONTAINER_CODEC_MP4V,             VC_FOURCC('m','p','4','v')},
-   {VC_CONTAINER_CODEC_MP4V,             VC_FOURCC('M','P','4','S')},
-   {VC_CONTAINER_CODEC_MP4V,             VC_FOURCC('m','p','4','s')},
-   {VC_CONTAINER_CODEC_MP4V,             VC_FOURCC('M','4','S','2')},
-   {VC_CONTAINER_CODEC_MP4V,             VC_FOURCC('m','4','s','2')},
-   {VC_CONTAINER_CODEC_MP4V,             VC_FOURCC('F','M','P','4')},
-   {VC_CONTAINER_CODEC_MP4V,             VC_FOURCC('X','V','I','D')},
-   {VC_CONTAINER_CODEC_MP4V,             VC_FOURCC('x','v','i','d')},
-   {VC_CONTAINER_CODEC_DIV3,             VC_FOURCC('M','P','4','3')},
-   {VC_CONTAINER_CODEC_DIV3,             VC_FOURCC('m','p','4','3')},
-   {VC_CONTAINER_CODEC_MP1V,             VC_FOURCC('m','p','g','1')},
-   {VC_CONTAINER_CODEC_MP1V,             VC_FOURCC('M','P','G','1')},
-   {VC_CONTAINER_CODEC_MP2V,             VC_FOURCC('m','p','g','2')},
-   {VC_CONTAINER_CODEC_MP2V,             VC_FOURCC('M','P','G','2')},
-   {VC_CONTAINER_CODEC_MJPEG,            VC_FOURCC('M','J','P','G')},
-   {VC_CONTAINER_CODEC_MJPEG,            VC_FOURCC('m','j','p','g')},
-   {VC_CONTAINER_CODEC_WMV1,             VC_FOURCC('W','M','V','1')},
-   {VC_CONTAINER_CODEC_WMV1,             VC_FOURCC('w','m','v','1')},
-   {VC_CONTAINER_CODEC_WMV2,             VC_FOURCC('W','M','V','2')},
-   {VC_CONTAINER_CODEC_WMV2,             VC_FOURCC('w','m','v','2')},
-   {VC_CONTAINER_CODEC_WMV3,             VC_FOURCC('W','M','V','3')},
-   {VC_CONTAINER_CODEC_WMV3,             VC_FOURCC('w','m','v','3')},
-   {VC_CONTAINER_CODEC_WVC1,             VC_FOURCC('W','V','C','1')},
-   {VC_CONTAINER_CODEC_WVC1,             VC_FOURCC('w','v','c','1')},
-   {VC_CONTAINER_CODEC_WMVA,             VC_FOURCC('w','m','v','a')},
-   {VC_CONTAINER_CODEC_WMVA,             VC_FOURCC('W','M','V','A')},
-   {VC_CONTAINER_CODEC_VP6,              VC_FOURCC('V','P','6','F')},
-   {VC_CONTAINER_CODEC_VP6,              VC_FOURCC('v','p','6','f')},
-   {VC_CONTAINER_CODEC_VP7,              VC_FOURCC('V','P','7','0')},
-   {VC_CONTAINER_CODEC_VP7,              VC_FOURCC('v','p','7','0')},
-   {VC_CONTAINER_CODEC_H263,             VC_FOURCC('H','2','6','3')},
-   {VC_CONTAINER_CODEC_H263,             VC_FOURCC('h','2','6','3')},
-   {VC_CONTAINER_CODEC_H264,             VC_FOURCC('H','2','6','4')},
-   {VC_CONTAINER_CODEC_H264,             VC_FOURCC('h','2','6','4')},
-   {VC_CONTAINER_CODEC_H264,             VC_FOURCC('A','V','C','1')},
-   {VC_CONTAINER_CODEC_H264,             VC_FOURCC('a','v','c','1')},
-   {VC_CONTAINER_CODEC_SPARK,            VC_FOURCC('F','L','V','1')},
-   {VC_CONTAINER_CODEC_SPARK,            VC_FOURCC('f','l','v','1')},
-   {VC_CONTAINER_CODEC_UNKNOWN, 0}
+   {VC_CONTAINER_CODEC_DIV3,            VC_FOURCC('D','I','V','3')},
+#else
+   {VC_CONTAINER_CODEC_DIV3,            VC_FOURCC('M','P','4','3')},
+#endif
+   {VC_CONTAINER_CODEC_WMV3,            VC_FOURCC('W','M','V','3')},
+   {VC_CONTAINER_CODEC_H264,            VC_FOURCC('H','2','6','4')},
+   DIVX_ENTRY(VC_CONTAINER_CODEC_DIV4,  VC_FOURCC('D','I','V','4'))
+   {VC_CONTAINER_CODEC_WMVA,            VC_FOURCC('w','m','v','a')},
+   {VC_CONTAINER_CODEC_MJPEG,           VC_FOURCC('M','J','P','G')},
+   {VC_CONTAINER_CODEC_SPARK,           VC_FOURCC('F','L','V','1')},
+   {VC_CONTAINER_CODEC_MP1V,            VC_FOURCC('m','p','g','1')},
+   {VC_CONTAINER_CODEC_MP2V,            VC_FOURCC('m','p','g','2')},
+#if defined(ENABLE_CONTAINERS_STANDALONE) || !defined(NDEBUG)
+   {VC_CONTAINER_CODEC_MP4V,            VC_FOURCC('D','X','5','0')},
+#else
+   {VC_CONTAINER_CODEC_MP4V,            VC_FOURCC('M','P','4','V')},
+#endif
 };
+VC_CONTAINERS_STATIC_LIST(codec_to_vfw_map, codec_to_vfw_table, codec_map_comparator);
 
-VC_CONTAINER_FOURCC_T vfw_fourcc_to_codec(uint32_t fourcc)
+/*****************************************************************************/
+static CODEC_MAP_ENTRY_T fourcc_to_codec_table[] =
 {
-   unsigned int i;
-   for(i = 0; codec_to_vfw_table[i].codec != VC_CONTAINER_CODEC_UNKNOWN; i++)
-      if(codec_to_vfw_table[i].fourcc == fourcc) break;
+   {VC_FOURCC('M','P','G','1'),          VC_CONTAINER_CODEC_MP1V},
+   {VC_FOURCC('W','M','V','1'),          VC_CONTAINER_CODEC_WMV1},
+   {VC_FOURCC('m','p','g','1'),          VC_CONTAINER_CODEC_MP1V},
+   {VC_FOURCC('w','m','v','1'),          VC_CONTAINER_CODEC_WMV1},
+   {VC_FOURCC('M','P','G','2'),          VC_CONTAINER_CODEC_MP2V},
+   {VC_FOURCC('M','4','S','2'),          VC_CONTAINER_CODEC_MP4V},
+   {VC_FOURCC('W','M','V','2'),          VC_CONTAINER_CODEC_WMV2},
+   {VC_FOURCC('m','p','g','2'),          VC_CONTAINER_CODEC_MP2V},
+   {VC_FOURCC('m','4','s','2'),          VC_CONTAINER_CODEC_MP4V},
+   {VC_FOURCC('w','m','v','2'),          VC_CONTAINER_CODEC_WMV2},
+   {VC_FOURCC('M','P','4','3'),          VC_CONTAINER_CODEC_DIV3},
+   {VC_FOURCC('m','p','4','3'),          VC_CONTAINER_CODEC_DIV3},
+   {VC_FOURCC('W','M','V','3'),          VC_CONTAINER_CODEC_WMV3},
+   {VC_FOURCC('w','m','v','3'),          VC_CONTAINER_CODEC_WMV3},
+   {VC_FOURCC('F','M','P','4'),          VC_CONTAINER_CODEC_MP4V},
+   {VC_FOURCC('M','J','P','G'),          VC_CONTAINER_CODEC_MJPEG},
+   {VC_FOURCC('M','P','4','S'),          VC_CONTAINER_CODEC_MP4V},
+   {VC_FOURCC('M','P','4','V'),          VC_CONTAINER_CODEC_MP4V},
+   {VC_FOURCC('m','j','p','g'),          VC_CONTAINER_CODEC_MJPEG},
+   {VC_FOURCC('m','p','4','s'),          VC_CONTAINER_CODEC_MP4V},
+   {VC_FOURCC('m','p','4','v'),          VC_CONTAINER_CODEC_MP4V},
+};
+VC_CONTAINERS_STATIC_LIST(fourcc_to_codec_map, fourcc_to_codec_table, codec_map_comparator);
 
-   if(codec_to_vfw_table[i].codec == VC_CONTAINER_CODEC_UNKNOWN)
-      return fourcc;
+static CODEC_MAP_ENTRY_T codec_to_fourcc_table[] =
+{
+   {VC_CONTAINER_CODEC_WMV1,            VC_FOURCC('W','M','V','1')},
+   {VC_CONTAINER_CODEC_WMV2,            VC_FOURCC('W','M','V','2')},
+   {VC_CONTAINER_CODEC_DIV3,            VC_FOURCC('M','P','4','3')},
+   {VC_CONTAINER_CODEC_WMV3,            VC_FOURCC('W','M','V','3')},
+   {VC_CONTAINER_CODEC_MJPEG,           VC_FOURCC('M','J','P','G')},
+   {VC_CONTAINER_CODEC_MP1V,            VC_FOURCC('m','p','g','1')},
+   {VC_CONTAINER_CODEC_MP2V,            VC_FOURCC('m','p','g','2')},
+   {VC_CONTAINER_CODEC_MP4V,            VC_FOURCC('M','P','4','S')},
+};
+VC_CONTAINERS_STATIC_LIST(codec_to_fourcc_map, codec_to_fourcc_table, codec_map_comparator);
+
+/*****************************************************************************/
+static bool codec_map_lookup(VC_CONTAINERS_LIST_T *map, uint32_t key, uint32_t *value)
+{
+   CODEC_MAP_ENTRY_T entry;
+
+#ifndef NDEBUG
+   static bool validated;
+   if(!validated)
+   {
+      validated = true;
+      vc_containers_list_validate(&wf_to_codec_map);
+      vc_containers_list_validate(&codec_to_wf_map);
+      vc_containers_list_validate(&vfw_to_codec_map);
+      vc_containers_list_validate(&codec_to_vfw_map);
+      vc_containers_list_validate(&fourcc_to_codec_map);
+      vc_containers_list_validate(&codec_to_fourcc_map);
+   }
+#endif
 
-   return codec_to_vfw_table[i].codec;
+   entry.key = key;
+   if(!vc_containers_list_find_entry(map, &entry))
+      return false;
+   *value = entry.value;
+   return true;
 }
 
-uint32_t codec_to_vfw_fourcc(VC_CONTAINER_FOURCC_T codec)
+/*****************************************************************************/
+VC_CONTAINER_FOURCC_T waveformat_to_codec(uint16_t waveformat_id)
 {
-   unsigned int i;
-   for(i = 0; codec_to_vfw_table[i].codec != VC_CONTAINER_CODEC_UNKNOWN; i++)
-      if(codec_to_vfw_table[i].codec == codec) break;
+   uint32_t codec;
+   if(!codec_map_lookup(&wf_to_codec_map, waveformat_id, &codec))
+      return VC_CONTAINER_CODEC_UNKNOWN;
+   return codec;
+}
 
-   return codec_to_vfw_table[i].fourcc;
+/*****************************************************************************/
+uint16_t codec_to_waveformat(VC_CONTAINER_FOURCC_T codec)
+{
+   uint32_t waveformat_id;
+   if(!codec_map_lookup(&codec_to_wf_map, codec, &waveformat_id))
+      return WAVE_FORMAT_UNKNOWN;
+   return (uint16_t)waveformat_id;
 }
 
-static struct {
-   VC_CONTAINER_FOURCC_T codec;
-   uint32_t fourcc;
-} codec_to_fourcc_table[] =
+/*****************************************************************************/
+VC_CONTAINER_FOURCC_T vfw_fourcc_to_codec(uint32_t fourcc)
 {
-   {VC_CONTAINER_CODEC_MP4V,             VC_FOURCC('M','P','4','S')},
-   {VC_CONTAINER_CODEC_MP4V,             VC_FOURCC('M','4','S','2')},
-   {VC_CONTAINER_CODEC_MP4V,             VC_FOURCC('m','p','4','s')},
-   {VC_CONTAINER_CODEC_MP4V,             VC_FOURCC('m','4','s','2')},
-   {VC_CONTAINER_CODEC_MP4V,             VC_FOURCC('M','P','4','V')},
-   {VC_CONTAINER_CODEC_MP4V,             VC_FOURCC('m','p','4','v')},
-   {VC_CONTAINER_CODEC_MP4V,             VC_FOURCC('F','M','P','4')},
-   {VC_CONTAINER_CODEC_DIV3,             VC_FOURCC('M','P','4','3')},
-   {VC_CONTAINER_CODEC_DIV3,             VC_FOURCC('m','p','4','3')},
-   {VC_CONTAINER_CODEC_WMV1,             VC_FOURCC('W','M','V','1')},
-   {VC_CONTAINER_CODEC_WMV1,             VC_FOURCC('w','m','v','1')},
-   {VC_CONTAINER_CODEC_WMV2,             VC_FOURCC('W','M','V','2')},
-   {VC_CONTAINER_CODEC_WMV2,             VC_FOURCC('w','m','v','2')},
-   {VC_CONTAINER_CODEC_WMV3,             VC_FOURCC('W','M','V','3')},
-   {VC_CONTAINER_CODEC_WMV3,             VC_FOURCC('w','m','v','3')},
-   {VC_CONTAINER_CODEC_MP1V,             VC_FOURCC('m','p','g','1')},
-   {VC_CONTAINER_CODEC_MP1V,             VC_FOURCC('M','P','G','1')},
-   {VC_CONTAINER_CODEC_MP2V,             VC_FOURCC('m','p','g','2')},
-   {VC_CONTAINER_CODEC_MP2V,             VC_FOURCC('M','P','G','2')},
-   {VC_CONTAINER_CODEC_MJPEG,            VC_FOURCC('M','J','P','G')},
-   {VC_CONTAINER_CODEC_MJPEG,            VC_FOURCC('m','j','p','g')},
-   {VC_CONTAINER_CODEC_UNKNOWN, 0}
-};
+   uint32_t codec;
+   if(!codec_map_lookup(&vfw_to_codec_map, fourcc, &codec))
+      return fourcc;
+   return codec;
+}
 
-VC_CONTAINER_FOURCC_T fourcc_to_codec(uint32_t fourcc)
+/*****************************************************************************/
+uint32_t codec_to_vfw_fourcc(VC_CONTAINER_FOURCC_T codec)
 {
-   unsigned int i;
-   for(i = 0; codec_to_fourcc_table[i].codec != VC_CONTAINER_CODEC_UNKNOWN; i++)
-      if(codec_to_fourcc_table[i].fourcc == fourcc) break;
+   uint32_t fourcc;
+   if(!codec_map_lookup(&codec_to_vfw_map, codec, &fourcc))
+      return 0;
+   return fourcc;
+}
 
-   return codec_to_fourcc_table[i].codec;
+/*****************************************************************************/
+VC_CONTAINER_FOURCC_T fourcc_to_codec(uint32_t fourcc)
+{
+   uint32_t codec;
+   if(!codec_map_lookup(&fourcc_to_codec_map, fourcc, &codec))
+      return VC_CONTAINER_CODEC_UNKNOWN;
+   return codec;
 }
 
+/*****************************************************************************/
 uint32_t codec_to_fourcc(VC_CONTAINER_FOURCC_T codec)
 {
-   unsigned int i;
-   for(i = 0; codec_to_fourcc_table[i].codec != VC_CONTAINER_CODEC_UNKNOWN; i++)
-      if(codec_to_fourcc_table[i].codec == codec) break;
-
-   return codec_to_fourcc_table[i].fourcc;
+   uint32_t fourcc;
+   if(!codec_map_lookup(&codec_to_fourcc_map, codec, &fourcc))
+      return 0;
+   return fourcc;
 }
@@ -0,0 +1,181 @@
+/*
+Copyright (c) 2012, Broadcom Europe Ltd
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <string.h>
+
+#include "containers/containers.h"
+#include "containers/core/containers_common.h"
+#include "containers/core/containers_crc.h"
+
+#if defined(__ARM_FEATURE_CRC32)
+# include <arm_acle.h>
+#endif
+
+/******************************************************************************
+Defines.
+******************************************************************************/
+/** Reflected generator polynomial of the CRC-32 used by EBML */
+#define CRC32_POLYNOMIAL   0xEDB88320
+/** Reflected generator polynomial of CRC-32C (Castagnoli) */
+#define CRC32C_POLYNOMIAL  0x82F63B78
+
+#if !defined(__ARM_FEATURE_CRC32)
+/** State of the table driven kernel for one polynomial.
+ * The tables allow a whole 32 bit word to be folded into the CRC at a time
+ * and are small enough (4kB per polynomial) to be built on first use rather
+ * than carried around in the binary. */
+typedef struct VC_CONTAINER_CRC_TABLES_T
+{
+   uint32_t table[4][256];
+   bool generated;
+} VC_CONTAINER_CRC_TABLES_T;
+
+static VC_CONTAINER_CRC_TABLES_T crc32_tables;
+static VC_CONTAINER_CRC_TABLES_T crc32c_tables;
+
+/*****************************************************************************/
+static void crc_generate_tables( VC_CONTAINER_CRC_TABLES_T *tables,
+   uint32_t polynomial )
+{
+   unsigned int i, j;
+
+   for (i = 0; i < 256; i++)
+   {
+      uint32_t crc = i;
+      for (j = 0; j < 8; j++)
+         crc = (crc & 1) ? (crc >> 1) ^ polynomial : (crc >> 1);
+      tables->table[0][i] = crc;
+   }
+
+   /* Each further table shifts the contribution of a byte 8 bits deeper into
+    * the word, so the 4 bytes of a word can be looked up independently */
+   for (i = 0; i < 256; i++)
+      for (j = 1; j < 4; j++)
+         tables->table[j][i] = (tables->table[j - 1][i] >> 8) ^
+            tables->table[0][tables->table[j - 1][i] & 0xFF];
+
+   tables->generated = true;
+}
+
+/*****************************************************************************/
+static uint32_t crc_table_update( VC_CONTAINER_CRC_TABLES_T *tables,
+   uint32_t polynomial, uint32_t crc, const uint8_t *data, size_t size )
+{
+   if (!tables->generated)
+      crc_generate_tables(tables, polynomial);
+
+   /* Align onto a word boundary so whole words can be loaded directly */
+   while (size && ((uintptr_t)data & 3))
+   {
+      crc = (crc >> 8) ^ tables->table[0][(crc ^ *data++) & 0xFF];
+      size--;
+   }
+
+   while (size >= 4)
+   {
+      crc ^= data[0] | (data[1] << 8) | ((uint32_t)data[2] << 16) |
+         ((uint32_t)data[3] << 24);
+      crc = tables->table[3][crc & 0xFF] ^ tables->table[2][(crc >> 8) & 0xFF] ^
+         tables->table[1][(crc >> 16) & 0xFF] ^ tables->table[0][crc >> 24];
+      data += 4;
+      size -= 4;
+   }
+
+   while (size--)
+      crc = (crc >> 8) ^ tables->table[0][(crc ^ *data++) & 0xFF];
+
+   return crc;
+}
+#endif /* !defined(__ARM_FEATURE_CRC32) */
+
+#if defined(__ARM_FEATURE_CRC32)
+/*****************************************************************************/
+static uint32_t crc32_hw_update( uint32_t crc, const uint8_t *data, size_t size )
+{
+   while (size && ((uintptr_t)data & 7))
+   {
+      crc = __crc32b(crc, *data++);
+      size--;
+   }
+   while (size >= 8)
+   {
+      uint64_t word;
+      memcpy(&word, data, sizeof(word));
+      crc = __crc32d(crc, word);
+      data += 8;
+      size -= 8;
+   }
+   while (size--)
+      crc = __crc32b(crc, *data++);
+   return crc;
+}
+
+/*****************************************************************************/
+static uint32_t crc32c_hw_update( uint32_t crc, const uint8_t *data, size_t size )
+{
+   while (size && ((uintptr_t)data & 7))
+   {
+      crc = __crc32cb(crc, *data++);
+      size--;
+   }
+   while (size >= 8)
+   {
+      uint64_t word;
+      memcpy(&word, data, sizeof(word));
+      crc = __crc32cd(crc, word);
+      data += 8;
+      size -= 8;
+   }
+   while (size--)
+      crc = __crc32cb(crc, *data++);
+   return crc;
+}
+#endif /* defined(__ARM_FEATURE_CRC32) */
+
+/*****************************************************************************/
+uint32_t vc_container_crc32( uint32_t crc, const uint8_t *data, size_t size )
+{
+   crc = ~crc;
+#if defined(__ARM_FEATURE_CRC32)
+   crc = crc32_hw_update(crc, data, size);
+#else
+   crc = crc_table_update(&crc32_tables, CRC32_POLYNOMIAL, crc, data, size);
+#endif
+   return ~crc;
+}
+
+/*****************************************************************************/
+uint32_t vc_container_crc32c( uint32_t crc, const uint8_t *data, size_t size )
+{
+   crc = ~crc;
+#if defined(__ARM_FEATURE_CRC32)
+   crc = crc32c_hw_update(crc, data, size);
+#else
+   crc = crc_table_update(&crc32c_tables, CRC32C_POLYNOMIAL, crc, data, size);
+#endif
+   return ~crc;
+}
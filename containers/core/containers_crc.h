@@ -0,0 +1,55 @@
+/*
+Copyright (c) 2012, Broadcom Europe Ltd
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef VC_CONTAINERS_CRC_H
+#define VC_CONTAINERS_CRC_H
+
+/** \file containers_crc.h
+ * CRC kernels used by the container layer for integrity checking.
+ * On processors with the ARMv8 CRC32 instructions the checksums are computed
+ * in hardware, otherwise a table driven kernel processing a word at a time
+ * is used. Both checksums can be computed incrementally by feeding the result
+ * of one call as the crc argument of the next, starting from zero. */
+
+#include "containers/containers.h"
+
+/** Update a CRC-32 (as used by EBML CRC-32 elements) with a block of data.
+ *
+ * \param crc Running CRC value, zero for the first block
+ * \param data Block of data to add to the CRC
+ * \param size Size of the block in bytes
+ * \return Updated CRC value */
+uint32_t vc_container_crc32( uint32_t crc, const uint8_t *data, size_t size );
+
+/** Update a CRC-32C (Castagnoli) with a block of data.
+ *
+ * \param crc Running CRC value, zero for the first block
+ * \param data Block of data to add to the CRC
+ * \param size Size of the block in bytes
+ * \return Updated CRC value */
+uint32_t vc_container_crc32c( uint32_t crc, const uint8_t *data, size_t size );
+
+#endif /* VC_CONTAINERS_CRC_H */
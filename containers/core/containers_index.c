@@ -29,58 +29,250 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <string.h>
 
 #include "containers/containers.h"
+#include "containers/core/containers_io.h"
 #include "containers/core/containers_index.h"
+#include "containers/core/containers_crc.h"
+
+// The index is stored delta-compressed. Entries are grouped into blocks of
+// INDEX_BLOCK_ENTRIES; each block starts at a sync point which stores the
+// absolute time and file offset of its first entry together with the offset
+// of the block in the compressed stream. The remaining entries of a block
+// are stored as variable length deltas from their predecessor, so a typical
+// entry costs a few bytes instead of the 16 of a raw time / offset pair and
+// the same memory holds several times more entries than the flat array this
+// replaces.  Lookups binary search the sync table and then decode at most
+// one block, so they stay O(log n).
+// When the index is full every other entry is discarded, as the flat array
+// version did, and the discard rate of subsequent entries is doubled.
+
+#define INDEX_BLOCK_ENTRIES 32 /* Needs to be a power of 2 */
 
 typedef struct {
-   int64_t file_offset;
-   int64_t time;
-} VC_CONTAINER_INDEX_POS_T;
-
-struct  VC_CONTAINER_INDEX_T {
-   int len;                           // log2 of length of entry array
-   int next;                          // next array entry to write into
-   int gap;                           // log2 of the passes through entry array to build the full list
-   int mgap;                          // len-gap, stored for convenience
-   int count;                         // number of calls to index_add since last entry added
-   int max_count;                     // log2 of the number of calls to discard between each entry added
-   int64_t max_time;                  // time of the latest entry
-   VC_CONTAINER_INDEX_POS_T entry[0]; // array of position/time pairs   
+   int64_t time;          // absolute time of the first entry of the block
+   int64_t file_offset;   // absolute file offset of the first entry of the block
+   uint32_t byte_offset;  // offset of the block in the compressed stream
+   uint32_t pad;          // explicit padding, kept zero so saved indexes are deterministic
+} VC_CONTAINER_INDEX_SYNC_T;
+
+struct VC_CONTAINER_INDEX_T {
+   unsigned int num_syncs;      // number of sync points in use
+   unsigned int max_syncs;      // capacity of the sync table
+   unsigned int num_entries;    // total number of entries stored
+   unsigned int block_entries;  // number of entries in the block being filled
+   unsigned int bytes;          // bytes of compressed stream in use
+   unsigned int max_bytes;      // capacity of the compressed stream
+   int count;                   // number of calls to index_add since last entry added
+   int max_count;               // log2 of the number of calls to discard between each entry added
+   int64_t last_time;           // time of the latest entry, predictor for the next delta
+   int64_t last_offset;         // file offset of the latest entry, predictor for the next delta
+   int64_t max_time;            // time of the latest entry
+   VC_CONTAINER_INDEX_SYNC_T *sync; // sync table, followed in memory by ...
+   uint8_t *data;               // ... the compressed stream
 };
 
-// We have a fixed length list, and when it is full we want to discard half the entries.
-// This is done without coping data by mapping the entry number to the index to the array,
-// in the following way:
-// Length is a power of two, so the entry number is a fixed constant bit width.  The highest gap
-// bits are used as a direct offset into the array (o), the lowest mgap bits are right shifted by
-// gap to increment this (S).  Each time we double the number of passes through the actual array.
-// So if len=3, we start off with mgap=3, gap=0, we have a single pass with the trivial mapping:
-// |S|S|S|  [0 1 2 3 4 5 6 7]
-// when this is full we change to mgap=2, gap=1, so we iterate this way:
-// |o|S|S|  [0 2 4 6] [1 3 5 7]
-// when this is full we change to mgap=1, gap=2
-// |o|o|S|  [0 4] [1 5] [2 6] [3 7]  
-// when this is full we change to this, which is equivalent to where we started
-// |o|o|o|  [0] [1] [2] [3] [4] [5] [6] [7]
-
-#define ENTRY(x, i) ((x)->gap == 0 ? (i) : ((i)>>(x)->mgap) + (((i) & ((1<<(x)->mgap)-1)) << (x)->gap))
+// Header of the sidecar file used to persist an index across sessions.
+// The sidecar is a cache written and read back on the same device, so the
+// fields are stored in native endianness and invalidated by a version bump.
+#define INDEX_SIDECAR_SUFFIX  ".vcidx"
+#define INDEX_SIDECAR_MAGIC   VC_FOURCC('v','c','i','x')
+#define INDEX_SIDECAR_VERSION 3
+
+typedef struct {
+   uint32_t magic;
+   uint32_t version;
+   uint32_t num_syncs;
+   uint32_t max_syncs;
+   uint32_t num_entries;
+   uint32_t block_entries;
+   uint32_t bytes;
+   uint32_t max_bytes;
+   int32_t count;
+   int32_t max_count;
+   int64_t last_time;
+   int64_t last_offset;
+   int64_t max_time;
+   int64_t source_size;       // size of the media file when the index was saved
+   uint32_t crc;              // CRC-32C of the sync table and compressed stream
+} VC_CONTAINER_INDEX_SIDECAR_T;
+
+static char *index_sidecar_uri( const char *uri )
+{
+   size_t len = strlen(uri);
+   char *sidecar = malloc(len + sizeof(INDEX_SIDECAR_SUFFIX));
+   if(sidecar)
+   {
+      memcpy(sidecar, uri, len);
+      memcpy(sidecar + len, INDEX_SIDECAR_SUFFIX, sizeof(INDEX_SIDECAR_SUFFIX));
+   }
+   return sidecar;
+}
+
+static unsigned int index_varint_encode( uint8_t *buffer, uint64_t value )
+{
+   unsigned int i = 0;
+   do {
+      buffer[i++] = (value & 0x7f) | (value >= 0x80 ? 0x80 : 0);
+      value >>= 7;
+   } while(value);
+   return i;
+}
+
+static unsigned int index_varint_decode( const uint8_t *buffer, uint64_t *value )
+{
+   unsigned int i = 0, shift = 0;
+   *value = 0;
+   do {
+      *value |= (uint64_t)(buffer[i] & 0x7f) << shift;
+      shift += 7;
+   } while(buffer[i++] & 0x80);
+   return i;
+}
+
+// Zigzag mapping so small negative offset deltas also encode into few bytes
+static uint64_t index_zigzag( int64_t value )
+{
+   return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static int64_t index_unzigzag( uint64_t value )
+{
+   return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+// Appends an entry to the compressed stream. Fails without side effects if
+// the sync table or the stream is full.
+static bool index_append( VC_CONTAINER_INDEX_T *index, int64_t time, int64_t file_offset )
+{
+   uint8_t tmp[20];
+   unsigned int bytes;
+
+   if(index->num_entries == 0 || index->block_entries == INDEX_BLOCK_ENTRIES)
+   {
+      // Start a new block. Sync points store their entry in full so it
+      // costs nothing in the stream itself.
+      VC_CONTAINER_INDEX_SYNC_T *sync;
+      if(index->num_syncs == index->max_syncs)
+         return false;
+
+      sync = &index->sync[index->num_syncs];
+      sync->time = time;
+      sync->file_offset = file_offset;
+      sync->byte_offset = index->bytes;
+      sync->pad = 0;
+      index->num_syncs++;
+      index->block_entries = 0;
+   }
+   else
+   {
+      bytes = index_varint_encode(tmp, (uint64_t)(time - index->last_time));
+      bytes += index_varint_encode(tmp + bytes, index_zigzag(file_offset - index->last_offset));
+      if(index->bytes + bytes > index->max_bytes)
+         return false;
+      memcpy(index->data + index->bytes, tmp, bytes);
+      index->bytes += bytes;
+   }
+
+   index->block_entries++;
+   index->num_entries++;
+   index->last_time = time;
+   index->last_offset = file_offset;
+   return true;
+}
+
+// Discards every other entry by re-encoding the stream. The sync table is
+// rebuilt in place since a rebuilt sync point never overtakes the decoder,
+// but the stream itself is re-encoded through a scratch buffer because a
+// merged delta can be larger than the bytes it replaces.
+static bool index_compact( VC_CONTAINER_INDEX_T *index )
+{
+   unsigned int i, n, in = 0, out = 0, num_syncs = 0, block_entries = 0;
+   int64_t time = 0, file_offset = 0, prev_time = 0, prev_offset = 0;
+   uint8_t *scratch, tmp[20];
+   uint64_t value;
+
+   scratch = malloc(index->max_bytes);
+   if(scratch == NULL)
+      return false;
+
+   for(i = 0; i < index->num_entries; i++)
+   {
+      // Decode the next entry
+      if((i & (INDEX_BLOCK_ENTRIES-1)) == 0)
+      {
+         time = index->sync[i / INDEX_BLOCK_ENTRIES].time;
+         file_offset = index->sync[i / INDEX_BLOCK_ENTRIES].file_offset;
+      }
+      else
+      {
+         in += index_varint_decode(index->data + in, &value);
+         time += (int64_t)value;
+         in += index_varint_decode(index->data + in, &value);
+         file_offset += index_unzigzag(value);
+      }
+
+      // Keep every other entry
+      if(i & 1)
+         continue;
+
+      if(block_entries == 0 || block_entries == INDEX_BLOCK_ENTRIES)
+      {
+         index->sync[num_syncs].time = time;
+         index->sync[num_syncs].file_offset = file_offset;
+         index->sync[num_syncs].byte_offset = out;
+         index->sync[num_syncs].pad = 0;
+         num_syncs++;
+         block_entries = 0;
+      }
+      else
+      {
+         n = index_varint_encode(tmp, (uint64_t)(time - prev_time));
+         n += index_varint_encode(tmp + n, index_zigzag(file_offset - prev_offset));
+         memcpy(scratch + out, tmp, n);
+         out += n;
+      }
+      block_entries++;
+      prev_time = time;
+      prev_offset = file_offset;
+   }
+
+   memcpy(index->data, scratch, out);
+   free(scratch);
+
+   index->num_entries = (index->num_entries + 1) / 2;
+   index->num_syncs = num_syncs;
+   index->block_entries = block_entries;
+   index->bytes = out;
+   index->last_time = prev_time;
+   index->last_offset = prev_offset;
+   return true;
+}
 
 VC_CONTAINER_STATUS_T vc_container_index_create( VC_CONTAINER_INDEX_T **index, int length )
 {
    VC_CONTAINER_STATUS_T status = VC_CONTAINER_ERROR_OUT_OF_MEMORY;
    VC_CONTAINER_INDEX_T *id = NULL;
-   int len = 0;
+   unsigned int max_syncs, max_bytes;
 
    if(length < 16) length = 16;
    if(length > 4096) length = 4096;
-   while((length >>= 1) != 0)
-      len++;
 
-   id = malloc(sizeof(VC_CONTAINER_INDEX_T) + (sizeof(VC_CONTAINER_INDEX_POS_T)<<len));
+   // Budget roughly the same memory as the flat array used for the same
+   // suggested length, split between the sync table and the compressed
+   // stream. With typical streams this holds several times more entries
+   // before anything has to be discarded.
+   max_syncs = length / 8;
+   max_bytes = length * 13;
+
+   id = malloc(sizeof(VC_CONTAINER_INDEX_T) +
+               max_syncs * sizeof(VC_CONTAINER_INDEX_SYNC_T) + max_bytes);
    if(id == NULL) { goto error; }
-   
+
    memset(id, 0, sizeof(VC_CONTAINER_INDEX_T));
 
-   id->len = id->mgap = len;
+   id->max_syncs = max_syncs;
+   id->max_bytes = max_bytes;
+   id->sync = (VC_CONTAINER_INDEX_SYNC_T *)(id + 1);
+   id->data = (uint8_t *)(id->sync + max_syncs);
 
    *index = id;
    return VC_CONTAINER_SUCCESS;
@@ -104,35 +296,24 @@ VC_CONTAINER_STATUS_T vc_container_index_add( VC_CONTAINER_INDEX_T *index, int64
       return VC_CONTAINER_ERROR_FAILED;
 
    // reject entries if they are in part of the time covered
-   if(index->next != 0 && time <= index->max_time)
+   if(index->num_entries != 0 && time <= index->max_time)
       return VC_CONTAINER_SUCCESS;
 
    index->count++;
    if(index->count == (1<<index->max_count))
    {
-      int entry;
-      if(index->next == (1<<index->len))
+      index->count = 0;
+
+      while(!index_append(index, time, file_offset))
       {
-         // New entry doesn't fit, we discard every other index record
-         // by changing how we map index positions to array entry indexes.
-         index->next >>= 1;
-         index->gap++;
-         index->mgap--;
+         // New entry doesn't fit, we discard every other index record.
+         // If the compaction scratch buffer cannot be allocated this
+         // entry is dropped and the next one will try again.
+         if(!index_compact(index))
+            return VC_CONTAINER_SUCCESS;
          index->max_count++;
-
-         if(index->gap == index->len)
-         {
-            index->gap = 0;
-            index->mgap = index->len;
-         }
       }
 
-      entry = ENTRY(index, index->next);
-
-      index->entry[entry].file_offset = file_offset;
-      index->entry[entry].time = time;
-      index->count = 0;
-      index->next++;
       index->max_time = time;
    }
 
@@ -141,52 +322,198 @@ VC_CONTAINER_STATUS_T vc_container_index_add( VC_CONTAINER_INDEX_T *index, int64
 
 VC_CONTAINER_STATUS_T vc_container_index_get( VC_CONTAINER_INDEX_T *index, int later, int64_t *time, int64_t *file_offset, int *past )
 {
-   int guess, start, end, entry;
+   unsigned int start, end, guess, block, pos, block_end;
+   int64_t prev_time, prev_offset, cur_time, cur_offset;
+   uint64_t value;
 
-   if(index == NULL || index->next == 0)
+   if(index == NULL || index->num_entries == 0)
       return VC_CONTAINER_ERROR_FAILED;
 
-   guess = start = 0;
-   end = index->next-1;
-
    *past = *time > index->max_time;
 
-   while(end-start > 1)
+   // Binary search for the last block starting at or before the target
+   start = 0;
+   end = index->num_syncs - 1;
+   while(end > start)
    {
-      int64_t gtime;
-      guess = (start+end)>>1;
-      gtime = index->entry[ENTRY(index, guess)].time;
-
-      if(*time < gtime)
-         end = guess;
-      else if(*time > gtime)
-         start = guess;
+      guess = (start + end + 1) >> 1;
+      if(*time < index->sync[guess].time)
+         end = guess - 1;
       else
-         break;
+         start = guess;
    }
+   block = start;
+
+   // Walk the block looking for the pair of entries straddling the target
+   prev_time = cur_time = index->sync[block].time;
+   prev_offset = cur_offset = index->sync[block].file_offset;
+   pos = index->sync[block].byte_offset;
+   block_end = block + 1 < index->num_syncs ?
+      index->sync[block + 1].byte_offset : index->bytes;
 
-   if (*time != index->entry[ENTRY(index, guess)].time)
+   while(cur_time < *time && pos < block_end)
    {
-      if(later)
-      {
-         if(*time <= index->entry[ENTRY(index, start)].time)
-            guess = start;
-         else
-            guess = end;
-      }
-      else
-      {
-         if(*time >= index->entry[ENTRY(index, end)].time)
-            guess = end;
-         else
-            guess = start;
-      }
+      prev_time = cur_time;
+      prev_offset = cur_offset;
+      pos += index_varint_decode(index->data + pos, &value);
+      cur_time += (int64_t)value;
+      pos += index_varint_decode(index->data + pos, &value);
+      cur_offset += index_unzigzag(value);
    }
 
-   entry = ENTRY(index, guess);
-   *time = index->entry[entry].time;
-   *file_offset = index->entry[entry].file_offset;
+   if(cur_time < *time && block + 1 < index->num_syncs)
+   {
+      // The target falls in the gap between the end of this block and the
+      // next sync point
+      prev_time = cur_time;
+      prev_offset = cur_offset;
+      cur_time = index->sync[block + 1].time;
+      cur_offset = index->sync[block + 1].file_offset;
+   }
+
+   if(!later && cur_time > *time)
+   {
+      *time = prev_time;
+      *file_offset = prev_offset;
+   }
+   else
+   {
+      *time = cur_time;
+      *file_offset = cur_offset;
+   }
 
    return VC_CONTAINER_SUCCESS;
 }
 
+VC_CONTAINER_STATUS_T vc_container_index_save( VC_CONTAINER_INDEX_T *index, const char *uri, int64_t source_size )
+{
+   VC_CONTAINER_STATUS_T status;
+   VC_CONTAINER_INDEX_SIDECAR_T header;
+   VC_CONTAINER_IO_T *io;
+   char *sidecar;
+   size_t sync_size;
+
+   if(index == NULL || uri == NULL)
+      return VC_CONTAINER_ERROR_FAILED;
+
+   sidecar = index_sidecar_uri(uri);
+   if(sidecar == NULL)
+      return VC_CONTAINER_ERROR_OUT_OF_MEMORY;
+
+   io = vc_container_io_open(sidecar, VC_CONTAINER_IO_MODE_WRITE, &status);
+   free(sidecar);
+   if(io == NULL)
+      return status;
+
+   memset(&header, 0, sizeof(header));
+   header.magic = INDEX_SIDECAR_MAGIC;
+   header.version = INDEX_SIDECAR_VERSION;
+   header.num_syncs = index->num_syncs;
+   header.max_syncs = index->max_syncs;
+   header.num_entries = index->num_entries;
+   header.block_entries = index->block_entries;
+   header.bytes = index->bytes;
+   header.max_bytes = index->max_bytes;
+   header.count = index->count;
+   header.max_count = index->max_count;
+   header.last_time = index->last_time;
+   header.last_offset = index->last_offset;
+   header.max_time = index->max_time;
+   header.source_size = source_size;
+
+   // Only the used part of the sync table and stream is written out,
+   // together with the decimation state, so the reloaded index carries on
+   // exactly where it left off.
+   sync_size = index->num_syncs * sizeof(VC_CONTAINER_INDEX_SYNC_T);
+   header.crc = vc_container_crc32c(0, (const uint8_t *)index->sync, sync_size);
+   header.crc = vc_container_crc32c(header.crc, index->data, index->bytes);
+   if(vc_container_io_write(io, &header, sizeof(header)) != sizeof(header) ||
+      vc_container_io_write(io, index->sync, sync_size) != sync_size ||
+      vc_container_io_write(io, index->data, index->bytes) != index->bytes)
+      status = VC_CONTAINER_ERROR_OUT_OF_SPACE;
+   else
+      status = VC_CONTAINER_SUCCESS;
+
+   vc_container_io_close(io);
+   return status;
+}
+
+VC_CONTAINER_STATUS_T vc_container_index_load( VC_CONTAINER_INDEX_T **index, const char *uri, int64_t source_size )
+{
+   VC_CONTAINER_STATUS_T status;
+   VC_CONTAINER_INDEX_SIDECAR_T header;
+   VC_CONTAINER_INDEX_T *id = NULL;
+   VC_CONTAINER_IO_T *io;
+   char *sidecar;
+   size_t sync_size;
+   uint32_t crc;
+
+   if(index == NULL || uri == NULL)
+      return VC_CONTAINER_ERROR_FAILED;
+
+   sidecar = index_sidecar_uri(uri);
+   if(sidecar == NULL)
+      return VC_CONTAINER_ERROR_OUT_OF_MEMORY;
+
+   // On platforms with the memory mapped file i/o this open returns a mapping
+   // of the sidecar, so the load is served straight from the page cache.
+   io = vc_container_io_open(sidecar, VC_CONTAINER_IO_MODE_READ, &status);
+   free(sidecar);
+   if(io == NULL)
+      return status;
+
+   status = VC_CONTAINER_ERROR_FORMAT_INVALID;
+   if(vc_container_io_read(io, &header, sizeof(header)) != sizeof(header) ||
+      header.magic != INDEX_SIDECAR_MAGIC || header.version != INDEX_SIDECAR_VERSION ||
+      header.source_size != source_size)
+      goto error;
+
+   // Sanity check the header before trusting it
+   if(header.max_syncs < 2 || header.max_syncs > 512 ||
+      header.max_bytes > 64*1024 || header.bytes > header.max_bytes ||
+      header.num_syncs > header.max_syncs ||
+      header.num_entries > header.num_syncs * INDEX_BLOCK_ENTRIES ||
+      (header.num_entries == 0) != (header.num_syncs == 0) ||
+      header.block_entries > INDEX_BLOCK_ENTRIES ||
+      header.max_count < 0 || header.max_count > 30 ||
+      header.count < 0 || header.count >= (1<<header.max_count))
+      goto error;
+
+   id = malloc(sizeof(VC_CONTAINER_INDEX_T) +
+               header.max_syncs * sizeof(VC_CONTAINER_INDEX_SYNC_T) + header.max_bytes);
+   if(id == NULL) { status = VC_CONTAINER_ERROR_OUT_OF_MEMORY; goto error; }
+
+   memset(id, 0, sizeof(VC_CONTAINER_INDEX_T));
+   id->num_syncs = header.num_syncs;
+   id->max_syncs = header.max_syncs;
+   id->num_entries = header.num_entries;
+   id->block_entries = header.block_entries;
+   id->bytes = header.bytes;
+   id->max_bytes = header.max_bytes;
+   id->count = header.count;
+   id->max_count = header.max_count;
+   id->last_time = header.last_time;
+   id->last_offset = header.last_offset;
+   id->max_time = header.max_time;
+   id->sync = (VC_CONTAINER_INDEX_SYNC_T *)(id + 1);
+   id->data = (uint8_t *)(id->sync + id->max_syncs);
+
+   status = VC_CONTAINER_ERROR_FORMAT_INVALID;
+   sync_size = id->num_syncs * sizeof(VC_CONTAINER_INDEX_SYNC_T);
+   if(vc_container_io_read(io, id->sync, sync_size) != sync_size ||
+      vc_container_io_read(io, id->data, id->bytes) != id->bytes)
+      goto error;
+   crc = vc_container_crc32c(0, (const uint8_t *)id->sync, sync_size);
+   crc = vc_container_crc32c(crc, id->data, id->bytes);
+   if(crc != header.crc)
+      goto error;
+
+   vc_container_io_close(io);
+   *index = id;
+   return VC_CONTAINER_SUCCESS;
+
+ error:
+   free(id);
+   vc_container_io_close(io);
+   return status;
+}
@@ -79,4 +79,29 @@ VC_CONTAINER_STATUS_T vc_container_index_add( VC_CONTAINER_INDEX_T *index, int64
  */
 VC_CONTAINER_STATUS_T vc_container_index_get( VC_CONTAINER_INDEX_T *index, int later, int64_t *time, int64_t *file_offset, int *past );
 
+
+/**
+ * Saves an index to a sidecar file next to the media it indexes, so it can be
+ * reloaded with \ref vc_container_index_load instead of being rebuilt.
+ * The sidecar is a local cache and is stored in native endianness.
+ * @param index        Pointer to valid index.
+ * @param uri          URI of the media file the index refers to.  The sidecar
+ *                     file name is derived from this.
+ * @param source_size  Size of the media file, stored for staleness detection.
+ * @return             Status code.
+ */
+VC_CONTAINER_STATUS_T vc_container_index_save( VC_CONTAINER_INDEX_T *index, const char *uri, int64_t source_size );
+
+
+/**
+ * Loads an index previously saved with \ref vc_container_index_save.
+ * The load is rejected if the sidecar file is missing, was written by a
+ * different version, or if the media file size has changed since it was saved.
+ * @param index        Pointer to loaded index will be filled here on success.
+ * @param uri          URI of the media file the index refers to.
+ * @param source_size  Current size of the media file.
+ * @return             Status code.
+ */
+VC_CONTAINER_STATUS_T vc_container_index_load( VC_CONTAINER_INDEX_T **index, const char *uri, int64_t source_size );
+
 #endif /* VC_CONTAINERS_WRITER_UTILS_H */
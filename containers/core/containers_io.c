@@ -35,14 +35,23 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "containers/core/containers_utils.h"
 #include "containers/core/containers_uri.h"
 
+/* Process-wide counters on the shared vcos telemetry page, registered
+   lazily on the first transfer */
+static volatile uint32_t *telemetry_bytes_read;
+static volatile uint32_t *telemetry_bytes_written;
+
 #define MAX_NUM_CACHED_AREAS 16
+#define URI_PARTS_MEM_SIZE 256 /* For the parsed uri structure and the query array */
 #define MAX_NUM_MEMORY_AREAS 4
 #define NUM_TMP_MEMORY_AREAS 2
 #define MEM_CACHE_READ_MAX_SIZE (32*1024) /* Needs to be a power of 2 */
+#define MEM_CACHE_READ_MIN_SIZE (8*1024) /* Needs to be a power of 2 */
+#define MEM_CACHE_READ_ADAPT_MAX_SIZE (512*1024) /* Needs to be a power of 2 */
 #define MEM_CACHE_WRITE_MAX_SIZE (128*1024) /* Needs to be a power of 2 */
 #define MEM_CACHE_TMP_MAX_SIZE (32*1024) /* Needs to be a power of 2 */
 #define MEM_CACHE_ALIGNMENT (1*1024) /* Needs to be a power of 2 */
 #define MEM_CACHE_AREA_READ_MAX_SIZE (4*1024*1024) /* Needs to be a power of 2 */
+#define MEM_CACHE_ADAPT_THRESHOLD 4 /* Consecutive refills / missed seeks before the read size adapts */
 
 typedef struct VC_CONTAINER_IO_PRIVATE_CACHE_T
 {
@@ -55,6 +64,8 @@ typedef struct VC_CONTAINER_IO_PRIVATE_CACHE_T
 
    size_t position; /**< Current position in the cache */
 
+   unsigned int refcount; /**< Number of outstanding borrowed references into the cache memory */
+
    uint8_t *buffer;          /**< Pointer to the start of the valid cache area */
    uint8_t *buffer_end;      /**< Pointer to the end of the cache */
 
@@ -62,6 +73,11 @@ typedef struct VC_CONTAINER_IO_PRIVATE_CACHE_T
    unsigned int mem_size; /**< Size of the memory cache */
    uint8_t *mem;          /**< Pointer to the memory cache */
 
+   bool adaptive;           /**< Whether the refill size adapts to the access pattern */
+   unsigned int read_size;  /**< Current refill size */
+   unsigned int run_length; /**< Consecutive refills since the last seek outside the cache */
+   unsigned int miss_seeks; /**< Seeks outside the cached data since the last resize */
+
    VC_CONTAINER_IO_T *io;
 
 } VC_CONTAINER_IO_PRIVATE_CACHE_T;
@@ -80,6 +96,11 @@ typedef struct VC_CONTAINER_IO_PRIVATE_T
 
    struct VC_CONTAINER_IO_ASYNC_T *async_io;
 
+   struct VC_CONTAINER_IO_READAHEAD_T *readahead;
+
+   int stats_enable;                 /**< Whether read-side statistics are recorded */
+   VC_CONTAINER_READ_STATS_T stats;  /**< Read-side statistics */
+
 } VC_CONTAINER_IO_PRIVATE_T;
 
 /*****************************************************************************/
@@ -93,6 +114,8 @@ VC_CONTAINER_STATUS_T vc_container_io_pktfile_open( VC_CONTAINER_IO_T *p_ctx, co
                                                  VC_CONTAINER_IO_MODE_T mode );
 VC_CONTAINER_STATUS_T vc_container_io_http_open( VC_CONTAINER_IO_T *p_ctx, const char *uri,
                                                  VC_CONTAINER_IO_MODE_T mode );
+VC_CONTAINER_STATUS_T vc_container_io_mmap_open( VC_CONTAINER_IO_T *p_ctx, const char *uri,
+                                                 VC_CONTAINER_IO_MODE_T mode );
 static VC_CONTAINER_STATUS_T io_seek_not_seekable(VC_CONTAINER_IO_T *p_ctx, int64_t offset);
 
 static size_t vc_container_io_cache_read( VC_CONTAINER_IO_T *p_ctx,
@@ -114,6 +137,14 @@ static VC_CONTAINER_STATUS_T async_io_wait_complete( struct VC_CONTAINER_IO_ASYN
 static void async_io_stats_initialise( struct VC_CONTAINER_IO_ASYNC_T *ctx, int enable );
 static void async_io_stats_get( struct VC_CONTAINER_IO_ASYNC_T *ctx, VC_CONTAINER_WRITE_STATS_T *stats );
 
+static struct VC_CONTAINER_IO_READAHEAD_T *io_readahead_start( VC_CONTAINER_IO_T *io );
+static void io_readahead_stop( struct VC_CONTAINER_IO_READAHEAD_T *ctx );
+static void io_readahead_sync( struct VC_CONTAINER_IO_READAHEAD_T *ctx );
+static void io_readahead_kick( struct VC_CONTAINER_IO_READAHEAD_T *ctx,
+   VC_CONTAINER_IO_PRIVATE_CACHE_T *cache );
+static size_t io_readahead_refill( struct VC_CONTAINER_IO_READAHEAD_T *ctx,
+   VC_CONTAINER_IO_PRIVATE_CACHE_T *cache );
+
 /*****************************************************************************/
 static VC_CONTAINER_IO_T *vc_container_io_open_core( const char *uri, VC_CONTAINER_IO_MODE_T mode,
                                                      VC_CONTAINER_IO_CAPABILITIES_T capabilities,
@@ -127,14 +158,20 @@ static VC_CONTAINER_IO_T *vc_container_io_open_core( const char *uri, VC_CONTAIN
    /* XXX */
    uri_length = strlen(uri) + 1;
 
-   /* Allocate our context before trying out the different io modules */
-   p_ctx = malloc( sizeof(*p_ctx) + sizeof(*private) + uri_length);
+   /* Allocate our context before trying out the different io modules. The
+    * parsed uri lives in the same allocation; budgeting twice the escaped
+    * length leaves enough room for the unescaped components, so the parse
+    * itself doesn't need the heap. */
+   p_ctx = malloc( sizeof(*p_ctx) + sizeof(*private) + uri_length +
+                   URI_PARTS_MEM_SIZE + 2 * uri_length + sizeof(void *) );
    if(!p_ctx) { status = VC_CONTAINER_ERROR_OUT_OF_MEMORY; goto error; }
    memset(p_ctx, 0, sizeof(*p_ctx) + sizeof(*private) + uri_length );
    p_ctx->priv = private = (VC_CONTAINER_IO_PRIVATE_T *)&p_ctx[1];
    p_ctx->uri = (char *)&private[1];
    memcpy((char *)p_ctx->uri, uri, uri_length);
-   p_ctx->uri_parts = vc_uri_create();
+   p_ctx->uri_parts = vc_uri_create_in( (void *)(((uintptr_t)p_ctx->uri + uri_length +
+      sizeof(void *) - 1) & ~(uintptr_t)(sizeof(void *) - 1)),
+      URI_PARTS_MEM_SIZE + 2 * uri_length );
    if(!p_ctx->uri_parts) { status = VC_CONTAINER_ERROR_OUT_OF_MEMORY; goto error; }
    vc_uri_parse(p_ctx->uri_parts, uri);
 
@@ -146,6 +183,9 @@ static VC_CONTAINER_IO_T *vc_container_io_open_core( const char *uri, VC_CONTAIN
       if(status) status = vc_container_io_pktfile_open(p_ctx, uri, mode);
 #ifdef ENABLE_CONTAINER_IO_HTTP
       if(status) status = vc_container_io_http_open(p_ctx, uri, mode);
+#endif
+#ifdef ENABLE_CONTAINER_IO_MMAP
+      if(status) status = vc_container_io_mmap_open(p_ctx, uri, mode);
 #endif
       if(status) status = vc_container_io_file_open(p_ctx, uri, mode);
       if(status != VC_CONTAINER_SUCCESS) goto error;
@@ -166,7 +206,7 @@ static VC_CONTAINER_IO_T *vc_container_io_open_core( const char *uri, VC_CONTAIN
       caches = 1;
 
    if(mode == VC_CONTAINER_IO_MODE_WRITE) cache_max_size = MEM_CACHE_WRITE_MAX_SIZE;
-   else cache_max_size = MEM_CACHE_READ_MAX_SIZE;
+   else cache_max_size = MEM_CACHE_READ_ADAPT_MAX_SIZE;
 
    if(mode == VC_CONTAINER_IO_MODE_WRITE &&
       vc_uri_path_extension(p_ctx->uri_parts) &&
@@ -186,9 +226,17 @@ static VC_CONTAINER_IO_T *vc_container_io_open_core( const char *uri, VC_CONTAIN
       cache->io = p_ctx;
       cache->mem = malloc(p_ctx->priv->caches.mem_size);
       if(cache->mem)
-      {      
+      {
          cache->buffer = cache->mem;
          cache->buffer_end = cache->mem + cache->mem_size;
+         cache->read_size = cache->mem_size;
+         if(mode == VC_CONTAINER_IO_MODE_READ)
+         {
+            /* Start from the historical fixed size and let the access
+             * pattern grow or shrink the refill size from there */
+            cache->read_size = MEM_CACHE_READ_MAX_SIZE;
+            cache->adaptive = true;
+         }
          p_ctx->priv->caches_num = 1;
       }
    }
@@ -201,6 +249,12 @@ static VC_CONTAINER_IO_T *vc_container_io_open_core( const char *uri, VC_CONTAIN
    if(mode == VC_CONTAINER_IO_MODE_WRITE && p_ctx->priv->cache && num_areas >= 2)
       p_ctx->priv->async_io = async_io_start( p_ctx, num_areas, 0 );
 
+   /* Try to start a readahead thread if we're in read mode so the cache is
+    * refilled in the background while the parser consumes the current block */
+   if(mode == VC_CONTAINER_IO_MODE_READ && p_ctx->priv->cache &&
+      !(p_ctx->capabilities & VC_CONTAINER_IO_CAPS_CANT_SEEK))
+      p_ctx->priv->readahead = io_readahead_start( p_ctx );
+
  end:
    if(p_status) *p_status = status;
    return p_ctx;
@@ -242,6 +296,9 @@ VC_CONTAINER_STATUS_T vc_container_io_close( VC_CONTAINER_IO_T *p_ctx )
                vc_container_io_cache_flush( p_ctx, &p_ctx->priv->caches, 1 );
          }
          
+         if(p_ctx->priv->readahead)
+            io_readahead_stop( p_ctx->priv->readahead );
+
          if(p_ctx->priv->async_io)
             async_io_stop( p_ctx->priv->async_io );
          else if(p_ctx->priv->caches_num)
@@ -259,6 +316,25 @@ VC_CONTAINER_STATUS_T vc_container_io_close( VC_CONTAINER_IO_T *p_ctx )
    return VC_CONTAINER_SUCCESS;
 }
 
+/*****************************************************************************/
+/** Read from the underlying io, accounting for the call and the time spent
+ * waiting for it when the read-side statistics are enabled */
+static size_t io_read_timed(VC_CONTAINER_IO_T *io, void *buffer, size_t size)
+{
+   VC_CONTAINER_IO_PRIVATE_T *private = io->priv;
+   unsigned int start;
+   size_t ret;
+
+   if(!private->stats_enable)
+      return io->pf_read(io, buffer, size);
+
+   start = vcos_getmicrosecs();
+   ret = io->pf_read(io, buffer, size);
+   private->stats.actual_reads++;
+   private->stats.read_time += vcos_getmicrosecs() - start;
+   return ret;
+}
+
 /*****************************************************************************/
 size_t vc_container_io_peek(VC_CONTAINER_IO_T *p_ctx, void *buffer, size_t size)
 {
@@ -276,7 +352,7 @@ size_t vc_container_io_peek(VC_CONTAINER_IO_T *p_ctx, void *buffer, size_t size)
    if (p_ctx->capabilities & VC_CONTAINER_IO_CAPS_CANT_SEEK)
       return 0;
 
-   ret = p_ctx->pf_read(p_ctx, buffer, size);
+   ret = io_read_timed(p_ctx, buffer, size);
    p_ctx->pf_seek(p_ctx, p_ctx->offset);
    return ret;
 }
@@ -284,20 +360,76 @@ size_t vc_container_io_peek(VC_CONTAINER_IO_T *p_ctx, void *buffer, size_t size)
 /*****************************************************************************/
 size_t vc_container_io_read(VC_CONTAINER_IO_T *p_ctx, void *buffer, size_t size)
 {
+   uint32_t actual_reads = p_ctx->priv->stats.actual_reads;
    size_t ret;
 
    if(p_ctx->priv->cache)
       ret = vc_container_io_cache_read( p_ctx, p_ctx->priv->cache, (uint8_t*)buffer, size );
    else
    {
-      ret = p_ctx->pf_read(p_ctx, buffer, size);
+      ret = io_read_timed(p_ctx, buffer, size);
       p_ctx->priv->actual_offset += ret;
    }
 
+   if(p_ctx->priv->stats_enable)
+   {
+      p_ctx->priv->stats.reads++;
+      p_ctx->priv->stats.bytes += ret;
+      if(p_ctx->priv->cache && p_ctx->priv->stats.actual_reads == actual_reads)
+         p_ctx->priv->stats.cache_hits++;
+   }
+
    p_ctx->offset += ret;
+
+   if(!telemetry_bytes_read)
+      telemetry_bytes_read = vcos_telemetry_counter("containers.bytes_read");
+   vcos_telemetry_add(telemetry_bytes_read, ret);
+
    return ret;
 }
 
+/*****************************************************************************/
+const uint8_t *vc_container_io_borrow(VC_CONTAINER_IO_T *p_ctx, size_t *size)
+{
+   VC_CONTAINER_IO_PRIVATE_CACHE_T *cache = p_ctx->priv->cache;
+   const uint8_t *data;
+   size_t bytes;
+
+   if(!cache || cache->dirty || !*size)
+      return NULL;
+
+   bytes = cache->size - cache->position; /* Bytes left in cache */
+
+   /* Refill the cache if it is empty */
+   if(!bytes) bytes = vc_container_io_cache_refill( p_ctx, cache );
+   if(!bytes) return NULL;
+
+   /* We do have some data in the cache so override the status */
+   p_ctx->status = VC_CONTAINER_SUCCESS;
+
+   if(*size > bytes) *size = bytes;
+
+   data = cache->buffer + cache->position;
+   cache->position += *size;
+   cache->refcount++;
+   p_ctx->offset += *size;
+   return data;
+}
+
+/*****************************************************************************/
+void vc_container_io_release(VC_CONTAINER_IO_T *p_ctx, const uint8_t *data, size_t size)
+{
+   VC_CONTAINER_IO_PRIVATE_CACHE_T *cache = p_ctx->priv->cache;
+
+   if(!cache) return;
+   vc_container_assert(cache->refcount);
+   vc_container_assert(data >= cache->buffer &&
+                       data + size <= cache->buffer + cache->size);
+   VC_CONTAINER_PARAM_UNUSED(data);
+   VC_CONTAINER_PARAM_UNUSED(size);
+   if(cache->refcount) cache->refcount--;
+}
+
 /*****************************************************************************/
 size_t vc_container_io_write(VC_CONTAINER_IO_T *p_ctx, const void *buffer, size_t size)
 {
@@ -312,9 +444,49 @@ size_t vc_container_io_write(VC_CONTAINER_IO_T *p_ctx, const void *buffer, size_
    }
 
    p_ctx->offset += ret;
+
+   if(ret > 0)
+   {
+      if(!telemetry_bytes_written)
+         telemetry_bytes_written = vcos_telemetry_counter("containers.bytes_written");
+      vcos_telemetry_add(telemetry_bytes_written, ret);
+   }
+
    return ret < 0 ? 0 : ret;
 }
 
+/*****************************************************************************/
+size_t vc_container_io_writev(VC_CONTAINER_IO_T *p_ctx,
+   const VC_CONTAINER_IO_VEC_T *vec, unsigned int num)
+{
+   size_t ret, total = 0;
+   unsigned int i;
+
+   if(!p_ctx->priv->cache && p_ctx->pf_writev)
+   {
+      ret = p_ctx->pf_writev(p_ctx, vec, num);
+      p_ctx->priv->actual_offset += ret;
+      p_ctx->offset += ret;
+
+      if(!telemetry_bytes_written)
+         telemetry_bytes_written = vcos_telemetry_counter("containers.bytes_written");
+      vcos_telemetry_add(telemetry_bytes_written, ret);
+
+      return ret;
+   }
+
+   /* Fall back onto writing the elements one by one. When the i/o is cached,
+    * the elements just end up coalesced in the cache so nothing is lost. */
+   for(i = 0; i < num; i++)
+   {
+      ret = vc_container_io_write(p_ctx, vec[i].buffer, vec[i].size);
+      total += ret;
+      if(ret != vec[i].size)
+         break;
+   }
+   return total;
+}
+
 /*****************************************************************************/
 size_t vc_container_io_skip(VC_CONTAINER_IO_T *p_ctx, size_t size)
 {
@@ -343,6 +515,9 @@ VC_CONTAINER_STATUS_T vc_container_io_seek(VC_CONTAINER_IO_T *p_ctx, int64_t off
    VC_CONTAINER_STATUS_T status;
    unsigned int i;
 
+   if(p_ctx->priv->stats_enable)
+      p_ctx->priv->stats.seeks++;
+
    /* Check if the requested position is in one of the cached areas */
    for(i = 0; i < p_ctx->priv->cached_areas_num; i++)
    {
@@ -426,6 +601,19 @@ VC_CONTAINER_STATUS_T vc_container_io_control_list(VC_CONTAINER_IO_T *context, V
       async_io_stats_get(context->priv->async_io, va_arg(args, VC_CONTAINER_WRITE_STATS_T *));
    }
 
+   if(operation == VC_CONTAINER_CONTROL_SET_IO_READ_STATS)
+   {
+      status = VC_CONTAINER_SUCCESS;
+      context->priv->stats_enable = va_arg(args, int);
+      memset(&context->priv->stats, 0, sizeof(context->priv->stats));
+   }
+
+   if(operation == VC_CONTAINER_CONTROL_GET_IO_READ_STATS)
+   {
+      status = VC_CONTAINER_SUCCESS;
+      *va_arg(args, VC_CONTAINER_READ_STATS_T *) = context->priv->stats;
+   }
+
    return status;
 }
 
@@ -452,6 +640,9 @@ size_t vc_container_io_cache(VC_CONTAINER_IO_T *p_ctx, size_t size)
    /* Sanity checking */
    if(private->cached_areas_num >= MAX_NUM_CACHED_AREAS) return 0;
 
+   if(private->readahead)
+      io_readahead_sync( private->readahead );
+
    cache = &private->cached_areas[private->cached_areas_num];
    cache->start = p_ctx->offset;
    cache->end = cache->start + size;
@@ -475,6 +666,8 @@ size_t vc_container_io_cache(VC_CONTAINER_IO_T *p_ctx, size_t size)
 
    cache->buffer = cache->mem;
    cache->buffer_end = cache->mem + cache->mem_size;
+   cache->read_size = cache->mem_size;
+   cache->adaptive = false;
 
    if(!cache->mem) return 0;
    private->cached_areas_num++;
@@ -492,8 +685,8 @@ size_t vc_container_io_cache(VC_CONTAINER_IO_T *p_ctx, size_t size)
    /* Read the rest of the cache directly from the stream */
    if(cache->mem_size > cache->size)
    {
-      size_t ret = cache->io->pf_read(cache->io, cache->buffer + cache->size,
-                                      cache->mem_size - cache->size);
+      size_t ret = io_read_timed(cache->io, cache->buffer + cache->size,
+                                 cache->mem_size - cache->size);
       cache->size += ret;
       cache->io->priv->actual_offset = cache->offset + cache->size;
    }
@@ -512,20 +705,46 @@ size_t vc_container_io_cache(VC_CONTAINER_IO_T *p_ctx, size_t size)
 static size_t vc_container_io_cache_refill( VC_CONTAINER_IO_T *p_ctx,
    VC_CONTAINER_IO_PRIVATE_CACHE_T *cache )
 {
-   size_t ret = vc_container_io_cache_flush( p_ctx, cache, 1 );
+   size_t ret, bytes;
+
+   /* Refilling will overwrite data which is still borrowed */
+   vc_container_assert(!cache->refcount);
+
+   ret = vc_container_io_cache_flush( p_ctx, cache, 1 );
 
    if(ret) return 0; /* TODO what should we do there ? */
 
+   /* Sustained linear consumption: grow the refill size so high bitrate
+    * streams pay for fewer, larger reads */
+   if(cache->adaptive && ++cache->run_length >= MEM_CACHE_ADAPT_THRESHOLD)
+   {
+      cache->run_length = cache->miss_seeks = 0;
+      if(cache->read_size < cache->mem_max_size) cache->read_size <<= 1;
+   }
+
+   if(p_ctx->priv->readahead)
+   {
+      /* See if the data has already been prefetched for us */
+      ret = io_readahead_refill( p_ctx->priv->readahead, cache );
+      if(ret) return ret;
+   }
+
    if(p_ctx->priv->actual_offset != cache->offset)
    {
       if(cache->io->pf_seek(cache->io, cache->offset) != VC_CONTAINER_SUCCESS)
          return 0;
    }
 
-   ret = cache->io->pf_read(cache->io, cache->buffer, cache->buffer_end - cache->buffer);
+   bytes = cache->buffer_end - cache->buffer;
+   if(bytes > cache->read_size) bytes = cache->read_size;
+   ret = io_read_timed(cache->io, cache->buffer, bytes);
    cache->size = ret;
    cache->position = 0;
    cache->io->priv->actual_offset = cache->offset + ret;
+
+   if(p_ctx->priv->readahead)
+      io_readahead_kick( p_ctx->priv->readahead, cache );
+
    return ret;
 }
 
@@ -533,17 +752,24 @@ static size_t vc_container_io_cache_refill( VC_CONTAINER_IO_T *p_ctx,
 static size_t vc_container_io_cache_refill_bypass( VC_CONTAINER_IO_T *p_ctx,
    VC_CONTAINER_IO_PRIVATE_CACHE_T *cache, uint8_t *buffer, size_t size )
 {
-   size_t ret = vc_container_io_cache_flush( p_ctx, cache, 1 );
+   size_t ret;
+
+   vc_container_assert(!cache->refcount);
+
+   ret = vc_container_io_cache_flush( p_ctx, cache, 1 );
 
    if(ret) return 0; /* TODO what should we do there ? */
 
+   if(p_ctx->priv->readahead)
+      io_readahead_sync( p_ctx->priv->readahead );
+
    if(p_ctx->priv->actual_offset != cache->offset)
    {
       if(cache->io->pf_seek(cache->io, cache->offset) != VC_CONTAINER_SUCCESS)
          return 0;
    }
 
-   ret = cache->io->pf_read(cache->io, buffer, size);
+   ret = io_read_timed(cache->io, buffer, size);
    cache->size = cache->position = 0;
    cache->offset += ret;
    cache->io->priv->actual_offset = cache->offset;
@@ -562,9 +788,9 @@ static size_t vc_container_io_cache_read( VC_CONTAINER_IO_T *p_ctx,
 
 #if 1 // FIXME Only if stream is seekable
       /* Try to read directly from the stream if the cache just gets in the way */
-      if(!bytes && size > cache->mem_size)
+      if(!bytes && size > cache->read_size)
       {
-         bytes = cache->mem_size;
+         bytes = cache->read_size;
          ret = vc_container_io_cache_refill_bypass( p_ctx, cache, data + read, bytes);
          read += ret;
 
@@ -671,6 +897,11 @@ static VC_CONTAINER_STATUS_T vc_container_io_cache_seek(VC_CONTAINER_IO_T *p_ctx
       return VC_CONTAINER_SUCCESS;
    }
 
+   /* We're going to hit the underlying i/o directly so any prefetch in
+    * flight needs to have completed first */
+   if(p_ctx->priv->readahead)
+      io_readahead_sync( p_ctx->priv->readahead );
+
    shift = cache->buffer - cache->mem;
    if(!cache->dirty && shift && cache->size &&
       offset >= cache->offset - (int64_t)shift && offset < cache->offset)
@@ -681,7 +912,7 @@ static VC_CONTAINER_STATUS_T vc_container_io_cache_seek(VC_CONTAINER_IO_T *p_ctx
       cache->offset -= shift;
       cache->buffer -= shift;
 
-      ret = cache->io->pf_read(cache->io, cache->buffer, shift);
+      ret = io_read_timed(cache->io, cache->buffer, shift);
       vc_container_assert(ret == shift); /* FIXME: ret must = shift */
       cache->size += shift;
       cache->position = offset - cache->offset;
@@ -689,6 +920,18 @@ static VC_CONTAINER_STATUS_T vc_container_io_cache_seek(VC_CONTAINER_IO_T *p_ctx
       return VC_CONTAINER_SUCCESS;
    }
 
+   /* Seek-heavy access: shrink the refill size so we stop reading ahead
+    * data which just gets discarded */
+   if(cache->adaptive)
+   {
+      cache->run_length = 0;
+      if(++cache->miss_seeks >= MEM_CACHE_ADAPT_THRESHOLD)
+      {
+         cache->miss_seeks = 0;
+         if(cache->read_size > MEM_CACHE_READ_MIN_SIZE) cache->read_size >>= 1;
+      }
+   }
+
    if(cache->dirty) vc_container_io_cache_flush( p_ctx, cache, 1 );
    // FIXME: what if all the data couldn't be flushed ?
 
@@ -866,7 +1109,7 @@ static void async_io_stats_get( struct VC_CONTAINER_IO_ASYNC_T *ctx, VC_CONTAINE
    *stats = ctx->stats;
 }
 
-static void *async_io_thread(VOID *argv)
+static void *async_io_thread(void *argv)
 {
    VC_CONTAINER_IO_ASYNC_T *ctx = argv;
    unsigned int write_area = 0;
@@ -1040,6 +1283,167 @@ static VC_CONTAINER_STATUS_T async_io_stop( VC_CONTAINER_IO_ASYNC_T *ctx )
    free(ctx);
    return VC_CONTAINER_SUCCESS;
 }
+
+/*****************************************************************************
+ * Readahead.
+ * Counterpart of the asynchronous write support for the read path. A
+ * background thread prefetches the next cache block while the parser is
+ * consuming the current one, so linear playback never stalls on a cold read.
+ *****************************************************************************/
+
+typedef struct VC_CONTAINER_IO_READAHEAD_T
+{
+   VC_CONTAINER_IO_T *io;
+   VCOS_THREAD_T thread;
+   VCOS_SEMAPHORE_T req_sema;   /**< Posted to request the next prefetch */
+   VCOS_SEMAPHORE_T done_sema;  /**< Posted when a prefetch completes */
+   int busy;                    /**< Whether a prefetch is in flight */
+   int quit;
+
+   int64_t offset;    /**< Stream offset of the prefetched block */
+   size_t shift;      /**< Alignment shift of the prefetched block */
+   size_t size;       /**< Number of valid bytes prefetched */
+   size_t read_size;  /**< Number of bytes to prefetch */
+   size_t mem_size;   /**< Size of the prefetch buffer */
+   uint8_t *mem;      /**< Prefetch buffer */
+
+   unsigned char stack[3000];
+
+} VC_CONTAINER_IO_READAHEAD_T;
+
+static void *io_readahead_thread(void *argv)
+{
+   VC_CONTAINER_IO_READAHEAD_T *ctx = argv;
+   size_t bytes;
+
+   while(1)
+   {
+      vcos_semaphore_wait(&ctx->req_sema);
+      if(ctx->quit) break;
+
+      /* The main thread is guaranteed not to touch the underlying i/o
+       * between the request and our completion */
+      ctx->size = 0;
+      if(ctx->io->priv->actual_offset == ctx->offset ||
+         ctx->io->pf_seek(ctx->io, ctx->offset) == VC_CONTAINER_SUCCESS)
+      {
+         bytes = ctx->mem_size - ctx->shift;
+         if(bytes > ctx->read_size) bytes = ctx->read_size;
+         ctx->size = ctx->io->pf_read(ctx->io, ctx->mem + ctx->shift, bytes);
+         ctx->io->priv->actual_offset = ctx->offset + ctx->size;
+      }
+      vcos_semaphore_post(&ctx->done_sema);
+   }
+
+   return NULL;
+}
+
+static void io_readahead_sync( VC_CONTAINER_IO_READAHEAD_T *ctx )
+{
+   if(ctx->busy)
+   {
+      vcos_semaphore_wait(&ctx->done_sema);
+      ctx->busy = 0;
+   }
+}
+
+static void io_readahead_kick( VC_CONTAINER_IO_READAHEAD_T *ctx,
+   VC_CONTAINER_IO_PRIVATE_CACHE_T *cache )
+{
+   int64_t offset = cache->offset + (int64_t)cache->size;
+
+   if(ctx->busy || !cache->size)
+      return;
+
+   /* Same alignment policy as vc_container_io_cache_flush so the prefetched
+    * block can be swapped straight in at the next refill */
+   ctx->offset = offset;
+   ctx->shift = cache->mem_size == cache->mem_max_size ?
+      (size_t)(offset & (MEM_CACHE_ALIGNMENT-1)) : 0;
+   ctx->read_size = cache->read_size;
+   ctx->busy = 1;
+   vcos_semaphore_post(&ctx->req_sema);
+}
+
+static size_t io_readahead_refill( VC_CONTAINER_IO_READAHEAD_T *ctx,
+   VC_CONTAINER_IO_PRIVATE_CACHE_T *cache )
+{
+   uint8_t *mem;
+
+   io_readahead_sync( ctx );
+
+   if(ctx->offset != cache->offset || !ctx->size ||
+      ctx->mem_size != cache->mem_size)
+      return 0;
+
+   /* Hand the prefetched block over to the cache and recycle the previous
+    * cache memory as the next prefetch buffer */
+   mem = cache->mem;
+   cache->mem = ctx->mem;
+   ctx->mem = mem;
+   cache->buffer = cache->mem + ctx->shift;
+   cache->buffer_end = cache->mem + cache->mem_size;
+   cache->size = ctx->size;
+   cache->position = 0;
+   ctx->size = 0;
+
+   io_readahead_kick( ctx, cache );
+   return cache->size;
+}
+
+static VC_CONTAINER_IO_READAHEAD_T *io_readahead_start( VC_CONTAINER_IO_T *io )
+{
+   VC_CONTAINER_IO_READAHEAD_T *ctx;
+   VCOS_UNSIGNED pri;
+
+   /* Allocate our context  */
+   ctx = malloc(sizeof(*ctx));
+   if(!ctx) return 0;
+   memset(ctx, 0, sizeof(*ctx));
+   ctx->io = io;
+   ctx->mem_size = io->priv->cache->mem_size;
+   ctx->read_size = ctx->mem_size;
+   ctx->mem = malloc(ctx->mem_size);
+   if(!ctx->mem) goto error_mem;
+
+   if(vcos_semaphore_create(&ctx->req_sema, "readahead_req_sem", 0) != VCOS_SUCCESS)
+      goto error_req_sema;
+
+   if(vcos_semaphore_create(&ctx->done_sema, "readahead_done_sem", 0) != VCOS_SUCCESS)
+      goto error_done_sema;
+
+   // run this thread at a slightly higher priority than the calling thread so
+   // cold data is ready before the parser gets to it.
+   pri = vcos_thread_get_priority(vcos_thread_current());
+   if(vcos_thread_create_classic(&ctx->thread, "io_readahead", io_readahead_thread, ctx,
+         ctx->stack, sizeof(ctx->stack), pri-1, 10, VCOS_START) != VCOS_SUCCESS)
+      goto error_thread;
+
+   return ctx;
+
+ error_thread:
+   vcos_semaphore_delete(&ctx->done_sema);
+ error_done_sema:
+   vcos_semaphore_delete(&ctx->req_sema);
+ error_req_sema:
+   free(ctx->mem);
+ error_mem:
+   free(ctx);
+   return 0;
+}
+
+static void io_readahead_stop( VC_CONTAINER_IO_READAHEAD_T *ctx )
+{
+   io_readahead_sync( ctx );
+   ctx->quit = 1;
+   vcos_semaphore_post(&ctx->req_sema);
+   vcos_thread_join(&ctx->thread, NULL);
+   vcos_semaphore_delete(&ctx->done_sema);
+   vcos_semaphore_delete(&ctx->req_sema);
+   free(ctx->mem);
+   free(ctx);
+}
+
 #else
 
 static struct VC_CONTAINER_IO_ASYNC_T *async_io_start( VC_CONTAINER_IO_T *io, int num_areas, VC_CONTAINER_STATUS_T *status )
@@ -1084,5 +1488,35 @@ static void async_io_stats_get( struct VC_CONTAINER_IO_ASYNC_T *ctx, VC_CONTAINE
    VC_CONTAINER_PARAM_UNUSED(stats);
 }
 
+static struct VC_CONTAINER_IO_READAHEAD_T *io_readahead_start( VC_CONTAINER_IO_T *io )
+{
+   VC_CONTAINER_PARAM_UNUSED(io);
+   return 0;
+}
+
+static void io_readahead_stop( struct VC_CONTAINER_IO_READAHEAD_T *ctx )
+{
+   VC_CONTAINER_PARAM_UNUSED(ctx);
+}
+
+static void io_readahead_sync( struct VC_CONTAINER_IO_READAHEAD_T *ctx )
+{
+   VC_CONTAINER_PARAM_UNUSED(ctx);
+}
+
+static void io_readahead_kick( struct VC_CONTAINER_IO_READAHEAD_T *ctx,
+   VC_CONTAINER_IO_PRIVATE_CACHE_T *cache )
+{
+   VC_CONTAINER_PARAM_UNUSED(ctx);
+   VC_CONTAINER_PARAM_UNUSED(cache);
+}
+
+static size_t io_readahead_refill( struct VC_CONTAINER_IO_READAHEAD_T *ctx,
+   VC_CONTAINER_IO_PRIVATE_CACHE_T *cache )
+{
+   VC_CONTAINER_PARAM_UNUSED(ctx);
+   VC_CONTAINER_PARAM_UNUSED(cache);
+   return 0;
+}
 
 #endif
@@ -60,6 +60,13 @@ typedef uint32_t VC_CONTAINER_IO_CAPABILITIES_T;
 #define VC_CONTAINER_IO_CAPS_NO_CACHING   0x4
 /* @} */
 
+/** Element of a scatter-gather list as passed to \ref vc_container_io_writev */
+typedef struct VC_CONTAINER_IO_VEC_T
+{
+   const void *buffer; /**< Pointer to the data for this element */
+   size_t size;        /**< Number of bytes in this element */
+} VC_CONTAINER_IO_VEC_T;
+
 /** Container Input / Output Context.
  * This structure defines the context for a container io instance */
 struct VC_CONTAINER_IO_T
@@ -112,6 +119,13 @@ struct VC_CONTAINER_IO_T
     * Function pointer to write data to a container io module */
    size_t (*pf_write)(struct VC_CONTAINER_IO_T *io, const void *buffer, size_t size);
 
+   /** \private
+    * Optional function pointer to write a scatter-gather list of buffers to a
+    * container io module in a single operation. Left unset by modules which
+    * cannot do better than successive calls to \ref pf_write */
+   size_t (*pf_writev)(struct VC_CONTAINER_IO_T *io,
+                       const VC_CONTAINER_IO_VEC_T *vec, unsigned int num);
+
    /** \private
     * Function pointer to seek into a container io module */
    VC_CONTAINER_STATUS_T (*pf_seek)(struct VC_CONTAINER_IO_T *io, int64_t offset);
@@ -187,6 +201,17 @@ size_t vc_container_io_skip(VC_CONTAINER_IO_T *context, size_t size);
  */
 size_t vc_container_io_write(VC_CONTAINER_IO_T *context, const void *buffer, size_t size);
 
+/** Write a scatter-gather list of buffers to an i/o stream.
+ * The buffers are written back to back, in one operation if the underlying
+ * i/o module supports it.
+ * \param  context     Pointer to the VC_CONTAINER_IO_T instance to use
+ * \param  vec         Pointer to the scatter-gather list describing the data to write
+ * \param  num         Number of elements in the scatter-gather list
+ * \return             The size of the data actually written.
+ */
+size_t vc_container_io_writev(VC_CONTAINER_IO_T *context,
+   const VC_CONTAINER_IO_VEC_T *vec, unsigned int num);
+
 /** Seek into an i/o stream.
  * \param  context     Pointer to the VC_CONTAINER_IO_T instance to use
  * \param  offset      Absolute file offset to seek to
@@ -220,6 +245,25 @@ VC_CONTAINER_STATUS_T vc_container_io_control(VC_CONTAINER_IO_T *context,
  */
 size_t vc_container_io_cache(VC_CONTAINER_IO_T *context, size_t size);
 
+/** Borrow a pointer to the data available at the current position in the i/o cache.
+ * The data is consumed (i.e. the position advances) without being copied. The returned
+ * pointer stays valid until it is released using \ref vc_container_io_release, which
+ * must be done before any other operation on the i/o.
+ * \param  context     Pointer to the VC_CONTAINER_IO_T instance to use
+ * \param  size        In: maximum number of bytes wanted.
+ *                     Out: number of bytes actually borrowed
+ * \return             Pointer to the data or NULL if the data cannot be borrowed
+ *                     (e.g. the i/o isn't cached)
+ */
+const uint8_t *vc_container_io_borrow(VC_CONTAINER_IO_T *context, size_t *size);
+
+/** Release a pointer previously borrowed using \ref vc_container_io_borrow.
+ * \param  context     Pointer to the VC_CONTAINER_IO_T instance to use
+ * \param  data        Pointer which was borrowed
+ * \param  size        Number of bytes which were borrowed
+ */
+void vc_container_io_release(VC_CONTAINER_IO_T *context, const uint8_t *data, size_t size);
+
 /* @} */
 
 #ifdef __cplusplus
@@ -33,6 +33,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "containers/core/containers_loader.h"
 
 #if !defined(ENABLE_CONTAINERS_STANDALONE)
+   #include "vcos.h"
    #include "vcos_dlfcn.h"
    #define DL_SUFFIX VCOS_SO_EXT
    #ifndef DL_PATH_PREFIX
@@ -58,6 +59,9 @@ static VC_CONTAINER_READER_OPEN_FUNC_T load_reader(void **handle, const char *na
 static VC_CONTAINER_READER_OPEN_FUNC_T load_writer(void **handle, const char *name);
 static VC_CONTAINER_READER_OPEN_FUNC_T load_metadata_reader(void **handle, const char *name);
 static const char* container_for_fileext(const char *fileext);
+struct CONTAINER_SIGNATURE_S;
+static int signature_matches(const struct CONTAINER_SIGNATURE_S *signature,
+   const uint8_t *header, size_t size);
 
 /********************************************************************************
  List of supported containers
@@ -145,6 +149,38 @@ static struct
 };
 #endif /* defined(ENABLE_CONTAINERS_STANDALONE) */
 
+/** Table of container signatures (magic bytes), checked in a single pass
+    against one prefetched copy of the stream head. This is only used as
+    optimisation to decide which containers to try first when the file
+    extension gives no usable hint; anything the table misses still falls
+    through to the exhaustive probe. Formats without a fixed signature
+    (e.g. mpga, rawvideo) are deliberately absent. */
+typedef struct CONTAINER_SIGNATURE_S {
+   const char *container;
+   uint8_t offset;          /**< Offset of the first byte sequence */
+   uint8_t length;
+   const char *bytes;
+   uint8_t offset2;         /**< Optional second sequence, length2 0 if unused */
+   uint8_t length2;
+   const char *bytes2;
+} CONTAINER_SIGNATURE_T;
+
+#define PROBE_HEADER_SIZE 16
+
+static const CONTAINER_SIGNATURE_T container_signatures[] =
+{
+   { "mp4",    4, 4, "ftyp",             0, 0, 0 },
+   { "asf",    0, 4, "\x30\x26\xB2\x75", 0, 0, 0 },
+   { "avi",    0, 4, "RIFF",             8, 4, "AVI " },
+   { "wav",    0, 4, "RIFF",             8, 4, "WAVE" },
+   { "mkv",    0, 4, "\x1A\x45\xDF\xA3", 0, 0, 0 },
+   { "flv",    0, 3, "FLV",              0, 0, 0 },
+   { "ps",     0, 4, "\x00\x00\x01\xBA", 0, 0, 0 },
+   { "qsynth", 0, 4, "MThd",             0, 0, 0 },
+   { "qsynth", 0, 4, "MMMD",             0, 0, 0 },
+   { 0, 0, 0, 0, 0, 0, 0 }
+};
+
 /** Table describing the mapping between file extensions and container name.
     This is only used as optimisation to decide which container to try first.
     Entries where the file extension and container have the same name can be omitted. */
@@ -175,9 +211,12 @@ VC_CONTAINER_STATUS_T vc_container_load_reader(VC_CONTAINER_T *p_ctx, const char
    void *handle = NULL;
    VC_CONTAINER_READER_OPEN_FUNC_T func;
    VC_CONTAINER_STATUS_T status;
-   unsigned int i;
+   uint8_t header[PROBE_HEADER_SIZE];
+   size_t header_size;
+   const char *tried[8];
+   unsigned int i, j, tried_num = 0;
    int64_t offset;
-   
+
    vc_container_assert(p_ctx && !p_ctx->priv->module_handle);
 
    /* FIXME: the missing part here is code that reads a configuration or
@@ -207,15 +246,57 @@ VC_CONTAINER_STATUS_T vc_container_load_reader(VC_CONTAINER_T *p_ctx, const char
       mapping first */
    if (fileext && (name = container_for_fileext(fileext)) != NULL && (func = load_reader(&handle, name)) != NULL)
    {
+      tried[tried_num++] = name;
       status = (*func)(p_ctx);
       if(status == VC_CONTAINER_SUCCESS) goto success;
+      reset_context(p_ctx);
       unload_library(handle);
       if (status != VC_CONTAINER_ERROR_FORMAT_NOT_SUPPORTED) goto error;
    }
 
-   /* If there was no suitable mapping, iterate through all readers. */
+   /* Prefetch the stream head once and run every signature check against it
+      in a single pass, so unknown extensions don't have to load and probe
+      each plugin in turn just to be turned away. */
+   header_size = 0;
+   if(vc_container_io_seek(p_ctx->priv->io, offset) == VC_CONTAINER_SUCCESS)
+      header_size = vc_container_io_peek(p_ctx->priv->io, header, sizeof(header));
+
+   for(i = 0; header_size && container_signatures[i].container; i++)
+   {
+      const CONTAINER_SIGNATURE_T *signature = &container_signatures[i];
+
+      if(!signature_matches(signature, header, header_size))
+         continue;
+      for(j = 0; j < tried_num; j++)
+         if(!strcasecmp(tried[j], signature->container)) break;
+      if(j < tried_num || (func = load_reader(&handle, signature->container)) == NULL)
+         continue;
+
+      if(tried_num < sizeof(tried)/sizeof(tried[0]))
+         tried[tried_num++] = signature->container;
+
+      if(vc_container_io_seek(p_ctx->priv->io, offset) != VC_CONTAINER_SUCCESS)
+      {
+         unload_library(handle);
+         goto error;
+      }
+
+      status = (*func)(p_ctx);
+      if(status == VC_CONTAINER_SUCCESS) goto success;
+      reset_context(p_ctx);
+      unload_library(handle);
+      if (status != VC_CONTAINER_ERROR_FORMAT_NOT_SUPPORTED) goto error;
+   }
+
+   /* If neither the extension nor a signature identified the stream, iterate
+      through all the remaining readers. */
    for(i = 0; readers[i]; i++)
    {
+      for(j = 0; j < tried_num; j++)
+         if(!strcasecmp(tried[j], readers[i])) break;
+      if(j < tried_num)
+         continue;
+
       if ((func = load_reader(&handle, readers[i])) != NULL)
       {
          if(vc_container_io_seek(p_ctx->priv->io, offset) != VC_CONTAINER_SUCCESS)
@@ -290,6 +371,40 @@ void vc_container_unload(VC_CONTAINER_T *p_ctx)
    }
 }
 
+/*****************************************************************************/
+void vc_container_load_prewarm(const char *containers)
+{
+#if !defined(ENABLE_CONTAINERS_STANDALONE)
+   char name[16];
+
+   while (containers && *containers)
+   {
+      const char *sep = strchr(containers, ',');
+      size_t len = sep ? (size_t)(sep - containers) : strlen(containers);
+
+      if (len && len < sizeof(name))
+      {
+         void *handle = NULL;
+         VC_CONTAINER_READER_OPEN_FUNC_T func;
+
+         memcpy(name, containers, len);
+         name[len] = 0;
+
+         /* Loading populates the plugin cache; the entry point is not needed
+            here. Plugins which don't fit in the cache are unloaded again. */
+         func = load_reader(&handle, name);
+         if (!func) func = load_writer(&handle, name);
+         if (func) unload_library(handle);
+      }
+
+      containers = sep ? sep + 1 : containers + len;
+   }
+#else /* defined(ENABLE_CONTAINERS_STANDALONE) */
+   /* Entry points are statically linked, there is nothing to preload */
+   VC_CONTAINER_PARAM_UNUSED(containers);
+#endif
+}
+
 /******************************************************************************
 Local Functions
 ******************************************************************************/
@@ -331,6 +446,112 @@ static VC_CONTAINER_READER_OPEN_FUNC_T load_metadata_reader(void **handle, const
 
 #if !defined(ENABLE_CONTAINERS_STANDALONE)
 
+/******************************************************************************
+Plugin cache
+******************************************************************************/
+
+/* Once a plugin has been successfully loaded, its handle and resolved entry
+   point are kept in this registry and reused by subsequent opens, so the disk
+   and relocation cost of dlopen is only paid once per plugin. Cached plugins
+   stay pinned in memory until process exit. */
+#define PLUGIN_CACHE_ENTRIES 24
+
+static struct {
+   char name[16];
+   char prefix[12];
+   int read;
+   void *handle;
+   VC_CONTAINER_READER_OPEN_FUNC_T func;
+} plugin_cache[PLUGIN_CACHE_ENTRIES];
+static unsigned int plugin_cache_used;
+
+/* Opens can run on several threads, so all accesses to the registry go
+   through this lock. dlopen itself is not serialised by it: two threads
+   racing to load the same plugin just create a duplicate entry, which only
+   wastes a slot since dlopen reference-counts the library. If the mutex
+   can't be created, caching is disabled and every open pays the dlopen. */
+static VCOS_ONCE_T plugin_cache_once = VCOS_ONCE_INIT;
+static VCOS_MUTEX_T plugin_cache_mutex;
+static int plugin_cache_enabled;
+
+static void plugin_cache_init(void)
+{
+   plugin_cache_enabled =
+      vcos_mutex_create(&plugin_cache_mutex, "plugin_cache") == VCOS_SUCCESS;
+}
+
+/*****************************************************************************/
+static VC_CONTAINER_READER_OPEN_FUNC_T plugin_cache_lookup(void **handle, const char *name, const char *ext, int read)
+{
+   VC_CONTAINER_READER_OPEN_FUNC_T func = NULL;
+   unsigned int i;
+
+   vcos_once(&plugin_cache_once, plugin_cache_init);
+   if (!plugin_cache_enabled)
+      return NULL;
+
+   vcos_mutex_lock(&plugin_cache_mutex);
+   for (i = 0; i < plugin_cache_used; i++)
+   {
+      if (plugin_cache[i].read == read &&
+          !strcasecmp(plugin_cache[i].name, name) &&
+          !strcmp(plugin_cache[i].prefix, ext ? ext : ""))
+      {
+         *handle = plugin_cache[i].handle;
+         func = plugin_cache[i].func;
+         break;
+      }
+   }
+   vcos_mutex_unlock(&plugin_cache_mutex);
+
+   return func;
+}
+
+/*****************************************************************************/
+static void plugin_cache_store(void *handle, VC_CONTAINER_READER_OPEN_FUNC_T func,
+   const char *name, const char *ext, int read)
+{
+   /* If the entry doesn't fit, the plugin just stays uncached and is loaded
+      the old way on each open */
+   if (!plugin_cache_enabled ||
+       strlen(name) >= sizeof(plugin_cache[0].name) ||
+       (ext && strlen(ext) >= sizeof(plugin_cache[0].prefix)))
+      return;
+
+   vcos_mutex_lock(&plugin_cache_mutex);
+   if (plugin_cache_used < PLUGIN_CACHE_ENTRIES)
+   {
+      strcpy(plugin_cache[plugin_cache_used].name, name);
+      strcpy(plugin_cache[plugin_cache_used].prefix, ext ? ext : "");
+      plugin_cache[plugin_cache_used].read = read;
+      plugin_cache[plugin_cache_used].handle = handle;
+      plugin_cache[plugin_cache_used].func = func;
+      plugin_cache_used++;
+   }
+   vcos_mutex_unlock(&plugin_cache_mutex);
+}
+
+/*****************************************************************************/
+static int plugin_cache_holds(void *handle)
+{
+   unsigned int i;
+   int held = 0;
+
+   if (!plugin_cache_enabled)
+      return 0;
+
+   vcos_mutex_lock(&plugin_cache_mutex);
+   for (i = 0; i < plugin_cache_used; i++)
+      if (plugin_cache[i].handle == handle)
+      {
+         held = 1;
+         break;
+      }
+   vcos_mutex_unlock(&plugin_cache_mutex);
+
+   return held;
+}
+
 /*****************************************************************************/
 static VC_CONTAINER_READER_OPEN_FUNC_T load_library(void **handle, const char *name, const char *ext, int read)
 {
@@ -344,7 +565,11 @@ static VC_CONTAINER_READER_OPEN_FUNC_T load_library(void **handle, const char *n
    unsigned dl_size, ep_size, name_len = strlen(name) + (ext ? strlen(ext) : 0);
    
    vc_container_assert(read == 0 || read == 1);
-   
+
+   /* Reuse the resolved entry point if this plugin has been loaded before */
+   if ((func = plugin_cache_lookup(handle, name, ext, read)) != NULL)
+      return func;
+
    dl_size = strlen(DL_PATH_PREFIX) + MAX(strlen(DL_PREFIX_RD), strlen(DL_PREFIX_WR)) + name_len + strlen(DL_SUFFIX) + 1;
    if ((dl_name = malloc(dl_size)) == NULL)
       return NULL;
@@ -359,7 +584,9 @@ static VC_CONTAINER_READER_OPEN_FUNC_T load_library(void **handle, const char *n
    snprintf(dl_name, dl_size, "%s%s%s%s%s", DL_PATH_PREFIX, read ? DL_PREFIX_RD : DL_PREFIX_WR, ext ? ext : "", name, DL_SUFFIX);
    snprintf(entrypt_name, ep_size, "%s_%s%s", name, ext ? ext : "", read ? entrypt_read : entrypt_write);
       
-   if ( (dl_handle = vcos_dlopen(dl_name, VCOS_DL_NOW)) != NULL )
+   /* Resolve symbols lazily - the entry point is looked up explicitly below,
+      and deferring the rest shortens the first open */
+   if ( (dl_handle = vcos_dlopen(dl_name, VCOS_DL_LAZY)) != NULL )
    {
       /* Try generic entrypoint name before the mangled, full name */
       func = (VC_CONTAINER_READER_OPEN_FUNC_T)vcos_dlsym(dl_handle, read ? entrypt_read : entrypt_write);
@@ -368,7 +595,10 @@ static VC_CONTAINER_READER_OPEN_FUNC_T load_library(void **handle, const char *n
 #endif
       /* Only return handle if symbol found */
       if (func)
+      {
          *handle = dl_handle;
+         plugin_cache_store(dl_handle, func, name, ext, read);
+      }
       else
          vcos_dlclose(dl_handle);
    }
@@ -381,7 +611,9 @@ static VC_CONTAINER_READER_OPEN_FUNC_T load_library(void **handle, const char *n
 /*****************************************************************************/
 static void unload_library(void *handle)
 {
-   vcos_dlclose(handle);
+   /* Cached plugins are pinned - they are only unmapped at process exit */
+   if (!plugin_cache_holds(handle))
+      vcos_dlclose(handle);
 }
 
 #else /* !defined(ENABLE_CONTAINERS_STANDALONE) */
@@ -421,6 +653,22 @@ static void unload_library(void *handle)
 
 #endif /* !defined(ENABLE_CONTAINERS_STANDALONE) */
 
+/*****************************************************************************/
+static int signature_matches(const struct CONTAINER_SIGNATURE_S *signature,
+   const uint8_t *header, size_t size)
+{
+   if((size_t)signature->offset + signature->length > size ||
+      memcmp(header + signature->offset, signature->bytes, signature->length))
+      return 0;
+
+   if(signature->length2 &&
+      ((size_t)signature->offset2 + signature->length2 > size ||
+       memcmp(header + signature->offset2, signature->bytes2, signature->length2)))
+      return 0;
+
+   return 1;
+}
+
 /*****************************************************************************/
 static const char* container_for_fileext(const char *fileext)
 {
@@ -38,4 +38,9 @@ VC_CONTAINER_STATUS_T vc_container_load_writer(VC_CONTAINER_T *p_ctx, const char
 
 void vc_container_unload(VC_CONTAINER_T *p_ctx);
 
+/** Load and pin the given comma-separated list of container plugins (e.g.
+    "mkv,mp4") so that the disk and relocation cost of loading them is not paid
+    on the first open. Pinned plugins stay in memory until process exit. */
+void vc_container_load_prewarm(const char *containers);
+
 #endif /* VC_CONTAINERS_LOADER_H */
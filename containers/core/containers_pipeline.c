@@ -0,0 +1,528 @@
+/*
+Copyright (c) 2012, Broadcom Europe Ltd
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "containers/core/containers_private.h"
+#include "containers/core/containers_pipeline.h"
+#include "containers/core/containers_logging.h"
+
+#include "vcos.h"
+
+/* The pipeline moves packets around as fixed size buffers taken from a finite
+ * pool.  The pool is what bounds the pipeline: when all packets are in-flight,
+ * the demux thread blocks until the caller consumes some output.
+ * Packets flow: pool -> demux -> track worker -> output -> back to the pool.
+ * Tracks without a packetizer bypass the workers and go straight to the
+ * output queue. */
+
+#define PIPELINE_PACKET_SIZE (32*1024)
+#define PIPELINE_NUM_PACKETS 16
+#define PIPELINE_MAX_TRACKS 16
+#define PIPELINE_STACK_SIZE 4096
+
+typedef struct PIPELINE_PACKET_T
+{
+   struct PIPELINE_PACKET_T *next;
+   VC_CONTAINER_PACKET_T packet;
+   VC_CONTAINER_STATUS_T status;    /**< Carried status, used by the end-of-stream marker */
+   uint8_t data[PIPELINE_PACKET_SIZE];
+
+} PIPELINE_PACKET_T;
+
+/** Simple queue of packets.  A pop can return NULL, which is used as a wakeup
+ * to get the popping thread to re-check the pipeline state. */
+typedef struct PIPELINE_QUEUE_T
+{
+   VCOS_MUTEX_T lock;
+   VCOS_SEMAPHORE_T items;
+   PIPELINE_PACKET_T *first;
+   PIPELINE_PACKET_T *last;
+
+} PIPELINE_QUEUE_T;
+
+typedef struct PIPELINE_TRACK_T
+{
+   struct VC_CONTAINER_PIPELINE_T *pipeline;
+   unsigned int track;              /**< Index of the track this worker packetizes */
+   PIPELINE_QUEUE_T input;          /**< Raw packets queued by the demux thread */
+   VCOS_THREAD_T thread;
+   uint8_t stack[PIPELINE_STACK_SIZE];
+
+} PIPELINE_TRACK_T;
+
+typedef struct VC_CONTAINER_PIPELINE_T
+{
+   VC_CONTAINER_T *p_ctx;
+
+   PIPELINE_QUEUE_T pool;           /**< Spare packets, bounds the whole pipeline */
+   PIPELINE_QUEUE_T output;         /**< Packets ready to be consumed by the caller */
+   PIPELINE_PACKET_T *pending;      /**< Output packet peeked at / partially consumed */
+
+   PIPELINE_TRACK_T *tracks[PIPELINE_MAX_TRACKS];
+   unsigned int tracks_num;
+
+   VCOS_MUTEX_T lock;
+   unsigned int workers_active;     /**< Workers still to flush before end-of-stream */
+   PIPELINE_PACKET_T *eos;          /**< End-of-stream marker waiting to be sent */
+
+   volatile int quit;
+   volatile int demux_done;
+
+   VCOS_THREAD_T demux_thread;
+   uint8_t demux_stack[PIPELINE_STACK_SIZE];
+
+   PIPELINE_PACKET_T packets[PIPELINE_NUM_PACKETS];
+
+} VC_CONTAINER_PIPELINE_T;
+
+/*****************************************************************************/
+static VC_CONTAINER_STATUS_T pipeline_queue_init( PIPELINE_QUEUE_T *queue, const char *name )
+{
+   queue->first = queue->last = NULL;
+   if(vcos_mutex_create(&queue->lock, name) != VCOS_SUCCESS)
+      return VC_CONTAINER_ERROR_OUT_OF_RESOURCES;
+   if(vcos_semaphore_create(&queue->items, name, 0) != VCOS_SUCCESS)
+   {
+      vcos_mutex_delete(&queue->lock);
+      return VC_CONTAINER_ERROR_OUT_OF_RESOURCES;
+   }
+   return VC_CONTAINER_SUCCESS;
+}
+
+static void pipeline_queue_deinit( PIPELINE_QUEUE_T *queue )
+{
+   vcos_semaphore_delete(&queue->items);
+   vcos_mutex_delete(&queue->lock);
+}
+
+static void pipeline_queue_push( PIPELINE_QUEUE_T *queue, PIPELINE_PACKET_T *packet )
+{
+   packet->next = NULL;
+   vcos_mutex_lock(&queue->lock);
+   if(queue->last) queue->last->next = packet;
+   else queue->first = packet;
+   queue->last = packet;
+   vcos_mutex_unlock(&queue->lock);
+   vcos_semaphore_post(&queue->items);
+}
+
+/** Wakes up one thread blocked on the queue without queueing a packet */
+static void pipeline_queue_wakeup( PIPELINE_QUEUE_T *queue )
+{
+   vcos_semaphore_post(&queue->items);
+}
+
+static PIPELINE_PACKET_T *pipeline_queue_pop( PIPELINE_QUEUE_T *queue )
+{
+   PIPELINE_PACKET_T *packet;
+
+   vcos_semaphore_wait(&queue->items);
+   vcos_mutex_lock(&queue->lock);
+   packet = queue->first;
+   if(packet)
+   {
+      queue->first = packet->next;
+      if(!queue->first) queue->last = NULL;
+   }
+   vcos_mutex_unlock(&queue->lock);
+   return packet;
+}
+
+/** Non-blocking variant of the pop, returns NULL when the queue is empty */
+static PIPELINE_PACKET_T *pipeline_queue_trypop( PIPELINE_QUEUE_T *queue )
+{
+   PIPELINE_PACKET_T *packet;
+
+   if(vcos_semaphore_trywait(&queue->items) != VCOS_SUCCESS)
+      return NULL;
+   vcos_mutex_lock(&queue->lock);
+   packet = queue->first;
+   if(packet)
+   {
+      queue->first = packet->next;
+      if(!queue->first) queue->last = NULL;
+   }
+   vcos_mutex_unlock(&queue->lock);
+   return packet;
+}
+
+/*****************************************************************************/
+static void pipeline_packet_reset( PIPELINE_PACKET_T *packet )
+{
+   memset(&packet->packet, 0, sizeof(packet->packet));
+   packet->packet.data = packet->data;
+   packet->packet.buffer_size = PIPELINE_PACKET_SIZE;
+   packet->status = VC_CONTAINER_SUCCESS;
+}
+
+/** Called by the demux thread and each worker when it is done producing data.
+ * The last one to finish forwards the end-of-stream marker, so the caller
+ * only sees it once all packetizers have been flushed. */
+static void pipeline_worker_done( VC_CONTAINER_PIPELINE_T *pipeline )
+{
+   PIPELINE_PACKET_T *eos = NULL;
+
+   vcos_mutex_lock(&pipeline->lock);
+   if(pipeline->workers_active) pipeline->workers_active--;
+   if(!pipeline->workers_active)
+   {
+      eos = pipeline->eos;
+      pipeline->eos = NULL;
+   }
+   vcos_mutex_unlock(&pipeline->lock);
+
+   if(eos)
+      pipeline_queue_push(&pipeline->output, eos);
+}
+
+/*****************************************************************************/
+static void *pipeline_worker_thread(void *argv)
+{
+   PIPELINE_TRACK_T *track = argv;
+   VC_CONTAINER_PIPELINE_T *pipeline = track->pipeline;
+   VC_PACKETIZER_T *packetizer = pipeline->p_ctx->tracks[track->track]->priv->packetizer;
+   VC_PACKETIZER_FLAGS_T flush = 0;
+
+   while(1)
+   {
+      PIPELINE_PACKET_T *in = pipeline_queue_pop(&track->input);
+      VC_CONTAINER_PACKET_T *released;
+
+      if(pipeline->quit)
+      {
+         if(in) pipeline_queue_push(&pipeline->pool, in);
+         return NULL; /* Stopping, the marker isn't wanted */
+      }
+
+      if(in)
+      {
+         /* Feed the raw data to the packetizer and return the packet to the
+          * pool straight away so the demux thread isn't starved */
+         vc_packetizer_push(packetizer, &in->packet);
+         vc_packetizer_pop(packetizer, &released, VC_PACKETIZER_FLAG_FORCE_RELEASE_INPUT);
+         pipeline_queue_push(&pipeline->pool, in);
+      }
+      else if(pipeline->demux_done)
+         flush = VC_PACKETIZER_FLAG_FLUSH; /* Last chance to drain everything */
+      else
+         continue; /* Spurious wakeup */
+
+      /* Drain whatever the packetizer has made available.  Waiting on an
+       * empty pool here would deadlock once every packet is parked on the
+       * worker input queues (the demux thread blocks behind us and nothing
+       * reaches the output queue), so outside of the final flush the pool is
+       * only polled: the packetizer keeps its data buffered until the next
+       * input packet or the flush brings us back here.  During the flush the
+       * demux thread has exited so waiting is safe, and needed to fully
+       * drain the packetizer. */
+      while(1)
+      {
+         PIPELINE_PACKET_T *out = flush ? pipeline_queue_pop(&pipeline->pool) :
+            pipeline_queue_trypop(&pipeline->pool);
+         if(pipeline->quit)
+         {
+            if(out) pipeline_queue_push(&pipeline->pool, out);
+            return NULL;
+         }
+         if(!out)
+         {
+            if(flush) continue; /* Spurious wakeup */
+            break;
+         }
+
+         pipeline_packet_reset(out);
+         if(vc_packetizer_read(packetizer, &out->packet, flush) != VC_CONTAINER_SUCCESS)
+         {
+            pipeline_queue_push(&pipeline->pool, out);
+            break;
+         }
+         out->packet.track = track->track;
+         pipeline_queue_push(&pipeline->output, out);
+      }
+
+      if(flush)
+         break;
+   }
+
+   pipeline_worker_done(pipeline);
+   return NULL;
+}
+
+/*****************************************************************************/
+static void *pipeline_demux_thread(void *argv)
+{
+   VC_CONTAINER_PIPELINE_T *pipeline = argv;
+   VC_CONTAINER_T *p_ctx = pipeline->p_ctx;
+   unsigned int i;
+
+   while(1)
+   {
+      VC_CONTAINER_STATUS_T status;
+      PIPELINE_PACKET_T *packet = pipeline_queue_pop(&pipeline->pool);
+      PIPELINE_TRACK_T *track = NULL;
+
+      if(pipeline->quit)
+      {
+         if(packet) pipeline_queue_push(&pipeline->pool, packet);
+         return NULL;
+      }
+      if(!packet) continue;
+
+      pipeline_packet_reset(packet);
+      status = vc_container_read_packet(p_ctx, &packet->packet, 0);
+      if(status != VC_CONTAINER_SUCCESS)
+      {
+         /* Keep the packet back as the end-of-stream marker.  It is sent on
+          * the output queue once every worker has flushed its packetizer. */
+         packet->status = status;
+         vcos_mutex_lock(&pipeline->lock);
+         pipeline->eos = packet;
+         vcos_mutex_unlock(&pipeline->lock);
+         break;
+      }
+
+      for(i = 0; i < pipeline->tracks_num; i++)
+         if(pipeline->tracks[i]->track == packet->packet.track)
+         { track = pipeline->tracks[i]; break; }
+
+      if(track)
+         pipeline_queue_push(&track->input, packet);
+      else
+         pipeline_queue_push(&pipeline->output, packet);
+   }
+
+   /* Tell the workers there is nothing more coming so they flush and exit */
+   pipeline->demux_done = 1;
+   for(i = 0; i < pipeline->tracks_num; i++)
+      pipeline_queue_wakeup(&pipeline->tracks[i]->input);
+
+   pipeline_worker_done(pipeline);
+   return NULL;
+}
+
+/*****************************************************************************/
+static void pipeline_destroy( VC_CONTAINER_PIPELINE_T *pipeline, int started )
+{
+   unsigned int i;
+
+   if(started)
+   {
+      pipeline->quit = 1;
+      pipeline_queue_wakeup(&pipeline->pool);
+      vcos_thread_join(&pipeline->demux_thread, NULL);
+      for(i = 0; i < pipeline->tracks_num; i++)
+      {
+         pipeline_queue_wakeup(&pipeline->tracks[i]->input);
+         pipeline_queue_wakeup(&pipeline->pool);
+         vcos_thread_join(&pipeline->tracks[i]->thread, NULL);
+      }
+   }
+
+   for(i = 0; i < pipeline->tracks_num; i++)
+   {
+      pipeline_queue_deinit(&pipeline->tracks[i]->input);
+      free(pipeline->tracks[i]);
+   }
+   pipeline_queue_deinit(&pipeline->output);
+   pipeline_queue_deinit(&pipeline->pool);
+   vcos_mutex_delete(&pipeline->lock);
+   free(pipeline);
+}
+
+/*****************************************************************************/
+VC_CONTAINER_STATUS_T vc_container_pipeline_start( VC_CONTAINER_T *p_ctx )
+{
+   VC_CONTAINER_STATUS_T status = VC_CONTAINER_ERROR_OUT_OF_RESOURCES;
+   VC_CONTAINER_PIPELINE_T *pipeline;
+   VCOS_UNSIGNED pri;
+   unsigned int i;
+
+   if(p_ctx->priv->pipeline)
+      return VC_CONTAINER_SUCCESS;
+   if(!p_ctx->priv->pf_read)
+      return VC_CONTAINER_ERROR_INVALID_ARGUMENT;
+
+   pipeline = malloc(sizeof(*pipeline));
+   if(!pipeline)
+      return VC_CONTAINER_ERROR_OUT_OF_MEMORY;
+   memset(pipeline, 0, sizeof(*pipeline));
+   pipeline->p_ctx = p_ctx;
+
+   if(vcos_mutex_create(&pipeline->lock, "cont_pipe") != VCOS_SUCCESS)
+   { free(pipeline); return status; }
+   if(pipeline_queue_init(&pipeline->pool, "cont_pipe_pool") != VC_CONTAINER_SUCCESS)
+   { vcos_mutex_delete(&pipeline->lock); free(pipeline); return status; }
+   if(pipeline_queue_init(&pipeline->output, "cont_pipe_out") != VC_CONTAINER_SUCCESS)
+   { pipeline_queue_deinit(&pipeline->pool); vcos_mutex_delete(&pipeline->lock);
+     free(pipeline); return status; }
+
+   for(i = 0; i < PIPELINE_NUM_PACKETS; i++)
+      pipeline_queue_push(&pipeline->pool, &pipeline->packets[i]);
+
+   /* One worker per packetized track */
+   for(i = 0; i < p_ctx->tracks_num; i++)
+   {
+      PIPELINE_TRACK_T *track;
+
+      if(!p_ctx->tracks[i]->is_enabled || !p_ctx->tracks[i]->priv->packetizer)
+         continue;
+      if(pipeline->tracks_num == PIPELINE_MAX_TRACKS)
+      { status = VC_CONTAINER_ERROR_OUT_OF_RESOURCES; goto error; }
+
+      track = malloc(sizeof(*track));
+      if(!track) { status = VC_CONTAINER_ERROR_OUT_OF_MEMORY; goto error; }
+      memset(track, 0, sizeof(*track));
+      track->pipeline = pipeline;
+      track->track = i;
+      if(pipeline_queue_init(&track->input, "cont_pipe_in") != VC_CONTAINER_SUCCESS)
+      { free(track); goto error; }
+      pipeline->tracks[pipeline->tracks_num++] = track;
+   }
+
+   /* Every worker plus the demux thread has to finish before the
+    * end-of-stream marker is forwarded */
+   pipeline->workers_active = pipeline->tracks_num + 1;
+
+   pri = vcos_thread_get_priority(vcos_thread_current());
+   for(i = 0; i < pipeline->tracks_num; i++)
+   {
+      PIPELINE_TRACK_T *track = pipeline->tracks[i];
+      if(vcos_thread_create_classic(&track->thread, "cont_pktz", pipeline_worker_thread,
+            track, track->stack, sizeof(track->stack), pri, 10, VCOS_START) != VCOS_SUCCESS)
+      {
+         unsigned int j;
+         pipeline->quit = 1;
+         for(j = 0; j < i; j++)
+         {
+            pipeline_queue_wakeup(&pipeline->tracks[j]->input);
+            vcos_thread_join(&pipeline->tracks[j]->thread, NULL);
+         }
+         goto error;
+      }
+   }
+
+   if(vcos_thread_create_classic(&pipeline->demux_thread, "cont_demux", pipeline_demux_thread,
+         pipeline, pipeline->demux_stack, sizeof(pipeline->demux_stack), pri, 10,
+         VCOS_START) != VCOS_SUCCESS)
+   {
+      pipeline->quit = 1;
+      for(i = 0; i < pipeline->tracks_num; i++)
+      {
+         pipeline_queue_wakeup(&pipeline->tracks[i]->input);
+         pipeline_queue_wakeup(&pipeline->pool);
+         vcos_thread_join(&pipeline->tracks[i]->thread, NULL);
+      }
+      goto error;
+   }
+
+   p_ctx->priv->pipeline = pipeline;
+   return VC_CONTAINER_SUCCESS;
+
+ error:
+   pipeline_destroy(pipeline, 0);
+   return status;
+}
+
+/*****************************************************************************/
+void vc_container_pipeline_stop( VC_CONTAINER_T *p_ctx )
+{
+   VC_CONTAINER_PIPELINE_T *pipeline = p_ctx->priv->pipeline;
+
+   if(!pipeline)
+      return;
+
+   p_ctx->priv->pipeline = NULL;
+   pipeline_destroy(pipeline, 1);
+}
+
+/*****************************************************************************/
+VC_CONTAINER_STATUS_T vc_container_pipeline_read( VC_CONTAINER_T *p_ctx,
+   VC_CONTAINER_PACKET_T *packet, VC_CONTAINER_READ_FLAGS_T flags )
+{
+   VC_CONTAINER_PIPELINE_T *pipeline = p_ctx->priv->pipeline;
+   PIPELINE_PACKET_T *p = pipeline->pending;
+   uint32_t size;
+
+   while(!p)
+      p = pipeline_queue_pop(&pipeline->output);
+
+   if(p->status != VC_CONTAINER_SUCCESS)
+   {
+      /* End of stream / error marker.  Hold on to it so all the subsequent
+       * reads keep returning the same status. */
+      pipeline->pending = p;
+      return p->status;
+   }
+
+   if(flags & VC_CONTAINER_READ_FLAG_INFO)
+   {
+      uint8_t *data = packet->data;
+      uint32_t buffer_size = packet->buffer_size;
+      *packet = p->packet;
+      packet->data = data;
+      packet->buffer_size = buffer_size;
+      pipeline->pending = p;
+      return VC_CONTAINER_SUCCESS;
+   }
+
+   if(flags & VC_CONTAINER_READ_FLAG_SKIP)
+   {
+      pipeline->pending = NULL;
+      pipeline_queue_push(&pipeline->pool, p);
+      return VC_CONTAINER_SUCCESS;
+   }
+
+   size = p->packet.size;
+   if(size > packet->buffer_size) size = packet->buffer_size;
+   memcpy(packet->data, p->packet.data, size);
+   packet->size = size;
+   packet->track = p->packet.track;
+   packet->pts = p->packet.pts;
+   packet->dts = p->packet.dts;
+   packet->num = p->packet.num;
+   packet->frame_size = p->packet.frame_size;
+   packet->flags = p->packet.flags;
+
+   if(size < p->packet.size)
+   {
+      /* The caller's buffer was too small, keep the rest for the next read */
+      p->packet.data += size;
+      p->packet.size -= size;
+      p->packet.flags &= ~VC_CONTAINER_PACKET_FLAG_FRAME_START;
+      packet->flags &= ~VC_CONTAINER_PACKET_FLAG_FRAME_END;
+      pipeline->pending = p;
+   }
+   else
+   {
+      pipeline->pending = NULL;
+      pipeline_queue_push(&pipeline->pool, p);
+   }
+
+   return VC_CONTAINER_SUCCESS;
+}
@@ -0,0 +1,74 @@
+/*
+Copyright (c) 2012, Broadcom Europe Ltd
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef VC_CONTAINERS_PIPELINE_H
+#define VC_CONTAINERS_PIPELINE_H
+
+/** \file containers_pipeline.h
+ * Private interface for the pipelined read mode of the container core.
+ * When enabled, demuxing and per-track packetization are moved onto worker
+ * threads connected by bounded queues, leaving the caller's thread free to
+ * consume packetized data.  This is opt-in via the
+ * \ref VC_CONTAINER_CONTROL_SET_PIPELINED_READ control.
+ */
+
+#include "containers/containers.h"
+
+struct VC_CONTAINER_PIPELINE_T;
+
+/**
+ * Starts the pipelined read mode on a container reader.
+ * One worker thread per packetized track is created, plus one demux thread.
+ * While the pipeline is running, the only container calls allowed are
+ * \ref vc_container_read, \ref vc_container_seek, \ref vc_container_control
+ * and \ref vc_container_close.
+ * @param p_ctx  Pointer to the context of the reader.
+ * @return       Status code.
+ */
+VC_CONTAINER_STATUS_T vc_container_pipeline_start( VC_CONTAINER_T *p_ctx );
+
+/**
+ * Stops the pipelined read mode.  All worker threads are joined and any
+ * buffered packets are discarded.  It is safe to call this when no pipeline
+ * is running.
+ * @param p_ctx  Pointer to the context of the reader.
+ */
+void vc_container_pipeline_stop( VC_CONTAINER_T *p_ctx );
+
+/**
+ * Reads the next packetized packet from the pipeline.
+ * Called by \ref vc_container_read when a pipeline is running.  Supports the
+ * \ref VC_CONTAINER_READ_FLAG_INFO and \ref VC_CONTAINER_READ_FLAG_SKIP flags
+ * but not \ref VC_CONTAINER_READ_FLAG_FORCE_TRACK.
+ * @param p_ctx   Pointer to the context of the reader.
+ * @param packet  Pointer to the VC_CONTAINER_PACKET_T structure to fill.
+ * @param flags   Flags controlling the read operation.
+ * @return        Status code.
+ */
+VC_CONTAINER_STATUS_T vc_container_pipeline_read( VC_CONTAINER_T *p_ctx,
+   VC_CONTAINER_PACKET_T *packet, VC_CONTAINER_READ_FLAGS_T flags );
+
+#endif /* VC_CONTAINERS_PIPELINE_H */
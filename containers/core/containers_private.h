@@ -65,6 +65,11 @@ typedef struct VC_CONTAINER_TRACK_PRIVATE_T
    /** Packetizer used by this track */
    VC_PACKETIZER_T *packetizer;
 
+   /** Number of packets read so far for this track */
+   uint32_t packets_read;
+   /** Number of bytes read so far for this track */
+   uint64_t bytes_read;
+
 } VC_CONTAINER_TRACK_PRIVATE_T;
 
 /** Context private to the container reader / writer instance. This private context is used to
@@ -162,6 +167,13 @@ typedef struct VC_CONTAINER_PRIVATE_T
    /** Flag specifying whether one of the tracks is being packetized */
    bool packetizing;
 
+   /** Flag set while a write-side packetizer is re-entering
+    * \ref vc_container_write with the packets it has produced */
+   bool writer_packetizing;
+
+   /** Pipelined read state when the pipelined read mode is enabled */
+   struct VC_CONTAINER_PIPELINE_T *pipeline;
+
    /** Temporary packet structure used to feed data to the packetizer */
    VC_CONTAINER_PACKET_T packetizer_packet;
 
@@ -177,7 +189,9 @@ VC_CONTAINER_STATUS_T vc_container_track_allocate_extradata( VC_CONTAINER_T *con
    VC_CONTAINER_TRACK_T *p_track, unsigned int extra_size );
 VC_CONTAINER_STATUS_T vc_container_track_allocate_drmdata( VC_CONTAINER_T *context,
    VC_CONTAINER_TRACK_T *p_track, unsigned int size );
-   
+VC_CONTAINER_STATUS_T vc_container_read_packet( VC_CONTAINER_T *context,
+   VC_CONTAINER_PACKET_T *p_packet, uint32_t flags );
+
 /* @} */
 
 #endif /* VC_CONTAINERS_PRIVATE_H */
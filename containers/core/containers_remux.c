@@ -0,0 +1,245 @@
+/*
+Copyright (c) 2012, Broadcom Europe Ltd
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "containers/core/containers_private.h"
+#include "containers/core/containers_remux.h"
+#include "containers/core/containers_logging.h"
+
+#include "vcos.h"
+
+/* The engine runs a single producer / single consumer ring of packet buffers.
+ * The reader thread fills the slots in order and the calling thread writes
+ * them out in the same order, so the ring needs no locking, just a semaphore
+ * counting free slots and one counting filled slots.  The buffer a packet was
+ * demuxed into is the one handed to the writer, so the data is copied exactly
+ * once, by the reader. */
+
+#define REMUX_PACKET_SIZE (64*1024)
+#define REMUX_NUM_PACKETS 8
+#define REMUX_MAX_TRACKS 16
+#define REMUX_STACK_SIZE 4096
+
+typedef struct REMUX_PACKET_T
+{
+   VC_CONTAINER_PACKET_T packet;
+   VC_CONTAINER_STATUS_T status;    /**< Status of the read which filled this slot */
+   uint8_t data[REMUX_PACKET_SIZE];
+
+} REMUX_PACKET_T;
+
+typedef struct VC_CONTAINER_REMUX_T
+{
+   VC_CONTAINER_T *input;
+
+   VCOS_SEMAPHORE_T free_slots;     /**< Slots available to the reader thread */
+   VCOS_SEMAPHORE_T full_slots;     /**< Slots waiting to be written out */
+
+   /** Maps an input track index onto the corresponding output track index */
+   unsigned int track_map[REMUX_MAX_TRACKS];
+
+   volatile int quit;
+
+   VCOS_THREAD_T thread;
+   uint8_t stack[REMUX_STACK_SIZE];
+
+   REMUX_PACKET_T packets[REMUX_NUM_PACKETS];
+
+} VC_CONTAINER_REMUX_T;
+
+/*****************************************************************************/
+static void *remux_reader_thread(void *argv)
+{
+   VC_CONTAINER_REMUX_T *remux = argv;
+   unsigned int produced = 0;
+
+   while(1)
+   {
+      REMUX_PACKET_T *slot;
+
+      vcos_semaphore_wait(&remux->free_slots);
+      if(remux->quit)
+         return NULL;
+
+      slot = &remux->packets[produced++ % REMUX_NUM_PACKETS];
+      memset(&slot->packet, 0, sizeof(slot->packet));
+      slot->packet.data = slot->data;
+      slot->packet.buffer_size = REMUX_PACKET_SIZE;
+      slot->status = vc_container_read(remux->input, &slot->packet, 0);
+      vcos_semaphore_post(&remux->full_slots);
+
+      /* The slot carrying the failed read acts as the end-of-stream marker */
+      if(slot->status != VC_CONTAINER_SUCCESS)
+         return NULL;
+   }
+}
+
+/** Adds a track to the writer behind a write-side packetizer.
+ * Used when the writer refuses the track format as it stands: the format is
+ * converted to the default variant of the same codec (e.g. H264 as Annex-B
+ * start codes rather than AVC1 length prefixes) and the writer is offered
+ * that instead. The packetizer is left attached to the output track, where
+ * vc_container_write runs it over each packet, and is closed with the rest
+ * of the track when the writer is closed. */
+static VC_CONTAINER_STATUS_T remux_add_packetized_track( VC_CONTAINER_T *output,
+   VC_CONTAINER_ES_FORMAT_T *format )
+{
+   VC_CONTAINER_STATUS_T status;
+   VC_PACKETIZER_T *packetizer;
+
+   packetizer = vc_packetizer_open(format, 0, &status);
+   if(!packetizer)
+      return status;
+
+   status = vc_container_control(output, VC_CONTAINER_CONTROL_TRACK_ADD,
+      packetizer->out);
+   if(status != VC_CONTAINER_SUCCESS)
+   {
+      vc_packetizer_close(packetizer);
+      return status;
+   }
+
+   output->tracks[output->tracks_num - 1]->priv->packetizer = packetizer;
+   return VC_CONTAINER_SUCCESS;
+}
+
+/** Creates one output track for each enabled input track */
+static VC_CONTAINER_STATUS_T remux_setup_tracks( VC_CONTAINER_REMUX_T *remux,
+   VC_CONTAINER_T *input, VC_CONTAINER_T *output )
+{
+   VC_CONTAINER_STATUS_T status;
+   unsigned int i, added = 0;
+
+   if(input->tracks_num > REMUX_MAX_TRACKS)
+      return VC_CONTAINER_ERROR_OUT_OF_RESOURCES;
+
+   for(i = 0; i < input->tracks_num; i++)
+   {
+      if(!input->tracks[i]->is_enabled)
+         continue;
+
+      status = vc_container_control(output, VC_CONTAINER_CONTROL_TRACK_ADD,
+         input->tracks[i]->format);
+      if(status != VC_CONTAINER_SUCCESS)
+         /* The writer may only take another variant of the codec, so retry
+          * with a packetizer converting the stream on the fly */
+         status = remux_add_packetized_track(output, input->tracks[i]->format);
+      if(status != VC_CONTAINER_SUCCESS)
+      {
+         LOG_ERROR(input, "remux: output does not support track %u (%i)", i, status);
+         return status;
+      }
+      remux->track_map[i] = added++;
+   }
+
+   if(!added)
+      return VC_CONTAINER_ERROR_NO_TRACK_AVAILABLE;
+
+   /* Optional, lets the writer lay down its header before the first packet */
+   vc_container_control(output, VC_CONTAINER_CONTROL_TRACK_ADD_DONE);
+
+   return VC_CONTAINER_SUCCESS;
+}
+
+/*****************************************************************************/
+VC_CONTAINER_STATUS_T vc_container_remux( VC_CONTAINER_T *input,
+   VC_CONTAINER_T *output )
+{
+   VC_CONTAINER_STATUS_T status = VC_CONTAINER_ERROR_OUT_OF_RESOURCES;
+   VC_CONTAINER_REMUX_T *remux;
+   unsigned int consumed = 0;
+
+   if(!input->priv->pf_read || !output->priv->pf_write)
+      return VC_CONTAINER_ERROR_INVALID_ARGUMENT;
+
+   remux = malloc(sizeof(*remux));
+   if(!remux)
+      return VC_CONTAINER_ERROR_OUT_OF_MEMORY;
+   memset(remux, 0, sizeof(*remux));
+   remux->input = input;
+
+   status = remux_setup_tracks(remux, input, output);
+   if(status != VC_CONTAINER_SUCCESS)
+   { free(remux); return status; }
+
+   status = VC_CONTAINER_ERROR_OUT_OF_RESOURCES;
+   if(vcos_semaphore_create(&remux->free_slots, "cont_remux_free",
+         REMUX_NUM_PACKETS) != VCOS_SUCCESS)
+   { free(remux); return status; }
+   if(vcos_semaphore_create(&remux->full_slots, "cont_remux_full", 0) != VCOS_SUCCESS)
+   { vcos_semaphore_delete(&remux->free_slots); free(remux); return status; }
+
+   if(vcos_thread_create_classic(&remux->thread, "cont_remux", remux_reader_thread,
+         remux, remux->stack, sizeof(remux->stack),
+         vcos_thread_get_priority(vcos_thread_current()), 10, VCOS_START) != VCOS_SUCCESS)
+   {
+      vcos_semaphore_delete(&remux->full_slots);
+      vcos_semaphore_delete(&remux->free_slots);
+      free(remux);
+      return status;
+   }
+
+   /* Write the packets out in the order the reader filled them in */
+   while(1)
+   {
+      REMUX_PACKET_T *slot;
+
+      vcos_semaphore_wait(&remux->full_slots);
+      slot = &remux->packets[consumed++ % REMUX_NUM_PACKETS];
+
+      if(slot->status != VC_CONTAINER_SUCCESS)
+      {
+         /* The whole input was consumed if the reader stopped at its end */
+         status = slot->status == VC_CONTAINER_ERROR_EOS ?
+            VC_CONTAINER_SUCCESS : slot->status;
+         break;
+      }
+
+      slot->packet.track = remux->track_map[slot->packet.track];
+      status = vc_container_write(output, &slot->packet);
+      vcos_semaphore_post(&remux->free_slots);
+
+      if(status != VC_CONTAINER_SUCCESS)
+      {
+         LOG_ERROR(input, "remux: write failed (%i)", status);
+         break;
+      }
+   }
+
+   /* Stop and join the reader thread.  It might be blocked waiting for a
+    * free slot, so hand it one after raising the quit flag. */
+   remux->quit = 1;
+   vcos_semaphore_post(&remux->free_slots);
+   vcos_thread_join(&remux->thread, NULL);
+
+   vcos_semaphore_delete(&remux->full_slots);
+   vcos_semaphore_delete(&remux->free_slots);
+   free(remux);
+   return status;
+}
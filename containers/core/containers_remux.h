@@ -0,0 +1,54 @@
+/*
+Copyright (c) 2012, Broadcom Europe Ltd
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef VC_CONTAINERS_REMUX_H
+#define VC_CONTAINERS_REMUX_H
+
+/** \file containers_remux.h
+ * Remux engine of the container core.
+ * Connects a container reader directly to a container writer, handing the
+ * packet buffers filled by the reader straight to the writer without any
+ * intermediate copy.  Reading and writing are pipelined on two threads so
+ * the demuxing of one packet overlaps the writing of the previous one.
+ */
+
+#include "containers/containers.h"
+
+/**
+ * Remuxes the content of a container reader into a container writer.
+ * The writer must be freshly opened: the engine creates one output track for
+ * each enabled track of the reader and then copies packets across until the
+ * end of the input stream, blocking the calling thread for the duration.
+ * The calling thread does the writing while a worker thread does the reading.
+ * @param input   Pointer to the context of the reader to consume.
+ * @param output  Pointer to the context of the writer to fill.
+ * @return        Status code, VC_CONTAINER_SUCCESS once the whole of the
+ *                input has been written to the output.
+ */
+VC_CONTAINER_STATUS_T vc_container_remux( VC_CONTAINER_T *input,
+   VC_CONTAINER_T *output );
+
+#endif /* VC_CONTAINERS_REMUX_H */
@@ -0,0 +1,211 @@
+/*
+Copyright (c) 2012, Broadcom Europe Ltd
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include <stdlib.h>
+#include <string.h>
+
+#include "containers/core/containers_common.h"
+#include "containers/core/containers_reorder.h"
+
+/******************************************************************************
+Type definitions
+******************************************************************************/
+
+/** One packet held by the reorder buffer. */
+typedef struct reorder_packet_tag
+{
+   uint16_t seq;  /**< Sequence number of the packet */
+   size_t size;   /**< Number of bytes of data in the packet */
+   uint8_t *data; /**< Packet data, points into the shared data pool */
+} REORDER_PACKET_T;
+
+struct VC_CONTAINERS_REORDER_T
+{
+   unsigned int depth;           /**< Maximum number of packets held */
+   size_t packet_size;           /**< Maximum size of a single packet */
+   bool initialized;             /**< True once the first packet has set the sequence position */
+   uint16_t next_seq;            /**< Next sequence number due for delivery */
+   unsigned int count;           /**< Number of packets currently held */
+   REORDER_PACKET_T **sorted;    /**< Held packets, sorted by sequence number */
+   REORDER_PACKET_T **free_list; /**< Stack of unused packet slots */
+   unsigned int free_count;      /**< Number of entries in the free stack */
+   REORDER_PACKET_T *packets;    /**< Packet slot storage */
+   uint8_t *pool;                /**< Data area shared by all packet slots */
+};
+
+/******************************************************************************
+Local Functions
+******************************************************************************/
+
+/** Distance of a sequence number ahead of the delivery position.
+ * Serial number arithmetic: values of 0x8000 and above mean seq is actually
+ * behind (older than) the delivery position. */
+#define SEQ_DELTA(reorder, seq) ((uint16_t)((seq) - (reorder)->next_seq))
+
+/*****************************************************************************/
+VC_CONTAINERS_REORDER_T *vc_containers_reorder_create( unsigned int depth, size_t packet_size )
+{
+   VC_CONTAINERS_REORDER_T *reorder;
+   unsigned int i;
+
+   if (!depth || !packet_size)
+      return NULL;
+
+   reorder = (VC_CONTAINERS_REORDER_T *)malloc(sizeof(*reorder) +
+         2 * depth * sizeof(REORDER_PACKET_T *) +
+         depth * sizeof(REORDER_PACKET_T) +
+         depth * packet_size);
+   if (!reorder)
+      return NULL;
+
+   memset(reorder, 0, sizeof(*reorder));
+   reorder->depth = depth;
+   reorder->packet_size = packet_size;
+   reorder->sorted = (REORDER_PACKET_T **)(reorder + 1);
+   reorder->free_list = reorder->sorted + depth;
+   reorder->packets = (REORDER_PACKET_T *)(reorder->free_list + depth);
+   reorder->pool = (uint8_t *)(reorder->packets + depth);
+
+   for (i = 0; i < depth; i++)
+      reorder->packets[i].data = reorder->pool + i * packet_size;
+
+   vc_containers_reorder_reset(reorder);
+
+   return reorder;
+}
+
+/*****************************************************************************/
+void vc_containers_reorder_destroy( VC_CONTAINERS_REORDER_T *reorder )
+{
+   if (reorder)
+      free(reorder);
+}
+
+/*****************************************************************************/
+void vc_containers_reorder_reset( VC_CONTAINERS_REORDER_T *reorder )
+{
+   unsigned int i;
+
+   if (!reorder)
+      return;
+
+   reorder->initialized = false;
+   reorder->count = 0;
+   reorder->free_count = reorder->depth;
+   for (i = 0; i < reorder->depth; i++)
+      reorder->free_list[i] = &reorder->packets[i];
+}
+
+/*****************************************************************************/
+bool vc_containers_reorder_insert( VC_CONTAINERS_REORDER_T *reorder, uint16_t seq,
+      const void *data, size_t size )
+{
+   REORDER_PACKET_T *packet;
+   unsigned int lo, hi;
+   uint16_t delta;
+
+   if (!reorder || !data || size > reorder->packet_size)
+      return false;
+
+   if (reorder->count == reorder->depth)
+      return false;
+
+   if (!reorder->initialized)
+   {
+      reorder->next_seq = seq;
+      reorder->initialized = true;
+   }
+
+   /* Drop packets the delivery position has already moved past */
+   delta = SEQ_DELTA(reorder, seq);
+   if (delta & 0x8000)
+      return false;
+
+   /* Binary search for the insertion position, dropping duplicates */
+   lo = 0;
+   hi = reorder->count;
+   while (lo < hi)
+   {
+      unsigned int mid = (lo + hi) / 2;
+      uint16_t mid_delta = SEQ_DELTA(reorder, reorder->sorted[mid]->seq);
+
+      if (mid_delta == delta)
+         return false;
+      if (mid_delta < delta)
+         lo = mid + 1;
+      else
+         hi = mid;
+   }
+
+   vc_container_assert(reorder->free_count);
+   packet = reorder->free_list[--reorder->free_count];
+   packet->seq = seq;
+   packet->size = size;
+   memcpy(packet->data, data, size);
+
+   memmove(&reorder->sorted[lo + 1], &reorder->sorted[lo],
+         (reorder->count - lo) * sizeof(*reorder->sorted));
+   reorder->sorted[lo] = packet;
+   reorder->count++;
+
+   return true;
+}
+
+/*****************************************************************************/
+bool vc_containers_reorder_ready( const VC_CONTAINERS_REORDER_T *reorder )
+{
+   if (!reorder || !reorder->count)
+      return false;
+
+   /* Deliver when the next packet in sequence is held, or when the buffer is
+    * full and the gap in front of the oldest packet has to be given up on. */
+   return reorder->count == reorder->depth ||
+      reorder->sorted[0]->seq == reorder->next_seq;
+}
+
+/*****************************************************************************/
+size_t vc_containers_reorder_remove( VC_CONTAINERS_REORDER_T *reorder, void *buffer,
+      size_t buffer_size )
+{
+   REORDER_PACKET_T *packet;
+   size_t size;
+
+   if (!reorder || !reorder->count || !buffer)
+      return 0;
+
+   packet = reorder->sorted[0];
+   size = packet->size;
+   if (size > buffer_size)
+      size = buffer_size;
+   memcpy(buffer, packet->data, size);
+
+   reorder->next_seq = packet->seq + 1;
+   reorder->count--;
+   memmove(reorder->sorted, &reorder->sorted[1], reorder->count * sizeof(*reorder->sorted));
+   reorder->free_list[reorder->free_count++] = packet;
+
+   return size;
+}
@@ -0,0 +1,102 @@
+/*
+Copyright (c) 2012, Broadcom Europe Ltd
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef VC_CONTAINERS_REORDER_H
+#define VC_CONTAINERS_REORDER_H
+
+/** \file containers_reorder.h
+ * Sequence-number-ordered packet buffer (jitter buffer).
+ *
+ * Streaming protocols such as RTP deliver packets tagged with a 16-bit
+ * sequence number but do not guarantee ordering. This buffer holds a bounded
+ * number of packets and hands them back in sequence number order, undoing any
+ * reordering that fits within its depth. The depth directly sets the latency
+ * and memory bound: at most depth packets of packet_size bytes are held.
+ *
+ * Insertion uses a binary search on the pending packets, so the cost of
+ * accepting an out of order packet is logarithmic in the buffer depth.
+ * Sequence numbers are treated with serial number arithmetic, so wrapping
+ * through zero is handled transparently.
+ */
+
+#include "containers/containers.h"
+
+/** Sequence-ordered packet buffer.
+ * This is an opaque structure; use the functions below to manipulate it. */
+typedef struct VC_CONTAINERS_REORDER_T VC_CONTAINERS_REORDER_T;
+
+/** Create a packet reorder buffer.
+ *
+ * \param depth Maximum number of packets held, which also bounds the latency.
+ * \param packet_size Maximum size of a single packet in bytes.
+ * \return The created buffer, or NULL on failure. */
+VC_CONTAINERS_REORDER_T *vc_containers_reorder_create( unsigned int depth, size_t packet_size );
+
+/** Destroy a packet reorder buffer, releasing any packets still held.
+ *
+ * \param reorder The buffer to destroy. */
+void vc_containers_reorder_destroy( VC_CONTAINERS_REORDER_T *reorder );
+
+/** Empty a packet reorder buffer and forget the current sequence position.
+ * The next packet inserted restarts the sequence.
+ *
+ * \param reorder The buffer to reset. */
+void vc_containers_reorder_reset( VC_CONTAINERS_REORDER_T *reorder );
+
+/** Insert a packet into the reorder buffer.
+ * The packet data is copied into the buffer. Packets older than the last one
+ * removed, duplicates of held packets and packets that would overflow the
+ * buffer are dropped. To guarantee space, remove pending packets whenever
+ * vc_containers_reorder_ready() reports true before inserting new ones.
+ *
+ * \param reorder The buffer to insert into.
+ * \param seq Sequence number of the packet.
+ * \param data Pointer to the packet data.
+ * \param size Number of bytes in the packet, at most packet_size.
+ * \return True if the packet was stored, false if it was dropped. */
+bool vc_containers_reorder_insert( VC_CONTAINERS_REORDER_T *reorder, uint16_t seq,
+      const void *data, size_t size );
+
+/** Query whether a packet is due for delivery.
+ * A packet is due when the next packet in sequence is held, or when the
+ * buffer is full and the oldest packet has to be given up on.
+ *
+ * \param reorder The buffer to query.
+ * \return True if vc_containers_reorder_remove() will deliver a packet. */
+bool vc_containers_reorder_ready( const VC_CONTAINERS_REORDER_T *reorder );
+
+/** Remove the oldest pending packet from the reorder buffer.
+ * Delivery moves the sequence position past the removed packet, so any gap in
+ * front of it is treated as lost from then on.
+ *
+ * \param reorder The buffer to remove from.
+ * \param buffer Pointer to memory receiving the packet data.
+ * \param buffer_size Available space in bytes; larger packets are truncated.
+ * \return The number of bytes delivered, zero if the buffer is empty. */
+size_t vc_containers_reorder_remove( VC_CONTAINERS_REORDER_T *reorder, void *buffer,
+      size_t buffer_size );
+
+#endif /* VC_CONTAINERS_REORDER_H */
@@ -52,6 +52,11 @@ struct VC_URI_PARTS_T
    char *fragment;   /**< Unescaped fragment */
    VC_URI_QUERY_T *queries;   /**< Array of queries */
    uint32_t num_queries;      /**< Number of queries in array */
+
+   char *arena;      /**< Optional caller-provided memory for components */
+   size_t arena_size; /**< Size of the arena */
+   size_t arena_used; /**< Bytes of the arena allocated so far */
+   bool embedded;    /**< Whether the structure itself lives in caller memory */
 };
 
 typedef const uint32_t *RESERVED_CHARS_TABLE_T;
@@ -110,6 +115,36 @@ static uint32_t fragment_reserved_chars[8] = {
 /* Internal functions                                                        */
 /*****************************************************************************/
 
+/** Allocates memory for a URI component, from the arena when one was provided
+ * and still has room, falling back to the heap otherwise. */
+static void *uri_alloc( VC_URI_PARTS_T *p_uri, size_t size )
+{
+   if (p_uri->arena && p_uri->arena_used + size <= p_uri->arena_size)
+   {
+      void *ptr = p_uri->arena + p_uri->arena_used;
+      /* Keep the arena pointer-aligned for the query array */
+      p_uri->arena_used += (size + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+      return ptr;
+   }
+   return malloc(size);
+}
+
+/*****************************************************************************/
+static bool uri_in_arena( const VC_URI_PARTS_T *p_uri, const void *ptr )
+{
+   return p_uri->arena && (const char *)ptr >= p_uri->arena &&
+      (const char *)ptr < p_uri->arena + p_uri->arena_size;
+}
+
+/*****************************************************************************/
+static void uri_free( VC_URI_PARTS_T *p_uri, void *ptr )
+{
+   /* Arena memory is reclaimed wholesale by vc_uri_clear */
+   if (ptr && !uri_in_arena(p_uri, ptr))
+      free(ptr);
+}
+
+/*****************************************************************************/
 static char to_hex(int v)
 {
    if (v > 9)
@@ -229,11 +264,12 @@ static void unescape_string( const char *str, uint32_t str_len, char *unescaped
 }
 
 /*****************************************************************************/
-static char *create_unescaped_string( const char *escstr, uint32_t esclen )
+static char *create_unescaped_string( VC_URI_PARTS_T *p_uri,
+      const char *escstr, uint32_t esclen )
 {
    char *unescstr;
 
-   unescstr = (char *)malloc(unescaped_length(escstr, esclen) + 1);  /* Allow for NUL */
+   unescstr = (char *)uri_alloc(p_uri, unescaped_length(escstr, esclen) + 1);  /* Allow for NUL */
    if (unescstr)
       unescape_string(escstr, esclen, unescstr);
 
@@ -241,16 +277,16 @@ static char *create_unescaped_string( const char *escstr, uint32_t esclen )
 }
 
 /*****************************************************************************/
-static bool duplicate_string( const char *src, char **p_dst )
+static bool duplicate_string( VC_URI_PARTS_T *p_uri, const char *src, char **p_dst )
 {
    if (*p_dst)
-      free(*p_dst);
+      uri_free(p_uri, *p_dst);
 
    if (src)
    {
       size_t str_size = strlen(src) + 1;
 
-      *p_dst = (char *)malloc(str_size);
+      *p_dst = (char *)uri_alloc(p_uri, str_size);
       if (!*p_dst)
          return false;
 
@@ -262,11 +298,11 @@ static bool duplicate_string( const char *src, char **p_dst )
 }
 
 /*****************************************************************************/
-static void release_string( char **str )
+static void release_string( VC_URI_PARTS_T *p_uri, char **str )
 {
    if (*str)
    {
-      free(*str);
+      uri_free(p_uri, *str);
       *str = NULL;
    }
 }
@@ -331,7 +367,7 @@ static bool parse_authority( VC_URI_PARTS_T *p_uri, const char *str,
 
    if (marker)
    {
-      p_uri->userinfo = create_unescaped_string(str, marker - str);
+      p_uri->userinfo = create_unescaped_string(p_uri, str, marker - str);
       if (!p_uri->userinfo)
          return false;
       str = marker + 1; /* Past '@' character */
@@ -360,7 +396,7 @@ static bool parse_authority( VC_URI_PARTS_T *p_uri, const char *str,
    }
 
    /* Always store the host, even if empty, to trigger the "://" form of URI */
-   p_uri->host = create_unescaped_string(str, marker - str);
+   p_uri->host = create_unescaped_string(p_uri, str, marker - str);
    if (!p_uri->host)
       return false;
    to_lower_string(p_uri->host);    /* Host names are case-insensitive */
@@ -368,7 +404,7 @@ static bool parse_authority( VC_URI_PARTS_T *p_uri, const char *str,
    if (*marker == ':')
    {
       str = marker + 1;
-      p_uri->port = create_unescaped_string(str, str_end - str);
+      p_uri->port = create_unescaped_string(p_uri, str, str_end - str);
       if (!p_uri->port)
          return false;
    }
@@ -399,17 +435,17 @@ static bool store_query( VC_URI_PARTS_T *p_uri, const char *name_start,
 
       if (equals_ptr)
       {
-         value = create_unescaped_string(equals_ptr + 1, value_len);
+         value = create_unescaped_string(p_uri, equals_ptr + 1, value_len);
          if (!value)
             return false;
          equals_ptr = query_end;
       }
 
-      name = create_unescaped_string(name_start, name_len);
+      name = create_unescaped_string(p_uri, name_start, name_len);
       if (!name)
       {
          if (value)
-            free(value);
+            uri_free(p_uri, value);
          return false;
       }
 
@@ -445,7 +481,7 @@ static bool parse_query( VC_URI_PARTS_T *p_uri, const char *str, uint32_t str_le
          query_count++;
    }
 
-   queries = (VC_URI_QUERY_T *)malloc(query_count * sizeof(VC_URI_QUERY_T));
+   queries = (VC_URI_QUERY_T *)uri_alloc(p_uri, query_count * sizeof(VC_URI_QUERY_T));
    if (!queries)
       return false;
 
@@ -716,18 +752,35 @@ VC_URI_PARTS_T *vc_uri_create( void )
    return p_uri;
 }
 
+/*****************************************************************************/
+VC_URI_PARTS_T *vc_uri_create_in( void *mem, size_t mem_size )
+{
+   VC_URI_PARTS_T *p_uri;
+
+   if (!mem || mem_size < sizeof(VC_URI_PARTS_T))
+      return NULL;
+
+   p_uri = (VC_URI_PARTS_T *)mem;
+   memset(p_uri, 0, sizeof(VC_URI_PARTS_T));
+   p_uri->arena = (char *)mem + sizeof(VC_URI_PARTS_T);
+   p_uri->arena_size = mem_size - sizeof(VC_URI_PARTS_T);
+   p_uri->embedded = true;
+
+   return p_uri;
+}
+
 /*****************************************************************************/
 void vc_uri_clear( VC_URI_PARTS_T *p_uri )
 {
    if (!p_uri)
       return;
 
-   release_string(&p_uri->scheme);
-   release_string(&p_uri->userinfo);
-   release_string(&p_uri->host);
-   release_string(&p_uri->port);
-   release_string(&p_uri->path);
-   release_string(&p_uri->fragment);
+   release_string(p_uri, &p_uri->scheme);
+   release_string(p_uri, &p_uri->userinfo);
+   release_string(p_uri, &p_uri->host);
+   release_string(p_uri, &p_uri->port);
+   release_string(p_uri, &p_uri->path);
+   release_string(p_uri, &p_uri->fragment);
 
    if (p_uri->queries)
    {
@@ -736,14 +789,16 @@ void vc_uri_clear( VC_URI_PARTS_T *p_uri )
 
       while (count--)
       {
-         release_string(&queries[count].name);
-         release_string(&queries[count].value);
+         release_string(p_uri, &queries[count].name);
+         release_string(p_uri, &queries[count].value);
       }
 
-      free(queries);
+      uri_free(p_uri, queries);
       p_uri->queries = NULL;
       p_uri->num_queries = 0;
    }
+
+   p_uri->arena_used = 0;
 }
 
 /*****************************************************************************/
@@ -754,7 +809,8 @@ void vc_uri_release( VC_URI_PARTS_T *p_uri )
 
    vc_uri_clear(p_uri);
 
-   free(p_uri);
+   if (!p_uri->embedded)
+      free(p_uri);
 }
 
 /*****************************************************************************/
@@ -780,12 +836,12 @@ bool vc_uri_parse( VC_URI_PARTS_T *p_uri, const char *uri )
       {
          /* Looks like a bare, absolute DOS/Windows filename with a drive letter */
          /* coverity[double_free] Pointer freed and set to NULL */
-         bool ret = duplicate_string(uri, &p_uri->path);
+         bool ret = duplicate_string(p_uri, uri, &p_uri->path);
          vc_uri_set_path_extension(p_uri);
          return ret;
       }
 
-      p_uri->scheme = create_unescaped_string(uri, len);
+      p_uri->scheme = create_unescaped_string(p_uri, uri, len);
       if (!p_uri->scheme)
          goto error;
 
@@ -817,7 +873,7 @@ bool vc_uri_parse( VC_URI_PARTS_T *p_uri, const char *uri )
    len = marker - uri;
    if (len)
    {
-      p_uri->path = create_unescaped_string(uri, len);
+      p_uri->path = create_unescaped_string(p_uri, uri, len);
       vc_uri_set_path_extension(p_uri);
       if (!p_uri->path)
          goto error;
@@ -836,7 +892,7 @@ bool vc_uri_parse( VC_URI_PARTS_T *p_uri, const char *uri )
    if (*marker == '#')
    {
       uri = marker + 1;
-      p_uri->fragment = create_unescaped_string(uri, strlen(uri));
+      p_uri->fragment = create_unescaped_string(p_uri, uri, strlen(uri));
       if (!p_uri->fragment)
          goto error;
    }
@@ -958,31 +1014,31 @@ bool vc_uri_find_query( VC_URI_PARTS_T *p_uri, uint32_t *p_index, const char *na
 /*****************************************************************************/
 bool vc_uri_set_scheme( VC_URI_PARTS_T *p_uri, const char *scheme )
 {
-   return p_uri ? duplicate_string(scheme, &p_uri->scheme) : false;
+   return p_uri ? duplicate_string(p_uri, scheme, &p_uri->scheme) : false;
 }
 
 /*****************************************************************************/
 bool vc_uri_set_userinfo( VC_URI_PARTS_T *p_uri, const char *userinfo )
 {
-   return p_uri ? duplicate_string(userinfo, &p_uri->userinfo) : false;
+   return p_uri ? duplicate_string(p_uri, userinfo, &p_uri->userinfo) : false;
 }
 
 /*****************************************************************************/
 bool vc_uri_set_host( VC_URI_PARTS_T *p_uri, const char *host )
 {
-   return p_uri ? duplicate_string(host, &p_uri->host) : false;
+   return p_uri ? duplicate_string(p_uri, host, &p_uri->host) : false;
 }
 
 /*****************************************************************************/
 bool vc_uri_set_port( VC_URI_PARTS_T *p_uri, const char *port )
 {
-   return p_uri ? duplicate_string(port, &p_uri->port) : false;
+   return p_uri ? duplicate_string(p_uri, port, &p_uri->port) : false;
 }
 
 /*****************************************************************************/
 bool vc_uri_set_path( VC_URI_PARTS_T *p_uri, const char *path )
 {
-   bool ret = p_uri ? duplicate_string(path, &p_uri->path) : false;
+   bool ret = p_uri ? duplicate_string(p_uri, path, &p_uri->path) : false;
    vc_uri_set_path_extension(p_uri);
    return ret;
 }
@@ -990,7 +1046,7 @@ bool vc_uri_set_path( VC_URI_PARTS_T *p_uri, const char *path )
 /*****************************************************************************/
 bool vc_uri_set_fragment( VC_URI_PARTS_T *p_uri, const char *fragment )
 {
-   return p_uri ? duplicate_string(fragment, &p_uri->fragment) : false;
+   return p_uri ? duplicate_string(p_uri, fragment, &p_uri->fragment) : false;
 }
 
 /*****************************************************************************/
@@ -1003,10 +1059,16 @@ bool vc_uri_add_query( VC_URI_PARTS_T *p_uri, const char *name, const char *valu
       return false;
 
    count = p_uri->num_queries;
-   if (p_uri->queries)
+   if (p_uri->queries && !uri_in_arena(p_uri, p_uri->queries))
       queries = (VC_URI_QUERY_T *)realloc(p_uri->queries, (count + 1) * sizeof(VC_URI_QUERY_T));
    else
-      queries = (VC_URI_QUERY_T *)malloc(sizeof(VC_URI_QUERY_T));
+   {
+      /* Arena allocations cannot be resized, so take a new array and leave
+       * the old one to be reclaimed by the next clear */
+      queries = (VC_URI_QUERY_T *)uri_alloc(p_uri, (count + 1) * sizeof(VC_URI_QUERY_T));
+      if (queries && p_uri->queries)
+         memcpy(queries, p_uri->queries, count * sizeof(VC_URI_QUERY_T));
+   }
 
    if (!queries)
       return false;
@@ -1016,16 +1078,16 @@ bool vc_uri_add_query( VC_URI_PARTS_T *p_uri, const char *name, const char *valu
    queries[count].name = NULL;
    queries[count].value = NULL;
 
-   if (duplicate_string(name, &queries[count].name))
+   if (duplicate_string(p_uri, name, &queries[count].name))
    {
-      if (duplicate_string(value, &queries[count].value))
+      if (duplicate_string(p_uri, value, &queries[count].value))
       {
          /* Successful exit path */
          p_uri->num_queries++;
          return true;
       }
 
-      release_string(&queries[count].name);
+      release_string(p_uri, &queries[count].name);
    }
 
    return false;
@@ -1042,7 +1104,7 @@ bool vc_uri_merge( const VC_URI_PARTS_T *base_uri, VC_URI_PARTS_T *relative_uri
       return true;
 
    /* Otherwise, copy the base scheme */
-   if (!duplicate_string(base_uri->scheme, &relative_uri->scheme))
+   if (!duplicate_string(relative_uri, base_uri->scheme, &relative_uri->scheme))
       return false;
 
    /* If any of the network info is set, use the rest of the relative URI as-is */
@@ -1050,9 +1112,9 @@ bool vc_uri_merge( const VC_URI_PARTS_T *base_uri, VC_URI_PARTS_T *relative_uri
       return true;
 
    /* Otherwise, copy the base network info */
-   if (!duplicate_string(base_uri->host, &relative_uri->host) ||
-         !duplicate_string(base_uri->port, &relative_uri->port) ||
-         !duplicate_string(base_uri->userinfo, &relative_uri->userinfo))
+   if (!duplicate_string(relative_uri, base_uri->host, &relative_uri->host) ||
+         !duplicate_string(relative_uri, base_uri->port, &relative_uri->port) ||
+         !duplicate_string(relative_uri, base_uri->userinfo, &relative_uri->userinfo))
       return false;
 
    relative_path = relative_uri->path;
@@ -1110,7 +1172,7 @@ bool vc_uri_merge( const VC_URI_PARTS_T *base_uri, VC_URI_PARTS_T *relative_uri
       vc_uri_remove_single_dot_segments(merged_path);
       vc_uri_remove_double_dot_segments(merged_path);
 
-      success = duplicate_string(merged_path, &relative_uri->path);
+      success = duplicate_string(relative_uri, merged_path, &relative_uri->path);
 
       free(merged_path);
    }
@@ -45,6 +45,18 @@ typedef struct VC_URI_PARTS_T VC_URI_PARTS_T;
  * \return The new URI structure. */
 VC_URI_PARTS_T *vc_uri_create( void );
 
+/** Create an empty URI structure inside caller-provided memory.
+ * The structure itself and, as far as they fit, the component strings of
+ * subsequent parses are carved out of the given memory, so parsing a typical
+ * URI performs no heap allocation. Components which do not fit fall back to
+ * the heap transparently. The memory must be pointer-aligned, must outlive
+ * the structure and is not freed by \ref vc_uri_release.
+ *
+ * \param mem      Memory to place the structure and its components in.
+ * \param mem_size Size of the memory in bytes.
+ * \return The new URI structure, or NULL if the memory is too small. */
+VC_URI_PARTS_T *vc_uri_create_in( void *mem, size_t mem_size );
+
 /** Destroy a URI structure.
  *
  * \param p_uri Pointer to a URI parts structure. */
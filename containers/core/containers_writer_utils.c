@@ -45,6 +45,8 @@ static VC_CONTAINER_STATUS_T vc_container_writer_extraio_create(VC_CONTAINER_T *
    extraio->io = vc_container_io_open( uri, VC_CONTAINER_IO_MODE_WRITE, &status );
    extraio->refcount = 0;
    extraio->temp = 0;
+   extraio->checkpoint_dirty = 0;
+   extraio->checkpoint_interval = 0;
    return status;
 }
 
@@ -66,6 +68,7 @@ VC_CONTAINER_STATUS_T vc_container_writer_extraio_create_temp(VC_CONTAINER_T *co
    status = vc_container_writer_extraio_create(context, uri, extraio);
    free(uri);
    extraio->temp = true;
+   extraio->checkpoint_interval = VC_CONTAINER_WRITER_EXTRAIO_CHECKPOINT_DEFAULT;
 
    if(status == VC_CONTAINER_SUCCESS && !context->priv->tmp_io)
       context->priv->tmp_io = extraio->io;
@@ -107,6 +110,37 @@ int64_t vc_container_writer_extraio_enable(VC_CONTAINER_T *context, VC_CONTAINER
    return extraio->refcount++;
 }
 
+/*****************************************************************************/
+VC_CONTAINER_STATUS_T vc_container_writer_extraio_checkpoint(VC_CONTAINER_T *context,
+   VC_CONTAINER_WRITER_EXTRAIO_T *extraio, int64_t bytes)
+{
+   /* While enabled, the extra i/o has been swapped into the context */
+   VC_CONTAINER_IO_T *io = extraio->refcount ? context->priv->io : extraio->io;
+   VC_CONTAINER_STATUS_T status;
+
+   if(!extraio->checkpoint_interval)
+      return VC_CONTAINER_SUCCESS;
+
+   extraio->checkpoint_dirty += bytes;
+   if(extraio->checkpoint_dirty < extraio->checkpoint_interval)
+      return VC_CONTAINER_SUCCESS;
+
+   /* Push any cached data out to the file, then the file to storage. A
+    * failure to sync (e.g. an io without sync support) stops further
+    * checkpoint attempts rather than uselessly flushing every interval. */
+   status = vc_container_io_control(io, VC_CONTAINER_CONTROL_IO_FLUSH);
+   if(status == VC_CONTAINER_SUCCESS || status == VC_CONTAINER_ERROR_UNSUPPORTED_OPERATION)
+      status = vc_container_io_control(io, VC_CONTAINER_CONTROL_IO_SYNC);
+   if(status != VC_CONTAINER_SUCCESS)
+   {
+      extraio->checkpoint_interval = 0;
+      return status;
+   }
+
+   extraio->checkpoint_dirty = 0;
+   return VC_CONTAINER_SUCCESS;
+}
+
 /*****************************************************************************/
 int64_t vc_container_writer_extraio_disable(VC_CONTAINER_T *context, VC_CONTAINER_WRITER_EXTRAIO_T *extraio)
 {
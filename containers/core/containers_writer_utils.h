@@ -85,12 +85,24 @@ typedef struct VC_CONTAINER_WRITER_EXTRAIO_T {
    VC_CONTAINER_IO_T *io;
    unsigned int refcount;
    bool temp;
+   int64_t checkpoint_dirty;    /**< Bytes appended since the last sync to storage */
+   int64_t checkpoint_interval; /**< Dirty window triggering a sync, 0 to disable */
 } VC_CONTAINER_WRITER_EXTRAIO_T;
 
+/** Default bound on the amount of index data which can be lost by a crash */
+#define VC_CONTAINER_WRITER_EXTRAIO_CHECKPOINT_DEFAULT (256*1024)
+
 VC_CONTAINER_STATUS_T vc_container_writer_extraio_create_null(VC_CONTAINER_T *context, VC_CONTAINER_WRITER_EXTRAIO_T *null);
 VC_CONTAINER_STATUS_T vc_container_writer_extraio_create_temp(VC_CONTAINER_T *context, VC_CONTAINER_WRITER_EXTRAIO_T *null);
 VC_CONTAINER_STATUS_T vc_container_writer_extraio_delete(VC_CONTAINER_T *context, VC_CONTAINER_WRITER_EXTRAIO_T *null);
 int64_t vc_container_writer_extraio_enable(VC_CONTAINER_T *context, VC_CONTAINER_WRITER_EXTRAIO_T *null);
 int64_t vc_container_writer_extraio_disable(VC_CONTAINER_T *context, VC_CONTAINER_WRITER_EXTRAIO_T *null);
 
+/** Account for bytes appended to an extra i/o and, once the dirty window
+ * configured in checkpoint_interval has filled, flush them through to durable
+ * storage. Lets writers keep their temporary index crash-recoverable without
+ * paying a sync per sample. */
+VC_CONTAINER_STATUS_T vc_container_writer_extraio_checkpoint(VC_CONTAINER_T *context,
+   VC_CONTAINER_WRITER_EXTRAIO_T *extraio, int64_t bytes);
+
 #endif /* VC_CONTAINERS_WRITER_UTILS_H */
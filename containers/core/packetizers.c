@@ -34,6 +34,9 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "containers/core/containers_logging.h"
 #include "containers/core/containers_utils.h"
 
+/** Chunk size of the arena the per-packet internal copies come from */
+#define PACKETIZER_ARENA_CHUNK_SIZE (64*1024)
+
 /** List of registered packetizers. */
 static VC_PACKETIZER_REGISTRY_ENTRY_T *registry;
 
@@ -82,6 +85,12 @@ VC_PACKETIZER_T *vc_packetizer_open( VC_CONTAINER_ES_FORMAT_T *in,
    p_ctx->priv = (VC_PACKETIZER_PRIVATE_T *)(p_ctx + 1);
    bytestream_init( &p_ctx->priv->stream );
 
+   /* The internal copies of the input packets made by vc_packetizer_pop are
+    * created and released once per packet, so they come from an arena instead
+    * of hammering malloc */
+   p_ctx->priv->arena = vc_container_arena_create(PACKETIZER_ARENA_CHUNK_SIZE);
+   if(!p_ctx->priv->arena) { status = VC_CONTAINER_ERROR_OUT_OF_MEMORY; goto error; }
+
    p_ctx->in = vc_container_format_create(in->extradata_size);
    if(!p_ctx->in) { status = VC_CONTAINER_ERROR_OUT_OF_MEMORY; goto error; }
    p_ctx->out = vc_container_format_create(in->extradata_size);
@@ -130,8 +139,9 @@ VC_CONTAINER_STATUS_T vc_packetizer_close( VC_PACKETIZER_T *p_ctx )
    for(packet = stream->first; packet; packet = next)
    {
       next = packet->next;
-      if(packet->framework_data) free(packet);
+      if(packet->framework_data) vc_container_arena_free(p_ctx->priv->arena, packet);
    }
+   vc_container_arena_destroy(p_ctx->priv->arena);
 
    free(p_ctx);
    return VC_CONTAINER_SUCCESS;
@@ -160,7 +170,7 @@ VC_CONTAINER_STATUS_T vc_packetizer_pop( VC_PACKETIZER_T *p_ctx,
    {
       if(*in && (*in)->framework_data)
       {
-         free(*in);
+         vc_container_arena_free(p_ctx->priv->arena, *in);
          continue;
       }
 
@@ -178,10 +188,10 @@ VC_CONTAINER_STATUS_T vc_packetizer_pop( VC_PACKETIZER_T *p_ctx,
    if (!packet || (packet && packet->framework_data))
       return VC_CONTAINER_ERROR_INCOMPLETE_DATA;
 
-   /* We'll currently alloc an internal packet for each packet the client forcefully releases.
-    * We could probably do something a bit more clever than that though. */
+   /* We alloc an internal packet for each packet the client forcefully releases.
+    * The arena recycles them so this doesn't involve malloc in steady state. */
    /* Replace the packet with a newly allocated one */
-   new = malloc(sizeof(*packet) + packet->size);
+   new = vc_container_arena_alloc(p_ctx->priv->arena, sizeof(*packet) + packet->size);
    if(!new)
       return VC_CONTAINER_ERROR_OUT_OF_MEMORY;
 
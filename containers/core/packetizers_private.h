@@ -34,6 +34,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <stdarg.h>
 #include "containers/packetizers.h"
 #include "containers/core/containers_common.h"
+#include "containers/core/containers_arena.h"
 #include "containers/core/containers_bytestream.h"
 #include "containers/core/containers_time.h"
 
@@ -81,6 +82,9 @@ typedef struct VC_PACKETIZER_PRIVATE_T
    /** Pointer to the packetizer module code and symbols*/
    void *module_handle;
 
+   /** Arena the per-packet internal copies are allocated from */
+   struct VC_CONTAINER_ARENA_T *arena;
+
    /** Temporary packet structure used when the caller does not provide one */
    VC_CONTAINER_PACKET_T packet;
 
@@ -56,9 +56,13 @@ Defines.
 #define FLV_SCRIPT_DATA_TYPE_NUMBER      0
 #define FLV_SCRIPT_DATA_TYPE_BOOL        1
 #define FLV_SCRIPT_DATA_TYPE_STRING      2
+#define FLV_SCRIPT_DATA_TYPE_OBJECT      3
 #define FLV_SCRIPT_DATA_TYPE_ECMA        8
+#define FLV_SCRIPT_DATA_TYPE_STRICTARRAY 10
 #define FLV_SCRIPT_DATA_TYPE_LONGSTRING 12
 
+#define MAX_METADATA_STRING_SIZE 25
+
 #define FLV_FLAG_DISCARD    1
 #define FLV_FLAG_KEYFRAME   2
 #define FLV_FLAG_INTERFRAME 4
@@ -327,6 +331,90 @@ static VC_CONTAINER_STATUS_T flv_read_audiodata_properties(VC_CONTAINER_T *p_ctx
    return STREAM_STATUS(p_ctx);
 }
 
+/** Convert the 64-bit pattern of a script data number (an IEEE double) into
+  * a double using integer arithmetic only */
+static double flv_script_data_number(uint64_t u_value)
+{
+   int64_t value = ((u_value & ((UINT64_C(1)<<52)-1)) + (UINT64_C(1)<<52)) * ((((int64_t)u_value)>>63)|1);
+   int exp = ((u_value>>52)&0x7FF)-1075 + 16;
+   if(exp >= 0) value <<= exp;
+   else value >>= -exp;
+   return ((double)value) / (1 << 16);
+}
+
+/** Reads the keyframe index from the 'keyframes' script data object.
+  * This object contains two strict arrays, 'filepositions' and 'times',
+  * listing the file offset and timestamp of every keyframe in the stream.
+  * They are fed into our seek index so that seeking doesn't have to find
+  * keyframes by scanning tags linearly.
+  *
+  * @param p_ctx              pointer to our context
+  * @param p_size             size left in the containing tag, updated as we read
+  * @return                   VC_CONTAINER_SUCCESS on success
+  */
+static int flv_read_keyframe_index(VC_CONTAINER_T *p_ctx, int *p_size)
+{
+   VC_CONTAINER_MODULE_T *module = p_ctx->priv->module;
+   char psz_string[MAX_METADATA_STRING_SIZE+1];
+   double *times = 0, *positions = 0, **p_array;
+   uint32_t times_count = 0, positions_count = 0, count, i;
+   uint16_t length;
+   uint8_t type;
+
+   while(*p_size >= 3)
+   {
+      length = _READ_U16(p_ctx); *p_size -= 2;
+      if(!length) /* end of object marker */
+      {
+         _READ_U8(p_ctx); (*p_size)--;
+         break;
+      }
+      if(length >= *p_size || length > MAX_METADATA_STRING_SIZE) goto end;
+      if(READ_BYTES(p_ctx, psz_string, length) != length) goto end;
+      psz_string[length] = 0; *p_size -= length;
+      type = _READ_U8(p_ctx); (*p_size)--;
+
+      /* The index is made up of strict arrays of numbers, anything else
+         and we bail out */
+      if(type != FLV_SCRIPT_DATA_TYPE_STRICTARRAY || *p_size < 4) goto end;
+      count = _READ_U32(p_ctx); *p_size -= 4;
+      if(count > (uint32_t)*p_size / 9) goto end;
+
+      if(!strcmp(psz_string, "times")) p_array = &times;
+      else if(!strcmp(psz_string, "filepositions")) p_array = &positions;
+      else p_array = 0;
+
+      if(p_array)
+      {
+         *p_array = malloc(count * sizeof(**p_array));
+         if(!*p_array) goto end;
+      }
+
+      for(i = 0; i < count; i++)
+      {
+         uint64_t u_value;
+         type = _READ_U8(p_ctx); (*p_size)--;
+         if(type != FLV_SCRIPT_DATA_TYPE_NUMBER || *p_size < 8) goto end;
+         u_value = _READ_U64(p_ctx); *p_size -= 8;
+         if(p_array) (*p_array)[i] = flv_script_data_number(u_value);
+      }
+
+      if(p_array == &times) times_count = count;
+      else if(p_array == &positions) positions_count = count;
+   }
+
+   /* We need both arrays to agree before we can trust them */
+   if(module->state.index && times && positions && times_count == positions_count)
+      for(i = 0; i < times_count; i++)
+         vc_container_index_add(module->state.index,
+            (int64_t)(times[i] * 1000000.0), (int64_t)positions[i]);
+
+ end:
+   if(times) free(times);
+   if(positions) free(positions);
+   return STREAM_STATUS(p_ctx);
+}
+
 /** Reads an FLV metadata tag.
   * This contains metadata information about the stream.
   * All the data we extract from this will be placed directly in the context.
@@ -338,7 +426,6 @@ static VC_CONTAINER_STATUS_T flv_read_audiodata_properties(VC_CONTAINER_T *p_ctx
 static int flv_read_metadata(VC_CONTAINER_T *p_ctx, int size)
 {
    VC_CONTAINER_MODULE_T *module = p_ctx->priv->module;
-#define MAX_METADATA_STRING_SIZE 25
    char psz_string[MAX_METADATA_STRING_SIZE+1];
    uint16_t length, num_values;
    double f_value;
@@ -374,14 +461,7 @@ static int flv_read_metadata(VC_CONTAINER_T *p_ctx, int size)
          if(size < 8) return VC_CONTAINER_SUCCESS;
 
          u_value = _READ_U64(p_ctx); size -= 8;
-         /* Convert value into a double */
-         {
-            int64_t value = ((u_value & ((UINT64_C(1)<<52)-1)) + (UINT64_C(1)<<52)) * ((((int64_t)u_value)>>63)|1);
-            int exp = ((u_value>>52)&0x7FF)-1075 + 16;
-            if(exp >= 0) value <<= exp;
-            else value >>= -exp;
-            f_value = ((double)value) / (1 << 16);
-         }
+         f_value = flv_script_data_number(u_value);
 
          LOG_DEBUG(p_ctx, "metadata (%s=%i.%i)", psz_string,
                    ((int)(f_value*100))/100, ((int)(f_value*100))%100);
@@ -415,6 +495,18 @@ static int flv_read_metadata(VC_CONTAINER_T *p_ctx, int size)
          LOG_DEBUG(p_ctx, "metadata skipping (%s)", psz_string);
          continue;
 
+      case FLV_SCRIPT_DATA_TYPE_OBJECT:
+         /* The only object we know how to make use of is the keyframe index */
+         if(!strcmp(psz_string, "keyframes"))
+         {
+            if(flv_read_keyframe_index(p_ctx, &size) != VC_CONTAINER_SUCCESS)
+               return VC_CONTAINER_SUCCESS;
+            continue;
+         }
+         /* We can't skip over an object we don't know the layout of */
+         LOG_DEBUG(p_ctx, "unknown amf object (%s)", psz_string);
+         return VC_CONTAINER_SUCCESS;
+
       /* We can't cope with anything else */
       default:
          LOG_DEBUG(p_ctx, "unknown amf type (%s,%i)", psz_string, type);
@@ -1032,6 +1124,14 @@ VC_CONTAINER_STATUS_T flv_reader_open( VC_CONTAINER_T *p_ctx )
    /* Skip to the start of the actual data */
    SKIP_BYTES(p_ctx, data_offset - 9);
 
+   /* Try and create an index before we start parsing tags, so that a keyframe
+    * index found in the metadata can be stored in it.  All times are signed, so
+    * adding a base timestamp of zero means that we will always seek back to the
+    * start of the file, even if the actual frame timestamps start at some
+    * higher number. */
+   if(vc_container_index_create(&module->state.index, 512) == VC_CONTAINER_SUCCESS)
+      vc_container_index_add(module->state.index, 0LL, (int64_t) data_offset);
+
    /* We'll start parsing a few of the FLV tags to find out the
     * metadata / audio / video properties.
     * The first tag we should see is the metadata one which will give us all the
@@ -1109,12 +1209,6 @@ VC_CONTAINER_STATUS_T flv_reader_open( VC_CONTAINER_T *p_ctx )
    /* Make sure we found something we can play */
    if(!p_ctx->tracks_num) {LOG_DEBUG(p_ctx, "didn't find any track"); goto error;}
 
-   /* Try and create an index.  All times are signed, so adding a base timestamp
-    * of zero means that we will always seek back to the start of the file, even if
-    * the actual frame timestamps start at some higher number. */
-   if(vc_container_index_create(&module->state.index, 512) == VC_CONTAINER_SUCCESS)
-      vc_container_index_add(module->state.index, 0LL, (int64_t) data_offset);
-
    /* Use the metadata we read */
    if(module->audio_track >= 0)
    {
@@ -35,6 +35,16 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "containers/core/containers_io.h"
 #include "containers/core/containers_uri.h"
 
+#ifdef ENABLE_CONTAINER_IO_WRITEV
+# include <sys/uio.h>
+# define IO_FILE_IOVEC_MAX 16
+#endif
+
+#if !defined(_VIDEOCORE) && !defined(WIN32)
+# define IO_FILE_HAVE_FSYNC
+# include <unistd.h>
+#endif
+
 typedef struct VC_CONTAINER_IO_MODULE_T
 {
    FILE *stream;
@@ -74,6 +84,68 @@ static size_t io_file_write(VC_CONTAINER_IO_T *p_ctx, const void *buffer, size_t
    return fwrite(buffer, 1, size, p_ctx->module->stream);
 }
 
+/*****************************************************************************/
+#ifdef ENABLE_CONTAINER_IO_WRITEV
+static size_t io_file_writev(VC_CONTAINER_IO_T *p_ctx,
+   const VC_CONTAINER_IO_VEC_T *vec, unsigned int num)
+{
+   size_t total = 0;
+
+   /* The stream is unbuffered so the file descriptor offset is in sync
+    * with the stream position and we can write to it directly */
+   while(num)
+   {
+      struct iovec iov[IO_FILE_IOVEC_MAX];
+      unsigned int i, batch = num > IO_FILE_IOVEC_MAX ? IO_FILE_IOVEC_MAX : num;
+      size_t batch_size = 0;
+      ssize_t ret;
+
+      for(i = 0; i < batch; i++)
+      {
+         iov[i].iov_base = (void *)(uintptr_t)vec[i].buffer;
+         iov[i].iov_len = vec[i].size;
+         batch_size += vec[i].size;
+      }
+
+      ret = writev(fileno(p_ctx->module->stream), iov, batch);
+      if(ret < 0)
+         break;
+      total += ret;
+      if((size_t)ret != batch_size)
+         break;
+
+      vec += batch;
+      num -= batch;
+   }
+   return total;
+}
+#endif /* ENABLE_CONTAINER_IO_WRITEV */
+
+/*****************************************************************************/
+static VC_CONTAINER_STATUS_T io_file_control(VC_CONTAINER_IO_T *p_ctx,
+   VC_CONTAINER_CONTROL_T operation, va_list args)
+{
+   VC_CONTAINER_PARAM_UNUSED(args);
+
+   switch(operation)
+   {
+   case VC_CONTAINER_CONTROL_IO_SYNC:
+      /* The stream is unbuffered so only the kernel's write-back cache needs
+       * pushing to storage */
+#ifdef IO_FILE_HAVE_FSYNC
+      if(fsync(fileno(p_ctx->module->stream)))
+         return VC_CONTAINER_ERROR_FAILED;
+      return VC_CONTAINER_SUCCESS;
+#else
+      if(fflush(p_ctx->module->stream))
+         return VC_CONTAINER_ERROR_FAILED;
+      return VC_CONTAINER_SUCCESS;
+#endif
+   default:
+      return VC_CONTAINER_ERROR_UNSUPPORTED_OPERATION;
+   }
+}
+
 /*****************************************************************************/
 static VC_CONTAINER_STATUS_T io_file_seek(VC_CONTAINER_IO_T *p_ctx, int64_t offset)
 {
@@ -131,7 +203,11 @@ VC_CONTAINER_STATUS_T vc_container_io_file_open( VC_CONTAINER_IO_T *p_ctx,
    p_ctx->pf_close = io_file_close;
    p_ctx->pf_read = io_file_read;
    p_ctx->pf_write = io_file_write;
+#ifdef ENABLE_CONTAINER_IO_WRITEV
+   p_ctx->pf_writev = io_file_writev;
+#endif
    p_ctx->pf_seek = io_file_seek;
+   p_ctx->pf_control = io_file_control;
 
    if(mode == VC_CONTAINER_IO_MODE_WRITE)
    {
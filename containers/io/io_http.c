@@ -110,6 +110,9 @@ typedef struct VC_CONTAINER_IO_MODULE_T
    int64_t cur_offset;
    bool reconnecting;
 
+   int64_t pipeline_offset;   /**< Offset of the in-flight pipelined request, -1 if none */
+   size_t pipeline_size;      /**< Size of the in-flight pipelined request */
+
    /* Buffer used for sending and receiving HTTP messages */
    char comms_buffer[COMMS_BUFFER_SIZE];
 } VC_CONTAINER_IO_MODULE_T;
@@ -496,7 +499,8 @@ static VC_CONTAINER_STATUS_T io_http_read_response(VC_CONTAINER_IO_T *p_ctx)
  * @param p_ctx      The reader context.
  * @return  The resulting status of the function.
  */
-static VC_CONTAINER_STATUS_T io_http_send_get_request(VC_CONTAINER_IO_T *p_ctx, size_t size)
+static VC_CONTAINER_STATUS_T io_http_send_get_request(VC_CONTAINER_IO_T *p_ctx,
+   int64_t offset, size_t size)
 {
    VC_CONTAINER_IO_MODULE_T *module = p_ctx->module;
    char *ptr = module->comms_buffer, *end = ptr + sizeof(module->comms_buffer);
@@ -505,12 +509,12 @@ static VC_CONTAINER_STATUS_T io_http_send_get_request(VC_CONTAINER_IO_T *p_ctx,
    ptr += snprintf(ptr, end - ptr, HTTP_REQUEST_LINE_FORMAT, GET_METHOD,
                    vc_uri_path(p_ctx->uri_parts), vc_uri_host(p_ctx->uri_parts));
 
-   end_offset = module->cur_offset + size - 1;
+   end_offset = offset + size - 1;
    if (end_offset >= p_ctx->size)
       end_offset = p_ctx->size - 1;
 
    if (ptr < end)
-      ptr += snprintf(ptr, end - ptr, HTTP_RANGE_REQUEST, module->cur_offset, end_offset);
+      ptr += snprintf(ptr, end - ptr, HTTP_RANGE_REQUEST, offset, end_offset);
 
    if (ptr < end)
       ptr += snprintf(ptr, end - ptr, TRAILING_HEADERS_FORMAT);
@@ -575,6 +579,7 @@ static size_t io_http_read(VC_CONTAINER_IO_T *p_ctx, void *buffer, size_t size)
    size_t bytes_read;
    size_t ret = 0;
    char *ptr = buffer;
+   bool pipelined;
 
    /*
     * Are we at the end of the file?
@@ -586,7 +591,16 @@ static size_t io_http_read(VC_CONTAINER_IO_T *p_ctx, void *buffer, size_t size)
       return 0;
    }
 
-   if (!module->persistent)
+   /* Check whether a pipelined request matching this read is already in
+    * flight. If one is in flight but doesn't match (e.g. after a seek), drop
+    * the connection rather than draining the unwanted response. */
+   pipelined = module->sock && module->pipeline_offset == module->cur_offset &&
+      module->pipeline_size == size;
+   if (module->pipeline_offset >= 0 && !pipelined)
+      io_http_close_socket(module);
+   module->pipeline_offset = -1;
+
+   if (!module->sock)
    {
       status = io_http_open_socket(p_ctx);
       if (status != VC_CONTAINER_SUCCESS)
@@ -597,11 +611,14 @@ static size_t io_http_read(VC_CONTAINER_IO_T *p_ctx, void *buffer, size_t size)
    }
 
    /* Send GET request and get response */
-   status = io_http_send_get_request(p_ctx, size);
-   if (status != VC_CONTAINER_SUCCESS)
+   if (!pipelined)
    {
-      LOG_ERROR(NULL, "Error sending GET request");
-      goto error;
+      status = io_http_send_get_request(p_ctx, module->cur_offset, size);
+      if (status != VC_CONTAINER_SUCCESS)
+      {
+         LOG_ERROR(NULL, "Error sending GET request");
+         goto error;
+      }
    }
 
    status = io_http_read_response(p_ctx);
@@ -655,7 +672,21 @@ static size_t io_http_read(VC_CONTAINER_IO_T *p_ctx, void *buffer, size_t size)
    }
 
    if (!module->persistent)
+   {
       io_http_close_socket(module);
+      return ret;
+   }
+
+   /* Pipeline a request for the next range on the persistent connection so
+    * that the response is already on its way while the caller processes this
+    * block. Sequential reads then only pay the round trip once. */
+   if (p_ctx->status == VC_CONTAINER_SUCCESS && module->cur_offset < p_ctx->size &&
+       io_http_send_get_request(p_ctx, module->cur_offset, size) == VC_CONTAINER_SUCCESS)
+   {
+      module->pipeline_offset = module->cur_offset;
+      module->pipeline_size = size;
+      p_ctx->status = VC_CONTAINER_SUCCESS;
+   }
 
    return ret;
 
@@ -852,6 +883,7 @@ VC_CONTAINER_STATUS_T vc_container_io_http_open(VC_CONTAINER_IO_T *p_ctx,
       goto error;
    }
    p_ctx->module = module;
+   module->pipeline_offset = -1;
 
    /* header_list will contain pointers into the response_buffer, so take care in re-use */
    module->header_list = vc_containers_list_create(HEADER_LIST_INITIAL_CAPACITY, sizeof(HTTP_HEADER_T),
@@ -0,0 +1,167 @@
+/*
+Copyright (c) 2012, Broadcom Europe Ltd
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/* Memory-mapped file i/o. Read-only alternative to io_file.c which serves
+ * reads straight out of the page cache, avoiding the syscall and stdio
+ * buffer copy per access. Seeks are just a pointer update so indexed
+ * seeking in large files is essentially free. */
+
+/* posix_madvise() needs a newer feature test level than the containers
+ * build sets globally */
+#undef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "containers/containers.h"
+#include "containers/core/containers_common.h"
+#include "containers/core/containers_io.h"
+#include "containers/core/containers_uri.h"
+
+typedef struct VC_CONTAINER_IO_MODULE_T
+{
+   int fd;
+   uint8_t *map;      /**< Base address of the file mapping */
+   size_t map_size;   /**< Size of the file mapping */
+   size_t position;   /**< Current read position in the mapping */
+
+} VC_CONTAINER_IO_MODULE_T;
+
+VC_CONTAINER_STATUS_T vc_container_io_mmap_open( VC_CONTAINER_IO_T *, const char *,
+   VC_CONTAINER_IO_MODE_T );
+
+/*****************************************************************************/
+static VC_CONTAINER_STATUS_T io_mmap_close( VC_CONTAINER_IO_T *p_ctx )
+{
+   VC_CONTAINER_IO_MODULE_T *module = p_ctx->module;
+   munmap(module->map, module->map_size);
+   close(module->fd);
+   free(module);
+   return VC_CONTAINER_SUCCESS;
+}
+
+/*****************************************************************************/
+static size_t io_mmap_read(VC_CONTAINER_IO_T *p_ctx, void *buffer, size_t size)
+{
+   VC_CONTAINER_IO_MODULE_T *module = p_ctx->module;
+   size_t bytes = module->map_size - module->position;
+
+   if(bytes > size) bytes = size;
+   if(bytes) memcpy(buffer, module->map + module->position, bytes);
+   module->position += bytes;
+
+   if(bytes != size) p_ctx->status = VC_CONTAINER_ERROR_EOS;
+   return bytes;
+}
+
+/*****************************************************************************/
+static VC_CONTAINER_STATUS_T io_mmap_seek(VC_CONTAINER_IO_T *p_ctx, int64_t offset)
+{
+   VC_CONTAINER_IO_MODULE_T *module = p_ctx->module;
+
+   if(offset < 0 || offset > (int64_t)module->map_size)
+   {
+      p_ctx->status = VC_CONTAINER_ERROR_EOS;
+      return VC_CONTAINER_ERROR_EOS;
+   }
+
+   module->position = (size_t)offset;
+   p_ctx->status = VC_CONTAINER_SUCCESS;
+   return VC_CONTAINER_SUCCESS;
+}
+
+/*****************************************************************************/
+VC_CONTAINER_STATUS_T vc_container_io_mmap_open( VC_CONTAINER_IO_T *p_ctx,
+   const char *unused, VC_CONTAINER_IO_MODE_T mode )
+{
+   VC_CONTAINER_STATUS_T status;
+   VC_CONTAINER_IO_MODULE_T *module = 0;
+   const char *uri = p_ctx->uri;
+   struct stat st;
+   uint8_t *map = MAP_FAILED;
+   int fd = -1;
+   VC_CONTAINER_PARAM_UNUSED(unused);
+
+   /* Mapping is only for reading existing files */
+   if(mode != VC_CONTAINER_IO_MODE_READ)
+      return VC_CONTAINER_ERROR_URI_NOT_FOUND;
+
+   if(vc_uri_path(p_ctx->uri_parts))
+      uri = vc_uri_path(p_ctx->uri_parts);
+
+   fd = open(uri, O_RDONLY);
+   if(fd < 0) { status = VC_CONTAINER_ERROR_URI_NOT_FOUND; goto error; }
+
+   if(fstat(fd, &st) || !S_ISREG(st.st_mode) || !st.st_size ||
+      (int64_t)st.st_size != (int64_t)(size_t)st.st_size)
+   {
+      /* Not a regular file, empty, or too big for the address space.
+       * Let the stdio backend deal with it. */
+      status = VC_CONTAINER_ERROR_URI_NOT_FOUND;
+      goto error;
+   }
+
+   map = mmap(0, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+   if(map == MAP_FAILED) { status = VC_CONTAINER_ERROR_URI_NOT_FOUND; goto error; }
+
+   /* Linear demux is the common case so ask the kernel to read ahead
+    * aggressively. This is only a hint and does not hurt indexed seeking. */
+   posix_madvise(map, (size_t)st.st_size, POSIX_MADV_SEQUENTIAL);
+   posix_madvise(map, (size_t)st.st_size, POSIX_MADV_WILLNEED);
+
+   module = malloc( sizeof(*module) );
+   if(!module) { status = VC_CONTAINER_ERROR_OUT_OF_MEMORY; goto error; }
+   memset(module, 0, sizeof(*module));
+
+   p_ctx->module = module;
+   module->fd = fd;
+   module->map = map;
+   module->map_size = (size_t)st.st_size;
+   p_ctx->pf_close = io_mmap_close;
+   p_ctx->pf_read = io_mmap_read;
+   p_ctx->pf_write = 0;
+   p_ctx->pf_seek = io_mmap_seek;
+
+   p_ctx->size = st.st_size;
+
+   /* Reads come straight out of the page cache so there is no point in the
+    * core adding its own cache on top (NO_CACHING deliberately not set) */
+   p_ctx->capabilities = 0;
+   return VC_CONTAINER_SUCCESS;
+
+ error:
+   if(map != MAP_FAILED) munmap(map, (size_t)st.st_size);
+   if(fd >= 0) close(fd);
+   return status;
+}
@@ -67,12 +67,23 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 Defines and constants.
 ******************************************************************************/
 
+/** Number of datagrams picked up from the socket by one batched receive. */
+#define IO_NET_READ_BATCH_SIZE      32
+
+/** Size of each buffer in the datagram pool. Needs to be large enough for the
+ * biggest packet expected by the readers using this interface. */
+#define IO_NET_POOL_PACKET_SIZE     2048
+
 /******************************************************************************
 Type definitions
 ******************************************************************************/
 typedef struct VC_CONTAINER_IO_MODULE_T
 {
    VC_CONTAINER_NET_T *sock;
+   uint8_t *pool;             /**< Preallocated datagram buffers, NULL when reads are unbatched */
+   VC_CONTAINER_NET_DATAGRAM_T datagrams[IO_NET_READ_BATCH_SIZE];
+   unsigned int pool_count;   /**< Number of datagrams currently in the pool */
+   unsigned int pool_index;   /**< Next pooled datagram to be handed out */
 #ifdef IO_NET_CAPTURE_PACKETS
    FILE *read_capture_file;
    FILE *write_capture_file;
@@ -222,6 +233,8 @@ static VC_CONTAINER_STATUS_T io_net_close( VC_CONTAINER_IO_T *p_ctx )
 
    if (module->sock)
       vc_container_net_close(module->sock);
+   if (module->pool)
+      free(module->pool);
 #ifdef IO_NET_CAPTURE_PACKETS
    if (module->read_capture_file)
       fclose(module->read_capture_file);
@@ -237,10 +250,51 @@ static VC_CONTAINER_STATUS_T io_net_close( VC_CONTAINER_IO_T *p_ctx )
 /*****************************************************************************/
 static size_t io_net_read(VC_CONTAINER_IO_T *p_ctx, void *buffer, size_t size)
 {
-   size_t ret = vc_container_net_read(p_ctx->module->sock, buffer, size);
+   VC_CONTAINER_IO_MODULE_T *module = p_ctx->module;
    vc_container_net_status_t net_status;
+   size_t ret;
 
-   net_status = vc_container_net_status(p_ctx->module->sock);
+   if (module->pool)
+   {
+      if (module->pool_index == module->pool_count)
+      {
+         unsigned int i;
+
+         /* Pool exhausted, pick up another batch of datagrams in one go */
+         for (i = 0; i < IO_NET_READ_BATCH_SIZE; i++)
+         {
+            module->datagrams[i].buffer = module->pool + i * IO_NET_POOL_PACKET_SIZE;
+            module->datagrams[i].size = IO_NET_POOL_PACKET_SIZE;
+         }
+         module->pool_count = vc_container_net_read_batch(module->sock,
+               module->datagrams, IO_NET_READ_BATCH_SIZE);
+         module->pool_index = 0;
+         if (!module->pool_count)
+         {
+            net_status = vc_container_net_status(module->sock);
+            p_ctx->status = translate_net_status_to_container_status(net_status);
+            return 0;
+         }
+      }
+
+      /* Hand out the next pooled datagram, truncating it if necessary */
+      ret = module->datagrams[module->pool_index].size;
+      if (ret > size)
+         ret = size;
+      memcpy(buffer, module->datagrams[module->pool_index].buffer, ret);
+      module->pool_index++;
+      p_ctx->status = VC_CONTAINER_SUCCESS;
+
+#ifdef IO_NET_CAPTURE_PACKETS
+      io_net_capture_write_packet(module->read_capture_file, (const char *)buffer, ret);
+#endif
+
+      return ret;
+   }
+
+   ret = vc_container_net_read(module->sock, buffer, size);
+
+   net_status = vc_container_net_status(module->sock);
    p_ctx->status = translate_net_status_to_container_status(net_status);
 
 #ifdef IO_NET_CAPTURE_PACKETS
@@ -363,6 +417,12 @@ VC_CONTAINER_STATUS_T vc_container_io_net_open( VC_CONTAINER_IO_T *p_ctx,
    if (status != VC_CONTAINER_SUCCESS)
       goto error;
 
+   /* Batch datagram reads through a preallocated packet pool, so that many
+    * packets are picked up per socket operation. If the allocation fails,
+    * just fall back on one datagram per read. */
+   if (is_udp && mode == VC_CONTAINER_IO_MODE_READ)
+      module->pool = (uint8_t *)malloc(IO_NET_READ_BATCH_SIZE * IO_NET_POOL_PACKET_SIZE);
+
    p_ctx->pf_close = io_net_close;
    p_ctx->pf_read = io_net_read;
    p_ctx->pf_write = io_net_write;
@@ -77,10 +77,11 @@ VC_CONTAINER_STATUS_T vc_container_io_null_open( VC_CONTAINER_IO_T *p_ctx,
    VC_CONTAINER_PARAM_UNUSED(unused);
    VC_CONTAINER_PARAM_UNUSED(mode);
 
-   /* Check the URI */
+   /* Check the URI. The "rtppush" scheme is used by readers which are handed
+    * their data by another container and thus need no i/o of their own. */
    if (!vc_uri_scheme(p_ctx->uri_parts) ||
        (strcasecmp(vc_uri_scheme(p_ctx->uri_parts), "null") &&
-        strcasecmp(vc_uri_scheme(p_ctx->uri_parts), "null")))
+        strcasecmp(vc_uri_scheme(p_ctx->uri_parts), "rtppush")))
       return VC_CONTAINER_ERROR_FORMAT_NOT_SUPPORTED;
 
    p_ctx->pf_close = io_null_close;
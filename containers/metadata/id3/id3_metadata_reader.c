@@ -32,6 +32,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 //#define ENABLE_CONTAINERS_LOG_FORMAT
 //#define ENABLE_CONTAINERS_LOG_FORMAT_VERBOSE
 #define CONTAINER_HELPER_LOG_INDENT(a) 0
+#include "vcos.h"
 #include "containers/core/containers_private.h"
 #include "containers/core/containers_io_helpers.h"
 #include "containers/core/containers_utils.h"
@@ -44,7 +45,10 @@ Defines
 ******************************************************************************/
 #define ID3_SYNC_SAFE(x) ((((x >> 24) & 0x7f) << 21) | (((x >> 16) & 0x7f) << 14) | \
                           (((x >>  8) & 0x7f) <<  7) | (((x >>  0) & 0x7f) <<  0))
-      
+
+#define ID3_INTERN_POOL_ENTRIES 64 /**< Maximum number of interned tag values */
+#define ID3_INTERN_VALUE_MAX 128   /**< Values longer than this are not interned */
+
 /******************************************************************************
 Type definitions
 ******************************************************************************/
@@ -57,6 +61,61 @@ VC_CONTAINER_STATUS_T id3_metadata_reader_open( VC_CONTAINER_T * );
 /******************************************************************************
 Local Functions
 ******************************************************************************/
+
+/** Process-wide pool of interned tag values. Artist and genre strings repeat
+ * across the files of a music library so a single copy of each value is kept
+ * for the lifetime of the process and shared between containers. Opens can
+ * run concurrently so the pool is guarded by a mutex, created on first use;
+ * if that fails, nothing is interned and every entry keeps its own copy. */
+static struct
+{
+   unsigned int num;
+   char *values[ID3_INTERN_POOL_ENTRIES];
+} id3_intern_pool;
+
+static VCOS_ONCE_T id3_intern_once = VCOS_ONCE_INIT;
+static VCOS_MUTEX_T id3_intern_lock;
+static bool id3_intern_lock_ok;
+
+static void id3_intern_lock_init( void )
+{
+   id3_intern_lock_ok =
+      vcos_mutex_create(&id3_intern_lock, "id3_intern") == VCOS_SUCCESS;
+}
+
+/*****************************************************************************/
+static const char *id3_intern_value( const char *value )
+{
+   unsigned int i;
+   char *copy = NULL;
+
+   vcos_once(&id3_intern_once, id3_intern_lock_init);
+   if (!id3_intern_lock_ok)
+      return NULL;
+
+   vcos_mutex_lock(&id3_intern_lock);
+   for (i = 0; i < id3_intern_pool.num; i++)
+      if (!strcmp(id3_intern_pool.values[i], value))
+      {
+         copy = id3_intern_pool.values[i];
+         goto end;
+      }
+
+   /* When the pool is full, values are stored in the entries themselves */
+   if (id3_intern_pool.num == countof(id3_intern_pool.values))
+      goto end;
+
+   if ((copy = malloc(strlen(value) + 1)) == NULL)
+      goto end;
+   strcpy(copy, value);
+   id3_intern_pool.values[id3_intern_pool.num++] = copy;
+
+ end:
+   vcos_mutex_unlock(&id3_intern_lock);
+   return copy;
+}
+
+/*****************************************************************************/
 static VC_CONTAINER_METADATA_T *id3_metadata_append( VC_CONTAINER_T *p_ctx,
                                                      VC_CONTAINER_METADATA_KEY_T key,
                                                      unsigned int size )
@@ -178,7 +237,28 @@ static VC_CONTAINER_METADATA_T *id3_add_metadata_entry( VC_CONTAINER_T *p_ctx,
 }
 
 /*****************************************************************************/
-static VC_CONTAINER_STATUS_T id3_read_id3v2_frame( VC_CONTAINER_T *p_ctx, 
+static VC_CONTAINER_METADATA_T *id3_set_metadata_entry( VC_CONTAINER_T *p_ctx,
+   VC_CONTAINER_METADATA_KEY_T key, const char *value )
+{
+   const char *interned = id3_intern_value(value);
+   VC_CONTAINER_METADATA_T *meta;
+
+   if (!interned)
+      return id3_add_metadata_entry(p_ctx, key, value);
+
+   /* The entry just points at the interned value so no storage is allocated
+      for the value itself */
+   if ((meta = id3_metadata_append(p_ctx, key, 0)) != NULL)
+   {
+      meta->value = (char *)interned;
+      meta->size = strlen(interned) + 1;
+   }
+
+   return meta;
+}
+
+/*****************************************************************************/
+static VC_CONTAINER_STATUS_T id3_read_id3v2_frame( VC_CONTAINER_T *p_ctx,
    VC_CONTAINER_FOURCC_T frame_id, uint32_t frame_size )
 {
    VC_CONTAINER_STATUS_T status = VC_CONTAINER_SUCCESS;
@@ -186,6 +266,7 @@ static VC_CONTAINER_STATUS_T id3_read_id3v2_frame( VC_CONTAINER_T *p_ctx,
    VC_CONTAINER_METADATA_T *meta = NULL;
    uint8_t encoding;
    const char *charset = NULL;
+   char buffer[ID3_INTERN_VALUE_MAX];
 
    if(frame_size < 1) return VC_CONTAINER_ERROR_CORRUPTED;
 
@@ -224,6 +305,29 @@ static VC_CONTAINER_STATUS_T id3_read_id3v2_frame( VC_CONTAINER_T *p_ctx,
          return VC_CONTAINER_ERROR_FORMAT_NOT_SUPPORTED;
    }
 
+   /* Short artist and genre values go through the interning pool instead of
+      being stored in the entry itself */
+   if ((key == VC_CONTAINER_METADATA_KEY_ARTIST ||
+        key == VC_CONTAINER_METADATA_KEY_GENRE) &&
+       frame_size + 2 <= sizeof(buffer))
+   {
+      memset(buffer, 0, sizeof(buffer));
+      if (charset)
+      {
+         READ_STRING_UTF16(p_ctx, buffer, frame_size, "ID3v2 data");
+         utf8_from_charset(charset, buffer, sizeof(buffer), buffer, sizeof(buffer));
+      }
+      else
+      {
+         READ_STRING(p_ctx, buffer, frame_size, "ID3v2 data");
+      }
+
+      if ((meta = id3_set_metadata_entry(p_ctx, key, buffer)) != NULL)
+         meta->encoding = VC_CONTAINER_CHAR_ENCODING_UTF8;
+
+      return VC_CONTAINER_SUCCESS;
+   }
+
    if ((meta = id3_read_metadata_entry_ex(p_ctx, key, frame_size, charset)) != NULL)
    {
       if (charset)
@@ -344,12 +448,14 @@ static VC_CONTAINER_STATUS_T id3_read_id3v1_tag( VC_CONTAINER_T *p_ctx )
    VC_CONTAINER_STATUS_T status = VC_CONTAINER_SUCCESS;
    uint8_t track, genre;
    char track_num[4] = {0};
+   char artist[31] = {0};
 
    SKIP_STRING(p_ctx, 3, "ID3v1 identifier");
    /* ID3v1 title */
    id3_read_metadata_entry(p_ctx, VC_CONTAINER_METADATA_KEY_TITLE, 30);
-   /* ID3v1 artist */
-   id3_read_metadata_entry(p_ctx, VC_CONTAINER_METADATA_KEY_ARTIST, 30);
+   /* ID3v1 artist, interned since it repeats across files */
+   READ_STRING(p_ctx, artist, 30, "ID3v1 artist");
+   id3_set_metadata_entry(p_ctx, VC_CONTAINER_METADATA_KEY_ARTIST, artist);
    /* ID3v1 album */
    id3_read_metadata_entry(p_ctx, VC_CONTAINER_METADATA_KEY_ALBUM, 30);
    /* ID3v1 year */
@@ -368,7 +474,7 @@ static VC_CONTAINER_STATUS_T id3_read_id3v1_tag( VC_CONTAINER_T *p_ctx )
    genre = READ_U8(p_ctx, "ID3v1 genre");
    if (genre < countof(id3_genres))
    {
-      id3_add_metadata_entry(p_ctx, VC_CONTAINER_METADATA_KEY_GENRE, id3_genres[genre]);
+      id3_set_metadata_entry(p_ctx, VC_CONTAINER_METADATA_KEY_GENRE, id3_genres[genre]);
    }
 
    status = STREAM_STATUS(p_ctx);
@@ -34,6 +34,8 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "containers/core/containers_io_helpers.h"
 #include "containers/core/containers_utils.h"
 #include "containers/core/containers_logging.h"
+#include "containers/core/containers_index.h"
+#include "containers/core/containers_crc.h"
 
 /******************************************************************************
 Defines.
@@ -48,6 +50,7 @@ Defines.
 #define MKV_MAX_ELEMENT_LEVEL 8
 #define MKV_MAX_CONSECUTIVE_UNKNOWN_ELEMENTS 5
 #define MKV_MAX_ELEMENT_SIZE  (1<<29) /* Does not apply to the data element */
+#define MKV_CRC32_CHECK_MAX   (1<<16) /* CRC protected regions bigger than this are not verified */
 #define MKV_MAX_STRING_SIZE 256
 #define MKV_ELEMENT_MIN_HEADER_SIZE 2
 
@@ -305,6 +308,7 @@ typedef struct
    unsigned int flags;
    int64_t pts;
    int64_t cluster_timecode;
+   int64_t cluster_position; /* Offset to the start of the cluster being read */
    int64_t prev_cluster_size; /* Size of the previous cluster if available */
    int64_t frame_duration;
 
@@ -418,6 +422,9 @@ typedef struct VC_CONTAINER_MODULE_T
    uint64_t cues_offset; /**< Offset to the start of the seeking cues */
    uint64_t tags_offset; /**< Offset to the start of the tags */
 
+   VC_CONTAINER_INDEX_T *index; /**< Index of keyframes, used when the file has no cues */
+   bool index_dirty; /**< True if the index has grown since it was loaded / created */
+
    /*
     * Variables only used during parsing of the header
     */
@@ -434,6 +441,14 @@ typedef struct VC_CONTAINER_MODULE_T
    uint64_t cue_cluster_offset;
    unsigned int cue_block;
 
+   /*
+    * Whole-block delivery of laced frames
+    */
+
+   bool whole_block_delivery; /**< Deliver laced blocks as a single packet */
+   uint32_t lace_table[MKV_MAX_LACING_NUM]; /**< Frame sizes of the last laced block */
+   uint32_t lace_table_num; /**< Number of frames in the last laced block */
+
 } VC_CONTAINER_MODULE_T;
 
 /******************************************************************************
@@ -851,12 +866,59 @@ static VC_CONTAINER_STATUS_T mkv_read_element_header(VC_CONTAINER_T *p_ctx, int6
    return STREAM_STATUS(p_ctx);
 }
 
+/** Verifies a CRC-32 element against the remainder of its parent element.
+ * The element stores its value little-endian, unlike every other EBML integer,
+ * and covers everything between its own end and the end of its parent. */
+static VC_CONTAINER_STATUS_T mkv_verify_crc32(VC_CONTAINER_T *p_ctx, int64_t parent_end)
+{
+   uint8_t buffer[512];
+   uint32_t expected, crc = 0;
+   int64_t position, left;
+
+   if(READ_BYTES(p_ctx, buffer, 4) != 4) return STREAM_STATUS(p_ctx);
+   expected = buffer[0] | (buffer[1] << 8) | ((uint32_t)buffer[2] << 16) |
+      ((uint32_t)buffer[3] << 24);
+
+   position = STREAM_POSITION(p_ctx);
+   left = parent_end - position;
+
+   /* Verification needs to rewind over the protected region afterwards, and
+    * is skipped for regions big enough for the extra read to be noticeable */
+   if(!STREAM_SEEKABLE(p_ctx) || left < 0 || left > MKV_CRC32_CHECK_MAX)
+      return STREAM_STATUS(p_ctx);
+
+   while(left)
+   {
+      size_t bytes = (size_t)MIN(left, (int64_t)sizeof(buffer));
+      if(READ_BYTES(p_ctx, buffer, bytes) != bytes) break;
+      crc = vc_container_crc32(crc, buffer, bytes);
+      left -= bytes;
+   }
+
+   if(SEEK(p_ctx, position) != VC_CONTAINER_SUCCESS) return STREAM_STATUS(p_ctx);
+
+   if(!left && crc != expected)
+   {
+      LOG_DEBUG(p_ctx, "CRC-32 mismatch over protected region (0x%x instead of 0x%x)",
+                crc, expected);
+      return VC_CONTAINER_ERROR_CORRUPTED;
+   }
+
+   return STREAM_STATUS(p_ctx);
+}
+
 static VC_CONTAINER_STATUS_T mkv_read_element_data(VC_CONTAINER_T *p_ctx,
    MKV_ELEMENT_T *element, int64_t element_size, int64_t size)
 {
    VC_CONTAINER_STATUS_T status = VC_CONTAINER_SUCCESS;
    int64_t offset;
 
+   /* The CRC-32 global element is handled out of line here since its
+    * verification needs to know the extent of the parent element */
+   if(element->id == MKV_ELEMENT_ID_CRC32 && element_size == 4 && size >= 0)
+      return mkv_verify_crc32(p_ctx,
+         (int64_t)p_ctx->priv->module->element_offset + size);
+
    offset = STREAM_POSITION(p_ctx);
    if (size < 0) size = element_size;
    if (size < 0) size = INT64_C(1) << 62;
@@ -1079,6 +1141,7 @@ static VC_CONTAINER_STATUS_T mkv_read_element_segment( VC_CONTAINER_T *p_ctx, MK
       {
          /* We found the start of the data */
          module->cluster_offset = module->element_offset;
+         module->state.cluster_position = module->element_offset;
          module->state.level = 1;
          module->state.levels[1].offset = STREAM_POSITION(p_ctx);
          module->state.levels[1].size = child_size;
@@ -1671,7 +1734,7 @@ static VC_CONTAINER_STATUS_T mkv_find_next_element(VC_CONTAINER_T *p_ctx,
       MKV_READER_STATE_T *state, MKV_ELEMENT_ID_T element_id)
 {
    VC_CONTAINER_STATUS_T status = VC_CONTAINER_SUCCESS;
-   int64_t element_size, element_offset;
+   int64_t element_size, element_offset, header_offset;
    MKV_ELEMENT_ID_T id;
 
    /* Skip all elements until we find the next requested element */
@@ -1684,6 +1747,7 @@ static VC_CONTAINER_STATUS_T mkv_find_next_element(VC_CONTAINER_T *p_ctx,
          state->levels[state->level].size)
          return VC_CONTAINER_ERROR_NOT_FOUND;
 
+      header_offset = STREAM_POSITION(p_ctx);
       status = mkv_read_element_header(p_ctx, INT64_C(1) << 30, &id,
             &element_size, state->levels[state->level].id, &element);
       element_offset = STREAM_POSITION(p_ctx);
@@ -1709,6 +1773,10 @@ static VC_CONTAINER_STATUS_T mkv_find_next_element(VC_CONTAINER_T *p_ctx,
    if(STREAM_STATUS(p_ctx) != VC_CONTAINER_SUCCESS)
       return STREAM_STATUS(p_ctx);
 
+   /* Remember where the cluster started so it can be added to the index */
+   if(id == MKV_ELEMENT_ID_CLUSTER)
+      state->cluster_position = header_offset;
+
    state->level++;
    state->levels[state->level].offset = element_offset;
    state->levels[state->level].size = element_size;
@@ -1861,6 +1929,7 @@ static VC_CONTAINER_STATUS_T mkv_read_next_frame_header(VC_CONTAINER_T *p_ctx,
 
    /* Take care of the lacing */
    state->lacing_num_frames = 0;
+   module->lace_table_num = 0;
    if(i < p_ctx->tracks_num && (flags & 0x06))
    {
       unsigned int i, value = 0;
@@ -1945,6 +2014,29 @@ static VC_CONTAINER_STATUS_T mkv_read_next_frame_header(VC_CONTAINER_T *p_ctx,
    }
    state->header_size_backup = state->header_size;
 
+   /* Whole-block delivery: record the lace layout for the client, then forget the
+    * laces so that the block body is read out as one packet of back-to-back frames.
+    * Header stripping compression inserts bytes in front of each frame, so such
+    * tracks stay on per-lace delivery. */
+   if(state->lacing_num_frames && module->whole_block_delivery &&
+      state->lacing_num_frames <= MKV_MAX_LACING_NUM && !state->header_size)
+   {
+      uint32_t num = state->lacing_num_frames, lace, total = 0;
+      int64_t body = state->levels[state->level].size - state->levels[state->level].data_start;
+
+      for(lace = 0; lace < num - 1; lace++)
+      {
+         module->lace_table[lace] = state->lacing_size ? state->lacing_size :
+            state->lacing_sizes[num - 2 - lace];
+         total += module->lace_table[lace];
+      }
+      module->lace_table[num - 1] = body > total ? body - total : 0; /* Last frame takes the rest */
+      module->lace_table_num = num;
+
+      state->lacing_num_frames = 0;
+      state->lacing_size = 0;
+   }
+
  end:
    *pi_length = state->levels[state->level].size - state->levels[state->level].data_start -
       state->levels[state->level].data_offset + state->header_size;
@@ -2052,6 +2144,14 @@ static VC_CONTAINER_STATUS_T mkv_reader_read(VC_CONTAINER_T *p_ctx,
    if(status == VC_CONTAINER_ERROR_CORRUPTED) state->corrupted = true;
    if(status != VC_CONTAINER_SUCCESS) return status;
 
+   /* Feed video keyframes to the index as we come across them */
+   if(module->index && (state->flags & 0x80) && track < p_ctx->tracks_num &&
+      p_ctx->tracks[track]->format->es_type == VC_CONTAINER_ES_TYPE_VIDEO &&
+      state->pts != VC_CONTAINER_TIME_UNKNOWN &&
+      vc_container_index_add(module->index, state->pts,
+         state->cluster_position - module->segment_offset) == VC_CONTAINER_SUCCESS)
+      module->index_dirty = true;
+
    if(track >= p_ctx->tracks_num || !p_ctx->tracks[track]->is_enabled)
    {
       /* Skip frame */
@@ -2114,7 +2214,27 @@ static VC_CONTAINER_STATUS_T mkv_reader_seek(VC_CONTAINER_T *p_ctx,
          p_ctx->tracks[video_track]->format->es_type == VC_CONTAINER_ES_TYPE_VIDEO) break;
 
    if(!*p_offset) goto end; /* Nothing much to do */
-   if(!module->cues_offset) {status = VC_CONTAINER_ERROR_UNSUPPORTED_OPERATION; goto error;}
+
+   /* Files without cues rely on the index built / reloaded from the sidecar file */
+   if(!module->cues_offset)
+   {
+      int64_t index_offset;
+      int past;
+      time_offset = *p_offset;
+      if(!module->index ||
+         vc_container_index_get(module->index, flags & VC_CONTAINER_SEEK_FLAG_FORWARD,
+            &time_offset, &index_offset, &past) != VC_CONTAINER_SUCCESS)
+      {status = VC_CONTAINER_ERROR_UNSUPPORTED_OPERATION; goto error;}
+      offset = index_offset;
+      /* If the requested time is beyond the region visited so far, resume the
+       * linear scan from the last indexed cluster rather than clamping to it.
+       * The scan feeds the index, so it never covers the same ground twice. */
+      if(past)
+         time_offset = *p_offset;
+      else
+         *p_offset = time_offset;
+      goto end;
+   }
 
    /* We need to do a search in the cue list */
    status = SEEK(p_ctx, module->cues_offset);
@@ -2203,8 +2323,20 @@ static VC_CONTAINER_STATUS_T mkv_reader_seek(VC_CONTAINER_T *p_ctx,
       status = mkv_read_next_frame_header(p_ctx, state, &track, &data_size);
       if(status != VC_CONTAINER_SUCCESS) break; //FIXME
       if(track == video_track) i++;
-      if(track == video_track && (state->flags & 0x80) &&
-         state->pts >= time_offset) break;
+      if(track == video_track && (state->flags & 0x80))
+      {
+         /* Keyframes passed on the way feed the index and reset the search
+          * limit, so a scan beyond the indexed region can reach its target */
+         if(module->index)
+         {
+            if(state->pts != VC_CONTAINER_TIME_UNKNOWN &&
+               vc_container_index_add(module->index, state->pts,
+                  state->cluster_position - module->segment_offset) == VC_CONTAINER_SUCCESS)
+               module->index_dirty = true;
+            i = 0;
+         }
+         if(state->pts >= time_offset) break;
+      }
 
       /* Skip frame */
       status = mkv_read_frame_data(p_ctx, state, 0, &data_size);
@@ -2231,10 +2363,44 @@ static VC_CONTAINER_STATUS_T mkv_reader_close(VC_CONTAINER_T *p_ctx)
          free(p_ctx->tracks[i]->priv->module->encodings[j].data);
       vc_container_free_track(p_ctx, p_ctx->tracks[i]);
    }
+   if(module->index)
+   {
+      /* Persist the index so the next open doesn't have to rebuild it.
+       * A failure here just means the next open falls back to rebuilding. */
+      if(module->index_dirty)
+         vc_container_index_save(module->index, p_ctx->priv->io->uri, p_ctx->size);
+      vc_container_index_free(module->index);
+   }
    free(module);
    return VC_CONTAINER_SUCCESS;
 }
 
+/*****************************************************************************/
+static VC_CONTAINER_STATUS_T mkv_reader_control( VC_CONTAINER_T *p_ctx,
+   VC_CONTAINER_CONTROL_T operation, va_list args )
+{
+   VC_CONTAINER_MODULE_T *module = p_ctx->priv->module;
+   uint32_t *p_num;
+   const uint32_t **p_sizes;
+
+   switch(operation)
+   {
+   case VC_CONTAINER_CONTROL_SET_WHOLE_BLOCK_DELIVERY:
+      module->whole_block_delivery = !!va_arg(args, uint32_t);
+      return VC_CONTAINER_SUCCESS;
+
+   case VC_CONTAINER_CONTROL_GET_BLOCK_LACE_SIZES:
+      p_num = va_arg(args, uint32_t *);
+      p_sizes = va_arg(args, const uint32_t **);
+      if(!p_num || !p_sizes) return VC_CONTAINER_ERROR_INVALID_ARGUMENT;
+      *p_num = module->lace_table_num;
+      *p_sizes = module->lace_table;
+      return VC_CONTAINER_SUCCESS;
+
+   default: return VC_CONTAINER_ERROR_UNSUPPORTED_OPERATION;
+   }
+}
+
 /*****************************************************************************/
 VC_CONTAINER_STATUS_T mkv_reader_open(VC_CONTAINER_T *p_ctx)
 {
@@ -2289,6 +2455,7 @@ VC_CONTAINER_STATUS_T mkv_reader_open(VC_CONTAINER_T *p_ctx)
    p_ctx->priv->pf_close = mkv_reader_close;
    p_ctx->priv->pf_read = mkv_reader_read;
    p_ctx->priv->pf_seek = mkv_reader_seek;
+   p_ctx->priv->pf_control = mkv_reader_control;
    p_ctx->duration = module->duration / 1000 * module->timecode_scale;
 
    /* Check if we're done */
@@ -2297,6 +2464,20 @@ VC_CONTAINER_STATUS_T mkv_reader_open(VC_CONTAINER_T *p_ctx)
 
    if(module->cues_offset && (int64_t)module->cues_offset < p_ctx->size)
       p_ctx->capabilities |= VC_CONTAINER_CAPS_CAN_SEEK;
+   else
+   {
+      /* No usable cues.  Try to reload the index saved by a previous session
+       * and failing that, build one as the stream is read so the linear scan
+       * only ever has to happen once. */
+      if(vc_container_index_load(&module->index, p_ctx->priv->io->uri,
+            p_ctx->size) != VC_CONTAINER_SUCCESS &&
+         vc_container_index_create(&module->index, 512) == VC_CONTAINER_SUCCESS &&
+         module->cluster_offset)
+         vc_container_index_add(module->index, 0,
+            module->cluster_offset - module->segment_offset);
+      if(module->index)
+         p_ctx->capabilities |= VC_CONTAINER_CAPS_CAN_SEEK;
+   }
 
    if(module->tags_offset)
    {
@@ -36,6 +36,13 @@ typedef enum {
    MP4_BOX_TYPE_FTYP              = VC_FOURCC('f','t','y','p'),
    MP4_BOX_TYPE_MDAT              = VC_FOURCC('m','d','a','t'),
    MP4_BOX_TYPE_MOOV              = VC_FOURCC('m','o','o','v'),
+   MP4_BOX_TYPE_MOOF              = VC_FOURCC('m','o','o','f'),
+   MP4_BOX_TYPE_MFHD              = VC_FOURCC('m','f','h','d'),
+   MP4_BOX_TYPE_TRAF              = VC_FOURCC('t','r','a','f'),
+   MP4_BOX_TYPE_TFHD              = VC_FOURCC('t','f','h','d'),
+   MP4_BOX_TYPE_TRUN              = VC_FOURCC('t','r','u','n'),
+   MP4_BOX_TYPE_MVEX              = VC_FOURCC('m','v','e','x'),
+   MP4_BOX_TYPE_TREX              = VC_FOURCC('t','r','e','x'),
    MP4_BOX_TYPE_MVHD              = VC_FOURCC('m','v','h','d'),
    MP4_BOX_TYPE_TRAK              = VC_FOURCC('t','r','a','k'),
    MP4_BOX_TYPE_TKHD              = VC_FOURCC('t','k','h','d'),
@@ -61,6 +61,10 @@ Defines.
 
 #define MP4_MAX_SAMPLES_BATCH_SIZE (16*1024)
 
+/** Bound on the number of entries of a sample table decoded into the in-memory
+ * seek index. Tables bigger than this are walked on disk as before. */
+#define MP4_SEEK_INDEX_MAX_ENTRIES (1<<18)
+
 #define MP4_SKIP_U8(ctx,n)   (size -= 1, SKIP_U8(ctx,n))
 #define MP4_SKIP_U16(ctx,n)  (size -= 2, SKIP_U16(ctx,n))
 #define MP4_SKIP_U24(ctx,n)  (size -= 3, SKIP_U24(ctx,n))
@@ -127,6 +131,23 @@ typedef struct VC_CONTAINER_TRACK_MODULE_T
 
    uint32_t samples_batch_size;
 
+   /* Sample tables decoded at open time into packed arrays so that seeking
+    * is a binary search instead of a per-entry walk of the boxes on disk.
+    * All pointers are NULL when a table was too large to cache or could not
+    * be read, in which case the seek path falls back to walking the box. */
+   struct {
+      uint32_t stts_entries;
+      uint32_t *stts_sample;   /**< Cumulative sample count, stts_entries + 1 values */
+      int64_t *stts_time;      /**< Cumulative duration, stts_entries + 1 values */
+      uint32_t *stts_duration; /**< Per-sample duration of each entry */
+      uint32_t stsc_entries;
+      uint32_t *stsc_chunk;    /**< First chunk of each entry (0 based), stsc_entries + 1 values */
+      uint32_t *stsc_sample;   /**< Cumulative sample count, stsc_entries + 1 values */
+      uint32_t *stsc_samples_per_chunk;
+      uint32_t stss_entries;
+      uint32_t *stss_sample;   /**< Sync sample numbers (1 based as stored in the box) */
+   } seek_index;
+
 } VC_CONTAINER_TRACK_MODULE_T;
 
 typedef struct VC_CONTAINER_MODULE_T
@@ -1197,6 +1218,19 @@ static VC_CONTAINER_STATUS_T mp4_read_box_text( VC_CONTAINER_T *p_ctx, int64_t s
    return STREAM_STATUS(p_ctx);
 }
 
+/*****************************************************************************/
+static void mp4_free_seek_index( VC_CONTAINER_TRACK_MODULE_T *track_module )
+{
+   free(track_module->seek_index.stts_sample);
+   free(track_module->seek_index.stts_time);
+   free(track_module->seek_index.stts_duration);
+   free(track_module->seek_index.stsc_chunk);
+   free(track_module->seek_index.stsc_sample);
+   free(track_module->seek_index.stsc_samples_per_chunk);
+   free(track_module->seek_index.stss_sample);
+   memset(&track_module->seek_index, 0, sizeof(track_module->seek_index));
+}
+
 /*****************************************************************************/
 static VC_CONTAINER_STATUS_T mp4_reader_close( VC_CONTAINER_T *p_ctx )
 {
@@ -1204,11 +1238,139 @@ static VC_CONTAINER_STATUS_T mp4_reader_close( VC_CONTAINER_T *p_ctx )
    unsigned int i;
 
    for(i = 0; i < p_ctx->tracks_num; i++)
+   {
+      mp4_free_seek_index(p_ctx->tracks[i]->priv->module);
       vc_container_free_track(p_ctx, p_ctx->tracks[i]);
+   }
    free(module);
    return VC_CONTAINER_SUCCESS;
 }
 
+/*****************************************************************************/
+static void mp4_build_seek_index( VC_CONTAINER_T *p_ctx,
+   VC_CONTAINER_TRACK_MODULE_T *track_module )
+{
+   uint32_t entries, total_chunks, i;
+
+   /* Decode stts into cumulative (sample, time) pairs plus the per-sample
+    * duration of each entry */
+   entries = track_module->sample_table[MP4_SAMPLE_TABLE_STTS].entries;
+   if(entries && entries <= MP4_SEEK_INDEX_MAX_ENTRIES &&
+      SEEK(p_ctx, track_module->sample_table[MP4_SAMPLE_TABLE_STTS].offset) == VC_CONTAINER_SUCCESS)
+   {
+      uint32_t *sample = malloc((entries + 1) * sizeof(*sample));
+      int64_t *time = malloc((entries + 1) * sizeof(*time));
+      uint32_t *duration = malloc(entries * sizeof(*duration));
+
+      if(sample && time && duration)
+      {
+         uint32_t acc_sample = 0;
+         int64_t acc_time = 0;
+
+         for(i = 0; i < entries; i++)
+         {
+            uint32_t count = _READ_U32(p_ctx);
+            sample[i] = acc_sample;
+            time[i] = acc_time;
+            duration[i] = _READ_U32(p_ctx);
+            acc_sample += count;
+            acc_time += (int64_t)count * duration[i];
+         }
+         sample[entries] = acc_sample;
+         time[entries] = acc_time;
+      }
+
+      if(sample && time && duration && STREAM_STATUS(p_ctx) == VC_CONTAINER_SUCCESS)
+      {
+         track_module->seek_index.stts_entries = entries;
+         track_module->seek_index.stts_sample = sample;
+         track_module->seek_index.stts_time = time;
+         track_module->seek_index.stts_duration = duration;
+      }
+      else
+      {
+         free(sample); free(time); free(duration);
+      }
+   }
+
+   /* Decode stsc into a cumulative (chunk, sample) map. Chunk numbers are
+    * converted to 0 based on the way in. */
+   entries = track_module->sample_table[MP4_SAMPLE_TABLE_STSC].entries;
+   total_chunks = track_module->sample_table[MP4_SAMPLE_TABLE_CO64].entries ?
+      track_module->sample_table[MP4_SAMPLE_TABLE_CO64].entries :
+      track_module->sample_table[MP4_SAMPLE_TABLE_STCO].entries;
+   if(entries && entries <= MP4_SEEK_INDEX_MAX_ENTRIES &&
+      SEEK(p_ctx, track_module->sample_table[MP4_SAMPLE_TABLE_STSC].offset) == VC_CONTAINER_SUCCESS)
+   {
+      uint32_t *chunk = malloc((entries + 1) * sizeof(*chunk));
+      uint32_t *sample = malloc((entries + 1) * sizeof(*sample));
+      uint32_t *samples_per_chunk = malloc(entries * sizeof(*samples_per_chunk));
+      int valid = chunk && sample && samples_per_chunk;
+
+      if(valid)
+      {
+         for(i = 0; i < entries; i++)
+         {
+            uint32_t first_chunk = _READ_U32(p_ctx);
+            samples_per_chunk[i] = _READ_U32(p_ctx);
+            _SKIP_U32(p_ctx); /* sample description index */
+            if(!first_chunk || !samples_per_chunk[i] ||
+               (i && first_chunk - 1 <= chunk[i - 1])) { valid = 0; break; }
+            chunk[i] = first_chunk - 1;
+         }
+         chunk[entries] = total_chunks > chunk[entries - 1] ?
+            total_chunks : chunk[entries - 1] + 1;
+
+         if(valid)
+         {
+            uint32_t acc_sample = 0;
+            for(i = 0; i < entries; i++)
+            {
+               sample[i] = acc_sample;
+               acc_sample += (chunk[i + 1] - chunk[i]) * samples_per_chunk[i];
+            }
+            sample[entries] = acc_sample;
+         }
+      }
+
+      if(valid && STREAM_STATUS(p_ctx) == VC_CONTAINER_SUCCESS)
+      {
+         track_module->seek_index.stsc_entries = entries;
+         track_module->seek_index.stsc_chunk = chunk;
+         track_module->seek_index.stsc_sample = sample;
+         track_module->seek_index.stsc_samples_per_chunk = samples_per_chunk;
+      }
+      else
+      {
+         free(chunk); free(sample); free(samples_per_chunk);
+      }
+   }
+
+   /* The sync sample table is kept as-is, it is already just a sorted list */
+   entries = track_module->sample_table[MP4_SAMPLE_TABLE_STSS].entries;
+   if(entries && entries <= MP4_SEEK_INDEX_MAX_ENTRIES &&
+      SEEK(p_ctx, track_module->sample_table[MP4_SAMPLE_TABLE_STSS].offset) == VC_CONTAINER_SUCCESS)
+   {
+      uint32_t *sample = malloc(entries * sizeof(*sample));
+      int valid = sample != NULL;
+
+      if(valid)
+         for(i = 0; i < entries; i++)
+         {
+            sample[i] = _READ_U32(p_ctx);
+            if(i && sample[i] <= sample[i - 1]) { valid = 0; break; }
+         }
+
+      if(valid && STREAM_STATUS(p_ctx) == VC_CONTAINER_SUCCESS)
+      {
+         track_module->seek_index.stss_entries = entries;
+         track_module->seek_index.stss_sample = sample;
+      }
+      else
+         free(sample);
+   }
+}
+
 /*****************************************************************************/
 #ifdef ENABLE_MP4_READER_LOG_STATE
 static void mp4_log_state( VC_CONTAINER_T *p_ctx, MP4_READER_STATE_T *state )
@@ -1569,6 +1731,31 @@ static uint32_t mp4_find_sample( VC_CONTAINER_T *p_ctx, uint32_t track,
     * rounding errors in the timestamp (because of the timescale conversion) */
    seek_time_up = seek_time_up * track_module->timescale / 1000000;
 
+   if(track_module->seek_index.stts_sample)
+   {
+      /* Binary search the decoded index for the last entry starting at or
+       * before the requested time, then interpolate within the entry */
+      uint32_t entries = track_module->seek_index.stts_entries;
+      const int64_t *time = track_module->seek_index.stts_time;
+      uint32_t lo = 0, hi = entries;
+
+      while(hi - lo > 0)
+      {
+         uint32_t mid = lo + (hi - lo + 1) / 2;
+         if(time[mid] <= seek_time) lo = mid;
+         else hi = mid - 1;
+      }
+
+      sample = track_module->seek_index.stts_sample[lo];
+      if(lo < entries && track_module->seek_index.stts_duration[lo])
+      {
+         int64_t duration = track_module->seek_index.stts_duration[lo];
+         sample += MAX((seek_time - time[lo]) / duration,
+                       (seek_time_up - time[lo]) / duration);
+      }
+      goto end;
+   }
+
    status = SEEK(p_ctx, track_module->sample_table[MP4_SAMPLE_TABLE_STTS].offset);
    if(status != VC_CONTAINER_SUCCESS) goto end;
 
@@ -1611,7 +1798,34 @@ static VC_CONTAINER_STATUS_T mp4_seek_track( VC_CONTAINER_T *p_ctx, uint32_t tra
    memset(state, 0, sizeof(*state));
 
    /* Find the right chunk */
-   for(i = 0, samples = sample; i < track_module->sample_table[MP4_SAMPLE_TABLE_STSC].entries; i++)
+   if(track_module->seek_index.stsc_sample)
+   {
+      /* Binary search the decoded chunk map for the entry containing the
+       * sample instead of walking stsc on disk */
+      const uint32_t *map_sample = track_module->seek_index.stsc_sample;
+      const uint32_t *map_chunk = track_module->seek_index.stsc_chunk;
+      uint32_t entries = track_module->seek_index.stsc_entries;
+      uint32_t lo = 0, hi = entries - 1, chunks_into, span;
+
+      while(hi - lo > 0)
+      {
+         uint32_t mid = lo + (hi - lo + 1) / 2;
+         if(map_sample[mid] <= sample) lo = mid;
+         else hi = mid - 1;
+      }
+
+      samples = sample - map_sample[lo];
+      chunks_into = samples / track_module->seek_index.stsc_samples_per_chunk[lo];
+      samples -= chunks_into * track_module->seek_index.stsc_samples_per_chunk[lo];
+      chunk = map_chunk[lo] + chunks_into;
+      span = map_chunk[lo + 1] - map_chunk[lo];
+
+      /* Leave the streaming state exactly as the walk would have */
+      state->samples_per_chunk = track_module->seek_index.stsc_samples_per_chunk[lo];
+      state->chunks = span > chunks_into ? span - chunks_into - 1 : 0;
+      state->sample_table[MP4_SAMPLE_TABLE_STSC].entry = lo + 1;
+   }
+   else for(i = 0, samples = sample; i < track_module->sample_table[MP4_SAMPLE_TABLE_STSC].entries; i++)
    {
       state->status = mp4_read_sample_table( p_ctx, track_module, state, MP4_SAMPLE_TABLE_STSC, 1 );
       if(state->status != VC_CONTAINER_SUCCESS) goto error;
@@ -1651,7 +1865,27 @@ static VC_CONTAINER_STATUS_T mp4_seek_track( VC_CONTAINER_T *p_ctx, uint32_t tra
    }
 
    /* Get the timestamp */
-   for(i = 0, samples = sample; i < track_module->sample_table[MP4_SAMPLE_TABLE_STTS].entries; i++)
+   if(track_module->seek_index.stts_sample &&
+      sample < track_module->seek_index.stts_sample[track_module->seek_index.stts_entries])
+   {
+      const uint32_t *map_sample = track_module->seek_index.stts_sample;
+      uint32_t entries = track_module->seek_index.stts_entries;
+      uint32_t lo = 0, hi = entries - 1;
+
+      while(hi - lo > 0)
+      {
+         uint32_t mid = lo + (hi - lo + 1) / 2;
+         if(map_sample[mid] <= sample) lo = mid;
+         else hi = mid - 1;
+      }
+
+      state->sample_duration = track_module->seek_index.stts_duration[lo];
+      state->sample_duration_count = map_sample[lo + 1] - sample;
+      state->duration = track_module->seek_index.stts_time[lo] +
+         (int64_t)(sample - map_sample[lo]) * state->sample_duration;
+      state->sample_table[MP4_SAMPLE_TABLE_STTS].entry = lo + 1;
+   }
+   else for(i = 0, samples = sample; i < track_module->sample_table[MP4_SAMPLE_TABLE_STTS].entries; i++)
    {
       state->status = mp4_read_sample_table( p_ctx, track_module, state, MP4_SAMPLE_TABLE_STTS, !i );
       if(state->status != VC_CONTAINER_SUCCESS) goto error;
@@ -1685,7 +1919,24 @@ static VC_CONTAINER_STATUS_T mp4_seek_track( VC_CONTAINER_T *p_ctx, uint32_t tra
    }
 
    /* Find the right place in the synchronisation table */
-   for(i = 0; i < track_module->sample_table[MP4_SAMPLE_TABLE_STSS].entries; i++)
+   if(track_module->seek_index.stss_sample)
+   {
+      const uint32_t *sync = track_module->seek_index.stss_sample;
+      uint32_t entries = track_module->seek_index.stss_entries;
+      uint32_t lo = 0, hi = entries;
+
+      /* First sync sample at or after the requested sample */
+      while(hi - lo > 0)
+      {
+         uint32_t mid = lo + (hi - lo) / 2;
+         if(sync[mid] < sample + 1) lo = mid + 1;
+         else hi = mid;
+      }
+
+      state->next_sync_sample = sync[lo < entries ? lo : entries - 1];
+      state->sample_table[MP4_SAMPLE_TABLE_STSS].entry = lo < entries ? lo + 1 : entries;
+   }
+   else for(i = 0; i < track_module->sample_table[MP4_SAMPLE_TABLE_STSS].entries; i++)
    {
       state->status = mp4_read_sample_table( p_ctx, track_module, state, MP4_SAMPLE_TABLE_STSS, !i );
       if(state->status != VC_CONTAINER_SUCCESS) goto error;
@@ -1741,18 +1992,42 @@ static VC_CONTAINER_STATUS_T mp4_reader_seek(VC_CONTAINER_T *p_ctx,
    if(status != VC_CONTAINER_SUCCESS) goto seek_time_found;
 
    /* Find the closest sync sample */
-   status = mp4_seek_sample_table( p_ctx, track_module, &track_module->state, MP4_SAMPLE_TABLE_STSS );
-   if(status != VC_CONTAINER_SUCCESS) goto seek_time_found;
-   for(i = 0, prev_sample = 0, next_sample = 0;
-       i < track_module->sample_table[MP4_SAMPLE_TABLE_STSS].entries; i++)
+   if(track_module->seek_index.stss_sample)
    {
-      next_sample = _READ_U32(p_ctx) - 1;
-      if(next_sample > sample)
+      const uint32_t *sync = track_module->seek_index.stss_sample;
+      uint32_t entries = track_module->seek_index.stss_entries;
+      uint32_t lo = 0, hi = entries;
+
+      /* First sync sample strictly after the target sample */
+      while(hi - lo > 0)
       {
+         uint32_t mid = lo + (hi - lo) / 2;
+         if(sync[mid] - 1 <= sample) lo = mid + 1;
+         else hi = mid;
+      }
+
+      if(lo < entries)
+      {
+         prev_sample = lo ? sync[lo - 1] - 1 : 0;
+         next_sample = sync[lo] - 1;
          sample = (flags & VC_CONTAINER_SEEK_FLAG_FORWARD) ? next_sample : prev_sample;
-         break;
       }
-      prev_sample = next_sample;
+   }
+   else
+   {
+      status = mp4_seek_sample_table( p_ctx, track_module, &track_module->state, MP4_SAMPLE_TABLE_STSS );
+      if(status != VC_CONTAINER_SUCCESS) goto seek_time_found;
+      for(i = 0, prev_sample = 0, next_sample = 0;
+          i < track_module->sample_table[MP4_SAMPLE_TABLE_STSS].entries; i++)
+      {
+         next_sample = _READ_U32(p_ctx) - 1;
+         if(next_sample > sample)
+         {
+            sample = (flags & VC_CONTAINER_SEEK_FLAG_FORWARD) ? next_sample : prev_sample;
+            break;
+         }
+         prev_sample = next_sample;
+      }
    }
 
    /* Do the seek on this track and use its timestamp as the new seek point */
@@ -1845,6 +2120,12 @@ VC_CONTAINER_STATUS_T mp4_reader_open( VC_CONTAINER_T *p_ctx )
       if(module->found_moov && module->data_offset) break; /* We've got everything we want */
    }
 
+   /* Decode the sample tables into the per-track seek index. Failure is not
+      an error, seeking just falls back to walking the tables on disk. */
+   if(STREAM_SEEKABLE(p_ctx))
+      for(i = 0; i < p_ctx->tracks_num; i++)
+         mp4_build_seek_index(p_ctx, p_ctx->tracks[i]->priv->module);
+
    /* Initialise tracks */
    for(i = 0; i < p_ctx->tracks_num; i++)
    {
@@ -47,6 +47,13 @@ Defines.
 
 #define MP4_64BITS_TIME 0 /* 0 to disable / 1 to enable */
 
+#define MP4_FRAGMENT_DURATION 1000000 /*< Target fragment duration in microseconds */
+#define MP4_FRAGMENT_SAMPLES_MAX 512 /*< Maximum number of samples per track in a fragment */
+
+/* Sample flags used in the trun box */
+#define MP4_SAMPLE_FLAG_SYNC     0x02000000 /*< sample_depends_on = 2 */
+#define MP4_SAMPLE_FLAG_NON_SYNC 0x00010000 /*< sample_is_non_sync_sample */
+
 /******************************************************************************
 Type definitions.
 ******************************************************************************/
@@ -69,6 +76,19 @@ typedef struct VC_CONTAINER_TRACK_MODULE_T
    int64_t first_pts;
    int64_t last_pts;
 
+   /** State for the current fragment when writing fragmented MP4 */
+   struct {
+      uint32_t samples;       /**< Number of samples accumulated */
+      uint32_t data_size;     /**< Number of payload bytes accumulated */
+      uint32_t data_alloc;    /**< Allocated size of the payload buffer */
+      uint8_t *data;          /**< Payload accumulated for the fragment */
+      uint32_t data_offset;   /**< Offset of the payload from the start of the moof */
+      int64_t last_delta;     /**< Sample duration carried over from the previous fragment */
+      uint32_t sizes[MP4_FRAGMENT_SAMPLES_MAX];   /**< Per-sample sizes */
+      int64_t dts[MP4_FRAGMENT_SAMPLES_MAX];      /**< Per-sample timestamps */
+      uint8_t keyframes[MP4_FRAGMENT_SAMPLES_MAX];/**< Per-sample keyframe flags */
+   } frag;
+
 } VC_CONTAINER_TRACK_MODULE_T;
 
 typedef struct VC_CONTAINER_MODULE_T
@@ -96,6 +116,13 @@ typedef struct VC_CONTAINER_MODULE_T
    int64_t duration;
    /**/
 
+   bool fragmented;            /**< Write a fragmented (moof/mdat) stream */
+   unsigned int cut_track;     /**< Track used to decide fragment boundaries */
+   uint32_t fragment_sequence; /**< Sequence number of the current fragment */
+   uint32_t fragment_samples;  /**< Total number of samples in the current fragment */
+   int64_t fragment_pts;       /**< Start time of the current fragment */
+   uint32_t fragment_moof_size;/**< Size of the moof box of the fragment being written */
+
 } VC_CONTAINER_MODULE_T;
 
 /******************************************************************************
@@ -128,6 +155,13 @@ static VC_CONTAINER_STATUS_T mp4_write_box_stss( VC_CONTAINER_T *p_ctx );
 static VC_CONTAINER_STATUS_T mp4_write_box_vide( VC_CONTAINER_T *p_ctx );
 static VC_CONTAINER_STATUS_T mp4_write_box_soun( VC_CONTAINER_T *p_ctx );
 static VC_CONTAINER_STATUS_T mp4_write_box_esds( VC_CONTAINER_T *p_ctx );
+static VC_CONTAINER_STATUS_T mp4_write_box_mvex( VC_CONTAINER_T *p_ctx );
+static VC_CONTAINER_STATUS_T mp4_write_box_trex( VC_CONTAINER_T *p_ctx );
+static VC_CONTAINER_STATUS_T mp4_write_box_moof( VC_CONTAINER_T *p_ctx );
+static VC_CONTAINER_STATUS_T mp4_write_box_mfhd( VC_CONTAINER_T *p_ctx );
+static VC_CONTAINER_STATUS_T mp4_write_box_traf( VC_CONTAINER_T *p_ctx );
+static VC_CONTAINER_STATUS_T mp4_write_box_tfhd( VC_CONTAINER_T *p_ctx );
+static VC_CONTAINER_STATUS_T mp4_write_box_trun( VC_CONTAINER_T *p_ctx );
 
 static struct {
   const MP4_BOX_TYPE_T type;
@@ -159,6 +193,13 @@ static struct {
    {MP4_BOX_TYPE_VIDE, mp4_write_box_vide},
    {MP4_BOX_TYPE_SOUN, mp4_write_box_soun},
    {MP4_BOX_TYPE_ESDS, mp4_write_box_esds},
+   {MP4_BOX_TYPE_MVEX, mp4_write_box_mvex},
+   {MP4_BOX_TYPE_TREX, mp4_write_box_trex},
+   {MP4_BOX_TYPE_MOOF, mp4_write_box_moof},
+   {MP4_BOX_TYPE_MFHD, mp4_write_box_mfhd},
+   {MP4_BOX_TYPE_TRAF, mp4_write_box_traf},
+   {MP4_BOX_TYPE_TFHD, mp4_write_box_tfhd},
+   {MP4_BOX_TYPE_TRUN, mp4_write_box_trun},
    {MP4_BOX_TYPE_UNKNOWN, 0}
 };
 
@@ -252,6 +293,9 @@ static VC_CONTAINER_STATUS_T mp4_write_box_moov( VC_CONTAINER_T *p_ctx )
       if(status != VC_CONTAINER_SUCCESS) return status;
    }
 
+   if(module->fragmented)
+      status = mp4_write_box(p_ctx, MP4_BOX_TYPE_MVEX);
+
    return status;
 }
 
@@ -612,12 +656,29 @@ static VC_CONTAINER_STATUS_T mp4_writer_write_sample_to_temp( VC_CONTAINER_T *p_
    VC_CONTAINER_MODULE_T *module = p_ctx->priv->module;
    int32_t dts_diff = packet->dts - module->prev_sample_dts;
    uint8_t keyframe = (packet->flags & VC_CONTAINER_PACKET_FLAG_KEYFRAME) ? 0x80 : 0;
-
-   vc_container_io_write_be_uint32(module->temp.io, packet->size);
-   vc_container_io_write_be_uint32(module->temp.io, dts_diff);
-   vc_container_io_write_be_uint24(module->temp.io, (uint32_t)(packet->pts - packet->dts));
-   vc_container_io_write_uint8(module->temp.io, packet->track | keyframe);
+   uint32_t pts_diff = (uint32_t)(packet->pts - packet->dts);
+   uint8_t record[12];
+
+   /* Pack the whole sample record so it hits the temporary i/o in one write */
+   record[0] = (uint8_t)(packet->size >> 24);
+   record[1] = (uint8_t)(packet->size >> 16);
+   record[2] = (uint8_t)(packet->size >> 8);
+   record[3] = (uint8_t)packet->size;
+   record[4] = (uint8_t)(dts_diff >> 24);
+   record[5] = (uint8_t)(dts_diff >> 16);
+   record[6] = (uint8_t)(dts_diff >> 8);
+   record[7] = (uint8_t)dts_diff;
+   record[8] = (uint8_t)(pts_diff >> 16);
+   record[9] = (uint8_t)(pts_diff >> 8);
+   record[10] = (uint8_t)pts_diff;
+   record[11] = packet->track | keyframe;
+   vc_container_io_write(module->temp.io, record, sizeof(record));
    module->prev_sample_dts = packet->dts;
+
+   /* Periodically sync the sample records to storage so a crash only loses
+    * a bounded tail of the index rather than the whole recording's worth */
+   vc_container_writer_extraio_checkpoint(p_ctx, &module->temp, sizeof(record));
+
    return module->temp.io->status;
 }
 
@@ -1138,6 +1199,272 @@ static VC_CONTAINER_STATUS_T mp4_write_box_esds( VC_CONTAINER_T *p_ctx )
    return STREAM_STATUS(p_ctx);
 }
 
+/*****************************************************************************/
+static VC_CONTAINER_STATUS_T mp4_write_box_mvex( VC_CONTAINER_T *p_ctx )
+{
+   VC_CONTAINER_MODULE_T *module = p_ctx->priv->module;
+   VC_CONTAINER_STATUS_T status = VC_CONTAINER_SUCCESS;
+   unsigned int i;
+
+   for(i = 0; i < p_ctx->tracks_num; i++)
+   {
+      module->current_track = i;
+      status = mp4_write_box(p_ctx, MP4_BOX_TYPE_TREX);
+      if(status != VC_CONTAINER_SUCCESS) return status;
+   }
+
+   return status;
+}
+
+/*****************************************************************************/
+static VC_CONTAINER_STATUS_T mp4_write_box_trex( VC_CONTAINER_T *p_ctx )
+{
+   VC_CONTAINER_MODULE_T *module = p_ctx->priv->module;
+
+   WRITE_U8(p_ctx,  0, "version");
+   WRITE_U24(p_ctx, 0, "flags");
+
+   WRITE_U32(p_ctx, module->current_track + 1, "track_ID");
+   WRITE_U32(p_ctx, 1, "default_sample_description_index");
+   WRITE_U32(p_ctx, 0, "default_sample_duration");
+   WRITE_U32(p_ctx, 0, "default_sample_size");
+   WRITE_U32(p_ctx, 0, "default_sample_flags");
+
+   return STREAM_STATUS(p_ctx);
+}
+
+/*****************************************************************************/
+static VC_CONTAINER_STATUS_T mp4_write_box_moof( VC_CONTAINER_T *p_ctx )
+{
+   VC_CONTAINER_MODULE_T *module = p_ctx->priv->module;
+   VC_CONTAINER_STATUS_T status;
+   unsigned int i;
+
+   status = mp4_write_box(p_ctx, MP4_BOX_TYPE_MFHD);
+   if(status != VC_CONTAINER_SUCCESS) return status;
+
+   for(i = 0; i < p_ctx->tracks_num; i++)
+   {
+      if(!p_ctx->tracks[i]->priv->module->frag.samples) continue;
+      module->current_track = i;
+      status = mp4_write_box(p_ctx, MP4_BOX_TYPE_TRAF);
+      if(status != VC_CONTAINER_SUCCESS) return status;
+   }
+
+   return status;
+}
+
+/*****************************************************************************/
+static VC_CONTAINER_STATUS_T mp4_write_box_mfhd( VC_CONTAINER_T *p_ctx )
+{
+   VC_CONTAINER_MODULE_T *module = p_ctx->priv->module;
+
+   WRITE_U8(p_ctx,  0, "version");
+   WRITE_U24(p_ctx, 0, "flags");
+
+   WRITE_U32(p_ctx, module->fragment_sequence, "sequence_number");
+
+   return STREAM_STATUS(p_ctx);
+}
+
+/*****************************************************************************/
+static VC_CONTAINER_STATUS_T mp4_write_box_traf( VC_CONTAINER_T *p_ctx )
+{
+   VC_CONTAINER_STATUS_T status;
+
+   status = mp4_write_box(p_ctx, MP4_BOX_TYPE_TFHD);
+   if(status != VC_CONTAINER_SUCCESS) return status;
+
+   status = mp4_write_box(p_ctx, MP4_BOX_TYPE_TRUN);
+
+   return status;
+}
+
+/*****************************************************************************/
+static VC_CONTAINER_STATUS_T mp4_write_box_tfhd( VC_CONTAINER_T *p_ctx )
+{
+   VC_CONTAINER_MODULE_T *module = p_ctx->priv->module;
+
+   WRITE_U8(p_ctx,  0, "version");
+   WRITE_U24(p_ctx, 0x020000, "flags"); /* default-base-is-moof */
+
+   WRITE_U32(p_ctx, module->current_track + 1, "track_ID");
+
+   return STREAM_STATUS(p_ctx);
+}
+
+/*****************************************************************************/
+static VC_CONTAINER_STATUS_T mp4_write_box_trun( VC_CONTAINER_T *p_ctx )
+{
+   VC_CONTAINER_MODULE_T *module = p_ctx->priv->module;
+   VC_CONTAINER_TRACK_MODULE_T *track_module = p_ctx->tracks[module->current_track]->priv->module;
+   uint32_t samples = track_module->frag.samples;
+   int64_t delta;
+   unsigned int i;
+
+   WRITE_U8(p_ctx,  0, "version");
+   /* data-offset / sample-duration / sample-size / sample-flags present */
+   WRITE_U24(p_ctx, 0x000701, "flags");
+
+   WRITE_U32(p_ctx, samples, "sample_count");
+   WRITE_U32(p_ctx, track_module->frag.data_offset, "data_offset");
+
+   for(i = 0; i < samples; i++)
+   {
+      /* The duration of the last sample isn't known until the next one
+       * arrives so it reuses the previous sample duration */
+      if(i + 1 < samples)
+         delta = track_module->frag.dts[i + 1] - track_module->frag.dts[i];
+      else if(samples >= 2)
+         delta = track_module->frag.dts[samples - 1] - track_module->frag.dts[samples - 2];
+      else
+         delta = track_module->frag.last_delta;
+      if(delta < 0) delta = 0;
+
+      WRITE_U32(p_ctx, delta * MP4_TIMESCALE / 1000000, "sample_duration");
+      WRITE_U32(p_ctx, track_module->frag.sizes[i], "sample_size");
+      WRITE_U32(p_ctx, track_module->frag.keyframes[i] ?
+                MP4_SAMPLE_FLAG_SYNC : MP4_SAMPLE_FLAG_NON_SYNC, "sample_flags");
+   }
+
+   return STREAM_STATUS(p_ctx);
+}
+
+/*****************************************************************************/
+static VC_CONTAINER_STATUS_T mp4_writer_write_fragment( VC_CONTAINER_T *p_ctx )
+{
+   VC_CONTAINER_MODULE_T *module = p_ctx->priv->module;
+   VC_CONTAINER_STATUS_T status = VC_CONTAINER_SUCCESS;
+   uint32_t data_size = 0;
+   int64_t offset;
+   unsigned int i;
+
+   if(!module->fragment_samples) return VC_CONTAINER_SUCCESS;
+
+   module->fragment_sequence++;
+
+   /* We need to find out the size of the moof before we can write it since
+    * the trun data offsets are relative to its first byte */
+   if(!vc_container_writer_extraio_enable(p_ctx, &module->null))
+   {
+      status = mp4_write_box(p_ctx, MP4_BOX_TYPE_MOOF);
+      module->fragment_moof_size = STREAM_POSITION(p_ctx);
+   }
+   vc_container_writer_extraio_disable(p_ctx, &module->null);
+   if(status != VC_CONTAINER_SUCCESS) return status;
+
+   /* The payload of each track is written back to back after the mdat header */
+   offset = module->fragment_moof_size + 8;
+   for(i = 0; i < p_ctx->tracks_num; i++)
+   {
+      VC_CONTAINER_TRACK_MODULE_T *track_module = p_ctx->tracks[i]->priv->module;
+      if(!track_module->frag.samples) continue;
+      track_module->frag.data_offset = offset;
+      offset += track_module->frag.data_size;
+      data_size += track_module->frag.data_size;
+   }
+
+   status = mp4_write_box(p_ctx, MP4_BOX_TYPE_MOOF);
+   if(status != VC_CONTAINER_SUCCESS) return status;
+
+   WRITE_U32(p_ctx, data_size + 8, "mdat size");
+   WRITE_FOURCC(p_ctx, VC_FOURCC('m','d','a','t'), "mdat type");
+   for(i = 0; i < p_ctx->tracks_num; i++)
+   {
+      VC_CONTAINER_TRACK_MODULE_T *track_module = p_ctx->tracks[i]->priv->module;
+      if(!track_module->frag.data_size) continue;
+      WRITE_BYTES(p_ctx, track_module->frag.data, track_module->frag.data_size);
+   }
+
+   /* Reset the fragment state, keeping the payload buffers for reuse */
+   for(i = 0; i < p_ctx->tracks_num; i++)
+   {
+      VC_CONTAINER_TRACK_MODULE_T *track_module = p_ctx->tracks[i]->priv->module;
+      uint32_t samples = track_module->frag.samples;
+      if(samples >= 2)
+         track_module->frag.last_delta =
+            track_module->frag.dts[samples - 1] - track_module->frag.dts[samples - 2];
+      track_module->frag.samples = 0;
+      track_module->frag.data_size = 0;
+   }
+   module->fragment_samples = 0;
+
+   return STREAM_STATUS(p_ctx);
+}
+
+/*****************************************************************************/
+static VC_CONTAINER_STATUS_T mp4_writer_write_fragmented( VC_CONTAINER_T *p_ctx,
+                                                          VC_CONTAINER_PACKET_T *packet )
+{
+   VC_CONTAINER_MODULE_T *module = p_ctx->priv->module;
+   VC_CONTAINER_TRACK_T *track = p_ctx->tracks[packet->track];
+   VC_CONTAINER_TRACK_MODULE_T *track_module = track->priv->module;
+   VC_CONTAINER_PACKET_T *sample = &module->sample;
+   VC_CONTAINER_STATUS_T status;
+
+   if(packet->flags & VC_CONTAINER_PACKET_FLAG_FRAME_START)
+   {
+      /* Close the current fragment on a sync point of the cut track once the
+       * target duration has elapsed, or when a sample table is full */
+      bool sync = track->format->es_type != VC_CONTAINER_ES_TYPE_VIDEO ||
+         (packet->flags & VC_CONTAINER_PACKET_FLAG_KEYFRAME);
+      if(track_module->frag.samples == MP4_FRAGMENT_SAMPLES_MAX ||
+         (packet->track == module->cut_track && sync && module->fragment_samples &&
+          packet->pts - module->fragment_pts >= MP4_FRAGMENT_DURATION))
+      {
+         status = mp4_writer_write_fragment(p_ctx);
+         if(status != VC_CONTAINER_SUCCESS) return status;
+      }
+
+      if(!module->fragment_samples) module->fragment_pts = packet->pts;
+
+      sample->size = packet->size;
+      sample->pts = packet->pts;
+      sample->track = packet->track;
+      sample->flags = packet->flags;
+   }
+   else
+   {
+      sample->size += packet->size;
+      sample->flags |= packet->flags;
+   }
+
+   /* Accumulate the payload into the fragment buffer of the track */
+   if(track_module->frag.data_size + packet->size > track_module->frag.data_alloc)
+   {
+      uint32_t data_alloc = track_module->frag.data_alloc ?
+         track_module->frag.data_alloc * 2 : 64 * 1024;
+      uint8_t *data;
+      if(data_alloc < track_module->frag.data_size + packet->size)
+         data_alloc = track_module->frag.data_size + packet->size;
+      data = realloc(track_module->frag.data, data_alloc);
+      if(!data) return VC_CONTAINER_ERROR_OUT_OF_MEMORY;
+      track_module->frag.data = data;
+      track_module->frag.data_alloc = data_alloc;
+   }
+   memcpy(track_module->frag.data + track_module->frag.data_size,
+          packet->data, packet->size);
+   track_module->frag.data_size += packet->size;
+   p_ctx->size += packet->size;
+
+   if(packet->flags & VC_CONTAINER_PACKET_FLAG_FRAME_END)
+   {
+      uint32_t index = track_module->frag.samples++;
+      track_module->frag.sizes[index] = sample->size;
+      track_module->frag.dts[index] = sample->pts;
+      track_module->frag.keyframes[index] =
+         track->format->es_type != VC_CONTAINER_ES_TYPE_VIDEO ||
+         (sample->flags & VC_CONTAINER_PACKET_FLAG_KEYFRAME);
+      module->fragment_samples++;
+
+      track_module->last_pts = sample->pts;
+      if(!track_module->samples) track_module->first_pts = sample->pts;
+      track_module->samples++;
+   }
+
+   return VC_CONTAINER_SUCCESS;
+}
+
 /*****************************************************************************/
 static VC_CONTAINER_STATUS_T mp4_writer_close( VC_CONTAINER_T *p_ctx )
 {
@@ -1145,17 +1472,29 @@ static VC_CONTAINER_STATUS_T mp4_writer_close( VC_CONTAINER_T *p_ctx )
    VC_CONTAINER_STATUS_T status;
    int64_t mdat_size;
 
-   mdat_size = STREAM_POSITION(p_ctx) - module->mdat_offset;
+   if(module->fragmented)
+   {
+      /* Only the pending fragment is left to write out, the headers are
+       * already in the file */
+      status = mp4_writer_write_fragment(p_ctx);
+   }
+   else
+   {
+      mdat_size = STREAM_POSITION(p_ctx) - module->mdat_offset;
 
-   /* Write the moov box */
-   status = mp4_write_box(p_ctx, MP4_BOX_TYPE_MOOV);
+      /* Write the moov box */
+      status = mp4_write_box(p_ctx, MP4_BOX_TYPE_MOOV);
 
-   /* Finalise the mdat box */
-   SEEK(p_ctx, module->mdat_offset);
-   WRITE_U32(p_ctx, (uint32_t)mdat_size, "mdat size" );
+      /* Finalise the mdat box */
+      SEEK(p_ctx, module->mdat_offset);
+      WRITE_U32(p_ctx, (uint32_t)mdat_size, "mdat size" );
+   }
 
    for(; p_ctx->tracks_num > 0; p_ctx->tracks_num--)
+   {
+      free(p_ctx->tracks[p_ctx->tracks_num-1]->priv->module->frag.data);
       vc_container_free_track(p_ctx, p_ctx->tracks[p_ctx->tracks_num-1]);
+   }
 
    vc_container_writer_extraio_delete(p_ctx, &module->temp);
    vc_container_writer_extraio_delete(p_ctx, &module->null);
@@ -1247,6 +1586,21 @@ static VC_CONTAINER_STATUS_T mp4_writer_add_track_done( VC_CONTAINER_T *p_ctx )
    }
    vc_container_writer_extraio_disable(p_ctx, &module->null);
 
+   if(module->fragmented && status == VC_CONTAINER_SUCCESS)
+   {
+      unsigned int i;
+
+      /* Fragments are cut on sync points of the first video track */
+      for(i = 0; i < p_ctx->tracks_num; i++)
+         if(p_ctx->tracks[i]->format->es_type == VC_CONTAINER_ES_TYPE_VIDEO) break;
+      module->cut_track = i < p_ctx->tracks_num ? i : 0;
+
+      /* The movie header goes straight out since it won't be rewritten,
+       * its sample tables stay empty and all the samples are described by
+       * the movie fragments which follow */
+      status = mp4_write_box(p_ctx, MP4_BOX_TYPE_MOOV);
+   }
+
    if(status == VC_CONTAINER_SUCCESS) module->tracks_add_done = true;
    return status;
 }
@@ -1332,6 +1686,9 @@ static VC_CONTAINER_STATUS_T mp4_writer_write( VC_CONTAINER_T *p_ctx,
       if(status != VC_CONTAINER_SUCCESS) return status;
    }
 
+   if(module->fragmented)
+      return mp4_writer_write_fragmented(p_ctx, packet);
+
    if(packet->flags & VC_CONTAINER_PACKET_FLAG_FRAME_START)
       ++module->samples; /* Switching to a new sample */
 
@@ -1400,6 +1757,13 @@ VC_CONTAINER_STATUS_T mp4_writer_open( VC_CONTAINER_T *p_ctx )
    else brand = MP4_BRAND_ISOM;
    module->brand = brand;
 
+   /* Check if the user has asked for a fragmented stream. This keeps the
+    * movie header state bounded and makes finalisation O(1), at the cost of
+    * a moof box per fragment, so a truncated recording only loses its last
+    * fragment. Quicktime files do not support fragments though. */
+   module->fragmented = brand != MP4_BRAND_QT &&
+      vc_uri_find_query(p_ctx->priv->uri, 0, "fragmented", 0);
+
    /* Create a null i/o writer to help us out in writing our data */
    status = vc_container_writer_extraio_create_null(p_ctx, &module->null);
    if(status != VC_CONTAINER_SUCCESS) goto error;
@@ -1411,11 +1775,14 @@ VC_CONTAINER_STATUS_T mp4_writer_open( VC_CONTAINER_T *p_ctx )
    status = mp4_write_box(p_ctx, MP4_BOX_TYPE_FTYP);
    if(status != VC_CONTAINER_SUCCESS) goto error;
 
-   /* Start the mdat box */
-   module->mdat_offset = STREAM_POSITION(p_ctx);
-   WRITE_U32(p_ctx, 0, "size");
-   WRITE_FOURCC(p_ctx, VC_FOURCC('m','d','a','t'), "type");
-   module->data_offset = STREAM_POSITION(p_ctx);
+   if(!module->fragmented)
+   {
+      /* Start the mdat box */
+      module->mdat_offset = STREAM_POSITION(p_ctx);
+      WRITE_U32(p_ctx, 0, "size");
+      WRITE_FOURCC(p_ctx, VC_FOURCC('m','d','a','t'), "type");
+      module->data_offset = STREAM_POSITION(p_ctx);
+   }
 
    p_ctx->priv->pf_close = mp4_writer_close;
    p_ctx->priv->pf_write = mp4_writer_write;
@@ -30,6 +30,8 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define CONTAINER_IS_BIG_ENDIAN
 //#define ENABLE_CONTAINERS_LOG_FORMAT
 //#define ENABLE_CONTAINERS_LOG_FORMAT_VERBOSE
+#include "vcos.h"
+
 #include "containers/core/containers_bits.h"
 #include "containers/core/containers_private.h"
 #include "containers/core/containers_io_helpers.h"
@@ -52,6 +54,11 @@ Defines.
     at open time or when resyncing. */
 #define PS_PACK_SCAN_MAX 128
 
+/** Number of stream maps remembered across opens, and the longest uri we'll
+    remember one for. */
+#define PS_STREAM_MAP_CACHE_ENTRIES 8
+#define PS_STREAM_MAP_URI_MAX 256
+
 /******************************************************************************
 Type definitions.
 ******************************************************************************/
@@ -120,6 +127,27 @@ typedef struct VC_CONTAINER_MODULE_T
    
 } VC_CONTAINER_MODULE_T;
 
+/** A stream map we've already discovered, so that reopening the same file can
+    skip the open-time track scan and rate estimation entirely */
+typedef struct PS_STREAM_MAP_T
+{
+   char uri[PS_STREAM_MAP_URI_MAX];
+   int64_t size;           /**< Size of the file the map belongs to */
+
+   int tracks_num;
+   struct
+   {
+      uint32_t stream_id;
+      uint32_t substream_id;
+      unsigned int payload_offset;
+      VC_CONTAINER_ES_FORMAT_T *format;
+   } tracks[PS_TRACKS_MAX];
+
+   int64_t duration;
+   int64_t data_rate;
+   uint32_t mux_rate;
+} PS_STREAM_MAP_T;
+
 /******************************************************************************
 Function prototypes
 ******************************************************************************/
@@ -167,6 +195,137 @@ static VC_CONTAINER_TRACK_T *ps_find_track( VC_CONTAINER_T *ctx, uint32_t stream
    return track;
 }
 
+/*****************************************************************************
+Stream map cache.
+Probing a program stream for tracks means scanning PES headers sequentially
+which, over a slow connection, dominates open latency. Since the same files
+tend to get opened over and over again we keep a small process-wide cache of
+the stream maps (and rate / duration estimates) already discovered, keyed by
+uri and file size, and skip the probe on a hit.
+*****************************************************************************/
+static PS_STREAM_MAP_T ps_stream_map_cache[PS_STREAM_MAP_CACHE_ENTRIES];
+static unsigned int ps_stream_map_next;
+
+/* The cache is shared by every open in the process, so it has to be locked:
+   a store can delete formats an unlocked restore would still be copying.
+   If for some reason the mutex can't be created, the cache is disabled and
+   every open just probes the file. */
+static VCOS_ONCE_T ps_stream_map_once = VCOS_ONCE_INIT;
+static VCOS_MUTEX_T ps_stream_map_lock;
+static bool ps_stream_map_lock_ok;
+
+static void ps_stream_map_lock_init( void )
+{
+   ps_stream_map_lock_ok =
+      vcos_mutex_create(&ps_stream_map_lock, "ps_stream_map") == VCOS_SUCCESS;
+}
+
+/** Look for a cached stream map matching the file being opened.
+    Called with the cache lock held. */
+static PS_STREAM_MAP_T *ps_stream_map_find( VC_CONTAINER_T *ctx )
+{
+   unsigned int i;
+
+   if(!ctx->priv->io->uri || !STREAM_SEEKABLE(ctx) || ctx->priv->io->size <= 0)
+      return 0;
+
+   for(i = 0; i < PS_STREAM_MAP_CACHE_ENTRIES; i++)
+      if(ps_stream_map_cache[i].tracks_num &&
+         ps_stream_map_cache[i].size == ctx->priv->io->size &&
+         !strcmp(ps_stream_map_cache[i].uri, ctx->priv->io->uri))
+         return &ps_stream_map_cache[i];
+
+   return 0;
+}
+
+/** Recreate the tracks described by a cached stream map, and re-use the
+    rate / duration estimates made when the file was first probed.
+    Called with the cache lock held. */
+static VC_CONTAINER_STATUS_T ps_stream_map_restore( VC_CONTAINER_T *ctx, PS_STREAM_MAP_T *map )
+{
+   VC_CONTAINER_STATUS_T status;
+   int i;
+
+   for(i = 0; i < map->tracks_num; i++)
+   {
+      VC_CONTAINER_TRACK_T *track =
+         ps_find_track(ctx, map->tracks[i].stream_id, map->tracks[i].substream_id, true);
+      if(!track) return VC_CONTAINER_ERROR_OUT_OF_MEMORY;
+
+      if(map->tracks[i].format->extradata_size)
+      {
+         status = vc_container_track_allocate_extradata(ctx, track,
+            map->tracks[i].format->extradata_size);
+         if(status != VC_CONTAINER_SUCCESS) return status;
+      }
+      status = vc_container_format_copy(track->format, map->tracks[i].format,
+         map->tracks[i].format->extradata_size);
+      if(status != VC_CONTAINER_SUCCESS) return status;
+
+      track->priv->module->payload_offset = map->tracks[i].payload_offset;
+      track->is_enabled = true;
+   }
+
+   ctx->duration = map->duration;
+   ctx->priv->module->data_rate = map->data_rate;
+   ctx->priv->module->mux_rate = map->mux_rate;
+
+   return VC_CONTAINER_SUCCESS;
+}
+
+/** Remember the stream map of a successfully opened file. Entries are
+    replaced round-robin; an evicted map just means probing that file again. */
+static void ps_stream_map_store( VC_CONTAINER_T *ctx )
+{
+   VC_CONTAINER_MODULE_T *module = ctx->priv->module;
+   PS_STREAM_MAP_T *map;
+   unsigned int i;
+
+   if(!ps_stream_map_lock_ok ||
+      !ctx->priv->io->uri || !STREAM_SEEKABLE(ctx) || ctx->priv->io->size <= 0 ||
+      strlen(ctx->priv->io->uri) >= PS_STREAM_MAP_URI_MAX)
+      return;
+
+   vcos_mutex_lock(&ps_stream_map_lock);
+   map = &ps_stream_map_cache[ps_stream_map_next];
+   for(i = 0; i < PS_TRACKS_MAX; i++)
+      if(map->tracks[i].format)
+         vc_container_format_delete(map->tracks[i].format);
+   memset(map, 0, sizeof(*map));
+
+   for(i = 0; i < ctx->tracks_num; i++)
+   {
+      VC_CONTAINER_TRACK_T *track = ctx->tracks[i];
+
+      map->tracks[i].format = vc_container_format_create(track->format->extradata_size);
+      if(!map->tracks[i].format ||
+         vc_container_format_copy(map->tracks[i].format, track->format,
+            track->format->extradata_size) != VC_CONTAINER_SUCCESS)
+         goto error;
+
+      map->tracks[i].stream_id = track->priv->module->stream_id;
+      map->tracks[i].substream_id = track->priv->module->substream_id;
+      map->tracks[i].payload_offset = track->priv->module->payload_offset;
+   }
+
+   strcpy(map->uri, ctx->priv->io->uri);
+   map->size = ctx->priv->io->size;
+   map->tracks_num = ctx->tracks_num;
+   map->duration = ctx->duration;
+   map->data_rate = module->data_rate;
+   map->mux_rate = module->mux_rate;
+   ps_stream_map_next = (ps_stream_map_next + 1) % PS_STREAM_MAP_CACHE_ENTRIES;
+   vcos_mutex_unlock(&ps_stream_map_lock);
+   return;
+
+ error:
+   for(i = 0; i < PS_TRACKS_MAX; i++)
+      if(map->tracks[i].format)
+         vc_container_format_delete(map->tracks[i].format);
+   memset(map, 0, sizeof(*map));
+   vcos_mutex_unlock(&ps_stream_map_lock);
+}
+
 /*****************************************************************************/
 STATIC_INLINE VC_CONTAINER_STATUS_T ps_find_start_code( VC_CONTAINER_T *ctx, uint8_t *buffer )
 {
@@ -1120,6 +1279,7 @@ VC_CONTAINER_STATUS_T ps_reader_open( VC_CONTAINER_T *ctx )
    const char *extension = vc_uri_path_extension(ctx->priv->uri);
    VC_CONTAINER_MODULE_T *module = 0;
    VC_CONTAINER_STATUS_T status = VC_CONTAINER_ERROR_FORMAT_NOT_SUPPORTED;
+   PS_STREAM_MAP_T *map;
    uint8_t buffer[4];
    unsigned int i;
 
@@ -1159,24 +1319,49 @@ VC_CONTAINER_STATUS_T ps_reader_open( VC_CONTAINER_T *ctx )
    ctx->priv->module->scr_offset = ctx->priv->module->scr = VC_CONTAINER_TIME_UNKNOWN;
    ctx->priv->module->searching_tracks = true;
 
-   for (i = 0; i != PS_PACK_SCAN_MAX; ++i)
+   /* If we've already probed this exact file, restore the stream map we
+      discovered then instead of scanning for it again. The lock is held
+      across find and restore so a concurrent store can't recycle the entry
+      while we're copying from it. */
+   vcos_once(&ps_stream_map_once, ps_stream_map_lock_init);
+   map = 0;
+   status = VC_CONTAINER_SUCCESS;
+   if(ps_stream_map_lock_ok)
    {
-      if (buffer[3] == 0xBA && (ps_read_pack_header(ctx) != VC_CONTAINER_SUCCESS))
-         goto resync;
+      vcos_mutex_lock(&ps_stream_map_lock);
+      map = ps_stream_map_find(ctx);
+      if(map) status = ps_stream_map_restore(ctx, map);
+      vcos_mutex_unlock(&ps_stream_map_lock);
+   }
+   if(status != VC_CONTAINER_SUCCESS)
+      goto error;
 
-      if (ps_read_pes_packet(ctx) == VC_CONTAINER_SUCCESS)
-         continue;
+   if(!map)
+   {
+      for (i = 0; i != PS_PACK_SCAN_MAX; ++i)
+      {
+         /* Stop scanning early once every track slot has been filled, the
+            remaining packs have nothing more to tell us */
+         if (ctx->tracks_num == PS_TRACKS_MAX)
+            break;
+
+         if (buffer[3] == 0xBA && (ps_read_pack_header(ctx) != VC_CONTAINER_SUCCESS))
+            goto resync;
+
+         if (ps_read_pes_packet(ctx) == VC_CONTAINER_SUCCESS)
+            continue;
 
 resync:
-      LOG_DEBUG(ctx, "Lost sync, scanning for start code");
-      if((status = ps_find_start_code(ctx, buffer)) != VC_CONTAINER_SUCCESS)
-         return VC_CONTAINER_ERROR_CORRUPTED;
-      LOG_DEBUG(ctx, "MPEG PS reader, found start code: 0x%"PRIx64" (%"PRId64"): 0x%02x%02x%02x%02x",
-         STREAM_POSITION(ctx), STREAM_POSITION(ctx), buffer[0], buffer[1], buffer[2], buffer[3]);
-   }
+         LOG_DEBUG(ctx, "Lost sync, scanning for start code");
+         if((status = ps_find_start_code(ctx, buffer)) != VC_CONTAINER_SUCCESS)
+            return VC_CONTAINER_ERROR_CORRUPTED;
+         LOG_DEBUG(ctx, "MPEG PS reader, found start code: 0x%"PRIx64" (%"PRId64"): 0x%02x%02x%02x%02x",
+            STREAM_POSITION(ctx), STREAM_POSITION(ctx), buffer[0], buffer[1], buffer[2], buffer[3]);
+      }
 
-   /* Seek back to the start of data */
-   SEEK(ctx, module->data_offset);
+      /* Seek back to the start of data */
+      SEEK(ctx, module->data_offset);
+   }
 
    /* Bail out if we didn't find any tracks */
    if(!ctx->tracks_num)
@@ -1189,7 +1374,12 @@ resync:
    module->data_size = MAX(ctx->priv->io->size - module->data_offset, INT64_C(0));
 
    /* Estimate data rate (necessary for seeking) */
-   if(STREAM_SEEKABLE(ctx))
+   if(map)
+   {
+      /* The estimates made when the file was first probed were re-used as
+         part of the stream map restore; nothing left to do */
+   }
+   else if(STREAM_SEEKABLE(ctx))
    {
       /* Estimate data rate by jumping in the stream */
       #define PS_PACK_SEARCH_MAX 64
@@ -1251,6 +1441,10 @@ resync:
    ctx->priv->pf_read = ps_reader_read;
    ctx->priv->pf_seek = ps_reader_seek;
 
+   /* Remember what we've learnt in case the same file gets opened again */
+   if(!map)
+      ps_stream_map_store(ctx);
+
    return STREAM_STATUS(ctx);
 
  error:
@@ -43,6 +43,9 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #define MAX_FRAME_SIZE 2881 /* MPEG 2.5 Layer II, 8000 Hz, 160 kbps */
 
+#define SYNC_CHUNK_SIZE 64 /**< Amount of data peeked at a time when looking for a sync word */
+#define SYNC_AHEAD_FRAMES 8 /**< Number of consecutive frame headers validated in one pass */
+
 VC_CONTAINER_STATUS_T mpga_packetizer_open( VC_PACKETIZER_T * );
 
 /*****************************************************************************/
@@ -72,6 +75,9 @@ typedef struct VC_PACKETIZER_MODULE_T {
 
    unsigned int lost_sync;
 
+   unsigned int frames_validated; /**< Number of upcoming frames which already had
+                                       their next header checked */
+
    unsigned int stream_version;
    unsigned int stream_layer;
 
@@ -91,6 +97,7 @@ static VC_CONTAINER_STATUS_T mpga_packetizer_reset( VC_PACKETIZER_T *p_ctx )
 {
    VC_PACKETIZER_MODULE_T *module = p_ctx->priv->module;
    module->lost_sync = 0;
+   module->frames_validated = 0;
    module->state = STATE_SYNC;
    return VC_CONTAINER_SUCCESS;
 }
@@ -105,6 +112,8 @@ static VC_CONTAINER_STATUS_T mpga_packetizer_packetize( VC_PACKETIZER_T *p_ctx,
    uint8_t header[MPGA_HEADER_SIZE];
    VC_CONTAINER_STATUS_T status;
    unsigned int version, layer;
+   uint32_t next_frame_size;
+   size_t next_offset;
    int64_t pts, dts;
 
    while(1) switch (module->state)
@@ -116,19 +125,36 @@ static VC_CONTAINER_STATUS_T mpga_packetizer_packetize( VC_PACKETIZER_T *p_ctx,
       module->state = STATE_SYNC;
 
    case STATE_SYNC:
-      while( bytestream_peek( stream, header, 2 ) == VC_CONTAINER_SUCCESS )
+      /* Scan a chunk at a time rather than peeking the stream for every byte */
+      while( module->state == STATE_SYNC )
       {
-          /* 11 bits sync work (0xffe) */
-          if( header[0] == 0xff && (header[1] & 0xe0) == 0xe0 )
-          {
-             module->state = STATE_HEADER;
-             break;
-          }
-          bytestream_skip_byte( stream );
-          module->lost_sync++;
+         uint8_t bounce[SYNC_CHUNK_SIZE];
+         size_t chunk_size = MIN(sizeof(bounce), bytestream_size( stream ));
+         const uint8_t *chunk;
+         size_t i;
+
+         if( chunk_size < 2 )
+            return VC_CONTAINER_ERROR_INCOMPLETE_DATA; /* We need more data */
+
+         chunk = bytestream_peek_linear( stream, bounce, chunk_size );
+         for( i = 0; i + 1 < chunk_size; i++ )
+         {
+             /* 11 bits sync work (0xffe) */
+             if( chunk[i] == 0xff && (chunk[i+1] & 0xe0) == 0xe0 )
+             {
+                module->state = STATE_HEADER;
+                break;
+             }
+         }
+
+         bytestream_skip( stream, i );
+         module->lost_sync += i;
+
+         /* If the sync word wasn't found, the last byte of the chunk is kept
+          * since it might be the start of one */
+         if( module->state != STATE_HEADER && chunk_size < sizeof(chunk) )
+            return VC_CONTAINER_ERROR_INCOMPLETE_DATA; /* We need more data */
       }
-      if( module->state != STATE_HEADER )
-         return VC_CONTAINER_ERROR_INCOMPLETE_DATA; /* We need more data */
 
    case STATE_HEADER:
       if( bytestream_peek( stream, header, MPGA_HEADER_SIZE ) != VC_CONTAINER_SUCCESS )
@@ -164,6 +190,15 @@ static VC_CONTAINER_STATUS_T mpga_packetizer_packetize( VC_PACKETIZER_T *p_ctx,
       /* fall through to the next state */
 
    case STATE_SYNC_NEXT:
+      /* Frames which already had their next header checked in a previous pass
+       * can go straight through */
+      if( module->frames_validated )
+      {
+         module->frames_validated--;
+         module->state = STATE_SYNC_DONE;
+         break;
+      }
+
       /* To avoid being caught by emulated start codes, we also look at where the next frame is supposed to be */
       if( bytestream_peek_at( stream, module->frame_size, header, MPGA_HEADER_SIZE ) != VC_CONTAINER_SUCCESS )
       {
@@ -177,7 +212,7 @@ static VC_CONTAINER_STATUS_T mpga_packetizer_packetize( VC_PACKETIZER_T *p_ctx,
          return VC_CONTAINER_ERROR_INCOMPLETE_DATA;
       }
 
-      status = mpga_read_header( header, 0, 0, &version, &layer, 0, 0, 0, 0 );
+      status = mpga_read_header( header, &next_frame_size, 0, &version, &layer, 0, 0, 0, 0 );
       if (status != VC_CONTAINER_SUCCESS)
       {
          LOG_ERROR(0, "invalid next header");
@@ -193,6 +228,19 @@ static VC_CONTAINER_STATUS_T mpga_packetizer_packetize( VC_PACKETIZER_T *p_ctx,
          break;
       }
 
+      /* While we're at it, validate as many of the following headers as are
+       * already buffered so the frames they terminate can skip this state */
+      for( next_offset = module->frame_size + next_frame_size;
+           next_frame_size && module->frames_validated < SYNC_AHEAD_FRAMES;
+           next_offset += next_frame_size )
+      {
+         if( bytestream_peek_at( stream, next_offset, header, MPGA_HEADER_SIZE ) != VC_CONTAINER_SUCCESS ||
+             mpga_read_header( header, &next_frame_size, 0, &version, &layer, 0, 0, 0, 0 ) != VC_CONTAINER_SUCCESS ||
+             module->version != version || module->layer != layer )
+            break;
+         module->frames_validated++;
+      }
+
       module->state = STATE_SYNC_DONE;
       /* fall through to the next state */
 
@@ -153,6 +153,30 @@ vc_container_net_status_t vc_container_net_status( VC_CONTAINER_NET_T *p_ctx );
  * \return The number of bytes actually read. */
 size_t vc_container_net_read( VC_CONTAINER_NET_T *p_ctx, void *buffer, size_t size );
 
+/** Descriptor for a single datagram in a batched read.
+ * Before the call, buffer and size describe the memory available for the
+ * datagram; afterwards, size holds the number of bytes actually received. */
+typedef struct VC_CONTAINER_NET_DATAGRAM_T
+{
+   void *buffer;  /**< Pointer to the memory receiving the datagram */
+   size_t size;   /**< Capacity of the buffer, updated to the bytes received */
+} VC_CONTAINER_NET_DATAGRAM_T;
+
+/** Read a batch of datagrams from the socket.
+ * The function blocks until at least one datagram is available, an error
+ * occurs or the timeout is reached (if set), then picks up as many further
+ * datagrams as are already queued on the socket without blocking again, up
+ * to num. Datagrams larger than their descriptor's buffer are truncated.
+ * Attempting a batched read on anything other than a datagram receiver
+ * socket will trigger an error.
+ *
+ * \param p_ctx The socket instance.
+ * \param datagrams Array of datagram descriptors to fill.
+ * \param num Number of entries in the datagrams array.
+ * \return The number of datagrams actually received. */
+unsigned int vc_container_net_read_batch( VC_CONTAINER_NET_T *p_ctx,
+      VC_CONTAINER_NET_DATAGRAM_T *datagrams, unsigned int num );
+
 /** Write data to the socket.
  * If the socket cannot send the requested number of bytes in one go, the function
  * will return a value smaller than size.
@@ -232,6 +256,79 @@ vc_container_net_status_t vc_container_net_get_client_port( VC_CONTAINER_NET_T *
  * \return The status of the socket. */
 vc_container_net_status_t vc_container_net_control( VC_CONTAINER_NET_T *p_ctx, vc_container_net_control_t operation, va_list args);
 
+/** \name Socket reactor
+ * A reactor multiplexes read events from a collection of sockets so that a
+ * single thread can service many network streams, instead of dedicating a
+ * blocked thread to each one. Sockets added to a reactor are switched to
+ * non-blocking operation and should only be read from the registered
+ * callback, where data is guaranteed to be immediately available. */
+/* @{ */
+
+/** Reactor instance.
+ * This is an opaque structure servicing a set of sockets from one thread.
+ * The details of the structure are contained within the platform implementation. */
+typedef struct vc_container_net_reactor_tag VC_CONTAINER_NET_REACTOR_T;
+
+/** Callback invoked by vc_container_net_reactor_wait() for each socket with
+ * data available to read.
+ *
+ * \param p_ctx The socket instance which is ready to read.
+ * \param userdata The opaque pointer registered with the socket. */
+typedef void (*VC_CONTAINER_NET_REACTOR_CALLBACK_T)( VC_CONTAINER_NET_T *p_ctx, void *userdata );
+
+/** Creates a reactor instance with no sockets attached.
+ * If the p_status parameter is not NULL, the status code will be written to it
+ * to indicate the reason for failure, or VC_CONTAINER_NET_SUCCESS on success.
+ *
+ * \param p_status Optional pointer to variable to receive status of operation.
+ * \return The reactor instance or NULL on error. */
+VC_CONTAINER_NET_REACTOR_T *vc_container_net_reactor_create( vc_container_net_status_t *p_status );
+
+/** Destroys a reactor instance.
+ * Sockets still attached to the reactor are detached but remain open and
+ * non-blocking; they still need to be closed by their owner. The p_reactor
+ * pointer must not be used after it has been destroyed.
+ *
+ * \param p_reactor The reactor instance to destroy.
+ * \return The status code for destroying the reactor. */
+vc_container_net_status_t vc_container_net_reactor_destroy( VC_CONTAINER_NET_REACTOR_T *p_reactor );
+
+/** Attach a socket to the reactor.
+ * The socket is made non-blocking and the callback will be invoked with the
+ * given userdata whenever the socket becomes ready to read during a call to
+ * vc_container_net_reactor_wait(). Attaching a datagram sender socket will
+ * trigger an error.
+ *
+ * \param p_reactor The reactor instance.
+ * \param p_ctx The socket instance to attach.
+ * \param callback Function called when the socket is ready to read.
+ * \param userdata Opaque pointer passed to the callback.
+ * \return The status code for attaching the socket. */
+vc_container_net_status_t vc_container_net_reactor_add( VC_CONTAINER_NET_REACTOR_T *p_reactor,
+      VC_CONTAINER_NET_T *p_ctx, VC_CONTAINER_NET_REACTOR_CALLBACK_T callback, void *userdata );
+
+/** Detach a socket from the reactor.
+ * The socket is left open and non-blocking. Detaching a socket that is not
+ * attached to the reactor will trigger an error.
+ *
+ * \param p_reactor The reactor instance.
+ * \param p_ctx The socket instance to detach.
+ * \return The status code for detaching the socket. */
+vc_container_net_status_t vc_container_net_reactor_remove( VC_CONTAINER_NET_REACTOR_T *p_reactor,
+      VC_CONTAINER_NET_T *p_ctx );
+
+/** Wait for sockets attached to the reactor to become ready to read.
+ * Blocks until at least one attached socket has data available, an error
+ * occurs or the timeout is reached (INFINITE_TIMEOUT_MS waits forever), and
+ * invokes the callback of each ready socket from the calling thread.
+ *
+ * \param p_reactor The reactor instance.
+ * \param timeout_ms Maximum time to wait in milliseconds, or INFINITE_TIMEOUT_MS.
+ * \return The number of callbacks invoked, zero on timeout or error. */
+unsigned int vc_container_net_reactor_wait( VC_CONTAINER_NET_REACTOR_T *p_reactor, uint32_t timeout_ms );
+
+/* @} */
+
 /** Convert a 32-bit unsigned value from network order (big endian) to host order.
  *
  * \param value The value to be converted.
@@ -25,7 +25,14 @@ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
 SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+#ifdef __linux__
+/* Needed to get recvmmsg() from <sys/socket.h> */
+#define _GNU_SOURCE
+#endif
+
 #include <errno.h>
+#include <fcntl.h>
+#include <string.h>
 #include <unistd.h>
 
 #include "net_sockets.h"
@@ -42,6 +49,9 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 /** Maximum socket buffer size to use. */
 #define MAXIMUM_BUFFER_SIZE   65536
 
+/** Maximum number of datagrams picked up by a single batched read. */
+#define MAXIMUM_READ_BATCH    32
+
 /*****************************************************************************/
 vc_container_net_status_t vc_container_net_private_last_error()
 {
@@ -115,3 +125,77 @@ size_t vc_container_net_private_maximum_datagram_size( SOCKET_T sock )
    /* No easy way to determine this, just use the default. */
    return DEFAULT_MAXIMUM_DATAGRAM_SIZE;
 }
+
+/*****************************************************************************/
+#ifdef __linux__
+unsigned int vc_container_net_private_read_batch( SOCKET_T sock,
+      VC_CONTAINER_NET_DATAGRAM_T *datagrams, unsigned int num )
+{
+   struct mmsghdr msgs[MAXIMUM_READ_BATCH];
+   struct iovec iovs[MAXIMUM_READ_BATCH];
+   unsigned int i;
+   int result;
+
+   if (num > MAXIMUM_READ_BATCH)
+      num = MAXIMUM_READ_BATCH;
+
+   memset(msgs, 0, num * sizeof(*msgs));
+   for (i = 0; i < num; i++)
+   {
+      iovs[i].iov_base = datagrams[i].buffer;
+      iovs[i].iov_len = datagrams[i].size;
+      msgs[i].msg_hdr.msg_iov = &iovs[i];
+      msgs[i].msg_hdr.msg_iovlen = 1;
+   }
+
+   /* Block for the first datagram only; any others are picked up in the same
+    * system call if they have already arrived. */
+   result = recvmmsg(sock, msgs, num, MSG_WAITFORONE, NULL);
+   if (result <= 0)
+      return 0;
+
+   for (i = 0; i < (unsigned int)result; i++)
+      datagrams[i].size = msgs[i].msg_len;
+
+   return (unsigned int)result;
+}
+#else
+unsigned int vc_container_net_private_read_batch( SOCKET_T sock,
+      VC_CONTAINER_NET_DATAGRAM_T *datagrams, unsigned int num )
+{
+   unsigned int count = 0;
+   ssize_t result;
+
+   /* Block for the first datagram, then drain whatever has already arrived */
+   result = recv(sock, datagrams[0].buffer, datagrams[0].size, 0);
+   if (result < 0)
+      return 0;
+   datagrams[count++].size = (size_t)result;
+
+   while (count < num)
+   {
+      result = recv(sock, datagrams[count].buffer, datagrams[count].size, MSG_DONTWAIT);
+      if (result < 0)
+         break;
+      datagrams[count++].size = (size_t)result;
+   }
+
+   return count;
+}
+#endif
+
+/*****************************************************************************/
+vc_container_net_status_t vc_container_net_private_set_nonblocking( SOCKET_T sock, bool enable )
+{
+   int flags = fcntl(sock, F_GETFL, 0);
+
+   if (flags == -1)
+      return vc_container_net_private_last_error();
+
+   flags = enable ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK);
+
+   if (fcntl(sock, F_SETFL, flags) == -1)
+      return vc_container_net_private_last_error();
+
+   return VC_CONTAINER_NET_SUCCESS;
+}
@@ -360,6 +360,42 @@ size_t vc_container_net_read( VC_CONTAINER_NET_T *p_ctx, void *buffer, size_t si
    return (size_t)result;
 }
 
+/*****************************************************************************/
+unsigned int vc_container_net_read_batch( VC_CONTAINER_NET_T *p_ctx,
+      VC_CONTAINER_NET_DATAGRAM_T *datagrams, unsigned int num )
+{
+   unsigned int received;
+
+   if (!p_ctx)
+      return 0;
+
+   if (!datagrams || !num)
+   {
+      p_ctx->status = VC_CONTAINER_NET_ERROR_INVALID_PARAMETER;
+      return 0;
+   }
+
+   if (p_ctx->type != DATAGRAM_RECEIVER)
+   {
+      p_ctx->status = VC_CONTAINER_NET_ERROR_NOT_ALLOWED;
+      return 0;
+   }
+
+   p_ctx->status = VC_CONTAINER_NET_SUCCESS;
+
+   if (!socket_wait_for_data(p_ctx, p_ctx->read_timeout_ms))
+   {
+      p_ctx->status = VC_CONTAINER_NET_ERROR_TIMED_OUT;
+      return 0;
+   }
+
+   received = vc_container_net_private_read_batch(p_ctx->socket, datagrams, num);
+   if (!received)
+      p_ctx->status = vc_container_net_private_last_error();
+
+   return received;
+}
+
 /*****************************************************************************/
 size_t vc_container_net_write( VC_CONTAINER_NET_T *p_ctx, const void *buffer, size_t size )
 {
@@ -506,6 +542,18 @@ size_t vc_container_net_maximum_datagram_size( VC_CONTAINER_NET_T *p_ctx )
    return p_ctx ? p_ctx->max_datagram_size : 0;
 }
 
+/*****************************************************************************/
+SOCKET_T vc_container_net_get_socket( VC_CONTAINER_NET_T *p_ctx )
+{
+   return p_ctx ? p_ctx->socket : INVALID_SOCKET;
+}
+
+/*****************************************************************************/
+bool vc_container_net_is_readable( VC_CONTAINER_NET_T *p_ctx )
+{
+   return p_ctx && p_ctx->type != DATAGRAM_SENDER;
+}
+
 /*****************************************************************************/
 static vc_container_net_status_t translate_getnameinfo_error( int error )
 {
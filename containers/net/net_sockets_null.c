@@ -75,6 +75,17 @@ size_t vc_container_net_read( VC_CONTAINER_NET_T *p_ctx, void *buffer, size_t si
    return 0;
 }
 
+/*****************************************************************************/
+unsigned int vc_container_net_read_batch( VC_CONTAINER_NET_T *p_ctx,
+      VC_CONTAINER_NET_DATAGRAM_T *datagrams, unsigned int num )
+{
+   VC_CONTAINER_PARAM_UNUSED(p_ctx);
+   VC_CONTAINER_PARAM_UNUSED(datagrams);
+   VC_CONTAINER_PARAM_UNUSED(num);
+
+   return 0;
+}
+
 /*****************************************************************************/
 size_t vc_container_net_write( VC_CONTAINER_NET_T *p_ctx, const void *buffer, size_t size )
 {
@@ -150,6 +161,54 @@ vc_container_net_status_t vc_container_net_control( VC_CONTAINER_NET_T *p_ctx,
    return VC_CONTAINER_NET_ERROR_NOT_ALLOWED;
 }
 
+/*****************************************************************************/
+VC_CONTAINER_NET_REACTOR_T *vc_container_net_reactor_create( vc_container_net_status_t *p_status )
+{
+   if (p_status)
+      *p_status = VC_CONTAINER_NET_ERROR_NOT_ALLOWED;
+
+   return NULL;
+}
+
+/*****************************************************************************/
+vc_container_net_status_t vc_container_net_reactor_destroy( VC_CONTAINER_NET_REACTOR_T *p_reactor )
+{
+   VC_CONTAINER_PARAM_UNUSED(p_reactor);
+
+   return VC_CONTAINER_NET_ERROR_INVALID_PARAMETER;
+}
+
+/*****************************************************************************/
+vc_container_net_status_t vc_container_net_reactor_add( VC_CONTAINER_NET_REACTOR_T *p_reactor,
+      VC_CONTAINER_NET_T *p_ctx, VC_CONTAINER_NET_REACTOR_CALLBACK_T callback, void *userdata )
+{
+   VC_CONTAINER_PARAM_UNUSED(p_reactor);
+   VC_CONTAINER_PARAM_UNUSED(p_ctx);
+   VC_CONTAINER_PARAM_UNUSED(callback);
+   VC_CONTAINER_PARAM_UNUSED(userdata);
+
+   return VC_CONTAINER_NET_ERROR_NOT_ALLOWED;
+}
+
+/*****************************************************************************/
+vc_container_net_status_t vc_container_net_reactor_remove( VC_CONTAINER_NET_REACTOR_T *p_reactor,
+      VC_CONTAINER_NET_T *p_ctx )
+{
+   VC_CONTAINER_PARAM_UNUSED(p_reactor);
+   VC_CONTAINER_PARAM_UNUSED(p_ctx);
+
+   return VC_CONTAINER_NET_ERROR_INVALID_SOCKET;
+}
+
+/*****************************************************************************/
+unsigned int vc_container_net_reactor_wait( VC_CONTAINER_NET_REACTOR_T *p_reactor, uint32_t timeout_ms )
+{
+   VC_CONTAINER_PARAM_UNUSED(p_reactor);
+   VC_CONTAINER_PARAM_UNUSED(timeout_ms);
+
+   return 0;
+}
+
 /*****************************************************************************/
 uint32_t vc_container_net_to_host( uint32_t value )
 {
@@ -78,6 +78,41 @@ void vc_container_net_private_set_reusable( SOCKET_T sock, bool enable );
  * \return The maximum supported datagram size on the socket. */
 size_t vc_container_net_private_maximum_datagram_size( SOCKET_T sock );
 
+/** Read as many datagrams as possible from the socket in one operation.
+ * Blocks until at least one datagram arrives; further datagrams are only
+ * picked up if they are already queued on the socket. Each descriptor has
+ * its size updated to the number of bytes received.
+ *
+ * \param sock The socket to read from.
+ * \param datagrams Array of datagram descriptors to fill.
+ * \param num Number of entries in the datagrams array.
+ * \return The number of datagrams received, zero on error. */
+unsigned int vc_container_net_private_read_batch( SOCKET_T sock,
+      VC_CONTAINER_NET_DATAGRAM_T *datagrams, unsigned int num );
+
+/** Enable or disable non-blocking operation on the socket.
+ *
+ * \param sock The socket to modify.
+ * \param enable True to make the socket non-blocking, false to make it block.
+ * \return VC_CONTAINER_NET_SUCCESS or one of the error codes on failure. */
+vc_container_net_status_t vc_container_net_private_set_nonblocking( SOCKET_T sock, bool enable );
+
+/** Get the underlying socket handle of a socket instance.
+ * For use by platform code such as the reactor which needs to multiplex on
+ * the raw handle.
+ *
+ * \param p_ctx The socket instance.
+ * \return The underlying socket handle, or INVALID_SOCKET. */
+SOCKET_T vc_container_net_get_socket( VC_CONTAINER_NET_T *p_ctx );
+
+/** Query whether reading from the socket instance is allowed.
+ * Datagram sender sockets cannot be read and thus cannot usefully be attached
+ * to a reactor.
+ *
+ * \param p_ctx The socket instance.
+ * \return True if the socket type supports reading. */
+bool vc_container_net_is_readable( VC_CONTAINER_NET_T *p_ctx );
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,281 @@
+/*
+Copyright (c) 2012, Broadcom Europe Ltd
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#else
+#include <poll.h>
+#endif
+
+#include "containers/containers.h"
+#include "containers/core/containers_common.h"
+#include "containers/core/containers_logging.h"
+#include "net_sockets.h"
+#include "net_sockets_priv.h"
+
+/*****************************************************************************/
+
+/** Maximum number of sockets that can be attached to a single reactor. */
+#define REACTOR_MAX_SOCKETS   256
+
+/** Maximum number of ready sockets serviced by a single wait call. */
+#define REACTOR_MAX_EVENTS    32
+
+/** State for one socket attached to the reactor.
+ * Slots are never moved once allocated, so the address of an entry can safely
+ * be stored in the kernel event data. A free slot has a NULL socket. */
+typedef struct vc_container_net_reactor_entry_tag
+{
+   VC_CONTAINER_NET_T *p_ctx;                   /**< Attached socket, NULL if the slot is free */
+   VC_CONTAINER_NET_REACTOR_CALLBACK_T callback;/**< Called when the socket is ready to read */
+   void *userdata;                              /**< Opaque pointer passed to the callback */
+} VC_CONTAINER_NET_REACTOR_ENTRY_T;
+
+struct vc_container_net_reactor_tag
+{
+#ifdef __linux__
+   int epoll_fd;              /**< Kernel event queue tracking the attached sockets */
+#endif
+   unsigned int entries_in_use;
+   VC_CONTAINER_NET_REACTOR_ENTRY_T entries[REACTOR_MAX_SOCKETS];
+};
+
+/*****************************************************************************/
+static VC_CONTAINER_NET_REACTOR_ENTRY_T *reactor_find_entry( VC_CONTAINER_NET_REACTOR_T *p_reactor,
+      VC_CONTAINER_NET_T *p_ctx )
+{
+   unsigned int i;
+
+   for (i = 0; i < REACTOR_MAX_SOCKETS; i++)
+      if (p_reactor->entries[i].p_ctx == p_ctx)
+         return &p_reactor->entries[i];
+
+   return NULL;
+}
+
+/*****************************************************************************/
+VC_CONTAINER_NET_REACTOR_T *vc_container_net_reactor_create( vc_container_net_status_t *p_status )
+{
+   VC_CONTAINER_NET_REACTOR_T *p_reactor;
+   vc_container_net_status_t status = VC_CONTAINER_NET_SUCCESS;
+
+   p_reactor = (VC_CONTAINER_NET_REACTOR_T *)malloc(sizeof(VC_CONTAINER_NET_REACTOR_T));
+   if (!p_reactor)
+   {
+      LOG_ERROR(NULL, "vc_container_net_reactor_create: malloc fail for VC_CONTAINER_NET_REACTOR_T");
+      status = VC_CONTAINER_NET_ERROR_NO_MEMORY;
+      goto error;
+   }
+
+   memset(p_reactor, 0, sizeof(*p_reactor));
+
+#ifdef __linux__
+   p_reactor->epoll_fd = epoll_create(REACTOR_MAX_SOCKETS);
+   if (p_reactor->epoll_fd == -1)
+   {
+      status = vc_container_net_private_last_error();
+      LOG_ERROR(NULL, "vc_container_net_reactor_create: failed to create event queue: %d", status);
+      goto error;
+   }
+#endif
+
+   if (p_status)
+      *p_status = VC_CONTAINER_NET_SUCCESS;
+
+   return p_reactor;
+
+error:
+   if (p_reactor)
+      free(p_reactor);
+   if (p_status)
+      *p_status = status;
+   return NULL;
+}
+
+/*****************************************************************************/
+vc_container_net_status_t vc_container_net_reactor_destroy( VC_CONTAINER_NET_REACTOR_T *p_reactor )
+{
+   if (!p_reactor)
+      return VC_CONTAINER_NET_ERROR_INVALID_PARAMETER;
+
+#ifdef __linux__
+   close(p_reactor->epoll_fd);
+#endif
+   free(p_reactor);
+
+   return VC_CONTAINER_NET_SUCCESS;
+}
+
+/*****************************************************************************/
+vc_container_net_status_t vc_container_net_reactor_add( VC_CONTAINER_NET_REACTOR_T *p_reactor,
+      VC_CONTAINER_NET_T *p_ctx, VC_CONTAINER_NET_REACTOR_CALLBACK_T callback, void *userdata )
+{
+   VC_CONTAINER_NET_REACTOR_ENTRY_T *entry;
+   vc_container_net_status_t status;
+
+   if (!p_reactor || !p_ctx || !callback)
+      return VC_CONTAINER_NET_ERROR_INVALID_PARAMETER;
+
+   if (!vc_container_net_is_readable(p_ctx))
+      return VC_CONTAINER_NET_ERROR_NOT_ALLOWED;
+
+   if (reactor_find_entry(p_reactor, p_ctx))
+      return VC_CONTAINER_NET_ERROR_IN_USE;
+
+   entry = reactor_find_entry(p_reactor, NULL);
+   if (!entry)
+      return VC_CONTAINER_NET_ERROR_TOO_BIG;
+
+   status = vc_container_net_private_set_nonblocking(vc_container_net_get_socket(p_ctx), true);
+   if (status != VC_CONTAINER_NET_SUCCESS)
+      return status;
+
+   entry->p_ctx = p_ctx;
+   entry->callback = callback;
+   entry->userdata = userdata;
+
+#ifdef __linux__
+   {
+      struct epoll_event event;
+
+      memset(&event, 0, sizeof(event));
+      event.events = EPOLLIN;
+      event.data.ptr = entry;
+      if (epoll_ctl(p_reactor->epoll_fd, EPOLL_CTL_ADD, vc_container_net_get_socket(p_ctx), &event) == -1)
+      {
+         entry->p_ctx = NULL;
+         return vc_container_net_private_last_error();
+      }
+   }
+#endif
+
+   p_reactor->entries_in_use++;
+
+   return VC_CONTAINER_NET_SUCCESS;
+}
+
+/*****************************************************************************/
+vc_container_net_status_t vc_container_net_reactor_remove( VC_CONTAINER_NET_REACTOR_T *p_reactor,
+      VC_CONTAINER_NET_T *p_ctx )
+{
+   VC_CONTAINER_NET_REACTOR_ENTRY_T *entry;
+
+   if (!p_reactor || !p_ctx)
+      return VC_CONTAINER_NET_ERROR_INVALID_PARAMETER;
+
+   entry = reactor_find_entry(p_reactor, p_ctx);
+   if (!entry)
+      return VC_CONTAINER_NET_ERROR_INVALID_SOCKET;
+
+#ifdef __linux__
+   (void)epoll_ctl(p_reactor->epoll_fd, EPOLL_CTL_DEL, vc_container_net_get_socket(p_ctx), NULL);
+#endif
+
+   entry->p_ctx = NULL;
+   p_reactor->entries_in_use--;
+
+   return VC_CONTAINER_NET_SUCCESS;
+}
+
+/*****************************************************************************/
+#ifdef __linux__
+unsigned int vc_container_net_reactor_wait( VC_CONTAINER_NET_REACTOR_T *p_reactor, uint32_t timeout_ms )
+{
+   struct epoll_event events[REACTOR_MAX_EVENTS];
+   int result, i;
+   unsigned int serviced = 0;
+
+   if (!p_reactor)
+      return 0;
+
+   result = epoll_wait(p_reactor->epoll_fd, events, REACTOR_MAX_EVENTS,
+         timeout_ms == INFINITE_TIMEOUT_MS ? -1 : (int)timeout_ms);
+   if (result <= 0)
+      return 0;
+
+   for (i = 0; i < result; i++)
+   {
+      VC_CONTAINER_NET_REACTOR_ENTRY_T *entry = (VC_CONTAINER_NET_REACTOR_ENTRY_T *)events[i].data.ptr;
+
+      /* The entry may have been removed by an earlier callback in this batch */
+      if (!entry->p_ctx)
+         continue;
+
+      entry->callback(entry->p_ctx, entry->userdata);
+      serviced++;
+   }
+
+   return serviced;
+}
+#else
+unsigned int vc_container_net_reactor_wait( VC_CONTAINER_NET_REACTOR_T *p_reactor, uint32_t timeout_ms )
+{
+   struct pollfd fds[REACTOR_MAX_SOCKETS];
+   VC_CONTAINER_NET_REACTOR_ENTRY_T *polled[REACTOR_MAX_SOCKETS];
+   unsigned int i, num_fds = 0, serviced = 0;
+   int result;
+
+   if (!p_reactor)
+      return 0;
+
+   for (i = 0; i < REACTOR_MAX_SOCKETS; i++)
+   {
+      VC_CONTAINER_NET_REACTOR_ENTRY_T *entry = &p_reactor->entries[i];
+
+      if (!entry->p_ctx)
+         continue;
+
+      fds[num_fds].fd = vc_container_net_get_socket(entry->p_ctx);
+      fds[num_fds].events = POLLIN;
+      fds[num_fds].revents = 0;
+      polled[num_fds++] = entry;
+   }
+
+   result = poll(fds, num_fds, timeout_ms == INFINITE_TIMEOUT_MS ? -1 : (int)timeout_ms);
+   if (result <= 0)
+      return 0;
+
+   for (i = 0; i < num_fds; i++)
+   {
+      if (!(fds[i].revents & (POLLIN | POLLERR | POLLHUP)))
+         continue;
+
+      /* The entry may have been removed by an earlier callback in this batch */
+      if (!polled[i]->p_ctx)
+         continue;
+
+      polled[i]->callback(polled[i]->p_ctx, polled[i]->userdata);
+      serviced++;
+   }
+
+   return serviced;
+}
+#endif
@@ -138,3 +138,32 @@ size_t vc_container_net_private_maximum_datagram_size( SOCKET_T sock )
 
    return max_datagram_size;
 }
+
+/*****************************************************************************/
+unsigned int vc_container_net_private_read_batch( SOCKET_T sock,
+      VC_CONTAINER_NET_DATAGRAM_T *datagrams, unsigned int num )
+{
+   int result;
+
+   VC_CONTAINER_PARAM_UNUSED(num);
+
+   /* No batched receive available, just pick up a single datagram */
+   result = recv(sock, (char *)datagrams[0].buffer, (int)datagrams[0].size, 0);
+   if (result == SOCKET_ERROR)
+      return 0;
+
+   datagrams[0].size = (size_t)result;
+
+   return 1;
+}
+
+/*****************************************************************************/
+vc_container_net_status_t vc_container_net_private_set_nonblocking( SOCKET_T sock, bool enable )
+{
+   u_long mode = enable ? 1 : 0;
+
+   if (ioctlsocket(sock, FIONBIO, &mode) == SOCKET_ERROR)
+      return vc_container_net_private_last_error();
+
+   return VC_CONTAINER_NET_SUCCESS;
+}
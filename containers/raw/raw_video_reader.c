@@ -303,6 +303,31 @@ static VC_CONTAINER_STATUS_T rawvideo_reader_read( VC_CONTAINER_T *ctx,
    if (flags & VC_CONTAINER_READ_FLAG_INFO)
       return VC_CONTAINER_SUCCESS;
 
+   if (flags & VC_CONTAINER_READ_FLAG_BORROW)
+   {
+      size_t borrowed = module->block_size - module->block_offset;
+      const uint8_t *data = vc_container_io_borrow(ctx->priv->io, &borrowed);
+
+      if (data)
+      {
+         packet->data = (uint8_t *)data;
+         packet->size = borrowed;
+         packet->flags |= VC_CONTAINER_PACKET_FLAG_BORROWED;
+         module->block_offset += borrowed;
+
+         if (module->block_offset == module->block_size)
+         {
+            module->block_offset = 0;
+            module->frame_header = 0;
+            module->frames++;
+         }
+
+         module->status = VC_CONTAINER_SUCCESS;
+         return module->status;
+      }
+      /* Fall back to copying into the supplied buffer */
+   }
+
    size = MIN(module->block_size - module->block_offset, packet->buffer_size);
    size = READ_BYTES(ctx, packet->data, size);
    module->block_offset += size;
@@ -155,7 +155,6 @@ static uint32_t h264_remove_emulation_prevention_bytes(uint8_t *sprop,
    uint32_t offset = 0;
    uint8_t nal_unit_type = sprop[offset++];
    uint32_t new_sprop_size = sprop_size;
-   uint8_t first_byte, second_byte;
 
    nal_unit_type &= 0x1F;  /* Just keep NAL unit type bits */
 
@@ -163,31 +162,22 @@ static uint32_t h264_remove_emulation_prevention_bytes(uint8_t *sprop,
    if (nal_unit_type == NAL_UNIT_PREFIX || nal_unit_type == NAL_UNIT_EXTENSION)
       offset += 3;
 
-   /* Make sure there is enough data for there to be a 0x00 0x00 0x03 sequence */
-   if (offset + 2 >= new_sprop_size)
-      return new_sprop_size;
-
-   /* Keep a rolling set of the last couple of bytes */
-   first_byte = sprop[offset++];
-   second_byte = sprop[offset++];
-
    while (offset < new_sprop_size)
    {
-      uint8_t next_byte = sprop[offset];
-
-      if (!first_byte && !second_byte && next_byte == 0x03)
-      {
-         /* Remove the emulation prevention byte (0x03) */
-         new_sprop_size--;
-         if (offset == new_sprop_size) /* No more data to check */
-            break;
-         memmove(&sprop[offset], &sprop[offset + 1], new_sprop_size - offset);
-         next_byte = sprop[offset];
-      } else
-         offset++;
-
-      first_byte = second_byte;
-      second_byte = next_byte;
+      /* Find the 0x03 of the next 0x00 0x00 0x03 pattern */
+      uint32_t position = offset +
+         vc_container_bits_find_emulation_prevention(sprop + offset,
+            new_sprop_size - offset);
+      if (position >= new_sprop_size)
+         break;
+
+      /* Remove the emulation prevention byte (0x03) */
+      new_sprop_size--;
+      memmove(&sprop[position], &sprop[position + 1], new_sprop_size - position);
+
+      /* Resume at the escaped byte: the zero bytes before it have been used
+       * up by the pattern just removed and cannot start another one */
+      offset = position;
    }
 
    return new_sprop_size;
@@ -33,6 +33,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "containers/core/containers_private.h"
 #include "containers/core/containers_bits.h"
 #include "containers/core/containers_list.h"
+#include "containers/core/containers_reorder.h"
 
 typedef VC_CONTAINER_STATUS_T (*PAYLOAD_HANDLER_T)(VC_CONTAINER_T *p_ctx,
       VC_CONTAINER_TRACK_T *track, VC_CONTAINER_PACKET_T *p_packet, uint32_t flags);
@@ -56,6 +57,7 @@ typedef enum
    TRACK_SSRC_SET = 0,
    TRACK_HAS_MARKER,
    TRACK_NEW_PACKET,
+   TRACK_PUSHED_DATA,
 } track_module_flag_bit_t;
 
 /** RTP track data */
@@ -77,6 +79,9 @@ typedef struct VC_CONTAINER_TRACK_MODULE_T
    uint32_t bad_seq;             /**< Last 'bad' seq number + 1 */
    uint32_t probation;           /**< Sequential packets till source is valid */
    uint32_t received;            /**< RTP packets received */
+   VC_CONTAINERS_REORDER_T *reorder; /**< Jitter buffer undoing packet reordering, if enabled */
+   uint8_t *pushed_data;         /**< Borrowed packet handed over in pushed-packet mode, if any */
+   uint32_t pushed_size;         /**< Size of the borrowed packet, zero if none is pending */
    void *extra;                  /**< Payload specific data */
 } VC_CONTAINER_TRACK_MODULE_T;
 
@@ -56,6 +56,9 @@ Configurable defines and constants.
 /** Maximum size of an RTP packet */
 #define MAXIMUM_PACKET_SIZE   2048
 
+/** Size of the fixed RTP packet header */
+#define RTP_HEADER_SIZE       12
+
 /** Maximum number of RTP packets that can be missed without restarting. */
 #define MAX_DROPOUT           3000
 /** Maximum number of out of sequence RTP packets that are accepted. */
@@ -73,6 +76,11 @@ Defines and constants.
 /** The RTP PKT scheme is used with test pkt files */
 #define RTP_PKT_SCHEME                     "rtppkt:"
 
+/** The RTP push scheme is used when another container (e.g. the RTSP reader
+ * with an interleaved transport) hands packets to this reader instead of the
+ * reader pulling them from its own i/o. */
+#define RTP_PUSH_SCHEME                    "rtppush"
+
 /** \name RTP URI parameter names
  * @{ */
 #define PAYLOAD_TYPE_NAME              "rtppt"
@@ -81,6 +89,7 @@ Defines and constants.
 #define RATE_NAME                      "rate"
 #define SSRC_NAME                      "ssrc"
 #define SEQ_NAME                       "seq"
+#define REORDER_NAME                   "reorder"
 /* @} */
 
 /** A sentinel codec that is not supported */
@@ -910,14 +919,66 @@ static VC_CONTAINER_STATUS_T rtp_reader_read( VC_CONTAINER_T *p_ctx,
 
    while (!BITS_AVAILABLE(p_ctx, &t_module->payload))
    {
+      uint8_t *packet = t_module->buffer;
       uint32_t bytes_read;
 
-      /* No data left from last RTP packet, get another one */
-      bytes_read = READ_BYTES(p_ctx, t_module->buffer, MAXIMUM_PACKET_SIZE);
-      if (!bytes_read)
-         return STREAM_STATUS(p_ctx);
+      if (t_module->reorder && vc_containers_reorder_ready(t_module->reorder))
+      {
+         /* The next packet in sequence (or the oldest one, if the jitter
+          * buffer has filled) is due for delivery */
+         bytes_read = vc_containers_reorder_remove(t_module->reorder,
+               t_module->buffer, MAXIMUM_PACKET_SIZE);
+      }
+      else if (BIT_IS_SET(t_module->flags, TRACK_PUSHED_DATA))
+      {
+         /* Packets are handed over by the owning container and parsed in
+          * place in the borrowed buffer, so they are never copied. When none
+          * is pending, report the same status as a network read timing out. */
+         if (!t_module->pushed_size)
+         {
+            STREAM_STATUS(p_ctx) = VC_CONTAINER_ERROR_ABORTED;
+            return VC_CONTAINER_ERROR_ABORTED;
+         }
+         packet = t_module->pushed_data;
+         bytes_read = t_module->pushed_size;
+         t_module->pushed_size = 0;
+         if (t_module->reorder)
+         {
+            if (bytes_read >= RTP_HEADER_SIZE && (packet[0] >> 6) == 2)
+               vc_containers_reorder_insert(t_module->reorder,
+                     (packet[2] << 8) | packet[3], packet, bytes_read);
+            continue;
+         }
+      }
+      else
+      {
+         /* No data left from last RTP packet, get another one */
+         bytes_read = READ_BYTES(p_ctx, t_module->buffer, MAXIMUM_PACKET_SIZE);
+         if (!bytes_read)
+         {
+            /* Drain the jitter buffer before reporting the stream status */
+            if (t_module->reorder)
+               bytes_read = vc_containers_reorder_remove(t_module->reorder,
+                     t_module->buffer, MAXIMUM_PACKET_SIZE);
+            if (!bytes_read)
+               return STREAM_STATUS(p_ctx);
+         }
+         else if (t_module->reorder)
+         {
+            /* Hold the packet in the jitter buffer so that any reordering can
+             * be undone. Late packets and duplicates are dropped here; since
+             * delivery is checked before every read, the buffer cannot
+             * overflow. The sequence number sits at a fixed offset in the
+             * fixed header, so it can be picked out before full decoding. */
+            if (bytes_read >= RTP_HEADER_SIZE && (t_module->buffer[0] >> 6) == 2)
+               vc_containers_reorder_insert(t_module->reorder,
+                     (t_module->buffer[2] << 8) | t_module->buffer[3],
+                     t_module->buffer, bytes_read);
+            continue;
+         }
+      }
 
-      BITS_INIT(p_ctx, &t_module->payload, t_module->buffer, bytes_read);
+      BITS_INIT(p_ctx, &t_module->payload, packet, bytes_read);
 
       decode_rtp_packet_header(p_ctx, t_module);
       SET_BIT(t_module->flags, TRACK_NEW_PACKET);
@@ -1013,6 +1074,25 @@ static VC_CONTAINER_STATUS_T rtp_reader_control( VC_CONTAINER_T *p_ctx,
          status = VC_CONTAINER_SUCCESS;
       }
       break;
+   case VC_CONTAINER_CONTROL_PACKET_PUSH:
+      {
+         uint8_t *data = va_arg(args, uint8_t *);
+         uint32_t size = va_arg(args, uint32_t);
+
+         if (BIT_IS_CLEAR(t_module->flags, TRACK_PUSHED_DATA) || !data || !size)
+            status = VC_CONTAINER_ERROR_INVALID_ARGUMENT;
+         else if (t_module->pushed_size || BITS_AVAILABLE(p_ctx, &t_module->payload))
+            status = VC_CONTAINER_ERROR_NOT_READY;
+         else
+         {
+            /* The buffer is borrowed, not copied: the pusher guarantees it
+             * stays valid until this reader has consumed the packet */
+            t_module->pushed_data = data;
+            t_module->pushed_size = size;
+            status = VC_CONTAINER_SUCCESS;
+         }
+      }
+      break;
    default:
       status = VC_CONTAINER_ERROR_UNSUPPORTED_OPERATION;
    }
@@ -1044,6 +1124,7 @@ static VC_CONTAINER_STATUS_T rtp_reader_close( VC_CONTAINER_T *p_ctx )
       payload_extra = module->track->priv->module->extra;
       if (payload_extra)
          free(payload_extra);
+      vc_containers_reorder_destroy(module->track->priv->module->reorder);
       vc_container_free_track(p_ctx, module->track);
    }
    p_ctx->tracks = NULL;
@@ -1069,11 +1150,13 @@ VC_CONTAINER_STATUS_T rtp_reader_open( VC_CONTAINER_T *p_ctx )
    VC_CONTAINERS_LIST_T *parameters = NULL;
    uint32_t payload_type;
    uint32_t initial_seq_num;
+   uint32_t reorder_depth;
 
    /* Check the URI scheme looks valid */
    if (!vc_uri_scheme(p_ctx->priv->uri) ||
        (strcasecmp(vc_uri_scheme(p_ctx->priv->uri), RTP_SCHEME) &&
-        strcasecmp(vc_uri_scheme(p_ctx->priv->uri), RTP_PKT_SCHEME)))
+        strcasecmp(vc_uri_scheme(p_ctx->priv->uri), RTP_PKT_SCHEME) &&
+        strcasecmp(vc_uri_scheme(p_ctx->priv->uri), RTP_PUSH_SCHEME)))
       return VC_CONTAINER_ERROR_FORMAT_NOT_SUPPORTED;
 
    /* Make the query/parameter list more easily searchable */
@@ -1121,6 +1204,24 @@ VC_CONTAINER_STATUS_T rtp_reader_open( VC_CONTAINER_T *p_ctx )
    if (rtp_get_parameter_x32(parameters, SSRC_NAME, &t_module->expected_ssrc))
       SET_BIT(t_module->flags, TRACK_SSRC_SET);
 
+   /* With the push scheme, packets are handed to the reader through the
+    * packet push control instead of being read from the i/o */
+   if (!strcasecmp(vc_uri_scheme(p_ctx->priv->uri), RTP_PUSH_SCHEME))
+      SET_BIT(t_module->flags, TRACK_PUSHED_DATA);
+
+   /* Optionally undo network packet reordering through a jitter buffer. The
+    * parameter gives the depth in packets, which bounds both the added
+    * latency and the memory used. */
+   if (rtp_get_parameter_u32(parameters, REORDER_NAME, &reorder_depth) && reorder_depth)
+   {
+      t_module->reorder = vc_containers_reorder_create(reorder_depth, MAXIMUM_PACKET_SIZE);
+      if (!t_module->reorder)
+      {
+         status = VC_CONTAINER_ERROR_OUT_OF_MEMORY;
+         goto error;
+      }
+   }
+
    t_module->probation = MIN_SEQUENTIAL;
    if (rtp_get_parameter_u32(parameters, SEQ_NAME, &initial_seq_num))
    {
@@ -94,6 +94,9 @@ Defines and constants.
 /** Format for the Transport: header */
 #define TRANSPORT_HEADER_FORMAT        "Transport: RTP/AVP;unicast;client_port=%hu-%hu;mode=play\r\n"
 
+/** Format for the Transport: header when interleaving RTP on the RTSP connection */
+#define TRANSPORT_TCP_HEADER_FORMAT    "Transport: RTP/AVP/TCP;unicast;interleaved=%u-%u;mode=play\r\n"
+
 /** Format for including Session: header. */
 #define SESSION_HEADER_FORMAT          "Session: %s\r\n"
 
@@ -113,6 +116,7 @@ Defines and constants.
 #define CONTENT_LOCATION_NAME          "Content-Location"
 #define RTP_INFO_NAME                  "RTP-Info"
 #define SESSION_NAME                   "Session"
+#define TRANSPORT_NAME                 "Transport"
 /* @} */
 
 /** Supported RTSP major version number */
@@ -145,6 +149,24 @@ Defines and constants.
 #define CHANNELS_NAME                  "channels"
 /* @} */
 
+/** RTSP URI query parameter that selects interleaving the RTP data on the
+ * RTSP connection instead of using separate UDP ports */
+#define INTERLEAVED_NAME               "interleaved"
+
+/** Scheme used for track readers that have their packets pushed to them */
+#define RTP_PUSH_SCHEME                "rtppush"
+
+/** URI query parameter used to name the container to handle the URI */
+#define CONTAINER_NAME                 "container"
+
+/** Start-of-frame marker for interleaved binary data */
+#define INTERLEAVED_MARKER             '$'
+/** Size of an interleaved frame header: marker, channel and 16-bit length */
+#define INTERLEAVED_HEADER_SIZE        4
+/** Size of the buffer used to receive interleaved frames. Has to be able to
+ * hold the largest frame the 16-bit length field can describe. */
+#define INTERLEAVED_BUFFER_SIZE        (INTERLEAVED_HEADER_SIZE + 0xFFFF)
+
 /** Largest signed 64-bit integer */
 #define MAXIMUM_INT64                  (int64_t)((1ULL << 63) - 1)
 
@@ -170,6 +192,7 @@ typedef struct VC_CONTAINER_TRACK_MODULE_T
    char *media_type;                /**< MIME type for track */
    VC_CONTAINER_PACKET_T info;      /**< Latest track packet info block */
    unsigned short rtp_port;       /**< UDP listener port being used in RTP reader */
+   uint8_t channel;                 /**< Interleaved channel carrying this track's RTP data */
 } VC_CONTAINER_TRACK_MODULE_T;
 
 typedef struct VC_CONTAINER_MODULE_T
@@ -181,6 +204,11 @@ typedef struct VC_CONTAINER_MODULE_T
    uint16_t next_rtp_port;                      /**< Next RTP port to use when opening track reader */
    uint16_t media_item;                         /**< Current media item number during initialization */
    bool uri_has_network_info;                   /**< True if the RTSP URI contains network info */
+   bool interleaved;                            /**< True if RTP data arrives interleaved on the RTSP connection */
+   uint8_t *interleaved_buffer;                 /**< Buffer into which interleaved frames are received */
+   uint32_t interleaved_bytes;                  /**< Number of bytes held in the interleaved buffer */
+   uint32_t interleaved_parsed;                 /**< Number of held bytes already parsed into frames */
+   uint8_t next_channel;                        /**< Next interleaved channel pair to request */
    int64_t ts_base;                             /**< Base value for dts and pts */
    VC_CONTAINER_TRACK_MODULE_T *current_track;  /**< Next track to be read, to keep info/data on same track */
 } VC_CONTAINER_MODULE_T;
@@ -298,7 +326,12 @@ static VC_CONTAINER_STATUS_T rtsp_send_setup_request( VC_CONTAINER_T *p_ctx,
 
    ptr += snprintf(ptr, end - ptr, RTSP_REQUEST_LINE_FORMAT, SETUP_METHOD, uri);
    if (ptr < end)
-      ptr += snprintf(ptr, end - ptr, TRANSPORT_HEADER_FORMAT, t_module->rtp_port, t_module->rtp_port + 1);
+   {
+      if (module->interleaved)
+         ptr += snprintf(ptr, end - ptr, TRANSPORT_TCP_HEADER_FORMAT, t_module->channel, t_module->channel + 1);
+      else
+         ptr += snprintf(ptr, end - ptr, TRANSPORT_HEADER_FORMAT, t_module->rtp_port, t_module->rtp_port + 1);
+   }
    if (ptr < end)
       ptr += snprintf(ptr, end - ptr, TRAILING_HEADERS_FORMAT, module->cseq_value++);
    vc_container_assert(ptr < end);
@@ -621,6 +654,34 @@ static bool rtsp_parse_extract_parameter(char **parse_str, char **p_name, char *
    return (**p_name != '\0');
 }
 
+/**************************************************************************//**
+ * Parses the Transport header of a SETUP response and stores the interleaved
+ * channel number assigned by the server, if there is one. If the server did
+ * not report a channel, the one that was requested remains in use.
+ *
+ * @param header_list   The response header list.
+ * @param t_module      The track module relating to the response headers.
+ */
+static void rtsp_store_interleaved_channel(VC_CONTAINERS_LIST_T *header_list,
+      VC_CONTAINER_TRACK_MODULE_T *t_module )
+{
+   RTSP_HEADER_T header;
+   char *ptr;
+   unsigned int channel;
+
+   header.name = TRANSPORT_NAME;
+   if (!vc_containers_list_find_entry(header_list, &header))
+      return;
+
+   ptr = strstr(header.value, "interleaved=");
+   if (!ptr)
+      return;
+
+   /* coverity[secure_coding] String is null-terminated */
+   if (sscanf(ptr + sizeof("interleaved=") - 1, "%u", &channel) == 1 && channel < 0xFF)
+      t_module->channel = (uint8_t)channel;
+}
+
 /**************************************************************************//**
  * Parses RTP-Info header and stores relevant parts.
  *
@@ -805,6 +866,105 @@ static VC_CONTAINER_STATUS_T rtsp_read_response( VC_CONTAINER_T *p_ctx )
    return p_ctx_io->status;
 }
 
+/**************************************************************************//**
+ * Parses complete interleaved frames held in the interleaved buffer and hands
+ * them to their tracks' readers as slices of the buffer, without copying them.
+ * Frames on unrecognised channels (e.g. RTCP) and any RTSP message data mixed
+ * into the stream are skipped. Parsing stops when a reader cannot accept a
+ * further frame, leaving that frame for a later pass.
+ *
+ * @param p_ctx      The RTSP reader context.
+ * @param p_pushed   Set to true if at least one frame was handed to a reader.
+ */
+static void rtsp_parse_interleaved_frames( VC_CONTAINER_T *p_ctx,
+      bool *p_pushed )
+{
+   VC_CONTAINER_MODULE_T *module = p_ctx->priv->module;
+   uint8_t *buffer = module->interleaved_buffer;
+
+   while (module->interleaved_parsed < module->interleaved_bytes)
+   {
+      uint8_t *frame = buffer + module->interleaved_parsed;
+      uint32_t available = module->interleaved_bytes - module->interleaved_parsed;
+      uint32_t frame_size;
+      uint32_t track_idx;
+
+      if (*frame != INTERLEAVED_MARKER)
+      {
+         /* Not binary data, so part of an interleaved RTSP message. There is
+          * nothing useful to do with it but skip to the next frame. */
+         module->interleaved_parsed++;
+         continue;
+      }
+
+      /* Frame format: marker, channel number, 16-bit big-endian length */
+      if (available < INTERLEAVED_HEADER_SIZE)
+         break;
+      frame_size = (frame[2] << 8) | frame[3];
+      if (available < INTERLEAVED_HEADER_SIZE + frame_size)
+         break;
+
+      for (track_idx = 0; track_idx < p_ctx->tracks_num; track_idx++)
+      {
+         VC_CONTAINER_TRACK_MODULE_T *t_module = p_ctx->tracks[track_idx]->priv->module;
+
+         if (t_module->channel != frame[1])
+            continue;
+
+         if (vc_container_control(t_module->reader, VC_CONTAINER_CONTROL_PACKET_PUSH,
+                  frame + INTERLEAVED_HEADER_SIZE, frame_size) == VC_CONTAINER_ERROR_NOT_READY)
+            return;
+         *p_pushed = true;
+         break;
+      }
+
+      module->interleaved_parsed += INTERLEAVED_HEADER_SIZE + frame_size;
+   }
+}
+
+/**************************************************************************//**
+ * Receives and dispatches interleaved binary frames from the RTSP connection.
+ * Frames are parsed in place and handed to the track readers as slices of the
+ * interleaved buffer, so the buffer can only be refilled once all pushed
+ * frames have been consumed. That is guaranteed here because the caller only
+ * asks for more data once no track has any left.
+ *
+ * @param p_ctx   The RTSP reader context.
+ * @return  The resulting status of the function.
+ */
+static VC_CONTAINER_STATUS_T rtsp_read_interleaved( VC_CONTAINER_T *p_ctx )
+{
+   VC_CONTAINER_MODULE_T *module = p_ctx->priv->module;
+   uint8_t *buffer = module->interleaved_buffer;
+   bool pushed = false;
+   uint32_t received;
+
+   /* A complete frame may already be buffered from the last receive */
+   rtsp_parse_interleaved_frames(p_ctx, &pushed);
+   if (pushed)
+      return VC_CONTAINER_SUCCESS;
+
+   /* Nothing deliverable is buffered, so every frame handed out so far has
+    * been consumed and the buffer can be compacted and refilled. Only the
+    * tail of a partial frame ever needs to be moved. */
+   if (module->interleaved_parsed)
+   {
+      module->interleaved_bytes -= module->interleaved_parsed;
+      memmove(buffer, buffer + module->interleaved_parsed, module->interleaved_bytes);
+      module->interleaved_parsed = 0;
+   }
+
+   received = vc_container_io_read(p_ctx->priv->io, buffer + module->interleaved_bytes,
+         INTERLEAVED_BUFFER_SIZE - module->interleaved_bytes);
+   if (!received)
+      return p_ctx->priv->io->status;
+   module->interleaved_bytes += received;
+
+   rtsp_parse_interleaved_frames(p_ctx, &pushed);
+
+   return VC_CONTAINER_SUCCESS;
+}
+
 /**************************************************************************//**
  * Creates a new track from an SDP media field.
  * Limitation: only the first payload type of the field is used.
@@ -1347,7 +1507,20 @@ static VC_CONTAINER_STATUS_T rtsp_complete_track( VC_CONTAINER_T *p_ctx,
       return VC_CONTAINER_ERROR_FORMAT_INVALID;
    }
 
-   if (module->uri_has_network_info)
+   if (module->interleaved)
+   {
+      /* The track's packets arrive interleaved on the RTSP connection and are
+       * pushed to the reader, so it needs no transport of its own */
+      if (!vc_uri_set_scheme(t_module->reader_uri, RTP_PUSH_SCHEME) ||
+          !vc_uri_add_query(t_module->reader_uri, CONTAINER_NAME, "rtp"))
+      {
+         LOG_ERROR(p_ctx, "RTSP: Failed to set up pushed track reader URI");
+         return VC_CONTAINER_ERROR_OUT_OF_MEMORY;
+      }
+
+      status = rtsp_open_track_reader(p_ctx, t_module);
+   }
+   else if (module->uri_has_network_info)
    {
       int ii;
 
@@ -1596,13 +1769,39 @@ static VC_CONTAINER_STATUS_T rtsp_describe( VC_CONTAINER_T *p_ctx )
 }
 
 /**************************************************************************//**
- * Make a SETUP request to the server and get session from response.
+ * Send a SETUP request to the server for a track, without waiting for the
+ * response. Requests for several tracks can be pipelined on the connection
+ * before the responses are collected with rtsp_setup_receive().
  *
  * @param p_ctx      The RTSP reader context.
  * @param t_module   The track module to be set up.
  * @return  The resulting status of the function.
  */
-static VC_CONTAINER_STATUS_T rtsp_setup( VC_CONTAINER_T *p_ctx,
+static VC_CONTAINER_STATUS_T rtsp_setup_send( VC_CONTAINER_T *p_ctx,
+      VC_CONTAINER_TRACK_MODULE_T *t_module )
+{
+   VC_CONTAINER_MODULE_T *module = p_ctx->priv->module;
+
+   if (module->interleaved)
+   {
+      /* Request the next free channel pair; the server may assign another */
+      t_module->channel = module->next_channel;
+      module->next_channel += 2;
+   }
+
+   return rtsp_send_setup_request(p_ctx, t_module);
+}
+
+/**************************************************************************//**
+ * Read a SETUP response for a track and get the session from it.
+ * Responses arrive on the connection in the order the requests were sent, so
+ * this must be called with the same track ordering as rtsp_setup_send().
+ *
+ * @param p_ctx      The RTSP reader context.
+ * @param t_module   The track module being set up.
+ * @return  The resulting status of the function.
+ */
+static VC_CONTAINER_STATUS_T rtsp_setup_receive( VC_CONTAINER_T *p_ctx,
       VC_CONTAINER_TRACK_MODULE_T *t_module )
 {
    VC_CONTAINER_STATUS_T status = VC_CONTAINER_SUCCESS;
@@ -1610,11 +1809,12 @@ static VC_CONTAINER_STATUS_T rtsp_setup( VC_CONTAINER_T *p_ctx,
    const char *session_header;
    size_t session_header_len;
 
-   status = rtsp_send_setup_request(p_ctx, t_module);
-   if (status != VC_CONTAINER_SUCCESS) return status;
    status = rtsp_read_response(p_ctx);
    if (status != VC_CONTAINER_SUCCESS) return status;
 
+   if (module->interleaved)
+      rtsp_store_interleaved_channel(module->header_list, t_module);
+
    session_header = rtsp_get_session_header(module->header_list);
    session_header_len = strlen(session_header);
    if (session_header_len > SESSION_HEADER_LENGTH_MAX) return VC_CONTAINER_ERROR_FORMAT_INVALID;
@@ -1627,20 +1827,20 @@ static VC_CONTAINER_STATUS_T rtsp_setup( VC_CONTAINER_T *p_ctx,
 }
 
 /**************************************************************************//**
- * Make a SETUP request to the server and get session from response.
+ * Read a PLAY response for a track and store its RTP info.
+ * As with SETUP, the PLAY requests are pipelined and the responses collected
+ * in the same track order.
  *
  * @param p_ctx      The RTSP reader context.
- * @param t_module   The track module to be set up.
+ * @param t_module   The track module being played.
  * @return  The resulting status of the function.
  */
-static VC_CONTAINER_STATUS_T rtsp_play( VC_CONTAINER_T *p_ctx,
+static VC_CONTAINER_STATUS_T rtsp_play_receive( VC_CONTAINER_T *p_ctx,
       VC_CONTAINER_TRACK_MODULE_T *t_module )
 {
    VC_CONTAINER_STATUS_T status = VC_CONTAINER_SUCCESS;
    VC_CONTAINER_MODULE_T *module = p_ctx->priv->module;
 
-   status = rtsp_send_play_request(p_ctx, t_module);
-   if (status != VC_CONTAINER_SUCCESS) return status;
    status = rtsp_read_response(p_ctx);
    if (status != VC_CONTAINER_SUCCESS) return status;
 
@@ -1781,8 +1981,12 @@ static VC_CONTAINER_STATUS_T rtsp_reader_read( VC_CONTAINER_T *p_ctx,
 
       while (!module->current_track)
       {
-         /* Check RTSP stream to see if it has closed */
-         status = rtsp_read_response(p_ctx);
+         /* Pump the RTSP stream: receive interleaved data, or just check
+          * whether the stream has closed */
+         if (module->interleaved)
+            status = rtsp_read_interleaved(p_ctx);
+         else
+            status = rtsp_read_response(p_ctx);
          if (status == VC_CONTAINER_SUCCESS || status == VC_CONTAINER_ERROR_ABORTED)
          {
             /* No data from any track yet, so keep checking */
@@ -1899,6 +2103,8 @@ static VC_CONTAINER_STATUS_T rtsp_reader_close( VC_CONTAINER_T *p_ctx )
    {
       if (module->comms_buffer)
          free(module->comms_buffer);
+      if (module->interleaved_buffer)
+         free(module->interleaved_buffer);
       if (module->header_list)
          vc_containers_list_destroy(module->header_list);
       free(module);
@@ -1943,16 +2149,37 @@ VC_CONTAINER_STATUS_T rtsp_reader_open( VC_CONTAINER_T *p_ctx )
    module->comms_buffer = (char *)calloc(1, COMMS_BUFFER_SIZE+1);
    if (!module->comms_buffer) { status = VC_CONTAINER_ERROR_OUT_OF_MEMORY; goto error; }
 
+   /* Optionally interleave the RTP data on the RTSP connection itself,
+    * instead of receiving each track on its own pair of UDP ports */
+   module->interleaved = module->uri_has_network_info &&
+         vc_uri_find_query(p_ctx->priv->uri, 0, INTERLEAVED_NAME, NULL);
+   if (module->interleaved)
+   {
+      module->interleaved_buffer = (uint8_t *)malloc(INTERLEAVED_BUFFER_SIZE);
+      if (!module->interleaved_buffer) { status = VC_CONTAINER_ERROR_OUT_OF_MEMORY; goto error; }
+   }
+
    /* header_list will contain pointers into the response_buffer, so take care in re-use */
    module->header_list = vc_containers_list_create(HEADER_LIST_INITIAL_CAPACITY, sizeof(RTSP_HEADER_T),
          (VC_CONTAINERS_LIST_COMPARATOR_T)rtsp_header_comparator);
    if (!module->header_list) { status = VC_CONTAINER_ERROR_OUT_OF_MEMORY; goto error; }
 
    status = rtsp_describe(p_ctx);
+
+   /* Pipeline the SETUP and PLAY exchanges: all the requests of a phase are
+    * sent back-to-back and their responses, which the server returns in
+    * request order on the connection, are collected afterwards. Starting a
+    * multi-track session then costs one round trip per phase rather than one
+    * per track. The per-track RTP sockets were already opened while parsing
+    * the SDP data, so they are ready by the time the first response is in. */
+   for (ii = 0; status == VC_CONTAINER_SUCCESS && ii < p_ctx->tracks_num; ii++)
+      status = rtsp_setup_send(p_ctx, p_ctx->tracks[ii]->priv->module);
+   for (ii = 0; status == VC_CONTAINER_SUCCESS && ii < p_ctx->tracks_num; ii++)
+      status = rtsp_setup_receive(p_ctx, p_ctx->tracks[ii]->priv->module);
    for (ii = 0; status == VC_CONTAINER_SUCCESS && ii < p_ctx->tracks_num; ii++)
-      status = rtsp_setup(p_ctx, p_ctx->tracks[ii]->priv->module);
+      status = rtsp_send_play_request(p_ctx, p_ctx->tracks[ii]->priv->module);
    for (ii = 0; status == VC_CONTAINER_SUCCESS && ii < p_ctx->tracks_num; ii++)
-      status = rtsp_play(p_ctx, p_ctx->tracks[ii]->priv->module);
+      status = rtsp_play_receive(p_ctx, p_ctx->tracks[ii]->priv->module);
    if (status != VC_CONTAINER_SUCCESS)
       goto error;
 
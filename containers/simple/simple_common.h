@@ -38,5 +38,32 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define CONFIG_UNFRAMED                 "UNFRAMED"
 #define CONFIG_VIDEO_CROP               "VIDEO_CROP"
 #define CONFIG_VIDEO_ASPECT             "VIDEO_ASPECT"
+#define CONFIG_RECORDS                  "RECORDS"
+#define CONFIG_ARRIVAL                  "ARRIVAL"
+
+/** Version 2 of the format appends a fixed-stride binary record table to the
+ * text header, followed by a single payload region holding the data of all
+ * the tracks, so a reader can index packets with pointer arithmetic instead
+ * of parsing per-packet metadata lines.
+ * A v2 file declares itself with a "RECORDS <count>" line in the header; the
+ * record table starts straight after the header end signature and the payload
+ * region straight after the table.
+ *
+ * Record table entry layout (all fields little endian):
+ *   bytes  0-7   u64  payload offset relative to the start of the payload region
+ *   bytes  8-11  u32  payload size
+ *   bytes 12-15  u32  track number
+ *   bytes 16-23  s64  pts in microseconds (VC_CONTAINER_TIME_UNKNOWN if not set)
+ *   bytes 24-27  u32  packet flags (VC_CONTAINER_PACKET_FLAG_* values)
+ *   bytes 28-31       reserved, must be zero unless the header declares
+ *                     "ARRIVAL 1", in which case they hold a u32 arrival time
+ *                     in microseconds relative to the first record. Arrival
+ *                     times are written by capture tools which record when
+ *                     each packet was seen, so a replay tool can reproduce
+ *                     the original delivery schedule. Readers which do not
+ *                     understand the declaration can safely ignore the field.
+ */
+#define SIMPLE_V2_RECORD_SIZE 32
+#define SIMPLE_V2_MAX_RECORDS (1<<20)
 
 #endif /* SIMPLE_COMMON_H */
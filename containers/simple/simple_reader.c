@@ -60,6 +60,7 @@ typedef struct SIMPLE_PACKET_STATE_T
    unsigned int flags;
 
    uint64_t metadata_offset; /* Offset in metadata stream */
+   uint32_t record;          /* Index of the next record (v2 only) */
    uint32_t data_size;       /* Size of current data packet */
    uint32_t data_left;       /* Data left to read in current packet */
 
@@ -67,6 +68,17 @@ typedef struct SIMPLE_PACKET_STATE_T
 
 } SIMPLE_PACKET_STATE_T;
 
+/** In-memory form of a v2 record table entry */
+typedef struct SIMPLE_V2_RECORD_T
+{
+   uint64_t offset;          /* Offset relative to the start of the payload region */
+   uint32_t size;
+   uint32_t track;
+   int64_t pts;
+   uint32_t flags;
+
+} SIMPLE_V2_RECORD_T;
+
 typedef struct VC_CONTAINER_TRACK_MODULE_T
 {
    SIMPLE_PACKET_STATE_T *state;
@@ -88,6 +100,11 @@ typedef struct VC_CONTAINER_MODULE_T
 
    int64_t metadata_offset;
 
+   /* V2 record table */
+   SIMPLE_V2_RECORD_T *v2_table;
+   uint32_t v2_record_count;
+   uint64_t v2_payload_offset;
+
    /* Shared packet state. This is used when the tracks are in sync,
     * and for the track at the earliest position in the file when they are
     * not in sync */
@@ -135,13 +152,60 @@ static VC_CONTAINER_STATUS_T simple_read_line( VC_CONTAINER_T *ctx )
    return VC_CONTAINER_SUCCESS;
 }
 
+static uint32_t simple_v2_u32( const uint8_t *p )
+{
+   return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint64_t simple_v2_u64( const uint8_t *p )
+{
+   return simple_v2_u32(p) | ((uint64_t)simple_v2_u32(p + 4) << 32);
+}
+
+/** Load the v2 record table which sits between the header and the payload
+ * region. Once in memory, finding a packet is just pointer arithmetic. */
+static VC_CONTAINER_STATUS_T simple_read_v2_table( VC_CONTAINER_T *ctx )
+{
+   VC_CONTAINER_MODULE_T *module = ctx->priv->module;
+   uint8_t record[SIMPLE_V2_RECORD_SIZE];
+   unsigned int i;
+
+   if (!module->v2_record_count ||
+       module->v2_record_count > SIMPLE_V2_MAX_RECORDS)
+   {
+      LOG_ERROR(ctx, "invalid record count: %u", module->v2_record_count);
+      return VC_CONTAINER_ERROR_FORMAT_INVALID;
+   }
+
+   module->v2_table = malloc(module->v2_record_count * sizeof(*module->v2_table));
+   if (!module->v2_table)
+      return VC_CONTAINER_ERROR_OUT_OF_MEMORY;
+
+   for (i = 0; i < module->v2_record_count; i++)
+   {
+      SIMPLE_V2_RECORD_T *rec = &module->v2_table[i];
+
+      if (READ_BYTES(ctx, record, sizeof(record)) != sizeof(record))
+         return VC_CONTAINER_ERROR_CORRUPTED;
+
+      rec->offset = simple_v2_u64(record);
+      rec->size = simple_v2_u32(record + 8);
+      rec->track = simple_v2_u32(record + 12);
+      rec->pts = (int64_t)simple_v2_u64(record + 16);
+      rec->flags = simple_v2_u32(record + 24);
+   }
+
+   module->v2_payload_offset = STREAM_POSITION(ctx);
+   return VC_CONTAINER_SUCCESS;
+}
+
 static VC_CONTAINER_STATUS_T simple_read_header( VC_CONTAINER_T *ctx )
 {
    VC_CONTAINER_MODULE_T *module = ctx->priv->module;
    VC_CONTAINER_TRACK_T *track = NULL;
    VC_CONTAINER_FOURCC_T fourcc;
    int matches, width, height, channels, samplerate, bps, blockalign, value;
-   unsigned int lines = 1;
+   unsigned int lines = 1, records;
 
    /* Skip the signature */
    if (simple_read_line(ctx) != VC_CONTAINER_SUCCESS)
@@ -207,6 +271,14 @@ static VC_CONTAINER_STATUS_T simple_read_header( VC_CONTAINER_T *ctx )
          }
       }
 
+      /* V2 record table declaration, applies to the whole file */
+      if (sscanf(module->line, CONFIG_RECORDS" %u", &records) == 1)
+      {
+         module->v2_record_count = records;
+         LOG_FORMAT(ctx, CONFIG_RECORDS": %u", records);
+         continue;
+      }
+
       if (!track)
          continue; /* Nothing interesting */
 
@@ -329,23 +401,41 @@ static VC_CONTAINER_STATUS_T simple_reader_read( VC_CONTAINER_T *ctx,
    if (!state->data_left)
    {
       unsigned int track_num, size;
+      uint64_t data_offset = 0;
       int64_t pts;
       int flags;
 
-      SEEK(ctx, state->metadata_offset);
-      status = simple_read_line(ctx);
-      if (status != VC_CONTAINER_SUCCESS)
-         return status;
+      if (module->v2_table)
+      {
+         SIMPLE_V2_RECORD_T *rec;
 
-      if (sscanf(module->line, "%u %u %"PRIi64" %i",
-             &track_num, &size, &pts, &flags) != 4 &&
-           (track_num = 0, sscanf(module->line, "%u %"PRIi64" %i",
-             &size, &pts, &flags)) != 3)
+         if (state->record >= module->v2_record_count)
+            return VC_CONTAINER_ERROR_EOS;
+
+         rec = &module->v2_table[state->record++];
+         track_num = rec->track;
+         size = rec->size;
+         pts = rec->pts;
+         flags = rec->flags;
+         data_offset = module->v2_payload_offset + rec->offset;
+      }
+      else
       {
-         LOG_ERROR(ctx, "invalid metadata: %s", module->line);
-         return VC_CONTAINER_ERROR_CORRUPTED;
+         SEEK(ctx, state->metadata_offset);
+         status = simple_read_line(ctx);
+         if (status != VC_CONTAINER_SUCCESS)
+            return status;
+
+         if (sscanf(module->line, "%u %u %"PRIi64" %i",
+                &track_num, &size, &pts, &flags) != 4 &&
+              (track_num = 0, sscanf(module->line, "%u %"PRIi64" %i",
+                &size, &pts, &flags)) != 3)
+         {
+            LOG_ERROR(ctx, "invalid metadata: %s", module->line);
+            return VC_CONTAINER_ERROR_CORRUPTED;
+         }
+         state->metadata_offset = STREAM_POSITION(ctx);
       }
-      state->metadata_offset = STREAM_POSITION(ctx);
 
       if (track_num >= ctx->tracks_num)
       {
@@ -368,8 +458,18 @@ static VC_CONTAINER_STATUS_T simple_reader_read( VC_CONTAINER_T *ctx,
 
       state->data_size = state->data_left = size;
       state->track_num = track_num;
-      state->flags = simple_convert_packet_flags(ctx, track_num, flags);
-      state->pts = simple_convert_packet_pts(ctx, track_num, pts, flags);
+      if (module->v2_table)
+      {
+         /* V2 records store native packet flags and pts */
+         state->flags = flags;
+         state->pts = pts;
+         ctx->tracks[track_num]->priv->module->data_offset = data_offset;
+      }
+      else
+      {
+         state->flags = simple_convert_packet_flags(ctx, track_num, flags);
+         state->pts = simple_convert_packet_pts(ctx, track_num, pts, flags);
+      }
 
       /* Discard empty packets */
       if (!state->data_size && !state->flags)
@@ -446,11 +546,55 @@ static VC_CONTAINER_STATUS_T simple_reader_read( VC_CONTAINER_T *ctx,
 static VC_CONTAINER_STATUS_T simple_reader_seek( VC_CONTAINER_T *ctx, int64_t *offset,
    VC_CONTAINER_SEEK_MODE_T mode, VC_CONTAINER_SEEK_FLAGS_T flags)
 {
-   VC_CONTAINER_PARAM_UNUSED(ctx);
-   VC_CONTAINER_PARAM_UNUSED(offset);
+   VC_CONTAINER_MODULE_T *module = ctx->priv->module;
+   uint32_t i, target = 0, wanted_flags;
+   bool found = false;
    VC_CONTAINER_PARAM_UNUSED(mode);
-   VC_CONTAINER_PARAM_UNUSED(flags);
-   return VC_CONTAINER_ERROR_UNSUPPORTED_OPERATION;
+
+   /* Only v2 files can seek, using the record table */
+   if (!module->v2_table)
+      return VC_CONTAINER_ERROR_UNSUPPORTED_OPERATION;
+
+   /* Find the last independent point before the requested time. If the
+      stream has no keyframes marked, fall back to frame starts. */
+   for (wanted_flags = VC_CONTAINER_PACKET_FLAG_KEYFRAME |
+           VC_CONTAINER_PACKET_FLAG_FRAME_START;
+        !found && wanted_flags;
+        wanted_flags = (wanted_flags & VC_CONTAINER_PACKET_FLAG_KEYFRAME) ?
+           VC_CONTAINER_PACKET_FLAG_FRAME_START : 0)
+   {
+      for (i = 0; i < module->v2_record_count; i++)
+      {
+         SIMPLE_V2_RECORD_T *rec = &module->v2_table[i];
+
+         if ((rec->flags & wanted_flags) != wanted_flags)
+            continue;
+         if (rec->pts > *offset)
+         {
+            if ((flags & VC_CONTAINER_SEEK_FLAG_FORWARD) || !found)
+            {
+               target = i;
+               found = true;
+            }
+            break;
+         }
+         target = i;
+         found = true;
+      }
+   }
+
+   if (!found)
+      return VC_CONTAINER_ERROR_EOS;
+
+   /* Reconnect all the tracks to the global state and restart from there */
+   module->state.record = target;
+   module->state.data_size = 0;
+   module->state.data_left = 0;
+   for (i = 0; i < ctx->tracks_num; i++)
+      ctx->tracks[i]->priv->module->state = &module->state;
+
+   *offset = module->v2_table[target].pts;
+   return VC_CONTAINER_SUCCESS;
 }
 
 /*****************************************************************************/
@@ -461,11 +605,12 @@ static VC_CONTAINER_STATUS_T simple_reader_close( VC_CONTAINER_T *ctx )
    for (; ctx->tracks_num > 0; ctx->tracks_num--)
    {
       VC_CONTAINER_TRACK_T *track = ctx->tracks[ctx->tracks_num-1];
-      if (track->priv->module->io)
+      if (track->priv->module->io && track->priv->module->io != ctx->priv->io)
          vc_container_io_close(track->priv->module->io);
       vc_container_free_track(ctx, track);
    }
 
+   if (module->v2_table) free(module->v2_table);
    free(module);
    return VC_CONTAINER_SUCCESS;
 }
@@ -496,8 +641,22 @@ VC_CONTAINER_STATUS_T simple_reader_open( VC_CONTAINER_T *ctx )
    if (status != VC_CONTAINER_SUCCESS)
       goto error;
 
+   /* A v2 file carries the record table and the payload of all its tracks in
+      the file itself so there are no elementary streams to open */
+   if (module->v2_record_count)
+   {
+      status = simple_read_v2_table(ctx);
+      if (status != VC_CONTAINER_SUCCESS)
+         goto error;
+
+      for (i = 0; i < ctx->tracks_num; i++)
+         ctx->tracks[i]->priv->module->io = ctx->priv->io;
+
+      ctx->capabilities |= VC_CONTAINER_CAPS_CAN_SEEK;
+   }
+
    /* Open all the elementary streams */
-   for (i = 0; i < ctx->tracks_num; i++)
+   for (i = 0; !module->v2_table && i < ctx->tracks_num; i++)
    {
       VC_CONTAINER_TRACK_T *track = ctx->tracks[i];
       char *uri;
@@ -34,6 +34,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <list>
 #include <algorithm>
 #include <iomanip>
+#include <chrono>
 
 // MS compilers require __cdecl calling convention on some callbacks. Other compilers reject it.
 #if (!defined(_MSC_VER) && !defined(__cdecl))
@@ -222,6 +223,15 @@ struct CONFIGURATION_T
    // Defaults to -ve value, which means don't do this test.
    double packet_buffer_size;
 
+   // If set by -P a performance test is run after the correctness tests, measuring
+   // demux throughput and seek latency. The figures are compared against the ones
+   // recorded in the baseline file, and any figure more than 10% worse is an error.
+   // If the baseline file does not exist it is created from this run's figures.
+   bool perf_test;
+
+   // The baseline file used by -P. Defaults to the source name with ".perf" appended.
+   std::string perf_baseline;
+
    // Constructor
    CONFIGURATION_T(int argc, char** argv)
       : mem_max(0x40000000)   // 1Gb for 32-bit system friendliness.
@@ -235,6 +245,7 @@ struct CONFIGURATION_T
       , tolerance_other_early(100000)   // 100k uS = 100mS
       , tolerance_other_late(1000000)   // 1000k uS = 1S
       , packet_buffer_size(-1)
+      , perf_test(false)
    {
       if (argc < 2)
       {
@@ -243,6 +254,8 @@ struct CONFIGURATION_T
             "-k     keep going on errors" << std::endl <<
             "-m     max memory buffer for packet data (default 1Gb). If the file is large not all will be validated properly." << std::endl <<
             "-p     re-read using a small packet buffer. If >= 1 this is a size; if < 1 a proportion of the packet" << std::endl <<
+            "-P     performance test (to baseline file if specified, else <source>.perf)." << std::endl <<
+            "         The first run records a baseline; later runs fail on >10% regressions" << std::endl <<
             "-v     verbose mode." << std::endl <<
             "         -vi input verbosity only" << std::endl <<
             "         -vo output verbosity only" << std::endl <<
@@ -448,6 +461,15 @@ struct CONFIGURATION_T
                }
                break;
 
+            case 'P':
+               // performance test against a recorded baseline
+               perf_test = true;
+               if (argstr.size() > 1)
+               {
+                  perf_baseline.assign(argstr.begin() + 1, argstr.end());
+               }
+               break;
+
                // verbosity. v, vi or vo followed by zero or more extra v.
             case 'v':
                process_vees(arg, argstr);
@@ -466,6 +488,12 @@ struct CONFIGURATION_T
          exit(VC_CONTAINER_ERROR_URI_NOT_FOUND);
       }
 
+      // If no baseline file was named with -P derive one from the source.
+      if (perf_test && perf_baseline.empty())
+      {
+         perf_baseline = source_name + ".perf";
+      }
+
       if (verbosity != 0)
       {
          if (verbosity_input == 0)
@@ -491,6 +519,11 @@ struct CONFIGURATION_T
       std::cout << " Other Early:       " << tolerance_other_early            << std::endl;
       std::cout << " Other Late:        " << tolerance_other_late             << std::endl;
       std::cout << "Dump Summary:       " << (dump_packets ? 'Y' : 'N')       << std::endl;
+
+      if (perf_test)
+      {
+         std::cout << "Perf baseline:      " << perf_baseline                 << std::endl;
+      }
    }
 private:
 
@@ -716,6 +749,14 @@ public:
          }
       }
 
+      // Performance measurement, if requested. This runs last so the correctness
+      // tests have already paged the file in - what it times is parsing cost,
+      // not disc speed, which is the figure we want to track between builds.
+      if (configuration.perf_test)
+      {
+         measure_performance();
+      }
+
       std::cout << "Test Complete" << std::endl;
 
       // If anything failed then the error logger will replace this error code. So always return 0 from here.
@@ -1733,6 +1774,177 @@ private:
       }
    };
 
+   // The figures recorded in a performance baseline, and produced by a measurement run.
+   struct PERF_FIGURES_T
+   {
+      double mbytes_per_sec;     // demux throughput, megabytes of packet payload per second
+      double packets_per_sec;    // demux throughput, packets per second
+      double seek_latency_us;    // mean vc_container_seek time in microseconds, or 0 if not seekable
+
+      PERF_FIGURES_T(): mbytes_per_sec(0), packets_per_sec(0), seek_latency_us(0)
+      {}
+   };
+
+   // Read a monotonic clock, in microseconds. Only differences are meaningful.
+   static int64_t microseconds_now()
+   {
+      return std::chrono::duration_cast<std::chrono::microseconds>(
+         std::chrono::steady_clock::now().time_since_epoch()).count();
+   }
+
+   // Measure demux throughput and seek latency, then compare against the recorded
+   // baseline. A missing baseline file is created from this run's figures. An
+   // existing one makes any figure more than 10% worse than recorded an error.
+   void measure_performance()
+   {
+      PERF_FIGURES_T measured;
+
+      // Timed sequential read of the whole file. Same buffer scheme as read_sequential,
+      // but without the CRC and copying overheads, which would swamp the parser cost.
+      {
+         std::vector<uint8_t> buffer(256*1024, 0);
+         uint64_t bytes = 0;
+         uint64_t packets = 0;
+
+         re_seek_to_beginning();
+
+         int64_t start = microseconds_now();
+
+         while (1)   //  We break out at EOF.
+         {
+            VC_CONTAINER_PACKET_T info;
+            memset(&info, 0, sizeof(info));
+            info.data = &buffer[0];
+            info.buffer_size = buffer.size();
+
+            status = vc_container_read(p_ctx, &info, 0);
+
+            if (status == VC_CONTAINER_ERROR_EOS)
+            {
+               break;
+            }
+
+            if (status != VC_CONTAINER_SUCCESS)
+            {
+               error_logger << "Error " << status << " reading packet during timed demux" << std::ends;
+               return;
+            }
+
+            bytes += info.size;
+            ++packets;
+         }
+
+         int64_t elapsed = microseconds_now() - start;
+
+         // A tiny file could read in under the resolution of the clock. Don't divide by zero.
+         if (elapsed <= 0)
+         {
+            elapsed = 1;
+         }
+
+         measured.mbytes_per_sec = (double)bytes / (double)elapsed;  // bytes/uS is the same as Mbytes/S
+         measured.packets_per_sec = (double)packets * 1000000.0 / (double)elapsed;
+
+         std::cout << "Demux throughput:   " << measured.mbytes_per_sec << " MB/s, "
+            << measured.packets_per_sec << " packets/s" << std::endl;
+      }
+
+      // Timed seeks to key frame positions, if the container supports seeking.
+      if ((p_ctx->capabilities & VC_CONTAINER_CAPS_CAN_SEEK)
+         && (all_key_packets.find(video_stream) != all_key_packets.end()))
+      {
+         const TIMED_PACKETS_T& keys = all_key_packets.at(video_stream);
+
+         // If there are more than 100 key frames time every Nth, so a long file
+         // doesn't take forever but the seeks still span the whole index.
+         size_t step = (keys.size() + 99) / 100;
+         size_t seeks = 0;
+         size_t position = 0;
+         int64_t total = 0;
+
+         for (TIMED_PACKETS_T::const_iterator key = keys.begin(); key != keys.end(); ++key, ++position)
+         {
+            if (position % step != 0)
+            {
+               continue;
+            }
+
+            // copy the PTS value to pass to vc_container_seek
+            PTS_T actual_pts = key->first;
+
+            int64_t start = microseconds_now();
+            status = vc_container_seek(p_ctx, &actual_pts, VC_CONTAINER_SEEK_MODE_TIME, 0);
+            total += microseconds_now() - start;
+
+            if (status != VC_CONTAINER_SUCCESS)
+            {
+               error_logger << "Error " << status << " seeking to PTS " << key->first
+                  << " during timed seeks" << std::ends;
+               return;
+            }
+
+            ++seeks;
+         }
+
+         measured.seek_latency_us = (double)total / (double)seeks;
+
+         std::cout << "Seek latency:       " << measured.seek_latency_us
+            << " uS mean over " << seeks << " seeks" << std::endl;
+      }
+
+      // Compare with the baseline, or record one if this is the first run on this file.
+      PERF_FIGURES_T baseline;
+      std::ifstream baseline_in(configuration.perf_baseline.c_str());
+
+      if (!baseline_in)
+      {
+         std::ofstream baseline_out(configuration.perf_baseline.c_str());
+
+         if (!baseline_out)
+         {
+            error_logger << "Cannot record performance baseline "
+               << configuration.perf_baseline << std::ends;
+            return;
+         }
+
+         baseline_out << measured.mbytes_per_sec << " "
+            << measured.packets_per_sec << " "
+            << measured.seek_latency_us << std::endl;
+
+         std::cout << "Recorded new performance baseline " << configuration.perf_baseline << std::endl;
+         return;
+      }
+
+      baseline_in >> baseline.mbytes_per_sec >> baseline.packets_per_sec >> baseline.seek_latency_us;
+
+      if (!baseline_in)
+      {
+         error_logger << "Cannot parse performance baseline "
+            << configuration.perf_baseline << std::ends;
+         return;
+      }
+
+      // More than 10% down on either throughput figure is a regression.
+      if (measured.mbytes_per_sec < baseline.mbytes_per_sec * 0.9)
+      {
+         error_logger << "Demux throughput regression: " << measured.mbytes_per_sec
+            << " MB/s against baseline " << baseline.mbytes_per_sec << " MB/s" << std::ends;
+      }
+
+      if (measured.packets_per_sec < baseline.packets_per_sec * 0.9)
+      {
+         error_logger << "Packet rate regression: " << measured.packets_per_sec
+            << " packets/s against baseline " << baseline.packets_per_sec << " packets/s" << std::ends;
+      }
+
+      // More than 10% up on the seek time is a regression.
+      if (measured.seek_latency_us > baseline.seek_latency_us * 1.1)
+      {
+         error_logger << "Seek latency regression: " << measured.seek_latency_us
+            << " uS against baseline " << baseline.seek_latency_us << " uS" << std::ends;
+      }
+   }
+
    // Compare two packets, and return a non-empty string if they don't match
    std::string compare_packets(const PACKET_DATA_T& expected, const PACKET_DATA_T& actual)
    {
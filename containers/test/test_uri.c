@@ -764,6 +764,53 @@ static int test_merging_uri(VC_URI_PARTS_T *uri, MERGE_URI_T *uri_data)
    return check_uri(uri, uri_data->merged);
 }
 
+/** Test parsing into caller-provided memory.
+ * Re-runs the parse test cases through URI structures created with
+ * vc_uri_create_in, one with room for everything and one with an arena too
+ * small for the components, which must fall back to the heap transparently.
+ *
+ * \return Number of errors. */
+static int test_arena_uri(void)
+{
+   void *arena[256];       /* Pointer arrays, so suitably aligned */
+   void *small_arena[32];
+   VC_URI_PARTS_T *uri;
+   int error_count = 0;
+   size_t ii;
+
+   uri = vc_uri_create_in(arena, sizeof(arena));
+   if (!uri)
+   {
+      LOG_ERROR(NULL, "*** Failed to create URI structure in arena");
+      return 1;
+   }
+
+   for (ii = 0; ii < ARRAY_SIZE(test_parse_uris); ii++)
+      error_count += test_parsing_uri(uri, test_parse_uris[ii].before, test_parse_uris[ii].after);
+
+   vc_uri_release(uri);
+
+   uri = vc_uri_create_in(small_arena, sizeof(small_arena));
+   if (!uri)
+   {
+      LOG_ERROR(NULL, "*** Failed to create URI structure in small arena");
+      return error_count + 1;
+   }
+
+   for (ii = 0; ii < ARRAY_SIZE(test_parse_uris); ii++)
+      error_count += test_parsing_uri(uri, test_parse_uris[ii].before, test_parse_uris[ii].after);
+
+   vc_uri_release(uri);
+
+   if (vc_uri_create_in(arena, 1) != NULL)
+   {
+      LOG_ERROR(NULL, "*** Created URI structure in undersized memory");
+      error_count++;
+   }
+
+   return error_count;
+}
+
 int main(int argc, char **argv)
 {
    VC_URI_PARTS_T *uri;
@@ -798,6 +845,9 @@ int main(int argc, char **argv)
       error_count += test_merging_uri(uri, &test_merge_uris[ii]);
    }
 
+   LOG_INFO(NULL, "Test parsing URIs into caller-provided memory:");
+   error_count += test_arena_uri();
+
    if (argc > 1)
    {
       LOG_INFO(NULL, "Test parsing URIs from command line:");
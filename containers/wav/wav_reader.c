@@ -42,6 +42,7 @@ Defines.
 ******************************************************************************/
 #define WAV_EXTRADATA_MAX 16
 #define BLOCK_SIZE (16*1024)
+#define BLOCK_SIZE_MAX (1024*1024)
 
 /******************************************************************************
 GUID list for the different codecs
@@ -57,6 +58,8 @@ typedef struct VC_CONTAINER_MODULE_T
    uint64_t data_offset; /**< Offset to the start of the data packets */
    int64_t data_size;    /**< Size of the data contained in the data element */
    uint32_t block_size;   /**< Size of a block of audio data */
+   uint32_t default_block_size; /**< Block size chosen when the stream was opened */
+   uint32_t frame_size;   /**< Smallest unit a block of audio data can be made of */
    int64_t position;
    uint64_t frame_data_left;
 
@@ -155,6 +158,38 @@ static VC_CONTAINER_STATUS_T wav_reader_seek( VC_CONTAINER_T *p_ctx, int64_t *p_
    return SEEK(p_ctx, module->data_offset + position);
 }
 
+/*****************************************************************************/
+static VC_CONTAINER_STATUS_T wav_reader_control( VC_CONTAINER_T *p_ctx,
+   VC_CONTAINER_CONTROL_T operation, va_list args )
+{
+   VC_CONTAINER_MODULE_T *module = p_ctx->priv->module;
+   uint32_t frames;
+   uint64_t size;
+
+   switch(operation)
+   {
+   case VC_CONTAINER_CONTROL_SET_FRAMES_PER_PACKET:
+      frames = va_arg(args, uint32_t);
+      if(!module->frame_size) return VC_CONTAINER_ERROR_UNSUPPORTED_OPERATION;
+      if(!frames)
+      {
+         module->block_size = module->default_block_size;
+         return VC_CONTAINER_SUCCESS;
+      }
+
+      /* Packets are made up of whole frames so round the requested size down
+       * to a multiple of the frame size, and cap it to keep packets sensible */
+      size = (uint64_t)frames * p_ctx->tracks[0]->format->type->audio.block_align;
+      if(size > BLOCK_SIZE_MAX) size = BLOCK_SIZE_MAX;
+      size = size / module->frame_size * module->frame_size;
+      if(!size) size = module->frame_size;
+      module->block_size = size;
+      return VC_CONTAINER_SUCCESS;
+
+   default: return VC_CONTAINER_ERROR_UNSUPPORTED_OPERATION;
+   }
+}
+
 /*****************************************************************************/
 static VC_CONTAINER_STATUS_T wav_reader_close( VC_CONTAINER_T *p_ctx )
 {
@@ -274,6 +309,7 @@ VC_CONTAINER_STATUS_T wav_reader_open( VC_CONTAINER_T *p_ctx )
    p_ctx->tracks[0]->format->extradata_size = 0;
    p_ctx->tracks[0]->format->extradata = module->extradata;
    module->block_size = block_align;
+   module->frame_size = block_align;
 
    /* Prepare the codec extradata */
    if(codec == VC_CONTAINER_CODEC_ATRAC3)
@@ -311,7 +347,9 @@ VC_CONTAINER_STATUS_T wav_reader_open( VC_CONTAINER_T *p_ctx )
       /* Audioplus can no longer be given anything other than a multiple-of-16 number of samples */
       block_align *= 16;
       module->block_size = (BLOCK_SIZE / block_align) * block_align;
+      module->frame_size = block_align;
    }
+   module->default_block_size = module->block_size;
 
    /* Skip the rest of the 'fmt' sub-chunk */
    SKIP_BYTES(p_ctx, chunk_pos + chunk_size - STREAM_POSITION(p_ctx));
@@ -345,6 +383,7 @@ VC_CONTAINER_STATUS_T wav_reader_open( VC_CONTAINER_T *p_ctx )
    p_ctx->priv->pf_close = wav_reader_close;
    p_ctx->priv->pf_read = wav_reader_read;
    p_ctx->priv->pf_seek = wav_reader_seek;
+   p_ctx->priv->pf_control = wav_reader_control;
 
    /* Seek back to the start of the data */
    status = SEEK(p_ctx, module->data_offset);
@@ -0,0 +1,318 @@
+/*
+Copyright (c) 2012, Broadcom Europe Ltd
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// Video decode benchmark using OpenMAX IL through the ilclient helper library.
+//
+// Unlike hello_video this does not tunnel the decoder to the display:
+// decoded frames come back to the host in client-side output buffers so
+// every frame can be timestamped as it arrives.  For each input file it
+// reports the stream resolution, time to first decoded frame, decode frame
+// rate, the spread of inter-frame gaps and the number of IL calls issued,
+// giving a number to compare across firmware and userland updates instead
+// of eyeballing playback smoothness.  Feed it the same clip at several
+// resolutions to get a per-resolution sweep.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "bcm_host.h"
+#include "ilclient.h"
+
+// Per-run measurement state
+typedef struct
+{
+   uint64_t start_us;         // decoder entered executing state
+   uint64_t first_frame_us;   // first decoded frame arrived
+   uint64_t last_frame_us;    // most recent decoded frame arrived
+   uint64_t gap_min_us;       // smallest inter-frame gap
+   uint64_t gap_max_us;       // largest inter-frame gap
+   unsigned int frames;       // decoded frames received
+   unsigned int width;        // decoded width from the port definition
+   unsigned int height;       // decoded height from the port definition
+   unsigned int empties;      // OMX_EmptyThisBuffer calls issued
+   unsigned int fills;        // OMX_FillThisBuffer calls issued
+   uint64_t bytes_in;         // compressed bytes fed to the decoder
+} BENCH_STATS_T;
+
+static uint64_t now_us(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t)ts.tv_sec * 1000000ull + ts.tv_nsec / 1000;
+}
+
+static void record_frame(BENCH_STATS_T *stats)
+{
+   uint64_t now = now_us();
+
+   if (stats->frames == 0)
+      stats->first_frame_us = now;
+   else
+   {
+      uint64_t gap = now - stats->last_frame_us;
+      if (stats->gap_min_us == 0 || gap < stats->gap_min_us)
+         stats->gap_min_us = gap;
+      if (gap > stats->gap_max_us)
+         stats->gap_max_us = gap;
+   }
+
+   stats->last_frame_us = now;
+   stats->frames++;
+}
+
+// Enables the decoder output port once the port settings are known and
+// primes every output buffer.  Returns 0 on success.
+static int enable_decoded_output(COMPONENT_T *video_decode, BENCH_STATS_T *stats)
+{
+   OMX_PARAM_PORTDEFINITIONTYPE def;
+   OMX_BUFFERHEADERTYPE *out;
+
+   memset(&def, 0, sizeof(def));
+   def.nSize = sizeof(def);
+   def.nVersion.nVersion = OMX_VERSION;
+   def.nPortIndex = 131;
+
+   if (OMX_GetParameter(ILC_GET_HANDLE(video_decode), OMX_IndexParamPortDefinition, &def) != OMX_ErrorNone)
+      return -1;
+
+   stats->width = def.format.video.nFrameWidth;
+   stats->height = def.format.video.nFrameHeight;
+
+   if (ilclient_enable_port_buffers(video_decode, 131, NULL, NULL, NULL) != 0)
+      return -1;
+
+   while ((out = ilclient_get_output_buffer(video_decode, 131, 0)) != NULL)
+   {
+      if (OMX_FillThisBuffer(ILC_GET_HANDLE(video_decode), out) != OMX_ErrorNone)
+         return -1;
+      stats->fills++;
+   }
+
+   return 0;
+}
+
+static int video_bench(char *filename, BENCH_STATS_T *stats)
+{
+   OMX_VIDEO_PARAM_PORTFORMATTYPE format;
+   COMPONENT_T *video_decode = NULL;
+   COMPONENT_T *list[2];
+   ILCLIENT_T *client;
+   FILE *in;
+   int status = 0;
+   unsigned int data_len = 0;
+
+   memset(list, 0, sizeof(list));
+   memset(stats, 0, sizeof(*stats));
+
+   if((in = fopen(filename, "rb")) == NULL)
+      return -2;
+
+   if((client = ilclient_init()) == NULL)
+   {
+      fclose(in);
+      return -3;
+   }
+
+   if(OMX_Init() != OMX_ErrorNone)
+   {
+      ilclient_destroy(client);
+      fclose(in);
+      return -4;
+   }
+
+   // create video_decode with both input and output buffers on the host
+   if(ilclient_create_component(client, &video_decode, "video_decode",
+                                ILCLIENT_DISABLE_ALL_PORTS |
+                                ILCLIENT_ENABLE_INPUT_BUFFERS |
+                                ILCLIENT_ENABLE_OUTPUT_BUFFERS) != 0)
+      status = -14;
+   list[0] = video_decode;
+
+   if(status == 0)
+      ilclient_change_component_state(video_decode, OMX_StateIdle);
+
+   memset(&format, 0, sizeof(OMX_VIDEO_PARAM_PORTFORMATTYPE));
+   format.nSize = sizeof(OMX_VIDEO_PARAM_PORTFORMATTYPE);
+   format.nVersion.nVersion = OMX_VERSION;
+   format.nPortIndex = 130;
+   format.eCompressionFormat = OMX_VIDEO_CodingAVC;
+
+   if(status == 0 &&
+      OMX_SetParameter(ILC_GET_HANDLE(video_decode), OMX_IndexParamVideoPortFormat, &format) == OMX_ErrorNone &&
+      ilclient_enable_port_buffers(video_decode, 130, NULL, NULL, NULL) == 0)
+   {
+      OMX_BUFFERHEADERTYPE *buf, *out;
+      int port_settings_changed = 0;
+      int eof = 0, eos_in_sent = 0;
+
+      ilclient_change_component_state(video_decode, OMX_StateExecuting);
+      stats->start_us = now_us();
+
+      while(1)
+      {
+         int progress = 0;
+
+         // feed compressed data whenever an input buffer is free.  Block
+         // for one only while the output port is still unconfigured,
+         // otherwise the output side below provides the wakeups.
+         if (!eos_in_sent &&
+             (buf = ilclient_get_input_buffer(video_decode, 130, !port_settings_changed)) != NULL)
+         {
+            data_len = fread(buf->pBuffer, 1, buf->nAllocLen, in);
+
+            if (data_len == 0)
+               eof = 1;
+
+            buf->nFilledLen = data_len;
+            stats->bytes_in += data_len;
+            buf->nOffset = 0;
+            buf->nFlags = eof ? OMX_BUFFERFLAG_EOS : 0;
+
+            if(OMX_EmptyThisBuffer(ILC_GET_HANDLE(video_decode), buf) != OMX_ErrorNone)
+            {
+               status = -6;
+               break;
+            }
+            stats->empties++;
+            eos_in_sent = eof;
+            progress = 1;
+         }
+
+         // configure the output port as soon as the decoder reports the
+         // stream dimensions
+         if(port_settings_changed == 0 &&
+            (ilclient_remove_event(video_decode, OMX_EventPortSettingsChanged, 131, 0, 0, 1) == 0 ||
+             (eos_in_sent && ilclient_wait_for_event(video_decode, OMX_EventPortSettingsChanged, 131, 0, 0, 1,
+                                                     ILCLIENT_EVENT_ERROR | ILCLIENT_PARAMETER_CHANGED, 10000) == 0)))
+         {
+            if(enable_decoded_output(video_decode, stats) != 0)
+            {
+               status = -7;
+               break;
+            }
+            port_settings_changed = 1;
+            progress = 1;
+         }
+
+         // timestamp decoded frames as they arrive.  Block here when
+         // nothing else made progress; returning output buffers is what
+         // lets the rest of the pipeline move.
+         if(port_settings_changed &&
+            (out = ilclient_get_output_buffer(video_decode, 131, !progress)) != NULL)
+         {
+            int eos_out = (out->nFlags & OMX_BUFFERFLAG_EOS) != 0;
+
+            if (out->nFilledLen)
+               record_frame(stats);
+
+            out->nFilledLen = 0;
+
+            if (eos_out)
+               break;
+
+            if(OMX_FillThisBuffer(ILC_GET_HANDLE(video_decode), out) != OMX_ErrorNone)
+            {
+               status = -8;
+               break;
+            }
+            stats->fills++;
+         }
+         else if (eos_in_sent && !port_settings_changed)
+         {
+            // stream ended without ever configuring the output port
+            status = -9;
+            break;
+         }
+      }
+
+      ilclient_disable_port_buffers(video_decode, 131, NULL, NULL, NULL);
+      ilclient_disable_port_buffers(video_decode, 130, NULL, NULL, NULL);
+   }
+   else if (status == 0)
+      status = -5;
+
+   fclose(in);
+
+   ilclient_state_transition(list, OMX_StateIdle);
+   ilclient_state_transition(list, OMX_StateLoaded);
+
+   ilclient_cleanup_components(list);
+
+   OMX_Deinit();
+
+   ilclient_destroy(client);
+   return status;
+}
+
+static void print_stats(const char *filename, const BENCH_STATS_T *stats)
+{
+   uint64_t decode_us = stats->last_frame_us - stats->first_frame_us;
+   double fps = 0.0, gap_avg_ms = 0.0;
+
+   if (stats->frames > 1 && decode_us)
+   {
+      fps = (double)(stats->frames - 1) * 1000000.0 / decode_us;
+      gap_avg_ms = (double)decode_us / (stats->frames - 1) / 1000.0;
+   }
+
+   printf("%s: %ux%u, %u frames, %.2f fps\n",
+          filename, stats->width, stats->height, stats->frames, fps);
+   printf("   first frame %.1f ms, frame gap min/avg/max %.1f/%.1f/%.1f ms\n",
+          (stats->first_frame_us - stats->start_us) / 1000.0,
+          stats->gap_min_us / 1000.0, gap_avg_ms, stats->gap_max_us / 1000.0);
+   printf("   %llu bytes in, IL calls: %u empty, %u fill\n",
+          (unsigned long long)stats->bytes_in, stats->empties, stats->fills);
+}
+
+int main (int argc, char **argv)
+{
+   int i, status = 0;
+
+   if (argc < 2) {
+      printf("Usage: %s <filename> [<filename> ...]\n", argv[0]);
+      exit(1);
+   }
+   bcm_host_init();
+
+   for (i = 1; i < argc; i++)
+   {
+      BENCH_STATS_T stats;
+      int rc = video_bench(argv[i], &stats);
+
+      if (rc == 0)
+         print_stats(argv[i], &stats);
+      else
+      {
+         printf("%s: failed (%d)\n", argv[i], rc);
+         status = rc;
+      }
+   }
+
+   return status;
+}
@@ -108,6 +108,7 @@ struct _COMPONENT_T {
    unsigned int private;
    ILEVENT_T *list;
    ILCLIENT_T *client;
+   void *recycle_list;
 };
 
 #define random_wait()
@@ -123,6 +124,7 @@ typedef enum {
 Static functions.
 ******************************************************************************/
 
+static void ilclient_recycle_flush(COMPONENT_T *comp);
 static OMX_ERRORTYPE ilclient_empty_buffer_done(OMX_IN OMX_HANDLETYPE hComponent,
       OMX_IN OMX_PTR pAppData,
       OMX_IN OMX_BUFFERHEADERTYPE* pBuffer);
@@ -721,6 +723,7 @@ void ilclient_cleanup_components(COMPONENT_T *list[])
    i=0;
    while (list[i])
    {
+      ilclient_recycle_flush(list[i]);
       vcos_event_flags_delete(&list[i]->event);
       vcos_semaphore_delete(&list[i]->sema);
       vcos_free(list[i]);
@@ -787,6 +790,89 @@ void ilclient_enable_port(COMPONENT_T *comp, int portIndex)
 }
 
 
+/* While a payload buffer sits on the component's recycle cache its first
+   bytes hold this header; buffers too small for it are simply freed. */
+typedef struct {
+   void *next;
+   OMX_U32 size;
+   OMX_U32 align;
+} ILRECYCLE_HEADER_T;
+
+/***********************************************************
+ * Name: ilclient_recycle_get
+ *
+ * Description: takes a buffer of the given size and alignment off the
+ * component's recycle cache, if one is available.
+ *
+ * Returns: buffer pointer, or NULL if no suitable buffer is cached
+ ***********************************************************/
+static unsigned char *ilclient_recycle_get(COMPONENT_T *comp, OMX_U32 size, OMX_U32 align)
+{
+   ILRECYCLE_HEADER_T *entry, **prev;
+   unsigned char *buf = NULL;
+
+   vcos_semaphore_wait(&comp->sema);
+   prev = (ILRECYCLE_HEADER_T **) &comp->recycle_list;
+   while((entry = *prev) != NULL)
+   {
+      if(entry->size == size && entry->align == align)
+      {
+         *prev = entry->next;
+         buf = (unsigned char *) entry;
+         break;
+      }
+      prev = (ILRECYCLE_HEADER_T **) &entry->next;
+   }
+   vcos_semaphore_post(&comp->sema);
+
+   return buf;
+}
+
+/***********************************************************
+ * Name: ilclient_recycle_put
+ *
+ * Description: puts a payload buffer onto the component's recycle
+ * cache for reuse by a later ilclient_enable_port_buffers call.
+ *
+ * Returns: 0 on success, -1 if the buffer cannot be cached and must
+ * be freed by the caller
+ ***********************************************************/
+static int ilclient_recycle_put(COMPONENT_T *comp, void *buf, OMX_U32 size, OMX_U32 align)
+{
+   ILRECYCLE_HEADER_T *entry = buf;
+
+   if(!(comp->flags & ILCLIENT_RECYCLE_PORT_BUFFERS) || size < sizeof(*entry))
+      return -1;
+
+   entry->size = size;
+   entry->align = align;
+
+   vcos_semaphore_wait(&comp->sema);
+   entry->next = comp->recycle_list;
+   comp->recycle_list = entry;
+   vcos_semaphore_post(&comp->sema);
+
+   return 0;
+}
+
+/***********************************************************
+ * Name: ilclient_recycle_flush
+ *
+ * Description: frees all buffers held on the component's recycle
+ * cache.
+ *
+ * Returns: void
+ ***********************************************************/
+static void ilclient_recycle_flush(COMPONENT_T *comp)
+{
+   while(comp->recycle_list)
+   {
+      ILRECYCLE_HEADER_T *entry = comp->recycle_list;
+      comp->recycle_list = entry->next;
+      vcos_free(entry);
+   }
+}
+
 /***********************************************************
  * Name: ilclient_enable_port_buffers
  *
@@ -831,7 +917,11 @@ int ilclient_enable_port_buffers(COMPONENT_T *comp, int portIndex,
       if(ilclient_malloc)
          buf = ilclient_malloc(private, portdef.nBufferSize, portdef.nBufferAlignment, comp->bufname);
       else
-         buf = vcos_malloc_aligned(portdef.nBufferSize, portdef.nBufferAlignment, comp->bufname);
+      {
+         buf = ilclient_recycle_get(comp, portdef.nBufferSize, portdef.nBufferAlignment);
+         if(!buf)
+            buf = vcos_malloc_aligned(portdef.nBufferSize, portdef.nBufferAlignment, comp->bufname);
+      }
 
       if(!buf)
          break;
@@ -962,10 +1052,10 @@ void ilclient_disable_port_buffers(COMPONENT_T *comp, int portIndex,
          
          error = OMX_FreeBuffer(comp->comp, portIndex, list);
          vc_assert(error == OMX_ErrorNone);
-         
+
          if(ilclient_free)
             ilclient_free(private, buf);
-         else
+         else if(ilclient_recycle_put(comp, buf, portdef.nBufferSize, portdef.nBufferAlignment) < 0)
             vcos_free(buf);
          
          num--;
@@ -1096,6 +1186,166 @@ int ilclient_setup_tunnel(TUNNEL_T *tunnel, unsigned int portStream, int timeout
    return 0;
 }
 
+/***********************************************************
+ * Name: ilclient_setup_tunnels
+ *
+ * Description: sets up a null terminated list of tunnels, overlapping
+ * the latencies that ilclient_setup_tunnel pays per tunnel.  Source
+ * idle transitions and port disables are issued for every tunnel
+ * before any completion is waited on, so the setup cost of a pipeline
+ * is close to that of its slowest tunnel rather than the sum of all
+ * of them.  Stream selection, OMX_SetupTunnel and port enables still
+ * run per tunnel since they depend on the preceding steps of that
+ * tunnel only.
+ *
+ * Returns: 0 indicates success, negative indicates failure of a
+ * tunnel, using the same codes as ilclient_setup_tunnel.  On failure,
+ * the failing tunnel is torn down; earlier tunnels in the list are
+ * left set up.
+ ***********************************************************/
+int ilclient_setup_tunnels(TUNNEL_T *tunnels, unsigned int portStream, int timeout)
+{
+   OMX_ERRORTYPE error;
+   OMX_PARAM_U32TYPE param;
+   OMX_STATETYPE state;
+   int32_t status;
+   int i, num;
+   uint32_t set;
+
+   num=0;
+   while (tunnels[num].source)
+      num++;
+
+   // source components must at least be idle, not loaded.  Issue all the
+   // state commands first so the transitions run concurrently; a component
+   // sourcing several tunnels is only commanded once.
+   for (i=0; i<num; i++)
+      tunnels[i].source->private = 0;
+
+   for (i=0; i<num; i++)
+   {
+      if (tunnels[i].source->private)
+         continue;
+
+      error = OMX_GetState(tunnels[i].source->comp, &state);
+      vc_assert(error == OMX_ErrorNone);
+
+      if (state == OMX_StateLoaded)
+      {
+         vcos_event_flags_get(&tunnels[i].source->event, ILCLIENT_EVENT_ERROR, VCOS_OR_CONSUME, 0, &set);
+
+         error = OMX_SendCommand(tunnels[i].source->comp, OMX_CommandStateSet, OMX_StateIdle, NULL);
+         vc_assert(error == OMX_ErrorNone);
+
+         tunnels[i].source->private = 1;
+      }
+   }
+
+   for (i=0; i<num; i++)
+   {
+      if (!tunnels[i].source->private)
+         continue;
+
+      tunnels[i].source->private = 0;
+      if (ilclient_wait_for_command_complete(tunnels[i].source, OMX_CommandStateSet, OMX_StateIdle) < 0)
+         return -2;
+   }
+
+   // wait for the port parameter changed from each source port.  The events
+   // arrive independently, so waiting in list order costs the slowest
+   // component, not the sum.
+   if(timeout)
+   {
+      for (i=0; i<num; i++)
+      {
+         status = ilclient_wait_for_event(tunnels[i].source, OMX_EventPortSettingsChanged,
+                                          tunnels[i].source_port, 0, -1, 1,
+                                          ILCLIENT_PARAMETER_CHANGED | ILCLIENT_EVENT_ERROR, timeout);
+
+         if (status < 0)
+         {
+            ilclient_debug_output(
+               "ilclient: timed out waiting for port settings changed on port %d", tunnels[i].source_port);
+            return status;
+         }
+      }
+   }
+
+   // disable every tunnel port before waiting on any of the completions
+   for (i=0; i<num; i++)
+   {
+      tunnels[i].source->error_mask |= ILCLIENT_ERROR_UNPOPULATED;
+      tunnels[i].sink->error_mask |= ILCLIENT_ERROR_UNPOPULATED;
+
+      error = OMX_SendCommand(tunnels[i].source->comp, OMX_CommandPortDisable, tunnels[i].source_port, NULL);
+      vc_assert(error == OMX_ErrorNone);
+
+      error = OMX_SendCommand(tunnels[i].sink->comp, OMX_CommandPortDisable, tunnels[i].sink_port, NULL);
+      vc_assert(error == OMX_ErrorNone);
+   }
+
+   for (i=0; i<num; i++)
+   {
+      if (ilclient_wait_for_command_complete(tunnels[i].source, OMX_CommandPortDisable, tunnels[i].source_port) < 0)
+         vc_assert(0);
+
+      if (ilclient_wait_for_command_complete(tunnels[i].sink, OMX_CommandPortDisable, tunnels[i].sink_port) < 0)
+         vc_assert(0);
+
+      tunnels[i].source->error_mask &= ~ILCLIENT_ERROR_UNPOPULATED;
+      tunnels[i].sink->error_mask &= ~ILCLIENT_ERROR_UNPOPULATED;
+   }
+
+   // stream selection, tunnelling and enabling for each tunnel in turn
+   for (i=0; i<num; i++)
+   {
+      int enable_error;
+
+      // if this source port uses port streams, we need to select one of them before proceeding
+      // if getparameter causes an error that's fine, nothing needs selecting
+      param.nSize = sizeof(OMX_PARAM_U32TYPE);
+      param.nVersion.nVersion = OMX_VERSION;
+      param.nPortIndex = tunnels[i].source_port;
+      if (OMX_GetParameter(tunnels[i].source->comp, OMX_IndexParamNumAvailableStreams, &param) == OMX_ErrorNone)
+      {
+         if (param.nU32 == 0)
+            return -3;
+         if (param.nU32 <= portStream)
+            return -4;
+
+         param.nU32 = portStream;
+         error = OMX_SetParameter(tunnels[i].source->comp, OMX_IndexParamActiveStream, &param);
+         vc_assert(error == OMX_ErrorNone);
+      }
+
+      error = OMX_SetupTunnel(tunnels[i].source->comp, tunnels[i].source_port,
+                              tunnels[i].sink->comp, tunnels[i].sink_port);
+
+      enable_error = 0;
+
+      if (error != OMX_ErrorNone || (enable_error=ilclient_enable_tunnel(&tunnels[i])) < 0)
+      {
+         error = OMX_SetupTunnel(tunnels[i].source->comp, tunnels[i].source_port, NULL, 0);
+         vc_assert(error == OMX_ErrorNone);
+         error = OMX_SetupTunnel(tunnels[i].sink->comp, tunnels[i].sink_port, NULL, 0);
+         vc_assert(error == OMX_ErrorNone);
+
+         if(enable_error)
+         {
+            //Clean up the errors. This does risk removing an error that was nothing to do with this tunnel :-/
+            ilclient_remove_event(tunnels[i].sink, OMX_EventError, 0, 1, 0, 1);
+            ilclient_remove_event(tunnels[i].source, OMX_EventError, 0, 1, 0, 1);
+         }
+
+         ilclient_debug_output("ilclient: could not setup/enable tunnel %d (setup=0x%x,enable=%d)",
+                                i, error, enable_error);
+         return -5;
+      }
+   }
+
+   return 0;
+}
+
 /***********************************************************
  * Name: ilclient_wait_for_event
  *
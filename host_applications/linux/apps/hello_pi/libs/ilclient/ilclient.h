@@ -231,9 +231,20 @@ typedef enum {
                                             so should only be used for testing
                                             purposes. */
 
-   ILCLIENT_OUTPUT_ZERO_BUFFERS   = 0x10 /**< All output ports will have
+   ILCLIENT_OUTPUT_ZERO_BUFFERS   = 0x10, /**< All output ports will have
                                             nBufferCountActual set to zero,
-                                            if supported by the component. */                                            
+                                            if supported by the component. */
+
+   ILCLIENT_RECYCLE_PORT_BUFFERS  = 0x20 /**< Payload buffers released by
+                                            <DFN>ilclient_disable_port_buffers()</DFN>
+                                            are kept on a per-component
+                                            cache and handed back out by
+                                            <DFN>ilclient_enable_port_buffers()</DFN>,
+                                            so disable/enable cycles (e.g.
+                                            around a seek) do not
+                                            re-allocate them.  Only applies
+                                            when the default allocator is
+                                            used. */
 } ILCLIENT_CREATE_FLAGS_T;
   
 
@@ -645,6 +656,37 @@ VCHPRE_ int VCHPOST_ ilclient_setup_tunnel(TUNNEL_T *tunnel,
                                            int timeout);
 
 
+/**
+ * The <DFN>ilclient_setup_tunnels()</DFN> function connects a null
+ * terminated list of tunnels, performing the same steps as
+ * <DFN>ilclient_setup_tunnel()</DFN> for each one but issuing the
+ * source idle transitions and port disables for every tunnel before
+ * waiting on any of the completions.  For a pipeline of several
+ * tunnels, the setup time then approaches that of the slowest tunnel
+ * rather than the sum of all of them.
+ *
+ * @param tunnels The null terminated list of tunnel structures to set
+ * up.
+ *
+ * @param portStream If port streams are supported on the output port
+ * of a tunnel, then this parameter indicates the port stream to
+ * select on that port.
+ *
+ * @param timeout The time duration in milliseconds to wait for each
+ * output port to signal a port settings changed event before
+ * returning a timeout failure.  If this is 0, then we do not check
+ * for a port settings changed before setting up the tunnels.
+ *
+ * @return 0 indicates success, negative indicates failure using the
+ * same codes as <DFN>ilclient_setup_tunnel()</DFN>.  On failure the
+ * failing tunnel is torn down; tunnels earlier in the list remain set
+ * up.
+ ***********************************************************/
+VCHPRE_ int VCHPOST_ ilclient_setup_tunnels(TUNNEL_T *tunnels,
+                                            unsigned int portStream,
+                                            int timeout);
+
+
 /**
  * The <DFN>ilclient_disable_tunnel()</DFN> function disables both ports listed in
  * the tunnel structure.  It will send a port disable command to each
@@ -11,6 +11,7 @@ make -C hello_tiger clean
 make -C hello_encode clean
 make -C hello_jpeg clean
 make -C hello_videocube clean
+make -C hello_bench clean
 make -C hello_teapot clean
 make -C hello_fft clean
 
@@ -27,6 +28,7 @@ make -C hello_tiger
 make -C hello_encode
 make -C hello_jpeg
 make -C hello_videocube
+make -C hello_bench
 make -C hello_teapot
 make -C hello_fft
 
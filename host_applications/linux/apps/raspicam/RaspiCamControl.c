@@ -977,6 +977,107 @@ int raspicamcontrol_set_all_parameters(MMAL_COMPONENT_T *camera, const RASPICAM_
    return result;
 }
 
+/**
+ * Reset the dirty tracking state so the next call to
+ * raspicamcontrol_set_changed_parameters applies everything
+ * @param batch Pointer to batch state to initialise
+ */
+void raspicamcontrol_batch_init(RASPICAM_CONTROL_BATCH_T *batch)
+{
+   memset(batch, 0, sizeof(*batch));
+}
+
+/**
+ * Set the specified camera to the specified settings, but only issue the
+ * parameter sets for controls whose values differ from what was last applied
+ * through this batch state. A 30Hz exposure tuning loop that nudges one or
+ * two knobs per frame then costs one or two VC round trips rather than the
+ * twenty raspicamcontrol_set_all_parameters always makes.
+ *
+ * The first call applies everything to establish a known camera state.
+ *
+ * @param camera Pointer to camera component
+ * @param batch Pointer to batch state holding the last applied values
+ * @param params Pointer to parameter block containing desired parameters
+ * @return 0 if successful, none-zero if unsuccessful.
+ */
+int raspicamcontrol_set_changed_parameters(MMAL_COMPONENT_T *camera,
+      RASPICAM_CONTROL_BATCH_T *batch, const RASPICAM_CAMERA_PARAMETERS *params)
+{
+   const RASPICAM_CAMERA_PARAMETERS *last = &batch->applied;
+   int result = 0;
+
+   if (!batch->valid)
+   {
+      result = raspicamcontrol_set_all_parameters(camera, params);
+   }
+   else
+   {
+      if (params->saturation != last->saturation)
+         result += raspicamcontrol_set_saturation(camera, params->saturation);
+      if (params->sharpness != last->sharpness)
+         result += raspicamcontrol_set_sharpness(camera, params->sharpness);
+      if (params->contrast != last->contrast)
+         result += raspicamcontrol_set_contrast(camera, params->contrast);
+      if (params->brightness != last->brightness)
+         result += raspicamcontrol_set_brightness(camera, params->brightness);
+      if (params->ISO != last->ISO)
+         result += raspicamcontrol_set_ISO(camera, params->ISO);
+      if (params->videoStabilisation != last->videoStabilisation)
+         result += raspicamcontrol_set_video_stabilisation(camera, params->videoStabilisation);
+      if (params->exposureCompensation != last->exposureCompensation)
+         result += raspicamcontrol_set_exposure_compensation(camera, params->exposureCompensation);
+      if (params->exposureMode != last->exposureMode)
+         result += raspicamcontrol_set_exposure_mode(camera, params->exposureMode);
+      if (params->exposureMeterMode != last->exposureMeterMode)
+         result += raspicamcontrol_set_metering_mode(camera, params->exposureMeterMode);
+      if (params->awbMode != last->awbMode)
+         result += raspicamcontrol_set_awb_mode(camera, params->awbMode);
+      if (params->awb_gains_r != last->awb_gains_r ||
+          params->awb_gains_b != last->awb_gains_b)
+         result += raspicamcontrol_set_awb_gains(camera, params->awb_gains_r, params->awb_gains_b);
+      if (params->imageEffect != last->imageEffect)
+         result += raspicamcontrol_set_imageFX(camera, params->imageEffect);
+      if (memcmp(&params->colourEffects, &last->colourEffects, sizeof(params->colourEffects)))
+         result += raspicamcontrol_set_colourFX(camera, &params->colourEffects);
+      if (params->rotation != last->rotation)
+         result += raspicamcontrol_set_rotation(camera, params->rotation);
+      if (params->hflip != last->hflip || params->vflip != last->vflip)
+         result += raspicamcontrol_set_flips(camera, params->hflip, params->vflip);
+      if (memcmp(&params->roi, &last->roi, sizeof(params->roi)))
+         result += raspicamcontrol_set_ROI(camera, params->roi);
+      if (params->shutter_speed != last->shutter_speed)
+         result += raspicamcontrol_set_shutter_speed(camera, params->shutter_speed);
+      if (params->drc_level != last->drc_level)
+         result += raspicamcontrol_set_DRC(camera, params->drc_level);
+      if (params->stats_pass != last->stats_pass)
+         result += raspicamcontrol_set_stats_pass(camera, params->stats_pass);
+      if (params->enable_annotate != last->enable_annotate ||
+          params->annotate_text_size != last->annotate_text_size ||
+          params->annotate_text_colour != last->annotate_text_colour ||
+          params->annotate_bg_colour != last->annotate_bg_colour ||
+          strncmp(params->annotate_string, last->annotate_string, sizeof(params->annotate_string)))
+         result += raspicamcontrol_set_annotate(camera, params->enable_annotate, params->annotate_string,
+                             params->annotate_text_size,
+                             params->annotate_text_colour,
+                             params->annotate_bg_colour);
+   }
+
+   if (result == 0)
+   {
+      // Only trust the shadow copy if everything applied; otherwise the next
+      // call retries the lot rather than leaving the camera out of step
+      batch->applied = *params;
+      batch->valid = 1;
+   }
+   else
+   {
+      batch->valid = 0;
+   }
+
+   return result;
+}
+
 /**
  * Adjust the saturation level for images
  * @param camera Pointer to camera component
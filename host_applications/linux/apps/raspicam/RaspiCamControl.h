@@ -159,6 +159,14 @@ typedef struct
    MMAL_PARAMETER_STEREOSCOPIC_MODE_T stereo_mode;
 } RASPICAM_CAMERA_PARAMETERS;
 
+/// Tracks the last parameter set applied to a camera so repeated updates only
+/// cost a VC round trip for the controls whose values actually changed
+typedef struct
+{
+   RASPICAM_CAMERA_PARAMETERS applied; /// Last values sent to the camera
+   int valid;                 /// Non-zero once 'applied' holds real values
+} RASPICAM_CONTROL_BATCH_T;
+
 
 void raspicamcontrol_check_configuration(int min_gpu_mem);
 
@@ -167,6 +175,9 @@ void raspicamcontrol_display_help();
 int raspicamcontrol_cycle_test(MMAL_COMPONENT_T *camera);
 
 int raspicamcontrol_set_all_parameters(MMAL_COMPONENT_T *camera, const RASPICAM_CAMERA_PARAMETERS *params);
+void raspicamcontrol_batch_init(RASPICAM_CONTROL_BATCH_T *batch);
+int raspicamcontrol_set_changed_parameters(MMAL_COMPONENT_T *camera,
+      RASPICAM_CONTROL_BATCH_T *batch, const RASPICAM_CAMERA_PARAMETERS *params);
 int raspicamcontrol_get_all_parameters(MMAL_COMPONENT_T *camera, RASPICAM_CAMERA_PARAMETERS *params);
 void raspicamcontrol_dump_parameters(const RASPICAM_CAMERA_PARAMETERS *params);
 
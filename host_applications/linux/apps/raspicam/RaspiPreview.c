@@ -48,6 +48,9 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define CommandFullScreen     2
 #define CommandOpacity        3
 #define CommandDisablePreview 4
+#define CommandDisplayNum     5
+#define CommandLayer          6
+#define CommandCrop           7
 
 static COMMAND_LIST cmdline_commands[] =
 {
@@ -55,6 +58,9 @@ static COMMAND_LIST cmdline_commands[] =
    { CommandFullScreen,    "-fullscreen", "f",  "Fullscreen preview mode", 0 },
    { CommandOpacity,       "-opacity",    "op", "Preview window opacity (0-255)", 1},
    { CommandDisablePreview,"-nopreview",  "n",  "Do not display a preview window", 0},
+   { CommandDisplayNum,    "-dispnum",    "dn", "Display to render the preview on. Default is the main display", 1},
+   { CommandLayer,         "-layer",      "ly", "Dispmanx layer to render the preview on, so several processes can share one display. Default 2", 1},
+   { CommandCrop,          "-previewcrop","pc", "Source region <'x,y,w,h'> to display. Regions outside it are never composited", 1},
 };
 
 static int cmdline_commands_size = sizeof(cmdline_commands) / sizeof(cmdline_commands[0]);
@@ -109,11 +115,25 @@ MMAL_STATUS_T raspipreview_create(RASPIPREVIEW_PARAMETERS *state)
       param.hdr.size = sizeof(MMAL_DISPLAYREGION_T);
 
       param.set = MMAL_DISPLAY_SET_LAYER;
-      param.layer = PREVIEW_LAYER;
+      param.layer = state->layer;
 
       param.set |= MMAL_DISPLAY_SET_ALPHA;
       param.alpha = state->opacity;
 
+      if (state->displayNum >= 0)
+      {
+         param.set |= MMAL_DISPLAY_SET_NUM;
+         param.display_num = state->displayNum;
+      }
+
+      if (state->wantCrop)
+      {
+         // Only the cropped source region is composited, so static
+         // letterbox/dead areas cost no display bandwidth
+         param.set |= MMAL_DISPLAY_SET_SRC_RECT;
+         param.src_rect = state->previewCrop;
+      }
+
       if (state->wantFullScreenPreview)
       {
          param.set |= MMAL_DISPLAY_SET_FULLSCREEN;
@@ -187,6 +207,13 @@ void raspipreview_set_defaults(RASPIPREVIEW_PARAMETERS *state)
    state->previewWindow.y = 0;
    state->previewWindow.width = 1024;
    state->previewWindow.height = 768;
+   state->displayNum = -1;
+   state->layer = PREVIEW_LAYER;
+   state->wantCrop = 0;
+   state->previewCrop.x = 0;
+   state->previewCrop.y = 0;
+   state->previewCrop.width = 0;
+   state->previewCrop.height = 0;
    state->preview_component = NULL;
 }
 
@@ -204,6 +231,12 @@ void raspipreview_dump_parameters(RASPIPREVIEW_PARAMETERS *state)
    fprintf(stderr, "Preview window %d,%d,%d,%d\nOpacity %d\n", state->previewWindow.x,
       state->previewWindow.y, state->previewWindow.width,
       state->previewWindow.height, state->opacity);
+
+   fprintf(stderr, "Display %d, Layer %d\n", state->displayNum, state->layer);
+
+   if (state->wantCrop)
+      fprintf(stderr, "Preview crop %d,%d,%d,%d\n", state->previewCrop.x,
+         state->previewCrop.y, state->previewCrop.width, state->previewCrop.height);
 };
 
 /**
@@ -266,6 +299,32 @@ int raspipreview_parse_cmdline(RASPIPREVIEW_PARAMETERS *params, const char *arg1
          params->wantPreview = 0;
          used = 1;
          break;
+
+      case CommandDisplayNum: // Display to render on
+         if (sscanf(arg2, "%d", &params->displayNum) != 1)
+            params->displayNum = -1;
+         else
+            used = 2;
+         break;
+
+      case CommandLayer: // Dispmanx layer to render on
+         if (sscanf(arg2, "%d", &params->layer) != 1)
+            params->layer = PREVIEW_LAYER;
+         else
+            used = 2;
+         break;
+
+      case CommandCrop: // Source region to display
+      {
+         if (sscanf(arg2, "%d,%d,%d,%d",
+               &params->previewCrop.x, &params->previewCrop.y,
+               &params->previewCrop.width, &params->previewCrop.height) == 4)
+         {
+            params->wantCrop = 1;
+            used = 2;
+         }
+         break;
+      }
    }
 
    return used;
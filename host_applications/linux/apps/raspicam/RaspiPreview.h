@@ -54,6 +54,11 @@ typedef struct
    int wantFullScreenPreview;             /// 0 is use previewRect, non-zero to use full screen
    int opacity;                           /// Opacity of window - 0 = transparent, 255 = opaque
    MMAL_RECT_T previewWindow;             /// Destination rectangle for the preview window.
+   int displayNum;                        /// Display to render on, -1 for the default display
+   int layer;                             /// Dispmanx layer to render on. Default PREVIEW_LAYER
+   int wantCrop;                          /// Non-zero to scan out only previewCrop of the source
+   MMAL_RECT_T previewCrop;               /// Source rectangle to display, letterbox/dead regions
+                                          /// outside it are never composited
    MMAL_COMPONENT_T *preview_component;   /// Pointer to the created preview display component
 } RASPIPREVIEW_PARAMETERS;
 
@@ -176,6 +176,7 @@ typedef struct
    int settings;                       /// Request settings from the camera
    int cameraNum;                      /// Camera number
    int burstCaptureMode;               /// Enable burst mode
+   int fastBurst;                      /// Keep the capture pipeline set up between frames
    int sensor_mode;                     /// Sensor mode. 0=auto. Check docs/forum for modes selected by other values.
    int datetime;                       /// Use DateTime instead of frame#
    int timestamp;                      /// Use timestamp instead of frame#
@@ -234,6 +235,7 @@ static void store_exif_tag(RASPISTILL_STATE *state, const char *exif_tag);
 #define CommandDateTime     23
 #define CommandTimeStamp    24
 #define CommandFast         25
+#define CommandFastBurst    26
 
 static COMMAND_LIST cmdline_commands[] =
 {
@@ -263,6 +265,7 @@ static COMMAND_LIST cmdline_commands[] =
    { CommandDateTime,  "-datetime",  "dt", "Replace frame number in file name with DateTime (YearMonthDayHourMinSec)", 0},
    { CommandTimeStamp, "-timestamp", "ts", "Replace frame number in file name with unix timestamp (seconds since 1900)", 0},
    { CommandFast, "-ff", "ff", "Take photos as fast as possible.", 0},
+   { CommandFastBurst, "-fastburst", "fbm", "Keep the camera/encoder pipeline running between captures. Implies -burst, disables EXIF tags", 0},
 
 };
 
@@ -342,6 +345,7 @@ static void default_status(RASPISTILL_STATE *state)
    state->settings = 0;
    state->cameraNum = 0;
    state->burstCaptureMode=0;
+   state->fastBurst=0;
    state->sensor_mode = 0;
    state->datetime = 0;
    state->timestamp = 0;
@@ -651,6 +655,14 @@ static int parse_cmdline(int argc, const char **argv, RASPISTILL_STATE *state)
          state->frameNextMethod = FRAME_NEXT_IMMEDIATELY;
          break;
 
+      case CommandFastBurst:
+         // EXIF tags can only be set up while the encoder output port is
+         // disabled, which is exactly what this mode avoids doing per frame
+         state->fastBurst = 1;
+         state->burstCaptureMode = 1;
+         state->enableExifTags = 0;
+         break;
+
       case CommandFullResPreview:
          state->fullResPreview = 1;
          break;
@@ -2093,6 +2105,53 @@ int main(int argc, const char **argv)
             char *use_filename = NULL;      // Temporary filename while image being written
             char *final_filename = NULL;    // Name that file gets once writing complete
 
+            if (state.fastBurst && !state.useGL)
+            {
+               int num, q;
+
+               // Set the pipeline up once and leave it running; re-enabling
+               // the encoder output port per frame costs several hundred ms
+               // of capture-to-capture latency
+               mmal_port_parameter_set_boolean(
+                  state.encoder_component->output[0], MMAL_PARAMETER_EXIF_DISABLE, 1);
+
+               if (state.wantRAW)
+               {
+                  if (mmal_port_parameter_set_boolean(camera_still_port, MMAL_PARAMETER_ENABLE_RAW_CAPTURE, 1) != MMAL_SUCCESS)
+                  {
+                     vcos_log_error("RAW was requested, but failed to enable");
+                  }
+               }
+
+               encoder_output_port->userdata = (struct MMAL_PORT_USERDATA_T *)&callback_data;
+
+               if (state.verbose)
+                  fprintf(stderr, "Enabling encoder output port for burst\n");
+
+               status = mmal_port_enable(encoder_output_port, encoder_buffer_callback);
+               if (status != MMAL_SUCCESS)
+               {
+                  vcos_log_error("Failed to setup encoder output");
+                  goto error;
+               }
+
+               // The callback recycles these, so the pool only needs filling once
+               num = mmal_queue_length(state.encoder_pool->queue);
+
+               for (q=0;q<num;q++)
+               {
+                  MMAL_BUFFER_HEADER_T *buffer = mmal_queue_get(state.encoder_pool->queue);
+
+                  if (!buffer)
+                     vcos_log_error("Unable to get a required buffer %d from pool queue", q);
+
+                  if (mmal_port_send_buffer(encoder_output_port, buffer)!= MMAL_SUCCESS)
+                     vcos_log_error("Unable to send a buffer to encoder output port (%d)", q);
+               }
+
+               mmal_port_parameter_set_boolean(state.camera_component->control,  MMAL_PARAMETER_CAMERA_BURST_CAPTURE, 1);
+            }
+
             frame = 0;
 
             while (keep_looping)
@@ -2169,62 +2228,64 @@ int main(int argc, const char **argv)
                }
                else if (output_file)
                {
-                  int num, q;
-
-                  // Must do this before the encoder output port is enabled since
-                  // once enabled no further exif data is accepted
-                  if ( state.enableExifTags )
+                  if (!state.fastBurst)
                   {
-                     add_exif_tags(&state);
-                  }
-                  else
-                  {
-                     mmal_port_parameter_set_boolean(
-                        state.encoder_component->output[0], MMAL_PARAMETER_EXIF_DISABLE, 1);
-                  }
+                     int num, q;
 
-                  // Same with raw, apparently need to set it for each capture, whilst port
-                  // is not enabled
-                  if (state.wantRAW)
-                  {
-                     if (mmal_port_parameter_set_boolean(camera_still_port, MMAL_PARAMETER_ENABLE_RAW_CAPTURE, 1) != MMAL_SUCCESS)
+                     // Must do this before the encoder output port is enabled since
+                     // once enabled no further exif data is accepted
+                     if ( state.enableExifTags )
                      {
-                        vcos_log_error("RAW was requested, but failed to enable");
+                        add_exif_tags(&state);
+                     }
+                     else
+                     {
+                        mmal_port_parameter_set_boolean(
+                           state.encoder_component->output[0], MMAL_PARAMETER_EXIF_DISABLE, 1);
                      }
-                  }
 
-                  // There is a possibility that shutter needs to be set each loop.
-                  if (mmal_status_to_int(mmal_port_parameter_set_uint32(state.camera_component->control, MMAL_PARAMETER_SHUTTER_SPEED, state.camera_parameters.shutter_speed) != MMAL_SUCCESS))
-                     vcos_log_error("Unable to set shutter speed");
+                     // Same with raw, apparently need to set it for each capture, whilst port
+                     // is not enabled
+                     if (state.wantRAW)
+                     {
+                        if (mmal_port_parameter_set_boolean(camera_still_port, MMAL_PARAMETER_ENABLE_RAW_CAPTURE, 1) != MMAL_SUCCESS)
+                        {
+                           vcos_log_error("RAW was requested, but failed to enable");
+                        }
+                     }
 
+                     // Enable the encoder output port
+                     encoder_output_port->userdata = (struct MMAL_PORT_USERDATA_T *)&callback_data;
 
-                  // Enable the encoder output port
-                  encoder_output_port->userdata = (struct MMAL_PORT_USERDATA_T *)&callback_data;
+                     if (state.verbose)
+                        fprintf(stderr, "Enabling encoder output port\n");
 
-                  if (state.verbose)
-                     fprintf(stderr, "Enabling encoder output port\n");
+                     // Enable the encoder output port and tell it its callback function
+                     status = mmal_port_enable(encoder_output_port, encoder_buffer_callback);
 
-                  // Enable the encoder output port and tell it its callback function
-                  status = mmal_port_enable(encoder_output_port, encoder_buffer_callback);
+                     // Send all the buffers to the encoder output port
+                     num = mmal_queue_length(state.encoder_pool->queue);
 
-                  // Send all the buffers to the encoder output port
-                  num = mmal_queue_length(state.encoder_pool->queue);
+                     for (q=0;q<num;q++)
+                     {
+                        MMAL_BUFFER_HEADER_T *buffer = mmal_queue_get(state.encoder_pool->queue);
 
-                  for (q=0;q<num;q++)
-                  {
-                     MMAL_BUFFER_HEADER_T *buffer = mmal_queue_get(state.encoder_pool->queue);
+                        if (!buffer)
+                           vcos_log_error("Unable to get a required buffer %d from pool queue", q);
 
-                     if (!buffer)
-                        vcos_log_error("Unable to get a required buffer %d from pool queue", q);
+                        if (mmal_port_send_buffer(encoder_output_port, buffer)!= MMAL_SUCCESS)
+                           vcos_log_error("Unable to send a buffer to encoder output port (%d)", q);
+                     }
 
-                     if (mmal_port_send_buffer(encoder_output_port, buffer)!= MMAL_SUCCESS)
-                        vcos_log_error("Unable to send a buffer to encoder output port (%d)", q);
+                     if (state.burstCaptureMode && frame==1)
+                     {
+                        mmal_port_parameter_set_boolean(state.camera_component->control,  MMAL_PARAMETER_CAMERA_BURST_CAPTURE, 1);
+                     }
                   }
 
-                  if (state.burstCaptureMode && frame==1)
-                  {
-                     mmal_port_parameter_set_boolean(state.camera_component->control,  MMAL_PARAMETER_CAMERA_BURST_CAPTURE, 1);
-                  }
+                  // There is a possibility that shutter needs to be set each loop.
+                  if (mmal_status_to_int(mmal_port_parameter_set_uint32(state.camera_component->control, MMAL_PARAMETER_SHUTTER_SPEED, state.camera_parameters.shutter_speed) != MMAL_SUCCESS))
+                     vcos_log_error("Unable to set shutter speed");
 
                   if (state.verbose)
                      fprintf(stderr, "Starting capture %d\n", frame);
@@ -2254,8 +2315,10 @@ int main(int argc, const char **argv)
                   {
                      fflush(output_file);
                   }
-                  // Disable encoder output port
-                  status = mmal_port_disable(encoder_output_port);
+                  // Disable encoder output port; in fast burst mode it stays
+                  // enabled so the next capture starts without a pipeline rebuild
+                  if (!state.fastBurst)
+                     status = mmal_port_disable(encoder_output_port);
                }
 
                if (use_filename)
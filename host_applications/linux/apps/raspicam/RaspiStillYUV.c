@@ -130,17 +130,51 @@ typedef struct
    MMAL_POOL_T *camera_pool;              /// Pointer to the pool of buffers used by camera stills port
 } RASPISTILLYUV_STATE;
 
+/// Number of in-flight staged frames for the background IO writer. Two is
+/// enough to overlap the write of shot N with the capture of shot N+1.
+#define IO_WRITER_SLOTS 2
+
+/** One staged capture waiting to be written out by the IO writer thread
+ */
+typedef struct IO_JOB_S
+{
+   uint8_t *data;                       /// Staged copy of the frame data
+   size_t capacity;                     /// Allocated size of data
+   size_t length;                       /// Bytes staged so far
+   int overflow;                        /// Set if the frame did not fit in data
+   FILE *file_handle;                   /// Open handle the frame will be written to
+   char *use_filename;                  /// Temporary filename while image being written
+   char *final_filename;                /// Name that file gets once writing complete
+   int frame;                           /// Frame number, needed for the -latest link
+} IO_JOB_T;
+
+/** State for the background IO writer thread
+ */
+typedef struct IO_WRITER_S
+{
+   RASPISTILLYUV_STATE *pstate;         /// pointer to our state
+   VCOS_THREAD_T thread;                /// The writer thread
+   VCOS_SEMAPHORE_T free_slots;         /// Counts staging slots the capture side may fill
+   VCOS_SEMAPHORE_T work;               /// Posted for each job handed to the writer
+   IO_JOB_T jobs[IO_WRITER_SLOTS];      /// Staging slot ring
+   int fill;                            /// Next slot index to fill
+   int drain;                           /// Next slot index to write out
+   int quit;                            /// Set to ask the writer thread to exit
+} IO_WRITER_T;
 
 /** Struct used to pass information in camera still port userdata to callback
  */
 typedef struct
 {
    FILE *file_handle;                   /// File handle to write buffer data to.
+   IO_JOB_T *io_job;                    /// If set, stage frame data here instead of writing file_handle
    VCOS_SEMAPHORE_T complete_semaphore; /// semaphore which is posted when we reach end of frame (indicates end of capture or fault)
    RASPISTILLYUV_STATE *pstate;            /// pointer to our state in case required in callback
 } PORT_USERDATA;
 
 static void display_valid_parameters(char *app_name);
+static void rename_file(RASPISTILLYUV_STATE *state, FILE *output_file,
+      const char *final_filename, const char *use_filename, int frame);
 
 /// Comamnd ID's and Structure defining our command line options
 #define CommandHelp         0
@@ -539,6 +573,135 @@ static void camera_control_callback(MMAL_PORT_T *port, MMAL_BUFFER_HEADER_T *buf
    mmal_buffer_header_release(buffer);
 }
 
+/**
+ * Worker function for the background IO writer thread
+ *
+ * Writes out each staged frame, closes and renames the file, then returns
+ * the staging slot so the capture side can reuse it.
+ *
+ * @param arg Pointer to the IO writer state
+ *
+ * @return NULL
+ */
+static void *io_writer_worker(void *arg)
+{
+   IO_WRITER_T *writer = (IO_WRITER_T *)arg;
+
+   while (1)
+   {
+      IO_JOB_T *job;
+
+      vcos_semaphore_wait(&writer->work);
+
+      if (writer->quit)
+         break;
+
+      job = &writer->jobs[writer->drain];
+      writer->drain = (writer->drain + 1) % IO_WRITER_SLOTS;
+
+      if (job->overflow)
+         vcos_log_error("Staged frame overflowed %u byte slot - %s will be incomplete",
+                        (unsigned)job->capacity, job->final_filename);
+      else if (fwrite(job->data, 1, job->length, job->file_handle) != job->length)
+         vcos_log_error("Unable to write buffer to file %s", job->final_filename);
+
+      rename_file(writer->pstate, job->file_handle, job->final_filename, job->use_filename, job->frame);
+
+      free(job->use_filename);
+      free(job->final_filename);
+      job->use_filename = NULL;
+      job->final_filename = NULL;
+      job->file_handle = NULL;
+
+      vcos_semaphore_post(&writer->free_slots);
+   }
+
+   return NULL;
+}
+
+/**
+ * Create the background IO writer and its staging buffers
+ *
+ * @param state Pointer to state control struct
+ *
+ * @return Pointer to the writer, or NULL on failure
+ */
+static IO_WRITER_T *io_writer_create(RASPISTILLYUV_STATE *state)
+{
+   IO_WRITER_T *writer = calloc(1, sizeof(*writer));
+   size_t frame_bytes;
+   int i;
+
+   if (!writer)
+      return NULL;
+
+   // Worst case frame size as delivered by the stills port, which pads the
+   // image out to 32 pixel wide and 16 pixel high boundaries
+   frame_bytes = (size_t)VCOS_ALIGN_UP(state->width, 32) * VCOS_ALIGN_UP(state->height, 16);
+   if (state->useRGB)
+      frame_bytes *= 3;
+   else
+      frame_bytes = frame_bytes * 3 / 2;
+
+   writer->pstate = state;
+
+   for (i = 0; i < IO_WRITER_SLOTS; i++)
+   {
+      writer->jobs[i].data = malloc(frame_bytes);
+      writer->jobs[i].capacity = frame_bytes;
+
+      if (!writer->jobs[i].data)
+         goto fail;
+   }
+
+   if (vcos_semaphore_create(&writer->free_slots, "io-free", IO_WRITER_SLOTS) != VCOS_SUCCESS)
+      goto fail;
+
+   if (vcos_semaphore_create(&writer->work, "io-work", 0) != VCOS_SUCCESS)
+      goto fail_free_sem;
+
+   if (vcos_thread_create(&writer->thread, "io-writer", NULL, io_writer_worker, writer) != VCOS_SUCCESS)
+      goto fail_work_sem;
+
+   return writer;
+
+fail_work_sem:
+   vcos_semaphore_delete(&writer->work);
+fail_free_sem:
+   vcos_semaphore_delete(&writer->free_slots);
+fail:
+   for (i = 0; i < IO_WRITER_SLOTS; i++)
+      free(writer->jobs[i].data);
+   free(writer);
+   return NULL;
+}
+
+/**
+ * Flush any outstanding writes, stop the IO writer thread and free its resources
+ *
+ * @param writer Pointer to the writer
+ */
+static void io_writer_destroy(IO_WRITER_T *writer)
+{
+   int i;
+
+   // Wait for any in-flight writes to retire before asking the thread to exit
+   for (i = 0; i < IO_WRITER_SLOTS; i++)
+      vcos_semaphore_wait(&writer->free_slots);
+
+   writer->quit = 1;
+   vcos_semaphore_post(&writer->work);
+   vcos_thread_join(&writer->thread, NULL);
+
+   vcos_semaphore_delete(&writer->work);
+   vcos_semaphore_delete(&writer->free_slots);
+
+   for (i = 0; i < IO_WRITER_SLOTS; i++)
+      free(writer->jobs[i].data);
+
+   free(writer);
+}
+
 /**
  *  buffer header callback function for camera output port
  *
@@ -559,7 +722,25 @@ static void camera_buffer_callback(MMAL_PORT_T *port, MMAL_BUFFER_HEADER_T *buff
    {
       int bytes_written = buffer->length;
 
-      if (buffer->length && pData->file_handle)
+      if (buffer->length && pData->io_job)
+      {
+         // Stage the data for the IO writer thread rather than writing it
+         // here, so the camera gets its buffer back immediately
+         IO_JOB_T *job = pData->io_job;
+
+         if (job->length + buffer->length > job->capacity)
+            job->overflow = 1;
+         else
+         {
+            mmal_buffer_header_mem_lock(buffer);
+
+            memcpy(job->data + job->length, buffer->data, buffer->length);
+            job->length += buffer->length;
+
+            mmal_buffer_header_mem_unlock(buffer);
+         }
+      }
+      else if (buffer->length && pData->file_handle)
       {
          mmal_buffer_header_mem_lock(buffer);
 
@@ -1254,6 +1435,7 @@ int main(int argc, const char **argv)
          // Set up our userdata - this is passed though to the callback where we need the information.
          // Null until we open our filename
          callback_data.file_handle = NULL;
+         callback_data.io_job = NULL;
          callback_data.pstate = &state;
 
          vcos_status = vcos_semaphore_create(&callback_data.complete_semaphore, "RaspiStill-sem", 0);
@@ -1281,6 +1463,17 @@ int main(int argc, const char **argv)
          FILE *output_file = NULL;
          char *use_filename = NULL;      // Temporary filename while image being written
          char *final_filename = NULL;    // Name that file gets once writing complete
+         IO_WRITER_T *io_writer = NULL;
+
+         // Background writer so the next capture can start while the previous
+         // shot is still going out to storage. Not used when writing to stdout
+         if (state.filename && state.filename[0] != '-')
+         {
+            io_writer = io_writer_create(&state);
+
+            if (!io_writer)
+               vcos_log_error("Failed to create IO writer thread - file writes will not be overlapped");
+         }
 
          frame = 0;
 
@@ -1322,6 +1515,30 @@ int main(int argc, const char **argv)
                }
 
                callback_data.file_handle = output_file;
+
+               if (output_file && io_writer)
+               {
+                  IO_JOB_T *job;
+
+                  // Claim a staging slot - blocks if both slots are still being written
+                  vcos_semaphore_wait(&io_writer->free_slots);
+
+                  job = &io_writer->jobs[io_writer->fill];
+                  io_writer->fill = (io_writer->fill + 1) % IO_WRITER_SLOTS;
+
+                  job->length = 0;
+                  job->overflow = 0;
+                  job->file_handle = output_file;
+                  job->use_filename = use_filename;
+                  job->final_filename = final_filename;
+                  job->frame = frame;
+
+                  callback_data.io_job = job;
+
+                  // Ownership of the handle and filenames passes to the writer
+                  use_filename = NULL;
+                  final_filename = NULL;
+               }
             }
 
             if (output_file)
@@ -1372,7 +1589,14 @@ int main(int argc, const char **argv)
                // Ensure we don't die if get callback with no open file
                callback_data.file_handle = NULL;
 
-               if (output_file != stdout)
+               if (callback_data.io_job)
+               {
+                  // Hand the staged frame to the writer and move straight on
+                  // to the next capture while it goes out to storage
+                  callback_data.io_job = NULL;
+                  vcos_semaphore_post(&io_writer->work);
+               }
+               else if (output_file != stdout)
                {
                   rename_file(&state, output_file, final_filename, use_filename, frame);
                }
@@ -1389,7 +1613,10 @@ int main(int argc, const char **argv)
                final_filename = NULL;
             }
          } // end for (frame)
-         
+
+         if (io_writer)
+            io_writer_destroy(io_writer);
+
          vcos_semaphore_delete(&callback_data.complete_semaphore);
       }
       else
@@ -44,6 +44,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "interface/mmal/util/mmal_util_params.h"
 #include "tga.h"
 
+#include "gl_scenes/latency.h"
 #include "gl_scenes/mirror.h"
 #include "gl_scenes/sobel.h"
 #include "gl_scenes/square.h"
@@ -97,7 +98,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 static COMMAND_LIST cmdline_commands[] =
 {
-   { CommandGLScene, "-glscene",  "gs",  "GL scene square,teapot,mirror,yuv,sobel", 1 },
+   { CommandGLScene, "-glscene",  "gs",  "GL scene square,teapot,mirror,yuv,sobel,latency", 1 },
    { CommandGLWin,   "-glwin",    "gw",  "GL window settings <'x,y,w,h'>", 1 },
 };
 
@@ -159,6 +160,8 @@ int raspitex_parse_cmdline(RASPITEX_STATE *state,
             state->scene_id = RASPITEX_SCENE_YUV;
          else if (strcmp(arg2, "sobel") == 0)
             state->scene_id = RASPITEX_SCENE_SOBEL;
+         else if (strcmp(arg2, "latency") == 0)
+            state->scene_id = RASPITEX_SCENE_LATENCY;
          else
             vcos_log_error("Unknown scene %s", arg2);
 
@@ -204,6 +207,68 @@ static void update_fps()
    }
 }
 
+/**
+ * Appends a frame timing sample to the latency ring. Called only from the
+ * GL thread so a plain store plus a barrier is enough to publish it.
+ *
+ * @param state RASPITEX STATE
+ * @param buf New camera buffer drawn this frame, or NULL for a redraw.
+ * @param acquire_us Monotonic time after the texture update, or zero.
+ * @param draw_us Monotonic time after the scene draw calls were submitted.
+ * @param swap_us Monotonic time after eglSwapBuffers returned.
+ */
+static void latency_record(RASPITEX_STATE *state, MMAL_BUFFER_HEADER_T *buf,
+      int64_t acquire_us, int64_t draw_us, int64_t swap_us)
+{
+   RASPITEX_LATENCY *lat = &state->latency;
+   RASPITEX_LATENCY_SAMPLE *sample =
+      &lat->samples[lat->seq % RASPITEX_LATENCY_SAMPLES];
+
+   sample->pts = buf ? buf->pts : MMAL_TIME_UNKNOWN;
+   sample->acquire_us = acquire_us;
+   sample->draw_us = draw_us;
+   sample->swap_us = swap_us;
+
+   /* Make the sample visible before the sequence count moves past it */
+   __sync_synchronize();
+   lat->seq++;
+}
+
+/**
+ * Copies the most recent frame timing samples out of the latency ring,
+ * newest first. Safe to call from any thread while rendering continues;
+ * the copy is retried if the GL thread lapped the ring during the read.
+ *
+ * @param state RASPITEX STATE
+ * @param samples Array to fill with samples.
+ * @param max_samples Capacity of the samples array.
+ * @return The number of samples copied.
+ */
+uint32_t raspitex_latency_snapshot(RASPITEX_STATE *state,
+      RASPITEX_LATENCY_SAMPLE *samples, uint32_t max_samples)
+{
+   RASPITEX_LATENCY *lat = &state->latency;
+   uint32_t seq, count, i;
+
+   do
+   {
+      seq = lat->seq;
+      __sync_synchronize();
+
+      count = seq < RASPITEX_LATENCY_SAMPLES ? seq : RASPITEX_LATENCY_SAMPLES;
+      if (count > max_samples)
+         count = max_samples;
+
+      for (i = 0; i < count; i++)
+         samples[i] = lat->samples[(seq - 1 - i) % RASPITEX_LATENCY_SAMPLES];
+
+      __sync_synchronize();
+      /* Retry if the writer has reused any of the slots just copied */
+   } while (lat->seq - seq > RASPITEX_LATENCY_SAMPLES - count);
+
+   return count;
+}
+
 /**
  * Captures the frame-buffer if requested.
  * @param state RASPITEX STATE
@@ -260,6 +325,7 @@ static int check_egl_image(RASPITEX_STATE *state)
 static int raspitex_draw(RASPITEX_STATE *state, MMAL_BUFFER_HEADER_T *buf)
 {
    int rc = 0;
+   int64_t acquire_us = 0, draw_us = 0;
 
    /* If buf is non-NULL then there is a new viewfinder frame available
     * from the camera so the texture should be updated.
@@ -317,6 +383,8 @@ static int raspitex_draw(RASPITEX_STATE *state, MMAL_BUFFER_HEADER_T *buf)
          mmal_buffer_header_release(state->preview_buf);
 
       state->preview_buf = buf;
+
+      acquire_us = vcos_getmonotonicmicrosecs64();
    }
 
    /*  Do the drawing */
@@ -330,9 +398,14 @@ static int raspitex_draw(RASPITEX_STATE *state, MMAL_BUFFER_HEADER_T *buf)
       if (rc != 0)
          goto end;
 
+      draw_us = vcos_getmonotonicmicrosecs64();
+
       raspitex_do_capture(state);
 
       eglSwapBuffers(state->display, state->surface);
+
+      latency_record(state, buf, acquire_us, draw_us,
+            vcos_getmonotonicmicrosecs64());
       update_fps();
    }
    else
@@ -585,6 +658,9 @@ int raspitex_init(RASPITEX_STATE *state)
       case RASPITEX_SCENE_SOBEL:
          rc = sobel_open(state);
          break;
+      case RASPITEX_SCENE_LATENCY:
+         rc = latency_open(state);
+         break;
       default:
          rc = -1;
          break;
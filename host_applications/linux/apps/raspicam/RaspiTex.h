@@ -46,6 +46,7 @@ typedef enum {
    RASPITEX_SCENE_TEAPOT,
    RASPITEX_SCENE_YUV,
    RASPITEX_SCENE_SOBEL,
+   RASPITEX_SCENE_LATENCY,
 
 } RASPITEX_SCENE_T;
 
@@ -97,6 +98,35 @@ typedef struct RASPITEX_SCENE_OPS
    void (*close)(struct RASPITEX_STATE *state);
 } RASPITEX_SCENE_OPS;
 
+/// Number of entries in the frame latency ring. Must be a power of two so
+/// the sequence count wraps cleanly on to slot indices.
+#define RASPITEX_LATENCY_SAMPLES 128
+
+/**
+ * Timeline for one rendered preview frame. All times are microseconds from
+ * the monotonic clock, except pts which is the MMAL buffer timestamp.
+ */
+typedef struct RASPITEX_LATENCY_SAMPLE
+{
+   int64_t pts;                        /// MMAL buffer PTS, or MMAL_TIME_UNKNOWN
+   int64_t acquire_us;                 /// Texture updated to new EGL image. Zero
+                                       /// if the frame was a redraw of an old image
+   int64_t draw_us;                    /// Scene draw calls submitted
+   int64_t swap_us;                    /// eglSwapBuffers returned
+} RASPITEX_LATENCY_SAMPLE;
+
+/**
+ * Lock-free ring of frame timing samples. The GL thread is the only writer;
+ * readers snapshot entries via raspitex_latency_snapshot which re-reads if
+ * the writer lapped the copy.
+ */
+typedef struct RASPITEX_LATENCY
+{
+   RASPITEX_LATENCY_SAMPLE samples[RASPITEX_LATENCY_SAMPLES]; /// Sample ring
+   volatile uint32_t seq;              /// Total samples written. The next slot
+                                       /// to write is seq modulo the ring size
+} RASPITEX_LATENCY;
+
 typedef struct RASPITEX_CAPTURE
 {
    /// Wait for previous capture to complete
@@ -174,6 +204,8 @@ typedef struct RASPITEX_STATE
 
    RASPITEX_CAPTURE capture;           /// Frame-buffer capture state
 
+   RASPITEX_LATENCY latency;           /// Frame latency instrumentation ring
+
 } RASPITEX_STATE;
 
 int raspitex_init(RASPITEX_STATE *state);
@@ -187,5 +219,7 @@ void raspitex_display_help();
 int raspitex_parse_cmdline(RASPITEX_STATE *state,
       const char *arg1, const char *arg2);
 int raspitex_capture(RASPITEX_STATE *state, FILE* output_file);
+uint32_t raspitex_latency_snapshot(RASPITEX_STATE *state,
+      RASPITEX_LATENCY_SAMPLE *samples, uint32_t max_samples);
 
 #endif /* RASPITEX_H_ */
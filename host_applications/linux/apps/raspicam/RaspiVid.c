@@ -55,6 +55,11 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <string.h>
 #include <memory.h>
 #include <sysexits.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
 
 #define VERSION_STRING "v1.3.12"
 
@@ -134,6 +139,9 @@ typedef struct
    char  header_bytes[29];
    int  header_wptr;
    FILE *imv_file_handle;               /// File handle to write inline motion vectors to.
+   struct DIRECTIO_WRITER_S *dio_writer; /// Direct-IO writer used instead of file_handle, or NULL
+   struct SEGMENTER_S *segmenter;        /// Background segment rotation, or NULL
+   struct MV_ANALYSER_S *mv_analyser;    /// In-process motion vector analysis, or NULL
 } PORT_USERDATA;
 
 /** Structure containing all state information for the current run
@@ -180,9 +188,12 @@ struct RASPIVID_STATE_S
 
    int bCapturing;                     /// State of capture/pause
    int bCircularBuffer;                /// Whether we are writing to a circular buffer
+   int circularSeconds;                /// Seconds of pre-record history in circular buffer mode; 0 = size from timeout
+   int directIO;                       /// Write the output file with O_DIRECT, bypassing the page cache
 
    int inlineMotionVectors;             /// Encoder outputs inline Motion Vectors
    char *imv_filename;                  /// filename of inline Motion Vectors output
+   int inlineMotionAnalysis;            /// Analyse inline Motion Vectors in-process
    
    int cameraNum;                       /// Camera number
    int settings;                        /// Request settings from the camera
@@ -253,6 +264,8 @@ static void display_valid_parameters(char *app_name);
 #define CommandSettings     25
 #define CommandSensorMode   26
 #define CommandIntraRefreshType 27
+#define CommandDirectIO     28
+#define CommandMVAnalysis   29
 
 static COMMAND_LIST cmdline_commands[] =
 {
@@ -278,8 +291,10 @@ static COMMAND_LIST cmdline_commands[] =
    { CommandSegmentWrap,   "-wrap",       "wr", "In segment mode, wrap any numbered filename back to 1 when reach number", 1},
    { CommandSegmentStart,  "-start",      "sn", "In segment mode, start with specified segment number", 1},
    { CommandSplitWait,     "-split",      "sp", "In wait mode, create new output file for each start event", 0},
-   { CommandCircular,      "-circular",   "c",  "Run encoded data through circular buffer until triggered then save", 0},
+   { CommandCircular,      "-circular",   "c",  "Run encoded data through circular buffer until triggered then save. Optionally takes seconds of history to keep", 0},
+   { CommandDirectIO,      "-dio",        "dio","Write output file with direct IO, bypassing the page cache. Requires a plain output file", 0},
    { CommandIMV,           "-vectors",    "x",  "Output filename <filename> for inline motion vectors", 1 },
+   { CommandMVAnalysis,    "-analyse",    "xa", "Analyse inline motion vectors in-process and print a motion summary on exit. Does not require -x", 0 },
    { CommandCamSelect,     "-camselect",  "cs", "Select camera <number>. Default 0", 1 },
    { CommandSettings,      "-settings",   "set","Retrieve camera settings and write to stdout", 0},
    { CommandSensorMode,    "-mode",       "md", "Force sensor mode. 0=auto. See docs for other modes available", 1},
@@ -347,8 +362,12 @@ static void default_status(RASPIVID_STATE *state)
    state->splitNow = 0;
    state->splitWait = 0;
 
+   state->circularSeconds = 0; // 0 = size the pre-record buffer from the timeout
+   state->directIO = 0;
+
    state->inlineMotionVectors = 0;
-   
+   state->inlineMotionAnalysis = 0;
+
    state->cameraNum = 0;
    state->settings = 0;
    state->sensor_mode = 0;
@@ -668,6 +687,15 @@ static int parse_cmdline(int argc, const char **argv, RASPIVID_STATE *state)
       case CommandCircular:
       {
          state->bCircularBuffer = 1;
+         // Optional seconds-of-history; if absent the buffer is sized from the timeout
+         if (i + 1 < argc && sscanf(argv[i + 1], "%u", &state->circularSeconds) == 1)
+            i++;
+         break;
+      }
+
+      case CommandDirectIO:
+      {
+         state->directIO = 1;
          break;
       }
 
@@ -687,6 +715,13 @@ static int parse_cmdline(int argc, const char **argv, RASPIVID_STATE *state)
             valid = 0;
          break;
       }
+      case CommandMVAnalysis:
+      {
+         // Needs the encoder to emit vectors, with or without an imv file
+         state->inlineMotionAnalysis = 1;
+         state->inlineMotionVectors = 1;
+         break;
+      }
       case CommandCamSelect:  //Select camera input port
       {
          if (sscanf(argv[i + 1], "%u", &state->cameraNum) == 1)
@@ -852,8 +887,9 @@ static void camera_control_callback(MMAL_PORT_T *port, MMAL_BUFFER_HEADER_T *buf
  * Open a file based on the settings in state
  *
  * @param state Pointer to state
+ * @param segment Segment number to substitute into the filename
  */
-static FILE *open_filename(RASPIVID_STATE *pState)
+static FILE *open_filename(RASPIVID_STATE *pState, int segment)
 {
    FILE *new_handle = NULL;
    char *tempname = NULL, *filename = NULL;
@@ -861,7 +897,7 @@ static FILE *open_filename(RASPIVID_STATE *pState)
    if (pState->segmentSize || pState->splitWait)
    {
       // Create a new filename string
-      asprintf(&tempname, pState->filename, pState->segmentNumber);
+      asprintf(&tempname, pState->filename, segment);
       filename = tempname;
    }
    else
@@ -892,8 +928,9 @@ static FILE *open_filename(RASPIVID_STATE *pState)
  * This time for the imv output file
  *
  * @param state Pointer to state
+ * @param segment Segment number to substitute into the filename
  */
-static FILE *open_imv_filename(RASPIVID_STATE *pState)
+static FILE *open_imv_filename(RASPIVID_STATE *pState, int segment)
 {
    FILE *new_handle = NULL;
    char *tempname = NULL, *filename = NULL;
@@ -901,7 +938,7 @@ static FILE *open_imv_filename(RASPIVID_STATE *pState)
    if (pState->segmentSize || pState->splitWait)
    {
       // Create a new filename string
-      asprintf(&tempname, pState->imv_filename, pState->segmentNumber);
+      asprintf(&tempname, pState->imv_filename, segment);
       filename = tempname;
    }
    else
@@ -926,6 +963,319 @@ static FILE *open_imv_filename(RASPIVID_STATE *pState)
    return new_handle;
 }
 
+/** State for background segment rotation. At a segment boundary the
+ * encoder callback swaps in a handle the worker pre-opened and parks the
+ * finished one for retirement, so the callback thread never opens or
+ * closes a file and no frames hiccup at the rotation.
+ */
+typedef struct SEGMENTER_S
+{
+   RASPIVID_STATE *pstate;       /// pointer to our state for filenames/settings
+   VCOS_THREAD_T thread;         /// worker thread
+   VCOS_SEMAPHORE_T work;        /// posted when the worker has something to do
+   FILE *next_handle;            /// pre-opened video file for the next segment
+   FILE *next_imv_handle;        /// pre-opened imv file for the next segment
+   FILE *retire_handle;          /// finished video file awaiting close
+   FILE *retire_imv_handle;      /// finished imv file awaiting close
+   int next_segment;             /// segment number the pre-opened files are for
+   int quit;                     /// tell the worker to exit
+} SEGMENTER_T;
+
+/**
+ * Segmenter worker: closes retired segment files and pre-opens the next
+ * ones, off the capture path.
+ */
+static void *segmenter_worker(void *arg)
+{
+   SEGMENTER_T *seg = (SEGMENTER_T *)arg;
+
+   while (1)
+   {
+      FILE *handle;
+
+      vcos_semaphore_wait(&seg->work);
+
+      if (seg->quit)
+         break;
+
+      handle = (FILE *)__sync_lock_test_and_set(&seg->retire_handle, NULL);
+      if (handle)
+         fclose(handle);
+
+      handle = (FILE *)__sync_lock_test_and_set(&seg->retire_imv_handle, NULL);
+      if (handle)
+         fclose(handle);
+
+      // Pre-open the next segment so the swap at the boundary is instant
+      if (!seg->next_handle)
+      {
+         seg->next_handle = open_filename(seg->pstate, seg->next_segment);
+
+         if (seg->pstate->inlineMotionVectors && !seg->next_imv_handle)
+            seg->next_imv_handle = open_imv_filename(seg->pstate, seg->next_segment);
+      }
+   }
+
+   return NULL;
+}
+
+/**
+ * Create and start a segmenter for the given state.
+ *
+ * @param state Pointer to state
+ * @return the segmenter, or NULL on failure
+ */
+static SEGMENTER_T *segmenter_create(RASPIVID_STATE *state)
+{
+   SEGMENTER_T *seg = calloc(1, sizeof(SEGMENTER_T));
+
+   if (!seg)
+      return NULL;
+
+   seg->pstate = state;
+   seg->next_segment = state->segmentNumber + 1;
+   if (state->segmentWrap && seg->next_segment > state->segmentWrap)
+      seg->next_segment = 1;
+
+   // Start with the semaphore posted so the first next-file is prepared now
+   if (vcos_semaphore_create(&seg->work, "segmenter-sem", 1) != VCOS_SUCCESS)
+   {
+      free(seg);
+      return NULL;
+   }
+
+   if (vcos_thread_create(&seg->thread, "segmenter", NULL, segmenter_worker, seg) != VCOS_SUCCESS)
+   {
+      vcos_semaphore_delete(&seg->work);
+      free(seg);
+      return NULL;
+   }
+
+   return seg;
+}
+
+/**
+ * Stop the segmenter and close any files it still holds.
+ *
+ * @param seg Segmenter to destroy
+ */
+static void segmenter_destroy(SEGMENTER_T *seg)
+{
+   seg->quit = 1;
+   vcos_semaphore_post(&seg->work);
+   vcos_thread_join(&seg->thread, NULL);
+
+   if (seg->next_handle)
+      fclose(seg->next_handle);
+   if (seg->next_imv_handle)
+      fclose(seg->next_imv_handle);
+   if (seg->retire_handle)
+      fclose(seg->retire_handle);
+   if (seg->retire_imv_handle)
+      fclose(seg->retire_imv_handle);
+
+   vcos_semaphore_delete(&seg->work);
+   free(seg);
+}
+
+/// Slots in the motion vector analysis ring; a few frames of headroom
+#define MV_ANALYSER_SLOTS 8
+
+// Forward
+struct MV_ANALYSER_S;
+
+/// Hook receiving one frame of inline motion vectors on the analysis thread
+typedef void (*MV_ANALYSE_FN)(struct MV_ANALYSER_S *analyser, const uint8_t *data, int length);
+
+/**
+ * In-process inline motion vector analysis.
+ * The encoder callback copies each motion vector buffer into a preallocated
+ * ring and a dedicated low priority thread runs the analysis hook over it,
+ * so the analysis cost never blocks the encoder buffer path. Frames are
+ * dropped (and counted) when the analysis falls behind.
+ */
+typedef struct MV_ANALYSER_S
+{
+   RASPIVID_STATE *pstate;       /// pointer to our state for dimensions
+   VCOS_THREAD_T thread;         /// analysis thread
+   VCOS_SEMAPHORE_T work;        /// counts filled slots
+   int quit;                     /// tell the worker to exit
+   int slot_size;                /// bytes per slot - one frame of vectors
+   uint8_t *slots;               /// ring of MV_ANALYSER_SLOTS frames
+   int lengths[MV_ANALYSER_SLOTS]; /// valid bytes in each slot
+   unsigned int insert;          /// slots produced (encoder callback side)
+   volatile unsigned int remove; /// slots consumed (analysis side)
+   MV_ANALYSE_FN analyse;        /// analysis hook, defaults to the magnitude summary
+
+   // Running totals kept by the built-in magnitude summary
+   uint64_t frames;              /// frames analysed
+   uint64_t dropped;             /// frames dropped because the ring was full
+   double magnitude_sum;         /// sum over frames of the mean vector magnitude
+   double magnitude_peak;        /// largest per-frame mean vector magnitude
+} MV_ANALYSER_T;
+
+/// One inline motion vector as emitted by the encoder, one per macroblock
+typedef struct
+{
+   int8_t x;
+   int8_t y;
+   int16_t sad;
+} MV_VECTOR_T;
+
+/**
+ * Built-in analysis hook: mean motion magnitude per frame.
+ * The |x|+|y| approximation of the vector length keeps the inner loop to
+ * adds and compares so the compiler can vectorise it.
+ *
+ * @param analyser Analyser owning the running totals
+ * @param data One frame of motion vectors
+ * @param length Number of bytes
+ */
+static void mv_magnitude_summary(MV_ANALYSER_T *analyser, const uint8_t *data, int length)
+{
+   const MV_VECTOR_T *mv = (const MV_VECTOR_T *)data;
+   int num = length / sizeof(MV_VECTOR_T);
+   uint32_t sum = 0;
+   double mean;
+   int i;
+
+   for (i = 0; i < num; i++)
+   {
+      int x = mv[i].x, y = mv[i].y;
+      sum += (x < 0 ? -x : x) + (y < 0 ? -y : y);
+   }
+
+   mean = num ? (double)sum / num : 0;
+   analyser->frames++;
+   analyser->magnitude_sum += mean;
+   if (mean > analyser->magnitude_peak)
+      analyser->magnitude_peak = mean;
+}
+
+/**
+ * Analysis worker: drains the ring, running the hook over each frame.
+ */
+static void *mv_analyser_worker(void *arg)
+{
+   MV_ANALYSER_T *analyser = (MV_ANALYSER_T *)arg;
+
+   while (1)
+   {
+      unsigned int slot;
+
+      vcos_semaphore_wait(&analyser->work);
+
+      if (analyser->quit && analyser->remove == analyser->insert)
+         break;
+
+      slot = analyser->remove % MV_ANALYSER_SLOTS;
+      analyser->analyse(analyser, analyser->slots + slot * analyser->slot_size,
+         analyser->lengths[slot]);
+      analyser->remove++;
+   }
+
+   return NULL;
+}
+
+/**
+ * Queue one frame of motion vectors for analysis.
+ * Called from the encoder callback: copies into a free ring slot, or drops
+ * the frame if the analyser has fallen behind.
+ *
+ * @param analyser Analyser to feed
+ * @param data Motion vector data
+ * @param length Number of bytes
+ */
+static void mv_analyser_submit(MV_ANALYSER_T *analyser, const uint8_t *data, int length)
+{
+   unsigned int slot;
+
+   if (analyser->insert - analyser->remove >= MV_ANALYSER_SLOTS ||
+       length > analyser->slot_size)
+   {
+      analyser->dropped++;
+      return;
+   }
+
+   slot = analyser->insert % MV_ANALYSER_SLOTS;
+   memcpy(analyser->slots + slot * analyser->slot_size, data, length);
+   analyser->lengths[slot] = length;
+   analyser->insert++;
+   vcos_semaphore_post(&analyser->work);
+}
+
+/**
+ * Create and start a motion vector analyser for the given state.
+ *
+ * @param state Pointer to state
+ * @return the analyser, or NULL on failure
+ */
+static MV_ANALYSER_T *mv_analyser_create(RASPIVID_STATE *state)
+{
+   VCOS_THREAD_ATTR_T attrs;
+   MV_ANALYSER_T *analyser = calloc(1, sizeof(MV_ANALYSER_T));
+
+   if (!analyser)
+      return NULL;
+
+   // One motion vector per macroblock, plus one extra column
+   analyser->slot_size = ((state->width + 15) / 16 + 1) *
+      ((state->height + 15) / 16) * sizeof(MV_VECTOR_T);
+   analyser->pstate = state;
+   analyser->analyse = mv_magnitude_summary;
+
+   analyser->slots = malloc((size_t)analyser->slot_size * MV_ANALYSER_SLOTS);
+   if (!analyser->slots)
+   {
+      free(analyser);
+      return NULL;
+   }
+
+   if (vcos_semaphore_create(&analyser->work, "mv-analyser-sem", 0) != VCOS_SUCCESS)
+   {
+      free(analyser->slots);
+      free(analyser);
+      return NULL;
+   }
+
+   // Low priority - analysis must never compete with the capture path
+   vcos_thread_attr_init(&attrs);
+   vcos_thread_attr_setpriority(&attrs, VCOS_THREAD_PRI_BELOW_NORMAL);
+
+   if (vcos_thread_create(&analyser->thread, "mv-analyser", &attrs,
+         mv_analyser_worker, analyser) != VCOS_SUCCESS)
+   {
+      vcos_semaphore_delete(&analyser->work);
+      free(analyser->slots);
+      free(analyser);
+      return NULL;
+   }
+
+   return analyser;
+}
+
+/**
+ * Stop the analyser, letting it drain any queued frames, and print the
+ * summary from the built-in analysis hook.
+ *
+ * @param analyser Analyser to destroy
+ */
+static void mv_analyser_destroy(MV_ANALYSER_T *analyser)
+{
+   analyser->quit = 1;
+   vcos_semaphore_post(&analyser->work);
+   vcos_thread_join(&analyser->thread, NULL);
+
+   if (analyser->frames)
+      fprintf(stderr, "Motion analysis: %u frames, %u dropped, mean magnitude %.2f, peak %.2f\n",
+         (unsigned int)analyser->frames, (unsigned int)analyser->dropped,
+         analyser->magnitude_sum / analyser->frames, analyser->magnitude_peak);
+
+   vcos_semaphore_delete(&analyser->work);
+   free(analyser->slots);
+   free(analyser);
+}
+
 /**
  * Update any annotation data specific to the video.
  * This simply passes on the setting from cli, or
@@ -965,7 +1315,187 @@ static void update_annotation_data(RASPIVID_STATE *state)
    }
 }
 
+/// O_DIRECT requires buffer, length and file offset alignment
+#define DIRECTIO_ALIGNMENT (4*1024)
+/// Bytes coalesced per direct write; several encoded frames at 25Mbps
+#define DIRECTIO_CHUNK     (256*1024)
+
+/** State for the direct-IO writer. Encoded buffers are coalesced into an
+ * aligned staging buffer and written out a DIRECTIO_CHUNK at a time with
+ * O_DIRECT, so a long recording is not double-buffered through the page
+ * cache, evicting everything else.
+ */
+typedef struct DIRECTIO_WRITER_S
+{
+   int fd;       /// Output file, opened with O_DIRECT
+   char *buff;   /// Staging buffer, DIRECTIO_ALIGNMENT aligned
+   int fill;     /// Bytes currently staged
+} DIRECTIO_WRITER;
+
+/**
+ * Open a direct-IO writer for the given filename.
+ *
+ * @param filename Name of file to open
+ * @return writer on success, NULL on failure (e.g. a filesystem without
+ *         direct IO support)
+ */
+static DIRECTIO_WRITER *directio_open(const char *filename)
+{
+   DIRECTIO_WRITER *writer = calloc(1, sizeof(DIRECTIO_WRITER));
+
+   if (!writer)
+      return NULL;
+
+   writer->fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, 0666);
+   if (writer->fd < 0)
+   {
+      free(writer);
+      return NULL;
+   }
+
+   if (posix_memalign((void **)&writer->buff, DIRECTIO_ALIGNMENT, DIRECTIO_CHUNK) != 0)
+   {
+      close(writer->fd);
+      free(writer);
+      return NULL;
+   }
+
+   return writer;
+}
+
+/**
+ * Stage encoded bytes, writing out each DIRECTIO_CHUNK as it fills.
+ *
+ * @param writer Writer to write to
+ * @param data Bytes to write
+ * @param length Number of bytes
+ * @return 0 on success, -1 on write failure
+ */
+static int directio_write(DIRECTIO_WRITER *writer, const char *data, int length)
+{
+   while (length)
+   {
+      int space = DIRECTIO_CHUNK - writer->fill;
+      int copy = length < space ? length : space;
+
+      memcpy(writer->buff + writer->fill, data, copy);
+      writer->fill += copy;
+      data += copy;
+      length -= copy;
+
+      if (writer->fill == DIRECTIO_CHUNK)
+      {
+         if (write(writer->fd, writer->buff, DIRECTIO_CHUNK) != DIRECTIO_CHUNK)
+            return -1;
+         writer->fill = 0;
+      }
+   }
+
+   return 0;
+}
+
+/**
+ * Write out any staged tail and release the writer. The tail is rarely a
+ * multiple of the alignment, so O_DIRECT is dropped for this last write.
+ *
+ * @param writer Writer to close
+ * @return 0 on success, -1 if the tail could not be written
+ */
+static int directio_close(DIRECTIO_WRITER *writer)
+{
+   int status = 0;
+
+   if (writer->fill)
+   {
+      int flags = fcntl(writer->fd, F_GETFL);
+
+      if (flags < 0 ||
+          fcntl(writer->fd, F_SETFL, flags & ~O_DIRECT) < 0 ||
+          write(writer->fd, writer->buff, writer->fill) != writer->fill)
+         status = -1;
+   }
+
+   if (close(writer->fd) != 0)
+      status = -1;
+
+   free(writer->buff);
+   free(writer);
+   return status;
+}
+
+/**
+ * Save the circular pre-record buffer to the output file.
+ *
+ * The history is trimmed to start at the oldest keyframe still in the
+ * buffer, then the header bytes and the (at most two) spans of the ring
+ * are handed to the kernel in one vectored write, so a trigger does not
+ * stall copying the buffer out piecemeal.
+ *
+ * @param cb Pointer to the our callback data containing the buffer
+ * @return 0 on success, -1 on write failure
+ */
+static int save_circular_buffer(PORT_USERDATA *cb)
+{
+   struct iovec iov[3];
+   int iovcnt = 0;
+   int copy_from_end, copy_from_start;
+   int fd = fileno(cb->file_handle);
+
+   copy_from_end = cb->cb_len - cb->iframe_buff[cb->iframe_buff_rpos];
+   copy_from_start = cb->cb_len - copy_from_end;
+   copy_from_start = cb->cb_wptr < copy_from_start ? cb->cb_wptr : copy_from_start;
+   if(!cb->cb_wrap)
+   {
+      copy_from_start = cb->cb_wptr;
+      copy_from_end = 0;
+   }
+
+   // We bypass stdio below, so get anything it buffered out first
+   fflush(cb->file_handle);
+
+   if (cb->header_wptr)
+   {
+      iov[iovcnt].iov_base = cb->header_bytes;
+      iov[iovcnt++].iov_len = cb->header_wptr;
+   }
+   if (copy_from_end)
+   {
+      iov[iovcnt].iov_base = cb->cb_buff + cb->iframe_buff[cb->iframe_buff_rpos];
+      iov[iovcnt++].iov_len = copy_from_end;
+   }
+   if (copy_from_start)
+   {
+      iov[iovcnt].iov_base = cb->cb_buff;
+      iov[iovcnt++].iov_len = copy_from_start;
+   }
+
+   while (iovcnt)
+   {
+      ssize_t written = writev(fd, iov, iovcnt);
+      int i;
+
+      if (written < 0)
+      {
+         if (errno == EINTR)
+            continue;
+         return -1;
+      }
+
+      // Skip the fully written vectors, trim the partially written one
+      for (i = 0; i < iovcnt && (size_t)written >= iov[i].iov_len; i++)
+         written -= iov[i].iov_len;
 
+      if (i == iovcnt)
+         break;
+
+      iov[i].iov_base = (char *)iov[i].iov_base + written;
+      iov[i].iov_len -= written;
+      memmove(iov, iov + i, (iovcnt - i) * sizeof(iov[0]));
+      iovcnt -= i;
+   }
+
+   return 0;
+}
 
 /**
  *  buffer header callback function for encoder
@@ -994,8 +1524,8 @@ static void encoder_buffer_callback(MMAL_PORT_T *port, MMAL_BUFFER_HEADER_T *buf
       int bytes_written = buffer->length;
       int64_t current_time = vcos_getmicrosecs64()/1000;
 
-      vcos_assert(pData->file_handle);
-      if(pData->pstate->inlineMotionVectors) vcos_assert(pData->imv_file_handle);
+      vcos_assert(pData->file_handle || pData->dio_writer);
+      if(pData->pstate->inlineMotionVectors) vcos_assert(pData->imv_file_handle || pData->mv_analyser);
 
       if (pData->cb_buff)
       {
@@ -1086,31 +1616,65 @@ static void encoder_buffer_callback(MMAL_PORT_T *port, MMAL_BUFFER_HEADER_T *buf
              ((pData->pstate->segmentSize && current_time > base_time + pData->pstate->segmentSize) ||
               (pData->pstate->splitWait && pData->pstate->splitNow)))
          {
-            FILE *new_handle;
+            if (pData->segmenter)
+            {
+               SEGMENTER_T *seg = pData->segmenter;
+               FILE *new_handle = (FILE *)__sync_lock_test_and_set(&seg->next_handle, NULL);
+
+               // If the worker has not prepared the next file yet, keep the
+               // current one until the next boundary rather than blocking here
+               if (new_handle)
+               {
+                  FILE *new_imv_handle = (FILE *)__sync_lock_test_and_set(&seg->next_imv_handle, NULL);
 
-            base_time = current_time;
+                  base_time = current_time;
+                  pData->pstate->splitNow = 0;
+                  pData->pstate->segmentNumber = seg->next_segment;
 
-            pData->pstate->splitNow = 0;
-            pData->pstate->segmentNumber++;
+                  seg->retire_handle = pData->file_handle;
+                  pData->file_handle = new_handle;
 
-            // Only wrap if we have a wrap point set
-            if (pData->pstate->segmentWrap && pData->pstate->segmentNumber > pData->pstate->segmentWrap)
-               pData->pstate->segmentNumber = 1;
+                  if (new_imv_handle)
+                  {
+                     seg->retire_imv_handle = pData->imv_file_handle;
+                     pData->imv_file_handle = new_imv_handle;
+                  }
 
-            new_handle = open_filename(pData->pstate);
+                  seg->next_segment++;
+                  if (pData->pstate->segmentWrap && seg->next_segment > pData->pstate->segmentWrap)
+                     seg->next_segment = 1;
 
-            if (new_handle)
-            {
-               fclose(pData->file_handle);
-               pData->file_handle = new_handle;
+                  vcos_semaphore_post(&seg->work);
+               }
             }
+            else
+            {
+               FILE *new_handle;
 
-            new_handle = open_imv_filename(pData->pstate);
+               base_time = current_time;
 
-            if (new_handle)
-            {
-               fclose(pData->imv_file_handle);
-               pData->imv_file_handle = new_handle;
+               pData->pstate->splitNow = 0;
+               pData->pstate->segmentNumber++;
+
+               // Only wrap if we have a wrap point set
+               if (pData->pstate->segmentWrap && pData->pstate->segmentNumber > pData->pstate->segmentWrap)
+                  pData->pstate->segmentNumber = 1;
+
+               new_handle = open_filename(pData->pstate, pData->pstate->segmentNumber);
+
+               if (new_handle)
+               {
+                  fclose(pData->file_handle);
+                  pData->file_handle = new_handle;
+               }
+
+               new_handle = open_imv_filename(pData->pstate, pData->pstate->segmentNumber);
+
+               if (new_handle)
+               {
+                  fclose(pData->imv_file_handle);
+                  pData->imv_file_handle = new_handle;
+               }
             }
          }
          if (buffer->length)
@@ -1118,7 +1682,10 @@ static void encoder_buffer_callback(MMAL_PORT_T *port, MMAL_BUFFER_HEADER_T *buf
             mmal_buffer_header_mem_lock(buffer);
             if(buffer->flags & MMAL_BUFFER_HEADER_FLAG_CODECSIDEINFO)
             {
-               if(pData->pstate->inlineMotionVectors)
+               if (pData->mv_analyser)
+                  mv_analyser_submit(pData->mv_analyser, buffer->data, buffer->length);
+
+               if(pData->pstate->inlineMotionVectors && pData->imv_file_handle)
                {
                   bytes_written = fwrite(buffer->data, 1, buffer->length, pData->imv_file_handle);
                }
@@ -1128,9 +1695,14 @@ static void encoder_buffer_callback(MMAL_PORT_T *port, MMAL_BUFFER_HEADER_T *buf
                   bytes_written = buffer->length;
                }
             }
+            else if (pData->dio_writer)
+            {
+               if (directio_write(pData->dio_writer, (char *)buffer->data, buffer->length) != 0)
+                  bytes_written = 0;
+            }
             else
             {
-               bytes_written = fwrite(buffer->data, 1, buffer->length, pData->file_handle);            
+               bytes_written = fwrite(buffer->data, 1, buffer->length, pData->file_handle);
             }
 
             mmal_buffer_header_mem_unlock(buffer);
@@ -1983,6 +2555,17 @@ int main(int argc, const char **argv)
          }
 
          state.callback_data.file_handle = NULL;
+         state.callback_data.dio_writer = NULL;
+         state.callback_data.segmenter = NULL;
+         state.callback_data.mv_analyser = NULL;
+
+         if (state.directIO &&
+             (state.bCircularBuffer || state.segmentSize || state.splitWait ||
+              !state.filename || state.filename[0] == '-'))
+         {
+            vcos_log_error("%s: Error, direct IO requires a plain output file and is incompatible with segment and circular buffer modes\n", __func__);
+            goto error;
+         }
 
          if (state.filename)
          {
@@ -1993,12 +2576,16 @@ int main(int argc, const char **argv)
                // Ensure we don't upset the output stream with diagnostics/info
                state.verbose = 0;
             }
+            else if (state.directIO)
+            {
+               state.callback_data.dio_writer = directio_open(state.filename);
+            }
             else
             {
-               state.callback_data.file_handle = open_filename(&state);
+               state.callback_data.file_handle = open_filename(&state, state.segmentNumber);
             }
 
-            if (!state.callback_data.file_handle)
+            if (!state.callback_data.file_handle && !state.callback_data.dio_writer)
             {
                // Notify user, carry on but discarding encoded output buffers
                vcos_log_error("%s: Error opening output file: %s\nNo output file will be generated\n", __func__, state.filename);
@@ -2015,17 +2602,39 @@ int main(int argc, const char **argv)
             }
             else
             {
-               state.callback_data.imv_file_handle = open_imv_filename(&state);
+               state.callback_data.imv_file_handle = open_imv_filename(&state, state.segmentNumber);
             }
 
             if (!state.callback_data.imv_file_handle)
             {
                // Notify user, carry on but discarding encoded output buffers
                fprintf(stderr, "Error opening output file: %s\nNo output file will be generated\n",state.imv_filename);
-               state.inlineMotionVectors=0;
+               // In-process analysis still needs the vectors
+               if (!state.inlineMotionAnalysis)
+                  state.inlineMotionVectors=0;
             }
          }
 
+         // Analyse motion vectors in-process, off the encoder callback path
+         if (state.inlineMotionAnalysis)
+         {
+            state.callback_data.mv_analyser = mv_analyser_create(&state);
+
+            if (!state.callback_data.mv_analyser)
+               vcos_log_error("%s: Unable to start motion analysis thread\n", __func__);
+         }
+
+         // Rotate segments on a background thread so the callback never
+         // opens or closes files inline
+         if ((state.segmentSize || state.splitWait) &&
+             state.callback_data.file_handle && state.callback_data.file_handle != stdout)
+         {
+            state.callback_data.segmenter = segmenter_create(&state);
+
+            if (!state.callback_data.segmenter)
+               vcos_log_error("%s: Unable to start segmenter thread, falling back to inline rotation\n", __func__);
+         }
+
          if(state.bCircularBuffer)
          {
             if(state.bitrate == 0)
@@ -2033,7 +2642,7 @@ int main(int argc, const char **argv)
                vcos_log_error("%s: Error circular buffer requires constant bitrate and small intra period\n", __func__);
                goto error;
             }
-            else if(state.timeout == 0)
+            else if(state.timeout == 0 && state.circularSeconds == 0)
             {
                vcos_log_error("%s: Error, circular buffer size is based on timeout must be greater than zero\n", __func__);
                goto error;
@@ -2050,16 +2659,21 @@ int main(int argc, const char **argv)
             }
             else
             {
-               int count = state.bitrate * (state.timeout / 1000) / 8;
+               int seconds = state.circularSeconds ? state.circularSeconds : state.timeout / 1000;
+               int count = state.bitrate * seconds / 8;
 
                state.callback_data.cb_buff = (char *) malloc(count);
                if(state.callback_data.cb_buff == NULL)
                {
-                  vcos_log_error("%s: Unable to allocate circular buffer for %d seconds at %.1f Mbits\n", __func__, state.timeout / 1000, (double)state.bitrate/1000000.0);
+                  vcos_log_error("%s: Unable to allocate circular buffer for %d seconds at %.1f Mbits\n", __func__, seconds, (double)state.bitrate/1000000.0);
                   goto error;
                }
                else
                {
+                  // Pin the history so saving it never has to page it back in
+                  if (mlock(state.callback_data.cb_buff, count) != 0 && state.verbose)
+                     fprintf(stderr, "Unable to lock circular buffer memory: %s\n", strerror(errno));
+
                   state.callback_data.cb_len = count;
                   state.callback_data.cb_wptr = 0;
                   state.callback_data.cb_wrap = 0;
@@ -2197,21 +2811,9 @@ int main(int argc, const char **argv)
 
       if(state.bCircularBuffer)
       {
-         int copy_from_end, copy_from_start;
-
-         copy_from_end = state.callback_data.cb_len - state.callback_data.iframe_buff[state.callback_data.iframe_buff_rpos];
-         copy_from_start = state.callback_data.cb_len - copy_from_end;
-         copy_from_start = state.callback_data.cb_wptr < copy_from_start ? state.callback_data.cb_wptr : copy_from_start;
-         if(!state.callback_data.cb_wrap)
-         {
-            copy_from_start = state.callback_data.cb_wptr;
-            copy_from_end = 0;
-         }
-
-         fwrite(state.callback_data.header_bytes, 1, state.callback_data.header_wptr, state.callback_data.file_handle);
          // Save circular buffer
-         fwrite(state.callback_data.cb_buff + state.callback_data.iframe_buff[state.callback_data.iframe_buff_rpos], 1, copy_from_end, state.callback_data.file_handle);
-         fwrite(state.callback_data.cb_buff, 1, copy_from_start, state.callback_data.file_handle);
+         if (save_circular_buffer(&state.callback_data) != 0)
+            vcos_log_error("%s: Failed to save circular buffer data - %s", __func__, strerror(errno));
       }
 
 error:
@@ -2231,10 +2833,22 @@ error:
       if (state.encoder_connection)
          mmal_connection_destroy(state.encoder_connection);
 
+      // Stop the segmenter before closing files; it owns any pre-opened or
+      // retired segment handles
+      if (state.callback_data.segmenter)
+         segmenter_destroy(state.callback_data.segmenter);
+
+      // Drain and stop the analyser; prints the motion summary
+      if (state.callback_data.mv_analyser)
+         mv_analyser_destroy(state.callback_data.mv_analyser);
+
       // Can now close our file. Note disabling ports may flush buffers which causes
       // problems if we have already closed the file!
       if (state.callback_data.file_handle && state.callback_data.file_handle != stdout)
          fclose(state.callback_data.file_handle);
+      if (state.callback_data.dio_writer &&
+          directio_close(state.callback_data.dio_writer) != 0)
+         vcos_log_error("%s: Failed to write final output data - %s", __func__, strerror(errno));
       if (state.callback_data.imv_file_handle && state.callback_data.imv_file_handle != stdout)
          fclose(state.callback_data.imv_file_handle);
 
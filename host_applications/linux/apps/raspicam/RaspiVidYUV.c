@@ -121,6 +121,10 @@ typedef struct
    FILE *file_handle;                   /// File handle to write buffer data to.
    RASPIVIDYUV_STATE *pstate;           /// pointer to our state in case required in callback
    int abort;                           /// Set to 1 in callback if an error occurs to attempt to abort the capture
+   FILE *analytics_file_handle;         /// File to write downscaled luma frames to, or NULL
+   uint8_t *analytics_frame;            /// One downscaled output frame
+   int *analytics_xmap;                 /// Precomputed source x offset for each output column
+   int analytics_pitch;                 /// Source luma stride in bytes
 } PORT_USERDATA;
 
 /** Structure containing all state information for the current run
@@ -152,6 +156,14 @@ struct RASPIVIDYUV_STATE_S
 
    int bCapturing;                      /// State of capture/pause
 
+   char *analytics_filename;            /// filename for downscaled luma (analytics) output, or NULL
+   int analyticsWidth;                  /// analytics output width
+   int analyticsHeight;                 /// analytics output height
+   int analyticsRoiX;                   /// analytics crop origin in source pixels
+   int analyticsRoiY;
+   int analyticsRoiW;                   /// analytics crop size in source pixels; 0 = full frame
+   int analyticsRoiH;
+
    int cameraNum;                       /// Camera number
    int settings;                        /// Request settings from the camera
    int sensor_mode;                     /// Sensor mode. 0=auto. Check docs/forum for modes selected by other values.
@@ -184,6 +196,9 @@ static void display_valid_parameters(char *app_name);
 #define CommandCamSelect    12
 #define CommandSettings     13
 #define CommandSensorMode   14
+#define CommandAnalytics    15
+#define CommandAnalyticsRes 16
+#define CommandAnalyticsRoi 17
 
 static COMMAND_LIST cmdline_commands[] =
 {
@@ -202,6 +217,9 @@ static COMMAND_LIST cmdline_commands[] =
    { CommandCamSelect,     "-camselect",  "cs", "Select camera <number>. Default 0", 1 },
    { CommandSettings,      "-settings",   "set","Retrieve camera settings and write to stdout", 0},
    { CommandSensorMode,    "-mode",       "md", "Force sensor mode. 0=auto. See docs for other modes available", 1},
+   { CommandAnalytics,     "-analytics",  "an", "Output filename <filename> for downscaled luma (analytics) frames", 1},
+   { CommandAnalyticsRes,  "-anres",      "ar", "Analytics output resolution <w,h>. Default 640,360", 1},
+   { CommandAnalyticsRoi,  "-anroi",      "aroi","Crop <x,y,w,h> in source pixels for the analytics output. Default full frame", 1},
 };
 
 static int cmdline_commands_size = sizeof(cmdline_commands) / sizeof(cmdline_commands[0]);
@@ -257,6 +275,9 @@ static void default_status(RASPIVIDYUV_STATE *state)
    state->settings = 0;
    state->sensor_mode = 0;
 
+   state->analyticsWidth = 640;
+   state->analyticsHeight = 360;
+
    // Setup preview window defaults
    raspipreview_set_defaults(&state->preview_parameters);
 
@@ -509,6 +530,44 @@ static int parse_cmdline(int argc, const char **argv, RASPIVIDYUV_STATE *state)
          break;
       }
 
+      case CommandAnalytics:  // analytics output filename
+      {
+         int len = strlen(argv[i + 1]);
+         if (len)
+         {
+            state->analytics_filename = malloc(len + 1);
+            vcos_assert(state->analytics_filename);
+            if (state->analytics_filename)
+               strncpy(state->analytics_filename, argv[i + 1], len+1);
+            i++;
+         }
+         else
+            valid = 0;
+         break;
+      }
+
+      case CommandAnalyticsRes: // analytics output resolution
+      {
+         if (sscanf(argv[i + 1], "%d,%d", &state->analyticsWidth, &state->analyticsHeight) == 2 &&
+             state->analyticsWidth > 0 && state->analyticsHeight > 0)
+            i++;
+         else
+            valid = 0;
+         break;
+      }
+
+      case CommandAnalyticsRoi: // analytics crop in source pixels
+      {
+         if (sscanf(argv[i + 1], "%d,%d,%d,%d", &state->analyticsRoiX, &state->analyticsRoiY,
+                    &state->analyticsRoiW, &state->analyticsRoiH) == 4 &&
+             state->analyticsRoiX >= 0 && state->analyticsRoiY >= 0 &&
+             state->analyticsRoiW > 0 && state->analyticsRoiH > 0)
+            i++;
+         else
+            valid = 0;
+         break;
+      }
+
       default:
       {
          // Try parsing for any image specific parameters
@@ -655,6 +714,111 @@ static FILE *open_filename(RASPIVIDYUV_STATE *pState)
    return new_handle;
 }
 
+/**
+ * Crop and downscale one luma plane for the analytics output.
+ *
+ * Nearest-sample scaling using a precomputed column map. Kept as plain
+ * integer C rather than NEON intrinsics so the same code still builds for
+ * ARMv6 targets; the inner loop is a simple gather the compiler can
+ * vectorise where NEON is available.
+ *
+ * @param pData Pointer to port userdata holding the analytics settings
+ * @param luma Pointer to the start of the source luma plane
+ */
+static void analytics_downscale(PORT_USERDATA *pData, const uint8_t *luma)
+{
+   RASPIVIDYUV_STATE *pState = pData->pstate;
+   int out_w = pState->analyticsWidth;
+   int out_h = pState->analyticsHeight;
+   int y;
+
+   for (y = 0; y < out_h; y++)
+   {
+      const uint8_t *src_row = luma +
+         (pState->analyticsRoiY + y * pState->analyticsRoiH / out_h) * pData->analytics_pitch +
+         pState->analyticsRoiX;
+      uint8_t *dst_row = pData->analytics_frame + y * out_w;
+      int x;
+
+      for (x = 0; x < out_w; x++)
+         dst_row[x] = src_row[pData->analytics_xmap[x]];
+   }
+}
+
+/**
+ * Set up the analytics downscale stage - validate the ROI, open the output
+ * file and allocate the output frame and column map.
+ *
+ * @param state Pointer to state
+ *
+ * @return 0 on success, -1 on failure
+ */
+static int setup_analytics(RASPIVIDYUV_STATE *state)
+{
+   PORT_USERDATA *pData = &state->callback_data;
+   int x;
+
+   // Default ROI is the full frame
+   if (state->analyticsRoiW == 0 || state->analyticsRoiH == 0)
+   {
+      state->analyticsRoiX = 0;
+      state->analyticsRoiY = 0;
+      state->analyticsRoiW = state->width;
+      state->analyticsRoiH = state->height;
+   }
+
+   if (state->analyticsRoiX + state->analyticsRoiW > state->width ||
+       state->analyticsRoiY + state->analyticsRoiH > state->height)
+   {
+      vcos_log_error("Analytics ROI %d,%d,%d,%d does not fit in %dx%d frame",
+                     state->analyticsRoiX, state->analyticsRoiY,
+                     state->analyticsRoiW, state->analyticsRoiH,
+                     state->width, state->height);
+      return -1;
+   }
+
+   if (state->analytics_filename[0] == '-')
+   {
+      pData->analytics_file_handle = stdout;
+
+      // Ensure we don't upset the output stream with diagnostics/info
+      state->verbose = 0;
+   }
+   else
+   {
+      pData->analytics_file_handle = fopen(state->analytics_filename, "wb");
+      if (!pData->analytics_file_handle)
+      {
+         vcos_log_error("Failed to open analytics output file %s", state->analytics_filename);
+         return -1;
+      }
+   }
+
+   // Camera frames arrive with the luma stride padded to a multiple of 32
+   pData->analytics_pitch = VCOS_ALIGN_UP(state->width, 32);
+
+   pData->analytics_frame = malloc(state->analyticsWidth * state->analyticsHeight);
+   pData->analytics_xmap = malloc(state->analyticsWidth * sizeof(int));
+
+   if (!pData->analytics_frame || !pData->analytics_xmap)
+   {
+      vcos_log_error("Failed to allocate analytics buffers");
+      return -1;
+   }
+
+   for (x = 0; x < state->analyticsWidth; x++)
+      pData->analytics_xmap[x] = x * state->analyticsRoiW / state->analyticsWidth;
+
+   if (state->verbose)
+      fprintf(stderr, "Analytics output %dx%d from ROI %d,%d,%d,%d to \"%s\"\n",
+              state->analyticsWidth, state->analyticsHeight,
+              state->analyticsRoiX, state->analyticsRoiY,
+              state->analyticsRoiW, state->analyticsRoiH,
+              state->analytics_filename);
+
+   return 0;
+}
+
 
 /**
  *  buffer header callback function for camera
@@ -681,18 +845,39 @@ static void camera_buffer_callback(MMAL_PORT_T *port, MMAL_BUFFER_HEADER_T *buff
    {
       int bytes_written = buffer->length;
 
-      vcos_assert(pData->file_handle);
+      vcos_assert(pData->file_handle || pData->analytics_file_handle);
 
       if (buffer->length)
       {
          mmal_buffer_header_mem_lock(buffer);
-         bytes_written = fwrite(buffer->data, 1, buffer->length, pData->file_handle);
+
+         if (pData->file_handle)
+         {
+            bytes_written = fwrite(buffer->data, 1, buffer->length, pData->file_handle);
+
+            if (bytes_written != buffer->length)
+            {
+               vcos_log_error("Failed to write buffer data (%d from %d)- aborting", bytes_written, buffer->length);
+               pData->abort = 1;
+            }
+         }
+
+         if (pData->analytics_file_handle)
+            analytics_downscale(pData, buffer->data);
+
          mmal_buffer_header_mem_unlock(buffer);
 
-         if (bytes_written != buffer->length)
+         if (pData->analytics_file_handle)
          {
-            vcos_log_error("Failed to write buffer data (%d from %d)- aborting", bytes_written, buffer->length);
-            pData->abort = 1;
+            int analytics_bytes = pData->pstate->analyticsWidth * pData->pstate->analyticsHeight;
+
+            bytes_written = fwrite(pData->analytics_frame, 1, analytics_bytes, pData->analytics_file_handle);
+
+            if (bytes_written != analytics_bytes)
+            {
+               vcos_log_error("Failed to write analytics data (%d from %d)- aborting", bytes_written, analytics_bytes);
+               pData->abort = 1;
+            }
          }
       }
    }
@@ -1269,6 +1454,9 @@ int main(int argc, const char **argv)
       if (status == MMAL_SUCCESS)
       {
          state.callback_data.file_handle = NULL;
+         state.callback_data.analytics_file_handle = NULL;
+         state.callback_data.analytics_frame = NULL;
+         state.callback_data.analytics_xmap = NULL;
 
          if (state.filename)
          {
@@ -1291,6 +1479,14 @@ int main(int argc, const char **argv)
             }
          }
 
+         if (state.analytics_filename)
+         {
+            state.callback_data.pstate = &state;
+
+            if (setup_analytics(&state) != 0)
+               goto error;
+         }
+
          // Set up our userdata - this is passed though to the callback where we need the information.
          state.callback_data.pstate = &state;
          state.callback_data.abort = 0;
@@ -1328,7 +1524,7 @@ int main(int argc, const char **argv)
          {
             // Only save stuff if we have a filename and it opened
             // Note we use the file handle copy in the callback, as the call back MIGHT change the file handle
-            if (state.callback_data.file_handle)
+            if (state.callback_data.file_handle || state.callback_data.analytics_file_handle)
             {
                int running = 1;
 
@@ -1416,6 +1612,15 @@ error:
       if (state.callback_data.file_handle && state.callback_data.file_handle != stdout)
          fclose(state.callback_data.file_handle);
 
+      if (state.callback_data.analytics_file_handle && state.callback_data.analytics_file_handle != stdout)
+         fclose(state.callback_data.analytics_file_handle);
+
+      if (state.callback_data.analytics_frame)
+         free(state.callback_data.analytics_frame);
+
+      if (state.callback_data.analytics_xmap)
+         free(state.callback_data.analytics_xmap);
+
       raspipreview_destroy(&state.preview_parameters);
       destroy_camera_component(&state);
 
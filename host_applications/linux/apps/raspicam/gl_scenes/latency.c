@@ -0,0 +1,186 @@
+/*
+Copyright (c) 2013, Broadcom Europe Ltd
+Copyright (c) 2013, Tim Gover
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/* Renders the camera preview with a rolling frame latency histogram
+ * overlaid along the bottom of the window. Each bar is a 4ms bucket of
+ * texture-update to swap-return times from the instrumentation ring in
+ * RaspiTex.c; the right-most bar collects everything at 60ms and above,
+ * so sporadic long frames show up as a spike there rather than
+ * disappearing into an average.
+ */
+
+#include <GLES/gl.h>
+#include <GLES/glext.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include "RaspiTexUtil.h"
+
+/* Number of histogram buckets and the width of each in microseconds.
+ * 16 x 4ms covers everything up to a missed 60Hz vsync pair; the last
+ * bucket is open ended.
+ */
+#define LATENCY_BINS    16
+#define LATENCY_BIN_US  4000
+
+/* Fraction of the window height the tallest bar may use */
+#define BAR_MAX_HEIGHT  0.4f
+
+/* Full window quad for the camera texture:
+ *
+ * v0----v1
+ * |     |
+ * |     |
+ * |     |
+ * v3----v2
+ */
+static const GLfloat quad_vertices[] =
+{
+#define QV0  -1.0,  1.0,
+#define QV1   1.0,  1.0,
+#define QV2   1.0, -1.0,
+#define QV3  -1.0, -1.0,
+   QV0 QV3 QV2 QV2 QV1 QV0
+};
+
+static const GLfloat quad_tex_coords[] =
+{
+   0, 0, 0, 1, 1, 1,
+   1, 1, 1, 0, 0, 0
+};
+
+/* Two triangles (6 vertices of x,y) per histogram bar */
+static GLfloat bar_vertices[LATENCY_BINS * 12];
+
+static RASPITEX_LATENCY_SAMPLE samples[RASPITEX_LATENCY_SAMPLES];
+
+static int latency_init(RASPITEX_STATE *state)
+{
+   int rc = raspitexutil_gl_init_1_0(state);
+
+   if (rc != 0)
+      goto end;
+
+   glClearColor(0, 0, 0, 0);
+   glClearDepthf(1);
+   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+   glLoadIdentity();
+
+end:
+   return rc;
+}
+
+/**
+ * Rebuilds the histogram bar geometry from the current contents of the
+ * latency ring. Bars are normalised to the fullest bucket so the shape
+ * stays readable regardless of frame rate.
+ */
+static int latency_update_model(RASPITEX_STATE *state)
+{
+   uint32_t bins[LATENCY_BINS] = {0};
+   uint32_t count, peak = 1;
+   uint32_t i;
+
+   count = raspitex_latency_snapshot(state, samples, vcos_countof(samples));
+
+   for (i = 0; i < count; i++)
+   {
+      int64_t total_us;
+      uint32_t bin;
+
+      /* Redraws of an old texture have no camera timeline to histogram */
+      if (!samples[i].acquire_us)
+         continue;
+
+      total_us = samples[i].swap_us - samples[i].acquire_us;
+      bin = total_us / LATENCY_BIN_US;
+      if (bin >= LATENCY_BINS)
+         bin = LATENCY_BINS - 1;
+      bins[bin]++;
+   }
+
+   for (i = 0; i < LATENCY_BINS; i++)
+   {
+      if (bins[i] > peak)
+         peak = bins[i];
+   }
+
+   for (i = 0; i < LATENCY_BINS; i++)
+   {
+      GLfloat *v = bar_vertices + i * 12;
+      GLfloat slot = 1.9f / LATENCY_BINS;
+      GLfloat x0 = -0.95f + i * slot;
+      GLfloat x1 = x0 + slot * 0.8f;
+      GLfloat y0 = -0.95f;
+      GLfloat y1 = y0 + BAR_MAX_HEIGHT * bins[i] / peak;
+
+      v[0] = x0; v[1]  = y1;
+      v[2] = x0; v[3]  = y0;
+      v[4] = x1; v[5]  = y0;
+      v[6] = x1; v[7]  = y0;
+      v[8] = x1; v[9]  = y1;
+      v[10] = x0; v[11] = y1;
+   }
+
+   return 0;
+}
+
+static int latency_redraw(RASPITEX_STATE *state)
+{
+   /* Draw the camera preview across the whole window */
+   glEnable(GL_TEXTURE_EXTERNAL_OES);
+   GLCHK(glBindTexture(GL_TEXTURE_EXTERNAL_OES, state->texture));
+   glLoadIdentity();
+   glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+   glEnableClientState(GL_VERTEX_ARRAY);
+   glVertexPointer(2, GL_FLOAT, 0, quad_vertices);
+   glDisableClientState(GL_COLOR_ARRAY);
+   glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+   glTexCoordPointer(2, GL_FLOAT, 0, quad_tex_coords);
+   GLCHK(glDrawArrays(GL_TRIANGLES, 0, vcos_countof(quad_tex_coords) / 2));
+
+   /* Overlay the histogram as translucent untextured bars */
+   glDisable(GL_TEXTURE_EXTERNAL_OES);
+   glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+   glEnable(GL_BLEND);
+   glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+   glColor4f(0.2f, 1.0f, 0.2f, 0.7f);
+   glVertexPointer(2, GL_FLOAT, 0, bar_vertices);
+   GLCHK(glDrawArrays(GL_TRIANGLES, 0, vcos_countof(bar_vertices) / 2));
+   glDisable(GL_BLEND);
+
+   return 0;
+}
+
+int latency_open(RASPITEX_STATE *state)
+{
+   state->ops.gl_init = latency_init;
+   state->ops.update_model = latency_update_model;
+   state->ops.redraw = latency_redraw;
+   state->ops.update_texture = raspitexutil_update_texture;
+   return 0;
+}
@@ -51,6 +51,8 @@ enum
    OPT_ALLOC     = 'a',
    OPT_STATUS    = 's',
    OPT_PID       = 'p',
+   OPT_STREAM    = 'S',
+   OPT_BUFFERS   = 'b',
    OPT_HELP      = 'h',
 
    // Options from this point onwards don't have any short option equivalents
@@ -64,10 +66,28 @@ static struct option long_opts[] =
    { "alloc",              required_argument,   NULL,    OPT_ALLOC },
    { "pid",                required_argument,   NULL,    OPT_PID },
    { "status",             required_argument,   NULL,    OPT_STATUS },
+   { "stream",             required_argument,   NULL,    OPT_STREAM },
+   { "buffers",            required_argument,   NULL,    OPT_BUFFERS },
    { "help",               no_argument,         NULL,    OPT_HELP },
    { 0,                    0,                   0,       0 }
 };
 
+// Streaming capture mode: a persistent ring of shared memory buffers which a
+// producer (typically on the VC side, importing the advertised vc-handles)
+// fills and sequence numbers, and which we consume in place - no copies.
+// Each buffer starts with this header; the producer sets 'sequence' last
+// (non-zero, incrementing), and the consumer writes 0 to hand the buffer back.
+#define STREAM_MAX_BUFFERS      32
+#define STREAM_DEFAULT_BUFFERS  8
+
+typedef struct
+{
+   volatile uint32_t sequence;  // 0 = free for the producer, N = Nth filled buffer
+   volatile uint32_t bytes;     // payload length, set before 'sequence'
+} STREAM_BUFFER_HEADER_T;
+
+static volatile sig_atomic_t quit_now = 0;
+
 // Maximum length of option string (3 characters max for each option + NULL)
 #define OPTSTRING_LEN  ( sizeof( long_opts ) / sizeof( *long_opts ) * 3 + 1 )
 
@@ -90,6 +110,9 @@ static void show_usage( void )
    vcos_log_info( "                map                    host map status" );
    vcos_log_info( "                map <pid>              host map status for pid" );
    vcos_log_info( "                host <pid>             host allocations for pid" );
+   vcos_log_info( "  -S, --stream=SIZE            Streaming capture from a ring of SIZE-byte buffers" );
+   vcos_log_info( "  -b, --buffers=COUNT          Number of ring buffers for --stream (default %d)",
+                  STREAM_DEFAULT_BUFFERS );
    vcos_log_info( "  -h, --help                   Print this information" );
 }
 
@@ -161,6 +184,7 @@ static void control_c( int signum )
 
     vcos_log_info( "Shutting down..." );
 
+    quit_now = 1;
     vcos_event_signal( &quit_event );
 }
 
@@ -180,6 +204,105 @@ static int start_monitor( void )
    return 0;
 }
 
+static int stream_capture( uint32_t alloc_size, uint32_t num_buffers )
+{
+   unsigned int usr_hdl[STREAM_MAX_BUFFERS];
+   STREAM_BUFFER_HEADER_T *hdr[STREAM_MAX_BUFFERS];
+   uint32_t next_seq = 1;
+   uint32_t consumed = 0, dropped = 0;
+   uint64_t bytes = 0;
+   uint32_t last_report, now;
+   uint32_t i, allocated;
+
+   if ( alloc_size < sizeof(STREAM_BUFFER_HEADER_T) )
+   {
+      vcos_log_info( "Stream buffer size %u too small", alloc_size );
+      return -1;
+   }
+
+   // Allocate and pin the whole ring up front. The buffers stay locked for
+   // the lifetime of the capture so the producer mappings remain valid.
+   for ( allocated = 0; allocated < num_buffers; allocated++ )
+   {
+      usr_hdl[allocated] = vcsm_malloc( alloc_size, "smem-stream" );
+      if ( usr_hdl[allocated] == 0 )
+      {
+         vcos_log_info( "Failed to allocate ring buffer %u of %u-bytes",
+                        allocated, alloc_size );
+         goto err_free;
+      }
+
+      hdr[allocated] = (STREAM_BUFFER_HEADER_T *)vcsm_lock( usr_hdl[allocated] );
+      if ( hdr[allocated] == NULL )
+      {
+         vcsm_free( usr_hdl[allocated] );
+         goto err_free;
+      }
+
+      hdr[allocated]->sequence = 0;
+      hdr[allocated]->bytes = 0;
+
+      // Advertise the handle for the producer to import.
+      vcos_log_info( "Ring buffer %u: vc-hdl %x, %u-bytes",
+                     allocated, vcsm_vc_hdl_from_hdl( usr_hdl[allocated] ),
+                     alloc_size );
+   }
+
+   vcos_log_info( "Streaming from %u buffers, ctrl-c to stop...", num_buffers );
+
+   // Consume buffers in sequence order. The mappings are uncached so the
+   // headers can simply be polled; there is no doorbell from the producer.
+   last_report = vcos_getmicrosecs();
+   while ( !quit_now )
+   {
+      STREAM_BUFFER_HEADER_T *h = hdr[(next_seq - 1) % num_buffers];
+      uint32_t seq = h->sequence;
+
+      if ( seq == 0 )
+      {
+         // Nothing new in the slot we expect - don't spin flat out.
+         vcos_sleep( 1 );
+      }
+      else
+      {
+         if ( seq != next_seq )
+         {
+            // The producer has lapped us - resynchronise.
+            dropped += seq - next_seq;
+            next_seq = seq;
+         }
+
+         // The payload after the header would be processed in place here.
+         bytes += h->bytes;
+         consumed++;
+
+         // Hand the buffer back to the producer.
+         h->sequence = 0;
+         next_seq++;
+      }
+
+      now = vcos_getmicrosecs();
+      if ( now - last_report >= 1000000 )
+      {
+         vcos_log_info( "Consumed %u buffers (%u dropped), %u KB",
+                        consumed, dropped, (uint32_t)(bytes / 1024) );
+         last_report = now;
+      }
+   }
+
+   vcos_log_info( "Stream total: %u buffers (%u dropped), %u KB",
+                  consumed, dropped, (uint32_t)(bytes / 1024) );
+
+err_free:
+   for ( i = 0; i < allocated; i++ )
+   {
+      vcsm_unlock_hdl( usr_hdl[i] );
+      vcsm_free( usr_hdl[i] );
+   }
+
+   return allocated == num_buffers ? 0 : -1;
+}
+
 // ---- Public Functions -----------------------------------------------------
 
 // #define DOUBLE_ALLOC
@@ -192,7 +315,10 @@ int main( int argc, char **argv )
    int  opt;
    int  opt_alloc = 0;
    int  opt_status = 0;
-   uint32_t alloc_size;
+   int  opt_stream = 0;
+   uint32_t alloc_size = 0;
+   uint32_t stream_size = 0;
+   uint32_t stream_buffers = STREAM_DEFAULT_BUFFERS;
    int  opt_pid = -1;
    VCSM_STATUS_T status_mode = VCSM_STATUS_NONE;
 
@@ -249,6 +375,32 @@ int main( int argc, char **argv )
 
             break;
          }
+         case OPT_STREAM:
+         {
+            char *end;
+            stream_size = (uint32_t)strtoul( optarg, &end, 10 );
+            if (end == optarg)
+            {
+               vcos_log_info( "Invalid arguments '%s'", optarg );
+               goto err_out;
+            }
+
+            opt_stream = 1;
+            break;
+         }
+         case OPT_BUFFERS:
+         {
+            char *end;
+            stream_buffers = (uint32_t)strtoul( optarg, &end, 10 );
+            if (end == optarg ||
+                stream_buffers < 2 || stream_buffers > STREAM_MAX_BUFFERS)
+            {
+               vcos_log_info( "Invalid arguments '%s'", optarg );
+               goto err_out;
+            }
+
+            break;
+         }
          case OPT_STATUS:
          {
             char status_str[32];
@@ -425,7 +577,16 @@ int main( int argc, char **argv )
    {
       get_status( status_mode, opt_pid );
    }
-   
+
+   if ( opt_stream == 1 )
+   {
+      start_monitor();
+
+      stream_capture( stream_size, stream_buffers );
+
+      vcos_event_delete( &quit_event );
+   }
+
    // If we allocated something, wait for the signal to exit to give chance for the
    // user to poke around the allocation test.
    //
@@ -0,0 +1,109 @@
+/*
+Copyright (c) 2012, Broadcom Europe Ltd
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/* Dump the vcos shared telemetry page, see interface/vcos/vcos_telemetry.h.
+ * The page is mapped read-only and walked directly - no library calls -
+ * so the cost of sampling is one mmap at startup and nothing after.
+ *
+ * usage: vctelemetry [interval]
+ *
+ * With no argument the live counters are printed once. With an interval
+ * in seconds, the counters are printed repeatedly with a blank line
+ * between samples.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "interface/vcos/vcos_telemetry.h"
+
+int main(int argc, char **argv)
+{
+   const VCOS_TELEMETRY_PAGE_T *page;
+   int interval = 0;
+   unsigned i, num_slots;
+   int fd;
+
+   if (argc > 1)
+   {
+      interval = atoi(argv[1]);
+      if (interval <= 0)
+      {
+         fprintf(stderr, "usage: %s [interval]\n", argv[0]);
+         return 1;
+      }
+   }
+
+   fd = shm_open("/" VCOS_TELEMETRY_SHM_NAME, O_RDONLY, 0);
+   if (fd < 0)
+   {
+      fprintf(stderr, "%s: no telemetry page (%s)\n", argv[0], strerror(errno));
+      return 1;
+   }
+
+   page = mmap(NULL, sizeof(*page), PROT_READ, MAP_SHARED, fd, 0);
+   close(fd);
+   if (page == MAP_FAILED)
+   {
+      fprintf(stderr, "%s: mmap failed (%s)\n", argv[0], strerror(errno));
+      return 1;
+   }
+
+   if (page->magic != VCOS_TELEMETRY_MAGIC || page->version != 1)
+   {
+      fprintf(stderr, "%s: telemetry page not initialised\n", argv[0]);
+      return 1;
+   }
+
+   num_slots = page->num_slots < VCOS_TELEMETRY_SLOTS ?
+      page->num_slots : VCOS_TELEMETRY_SLOTS;
+
+   for (;;)
+   {
+      for (i = 0; i < num_slots; i++)
+      {
+         const VCOS_TELEMETRY_SLOT_T *slot = &page->slots[i];
+         if (slot->state == VCOS_TELEMETRY_SLOT_LIVE)
+            printf("%-*s %10u\n", VCOS_TELEMETRY_NAMELEN, slot->name, slot->value);
+      }
+
+      if (!interval)
+         break;
+
+      printf("\n");
+      fflush(stdout);
+      sleep(interval);
+   }
+
+   return 0;
+}
@@ -30,59 +30,20 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
-#include <fcntl.h>
-#include <unistd.h>
-#include <assert.h>
-#include <stdint.h>
-#include <sys/mman.h>
-#include <sys/ioctl.h>		/* ioctl */
 
-#define DEVICE_FILE_NAME "/dev/vcio"
-#define MAJOR_NUM 100
-#define IOCTL_MBOX_PROPERTY _IOWR(MAJOR_NUM, 0, char *)
+#include "vcmbox.h"
 
-/*
- * use ioctl to send mbox property message
- */
-
-static int mbox_property(int file_desc, void *buf)
-{
-   int ret_val = ioctl(file_desc, IOCTL_MBOX_PROPERTY, buf);
-
-   if (ret_val < 0) {
-      printf("ioctl_set_msg failed:%d\n", ret_val);
-   }
-   return ret_val;
-}
-
-
-static int mbox_open()
-{
-   int file_desc;
-
-   // open a char device file used for communicating with kernel mbox driver
-   file_desc = open(DEVICE_FILE_NAME, 0);
-   if (file_desc < 0) {
-      printf("Can't open device file: %s\n", DEVICE_FILE_NAME);
-      printf("Try creating a device file with: sudo mknod %s c %d 0\n", DEVICE_FILE_NAME, MAJOR_NUM);
-      exit(-1);
-   }
-   return file_desc;
-}
-
-static void mbox_close(int file_desc) {
-  close(file_desc);
-}
-
-
-#define MAX_WORDS 256
+#define MAX_WORDS VCMBOX_MAX_WORDS
 
 int main(int argc, char *argv[])
 {
-  int mb = mbox_open();
+  int mb = vcmbox_open();
   unsigned words[MAX_WORDS] = {};
   int i;
 
+  if (mb < 0)
+    exit(-1);
+
   if (argc < 2 || argc+1 >= MAX_WORDS)
   {
     printf("Usage %s [word0] [word1] ...\n", argv[0]);
@@ -96,9 +57,9 @@ int main(int argc, char *argv[])
 
   words[argc+1] = 0; // end tag
 
-  int s = mbox_property(mb, words);
+  int s = vcmbox_property(mb, words);
 
-  mbox_close(mb);
+  vcmbox_close(mb);
 
   for (i=0; i<argc+2; i++)
      printf("0x%08x ", words[i]);
@@ -0,0 +1,140 @@
+/*
+Copyright (c) 2015 Raspberry Pi (Trading) Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// Library for driving the mailbox property interface to VideoCore
+
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>		/* ioctl */
+
+#include "vcmbox.h"
+
+#define DEVICE_FILE_NAME "/dev/vcio"
+#define MAJOR_NUM 100
+#define IOCTL_MBOX_PROPERTY _IOWR(MAJOR_NUM, 0, char *)
+
+// Request/response codes in word 1 of the property buffer
+#define VCMBOX_PROCESS_REQUEST   0x00000000
+#define VCMBOX_REQUEST_SUCCESS   0x80000000
+
+// Bit set in a tag's request/response code once the firmware has filled it in
+#define VCMBOX_TAG_RESPONSE      0x80000000
+
+/*
+ * use ioctl to send mbox property message
+ */
+
+int vcmbox_property(int file_desc, void *buf)
+{
+   int ret_val = ioctl(file_desc, IOCTL_MBOX_PROPERTY, buf);
+
+   if (ret_val < 0) {
+      printf("ioctl_set_msg failed:%d\n", ret_val);
+   }
+   return ret_val;
+}
+
+int vcmbox_open(void)
+{
+   int file_desc;
+
+   // open a char device file used for communicating with kernel mbox driver
+   file_desc = open(DEVICE_FILE_NAME, 0);
+   if (file_desc < 0) {
+      printf("Can't open device file: %s\n", DEVICE_FILE_NAME);
+      printf("Try creating a device file with: sudo mknod %s c %d 0\n", DEVICE_FILE_NAME, MAJOR_NUM);
+   }
+   return file_desc;
+}
+
+void vcmbox_close(int file_desc)
+{
+   close(file_desc);
+}
+
+void vcmbox_batch_init(VCMBOX_BATCH_T *batch)
+{
+   memset(batch->words, 0, sizeof batch->words);
+   batch->words[0] = 0;                       // total size, filled in on submit
+   batch->words[1] = VCMBOX_PROCESS_REQUEST;
+   batch->used = 2;
+}
+
+int vcmbox_batch_add_tag(VCMBOX_BATCH_T *batch, unsigned tag,
+                         const unsigned *req, unsigned req_words,
+                         unsigned resp_words)
+{
+   unsigned value_words = req_words > resp_words ? req_words : resp_words;
+   int value_index;
+
+   // tag id + value buffer size + request/response code + value buffer,
+   // and one word must be kept back for the end tag
+   if (batch->used + 3 + value_words + 1 > VCMBOX_MAX_WORDS)
+      return -1;
+
+   batch->words[batch->used++] = tag;
+   batch->words[batch->used++] = value_words * sizeof batch->words[0];
+   batch->words[batch->used++] = 0;           // request: no response yet
+
+   value_index = batch->used;
+   if (req_words)
+      memcpy(&batch->words[batch->used], req, req_words * sizeof batch->words[0]);
+   batch->used += value_words;
+
+   return value_index;
+}
+
+int vcmbox_batch_submit(int file_desc, VCMBOX_BATCH_T *batch)
+{
+   int ret_val;
+
+   batch->words[batch->used] = 0;             // end tag
+   batch->words[0] = (batch->used + 1) * sizeof batch->words[0];
+
+   ret_val = vcmbox_property(file_desc, batch->words);
+   if (ret_val < 0)
+      return ret_val;
+
+   return batch->words[1] == VCMBOX_REQUEST_SUCCESS ? 0 : -1;
+}
+
+unsigned vcmbox_batch_tag_words(const VCMBOX_BATCH_T *batch, int value_index)
+{
+   unsigned code;
+
+   if (value_index < 3 || (unsigned)value_index > batch->used)
+      return 0;
+
+   // the request/response code sits just before the value buffer
+   code = batch->words[value_index - 1];
+   if (!(code & VCMBOX_TAG_RESPONSE))
+      return 0;
+
+   return (code & ~VCMBOX_TAG_RESPONSE) / sizeof batch->words[0];
+}
@@ -0,0 +1,94 @@
+/*
+Copyright (c) 2015 Raspberry Pi (Trading) Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// Library interface to the VideoCore mailbox property channel.
+//
+// The property interface accepts several concatenated tags in one buffer,
+// so a batch of queries can be answered with a single ioctl and a single
+// mailbox round trip instead of one per tag.
+
+#ifndef VCMBOX_H
+#define VCMBOX_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Size of a property buffer in 32-bit words
+#define VCMBOX_MAX_WORDS 256
+
+// A property buffer holding zero or more concatenated tags.
+// Fill it with vcmbox_batch_init/vcmbox_batch_add_tag and send it with
+// vcmbox_batch_submit; all fields are managed by those functions.
+typedef struct
+{
+   unsigned words[VCMBOX_MAX_WORDS];
+   unsigned used;       // words used so far, excluding the end tag
+} VCMBOX_BATCH_T;
+
+// Open the mailbox device. Returns the file descriptor, or negative on error.
+int vcmbox_open(void);
+
+// Close the mailbox device.
+void vcmbox_close(int file_desc);
+
+// Send a raw, caller-built property buffer. Returns the ioctl result.
+int vcmbox_property(int file_desc, void *buf);
+
+// Start building a new batch of tags.
+void vcmbox_batch_init(VCMBOX_BATCH_T *batch);
+
+// Append one tag to the batch.
+//
+// 'req' points to 'req_words' words of request data (may be NULL if zero);
+// 'resp_words' is the number of words the response may occupy. The value
+// buffer is sized for the larger of the two.
+//
+// Returns the index into batch->words where the tag's value buffer starts,
+// so the response can be read from there after submitting, or -1 if the
+// tag does not fit in the buffer.
+int vcmbox_batch_add_tag(VCMBOX_BATCH_T *batch, unsigned tag,
+                         const unsigned *req, unsigned req_words,
+                         unsigned resp_words);
+
+// Send the whole batch with a single ioctl.
+//
+// Returns 0 on success (the firmware processed the request; individual tag
+// responses can still be checked with vcmbox_batch_tag_words), or negative
+// on error.
+int vcmbox_batch_submit(int file_desc, VCMBOX_BATCH_T *batch);
+
+// Number of response words the firmware wrote for the tag whose value
+// buffer starts at 'value_index' (as returned by vcmbox_batch_add_tag).
+// Returns 0 if the tag was not processed.
+unsigned vcmbox_batch_tag_words(const VCMBOX_BATCH_T *batch, int value_index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VCMBOX_H */
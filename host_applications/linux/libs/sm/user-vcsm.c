@@ -59,6 +59,29 @@ static unsigned int vcsm_page_size = 0;
 
 static VCOS_ONCE_T vcsm_once = VCOS_ONCE_INIT;
 static VCOS_MUTEX_T vcsm_mutex;
+
+/* Client side pool of allocations eligible for reuse (see
+** vcsm_malloc_pool).  Parked entries hold on to their videocore
+** allocation until the total parked memory exceeds the watermark.
+*/
+#define VCSM_POOL_MAX_ENTRIES        32
+#define VCSM_POOL_MIN_BUCKET         4096
+#define VCSM_POOL_WATERMARK_DEFAULT  (16 << 20)
+
+typedef struct
+{
+   unsigned int handle;       /* User opaque handle, 0 for a free slot. */
+   unsigned int size;         /* Bucket size the block was allocated with. */
+   VCSM_CACHE_TYPE_T cache;   /* Cache behavior the block was allocated with. */
+   int in_use;                /* Block currently handed out to the application. */
+   unsigned int seq;          /* Park order, for oldest first eviction. */
+
+} VCSM_POOL_ENTRY_T;
+
+static VCSM_POOL_ENTRY_T vcsm_pool[VCSM_POOL_MAX_ENTRIES];
+static unsigned int vcsm_pool_held;
+static unsigned int vcsm_pool_seq;
+static unsigned int vcsm_pool_watermark = VCSM_POOL_WATERMARK_DEFAULT;
 /* Cache [(current, new) -> outcome] mapping table, ignoring identity.
 **
 ** Note: Videocore cache mode cannot be udpated 'lock' time.
@@ -110,6 +133,64 @@ static VCSM_CACHE_TYPE_T vcsm_cache_table_lookup( VCSM_CACHE_TYPE_T current,
    return current;
 }
 
+/* Rounds an allocation size up to the pool bucket it belongs to
+** (next power of two, no smaller than a page worth).
+*/
+static unsigned int vcsm_pool_bucket( unsigned int size )
+{
+   unsigned int bucket = VCSM_POOL_MIN_BUCKET;
+
+   while ( bucket && (bucket < size) )
+   {
+      bucket <<= 1;
+   }
+
+   /* Sizes too large to bucket are allocated (and reused) exactly.
+   */
+   return bucket ? bucket : size;
+}
+
+
+/* Frees parked pool entries, oldest first, until at most 'keep_bytes'
+** worth of blocks remain held.
+**
+** Caller holds vcsm_mutex.
+*/
+static void vcsm_pool_evict( unsigned int keep_bytes )
+{
+   while ( vcsm_pool_held > keep_bytes )
+   {
+      VCSM_POOL_ENTRY_T *oldest = NULL;
+      int i;
+
+      for ( i = 0; i < VCSM_POOL_MAX_ENTRIES; i++ )
+      {
+         if ( vcsm_pool[i].handle && !vcsm_pool[i].in_use &&
+              ((oldest == NULL) || (vcsm_pool[i].seq < oldest->seq)) )
+         {
+            oldest = &vcsm_pool[i];
+         }
+      }
+
+      if ( oldest == NULL )
+      {
+         break;
+      }
+
+      vcos_log_trace( "[%s]: [%d]: evict (hdl: %x) - size %u - held %u",
+                      __func__,
+                      getpid(),
+                      oldest->handle,
+                      oldest->size,
+                      vcsm_pool_held );
+
+      vcsm_free( oldest->handle );
+      vcsm_pool_held -= oldest->size;
+      memset( oldest, 0, sizeof(*oldest) );
+   }
+}
+
+
 /* A one off vcsm initialization routine
 */
 static void vcsm_init_once(void)
@@ -188,6 +269,14 @@ void vcsm_exit( void )
       goto out; /* We're done. */
    }
 
+   /* Drop anything parked in the allocation pool.  The device close
+   ** below would reclaim the memory anyway, but this keeps the pool
+   ** accounting straight should the service be re-initialized later.
+   */
+   vcsm_pool_evict( 0 );
+   memset( vcsm_pool, 0, sizeof(vcsm_pool) );
+   vcsm_pool_held = 0;
+
    close( vcsm_handle );
    vcsm_handle = VCSM_INVALID_HANDLE;
 
@@ -498,6 +587,188 @@ out:
 }
 
 
+/* Allocates a block of memory of size 'size' via the vcsm memory
+** allocator, reusing a previously pooled block when one of a
+** suitable size and cache behavior is available.
+**
+** Returns:        0 on error
+**                 a non-zero opaque handle on success.
+**
+** Requested sizes are rounded up to power of two buckets so blocks
+** freed via vcsm_free_pool can be recycled by later requests of a
+** similar size; the block handed out may therefore be larger than
+** requested.
+*/
+unsigned int vcsm_malloc_pool( unsigned int size, VCSM_CACHE_TYPE_T cache, char *name )
+{
+   unsigned int bucket;
+   unsigned int handle;
+   int i;
+
+   if ( (vcsm_handle == VCSM_INVALID_HANDLE) || (size == 0) )
+   {
+      vcos_log_error( "[%s]: [%d]: NULL size or invalid device!",
+                      __func__,
+                      getpid() );
+
+      return 0;
+   }
+
+   bucket = vcsm_pool_bucket( size );
+
+   /* Reuse a parked block of the right bucket and cache behavior if
+   ** one is available, saving the videocore allocation round trip.
+   */
+   vcos_mutex_lock( &vcsm_mutex );
+
+   for ( i = 0; i < VCSM_POOL_MAX_ENTRIES; i++ )
+   {
+      if ( vcsm_pool[i].handle && !vcsm_pool[i].in_use &&
+           (vcsm_pool[i].size == bucket) &&
+           (vcsm_pool[i].cache == cache) )
+      {
+         vcsm_pool[i].in_use = 1;
+         vcsm_pool_held -= vcsm_pool[i].size;
+         handle = vcsm_pool[i].handle;
+
+         vcos_mutex_unlock( &vcsm_mutex );
+
+         vcos_log_trace( "[%s]: [%d]: reuse (hdl: %x) - size %u (bucket %u)",
+                         __func__,
+                         getpid(),
+                         handle,
+                         size,
+                         bucket );
+
+         return handle;
+      }
+   }
+
+   vcos_mutex_unlock( &vcsm_mutex );
+
+   /* Nothing suitable parked, allocate a fresh block of the full
+   ** bucket size so it remains reusable for similar requests later.
+   */
+   handle = vcsm_malloc_cache( bucket, cache, name );
+
+   if ( handle == 0 )
+   {
+      return 0;
+   }
+
+   /* Track the new block so vcsm_free_pool can park it.  If the
+   ** tracking table is full the block is simply handed out untracked
+   ** and vcsm_free_pool will free it for real.
+   */
+   vcos_mutex_lock( &vcsm_mutex );
+
+   for ( i = 0; i < VCSM_POOL_MAX_ENTRIES; i++ )
+   {
+      if ( vcsm_pool[i].handle == 0 )
+      {
+         vcsm_pool[i].handle = handle;
+         vcsm_pool[i].size   = bucket;
+         vcsm_pool[i].cache  = cache;
+         vcsm_pool[i].in_use = 1;
+         break;
+      }
+   }
+
+   vcos_mutex_unlock( &vcsm_mutex );
+
+   return handle;
+}
+
+
+/* Returns a block of memory allocated by vcsm_malloc_pool to the
+** pool rather than freeing it immediately.
+**
+** The handle should be considered invalid upon return from this
+** call.
+**
+** Parked blocks are freed for real, oldest first, once the total
+** memory held by the pool exceeds the pool watermark.  A handle
+** which was not allocated through the pool is simply freed.
+*/
+void vcsm_free_pool( unsigned int handle )
+{
+   VCSM_POOL_ENTRY_T *entry = NULL;
+   int i;
+
+   if ( (vcsm_handle == VCSM_INVALID_HANDLE) || (handle == 0) )
+   {
+      vcos_log_error( "[%s]: [%d]: invalid device or handle!",
+                      __func__,
+                      getpid() );
+
+      return;
+   }
+
+   vcos_mutex_lock( &vcsm_mutex );
+
+   for ( i = 0; i < VCSM_POOL_MAX_ENTRIES; i++ )
+   {
+      if ( vcsm_pool[i].in_use && (vcsm_pool[i].handle == handle) )
+      {
+         entry = &vcsm_pool[i];
+         break;
+      }
+   }
+
+   if ( entry == NULL )
+   {
+      vcos_mutex_unlock( &vcsm_mutex );
+
+      /* Not tracked by the pool, free it for real.
+      */
+      vcsm_free( handle );
+      return;
+   }
+
+   entry->in_use = 0;
+   entry->seq    = ++vcsm_pool_seq;
+   vcsm_pool_held += entry->size;
+
+   vcos_log_trace( "[%s]: [%d]: park (hdl: %x) - size %u - held %u",
+                   __func__,
+                   getpid(),
+                   entry->handle,
+                   entry->size,
+                   vcsm_pool_held );
+
+   /* Lazily release the oldest parked blocks if the pool now holds
+   ** more than the application wants to keep around.
+   */
+   vcsm_pool_evict( vcsm_pool_watermark );
+
+   vcos_mutex_unlock( &vcsm_mutex );
+}
+
+
+/* Releases memory parked in the allocation pool until at most
+** 'keep_bytes' worth of blocks remain held (0 releases everything).
+*/
+void vcsm_pool_trim( unsigned int keep_bytes )
+{
+   vcos_mutex_lock( &vcsm_mutex );
+   vcsm_pool_evict( keep_bytes );
+   vcos_mutex_unlock( &vcsm_mutex );
+}
+
+
+/* Sets the maximum amount of memory, in bytes, the allocation pool
+** will keep parked for reuse; the pool is trimmed immediately if it
+** currently holds more.
+*/
+void vcsm_pool_set_watermark( unsigned int bytes )
+{
+   vcos_mutex_lock( &vcsm_mutex );
+   vcsm_pool_watermark = bytes;
+   vcsm_pool_evict( bytes );
+   vcos_mutex_unlock( &vcsm_mutex );
+}
+
+
 /* Queries the status of the the vcsm.
 **
 ** Triggers dump of various kind of information, see the
@@ -927,6 +1198,147 @@ out:
 }
 
 
+/* Locks the memory associated with this opaque handle, limiting any
+** host cache invalidation to the given sub range of the block.
+**
+** Returns:        NULL on error
+**                 a valid pointer on success.
+**
+** The pointer returned corresponds to the start of the block, but
+** for a host cached allocation only data within the given range is
+** guaranteed coherent with videocore following this call.
+**
+** On success, the pointer returned is only valid within
+** the lock content (ie until a corresponding vcsm_unlock_xx
+** is invoked).
+*/
+void *vcsm_lock_range( unsigned int handle,
+                       unsigned int offset, unsigned int size )
+{
+   int rc;
+   struct vmcs_sm_ioctl_lock_unlock lock_unlock;
+   struct vmcs_sm_ioctl_size sz;
+   struct vmcs_sm_ioctl_cache cache;
+   void *usr_ptr = NULL;
+
+   if ( (vcsm_handle == VCSM_INVALID_HANDLE) || (handle == 0) )
+   {
+      vcos_log_error( "[%s]: [%d]: invalid device or invalid handle!",
+                      __func__,
+                      getpid() );
+
+      goto out;
+   }
+
+   memset( &sz, 0, sizeof(sz) );
+   memset( &lock_unlock, 0, sizeof(lock_unlock) );
+   memset( &cache, 0, sizeof(cache) );
+
+   /* Verify what we want is valid.
+   */
+   sz.handle = handle;
+
+   rc = ioctl( vcsm_handle,
+               VMCS_SM_IOCTL_SIZE_USR_HDL,
+               &sz );
+
+   vcos_log_trace( "[%s]: [%d]: ioctl size-usr-hdl %d (hdl: %x) - size %u, range [%u;%u]",
+                   __func__,
+                   getpid(),
+                   rc,
+                   sz.handle,
+                   sz.size,
+                   offset,
+                   offset + size );
+
+   /* We will not be able to lock the resource!
+   */
+   if ( (rc < 0) || (sz.size == 0) )
+   {
+      goto out;
+   }
+
+   /* The requested range must lie entirely within the block.
+   */
+   if ( (size == 0) || (offset > sz.size) || (size > (sz.size - offset)) )
+   {
+      vcos_log_error( "[%s]: [%d]: invalid range [%u;%u] - size: %u (hdl: %x)",
+                      __func__,
+                      getpid(),
+                      offset,
+                      offset + size,
+                      sz.size,
+                      sz.handle );
+
+      goto out;
+   }
+
+   /* Lock the allocated buffer all the way through videocore.
+   */
+   lock_unlock.handle    = sz.handle;
+
+   rc = ioctl( vcsm_handle,
+               VMCS_SM_IOCTL_MEM_LOCK,
+               &lock_unlock );
+
+   vcos_log_trace( "[%s]: [%d]: ioctl mem-lock %d (hdl: %x)",
+                   __func__,
+                   getpid(),
+                   rc,
+                   lock_unlock.handle );
+
+   /* We will not be able to lock the resource!
+   */
+   if ( rc < 0 )
+   {
+      goto out;
+   }
+
+   usr_ptr = (void *) lock_unlock.addr;
+
+   /* If applicable, invalidate the cache now, but only over the
+   ** range the caller asked for.
+   */
+   if ( usr_ptr )
+   {
+      cache.handle = sz.handle;
+      cache.addr   = (unsigned int) usr_ptr + offset;
+      cache.size   = size;
+
+      rc = ioctl( vcsm_handle,
+                  VMCS_SM_IOCTL_MEM_INVALID,
+                  &cache );
+
+      vcos_log_trace( "[%s]: [%d]: ioctl invalidate (cache) %d (hdl: %x, addr: %x, size: %u)",
+                      __func__,
+                      getpid(),
+                      rc,
+                      cache.handle,
+                      cache.addr,
+                      cache.size );
+
+      if ( rc < 0 )
+      {
+         vcos_log_error( "[%s]: [%d]: invalidate failed (rc: %d) - [%x;%x] - size: %u (hdl: %x) - cache incoherency",
+                         __func__,
+                         getpid(),
+                         rc,
+                         (unsigned int) cache.addr,
+                         (unsigned int) (cache.addr + cache.size),
+                         (unsigned int) (cache.addr + cache.size) - (unsigned int) cache.addr,
+                         cache.handle );
+      }
+   }
+
+   /* Done.
+   */
+   goto out;
+
+out:
+   return usr_ptr;
+}
+
+
 /* Locks the memory associated with this opaque handle.  The lock
 ** also gives a chance to update the *host* cache behavior of the
 ** allocated buffer if so desired.  The *videocore* cache behavior
@@ -1424,6 +1836,134 @@ int vcsm_unlock_hdl( unsigned int handle )
    return vcsm_unlock_hdl_sp( handle, 0 );
 }
 
+
+/* Unlocks the memory associated with this user opaque handle,
+** limiting any host cache flush to the given sub range of the block.
+**
+** The range should cover all the data the application wrote while
+** holding the lock, typically the same range which was passed to
+** vcsm_lock_range.
+**
+** Returns:        0 on success
+**                 -errno on error.
+**
+** After unlocking an opaque handle, the user should no longer
+** attempt to reference the mapped addressed once associated
+** with it.
+*/
+int vcsm_unlock_hdl_range( unsigned int handle,
+                           unsigned int offset, unsigned int size )
+{
+   int rc;
+   struct vmcs_sm_ioctl_lock_unlock lock_unlock;
+   struct vmcs_sm_ioctl_chk chk;
+   struct vmcs_sm_ioctl_cache cache;
+
+   if ( (vcsm_handle == VCSM_INVALID_HANDLE) || (handle == 0) )
+   {
+      vcos_log_error( "[%s]: [%d]: invalid device or invalid handle!",
+                      __func__,
+                      getpid() );
+
+      rc = -EIO;
+      goto out;
+   }
+
+   memset( &chk, 0, sizeof(chk) );
+   memset( &lock_unlock, 0, sizeof(lock_unlock) );
+   memset( &cache, 0, sizeof(cache) );
+
+   /* Retrieve the handle of the memory we want to lock.
+   */
+   chk.handle = handle;
+
+   rc = ioctl( vcsm_handle,
+               VMCS_SM_IOCTL_CHK_USR_HDL,
+               &chk );
+
+   vcos_log_trace( "[%s]: [%d]: ioctl chk-usr-hdl %d (hdl: %x, addr: %x, sz: %u) range [%u;%u]",
+                   __func__,
+                   getpid(),
+                   rc,
+                   chk.handle,
+                   chk.addr,
+                   chk.size,
+                   offset,
+                   offset + size );
+
+   /* We will not be able to flush/unlock the resource!
+   */
+   if ( rc < 0 )
+   {
+      goto out;
+   }
+
+   /* The requested range must lie entirely within the block.
+   */
+   if ( (size == 0) || (offset > chk.size) || (size > (chk.size - offset)) )
+   {
+      vcos_log_error( "[%s]: [%d]: invalid range [%u;%u] - size: %u (hdl: %x)",
+                      __func__,
+                      getpid(),
+                      offset,
+                      offset + size,
+                      chk.size,
+                      chk.handle );
+
+      rc = -EINVAL;
+      goto out;
+   }
+
+   /* If applicable, flush the cache now, but only over the range
+   ** the caller asked for.
+   */
+   if ( chk.addr )
+   {
+      cache.handle = chk.handle;
+      cache.addr   = chk.addr + offset;
+      cache.size   = size;
+
+      rc = ioctl( vcsm_handle,
+                  VMCS_SM_IOCTL_MEM_FLUSH,
+                  &cache );
+
+      vcos_log_trace( "[%s]: [%d]: ioctl flush (cache) %d (hdl: %x)",
+                      __func__,
+                      getpid(),
+                      rc,
+                      cache.handle );
+
+      if ( rc < 0 )
+      {
+         vcos_log_error( "[%s]: [%d]: flush failed (rc: %d) - [%x;%x] - size: %u (hdl: %x) - cache incoherency",
+                         __func__,
+                         getpid(),
+                         rc,
+                         (unsigned int) cache.addr,
+                         (unsigned int) (cache.addr + cache.size),
+                         (unsigned int) (cache.addr + cache.size) - (unsigned int) cache.addr,
+                         cache.handle );
+      }
+   }
+
+   /* Unlock the allocated buffer all the way through videocore.
+   */
+   lock_unlock.handle    = chk.handle;
+
+   rc = ioctl( vcsm_handle,
+               VMCS_SM_IOCTL_MEM_UNLOCK,
+               &lock_unlock );
+
+   vcos_log_trace( "[%s]: [%d]: ioctl mem-unlock %d (hdl: %x)",
+                   __func__,
+                   getpid(),
+                   rc,
+                   lock_unlock.handle );
+
+out:
+   return rc;
+}
+
 /* Resizes a block of memory allocated previously by vcsm_alloc.
 **
 ** Returns:        0 on success
@@ -1596,3 +2136,104 @@ int vcsm_clean_invalid( struct vcsm_user_clean_invalid_s *s )
 out:
    return rc;
 }
+
+
+/* Clean and/or invalidate a sub range of the memory associated with
+** this user opaque handle.
+**
+** Returns:        0 on success
+**                 -errno on error.
+**
+** 'cmd' is one of the VCSM_CACHE_OP_xx commands, applied to the
+** given (offset, size) byte range of the block.  The handle must be
+** locked by the caller for the duration of the operation.
+*/
+int vcsm_clean_invalid_range( unsigned int handle, unsigned int cmd,
+                              unsigned int offset, unsigned int size )
+{
+   int rc;
+   struct vmcs_sm_ioctl_clean_invalid cache;
+   struct vmcs_sm_ioctl_chk chk;
+
+   if ( (vcsm_handle == VCSM_INVALID_HANDLE) || (handle == 0) )
+   {
+      vcos_log_error( "[%s]: [%d]: invalid device or invalid handle!",
+                      __func__,
+                      getpid() );
+
+      rc = -EIO;
+      goto out;
+   }
+
+   if ( cmd > VCSM_CACHE_OP_CLEAN_INV )
+   {
+      vcos_log_error( "[%s]: [%d]: invalid command %u (hdl: %x)",
+                      __func__,
+                      getpid(),
+                      cmd,
+                      handle );
+
+      rc = -EINVAL;
+      goto out;
+   }
+
+   memset( &chk, 0, sizeof(chk) );
+   memset( &cache, 0, sizeof(cache) );
+
+   /* Retrieve the mapped address and size of the memory we want to
+   ** maintain.
+   */
+   chk.handle = handle;
+
+   rc = ioctl( vcsm_handle,
+               VMCS_SM_IOCTL_CHK_USR_HDL,
+               &chk );
+
+   vcos_log_trace( "[%s]: [%d]: ioctl chk-usr-hdl %d (hdl: %x, addr: %x, sz: %u) cmd %u range [%u;%u]",
+                   __func__,
+                   getpid(),
+                   rc,
+                   chk.handle,
+                   chk.addr,
+                   chk.size,
+                   cmd,
+                   offset,
+                   offset + size );
+
+   if ( rc < 0 )
+   {
+      goto out;
+   }
+
+   /* The requested range must lie entirely within the block.
+   */
+   if ( (size == 0) || (offset > chk.size) || (size > (chk.size - offset)) )
+   {
+      vcos_log_error( "[%s]: [%d]: invalid range [%u;%u] - size: %u (hdl: %x)",
+                      __func__,
+                      getpid(),
+                      offset,
+                      offset + size,
+                      chk.size,
+                      chk.handle );
+
+      rc = -EINVAL;
+      goto out;
+   }
+
+   cache.s[0].cmd    = cmd;
+   cache.s[0].handle = chk.handle;
+   cache.s[0].addr   = chk.addr + offset;
+   cache.s[0].size   = size;
+
+   rc = ioctl( vcsm_handle,
+               VMCS_SM_IOCTL_MEM_CLEAN_INVALID,
+               &cache );
+
+   /* Done.
+   */
+   goto out;
+
+out:
+   return rc;
+}
@@ -228,6 +228,58 @@ unsigned int vcsm_malloc_cache( unsigned int size, VCSM_CACHE_TYPE_T cache, char
 unsigned int vcsm_malloc_share( unsigned int handle );
 
 
+/* Allocates a block of memory of size 'size' via the vcsm memory
+** allocator, reusing a previously pooled block when one of a suitable
+** size and cache behavior is available.
+**
+** Returns:        0 on error
+**                 a non-zero opaque handle on success.
+**
+** Requested sizes are rounded up to power of two buckets so that
+** blocks freed via vcsm_free_pool can be recycled by later requests
+** of a similar size; the block actually handed out may therefore be
+** larger than requested.  Reuse avoids the videocore round trip and
+** firmware allocator work of a fresh vcsm_malloc, which matters for
+** pipelines which cycle buffer dimensions (eg camera mode switches).
+**
+** The returned handle is used the same way as one returned by
+** vcsm_malloc_cache, but should be released with vcsm_free_pool
+** to return the block to the pool.
+*/
+unsigned int vcsm_malloc_pool( unsigned int size, VCSM_CACHE_TYPE_T cache, char *name );
+
+
+/* Returns a block of memory allocated by vcsm_malloc_pool to the
+** pool rather than freeing it immediately.
+**
+** The handle should be considered invalid upon return from this
+** call.
+**
+** Parked blocks are freed for real once the total memory held by
+** the pool exceeds the pool watermark (oldest first), when
+** vcsm_pool_trim is invoked, or at vcsm_exit time.  A handle which
+** was not allocated through the pool is simply freed.
+*/
+void vcsm_free_pool( unsigned int handle );
+
+
+/* Releases memory parked in the allocation pool until at most
+** 'keep_bytes' worth of blocks remain held (0 releases everything).
+**
+** Applications can call this on transitions after which the pooled
+** blocks are known to be the wrong size, eg a definitive change of
+** capture resolution.
+*/
+void vcsm_pool_trim( unsigned int keep_bytes );
+
+
+/* Sets the maximum amount of memory, in bytes, the allocation pool
+** will keep parked for reuse before freeing blocks for real; the
+** pool is trimmed immediately if it currently holds more.
+*/
+void vcsm_pool_set_watermark( unsigned int bytes );
+
+
 /* Resizes a block of memory allocated previously by vcsm_alloc.
 **
 ** Returns:        0 on success
@@ -439,6 +491,79 @@ struct vcsm_user_clean_invalid_s {
 
 int vcsm_clean_invalid( struct vcsm_user_clean_invalid_s *s );
 
+/* Command values usable with vcsm_clean_invalid and
+** vcsm_clean_invalid_range, matching the list documented above.
+*/
+#define VCSM_CACHE_OP_NOP        0
+#define VCSM_CACHE_OP_INV        1
+#define VCSM_CACHE_OP_CLEAN      2
+#define VCSM_CACHE_OP_CLEAN_INV  3
+
+/* Clean and/or invalidate a sub range of the memory associated with
+** this user opaque handle.
+**
+** The range is expressed as a byte offset from the start of the
+** block plus a byte size, which must lie entirely within the block.
+** The handle must be locked by the caller for the duration of the
+** operation.
+**
+** 'cmd' is one of the VCSM_CACHE_OP_xx values defined above.
+**
+** Returns:        0 on success
+**                 -errno on error.
+**
+** This is the preferred way for an application which only touches a
+** small region of a large host cached block (eg a region of interest
+** within a video frame) to keep the cache coherent, as it avoids the
+** full block maintenance implied by lock/unlock or by a whole block
+** vcsm_clean_invalid.
+*/
+int vcsm_clean_invalid_range( unsigned int handle, unsigned int cmd,
+                              unsigned int offset, unsigned int size );
+
+
+/* Locks the memory associated with this opaque handle, limiting any
+** host cache invalidation to the given sub range of the block.
+**
+** The range is expressed as a byte offset from the start of the
+** block plus a byte size, which must lie entirely within the block.
+**
+** Returns:        NULL on error
+**                 a valid pointer on success.
+**
+** The pointer returned corresponds to the *start* of the block, the
+** same way it would for vcsm_lock, but for a host cached allocation
+** only data within the given range is guaranteed to be coherent with
+** videocore.  The application must confine its accesses to that
+** range, or take care of further cache maintenance itself (see
+** vcsm_clean_invalid_range).
+**
+** On success, the pointer returned is only valid within
+** the lock content (ie until a corresponding vcsm_unlock_xx
+** is invoked).
+*/
+void *vcsm_lock_range( unsigned int handle,
+                       unsigned int offset, unsigned int size );
+
+
+/* Unlocks the memory associated with this user opaque handle,
+** limiting any host cache flush to the given sub range of the block.
+**
+** The range is expressed as a byte offset from the start of the
+** block plus a byte size, which must lie entirely within the block.
+** It should cover all the data the application wrote while holding
+** the lock, typically the same range passed to vcsm_lock_range.
+**
+** Returns:        0 on success
+**                 -errno on error.
+**
+** After unlocking an opaque handle, the user should no longer
+** attempt to reference the mapped addressed once associated
+** with it.
+*/
+int vcsm_unlock_hdl_range( unsigned int handle,
+                           unsigned int offset, unsigned int size );
+
 #ifdef __cplusplus
 }
 #endif
@@ -250,6 +250,7 @@ static int test_parse_cmdline(int argc, const char **argv)
          if (sscanf(argv[i+1], "%u", &camcorder_behaviour.camera_num) == 0) goto invalid_option;
          i++;
          break;
+      case 'l': camcorder_behaviour.latency_test = 1; break;
       default: goto invalid_option;
       }
       continue;
@@ -294,6 +295,8 @@ static int test_parse_cmdline(int argc, const char **argv)
       printf(" -b <n>      : use <n> as the bitrate (bits/s)\n");
       printf(" -a <n>      : Set to focus mode <n> (autofocus will cycle). Use MMAL_PARAM_FOCUS_T values.\n");
       printf(" -n <n>      : Set camera number <n>. Use MMAL_PARAMETER_CAMERA_NUM values.\n");
+      printf(" -l          : measure per-frame camera to render latency (p50/p90/p99),\n");
+      printf("                with drop and late frame counters. Needs -f and no tunneling.\n");
    }
    return 1;
 }
@@ -36,6 +36,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "interface/mmal/mmal.h"
 #include "interface/mmal/mmal_logging.h"
 #include "interface/mmal/util/mmal_util.h"
+#include "interface/mmal/util/mmal_util_params.h"
 #include "interface/mmal/util/mmal_default_components.h"
 
 #define USE_CONTAINER 0
@@ -99,6 +100,132 @@ VCOS_LOG_CAT_T mmalcam_log_category;
 static MMAL_BOOL_T zero_copy;
 static MMAL_BOOL_T tunneling;
 
+/** Number of per-frame latency samples kept for percentile reporting */
+#define LATENCY_MAX_SAMPLES 4096
+
+/** Per-frame latency measurement state.  Camera timestamps are on the
+ * VC system time clock (STC), so a single calibration against the host
+ * clock lets every frame be measured without further round trips. */
+typedef struct {
+   MMAL_PORT_T *render_port;    /**< render input port, identifies buffer returns */
+   int64_t stc_base;            /**< camera STC at calibration time */
+   uint32_t host_base;          /**< host microseconds at calibration time */
+   int64_t frame_interval;      /**< expected pts step in us, 0 if unknown */
+   int64_t last_pts;            /**< previous camera pts seen, for drop detection */
+
+   uint32_t acquire_samples[LATENCY_MAX_SAMPLES]; /**< camera pts to host dequeue */
+   uint32_t render_samples[LATENCY_MAX_SAMPLES];  /**< camera pts to render return */
+   unsigned int acquire_count;
+   unsigned int render_count;
+
+   unsigned int dropped;        /**< frames missing from the camera pts sequence */
+   unsigned int late;           /**< render returns over twice the frame interval */
+} LATENCY_STATS_T;
+
+static LATENCY_STATS_T latency_stats;
+static MMAL_BOOL_T latency_enabled;
+
+/** Estimate of the current camera STC from the calibrated host clock */
+static int64_t latency_now(void)
+{
+   return latency_stats.stc_base +
+      (uint32_t)(vcos_getmicrosecs() - latency_stats.host_base);
+}
+
+/** Calibrate the STC against the host clock.  Returns MMAL_SUCCESS if
+ * the component exposes its system time. */
+static MMAL_STATUS_T latency_calibrate(MMAL_PORT_T *control)
+{
+   uint64_t stc = 0;
+   MMAL_STATUS_T status;
+
+   status = mmal_port_parameter_get_uint64(control, MMAL_PARAMETER_SYSTEM_TIME, &stc);
+   if (status != MMAL_SUCCESS)
+      return status;
+
+   latency_stats.stc_base = (int64_t)stc;
+   latency_stats.host_base = vcos_getmicrosecs();
+   return MMAL_SUCCESS;
+}
+
+/** Record a viewfinder frame being dequeued on the host and account for
+ * any frames missing from the pts sequence. */
+static void latency_record_acquire(MMAL_BUFFER_HEADER_T *buffer)
+{
+   int64_t delta;
+
+   if (buffer->pts == MMAL_TIME_UNKNOWN)
+      return;
+
+   if (latency_stats.last_pts && latency_stats.frame_interval &&
+       buffer->pts - latency_stats.last_pts > latency_stats.frame_interval * 3 / 2)
+      latency_stats.dropped += (buffer->pts - latency_stats.last_pts +
+            latency_stats.frame_interval / 2) / latency_stats.frame_interval - 1;
+   latency_stats.last_pts = buffer->pts;
+
+   delta = latency_now() - buffer->pts;
+   if (delta < 0)
+      delta = 0;
+   if (latency_stats.acquire_count < LATENCY_MAX_SAMPLES)
+      latency_stats.acquire_samples[latency_stats.acquire_count++] = (uint32_t)delta;
+}
+
+/** Record a frame coming back from the render, ie once it has been
+ * displayed and the port has finished with the payload. */
+static void latency_record_render(MMAL_BUFFER_HEADER_T *buffer)
+{
+   int64_t delta;
+
+   if (buffer->pts == MMAL_TIME_UNKNOWN)
+      return;
+
+   delta = latency_now() - buffer->pts;
+   if (delta < 0)
+      delta = 0;
+   if (latency_stats.render_count < LATENCY_MAX_SAMPLES)
+      latency_stats.render_samples[latency_stats.render_count++] = (uint32_t)delta;
+   if (latency_stats.frame_interval && delta > 2 * latency_stats.frame_interval)
+      latency_stats.late++;
+}
+
+static int latency_compare(const void *a, const void *b)
+{
+   uint32_t va = *(const uint32_t *)a, vb = *(const uint32_t *)b;
+   return va < vb ? -1 : va > vb ? 1 : 0;
+}
+
+/** Return the given percentile from an already sorted sample array */
+static uint32_t latency_percentile(const uint32_t *samples, unsigned int count,
+      unsigned int percent)
+{
+   unsigned int index = (count * percent) / 100;
+   return samples[index < count ? index : count - 1];
+}
+
+static void latency_report_stage(const char *stage, uint32_t *samples, unsigned int count)
+{
+   if (!count)
+      return;
+
+   qsort(samples, count, sizeof(*samples), latency_compare);
+   printf("[Latency] %s: %u samples, p50 %ums, p90 %ums, p99 %ums, max %ums\n",
+          stage, count,
+          latency_percentile(samples, count, 50) / 1000,
+          latency_percentile(samples, count, 90) / 1000,
+          latency_percentile(samples, count, 99) / 1000,
+          samples[count - 1] / 1000);
+}
+
+static void latency_report(void)
+{
+   latency_report_stage("camera pts to host dequeue",
+         latency_stats.acquire_samples, latency_stats.acquire_count);
+   latency_report_stage("camera pts to render complete",
+         latency_stats.render_samples, latency_stats.render_count);
+   printf("[Latency] frames dropped: %u, late (>2 frame times): %u\n",
+          latency_stats.dropped, latency_stats.late);
+}
+
 static MMAL_BOOL_T enable_zero_copy(void)
 {
    return zero_copy;
@@ -171,6 +298,10 @@ static void generic_input_port_cb(MMAL_PORT_T *port, MMAL_BUFFER_HEADER_T *buffe
    {
       LOG_INFO("%s callback: event %u not supported", port->name, buffer->cmd);
    }
+   else if (latency_enabled && port == latency_stats.render_port)
+   {
+      latency_record_render(buffer);
+   }
 
    mmal_buffer_header_release(buffer);
    vcos_event_flags_set(&events, MMAL_CAM_BUFFER_READY, VCOS_OR);
@@ -301,6 +432,11 @@ static MMAL_STATUS_T send_buffer_from_queue(MMAL_PORT_T *port, MMAL_QUEUE_T *que
 
    if (buffer)
    {
+      /* Record before sending since the header may be recycled as soon as
+       * the port owns it.  A failed send just means a duplicate sample. */
+      if (latency_enabled && port == latency_stats.render_port)
+         latency_record_acquire(buffer);
+
       status = mmal_port_send_buffer(port, buffer);
 
       if (status != MMAL_SUCCESS)
@@ -438,6 +574,29 @@ int test_mmal_start_camcorder(volatile int *stop, MMALCAM_BEHAVIOUR_T *behaviour
       goto error;
    }
 
+   /* Set up the latency harness.  Needs the camera pts to be on the STC
+    * (which the camera config requests) and non-tunneled buffers so the
+    * host sees every frame. */
+   if (behaviour->latency_test)
+   {
+      memset(&latency_stats, 0, sizeof(latency_stats));
+      latency_stats.render_port = render_port;
+      if (behaviour->frame_rate.num)
+         latency_stats.frame_interval = INT64_C(1000000) *
+            behaviour->frame_rate.den / behaviour->frame_rate.num;
+
+      if (behaviour->tunneling)
+      {
+         LOG_ERROR("latency measurement not available with tunneling");
+      }
+      else if (latency_calibrate(camera->control) != MMAL_SUCCESS)
+      {
+         LOG_ERROR("failed to read camera system time, latency measurement disabled");
+      }
+      else
+         latency_enabled = 1;
+   }
+
    if (behaviour->uri)
    {
       MMAL_PARAMETER_BOOLEAN_T camera_capture =
@@ -689,6 +848,12 @@ int test_mmal_start_camcorder(volatile int *stop, MMALCAM_BEHAVIOUR_T *behaviour
    if (packet_count)
       printf("Packet count: %d\n", packet_count);
 
+   if (latency_enabled)
+   {
+      latency_report();
+      latency_enabled = 0;
+   }
+
    if (behaviour->init_result != MMALCAM_INIT_SUCCESS)
       vcos_semaphore_post(&behaviour->init_sem);
 
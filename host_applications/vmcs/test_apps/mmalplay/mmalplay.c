@@ -50,6 +50,7 @@ typedef struct {
    MMALPLAY_T *ctx;
    MMALPLAY_OPTIONS_T options;
    MMAL_STATUS_T status;
+   MMALPLAY_STATS_T stats;
    char name[sizeof(THREAD_PREFIX) + URI_FOR_THREAD_NAME_MAX];
 } FILE_PLAY_INFO_T;
 
@@ -58,6 +59,7 @@ static FILE_PLAY_INFO_T play_info[FILE_PLAY_MAX];
 static int play_info_count;
 static uint32_t sleepy_time;
 static unsigned int verbosity;
+static unsigned int instances = 1;
 
 /* Utility functions used by test program */
 void test_signal_handler(int signum);
@@ -133,6 +135,32 @@ int main(int argc, const char **argv)
 
    LOG_TRACE("Completed");
 
+   /* Consolidated per-pipeline report, mainly of interest when scaling
+    * up the number of instances with -N */
+   {
+      unsigned int total_frames = 0;
+      double total_fps = 0.0;
+
+      printf("---- playback summary ----\n");
+      for (i = 0; i < play_info_count; i++)
+      {
+         MMALPLAY_STATS_T *stats = &play_info[i].stats;
+         double fps = stats->playback_us ?
+            stats->decoded_frames * 1000000.0 / stats->playback_us : 0.0;
+
+         printf("[%2i] %s: %u frames in %.2fs (%.2ffps), buffers %u out / %u recycled%s\n",
+                i, play_info[i].uri, stats->decoded_frames,
+                stats->playback_us / 1000000.0, fps,
+                stats->buffers_sent, stats->buffers_returned,
+                play_info[i].status ? " FAILED" : "");
+
+         total_frames += stats->decoded_frames;
+         total_fps += fps;
+      }
+      printf("total: %i pipeline(s), %u frames, %.2ffps aggregate\n",
+             play_info_count, total_frames, total_fps);
+   }
+
    /* Check for errors */
    for (i = 0; i < play_info_count; i++)
    {
@@ -174,6 +202,8 @@ static void *mmal_playback(void *id)
    if (!opts.disable_playback)
       status = mmalplay_play(ctx);
 
+   mmalplay_get_stats(ctx, &play_info->stats);
+
    if (unclean_exit)
       goto end;
 
@@ -334,6 +364,11 @@ static int test_parse_cmdline(int argc, const char **argv)
          if (++i >= argc || sscanf(argv[i], "%u", &sleepy_time) != 1)
             goto usage;    /* Time missing / invalid */
          break;
+      case 'N':
+         /* coverity[secure_coding] Only reading integers, so can't overflow */
+         if (++i >= argc || sscanf(argv[i], "%u", &instances) != 1 || !instances)
+            goto usage;    /* Count missing / invalid */
+         break;
       case 'x':
          /* coverity[secure_coding] Only reading integers, so can't overflow */
          if (++i >= argc || sscanf(argv[i], "%u", &value_u1) != 1)
@@ -452,6 +487,26 @@ static int test_parse_cmdline(int argc, const char **argv)
      goto usage;
    }
 
+   /* Replicate each URI across the requested number of pipelines */
+   if (instances > 1)
+   {
+      int uris = play_info_count;
+      unsigned int copy;
+
+      for (i = 0; i < uris; i++)
+      {
+         for (copy = 1; copy < instances; copy++)
+         {
+            if (play_info_count >= FILE_PLAY_MAX)
+            {
+               fprintf(stderr, "Too many URIs!\n");
+               goto usage;
+            }
+            play_info[play_info_count++] = play_info[i];
+         }
+      }
+   }
+
    return 0;
 
 invalid_option:
@@ -484,6 +539,7 @@ usage:
       fprintf(stderr, " -na   : disable audio\n");
       fprintf(stderr, " -es   : enable scheduling\n");
       fprintf(stderr, " -t <n>: play URI(s) for <n> seconds then stop\n");
+      fprintf(stderr, " -N <n>: play <n> instances of each URI (scaling soak test)\n");
       fprintf(stderr, " -f <fourcc:widthxheight> : set format used on output of decoder\n");
       fprintf(stderr, " -fr <fourcc:widthxheight> : set format used for rendering\n");
       fprintf(stderr, " -c    : do full copy of data transferred to videocore\n");
@@ -109,6 +109,23 @@ MMAL_STATUS_T mmalplay_play(MMALPLAY_T *ctx);
  */
 void mmalplay_stop(MMALPLAY_T *ctx);
 
+/** Playback statistics for an instance of mmalplay.
+ */
+typedef struct {
+   unsigned int decoded_frames;    /**< frames seen on the video output port */
+   int64_t playback_us;            /**< duration of the playback phase */
+   unsigned int buffers_sent;      /**< data buffers forwarded between components */
+   unsigned int buffers_returned;  /**< empty buffers recycled to output ports */
+} MMALPLAY_STATS_T;
+
+/** Retrieve playback statistics from an instance of mmalplay.
+ * Only valid once mmalplay_play has returned.
+ *
+ * @param MMALPLAY instance id
+ * @param stats filled in with the statistics for the instance
+ */
+void mmalplay_get_stats(MMALPLAY_T *ctx, MMALPLAY_STATS_T *stats);
+
 /** Destroys an instance of mmalplay.
  *
  * @param MMALPLAY instance id
@@ -93,6 +93,8 @@ struct MMALPLAY_T {
    /* Used for debug / statistics */
    int64_t time_playback;
    unsigned int decoded_frames;
+   unsigned int buffers_sent;
+   unsigned int buffers_returned;
 };
 
 typedef struct MMALPLAY_CONNECTIONS_T {
@@ -490,6 +492,7 @@ MMAL_STATUS_T mmalplay_play(MMALPLAY_T *ctx)
                mmal_queue_put_back(connection->queue, buffer);
                goto error;
             }
+            ctx->buffers_sent++;
             buffer = mmal_queue_get(connection->queue);
          }
 
@@ -504,6 +507,7 @@ MMAL_STATUS_T mmalplay_play(MMALPLAY_T *ctx)
                mmal_queue_put_back(connection->pool->queue, buffer);
                goto error;
             }
+            ctx->buffers_returned++;
             buffer = mmal_queue_get(connection->pool->queue);
          }
       }
@@ -528,6 +532,18 @@ void mmalplay_stop(MMALPLAY_T *ctx)
    vcos_semaphore_post(&ctx->event);
 }
 
+/** Retrieve playback statistics from an instance of mmalplay.
+ * Note: this is test code. Do not use it in your app. It *will* change or even be removed without notice.
+ */
+void mmalplay_get_stats(MMALPLAY_T *ctx, MMALPLAY_STATS_T *stats)
+{
+   memset(stats, 0, sizeof(*stats));
+   stats->decoded_frames = ctx->decoded_frames;
+   stats->playback_us = ctx->time_playback;
+   stats->buffers_sent = ctx->buffers_sent;
+   stats->buffers_returned = ctx->buffers_returned;
+}
+
 /** Destroys an instance of mmalplay.
  * Note: this is test code. Do not use it in your app. It *will* change or even be removed without notice.
  */
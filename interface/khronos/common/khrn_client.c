@@ -253,6 +253,7 @@ void client_process_state_term(CLIENT_PROCESS_STATE_T *process)
 #endif
 
 #if EGL_BRCM_global_image && EGL_KHR_image
+      khrn_global_image_map_cache_invalidate();
       khrn_global_image_map_term(&process->global_image_egl_images);
 #endif
 
@@ -290,18 +291,35 @@ void client_thread_state_init(CLIENT_THREAD_STATE_T *state)
    state->openvg.read = 0;
 
    state->high_priority = false;
+   state->channel_pinned = false;
 
+   /*
+      start with a single message-sized chunk; the rpc layer grows the
+      buffer on demand once the per-process options have been parsed
+   */
+   state->merge_buffer = khrn_platform_malloc(MERGE_BUFFER_SIZE, "CLIENT_THREAD_STATE_T.merge_buffer");
+   vcos_assert(state->merge_buffer);
+   state->merge_capacity = MERGE_BUFFER_SIZE;
    state->merge_pos = 0;
    state->merge_end = 0;
+   state->merge_chunks = 0;
+   state->merge_chunk_start[0] = 0;
 
 	state->glgeterror_hack = 0;
 	state->async_error_notification = false;
+
+   platform_init_rpc(state);
 }
 
 void client_thread_state_term(CLIENT_THREAD_STATE_T *state)
 {
    // TODO: termination
    platform_term_rpc( state );
+
+   if (state->merge_buffer) {
+      khrn_platform_free(state->merge_buffer);
+      state->merge_buffer = NULL;
+   }
 }
 
 EGL_CONTEXT_T *client_egl_get_context(CLIENT_THREAD_STATE_T *thread, CLIENT_PROCESS_STATE_T *process, EGLContext ctx)
@@ -64,7 +64,18 @@ extern void client_try_unload_server(CLIENT_PROCESS_STATE_T *process);
    - RPC merge buffer
 */
 
+/*
+   the merge buffer is transmitted as a series of messages of at most
+   MERGE_BUFFER_SIZE bytes each (a message must fit in a VCHIQ slot). how
+   many such message-sized chunks we accumulate before flushing is
+   configurable per-process (V3D_MERGE_BUFFER_CHUNKS, up to
+   MERGE_BUFFER_MAX_CHUNKS) -- everything buffered since the last flush
+   point (reply, bulk transfer or frame boundary) then goes out in one
+   locked span
+*/
+
 #define MERGE_BUFFER_SIZE  4080
+#define MERGE_BUFFER_MAX_CHUNKS  16
 
 typedef struct {
    EGL_CONTEXT_T *context;
@@ -115,11 +126,15 @@ struct CLIENT_THREAD_STATE {
    */
 
    bool high_priority;
+   bool channel_pinned; /* permanently assigned to the high priority service */
 
-   uint8_t merge_buffer[MERGE_BUFFER_SIZE];
+   uint8_t *merge_buffer;
 
+   uint32_t merge_capacity;
    uint32_t merge_pos;
    uint32_t merge_end;
+   uint32_t merge_chunk_start[MERGE_BUFFER_MAX_CHUNKS];
+   uint32_t merge_chunks; /* index of the chunk currently being filled */
 
 	/* Try to reduce impact of repeated consecutive glGetError() calls */
 	int32_t glgeterror_hack;
@@ -121,6 +121,11 @@ static void heap_free(KHRN_CACHE_T *cache, int block)
    }
 }
 
+static int entry_size(int len)
+{
+   return _max(_msb(len + sizeof(CACHE_ENTRY_T) - 1) + 2 - CACHE_LOG2_BLOCK_SIZE, 1);
+}
+
 static uint32_t hash(const void *data, int len, int sig)
 {
    int hash;
@@ -149,6 +154,17 @@ int khrn_cache_init(KHRN_CACHE_T *cache)
    cache->end.prev = &cache->start;
    cache->end.next = NULL;
 
+   cache->large_start.prev = NULL;
+   cache->large_start.next = &cache->large_end;
+   cache->large_end.prev = &cache->large_start;
+   cache->large_end.next = NULL;
+
+   cache->generation = 0;
+
+   cache->hits = 0;
+   cache->misses = 0;
+   cache->evictions = 0;
+
    return khrn_pointer_map_init(&cache->map, 64);
 }
 
@@ -287,6 +303,14 @@ static int grow(CLIENT_THREAD_STATE_T *thread, KHRN_CACHE_T *cache)
       cache->end.prev->next = &cache->end;
       if (cache->end.prev != &cache->start)
          cache->end.prev = (CACHE_LINK_T *)relocate(cache->end.prev, user);
+
+      cache->large_start.next->prev = &cache->large_start;
+      if (cache->large_start.next != &cache->large_end)
+         cache->large_start.next = (CACHE_LINK_T *)relocate(cache->large_start.next, user);
+
+      cache->large_end.prev->next = &cache->large_end;
+      if (cache->large_end.prev != &cache->large_start)
+         cache->large_end.prev = (CACHE_LINK_T *)relocate(cache->large_end.prev, user);
    }
 
    /*
@@ -331,26 +355,58 @@ int khrn_cache_lookup(CLIENT_THREAD_STATE_T *thread, KHRN_CACHE_T *cache, const
    }
 #endif
 
-   if (entry && entry->len >= len && !memcmp(entry->data, data, len)) {
+   if (entry && entry->generation == cache->generation && entry->len >= len && !memcmp(entry->data, data, len)) {
       /*
-         move link to end of discard queue
+         move link to end of its discard queue
       */
 
+      CACHE_LINK_T *queue_end = (entry_size(entry->len) <= CACHE_SMALL_SIZE_MAX) ? &cache->end : &cache->large_end;
+
+      cache->hits++;
+
       link_remove(&entry->link);
-      link_insert(&entry->link, cache->end.prev, &cache->end);
+      link_insert(&entry->link, queue_end->prev, queue_end);
    } else {
-      int size = _max(_msb(len + sizeof(CACHE_ENTRY_T) - 1) + 2 - CACHE_LOG2_BLOCK_SIZE, 1);
+      int size = entry_size(len);
       int block;
 
+      CACHE_LINK_T *queue_start, *queue_end;
+      CACHE_LINK_T *other_start, *other_end;
       CACHE_LINK_T *link;
 
+      cache->misses++;
+
       if (entry)
          discard(thread, cache, entry);
 
       while (!heap_avail(cache, size) && grow(thread, cache));
 
-      for (link = cache->start.next; link != &cache->end && !heap_avail(cache, size); link = link->next)
+      /*
+         evict from the matching size tier first; blocks freed from the
+         other tier are unlikely to coalesce into one big enough
+      */
+
+      if (size <= CACHE_SMALL_SIZE_MAX) {
+         queue_start = &cache->start;
+         queue_end = &cache->end;
+         other_start = &cache->large_start;
+         other_end = &cache->large_end;
+      } else {
+         queue_start = &cache->large_start;
+         queue_end = &cache->large_end;
+         other_start = &cache->start;
+         other_end = &cache->end;
+      }
+
+      for (link = queue_start->next; link != queue_end && !heap_avail(cache, size); link = link->next) {
          discard(thread, cache, (CACHE_ENTRY_T *)link);
+         cache->evictions++;
+      }
+
+      for (link = other_start->next; link != other_end && !heap_avail(cache, size); link = link->next) {
+         discard(thread, cache, (CACHE_ENTRY_T *)link);
+         cache->evictions++;
+      }
 
       if (!heap_avail(cache, size))
          return -1;
@@ -360,6 +416,7 @@ int khrn_cache_lookup(CLIENT_THREAD_STATE_T *thread, KHRN_CACHE_T *cache, const
       entry = (CACHE_ENTRY_T *)(cache->data + (block << CACHE_LOG2_BLOCK_SIZE));
       entry->len = len;
       entry->key = key;
+      entry->generation = cache->generation;
       platform_memcpy(entry->data, data, len);
 
       if (!khrn_pointer_map_insert(&cache->map, key, entry)) {
@@ -367,7 +424,7 @@ int khrn_cache_lookup(CLIENT_THREAD_STATE_T *thread, KHRN_CACHE_T *cache, const
          return -1;
       }
 
-      link_insert(&entry->link, cache->end.prev, &cache->end);
+      link_insert(&entry->link, queue_end->prev, queue_end);
 
       send_create(thread, (int)((uint8_t *)entry - cache->data));
       send_data(thread, (int)(entry->data - cache->data), data, len);
@@ -380,3 +437,23 @@ int khrn_cache_get_entries(KHRN_CACHE_T *cache)
 {
    return cache->map.entries;
 }
+
+void khrn_cache_invalidate(KHRN_CACHE_T *cache)
+{
+   /*
+      entries from older generations miss on their next lookup and are then
+      reclaimed through the normal discard path, so no scan is needed here
+   */
+
+   cache->generation++;
+}
+
+void khrn_cache_get_stats(KHRN_CACHE_T *cache, uint32_t *hits, uint32_t *misses, uint32_t *evictions)
+{
+   if (hits)
+      *hits = cache->hits;
+   if (misses)
+      *misses = cache->misses;
+   if (evictions)
+      *evictions = cache->evictions;
+}
@@ -43,12 +43,16 @@ typedef struct {
    int len;
    int key;
 
+   //entries from older generations miss on their next lookup and are
+   //reclaimed through the normal discard path
+   uint32_t generation;
+
 #ifdef WORKAROUND_HW2551
    uint8_t pad[16];
 #endif
 
    //on the server side
-   //we store a KHRN_INTERLOCK_T in the 
+   //we store a KHRN_INTERLOCK_T in the
    //same space as this struct
    uint8_t pad_for_interlock[24];
 
@@ -62,8 +66,19 @@ typedef struct {
    int client_depth;
    int server_depth;
 
+   //separate discard queues for small (index-array sized) and large
+   //(vertex-array sized) entries, so that allocating a large block does
+   //not flush lots of small hot entries and vice versa
    CACHE_LINK_T start;
    CACHE_LINK_T end;
+   CACHE_LINK_T large_start;
+   CACHE_LINK_T large_end;
+
+   uint32_t generation;
+
+   uint32_t hits;
+   uint32_t misses;
+   uint32_t evictions;
 
    KHRN_POINTER_MAP_T map;
 } KHRN_CACHE_T;
@@ -71,6 +86,9 @@ typedef struct {
 #define CACHE_LOG2_BLOCK_SIZE    6
 #define CACHE_MAX_DEPTH          16
 
+//allocation size tiers up to this (256 bytes) use the small discard queue
+#define CACHE_SMALL_SIZE_MAX     3
+
 #define CACHE_SIG_ATTRIB_0    0
 #define CACHE_SIG_ATTRIB_1    1
 #define CACHE_SIG_ATTRIB_2    2
@@ -88,5 +106,10 @@ extern void khrn_cache_term(KHRN_CACHE_T *cache);
 extern int khrn_cache_lookup(CLIENT_THREAD_STATE_T *thread, KHRN_CACHE_T *cache, const void *data, int len, int sig);
 extern int khrn_cache_get_entries(KHRN_CACHE_T *cache);
 
+//logically invalidate every entry in O(1) by bumping the generation
+extern void khrn_cache_invalidate(KHRN_CACHE_T *cache);
+
+extern void khrn_cache_get_stats(KHRN_CACHE_T *cache, uint32_t *hits, uint32_t *misses, uint32_t *evictions);
+
 #endif
 
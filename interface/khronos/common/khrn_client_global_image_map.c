@@ -26,6 +26,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
 #include "interface/khronos/common/khrn_int_common.h"
+#include "interface/khronos/common/khrn_client.h"
 #include "interface/khronos/common/khrn_client_platform.h"
 #include "interface/khronos/include/EGL/egl.h"
 #include "interface/khronos/include/EGL/eglext.h"
@@ -52,4 +53,64 @@ static INLINE void release_value(uint64_t value)
 #define CLIENT_GLOBAL_IMAGE_MAP_C
 #include "interface/khronos/common/khrn_client_global_image_map.h"
 
+/*
+   one-entry cache of the last successful lookup, readable without taking the
+   client lock. every EGLImage use goes through a lookup, and a video wall
+   doing thousands of lookups per second mostly hits the same image again, so
+   the common case avoids serializing on the lock entirely.
+
+   all writes to the cached pair happen under the client lock; the sequence
+   count is incremented before and after each update (so it is odd while an
+   update is in progress) and lock-free readers retry into the locked path if
+   it changed under them
+*/
+
+static volatile uint32_t cache_sequence;
+static KHRN_GLOBAL_IMAGE_MAP_T *cache_map;
+static uint32_t cache_key;
+static uint64_t cache_value;
+
+uint64_t khrn_global_image_map_lookup_fast(KHRN_GLOBAL_IMAGE_MAP_T *map, uint32_t key)
+{
+   uint32_t sequence = cache_sequence;
+   uint64_t value;
+
+   if (!(sequence & 1)) {
+      __sync_synchronize();
+      if ((cache_map == map) && (cache_key == key)) {
+         value = cache_value;
+         __sync_synchronize();
+         if (cache_sequence == sequence) {
+            return value;
+         }
+      }
+   }
+
+   CLIENT_LOCK();
+   value = khrn_global_image_map_lookup(map, key);
+   if (value) {
+      ++cache_sequence;
+      __sync_synchronize();
+      cache_map = map;
+      cache_key = key;
+      cache_value = value;
+      __sync_synchronize();
+      ++cache_sequence;
+   }
+   CLIENT_UNLOCK();
+
+   return value;
+}
+
+void khrn_global_image_map_cache_invalidate(void)
+{
+   if (cache_map) {
+      ++cache_sequence;
+      __sync_synchronize();
+      cache_map = NULL;
+      __sync_synchronize();
+      ++cache_sequence;
+   }
+}
+
 #endif
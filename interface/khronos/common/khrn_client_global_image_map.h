@@ -44,4 +44,14 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #undef KHRN_GENERIC_MAP
 #undef khrn_generic_map
 
+/*
+   lookup with a lock-free fast path for the last image looked up; falls back
+   to a full lookup under the client lock. writers already hold the client
+   lock and must call khrn_global_image_map_cache_invalidate() whenever they
+   change a mapping or destroy a map
+*/
+
+extern uint64_t khrn_global_image_map_lookup_fast(KHRN_GLOBAL_IMAGE_MAP_T *map, uint32_t key);
+extern void khrn_global_image_map_cache_invalidate(void);
+
 #endif
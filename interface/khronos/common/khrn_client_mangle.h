@@ -319,6 +319,8 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #define glPointSizePointerOES mangled_glPointSizePointerOES
 #define glDiscardFramebufferEXT mangled_glDiscardFramebufferEXT
+#define glReadPixelsAsyncBRCM mangled_glReadPixelsAsyncBRCM
+#define glReadPixelsAwaitBRCM mangled_glReadPixelsAwaitBRCM
 #define glInsertEventMarkerEXT mangled_glInsertEventMarkerEXT
 #define glPushGroupMarkerEXT mangled_glPushGroupMarkerEXT
 #define glPopGroupMarkerEXT mangled_glPopGroupMarkerEXT
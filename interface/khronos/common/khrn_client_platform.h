@@ -254,6 +254,15 @@ extern bool platform_get_pixmap_info(EGLNativePixmapType pixmap, KHRN_IMAGE_WRAP
 */
 extern void platform_get_pixmap_server_handle(EGLNativePixmapType pixmap, uint32_t *handle);
 
+/*
+   uint32_t platform_get_vcsm_vc_handle(uint32_t vcsm_handle)
+
+   Translate a vcsm (VideoCore shared memory) user handle into the
+   VideoCore-side handle an image can be created from. Returns 0 if the
+   handle is invalid or the platform has no vcsm support.
+*/
+extern uint32_t platform_get_vcsm_vc_handle(uint32_t vcsm_handle);
+
 extern void platform_wait_EGL(uint32_t handle);
 extern void platform_retrieve_pixmap_completed(EGLNativePixmapType pixmap);
 extern void platform_send_pixmap_completed(EGLNativePixmapType pixmap);
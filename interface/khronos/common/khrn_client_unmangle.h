@@ -319,6 +319,8 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #undef glPointSizePointerOES
 #undef glDiscardFramebufferEXT
+#undef glReadPixelsAsyncBRCM
+#undef glReadPixelsAwaitBRCM
 #undef glInsertEventMarkerEXT
 #undef glPushGroupMarkerEXT
 #undef glPopGroupMarkerEXT
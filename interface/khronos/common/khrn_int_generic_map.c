@@ -273,13 +273,12 @@ bool khrn_generic_map(insert)(KHRN_GENERIC_MAP(T) *map, KHRN_GENERIC_MAP_KEY_T k
 
 bool khrn_generic_map(delete)(KHRN_GENERIC_MAP(T) *map, KHRN_GENERIC_MAP_KEY_T key)
 {
-   KHRN_GENERIC_MAP(ENTRY_T) *entry = get_entry(
 #ifdef KHRN_GENERIC_MAP_RELOCATABLE
-      (KHRN_GENERIC_MAP(ENTRY_T) *)mem_lock(map->storage),
+   KHRN_GENERIC_MAP(ENTRY_T) *base = (KHRN_GENERIC_MAP(ENTRY_T) *)mem_lock(map->storage);
 #else
-      map->storage,
+   KHRN_GENERIC_MAP(ENTRY_T) *base = map->storage;
 #endif
-      map->capacity, key);
+   KHRN_GENERIC_MAP(ENTRY_T) *entry = get_entry(base, map->capacity, key);
    if (entry) {
 #ifdef KHRN_GENERIC_MAP_RELEASE_VALUE
       KHRN_GENERIC_MAP_RELEASE_VALUE(entry->value);
@@ -288,6 +287,29 @@ bool khrn_generic_map(delete)(KHRN_GENERIC_MAP(T) *map, KHRN_GENERIC_MAP_KEY_T k
       ++map->deletes;
       vcos_assert(map->entries > 0);
       --map->entries;
+
+      /*
+         if the slot after the deleted entry is unused, the probe chain ends
+         there, so this tombstone (and any run of tombstones immediately before
+         it) can be reclaimed as unused slots. this keeps probe chains short and
+         avoids most tombstone-triggered rehashes when elements are inserted and
+         deleted repeatedly. entries never move, so it is safe to do this from
+         an iterate callback
+      */
+
+      {
+         uint32_t capacity = map->capacity;
+         uint32_t h = (uint32_t)(entry - base);
+         uint32_t next = (h + 1 == capacity) ? 0 : (h + 1);
+         if (KHRN_GENERIC_MAP_CMP_VALUE(base[next].value, KHRN_GENERIC_MAP_VALUE_NONE)) {
+            while (KHRN_GENERIC_MAP_CMP_VALUE(base[h].value, KHRN_GENERIC_MAP_VALUE_DELETED)) {
+               base[h].value = KHRN_GENERIC_MAP_VALUE_NONE;
+               vcos_assert(map->deletes > 0);
+               --map->deletes;
+               h = (h == 0) ? (capacity - 1) : (h - 1);
+            }
+         }
+      }
    }
 #ifdef KHRN_GENERIC_MAP_RELOCATABLE
    mem_unlock(map->storage);
@@ -66,6 +66,11 @@ void khrn_init_options(void)
    /* Default values are all 0 */
    memset(&khrn_options, 0, sizeof(KHRN_OPTIONS_T));
 
+   /* except auto-tuning, which is what makes one binary behave well on
+      every board -- set V3D_TRANSPORT_AUTOTUNE=0 (or an explicit
+      V3D_MERGE_BUFFER_CHUNKS) to pin the transport settings instead */
+   khrn_options.transport_autotune = true;
+
 #ifndef DISABLE_OPTION_PARSING
    /* Now read the options */
    khrn_options.gl_error_assist        = read_bool_option(  "V3D_GL_ERROR_ASSIST",        khrn_options.gl_error_assist);
@@ -77,6 +82,10 @@ void khrn_init_options(void)
 
    khrn_options.bin_block_size         = read_uint32_option("V3D_BIN_BLOCK_SIZE",         khrn_options.bin_block_size);
    khrn_options.max_bin_blocks         = read_uint32_option("V3D_MAX_BIN_BLOCKS",         khrn_options.max_bin_blocks);
+
+   khrn_options.merge_buffer_chunks    = read_uint32_option("V3D_MERGE_BUFFER_CHUNKS",    khrn_options.merge_buffer_chunks);
+   khrn_options.dual_channel           = read_bool_option(  "V3D_DUAL_CHANNEL",           khrn_options.dual_channel);
+   khrn_options.transport_autotune     = read_bool_option(  "V3D_TRANSPORT_AUTOTUNE",     khrn_options.transport_autotune);
 #endif
 }
 
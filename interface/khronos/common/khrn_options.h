@@ -40,6 +40,9 @@ typedef struct {
    bool     force_dither_off;          /* Ensure dithering is always off */
    uint32_t bin_block_size;            /* Set the size of binning memory blocks */
    uint32_t max_bin_blocks;            /* Set the maximum number of binning block in use */
+   uint32_t merge_buffer_chunks;       /* Number of message-sized RPC merge buffer chunks to fill before flushing */
+   bool     dual_channel;              /* Pin second and later threads to the high priority service */
+   bool     transport_autotune;        /* Derive the merge depth from measured round-trip latency at init */
 
 } KHRN_OPTIONS_T;
 
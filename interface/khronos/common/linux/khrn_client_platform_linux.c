@@ -30,6 +30,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "interface/khronos/common/khrn_client.h"
 #include "interface/khronos/common/khrn_client_rpc.h"
 #include "interface/khronos/common/khrn_int_ids.h"
+#include "interface/khronos/common/khrn_options.h"
 #include <stdio.h>
 #include <string.h>
 #include <assert.h>
@@ -300,6 +301,31 @@ void platform_get_pixmap_server_handle(EGLNativePixmapType pixmap, uint32_t *han
    handle[1] = ((uint32_t *)pixmap)[1];
 }
 
+#ifndef KHRN_NO_VCSM
+#include "host_applications/linux/libs/sm/user-vcsm.h"
+
+uint32_t platform_get_vcsm_vc_handle(uint32_t vcsm_handle)
+{
+   /* vcsm_init is refcounted and cheap once the device is open */
+   static int vcsm_inited;
+
+   if (!vcsm_handle)
+      return 0;
+   if (!vcsm_inited) {
+      if (vcsm_init() != 0)
+         return 0;
+      vcsm_inited = 1;
+   }
+   return vcsm_vc_hdl_from_hdl(vcsm_handle);
+}
+#else
+uint32_t platform_get_vcsm_vc_handle(uint32_t vcsm_handle)
+{
+   UNUSED(vcsm_handle);
+   return 0;
+}
+#endif
+
 bool platform_match_pixmap_api_support(EGLNativePixmapType pixmap, uint32_t api_support)
 {
    return
@@ -356,7 +382,21 @@ void platform_client_release(void)
 
 void platform_init_rpc(struct CLIENT_THREAD_STATE *state)
 {
-   assert(1);
+   static volatile int threads_attached = 0;
+   int first = (__sync_fetch_and_add(&threads_attached, 1) == 0);
+
+   /*
+      With dual channel dispatch enabled, the second and subsequent threads
+      are pinned to the high priority service so that independent contexts
+      issue RPCs concurrently instead of contending for one channel. The
+      first thread attaches before the options have been parsed and always
+      keeps the normal service.
+   */
+   if (khrn_options.dual_channel && !first)
+   {
+      state->high_priority = true;
+      state->channel_pinned = true;
+   }
 }
 
 void platform_term_rpc(struct CLIENT_THREAD_STATE *state)
@@ -32,6 +32,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "interface/khronos/common/khrn_client.h"
 #include "interface/khronos/common/khrn_client_rpc.h"
+#include "interface/khronos/common/khrn_options.h"
 
 
 #include <string.h>
@@ -39,8 +40,18 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 extern VCOS_LOG_CAT_T khrn_client_log;
 
-static void *workspace; /* for scatter/gather bulks */
-static PLATFORM_MUTEX_T mutex;
+/*
+   the normal (khrn) and high priority (khhn) services are independent
+   channels: each gets its own lock, bulk event and scatter/gather workspace,
+   indexed by get_channel(), so threads pinned to different services can
+   issue rpcs concurrently
+*/
+
+#define CHANNEL_KHRN 0
+#define CHANNEL_KHHN 1
+
+static void *workspace[2]; /* for scatter/gather bulks */
+static PLATFORM_MUTEX_T mutex[2];
 
 #define FOURCC_KHAN VCHIQ_MAKE_FOURCC('K', 'H', 'A', 'N')
 #define FOURCC_KHRN VCHIQ_MAKE_FOURCC('K', 'H', 'R', 'N')
@@ -55,7 +66,17 @@ static VCHIQ_SERVICE_HANDLE_T vchiq_khhn_service;
 static VCHIU_QUEUE_T khrn_queue;
 static VCHIU_QUEUE_T khhn_queue;
 
-static VCOS_EVENT_T bulk_event;
+static VCOS_EVENT_T bulk_event[2];
+
+/*
+   the vchiq connect and service opens are brought up on a background thread
+   so they overlap the rest of the client side initialisation; the first rpc
+   joins the thread, see vc_vchi_khronos_init() and khrn_wait_connected()
+*/
+static VCOS_THREAD_T khrn_connect_thread;
+static PLATFORM_MUTEX_T khrn_connect_mutex;
+static volatile int khrn_connected;
+static int khrn_connect_async;
 
 VCHIQ_STATUS_T khrn_callback(VCHIQ_REASON_T reason, VCHIQ_HEADER_T *header,
                   VCHIQ_SERVICE_HANDLE_T handle, void *bulk_userdata)
@@ -66,7 +87,7 @@ VCHIQ_STATUS_T khrn_callback(VCHIQ_REASON_T reason, VCHIQ_HEADER_T *header,
       break;
    case VCHIQ_BULK_TRANSMIT_DONE:
    case VCHIQ_BULK_RECEIVE_DONE:
-      vcos_event_signal(&bulk_event);
+      vcos_event_signal(&bulk_event[CHANNEL_KHRN]);
       break;
    case VCHIQ_SERVICE_OPENED:
    case VCHIQ_SERVICE_CLOSED:
@@ -87,7 +108,7 @@ VCHIQ_STATUS_T khhn_callback(VCHIQ_REASON_T reason, VCHIQ_HEADER_T *header,
       break;
    case VCHIQ_BULK_TRANSMIT_DONE:
    case VCHIQ_BULK_RECEIVE_DONE:
-      vcos_event_signal(&bulk_event);
+      vcos_event_signal(&bulk_event[CHANNEL_KHHN]);
       break;
    case VCHIQ_SERVICE_OPENED:
    case VCHIQ_SERVICE_CLOSED:
@@ -166,11 +187,13 @@ VCHIQ_STATUS_T khan_callback(VCHIQ_REASON_T reason, VCHIQ_HEADER_T *header,
    return VCHIQ_SUCCESS;
 }
 
-void vc_vchi_khronos_init()
+static void khrn_vchiq_connect(void)
 {
-   VCOS_STATUS_T status = vcos_event_create(&bulk_event, NULL);
+   VCOS_STATUS_T status = vcos_event_create(&bulk_event[CHANNEL_KHRN], NULL);
    UNUSED_NDEBUG(status);
    vcos_assert(status == VCOS_SUCCESS);
+   status = vcos_event_create(&bulk_event[CHANNEL_KHHN], NULL);
+   vcos_assert(status == VCOS_SUCCESS);
    
    if (vchiq_initialise(&khrn_vchiq_instance) != VCHIQ_SUCCESS)
    {
@@ -228,37 +251,189 @@ void vc_vchi_khronos_init()
 //   vcos_assert(success);
 }
 
+static void *khrn_connect_thread_func(void *param)
+{
+   vcos_unused(param);
+   khrn_vchiq_connect();
+   return NULL;
+}
+
+void vc_vchi_khronos_init()
+{
+   /*
+      start the vchiq bring-up in the background so the connect and the
+      serial service opens overlap the rest of process initialisation; if
+      that can't be done, just connect here as before
+   */
+   if (platform_mutex_create(&khrn_connect_mutex) == KHR_SUCCESS)
+   {
+      if (vcos_thread_create(&khrn_connect_thread, "khrn connect", NULL,
+             khrn_connect_thread_func, NULL) == VCOS_SUCCESS)
+      {
+         khrn_connect_async = true;
+         return;
+      }
+      platform_mutex_destroy(&khrn_connect_mutex);
+   }
+
+   khrn_vchiq_connect();
+   khrn_connected = true;
+}
+
+/*
+   block until the background bring-up has finished. cheap once connected,
+   so this is called on every message send / receive
+*/
+static void khrn_wait_connected(void)
+{
+   if (khrn_connected)
+      return;
+
+   platform_mutex_acquire(&khrn_connect_mutex);
+   if (!khrn_connected)
+   {
+      vcos_thread_join(&khrn_connect_thread, NULL);
+      khrn_connected = true;
+   }
+   platform_mutex_release(&khrn_connect_mutex);
+}
+
 bool khclient_rpc_init(void)
 {
-   workspace = NULL;
-   return platform_mutex_create(&mutex) == KHR_SUCCESS;
+   workspace[CHANNEL_KHRN] = NULL;
+   workspace[CHANNEL_KHHN] = NULL;
+   if (platform_mutex_create(&mutex[CHANNEL_KHRN]) != KHR_SUCCESS) {
+      return false;
+   }
+   if (platform_mutex_create(&mutex[CHANNEL_KHHN]) != KHR_SUCCESS) {
+      platform_mutex_destroy(&mutex[CHANNEL_KHRN]);
+      return false;
+   }
+   return true;
 }
 
 void rpc_term(void)
 {
-   if (workspace) { khrn_platform_free(workspace); }
-   platform_mutex_destroy(&mutex);
+   if (workspace[CHANNEL_KHRN]) { khrn_platform_free(workspace[CHANNEL_KHRN]); }
+   if (workspace[CHANNEL_KHHN]) { khrn_platform_free(workspace[CHANNEL_KHHN]); }
+   platform_mutex_destroy(&mutex[CHANNEL_KHRN]);
+   platform_mutex_destroy(&mutex[CHANNEL_KHHN]);
+}
+
+static INLINE int get_channel(CLIENT_THREAD_STATE_T *thread)
+{
+   return thread->high_priority ? CHANNEL_KHHN : CHANNEL_KHRN;
 }
 
 static VCHIQ_SERVICE_HANDLE_T get_handle(CLIENT_THREAD_STATE_T *thread)
 {
-   VCHIQ_SERVICE_HANDLE_T result = (thread->high_priority ? vchiq_khhn_service : vchiq_khrn_service);
+   VCHIQ_SERVICE_HANDLE_T result;
+   khrn_wait_connected();
+   result = (thread->high_priority ? vchiq_khhn_service : vchiq_khrn_service);
    	return result;
 }
 
 static VCHIU_QUEUE_T *get_queue(CLIENT_THREAD_STATE_T *thread)
 {
+   khrn_wait_connected();
    return thread->high_priority ? &khhn_queue : &khrn_queue;
 }
 
-static void check_workspace(uint32_t size)
+static void *check_workspace(CLIENT_THREAD_STATE_T *thread, uint32_t size)
 {
    /* todo: find a better way to handle scatter/gather bulks */
+   int channel = get_channel(thread);
    vcos_assert(size <= KHDISPATCH_WORKSPACE_SIZE);
-   if (!workspace) {
-      workspace = khrn_platform_malloc(KHDISPATCH_WORKSPACE_SIZE, "rpc_workspace");
-      vcos_assert(workspace);
+   if (!workspace[channel]) {
+      workspace[channel] = khrn_platform_malloc(KHDISPATCH_WORKSPACE_SIZE, "rpc_workspace");
+      vcos_assert(workspace[channel]);
    }
+   return workspace[channel];
+}
+
+/*
+   transport auto-tune
+
+   the crossover between control messages and DMA bulks is part of the
+   khdispatch wire protocol (KHDISPATCH_CTRL_THRESHOLD is compiled into
+   both ends), so the client cannot move it unilaterally. the knob the
+   client does own is how deeply it batches control traffic before a
+   flush. rather than probing with synthetic traffic we time the first
+   few real reply round-trips after init and derive the merge depth from
+   the measured latency: the slower the link, the more a saved flush is
+   worth, so one binary lands on different depths on different boards
+*/
+
+#define AUTOTUNE_SAMPLES      16
+#define AUTOTUNE_US_PER_CHUNK 50
+
+static uint32_t autotune_sample_count;
+static uint32_t autotune_total_us;
+
+static void autotune_record_round_trip(uint32_t us)
+{
+   uint32_t chunks;
+
+   if (!khrn_options.transport_autotune || autotune_sample_count >= AUTOTUNE_SAMPLES)
+      return;
+
+   autotune_total_us += us;
+   if (++autotune_sample_count < AUTOTUNE_SAMPLES)
+      return;
+
+   /* an explicit V3D_MERGE_BUFFER_CHUNKS always wins */
+   if (khrn_options.merge_buffer_chunks)
+      return;
+
+   chunks = (autotune_total_us / AUTOTUNE_SAMPLES) / AUTOTUNE_US_PER_CHUNK + 1;
+   if (chunks > MERGE_BUFFER_MAX_CHUNKS)
+      chunks = MERGE_BUFFER_MAX_CHUNKS;
+   khrn_options.merge_buffer_chunks = chunks;
+}
+
+static void merge_grow(CLIENT_THREAD_STATE_T *thread)
+{
+   /*
+      resize the merge buffer to the per-process configured depth. this is
+      done lazily the first time a chunk fills rather than at thread attach,
+      as the first thread attaches before the options have been parsed
+   */
+
+   uint32_t chunks = khrn_options.merge_buffer_chunks;
+   uint32_t capacity;
+   uint8_t *buffer;
+
+   if (chunks < 1) { chunks = 1; }
+   if (chunks > MERGE_BUFFER_MAX_CHUNKS) { chunks = MERGE_BUFFER_MAX_CHUNKS; }
+   capacity = chunks * MERGE_BUFFER_SIZE;
+   if (capacity <= thread->merge_capacity) {
+      return;
+   }
+
+   buffer = khrn_platform_malloc(capacity, "CLIENT_THREAD_STATE_T.merge_buffer");
+   if (!buffer) {
+      return; /* keep the buffer we have -- we just flush more often */
+   }
+   memcpy(buffer, thread->merge_buffer, thread->merge_pos);
+   khrn_platform_free(thread->merge_buffer);
+   thread->merge_buffer = buffer;
+   thread->merge_capacity = capacity;
+}
+
+static void merge_flush(CLIENT_THREAD_STATE_T *thread);
+
+static void merge_open_chunk(CLIENT_THREAD_STATE_T *thread)
+{
+   /*
+      close the chunk currently being filled and start the next one with its
+      own make current, so every chunk is a self-contained message
+   */
+
+   vcos_assert(thread->merge_chunks + 1 < MERGE_BUFFER_MAX_CHUNKS);
+   thread->merge_chunks++;
+   thread->merge_chunk_start[thread->merge_chunks] = thread->merge_pos;
+
+   client_send_make_current(thread);
 }
 
 static void merge_flush(CLIENT_THREAD_STATE_T *thread)
@@ -274,18 +449,31 @@ static void merge_flush(CLIENT_THREAD_STATE_T *thread)
    */
 
    if (thread->merge_pos > CLIENT_MAKE_CURRENT_SIZE) {
-      VCHIQ_ELEMENT_T element;
-      
+      uint32_t i;
+
       rpc_begin(thread);
 
-      element.data = thread->merge_buffer;
-      element.size = thread->merge_pos;
+      /*
+         each message-sized chunk goes out as a separate message (they must
+         each fit in a slot), but back to back under one lock acquisition
+      */
+
+      for (i = 0; i <= thread->merge_chunks; i++) {
+         VCHIQ_ELEMENT_T element;
+         uint32_t end = (i == thread->merge_chunks) ? thread->merge_pos : thread->merge_chunk_start[i + 1];
 
-      VCHIQ_STATUS_T success = vchiq_queue_message(get_handle(thread), &element, 1);
-      UNUSED_NDEBUG(success);      
-      vcos_assert(success == VCHIQ_SUCCESS);
+         element.data = thread->merge_buffer + thread->merge_chunk_start[i];
+         element.size = end - thread->merge_chunk_start[i];
+         vcos_assert(element.size <= MERGE_BUFFER_SIZE);
+
+         VCHIQ_STATUS_T success = vchiq_queue_message(get_handle(thread), &element, 1);
+         UNUSED_NDEBUG(success);
+         vcos_assert(success == VCHIQ_SUCCESS);
+      }
 
       thread->merge_pos = 0;
+      thread->merge_chunks = 0;
+      thread->merge_chunk_start[0] = 0;
 
       client_send_make_current(thread);
 
@@ -304,6 +492,9 @@ void rpc_flush(CLIENT_THREAD_STATE_T *thread)
 
 void rpc_high_priority_begin(CLIENT_THREAD_STATE_T *thread)
 {
+   if (thread->channel_pinned) {
+      return; /* thread lives on the high priority service permanently */
+   }
    vcos_assert(!thread->high_priority);
    merge_flush(thread);
    thread->high_priority = true;
@@ -311,6 +502,9 @@ void rpc_high_priority_begin(CLIENT_THREAD_STATE_T *thread)
 
 void rpc_high_priority_end(CLIENT_THREAD_STATE_T *thread)
 {
+   if (thread->channel_pinned) {
+      return;
+   }
    vcos_assert(thread->high_priority);
    merge_flush(thread);
    thread->high_priority = false;
@@ -318,7 +512,7 @@ void rpc_high_priority_end(CLIENT_THREAD_STATE_T *thread)
 
 uint32_t rpc_send_ctrl_longest(CLIENT_THREAD_STATE_T *thread, uint32_t len_min)
 {
-   uint32_t len = MERGE_BUFFER_SIZE - thread->merge_pos;
+   uint32_t len = MERGE_BUFFER_SIZE - (thread->merge_pos - thread->merge_chunk_start[thread->merge_chunks]);
    if (len < len_min) {
       len = MERGE_BUFFER_SIZE - CLIENT_MAKE_CURRENT_SIZE;
    }
@@ -330,8 +524,20 @@ void rpc_send_ctrl_begin(CLIENT_THREAD_STATE_T *thread, uint32_t len)
    //CLIENT_THREAD_STATE_T *thread = CLIENT_GET_THREAD_STATE();
 
    vcos_assert(len == rpc_pad_ctrl(len));
-   if ((thread->merge_pos + len) > MERGE_BUFFER_SIZE) {
-      merge_flush(thread);
+   if ((thread->merge_pos + len) > (thread->merge_chunk_start[thread->merge_chunks] + MERGE_BUFFER_SIZE)) {
+      /*
+         the chunk being filled is full. open another one if the buffer
+         still has room for it (high-water mark), otherwise flush the lot
+      */
+      uint32_t max_chunks;
+      merge_grow(thread);
+      max_chunks = thread->merge_capacity / MERGE_BUFFER_SIZE;
+      if (((thread->merge_chunks + 1) < max_chunks) &&
+          ((thread->merge_pos + CLIENT_MAKE_CURRENT_SIZE + len) <= thread->merge_capacity)) {
+         merge_open_chunk(thread);
+      } else {
+         merge_flush(thread);
+      }
    }
 
    thread->merge_end = thread->merge_pos + len;
@@ -343,7 +549,7 @@ void rpc_send_ctrl_write(CLIENT_THREAD_STATE_T *thread, const uint32_t in[], uin
 
    memcpy(thread->merge_buffer + thread->merge_pos, in, len);
    thread->merge_pos += rpc_pad_ctrl(len);
-   vcos_assert(thread->merge_pos <= MERGE_BUFFER_SIZE);
+   vcos_assert(thread->merge_pos <= thread->merge_capacity);
 }
 
 void rpc_send_ctrl_end(CLIENT_THREAD_STATE_T *thread)
@@ -366,9 +572,9 @@ static void send_bulk(CLIENT_THREAD_STATE_T *thread, const void *in, uint32_t le
       vcos_assert(vchiq_status == VCHIQ_SUCCESS);
    } else {
       VCHIQ_STATUS_T vchiq_status = vchiq_queue_bulk_transmit(get_handle(thread), in, rpc_pad_bulk(len), NULL);
-      UNUSED_NDEBUG(vchiq_status);      
+      UNUSED_NDEBUG(vchiq_status);
       vcos_assert(vchiq_status == VCHIQ_SUCCESS);
-      VCOS_STATUS_T vcos_status = vcos_event_wait(&bulk_event);
+      VCOS_STATUS_T vcos_status = vcos_event_wait(&bulk_event[get_channel(thread)]);
       UNUSED_NDEBUG(vcos_status);      
       vcos_assert(vcos_status == VCOS_SUCCESS);
    }
@@ -385,7 +591,7 @@ static void recv_bulk(CLIENT_THREAD_STATE_T *thread, void *out, uint32_t len)
       VCHIQ_STATUS_T vchiq_status = vchiq_queue_bulk_receive(get_handle(thread), out, rpc_pad_bulk(len), NULL);
       UNUSED_NDEBUG(vchiq_status);
       vcos_assert(vchiq_status == VCHIQ_SUCCESS);
-      VCOS_STATUS_T vcos_status = vcos_event_wait(&bulk_event);
+      VCOS_STATUS_T vcos_status = vcos_event_wait(&bulk_event[get_channel(thread)]);
       UNUSED_NDEBUG(vcos_status);      
       vcos_assert(vcos_status == VCOS_SUCCESS);
    }
@@ -414,9 +620,9 @@ void rpc_send_bulk_gather(CLIENT_THREAD_STATE_T *thread, const void *in, uint32_
          /* hopefully should be the common case */
          send_bulk(thread, in, n * len);
       } else {
-         check_workspace(n * len);
-         rpc_gather(workspace, in, len, stride, n);
-         send_bulk(thread, workspace, n * len);
+         void *ws = check_workspace(thread, n * len);
+         rpc_gather(ws, in, len, stride, n);
+         send_bulk(thread, ws, n * len);
       }
    }
 #else
@@ -437,10 +643,13 @@ uint32_t rpc_recv(CLIENT_THREAD_STATE_T *thread, void *out, uint32_t *len_io, RP
    vcos_assert(!(flags & RPC_RECV_FLAG_CTRL) || !(flags & RPC_RECV_FLAG_BULK)); /* can't receive user data over both bulk and control... */
 
    if (recv_ctrl || len_io[0]) { /* do nothing if we're just receiving bulk of length 0 */
+      uint32_t flush_start = vcos_getmicrosecs();
+
       merge_flush(thread);
 
       if (recv_ctrl) {
          VCHIQ_HEADER_T *header = vchiu_queue_pop(get_queue(thread));
+         autotune_record_round_trip(vcos_getmicrosecs() - flush_start);
          uint8_t *ctrl = (uint8_t *)header->data;
          vcos_assert(header->size >= (!!(flags & RPC_RECV_FLAG_LEN)*4 + !!(flags & RPC_RECV_FLAG_RES)*4) );
          if (flags & RPC_RECV_FLAG_LEN) {
@@ -465,9 +674,9 @@ uint32_t rpc_recv(CLIENT_THREAD_STATE_T *thread, void *out, uint32_t *len_io, RP
                /* hopefully should be the common case */
                recv_bulk(thread, out, len_io[2] * len_io[0]);
             } else {
-               check_workspace(len_io[2] * len_io[0]);
-               recv_bulk(thread, workspace, len_io[2] * len_io[0]);
-               rpc_scatter(out, len_io[0], len_io[1], len_io[2], len_io[3], len_io[4], workspace);
+               void *ws = check_workspace(thread, len_io[2] * len_io[0]);
+               recv_bulk(thread, ws, len_io[2] * len_io[0]);
+               rpc_scatter(out, len_io[0], len_io[1], len_io[2], len_io[3], len_io[4], ws);
             }
          } else {
             recv_bulk(thread, out, len_io[0]);
@@ -480,14 +689,12 @@ uint32_t rpc_recv(CLIENT_THREAD_STATE_T *thread, void *out, uint32_t *len_io, RP
 
 void rpc_begin(CLIENT_THREAD_STATE_T *thread)
 {
-   UNUSED(thread);
-   platform_mutex_acquire(&mutex);
+   platform_mutex_acquire(&mutex[get_channel(thread)]);
 }
 
 void rpc_end(CLIENT_THREAD_STATE_T *thread)
 {
-   UNUSED(thread);
-   platform_mutex_release(&mutex);
+   platform_mutex_release(&mutex[get_channel(thread)]);
 }
 
 void rpc_use(CLIENT_THREAD_STATE_T *thread)
@@ -503,15 +710,17 @@ void rpc_release(CLIENT_THREAD_STATE_T *thread)
 void rpc_call8_makecurrent(CLIENT_THREAD_STATE_T *thread, uint32_t id, uint32_t p0,
    uint32_t p1, uint32_t p2, uint32_t p3, uint32_t p4, uint32_t p5, uint32_t p6, uint32_t p7)
 {
-   if (thread->merge_pos == CLIENT_MAKE_CURRENT_SIZE && *((uint32_t *)thread->merge_buffer) == EGLINTMAKECURRENT_ID)
+   uint32_t chunk_start = thread->merge_chunk_start[thread->merge_chunks];
+   if (thread->merge_pos == (chunk_start + CLIENT_MAKE_CURRENT_SIZE) &&
+       *((uint32_t *)(thread->merge_buffer + chunk_start)) == EGLINTMAKECURRENT_ID)
    {
       rpc_begin(thread);
       vcos_log_trace("rpc_call8_makecurrent collapse onto previous makecurrent");
 
-      thread->merge_pos = 0;
-      
+      thread->merge_pos = chunk_start;
+
       RPC_CALL8(eglIntMakeCurrent_impl, thread, EGLINTMAKECURRENT_ID, p0, p1, p2, p3, p4, p5, p6, p7);
-      vcos_assert(thread->merge_pos == CLIENT_MAKE_CURRENT_SIZE);
+      vcos_assert(thread->merge_pos == (chunk_start + CLIENT_MAKE_CURRENT_SIZE));
 
       rpc_end(thread);
    }
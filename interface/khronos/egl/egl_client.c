@@ -356,7 +356,7 @@ name may be one of EGL CLIENT APIS, EGL EXTENSIONS, EGL VENDOR, or
 EGL VERSION.
 The EGL CLIENT APIS string describes which client rendering APIs are supported.
 It is zero-terminated and contains a space-separated list of API names,
-which must include at least one of ��OpenGL ES�� or ��OpenVG��.
+which must include at least one of ��OpenGL ES�� or ��OpenVG��.
 Version 1.3 - December 4, 2006
 3.4. CONFIGURATION MANAGEMENT 13
 The EGL EXTENSIONS string describes which EGL extensions are supported
@@ -425,10 +425,12 @@ EGLAPI const char EGLAPIENTRY * eglQueryString(EGLDisplay dpy, EGLint name)
          result = ""
 #if EGL_KHR_image
             "EGL_KHR_image EGL_KHR_image_base EGL_KHR_image_pixmap EGL_KHR_vg_parent_image EGL_KHR_gl_texture_2D_image EGL_KHR_gl_texture_cubemap_image "
+            "EGL_BRCM_image_vcsm "
 #endif
 #if EGL_KHR_lock_surface
             "EGL_KHR_lock_surface "
 #endif
+            "EGL_BRCM_present_pacing "
 #if EGL_ANDROID_swap_rectangle
             "EGL_ANDROID_swap_rectangle "
 #endif
@@ -517,7 +519,7 @@ EGLAPI const char EGLAPIENTRY * eglQueryString(EGLDisplay dpy, EGLint name)
    of the OpenVG 1.0 specification for more information.
 
    Similarly, the EGL_VG_ALPHA_FORMAT attribute does not necessarily control
-   or affect the window system�s interpretation of alpha values, even when the window
+   or affect the window system�s interpretation of alpha values, even when the window
    system makes use of alpha to composite surfaces at display time. The window system's
    use and interpretation of alpha values is outside the scope of EGL. However,
    the preferred behavior is for window systems to ignore the value of EGL_VG_-
@@ -2330,6 +2332,21 @@ EGLAPI EGLBoolean EGLAPIENTRY eglSwapBuffers(EGLDisplay dpy, EGLSurface surf)
 #        ifndef RPC_DIRECT_MULTI
                   vcos_log_trace("eglSwapBuffers waiting for semaphore");
                   khronos_platform_semaphore_acquire(&surface->avail_buffers);
+
+                  /* present pacing: the semaphore counts free buffers, so
+                   * waiting for extra ones before returning bounds how many
+                   * swapped frames can be queued ahead of the display */
+                  if (surface->max_queued_frames != 0 &&
+                      surface->max_queued_frames < surface->buffers - 1) {
+                     uint32_t extra = surface->buffers - 1 - surface->max_queued_frames;
+                     uint32_t i;
+                     for (i = 0; i != extra; i++)
+                        khronos_platform_semaphore_acquire(&surface->avail_buffers);
+                     for (i = 0; i != extra; i++)
+                        khronos_platform_semaphore_release(&surface->avail_buffers);
+                  }
+
+                  surface->last_swap_time = vcos_getmicrosecs();
 #        endif
                }
 #     endif // RPC_LIBRARY
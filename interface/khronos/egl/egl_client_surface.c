@@ -35,6 +35,8 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "interface/khronos/egl/egl_client_surface.h"
 #include "interface/khronos/egl/egl_client_config.h"
 
+#include "interface/khronos/include/EGL/eglext_brcm.h"
+
 #include "interface/khronos/common/khrn_client.h"
 
 #ifdef KHRONOS_EGL_PLATFORM_OPENWFC
@@ -354,6 +356,9 @@ EGL_SURFACE_T *egl_surface_create(
 
    surface->internal_handle = serverwin;
 
+   surface->max_queued_frames = 0;
+   surface->last_swap_time = 0;
+
    surface->largest_pbuffer = largest_pbuffer;
    surface->mipmap_texture = mipmap_texture;
    surface->mipmap_level = 0;
@@ -550,6 +555,8 @@ EGL_SURFACE_T *egl_surface_from_vg_image(
    surface->config = config;
    surface->win = 0;
    surface->swap_interval = 1;
+   surface->max_queued_frames = 0;
+   surface->last_swap_time = 0;
 
    surface->largest_pbuffer = largest_pbuffer;
    surface->mipmap_texture = mipmap_texture;
@@ -755,6 +762,16 @@ EGLBoolean egl_surface_get_attrib(EGL_SURFACE_T *surface, EGLint attrib, EGLint
    case EGL_WIDTH:
       *value = surface->width;
       return EGL_TRUE;
+   case EGL_MAX_QUEUED_FRAMES_BRCM:
+      // Querying for a non-window surface is not an error, but value is
+      // not modified.
+      if (surface->type == WINDOW)
+         *value = (EGLint)surface->max_queued_frames;
+      return EGL_TRUE;
+   case EGL_LAST_SWAP_TIME_BRCM:
+      if (surface->type == WINDOW)
+         *value = (EGLint)surface->last_swap_time;
+      return EGL_TRUE;
    default:
       return EGL_FALSE;
    }
@@ -793,6 +810,13 @@ EGLint egl_surface_set_attrib(EGL_SURFACE_T *surface, EGLint attrib, EGLint valu
       default:
          return EGL_BAD_PARAMETER;
       }
+   case EGL_MAX_QUEUED_FRAMES_BRCM:
+      if (value < 0)
+         return EGL_BAD_PARAMETER;
+      // Setting for a non-window surface is not an error, but has no effect.
+      if (surface->type == WINDOW)
+         surface->max_queued_frames = (uint32_t)value;
+      return EGL_SUCCESS;
    default:
       return EGL_BAD_ATTRIBUTE;
    }
@@ -195,6 +195,28 @@ typedef struct {
    uint32_t swap_interval;
    uint32_t internal_handle;              // stores "serverwin"
 
+   /*
+      max_queued_frames
+
+      bound on the number of swapped frames queued ahead of the display
+      (EGL_MAX_QUEUED_FRAMES_BRCM); 0 means the full swap chain depth
+
+      Validity:
+      type == WINDOW
+   */
+   uint32_t max_queued_frames;
+
+   /*
+      last_swap_time
+
+      time at which the previous eglSwapBuffers acquired a free buffer, in
+      microseconds from a wrapping 32 bit clock (EGL_LAST_SWAP_TIME_BRCM)
+
+      Validity:
+      type == WINDOW
+   */
+   uint32_t last_swap_time;
+
    /*
       avail_buffers
 
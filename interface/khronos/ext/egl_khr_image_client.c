@@ -84,6 +84,7 @@ EGLAPI EGLImageKHR EGLAPIENTRY eglCreateImageKHR (EGLDisplay dpy, EGLContext ctx
             || target == EGL_IMAGE_BRCM_MULTIMEDIA_Y
             || target == EGL_IMAGE_BRCM_MULTIMEDIA_U
             || target == EGL_IMAGE_BRCM_MULTIMEDIA_V
+            || target == EGL_IMAGE_BRCM_VCSM
             || target == EGL_IMAGE_BRCM_DUPLICATE
             ) {
             context = NULL;
@@ -256,6 +257,19 @@ EGLAPI EGLImageKHR EGLAPIENTRY eglCreateImageKHR (EGLDisplay dpy, EGLContext ctx
                   buf[0] = (uint32_t)buffer;
                   vcos_log_trace("%s: converting buffer handle %u to EGL_IMAGE_BRCM_MULTIMEDIA_V",
                         __FUNCTION__, buf[0]);
+            } else if (target == EGL_IMAGE_BRCM_VCSM) {
+                  struct egl_image_brcm_vcsm_info *vcsm_info = (struct egl_image_brcm_vcsm_info *)buffer;
+
+                  buf[0] = 0;
+                  if (vcsm_info && vcsm_info->width && vcsm_info->height) {
+                     buf[0] = platform_get_vcsm_vc_handle(vcsm_info->vcsm_handle);
+                     buffer_width = vcsm_info->width;
+                     buffer_height = vcsm_info->height;
+                  }
+                  if (!buf[0])
+                     buf_error = true;
+                  vcos_log_trace("%s: converting vcsm handle %u to VC handle %u",
+                        __FUNCTION__, vcsm_info ? vcsm_info->vcsm_handle : 0, buf[0]);
 #endif
             } else {
                vcos_log_trace("%s:target type %x buffer %p handled on server", __FUNCTION__, target, buffer);
@@ -298,6 +312,7 @@ EGLAPI EGLImageKHR EGLAPIENTRY eglCreateImageKHR (EGLDisplay dpy, EGLContext ctx
                            buf[0] | ((uint64_t)buf[1] << 32))) {
                            thread->error = EGL_BAD_ALLOC;
                         } else {
+                           khrn_global_image_map_cache_invalidate();
                            result = (EGLImageKHR)(uintptr_t)process->next_global_image_egl_image;
                            thread->error = EGL_SUCCESS;
                            do {
@@ -373,6 +388,7 @@ EGLAPI EGLBoolean EGLAPIENTRY eglDestroyImageKHR (EGLDisplay dpy, EGLImageKHR im
          if ((uintptr_t)image & (1 << 31)) {
             result = khrn_global_image_map_delete(&process->global_image_egl_images, (uint32_t)(uintptr_t)image) ?
                EGL_TRUE : EGL_FALSE;
+            khrn_global_image_map_cache_invalidate();
          } else
 #endif
          {
@@ -59,9 +59,7 @@ static bool check_global_image_egl_image(GLuint global_image_id[2],
    uint64_t id;
    uint32_t format, width, height;
 
-   CLIENT_LOCK();
-   id = process->inited ? khrn_global_image_map_lookup(&process->global_image_egl_images, (uint32_t)(uintptr_t)image) : 0;
-   CLIENT_UNLOCK();
+   id = process->inited ? khrn_global_image_map_lookup_fast(&process->global_image_egl_images, (uint32_t)(uintptr_t)image) : 0;
    if (!id) {
       return false;
    }
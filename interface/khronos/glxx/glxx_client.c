@@ -330,10 +330,121 @@ GL_API void GL_APIENTRY glBlendEquation( GLenum mode ) // S
    glBlendEquationSeparate(mode, mode);
 }
 
+/*
+   client-side shadow of latched server state
+
+   UI toolkits re-set the same state every frame, and an RPC we never send
+   is the cheapest RPC of all. only enums validated against the lists below
+   are recorded; everything else is forwarded untouched, so the server
+   still generates GL_INVALID_ENUM exactly where it used to
+*/
+
+static const GLenum shadow_caps[GLXX_SHADOW_CAP_COUNT] = {
+   GL_BLEND,
+   GL_CULL_FACE,
+   GL_DEPTH_TEST,
+   GL_DITHER,
+   GL_POLYGON_OFFSET_FILL,
+   GL_SAMPLE_ALPHA_TO_COVERAGE,
+   GL_SAMPLE_COVERAGE,
+   GL_SCISSOR_TEST,
+   GL_STENCIL_TEST
+};
+
+static int shadow_cap_index(GLenum cap)
+{
+   int i;
+   for (i = 0; i < GLXX_SHADOW_CAP_COUNT; i++)
+      if (shadow_caps[i] == cap)
+         return i;
+   return -1;
+}
+
+/*
+   returns true if the glEnable/glDisable is redundant and can be skipped,
+   recording the new value otherwise
+*/
+
+static bool shadow_set_cap(CLIENT_THREAD_STATE_T *thread, GLenum cap, int8_t enabled)
+{
+   GLXX_CLIENT_STATE_T *state = GLXX_GET_CLIENT_STATE(thread);
+   int i = shadow_cap_index(cap);
+   if (i < 0)
+      return false; /* not shadowed (or not a valid cap) - always forward */
+   if (state->shadow.cap[i] == enabled) {
+      state->shadow.elided++;
+      return true;
+   }
+   state->shadow.cap[i] = enabled;
+   return false;
+}
+
+static bool shadow_blend_factor_ok(GLenum factor)
+{
+   switch (factor) {
+   case GL_ZERO:
+   case GL_ONE:
+   case GL_SRC_COLOR:
+   case GL_ONE_MINUS_SRC_COLOR:
+   case GL_DST_COLOR:
+   case GL_ONE_MINUS_DST_COLOR:
+   case GL_SRC_ALPHA:
+   case GL_ONE_MINUS_SRC_ALPHA:
+   case GL_DST_ALPHA:
+   case GL_ONE_MINUS_DST_ALPHA:
+      return true;
+   default:
+      /*
+         GL_SRC_ALPHA_SATURATE and the ES 2.0 constant-colour factors are
+         position/version dependent - leave their validation to the server
+      */
+      return false;
+   }
+}
+
+static bool shadow_blend_eqn_ok(GLenum mode)
+{
+   return mode == GL_FUNC_ADD || mode == GL_FUNC_SUBTRACT || mode == GL_FUNC_REVERSE_SUBTRACT;
+}
+
+/* -1 if the cap is not shadowed or its value has not been latched yet */
+static int8_t shadow_get_cap(CLIENT_THREAD_STATE_T *thread, GLenum cap)
+{
+   GLXX_CLIENT_STATE_T *state = GLXX_GET_CLIENT_STATE(thread);
+   int i = shadow_cap_index(cap);
+   if (i < 0)
+      return -1;
+   return state->shadow.cap[i];
+}
+
+uint32_t glxx_shadow_elided_calls(void)
+{
+   CLIENT_THREAD_STATE_T *thread = CLIENT_GET_THREAD_STATE();
+   if (IS_OPENGLES_11_OR_20(thread))
+      return GLXX_GET_CLIENT_STATE(thread)->shadow.elided;
+   return 0;
+}
+
 GL_API void GL_APIENTRY glBlendEquationSeparate(GLenum modeRGB, GLenum modeAlpha) // S
 {
    CLIENT_THREAD_STATE_T *thread = CLIENT_GET_THREAD_STATE();
    if (IS_OPENGLES_20(thread)) {
+      GLXX_CLIENT_STATE_T *state = GLXX_GET_CLIENT_STATE(thread);
+
+      if (shadow_blend_eqn_ok(modeRGB) && shadow_blend_eqn_ok(modeAlpha)) {
+         if (state->shadow.blend_eqn_valid &&
+             state->shadow.blend_eqn_rgb == modeRGB &&
+             state->shadow.blend_eqn_alpha == modeAlpha) {
+            state->shadow.elided++;
+            return;
+         }
+         state->shadow.blend_eqn_rgb = modeRGB;
+         state->shadow.blend_eqn_alpha = modeAlpha;
+         state->shadow.blend_eqn_valid = true;
+      } else {
+         state->shadow.blend_eqn_valid = false;
+      }
+
       RPC_CALL2(glBlendEquationSeparate_impl_20,
                 thread,
                 GLBLENDEQUATIONSEPARATE_ID_20,
@@ -343,6 +454,27 @@ GL_API void GL_APIENTRY glBlendEquationSeparate(GLenum modeRGB, GLenum modeAlpha
 }
 
 static void set_blend_func (CLIENT_THREAD_STATE_T *thread, GLenum srcRGB, GLenum dstRGB, GLenum srcAlpha, GLenum dstAlpha) {
+   GLXX_CLIENT_STATE_T *state = GLXX_GET_CLIENT_STATE(thread);
+
+   if (shadow_blend_factor_ok(srcRGB) && shadow_blend_factor_ok(dstRGB) &&
+       shadow_blend_factor_ok(srcAlpha) && shadow_blend_factor_ok(dstAlpha)) {
+      if (state->shadow.blend_func_valid &&
+          state->shadow.blend_src_rgb == srcRGB &&
+          state->shadow.blend_dst_rgb == dstRGB &&
+          state->shadow.blend_src_alpha == srcAlpha &&
+          state->shadow.blend_dst_alpha == dstAlpha) {
+         state->shadow.elided++;
+         return;
+      }
+      state->shadow.blend_src_rgb = srcRGB;
+      state->shadow.blend_dst_rgb = dstRGB;
+      state->shadow.blend_src_alpha = srcAlpha;
+      state->shadow.blend_dst_alpha = dstAlpha;
+      state->shadow.blend_func_valid = true;
+   } else {
+      state->shadow.blend_func_valid = false;
+   }
+
    RPC_CALL4(glBlendFuncSeparate_impl,
              thread,
              GLBLENDFUNCSEPARATE_ID,
@@ -1069,6 +1201,8 @@ GL_API void GL_APIENTRY glDisable (GLenum cap)
 {
    CLIENT_THREAD_STATE_T *thread = CLIENT_GET_THREAD_STATE();
    if (IS_OPENGLES_11_OR_20(thread)) {
+      if (shadow_set_cap(thread, cap, 0))
+         return;
       RPC_CALL1(glDisable_impl,
                thread,
                 GLDISABLE_ID,
@@ -1364,6 +1498,8 @@ GL_API void GL_APIENTRY glEnable (GLenum cap)
 {
    CLIENT_THREAD_STATE_T *thread = CLIENT_GET_THREAD_STATE();
    if (IS_OPENGLES_11_OR_20(thread)) {
+      if (shadow_set_cap(thread, cap, 1))
+         return;
       RPC_CALL1(glEnable_impl,
                 thread,
                 GLENABLE_ID,
@@ -1967,6 +2103,88 @@ static int get_integer_internal_20(CLIENT_THREAD_STATE_T *thread, GLenum pname,
    return 0;
 }
 
+/*
+   resolve an ES 2.0 query entirely client-side where we can: buffer
+   bindings and capabilities we shadow anyway, state we latched via the
+   shadow above, and implementation limits which are compile-time
+   constants on this hardware. returns the number of values written, or
+   0 if the server has to be asked (unknown pname, or shadow not valid)
+*/
+
+static int get_integer_shadow_20(CLIENT_THREAD_STATE_T *thread, GLenum pname, GLint *params)
+{
+   GLXX_CLIENT_STATE_T *state = GLXX_GET_CLIENT_STATE(thread);
+
+   vcos_assert(state != NULL);
+
+   switch (pname) {
+   case GL_ARRAY_BUFFER_BINDING:
+      params[0] = (GLint) state->bound_buffer.array;
+      return 1;
+   case GL_ELEMENT_ARRAY_BUFFER_BINDING:
+      params[0] = (GLint) state->bound_buffer.element_array;
+      return 1;
+
+   case GL_MAX_VERTEX_ATTRIBS:
+      params[0] = GL20_CONFIG_MAX_VERTEX_ATTRIBS;
+      return 1;
+   case GL_MAX_RENDERBUFFER_SIZE:
+      params[0] = GLXX_CONFIG_MAX_RENDERBUFFER_SIZE;
+      return 1;
+   case GL_SUBPIXEL_BITS:
+      params[0] = GLXX_CONFIG_SUBPIXEL_BITS;
+      return 1;
+   case GL_MAX_VIEWPORT_DIMS:
+      params[0] = GLXX_CONFIG_MAX_VIEWPORT_SIZE;
+      params[1] = GLXX_CONFIG_MAX_VIEWPORT_SIZE;
+      return 2;
+
+   case GL_BLEND_SRC_RGB:
+      if (!state->shadow.blend_func_valid) return 0;
+      params[0] = (GLint) state->shadow.blend_src_rgb;
+      return 1;
+   case GL_BLEND_DST_RGB:
+      if (!state->shadow.blend_func_valid) return 0;
+      params[0] = (GLint) state->shadow.blend_dst_rgb;
+      return 1;
+   case GL_BLEND_SRC_ALPHA:
+      if (!state->shadow.blend_func_valid) return 0;
+      params[0] = (GLint) state->shadow.blend_src_alpha;
+      return 1;
+   case GL_BLEND_DST_ALPHA:
+      if (!state->shadow.blend_func_valid) return 0;
+      params[0] = (GLint) state->shadow.blend_dst_alpha;
+      return 1;
+   case GL_BLEND_EQUATION_RGB:
+      if (!state->shadow.blend_eqn_valid) return 0;
+      params[0] = (GLint) state->shadow.blend_eqn_rgb;
+      return 1;
+   case GL_BLEND_EQUATION_ALPHA:
+      if (!state->shadow.blend_eqn_valid) return 0;
+      params[0] = (GLint) state->shadow.blend_eqn_alpha;
+      return 1;
+
+   case GL_BLEND:
+   case GL_CULL_FACE:
+   case GL_DEPTH_TEST:
+   case GL_DITHER:
+   case GL_POLYGON_OFFSET_FILL:
+   case GL_SAMPLE_ALPHA_TO_COVERAGE:
+   case GL_SAMPLE_COVERAGE:
+   case GL_SCISSOR_TEST:
+   case GL_STENCIL_TEST:
+   {
+      int8_t enabled = shadow_get_cap(thread, pname);
+      if (enabled < 0) return 0;
+      params[0] = enabled;
+      return 1;
+   }
+
+   default:
+      return 0;
+   }
+}
+
 GL_API void GL_APIENTRY glGetBooleanv (GLenum pname, GLboolean *params)
 {
    CLIENT_THREAD_STATE_T *thread = CLIENT_GET_THREAD_STATE();
@@ -2051,6 +2269,15 @@ GL_API void GL_APIENTRY glGetBooleanv (GLenum pname, GLboolean *params)
          break;
       }
       default:
+      {
+         GLint temp[2];
+         int count = get_integer_shadow_20(thread, pname, temp);
+         if (count) {
+            int i;
+            for (i = 0; i < count; i++)
+               params[i] = temp[i] != 0;
+            break;
+         }
          RPC_CALL2_OUT_CTRL(glGetBooleanv_impl,
                             thread,
                             GLGETBOOLEANV_ID,
@@ -2058,6 +2285,7 @@ GL_API void GL_APIENTRY glGetBooleanv (GLenum pname, GLboolean *params)
                             params);
          break;
       }
+      }
 
    }
 }
@@ -2337,6 +2565,15 @@ GL_API void GL_APIENTRY glGetFloatv (GLenum pname, GLfloat *params)
          break;
       }
       default:
+      {
+         GLint temp[2];
+         int count = get_integer_shadow_20(thread, pname, temp);
+         if (count) {
+            int i;
+            for (i = 0; i < count; i++)
+               params[i] = (GLfloat)temp[i];
+            break;
+         }
          RPC_CALL2_OUT_CTRL(glGetFloatv_impl,
                             thread,
                             GLGETFLOATV_ID,
@@ -2344,6 +2581,7 @@ GL_API void GL_APIENTRY glGetFloatv (GLenum pname, GLfloat *params)
                             params);
          break;
       }
+      }
    }
 }
 
@@ -2450,6 +2688,8 @@ GL_API void GL_APIENTRY glGetIntegerv (GLenum pname, GLint *params)
          get_integer_internal_20(thread, pname, params);
          break;
       default:
+         if (get_integer_shadow_20(thread, pname, params))
+            break;
          RPC_CALL2_OUT_CTRL(glGetIntegerv_impl,
                             thread,
                             GLGETINTEGERV_ID,
@@ -2995,13 +3235,21 @@ GL_API GLboolean GL_APIENTRY glIsEnabled (GLenum cap)
          return temp;
       }
       default:
+      {
+         int8_t enabled = shadow_get_cap(thread, cap);
+         if (enabled >= 0)
+            return (GLboolean)enabled;
          return RPC_BOOLEAN_RES(RPC_CALL1_RES(glIsEnabled_impl,
                                               thread,
                                               GLISENABLED_ID,
                                               RPC_ENUM(cap)));
       }
+      }
    }
    else if (IS_OPENGLES_20(thread)) {
+      int8_t enabled = shadow_get_cap(thread, cap);
+      if (enabled >= 0)
+         return (GLboolean)enabled;
       return RPC_BOOLEAN_RES(RPC_CALL1_RES(glIsEnabled_impl,
                                            thread,
                                            GLISENABLED_ID,
@@ -3759,41 +4007,190 @@ static uint32_t get_pitch(uint32_t w, GLenum format, GLenum type, uint32_t a)
    return 0;      // transfer no data, format will be rejected by server
 }
 
+static void read_pixels_rpc (CLIENT_THREAD_STATE_T *thread, GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, GLvoid *pixels)
+{
+   GLXX_CLIENT_STATE_T *state = GLXX_GET_CLIENT_STATE(thread);
+
+   uint32_t pitch = get_pitch( (uint32_t)width, format, type, (uint32_t) state->alignment.pack);
+   uint32_t lines = pitch ? (uint32_t) (KHDISPATCH_WORKSPACE_SIZE / pitch) : (uint32_t)height;
+
+   if (pixels && lines) {
+      int offset = 0;
+
+      while (height > 0) {
+         int32_t batch = _min(lines, (int32_t) height);
+
+         RPC_CALL8_OUT_BULK(glReadPixels_impl,
+                            thread,
+                            GLREADPIXELS_ID,
+                            RPC_INT(x),
+                            RPC_INT(y + offset),
+                            RPC_SIZEI(width),
+                            RPC_SIZEI(batch),
+                            RPC_ENUM(format),
+                            RPC_ENUM(type),
+                            RPC_INT(state->alignment.pack),
+                            (char *)pixels + offset * pitch);
+
+         offset += batch;
+         height -= batch;
+      }
+   }
+}
+
 GL_API void GL_APIENTRY glReadPixels (GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, GLvoid *pixels)
 {
    CLIENT_THREAD_STATE_T *thread = CLIENT_GET_THREAD_STATE();
    if (IS_OPENGLES_11_OR_20(thread)) {
-      GLXX_CLIENT_STATE_T *state = GLXX_GET_CLIENT_STATE(thread);
+      read_pixels_rpc(thread, x, y, width, height, format, type, pixels);
 
-      uint32_t pitch = get_pitch( (uint32_t)width, format, type, (uint32_t) state->alignment.pack);
-      uint32_t lines = pitch ? (uint32_t) (KHDISPATCH_WORKSPACE_SIZE / pitch) : (uint32_t)height;
+      // We do not call flush_callback as the spec does not imply a full flush
+      // at this point (I think).
+   }
+}
 
-      if (pixels && lines) {
-         int offset = 0;
+/*
+   GL_BRCM_async_read_pixels
+
+   the synchronous readback holds the calling thread for the whole
+   render+copy round trip. these entry points hand the blocking RPC to a
+   worker thread instead: the async call queues the read (having flushed
+   the caller's batched commands so the read observes them) and returns,
+   and the await blocks until the matching read has landed. the worker
+   performs the RPC with the issuing thread's context made current, so
+   the context and the destination buffer must both outlive the await
+*/
 
-         while (height > 0) {
-            int32_t batch = _min(lines, (int32_t) height);
-
-            RPC_CALL8_OUT_BULK(glReadPixels_impl,
-                               thread,
-                               GLREADPIXELS_ID,
-                               RPC_INT(x),
-                               RPC_INT(y + offset),
-                               RPC_SIZEI(width),
-                               RPC_SIZEI(batch),
-                               RPC_ENUM(format),
-                               RPC_ENUM(type),
-                               RPC_INT(state->alignment.pack),
-                               (char *)pixels + offset * pitch);
+#define GLXX_ASYNC_READS 2
+
+typedef struct {
+   GLint x;
+   GLint y;
+   GLsizei width;
+   GLsizei height;
+   GLenum format;
+   GLenum type;
+   GLvoid *pixels;
+   EGL_CURRENT_T opengl;   /* context/surfaces to read with */
+   VCOS_EVENT_T done;
+   bool issued;            /* set on queue, cleared on await (under async_read_mutex) */
+} GLXX_ASYNC_READ_T;
+
+static GLXX_ASYNC_READ_T async_reads[GLXX_ASYNC_READS];
+static VCOS_MUTEX_T async_read_mutex;
+static VCOS_EVENT_T async_read_pending;
+static VCOS_THREAD_T async_read_thread;
+static VCOS_ONCE_T async_read_once = VCOS_ONCE_INIT;
+static volatile uint32_t async_read_head; /* written by issuers under async_read_mutex */
+static volatile uint32_t async_read_tail; /* written by the worker only */
+static int async_read_ok;
+
+static void *async_read_func(void *arg)
+{
+   CLIENT_THREAD_STATE_T *thread = CLIENT_GET_THREAD_STATE();
+   UNUSED(arg);
+
+   while (vcos_event_wait(&async_read_pending) == VCOS_SUCCESS) {
+      while (async_read_tail != async_read_head) {
+         GLXX_ASYNC_READ_T *req = &async_reads[async_read_tail % GLXX_ASYNC_READS];
+
+         thread->opengl = req->opengl;
+         if (IS_OPENGLES_11_OR_20(thread))
+            read_pixels_rpc(thread, req->x, req->y, req->width, req->height, req->format, req->type, req->pixels);
+         thread->opengl.context = NULL;
+         thread->opengl.draw = NULL;
+         thread->opengl.read = NULL;
+
+         async_read_tail++;
+         vcos_event_signal(&req->done);
+      }
+   }
+   return NULL;
+}
 
-            offset += batch;
-            height -= batch;
-         }
+static void async_read_init(void)
+{
+   int i;
+
+   if (vcos_mutex_create(&async_read_mutex, "glxx_async_read") != VCOS_SUCCESS)
+      return;
+   if (vcos_event_create(&async_read_pending, "glxx_async_read") != VCOS_SUCCESS)
+      return;
+   for (i = 0; i < GLXX_ASYNC_READS; i++)
+      if (vcos_event_create(&async_reads[i].done, "glxx_async_read_done") != VCOS_SUCCESS)
+         return;
+   if (vcos_thread_create(&async_read_thread, "glxx_async_read", NULL, async_read_func, NULL) != VCOS_SUCCESS)
+      return;
+   async_read_ok = 1;
+}
+
+GL_API GLboolean GL_APIENTRY glReadPixelsAsyncBRCM (GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, GLvoid *pixels)
+{
+   CLIENT_THREAD_STATE_T *thread = CLIENT_GET_THREAD_STATE();
+   GLboolean queued = GL_FALSE;
+
+   if (IS_OPENGLES_11_OR_20(thread) && pixels) {
+      vcos_once(&async_read_once, async_read_init);
+      if (!async_read_ok)
+         return GL_FALSE;
+
+      vcos_mutex_lock(&async_read_mutex);
+      if ((async_read_head - async_read_tail) < GLXX_ASYNC_READS) {
+         GLXX_ASYNC_READ_T *req = &async_reads[async_read_head % GLXX_ASYNC_READS];
+
+         /* drain a stale completion if the previous read here was never awaited */
+         while (vcos_event_try(&req->done) == VCOS_SUCCESS)
+            continue;
+
+         req->x = x;
+         req->y = y;
+         req->width = width;
+         req->height = height;
+         req->format = format;
+         req->type = type;
+         req->pixels = pixels;
+         req->opengl = thread->opengl;
+         req->issued = true;
+
+         /* the read must observe everything batched so far */
+         RPC_FLUSH(thread);
+
+         async_read_head++;
+         vcos_event_signal(&async_read_pending);
+         queued = GL_TRUE;
       }
+      vcos_mutex_unlock(&async_read_mutex);
+   }
+   return queued;
+}
 
-      // We do not call flush_callback as the spec does not imply a full flush
-      // at this point (I think).
+GL_API GLboolean GL_APIENTRY glReadPixelsAwaitBRCM (GLvoid *pixels)
+{
+   GLXX_ASYNC_READ_T *req = NULL;
+   int i;
+
+   if (!async_read_ok)
+      return GL_FALSE;
+
+   vcos_mutex_lock(&async_read_mutex);
+   for (i = 0; i < GLXX_ASYNC_READS; i++) {
+      if (async_reads[i].issued && async_reads[i].pixels == pixels) {
+         req = &async_reads[i];
+         break;
+      }
    }
+   vcos_mutex_unlock(&async_read_mutex);
+
+   if (!req)
+      return GL_FALSE;
+
+   if (vcos_event_wait(&req->done) != VCOS_SUCCESS)
+      return GL_FALSE;
+
+   vcos_mutex_lock(&async_read_mutex);
+   req->issued = false;
+   vcos_mutex_unlock(&async_read_mutex);
+   return GL_TRUE;
 }
 
 GL_API void GL_APIENTRY glRotatef (GLfloat angle, GLfloat x, GLfloat y, GLfloat z)
@@ -5518,6 +5915,13 @@ static void glxx_client_state_init(GLXX_CLIENT_STATE_T *state)
    state->render_callback = NULL;
    state->flush_callback = NULL;
 
+   //shadowed server state starts unknown - the first set of anything is sent
+   for (i = 0; i < GLXX_SHADOW_CAP_COUNT; i++)
+      state->shadow.cap[i] = -1;
+   state->shadow.blend_func_valid = false;
+   state->shadow.blend_eqn_valid = false;
+   state->shadow.elided = 0;
+
    //buffer info
    khrn_pointer_map_init(&state->buffers,8);
 
@@ -5644,6 +6048,22 @@ void glintAttrib (uint32_t api, uint32_t indx, float x, float y, float z, float
       if (attrib_translate(state, &indx))
       {
          vcos_assert(indx < GLXX_CONFIG_MAX_VERTEX_ATTRIBS);
+
+         /*
+            The attrib value is shadowed here for glGetVertexAttrib, so it is
+            always in step with the server copy and a redundant update can be
+            dropped without being forwarded. Animation code commonly re-sets
+            constant attribs (bone weights, colours) every frame.
+         */
+         if (state->attrib[indx].value[0] == x &&
+             state->attrib[indx].value[1] == y &&
+             state->attrib[indx].value[2] == z &&
+             state->attrib[indx].value[3] == w)
+         {
+            state->shadow.elided++;
+            return;
+         }
+
          state->attrib[indx].value[0] = x;
          state->attrib[indx].value[1] = y;
          state->attrib[indx].value[2] = z;
@@ -54,6 +54,13 @@ typedef void (*GL_FLUSH_CALLBACK_T)(bool wait);
    GL 1.1 and 2.0 client state structure
 */
 
+/*
+   number of glEnable/glDisable capabilities shadowed for redundancy
+   elision (the list itself is shadow_caps[] in glxx_client.c)
+*/
+
+#define GLXX_SHADOW_CAP_COUNT 9
+
 typedef struct buffer_info {
    GLuint id;
    GLsizeiptr cached_size;
@@ -109,6 +116,26 @@ typedef struct {
 
    KHRN_POINTER_MAP_T buffers;
 
+   /*
+      shadow of latched server state, used to skip RPCs which would not
+      change anything. values start unknown and are only recorded when
+      they have been validated client-side, so error generation for bad
+      enums is unaffected
+   */
+
+   struct {
+      int8_t cap[GLXX_SHADOW_CAP_COUNT]; /* -1 unknown, 0 disabled, 1 enabled */
+      bool blend_func_valid;
+      GLenum blend_src_rgb;
+      GLenum blend_dst_rgb;
+      GLenum blend_src_alpha;
+      GLenum blend_dst_alpha;
+      bool blend_eqn_valid;
+      GLenum blend_eqn_rgb;
+      GLenum blend_eqn_alpha;
+      uint32_t elided;                   /* count of calls skipped, see glxx_shadow_elided_calls */
+   } shadow;
+
 } GLXX_CLIENT_STATE_T;
 
 extern int gl11_client_state_init(GLXX_CLIENT_STATE_T *state);
@@ -152,6 +179,9 @@ static INLINE bool is_opengles_api(CLIENT_THREAD_STATE_T *thread, uint32_t api)
 extern void glxx_buffer_info_get(GLXX_CLIENT_STATE_T *state, GLenum target, GLXX_BUFFER_INFO_T* buffer);
 extern void glxx_buffer_info_set(GLXX_CLIENT_STATE_T *state, GLenum target, GLXX_BUFFER_INFO_T* buffer);
 extern void glxx_set_error(GLXX_CLIENT_STATE_T *state, GLenum error);
+
+/* diagnostic: number of redundant state-setting calls elided for the current context */
+extern uint32_t glxx_shadow_elided_calls(void);
 extern void glxx_set_error_api(uint32_t api, GLenum error);
 
 /* Fake GL API calls */
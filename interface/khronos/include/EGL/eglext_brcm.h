@@ -45,6 +45,31 @@ extern "C" {
 #define EGL_IMAGE_BRCM_MULTIMEDIA_U      0x99930C1
 #define EGL_IMAGE_BRCM_MULTIMEDIA_V      0x99930C2
 
+/* Create an image backed by an existing vcsm (VideoCore shared memory)
+ * allocation. The buffer argument is an egl_image_brcm_vcsm_info; the
+ * memory is already GPU-visible, so texturing from it makes no copy. */
+#define EGL_IMAGE_BRCM_VCSM              0x99930C3
+
+struct egl_image_brcm_vcsm_info {
+   unsigned int width;
+   unsigned int height;
+   unsigned int vcsm_handle; /* handle returned by vcsm_malloc et al */
+};
+
+/* EGL_BRCM_present_pacing: surface attributes for eglSurfaceAttrib /
+ * eglQuerySurface on window surfaces.
+ *
+ * EGL_MAX_QUEUED_FRAMES_BRCM bounds how many swapped frames may be queued
+ * ahead of the display; eglSwapBuffers blocks until the queue is short
+ * enough. 0 (the default) keeps the full swap chain depth.
+ *
+ * EGL_LAST_SWAP_TIME_BRCM queries the time at which the previous
+ * eglSwapBuffers call acquired a free buffer, in microseconds from a
+ * wrapping 32 bit clock, for frame pacing feedback. */
+#define EGL_BRCM_present_pacing 1
+#define EGL_MAX_QUEUED_FRAMES_BRCM       0x99930C8
+#define EGL_LAST_SWAP_TIME_BRCM          0x99930C9
+
 #ifndef EGL_BRCM_sane_choose_config
 #define EGL_BRCM_sane_choose_config 1
 #endif
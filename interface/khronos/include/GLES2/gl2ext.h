@@ -1211,6 +1211,21 @@ typedef void (GL_APIENTRYP PFNGLENDTILINGQCOMPROC) (GLbitfield preserveMask);
 #define GL_BRCM_side_by_side_stero_hint 1
 #endif
 
+/* GL_BRCM_async_read_pixels
+   glReadPixelsAsyncBRCM issues a readback and returns immediately
+   (GL_FALSE if the read could not be queued); glReadPixelsAwaitBRCM
+   blocks until the read targeting the given buffer has landed. The
+   buffer and the current context must stay valid until the await. */
+#ifndef GL_BRCM_async_read_pixels
+#define GL_BRCM_async_read_pixels 1
+#ifdef GL_GLEXT_PROTOTYPES
+GL_APICALL GLboolean GL_APIENTRY glReadPixelsAsyncBRCM (GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, GLvoid *pixels);
+GL_APICALL GLboolean GL_APIENTRY glReadPixelsAwaitBRCM (GLvoid *pixels);
+#endif
+typedef GLboolean (GL_APIENTRYP PFNGLREADPIXELSASYNCBRCMPROC) (GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, GLvoid *pixels);
+typedef GLboolean (GL_APIENTRYP PFNGLREADPIXELSAWAITBRCMPROC) (GLvoid *pixels);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
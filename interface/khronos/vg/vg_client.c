@@ -60,6 +60,7 @@ length, 2kB should be fine for all functions.
 #include "interface/khronos/egl/egl_client_config.h"
 
 #include "interface/khronos/common/khrn_int_color.h"
+#include "interface/khronos/common/khrn_int_hash.h"
 #include "interface/khronos/common/khrn_int_math.h"
 #include "interface/khronos/common/khrn_int_util.h"
 
@@ -89,6 +90,7 @@ VG_CLIENT_SHARED_STATE_T *vg_client_shared_state_alloc(void)
 {
    VG_CLIENT_SHARED_STATE_T *shared_state;
    KHR_STATUS_T status;
+   VGuint i;
 
    shared_state = (VG_CLIENT_SHARED_STATE_T *)khrn_platform_malloc(sizeof(VG_CLIENT_SHARED_STATE_T), "VG_CLIENT_SHARED_STATE_T");
    if (!shared_state) {
@@ -110,6 +112,11 @@ VG_CLIENT_SHARED_STATE_T *vg_client_shared_state_alloc(void)
    shared_state->ref_count = 1;
    shared_state->stems_count = 0;
 
+   for (i = 0; i != VG_CLIENT_PATH_CACHE_ENTRIES; ++i) {
+      shared_state->path_cache[i].vg_handle = VG_INVALID_HANDLE;
+   }
+   shared_state->path_cache_next = 0;
+
    return shared_state;
 }
 
@@ -126,7 +133,18 @@ static void object_free_callback(KHRN_POINTER_MAP_T *pointer_map, uint32_t key,
 
 void vg_client_shared_state_free(VG_CLIENT_SHARED_STATE_T *shared_state)
 {
+   CLIENT_THREAD_STATE_T *thread = CLIENT_GET_THREAD_STATE();
+   VGuint i;
+
    vcos_assert(shared_state->ref_count == 0);
+   for (i = 0; i != VG_CLIENT_PATH_CACHE_ENTRIES; ++i) {
+      if (shared_state->path_cache[i].vg_handle != VG_INVALID_HANDLE) {
+         RPC_CALL1(vgDestroyPath_impl,
+                   thread,
+                   VGDESTROYPATH_ID,
+                   RPC_HANDLE(shared_state->path_cache[i].vg_handle));
+      }
+   }
    khrn_pointer_map_iterate(&shared_state->objects, object_free_callback, NULL);
    khrn_pointer_map_term(&shared_state->objects);
    platform_mutex_destroy(&shared_state->mutex);
@@ -2968,6 +2986,158 @@ VG_API_CALL void VG_API_ENTRY vgAppendPath(
              RPC_HANDLE(src_vg_handle));
 }
 
+#ifndef RPC_DIRECT
+
+/*
+   send path data to the server, splitting into multiple messages if
+   necessary to avoid overflowing the control buffer
+*/
+
+static void append_path_data_send(
+   CLIENT_THREAD_STATE_T *thread,
+   VGPath vg_handle, VGPathDatatype datatype,
+   VGint segments_count, const VGubyte *segments,
+   const void *coords)
+{
+   VGuint datatype_size = get_path_datatype_size(datatype);
+
+   while (segments_count != 0) {
+      #define MESSAGE_SIZE 20
+
+      VGuint size_max = rpc_send_ctrl_longest(thread, MESSAGE_SIZE + rpc_pad_ctrl(1) + rpc_pad_ctrl(6 * datatype_size)) - MESSAGE_SIZE; /* fit at least one segment */
+      VGint chunk_segments_count = 0;
+      VGuint chunk_coords_size = 0;
+      for (; chunk_segments_count != segments_count; ++chunk_segments_count) {
+         VGuint segment_coords_size = get_segment_coords_count(segments[chunk_segments_count] & ~VG_RELATIVE) * datatype_size;
+         if ((rpc_pad_ctrl(chunk_segments_count + 1) +
+            rpc_pad_ctrl(chunk_coords_size + segment_coords_size)) > size_max) {
+            /*
+               can't fit this segment in
+            */
+
+            break;
+         }
+         chunk_coords_size += segment_coords_size;
+      }
+
+      {
+         uint32_t message[] = {
+            VGAPPENDPATHDATA_ID,
+            RPC_HANDLE(vg_handle),
+            RPC_ENUM(datatype),
+            RPC_INT(chunk_segments_count),
+            RPC_UINT(chunk_coords_size) };
+         vcos_static_assert(sizeof(message) == MESSAGE_SIZE);
+
+         #undef MESSAGE_SIZE
+
+         rpc_send_ctrl_begin(thread, sizeof(message) + rpc_pad_ctrl(chunk_segments_count) + rpc_pad_ctrl(chunk_coords_size));
+         rpc_send_ctrl_write(thread, message, sizeof(message));
+         rpc_send_ctrl_write(thread, (uint32_t *)segments, chunk_segments_count);
+         rpc_send_ctrl_write(thread, (uint32_t *)coords, chunk_coords_size);
+         rpc_send_ctrl_end(thread);
+      }
+
+      segments_count -= chunk_segments_count;
+      segments += chunk_segments_count;
+      coords = (const uint8_t *)coords + chunk_coords_size;
+   }
+}
+
+/*
+   cache of the data from recent small vgAppendPathData calls. our UI
+   workloads append the same glyph outlines over and over again; the data is
+   uploaded once into a hidden server-side path and subsequent identical
+   appends just send a vgAppendPath referencing it, which is a small
+   fixed-size message. appending from a path with the same format, datatype,
+   scale and bias is equivalent to appending the raw data, so entries are
+   keyed on those as well as on the data itself
+*/
+
+static uint32_t path_cache_hash(
+   VGint segments_count, const VGubyte *segments,
+   VGuint coords_size, const void *coords)
+{
+   return khrn_hashlittle(coords, (int)coords_size,
+      khrn_hashlittle(segments, segments_count, 0xfa87d90b));
+}
+
+static VGHandle path_cache_lookup(
+   VG_CLIENT_SHARED_STATE_T *shared_state, uint32_t hash,
+   VGint format, VGPathDatatype datatype, VGfloat scale, VGfloat bias,
+   VGint segments_count, const VGubyte *segments,
+   VGuint coords_size, const void *coords)
+{
+   VGuint i;
+   for (i = 0; i != VG_CLIENT_PATH_CACHE_ENTRIES; ++i) {
+      VG_CLIENT_PATH_CACHE_ENTRY_T *entry = &shared_state->path_cache[i];
+      if ((entry->vg_handle != VG_INVALID_HANDLE) &&
+         (entry->hash == hash) &&
+         (entry->format == format) &&
+         (entry->datatype == datatype) &&
+         (entry->scale == scale) && (entry->bias == bias) &&
+         (entry->segments_count == (VGuint)segments_count) &&
+         (entry->coords_size == coords_size) &&
+         !memcmp(entry->data, segments, segments_count) &&
+         !memcmp(entry->data + segments_count, coords, coords_size)) {
+         return entry->vg_handle;
+      }
+   }
+   return VG_INVALID_HANDLE;
+}
+
+static void path_cache_insert(
+   VG_CLIENT_STATE_T *state, uint32_t hash,
+   VGint format, VGPathDatatype datatype, VGfloat scale, VGfloat bias,
+   VGint segments_count, const VGubyte *segments,
+   VGuint coords_size, const void *coords)
+{
+   CLIENT_THREAD_STATE_T *thread = CLIENT_GET_THREAD_STATE();
+   VG_CLIENT_SHARED_STATE_T *shared_state = state->shared_state;
+   VG_CLIENT_PATH_CACHE_ENTRY_T *entry;
+
+   VGHandle vg_handle = get_stem(state);
+   if (vg_handle == VG_INVALID_HANDLE) {
+      return; /* not an error -- we just don't cache */
+   }
+
+   RPC_CALL8(vgCreatePath_impl,
+             thread,
+             VGCREATEPATH_ID,
+             RPC_HANDLE(vg_handle),
+             RPC_INT(format),
+             RPC_ENUM(datatype),
+             RPC_FLOAT(scale), RPC_FLOAT(bias),
+             RPC_INT(segments_count),
+             RPC_INT(coords_size / get_path_datatype_size(datatype)),
+             RPC_BITFIELD(VG_PATH_CAPABILITY_APPEND_FROM));
+
+   append_path_data_send(thread, vg_handle, datatype, segments_count, segments, coords);
+
+   platform_mutex_acquire(&shared_state->mutex);
+   entry = &shared_state->path_cache[shared_state->path_cache_next];
+   shared_state->path_cache_next = (shared_state->path_cache_next + 1) % VG_CLIENT_PATH_CACHE_ENTRIES;
+   if (entry->vg_handle != VG_INVALID_HANDLE) {
+      RPC_CALL1(vgDestroyPath_impl,
+                thread,
+                VGDESTROYPATH_ID,
+                RPC_HANDLE(entry->vg_handle));
+   }
+   entry->vg_handle = vg_handle;
+   entry->hash = hash;
+   entry->format = format;
+   entry->datatype = datatype;
+   entry->scale = scale;
+   entry->bias = bias;
+   entry->segments_count = segments_count;
+   entry->coords_size = coords_size;
+   memcpy(entry->data, segments, segments_count);
+   memcpy(entry->data + segments_count, coords, coords_size);
+   platform_mutex_release(&shared_state->mutex);
+}
+
+#endif
+
 VG_API_CALL void VG_API_ENTRY vgAppendPathData(
    VGPath vg_handle,
    VGint segments_count, const VGubyte *segments,
@@ -2975,7 +3145,9 @@ VG_API_CALL void VG_API_ENTRY vgAppendPathData(
 {
    CLIENT_THREAD_STATE_T *thread = CLIENT_GET_THREAD_STATE();
    VG_CLIENT_PATH_T *path;
+   VGint format;
    VGPathDatatype datatype;
+   VGfloat scale, bias;
    VGuint datatype_size;
 
    VG_CLIENT_STATE_T *state = VG_GET_CLIENT_STATE(thread);
@@ -2992,7 +3164,10 @@ VG_API_CALL void VG_API_ENTRY vgAppendPathData(
       return;
    }
 
+   format = path->format;
    datatype = path->datatype;
+   scale = path->scale;
+   bias = path->bias;
 
    if ((segments_count <= 0) || !segments ||
       contains_illegal_segment(segments, segments_count) ||
@@ -3036,51 +3211,44 @@ VG_API_CALL void VG_API_ENTRY vgAppendPathData(
             coords_count * datatype_size, coords);
       }
    #else
-      /*
-         split into multiple calls if necessary to avoid overflowing control buffer
-      */
+      {
+         VGuint coords_size = 0;
+         VGint i;
+         for (i = 0; i != segments_count; ++i) {
+            coords_size += get_segment_coords_count(segments[i] & ~VG_RELATIVE) * datatype_size;
+         }
 
-      while (segments_count != 0) {
-         #define MESSAGE_SIZE 20
+         /*
+            small appends (i.e. glyph outlines) are cached, so repeated appends
+            of the same data just reference a previously uploaded path
+         */
 
-         VGuint size_max = rpc_send_ctrl_longest(thread, MESSAGE_SIZE + rpc_pad_ctrl(1) + rpc_pad_ctrl(6 * datatype_size)) - MESSAGE_SIZE; /* fit at least one segment */
-         VGint chunk_segments_count = 0;
-         VGuint chunk_coords_size = 0;
-         for (; chunk_segments_count != segments_count; ++chunk_segments_count) {
-            VGuint segment_coords_size = get_segment_coords_count(segments[chunk_segments_count] & ~VG_RELATIVE) * datatype_size;
-            if ((rpc_pad_ctrl(chunk_segments_count + 1) +
-               rpc_pad_ctrl(chunk_coords_size + segment_coords_size)) > size_max) {
-               /*
-                  can't fit this segment in
-               */
-
-               break;
-            }
-            chunk_coords_size += segment_coords_size;
-         }
+         if (((VGuint)segments_count + coords_size) <= VG_CLIENT_PATH_CACHE_DATA_MAX) {
+            VGHandle cached_vg_handle;
+            uint32_t hash = path_cache_hash(segments_count, segments, coords_size, coords);
 
-         {
-            uint32_t message[] = {
-               VGAPPENDPATHDATA_ID,
-               RPC_HANDLE(vg_handle),
-               RPC_ENUM(datatype),
-               RPC_INT(chunk_segments_count),
-               RPC_UINT(chunk_coords_size) };
-            vcos_static_assert(sizeof(message) == MESSAGE_SIZE);
+            platform_mutex_acquire(&state->shared_state->mutex);
+            cached_vg_handle = path_cache_lookup(state->shared_state, hash,
+               format, datatype, scale, bias,
+               segments_count, segments, coords_size, coords);
+            platform_mutex_release(&state->shared_state->mutex);
 
-            #undef MESSAGE_SIZE
-            CLIENT_THREAD_STATE_T *thread = CLIENT_GET_THREAD_STATE();
+            if (cached_vg_handle != VG_INVALID_HANDLE) {
+               RPC_CALL2(vgAppendPath_impl,
+                         thread,
+                         VGAPPENDPATH_ID,
+                         RPC_HANDLE(vg_handle),
+                         RPC_HANDLE(cached_vg_handle));
+               return;
+            }
 
-            rpc_send_ctrl_begin(thread, sizeof(message) + rpc_pad_ctrl(chunk_segments_count) + rpc_pad_ctrl(chunk_coords_size));
-            rpc_send_ctrl_write(thread, message, sizeof(message));
-            rpc_send_ctrl_write(thread, (uint32_t *)segments, chunk_segments_count);
-            rpc_send_ctrl_write(thread, (uint32_t *)coords, chunk_coords_size);
-            rpc_send_ctrl_end(thread);
+            append_path_data_send(thread, vg_handle, datatype, segments_count, segments, coords);
+            path_cache_insert(state, hash, format, datatype, scale, bias,
+               segments_count, segments, coords_size, coords);
+            return;
          }
 
-         segments_count -= chunk_segments_count;
-         segments += chunk_segments_count;
-         coords = (const uint8_t *)coords + chunk_coords_size;
+         append_path_data_send(thread, vg_handle, datatype, segments_count, segments, coords);
       }
    #endif
 }
@@ -5576,9 +5744,7 @@ VG_API_CALL VGImage VG_API_ENTRY vgCreateEGLImageTargetKHR(
       CLIENT_PROCESS_STATE_T *process = CLIENT_GET_PROCESS_STATE();
       uint64_t id;
 
-      CLIENT_LOCK();
-      id = process->inited ? khrn_global_image_map_lookup(&process->global_image_egl_images, (uint32_t)(uintptr_t)src_egl_handle) : 0;
-      CLIENT_UNLOCK();
+      id = process->inited ? khrn_global_image_map_lookup_fast(&process->global_image_egl_images, (uint32_t)(uintptr_t)src_egl_handle) : 0;
       if (!id) {
          set_error(VG_ILLEGAL_ARGUMENT_ERROR);
          return VG_INVALID_HANDLE;
@@ -54,6 +54,28 @@ shared state
 
 #define VG_CLIENT_STEMS_COUNT_MAX 64
 
+#define VG_CLIENT_PATH_CACHE_ENTRIES 16
+#define VG_CLIENT_PATH_CACHE_DATA_MAX 512
+
+/*
+   cached copy of the data from a previous small vgAppendPathData call,
+   together with the handle of a hidden server-side path holding that data.
+   repeated appends of the same data (i.e. glyph outlines) just reference the
+   hidden path instead of re-sending the data
+*/
+
+typedef struct {
+   VGHandle vg_handle; /* VG_INVALID_HANDLE when the entry is empty */
+   uint32_t hash;
+   VGint format;
+   VGPathDatatype datatype;
+   VGfloat scale;
+   VGfloat bias;
+   VGuint segments_count;
+   VGuint coords_size;
+   VGubyte data[VG_CLIENT_PATH_CACHE_DATA_MAX]; /* segments followed by coords */
+} VG_CLIENT_PATH_CACHE_ENTRY_T;
+
 typedef struct {
    VG_CLIENT_OBJECT_TYPE_T object_type;
 #if EGL_BRCM_global_image && EGL_KHR_image
@@ -116,6 +138,9 @@ typedef struct {
    VGuint stems_count;
    VGHandle stems[VG_CLIENT_STEMS_COUNT_MAX];
 
+   VG_CLIENT_PATH_CACHE_ENTRY_T path_cache[VG_CLIENT_PATH_CACHE_ENTRIES];
+   VGuint path_cache_next; /* next slot to recycle on a cache miss */
+
    KHRN_POINTER_MAP_T objects;
 } VG_CLIENT_SHARED_STATE_T;
 
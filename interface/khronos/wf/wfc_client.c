@@ -113,6 +113,7 @@ typedef struct
 
    uint32_t commit_count;           //!< Count of commits made
    WFC_SCENE_T committed_scene;     //!< Last committed scene
+   bool committed_scene_sent;       //!< True once committed_scene has been transmitted to the server.
 } WFC_CONTEXT_T;
 
 #define CONTEXT_POOL_COUNT 4
@@ -233,6 +234,8 @@ static void wfc_element_destroy(WFC_ELEMENT_T *element_ptr, void *unused);
 
 static void wfc_commit_iterator(WFC_ELEMENT_T *element_ptr, WFC_SCENE_T *scene);
 
+static bool wfc_scene_equal(const WFC_SCENE_T *scene_a, const WFC_SCENE_T *scene_b);
+
 static void wfc_set_error_with_location(WFC_DEVICE_T *device, WFCErrorCode error, const char *func, int line);
 
 static bool wfc_check_no_attribs(const WFCint *attribList);
@@ -563,18 +566,34 @@ WFC_API_CALL void WFC_APIENTRY
    if(vcos_verify((context_ptr != NULL) && (context_ptr->device_ptr == device_ptr)))
    {
       WFC_SCENE_T *scene = &context_ptr->committed_scene;
+      WFC_SCENE_T new_scene;
 
-      memset(scene, 0, sizeof(*scene));
-      // Store scene in committed_scene structure
-      memcpy(&scene->context, &context_ptr->dynamic_attributes, sizeof(WFC_CONTEXT_DYNAMIC_ATTRIB_T));
-      scene->element_count = 0;
-      scene->commit_count = context_ptr->commit_count++;
+      memset(&new_scene, 0, sizeof(new_scene));
+      // Build the scene from the current state
+      memcpy(&new_scene.context, &context_ptr->dynamic_attributes, sizeof(WFC_CONTEXT_DYNAMIC_ATTRIB_T));
+      new_scene.element_count = 0;
       wfc_link_iterate(&context_ptr->elements_in_scene,
-         (WFC_LINK_CALLBACK_T) wfc_commit_iterator, scene);
+         (WFC_LINK_CALLBACK_T) wfc_commit_iterator, &new_scene);
+
+      // Shadow the last scene handed to the server; a compositor typically
+      // commits every frame but rarely changes much, so an identical scene
+      // need not be stored or transmitted again.
+      if (!wfc_scene_equal(&new_scene, scene))
+      {
+         new_scene.commit_count = context_ptr->commit_count++;
+         memcpy(scene, &new_scene, sizeof(*scene));
+         context_ptr->committed_scene_sent = false;
+      }
 
       vcos_log_info("%s: dev 0x%X, ctx 0x%X commit %u", VCOS_FUNCTION, dev, ctx, context_ptr->committed_scene.commit_count);
 
-      if (context_ptr->active)
+      if (context_ptr->active && context_ptr->committed_scene_sent)
+      {
+         // No delta since the last transmitted scene; the server already
+         // holds an identical copy, so the commit can be skipped.
+         vcos_log_info("%s: dev 0x%X, ctx 0x%X unchanged, commit skipped", VCOS_FUNCTION, dev, ctx);
+      }
+      else if (context_ptr->active)
       {
          uint32_t commit_flags = WFC_SERVER_COMMIT_COMPOSE;
 
@@ -621,6 +640,10 @@ WFC_API_CALL void WFC_APIENTRY
             vcos_log_info("%s: failed to compose scene: %d", VCOS_FUNCTION, status);
             wfc_set_error(device_ptr, WFC_ERROR_BUSY);
          }
+         else
+         {
+            context_ptr->committed_scene_sent = true;
+         }
       }
    } // if
    else
@@ -1704,6 +1727,10 @@ WFC_API_CALL void WFC_APIENTRY
       {
          wfc_set_error(device_ptr, WFC_ERROR_BAD_HANDLE);
       }
+      else
+      {
+         context_ptr->committed_scene_sent = true;
+      }
    } //if
    else
       {wfc_set_error(device_ptr, WFC_ERROR_BAD_HANDLE);}
@@ -1809,6 +1836,10 @@ WFC_API_CALL void WFC_APIENTRY
             vcos_log_info("%s: failed to compose scene: %d", VCOS_FUNCTION, status);
             wfc_set_error(device_ptr, WFC_ERROR_BUSY);
          }
+         else
+         {
+            context_ptr->committed_scene_sent = true;
+         }
       } // if
       else
          {wfc_set_error(device_ptr, WFC_ERROR_UNSUPPORTED);}
@@ -1854,7 +1885,7 @@ WFC_API_CALL void WFC_APIENTRY
       /* Set error as WFC_ERROR_ILLEGAL_ARGUMENT
          - if dpy is not a valid EGLDisplay
          - if sync is not a valid sync object
-         - if sync�s EGL_SYNC_TYPE_KHR is not EGL_SYNC_REUSABLE_KHR
+         - if sync�s EGL_SYNC_TYPE_KHR is not EGL_SYNC_REUSABLE_KHR
        */
    } // if
    else
@@ -2135,6 +2166,7 @@ static WFC_CONTEXT_T *wfc_context_create
          wfc_link_init_empty(&context_ptr->elements_not_in_scene);
          wfc_link_init_empty(&context_ptr->elements_in_scene);
          context_ptr->active = false;
+         context_ptr->committed_scene_sent = false;
 
          context_ptr->dynamic_attributes = ctx_dyn_attrib_default;
          context_ptr->static_attributes.type = context_type;
@@ -2389,6 +2421,17 @@ static void wfc_commit_iterator(WFC_ELEMENT_T *element_ptr, WFC_SCENE_T *scene)
    memcpy(&scene->elements[scene->element_count++], &element_ptr->attributes, sizeof(WFC_ELEMENT_ATTRIB_T));
 } // wfc_commit_iterator()
 
+//------------------------------------------------------------------------------
+
+static bool wfc_scene_equal(const WFC_SCENE_T *scene_a, const WFC_SCENE_T *scene_b)
+//! Compare two scenes, ignoring their commit counts.
+{
+   return (memcmp(&scene_a->context, &scene_b->context, sizeof(scene_a->context)) == 0)
+      && (scene_a->element_count == scene_b->element_count)
+      && (memcmp(scene_a->elements, scene_b->elements,
+            scene_a->element_count * sizeof(scene_a->elements[0])) == 0);
+} // wfc_scene_equal()
+
 //==============================================================================
 
 static void wfc_set_error_with_location(WFC_DEVICE_T *device, WFCErrorCode error, const char *func, int line)
@@ -33,11 +33,322 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #define AGGREGATOR_PREFIX "aggregator"
 #define AGGREGATOR_PIPELINE_PREFIX "pipeline"
+#define AGGREGATOR_FUNNEL_PREFIX "funnel"
+
+#define AGGREGATOR_FUNNEL_INPUT_PORTS_NUM 4
 
 typedef struct MMAL_GRAPH_USERDATA_T {
     int dummy;
 } MMAL_GRAPH_USERDATA_T;
 
+/*****************************************************************************/
+typedef struct MMAL_COMPONENT_MODULE_T
+{
+   MMAL_BOOL_T error;   /**< Error state */
+
+} MMAL_COMPONENT_MODULE_T;
+
+typedef struct MMAL_PORT_MODULE_T
+{
+   MMAL_QUEUE_T *queue; /**< queue for the buffers sent to the ports */
+   uint32_t priority;   /**< inputs with a higher priority are dequeued first */
+
+} MMAL_PORT_MODULE_T;
+
+/*****************************************************************************/
+
+/** Destroy a previously created funnel component */
+static MMAL_STATUS_T funnel_component_destroy(MMAL_COMPONENT_T *component)
+{
+   unsigned int i;
+
+   for(i = 0; i < component->input_num; i++)
+      if(component->input[i]->priv->module->queue)
+         mmal_queue_destroy(component->input[i]->priv->module->queue);
+   if(component->input_num)
+      mmal_ports_free(component->input, component->input_num);
+
+   for(i = 0; i < component->output_num; i++)
+      if(component->output[i]->priv->module->queue)
+         mmal_queue_destroy(component->output[i]->priv->module->queue);
+   if(component->output_num)
+      mmal_ports_free(component->output, component->output_num);
+
+   vcos_free(component->priv->module);
+   return MMAL_SUCCESS;
+}
+
+/** Enable processing on a port */
+static MMAL_STATUS_T funnel_port_enable(MMAL_PORT_T *port, MMAL_PORT_BH_CB_T cb)
+{
+   MMAL_PARAM_UNUSED(port);
+   MMAL_PARAM_UNUSED(cb);
+   return MMAL_SUCCESS;
+}
+
+/** Flush a port */
+static MMAL_STATUS_T funnel_port_flush(MMAL_PORT_T *port)
+{
+   MMAL_PORT_MODULE_T *port_module = port->priv->module;
+   MMAL_BUFFER_HEADER_T *buffer;
+
+   /* Flush buffers that our component is holding on to */
+   buffer = mmal_queue_get(port_module->queue);
+   while(buffer)
+   {
+      mmal_port_buffer_header_callback(port, buffer);
+      buffer = mmal_queue_get(port_module->queue);
+   }
+
+   return MMAL_SUCCESS;
+}
+
+/** Disable processing on a port */
+static MMAL_STATUS_T funnel_port_disable(MMAL_PORT_T *port)
+{
+   /* We just need to flush our internal queue */
+   return funnel_port_flush(port);
+}
+
+/** Select the next input port to be serviced.
+ * Inputs with buffers pending are serviced highest priority first so that
+ * low-latency streams are not stuck behind bulkier ones, with the port
+ * index used as a tie-breaker. */
+static MMAL_PORT_T *funnel_select_input(MMAL_COMPONENT_T *component)
+{
+   MMAL_PORT_T *selected = NULL;
+   unsigned int i;
+
+   for (i = 0; i < component->input_num; i++)
+   {
+      MMAL_PORT_T *in_port = component->input[i];
+
+      if (!mmal_queue_length(in_port->priv->module->queue))
+         continue;
+
+      if (!selected ||
+          in_port->priv->module->priority > selected->priv->module->priority)
+         selected = in_port;
+   }
+
+   return selected;
+}
+
+/** Forward as many pending input buffers as possible to the output */
+static void funnel_component_process(MMAL_COMPONENT_T *component)
+{
+   MMAL_COMPONENT_MODULE_T *module = component->priv->module;
+   MMAL_PORT_T *out_port = component->output[0];
+   MMAL_BUFFER_HEADER_T *in, *out;
+   MMAL_PORT_T *in_port;
+   MMAL_STATUS_T status;
+
+   while (!module->error)
+   {
+      in_port = funnel_select_input(component);
+      if (!in_port)
+         return; /* Nothing to do */
+
+      in = mmal_queue_get(in_port->priv->module->queue);
+      if (!in)
+         return;
+
+      /* Events are forwarded as is to the output */
+      if (in->cmd)
+      {
+         status = mmal_event_forward(in, out_port);
+         if (status != MMAL_SUCCESS)
+            LOG_ERROR("unable to forward event %4.4s", (char *)&in->cmd);
+         in->length = 0;
+         mmal_port_buffer_header_callback(in_port, in);
+         continue;
+      }
+
+      /* Need an output buffer to be able to go any further */
+      out = mmal_queue_get(out_port->priv->module->queue);
+      if (!out)
+      {
+         mmal_queue_put_back(in_port->priv->module->queue, in);
+         return;
+      }
+
+      if (out_port->capabilities & MMAL_PORT_CAPABILITY_PASSTHROUGH)
+      {
+         /* Forward the payload by reference instead of copying it */
+         status = mmal_buffer_header_replicate(out, in);
+      }
+      else
+      {
+         /* Make a full copy of the input payload */
+         status = MMAL_SUCCESS;
+         if (out->alloc_size < in->length)
+         {
+            LOG_ERROR("output buffer too small");
+            status = MMAL_EINVAL;
+         }
+         else
+         {
+            mmal_buffer_header_mem_lock(out);
+            mmal_buffer_header_mem_lock(in);
+            memcpy(out->data, in->data + in->offset, in->length);
+            mmal_buffer_header_mem_unlock(in);
+            mmal_buffer_header_mem_unlock(out);
+            out->length     = in->length;
+            out->offset     = 0;
+            out->flags      = in->flags;
+            out->pts        = in->pts;
+            out->dts        = in->dts;
+            *out->type      = *in->type;
+         }
+      }
+
+      if (status != MMAL_SUCCESS)
+      {
+         mmal_queue_put_back(out_port->priv->module->queue, out);
+         mmal_queue_put_back(in_port->priv->module->queue, in);
+         if (mmal_event_error_send(component, status) != MMAL_SUCCESS)
+            LOG_ERROR("unable to send an error event buffer");
+         module->error = 1;
+         return;
+      }
+
+      /* Finished with the input buffer, so return it */
+      in->length = 0;
+      mmal_port_buffer_header_callback(in_port, in);
+
+      mmal_port_buffer_header_callback(out_port, out);
+   }
+}
+
+/** Send a buffer header to a port */
+static MMAL_STATUS_T funnel_port_send(MMAL_PORT_T *port, MMAL_BUFFER_HEADER_T *buffer)
+{
+   mmal_queue_put(port->priv->module->queue, buffer);
+   funnel_component_process(port->component);
+   return MMAL_SUCCESS;
+}
+
+/** Set format on a port */
+static MMAL_STATUS_T funnel_port_format_commit(MMAL_PORT_T *port)
+{
+   MMAL_PORT_T *out_port = port->component->output[0];
+
+   if (port->type == MMAL_PORT_TYPE_OUTPUT)
+      return MMAL_SUCCESS;
+
+   /* Inputs are forwarded untouched so we just mirror the format on the
+    * output port while it is not in use */
+   if (!out_port->is_enabled)
+      return mmal_format_full_copy(out_port->format, port->format);
+
+   if (mmal_format_compare(port->format, out_port->format))
+      LOG_DEBUG("input port format different from output port");
+
+   return MMAL_SUCCESS;
+}
+
+static MMAL_STATUS_T funnel_port_parameter_set(MMAL_PORT_T *port, const MMAL_PARAMETER_HEADER_T *param)
+{
+   MMAL_PORT_T *out_port = port->component->output[0];
+
+   switch (param->id)
+   {
+   case MMAL_PARAMETER_BUFFER_REQUIREMENTS:
+      {
+         /* Propagate the requirements to this port and the output port */
+         const MMAL_PARAMETER_BUFFER_REQUIREMENTS_T *req = (const MMAL_PARAMETER_BUFFER_REQUIREMENTS_T *)param;
+
+         port->buffer_num_min = MMAL_MAX(port->buffer_num_min, req->buffer_num_min);
+         port->buffer_num_recommended = MMAL_MAX(port->buffer_num_recommended, req->buffer_num_recommended);
+         port->buffer_size_min = MMAL_MAX(port->buffer_size_min, req->buffer_size_min);
+         port->buffer_size_recommended = MMAL_MAX(port->buffer_size_recommended, req->buffer_size_recommended);
+         out_port->buffer_num_min = MMAL_MAX(out_port->buffer_num_min, req->buffer_num_min);
+         out_port->buffer_num_recommended = MMAL_MAX(out_port->buffer_num_recommended, req->buffer_num_recommended);
+         out_port->buffer_size_min = MMAL_MAX(out_port->buffer_size_min, req->buffer_size_min);
+         out_port->buffer_size_recommended = MMAL_MAX(out_port->buffer_size_recommended, req->buffer_size_recommended);
+      }
+      return MMAL_SUCCESS;
+
+   case MMAL_PARAMETER_PORT_PRIORITY:
+      if (port->type != MMAL_PORT_TYPE_INPUT ||
+          param->size < sizeof(MMAL_PARAMETER_UINT32_T))
+         return MMAL_EINVAL;
+      port->priv->module->priority = ((const MMAL_PARAMETER_UINT32_T *)param)->value;
+      return MMAL_SUCCESS;
+
+   default:
+      return MMAL_ENOSYS;
+   }
+}
+
+/** Create an instance of the funnel component */
+static MMAL_STATUS_T mmal_component_create_aggregator_funnel(const char *name, MMAL_COMPONENT_T *component)
+{
+   MMAL_COMPONENT_MODULE_T *module;
+   MMAL_STATUS_T status = MMAL_ENOMEM;
+   int disable_passthrough = 0;
+   unsigned int i;
+
+   /* Allocate the context for our module */
+   component->priv->module = module = vcos_calloc(1, sizeof(*module), "mmal module");
+   if (!module)
+      return MMAL_ENOMEM;
+
+   component->priv->pf_destroy = funnel_component_destroy;
+
+   /* Allocate and initialise all the ports for this component */
+   component->input = mmal_ports_alloc(component, AGGREGATOR_FUNNEL_INPUT_PORTS_NUM,
+                                       MMAL_PORT_TYPE_INPUT, sizeof(MMAL_PORT_MODULE_T));
+   if (!component->input)
+      goto error;
+   component->input_num = AGGREGATOR_FUNNEL_INPUT_PORTS_NUM;
+   for (i = 0; i < component->input_num; i++)
+   {
+      component->input[i]->priv->pf_enable = funnel_port_enable;
+      component->input[i]->priv->pf_disable = funnel_port_disable;
+      component->input[i]->priv->pf_flush = funnel_port_flush;
+      component->input[i]->priv->pf_send = funnel_port_send;
+      component->input[i]->priv->pf_set_format = funnel_port_format_commit;
+      component->input[i]->priv->pf_parameter_set = funnel_port_parameter_set;
+      component->input[i]->buffer_num_min = 1;
+      component->input[i]->buffer_num_recommended = 0;
+      component->input[i]->priv->module->queue = mmal_queue_create();
+      if (!component->input[i]->priv->module->queue)
+         goto error;
+   }
+
+   /* Override passthrough behaviour */
+   if (strstr(name, ".copy"))
+   {
+      LOG_TRACE("disable passthrough on output port");
+      disable_passthrough = 1;
+   }
+
+   component->output = mmal_ports_alloc(component, 1, MMAL_PORT_TYPE_OUTPUT,
+                                        sizeof(MMAL_PORT_MODULE_T));
+   if (!component->output)
+      goto error;
+   component->output_num = 1;
+   component->output[0]->priv->pf_enable = funnel_port_enable;
+   component->output[0]->priv->pf_disable = funnel_port_disable;
+   component->output[0]->priv->pf_flush = funnel_port_flush;
+   component->output[0]->priv->pf_send = funnel_port_send;
+   component->output[0]->priv->pf_set_format = funnel_port_format_commit;
+   component->output[0]->priv->pf_parameter_set = funnel_port_parameter_set;
+   component->output[0]->buffer_num_min = 1;
+   component->output[0]->buffer_num_recommended = 0;
+   component->output[0]->capabilities = disable_passthrough ? 0 : MMAL_PORT_CAPABILITY_PASSTHROUGH;
+   component->output[0]->priv->module->queue = mmal_queue_create();
+   if (!component->output[0]->priv->module->queue)
+      goto error;
+
+   return MMAL_SUCCESS;
+
+ error:
+   funnel_component_destroy(component);
+   return status;
+}
+
 static MMAL_STATUS_T aggregator_parameter_set(MMAL_GRAPH_T *graph,
    MMAL_PORT_T *port, const MMAL_PARAMETER_HEADER_T *param)
 {
@@ -177,6 +488,8 @@ static MMAL_STATUS_T mmal_component_create_aggregator(const char *name, MMAL_COM
    if (!strncmp(stripped, AGGREGATOR_PIPELINE_PREFIX ":", sizeof(AGGREGATOR_PIPELINE_PREFIX)))
       return mmal_component_create_aggregator_pipeline(name,
          stripped + sizeof(AGGREGATOR_PIPELINE_PREFIX), component);
+   if (!strncmp(stripped, AGGREGATOR_FUNNEL_PREFIX, sizeof(AGGREGATOR_FUNNEL_PREFIX) - 1))
+      return mmal_component_create_aggregator_funnel(name, component);
 
    return MMAL_ENOSYS;
 }
@@ -39,12 +39,41 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define DEFAULT_WIDTH 320
 #define DEFAULT_HEIGHT 240
 
+/** Default PRNG seed, making the generated content reproducible from run to run */
+#define DEFAULT_SEED 0x41434147
+
+/** Maximum time the processing loop will sleep for (milliseconds) */
+#define SLEEP_TIME_MAX 10
+
+#define ARTIFICIAL_CAMERA_FRAME_MAGIC MMAL_FOURCC('A','C','A','M')
+
+/** Measurement header embedded at the start of every generated frame.
+ * Downstream test components can locate it through the magic value, verify
+ * the payload against the checksum and compute their latency from the
+ * timestamp, which is the wall-time at which the frame was generated. */
+typedef struct ARTIFICIAL_CAMERA_FRAME_HEADER_T
+{
+   uint32_t magic;    /**< set to \ref ARTIFICIAL_CAMERA_FRAME_MAGIC */
+   uint32_t sequence; /**< sequence number of the frame */
+   uint32_t pts_low;  /**< low 32 bits of the frame timestamp (microseconds) */
+   uint32_t pts_high; /**< high 32 bits of the frame timestamp (microseconds) */
+   uint32_t checksum; /**< 32-bit sum of the payload words following the header */
+
+} ARTIFICIAL_CAMERA_FRAME_HEADER_T;
+
 /*****************************************************************************/
 typedef struct MMAL_PORT_MODULE_T
 {
    MMAL_BUFFER_HEADER_VIDEO_SPECIFIC_T frame;
    unsigned int frame_size;
-   int count;
+
+   uint32_t sequence;       /**< sequence number of the next generated frame */
+   uint32_t seed;           /**< seed making the frame content deterministic */
+   uint32_t jitter_state;   /**< PRNG state used for frame period jitter */
+   int64_t period;          /**< average frame period in microseconds, 0 when
+                                 free-running (one frame per available buffer) */
+   int64_t jitter;          /**< maximum deviation from the average period (microseconds) */
+   int64_t next_frame_time; /**< wall-time at which the next frame is due */
 
    MMAL_QUEUE_T *queue;
 
@@ -56,11 +85,61 @@ typedef struct MMAL_COMPONENT_MODULE_T
 
 } MMAL_COMPONENT_MODULE_T;
 
+/*****************************************************************************/
+/* Small xorshift PRNG, deterministic for a given seed */
+static uint32_t artificial_camera_prng(uint32_t *state)
+{
+   uint32_t x = *state;
+   x ^= x << 13;
+   x ^= x >> 17;
+   x ^= x << 5;
+   return *state = x;
+}
+
+/* Convert a frame rate to a frame period in microseconds */
+static int64_t artificial_camera_frame_period(MMAL_RATIONAL_T rate)
+{
+   if (!rate.num || !rate.den)
+      return 0;
+   return INT64_C(1000000) * rate.den / rate.num;
+}
+
+/* Fill a frame with deterministic pseudo-random content and embed the
+ * measurement header. The content is different for every frame so components
+ * downstream cannot get away with caching or eliding copies of the payload. */
+static void artificial_camera_fill_frame(MMAL_PORT_MODULE_T *port_module,
+   MMAL_BUFFER_HEADER_T *buffer, int64_t pts)
+{
+   ARTIFICIAL_CAMERA_FRAME_HEADER_T *header =
+      (ARTIFICIAL_CAMERA_FRAME_HEADER_T *)buffer->data;
+   uint32_t *word = (uint32_t *)(buffer->data + sizeof(*header));
+   /* Frame dimensions are rounded up to multiples of 32x16 so the frame size
+    * is always a whole number of words */
+   uint32_t words = (port_module->frame_size - sizeof(*header)) / sizeof(*word);
+   uint32_t state = port_module->seed ^ (port_module->sequence * UINT32_C(2654435761));
+   uint32_t checksum = 0, value;
+
+   while (words--)
+   {
+      value = artificial_camera_prng(&state);
+      checksum += value;
+      *word++ = value;
+   }
+
+   header->magic = ARTIFICIAL_CAMERA_FRAME_MAGIC;
+   header->sequence = port_module->sequence++;
+   header->pts_low = (uint32_t)pts;
+   header->pts_high = (uint32_t)(pts >> 32);
+   header->checksum = checksum;
+}
+
 /*****************************************************************************/
 static void artificial_camera_do_processing(MMAL_COMPONENT_T *component)
 {
    MMAL_COMPONENT_MODULE_T *module = component->priv->module;
    MMAL_BUFFER_HEADER_T *buffer;
+   int64_t now = vcos_getmicrosecs64();
+   int64_t sleep_time = SLEEP_TIME_MAX * 1000;
    unsigned int i;
 
    if (module->status != MMAL_SUCCESS)
@@ -70,18 +149,31 @@ static void artificial_camera_do_processing(MMAL_COMPONENT_T *component)
    for (i = 0; i < component->output_num; i++)
    {
       MMAL_PORT_T *port = component->output[i];
+      MMAL_PORT_MODULE_T *port_module = port->priv->module;
+
+      /* Frame pacing. A port with a frame period only emits when a frame is
+       * due; a free-running port emits a frame per available buffer. */
+      if (port_module->period)
+      {
+         if (now < port_module->next_frame_time)
+         {
+            if (port_module->next_frame_time - now < sleep_time)
+               sleep_time = port_module->next_frame_time - now;
+            continue;
+         }
+      }
 
-      buffer = mmal_queue_get(port->priv->module->queue);
+      buffer = mmal_queue_get(port_module->queue);
       if (!buffer)
          continue;
 
       /* Sanity check the buffer size */
-      if (buffer->alloc_size < port->priv->module->frame_size)
+      if (buffer->alloc_size < port_module->frame_size)
       {
          LOG_ERROR("buffer too small (%i/%i)",
-                   buffer->alloc_size, port->priv->module->frame_size);
+                   buffer->alloc_size, port_module->frame_size);
          module->status = MMAL_EINVAL;
-         mmal_queue_put_back(port->priv->module->queue, buffer);
+         mmal_queue_put_back(port_module->queue, buffer);
          mmal_event_error_send(component, module->status);
          return;
       }
@@ -89,26 +181,38 @@ static void artificial_camera_do_processing(MMAL_COMPONENT_T *component)
       if (module->status != MMAL_SUCCESS)
       {
          LOG_ERROR("invalid buffer (%p, %p)", buffer, buffer->data);
-         mmal_queue_put_back(port->priv->module->queue, buffer);
+         mmal_queue_put_back(port_module->queue, buffer);
          mmal_event_error_send(component, module->status);
          return;
       }
 
       buffer->offset = 0;
-      buffer->length = port->priv->module->frame_size;
-      buffer->type->video = port->priv->module->frame;
+      buffer->length = port_module->frame_size;
+      buffer->type->video = port_module->frame;
+      buffer->pts = buffer->dts = now;
 
-      memset(buffer->data, 0xff, buffer->length);
-      if (buffer->type->video.planes > 1)
-         memset(buffer->data + buffer->type->video.offset[1],
-                0x7f - port->priv->module->count++,
-                buffer->length - buffer->type->video.offset[1]);
+      artificial_camera_fill_frame(port_module, buffer, now);
 
       mmal_buffer_header_mem_unlock(buffer);
       mmal_port_buffer_header_callback(port, buffer);
+
+      /* Schedule the next frame, applying jitter uniformly distributed in
+       * [-jitter, jitter] around the nominal period */
+      if (port_module->period)
+      {
+         int64_t period = port_module->period;
+         if (port_module->jitter)
+            period += artificial_camera_prng(&port_module->jitter_state) %
+                      (2 * port_module->jitter + 1) - port_module->jitter;
+         port_module->next_frame_time += period;
+         /* Don't try to catch up when held back by buffer starvation */
+         if (port_module->next_frame_time < now)
+            port_module->next_frame_time = now + period;
+      }
    }
 
-   vcos_sleep(10); /* Make sure we don't peg all the resources */
+   /* Make sure we don't peg all the resources */
+   vcos_sleep(MMAL_MAX((uint32_t)(sleep_time / 1000), 1));
 }
 
 /** Destroy a previously created component */
@@ -200,15 +304,42 @@ static MMAL_STATUS_T artificial_camera_port_format_commit(MMAL_PORT_T *port)
    }
 
    port->buffer_size_min = port->buffer_size_recommended = port_module->frame_size;
+   port_module->period = artificial_camera_frame_period(port->format->es->video.frame_rate);
+   port_module->jitter = 0;
+   port_module->next_frame_time = vcos_getmicrosecs64();
    return MMAL_SUCCESS;
 }
 
 /** Set parameter on a port */
 static MMAL_STATUS_T artificial_port_parameter_set(MMAL_PORT_T *port, const MMAL_PARAMETER_HEADER_T *param)
 {
-   MMAL_PARAM_UNUSED(port);
+   MMAL_PORT_MODULE_T *port_module = port->priv->module;
+
    switch (param->id)
    {
+   case MMAL_PARAMETER_FRAME_RATE:
+   case MMAL_PARAMETER_VIDEO_FRAME_RATE:
+      {
+         const MMAL_PARAMETER_FRAME_RATE_T *p = (const MMAL_PARAMETER_FRAME_RATE_T *)param;
+         port->format->es->video.frame_rate = p->frame_rate;
+         port_module->period = artificial_camera_frame_period(p->frame_rate);
+         port_module->jitter = 0;
+         port_module->next_frame_time = vcos_getmicrosecs64();
+      }
+      return MMAL_SUCCESS;
+   case MMAL_PARAMETER_FPS_RANGE:
+      /* The frame period is jittered uniformly across the given range */
+      {
+         const MMAL_PARAMETER_FPS_RANGE_T *p = (const MMAL_PARAMETER_FPS_RANGE_T *)param;
+         int64_t period_min = artificial_camera_frame_period(p->fps_high);
+         int64_t period_max = artificial_camera_frame_period(p->fps_low);
+         if (!period_min || !period_max || period_min > period_max)
+            return MMAL_EINVAL;
+         port_module->period = (period_min + period_max) / 2;
+         port_module->jitter = (period_max - period_min) / 2;
+         port_module->next_frame_time = vcos_getmicrosecs64();
+      }
+      return MMAL_SUCCESS;
    default:
       return MMAL_ENOSYS;
    }
@@ -217,9 +348,17 @@ static MMAL_STATUS_T artificial_port_parameter_set(MMAL_PORT_T *port, const MMAL
 /** Get parameter on a port */
 static MMAL_STATUS_T artificial_port_parameter_get(MMAL_PORT_T *port, MMAL_PARAMETER_HEADER_T *param)
 {
-   MMAL_PARAM_UNUSED(port);
    switch (param->id)
    {
+   case MMAL_PARAMETER_FRAME_RATE:
+   case MMAL_PARAMETER_VIDEO_FRAME_RATE:
+      {
+         MMAL_PARAMETER_FRAME_RATE_T *p = (MMAL_PARAMETER_FRAME_RATE_T *)param;
+         if (param->size < sizeof(*p))
+            return MMAL_EINVAL;
+         p->frame_rate = port->format->es->video.frame_rate;
+      }
+      return MMAL_SUCCESS;
    default:
       return MMAL_ENOSYS;
    }
@@ -262,6 +401,8 @@ static MMAL_STATUS_T mmal_component_create_artificial_camera(const char *name, M
       component->output[i]->format->es->video.height = DEFAULT_HEIGHT;
       component->output[i]->buffer_num_min = OUTPUT_MIN_BUFFER_NUM;
       component->output[i]->buffer_num_recommended = OUTPUT_RECOMMENDED_BUFFER_NUM;
+      component->output[i]->priv->module->seed = DEFAULT_SEED + i;
+      component->output[i]->priv->module->jitter_state = DEFAULT_SEED ^ ~i;
       artificial_camera_port_format_commit(component->output[i]);
 
       component->output[i]->priv->module->queue = mmal_queue_create();
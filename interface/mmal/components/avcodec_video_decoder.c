@@ -54,6 +54,13 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define DEFAULT_WIDTH 320
 #define DEFAULT_HEIGHT 240
 
+/* An unreasonably large thread count is more likely a client error */
+#define DECODE_THREADS_MAX 16
+
+/* Maximum number of output buffers the codec can hold on to for reference
+ * frames when decoding directly into output buffer payloads */
+#define DIRECT_RENDERING_HELD_MAX 34
+
 static uint32_t encoding_to_codecid(uint32_t encoding);
 static uint32_t pixfmt_to_encoding(enum PixelFormat);
 
@@ -82,6 +89,21 @@ typedef struct MMAL_COMPONENT_MODULE_T
    int frame_size;
    MMAL_BOOL_T output_needs_configuring;
 
+   uint32_t thread_count; /**< number of decoding threads, 0 lets avcodec decide */
+
+   MMAL_BOOL_T direct_rendering; /**< codec supports decoding into user memory */
+   MMAL_BOOL_T layout_supports_dr; /**< current output layout is aligned well
+                                        enough for direct rendering */
+
+   /** Output buffers the codec is currently decoding into or using as
+    * reference frames */
+   struct
+   {
+      MMAL_BUFFER_HEADER_T *buffer;
+      MMAL_BOOL_T sent; /**< buffer has been sent to the client */
+   } held[DIRECT_RENDERING_HELD_MAX];
+   unsigned int held_num;
+
 } MMAL_COMPONENT_MODULE_T;
 
 /** Destroy a previously created component */
@@ -106,6 +128,114 @@ static MMAL_STATUS_T avcodec_component_destroy(MMAL_COMPONENT_T *component)
    return MMAL_SUCCESS;
 }
 
+/*****************************************************************************/
+/* Direct rendering support. When the codec supports it, we get it to decode
+ * straight into the payload of our output buffers instead of its own internal
+ * frame store, which saves a full-frame copy per picture. The codec keeps hold
+ * of the buffers it uses as reference frames so we track which buffers are
+ * still in its hands and only recycle them once it has released them. */
+
+/** Find an output buffer in the list of buffers held by the codec */
+static int avcodec_dr_held_find(MMAL_COMPONENT_MODULE_T *module, MMAL_BUFFER_HEADER_T *buffer)
+{
+   unsigned int i;
+
+   for (i = 0; i < module->held_num; i++)
+      if (module->held[i].buffer == buffer)
+         return (int)i;
+   return -1;
+}
+
+/** Get an output buffer suitable for the codec to decode into */
+static MMAL_BUFFER_HEADER_T *avcodec_dr_buffer_get(MMAL_COMPONENT_MODULE_T *module)
+{
+   MMAL_BUFFER_HEADER_T *buffer;
+   unsigned int count = mmal_queue_length(module->queue_out);
+
+   /* Skip buffers the codec still references and buffers which do not
+    * satisfy the size / alignment requirements of the current layout */
+   while (count--)
+   {
+      buffer = mmal_queue_get(module->queue_out);
+      if (!buffer)
+         break;
+      if (avcodec_dr_held_find(module, buffer) < 0 &&
+          buffer->alloc_size >= (uint32_t)module->frame_size &&
+          !((uintptr_t)buffer->data & 15))
+         return buffer;
+      mmal_queue_put(module->queue_out, buffer);
+   }
+   return NULL;
+}
+
+/** Buffer allocation callback for the codec */
+static int avcodec_video_get_buffer(AVCodecContext *codec_context, AVFrame *frame)
+{
+   MMAL_COMPONENT_T *component = (MMAL_COMPONENT_T *)codec_context->opaque;
+   MMAL_COMPONENT_MODULE_T *module = component->priv->module;
+   MMAL_BUFFER_HEADER_T *buffer;
+   unsigned int i;
+
+   /* Fall back on the codec's own allocator whenever direct rendering
+    * is not possible for this frame */
+   if (!module->layout_supports_dr ||
+       codec_context->width != module->width ||
+       codec_context->height != module->height ||
+       codec_context->pix_fmt != module->pix_fmt ||
+       module->held_num == DIRECT_RENDERING_HELD_MAX ||
+       !(buffer = avcodec_dr_buffer_get(module)))
+      return avcodec_default_get_buffer(codec_context, frame);
+
+   for (i = 0; i < 4; i++)
+   {
+      frame->data[i] = module->layout.data[i] ?
+         buffer->data + (size_t)module->layout.data[i] : NULL;
+      frame->base[i] = frame->data[i];
+      frame->linesize[i] = module->layout.linesize[i];
+   }
+   frame->opaque = buffer;
+   frame->type = FF_BUFFER_TYPE_USER;
+   frame->reordered_opaque = codec_context->reordered_opaque;
+#if LIBAVCODEC_VERSION_MAJOR < 54
+   frame->age = 256*256*256*64;
+#endif
+
+   module->held[module->held_num].buffer = buffer;
+   module->held[module->held_num].sent = MMAL_FALSE;
+   module->held_num++;
+   return 0;
+}
+
+/** Buffer release callback for the codec */
+static void avcodec_video_release_buffer(AVCodecContext *codec_context, AVFrame *frame)
+{
+   MMAL_COMPONENT_T *component = (MMAL_COMPONENT_T *)codec_context->opaque;
+   MMAL_COMPONENT_MODULE_T *module = component->priv->module;
+   MMAL_BUFFER_HEADER_T *buffer = (MMAL_BUFFER_HEADER_T *)frame->opaque;
+   unsigned int i;
+   int index;
+
+   if (frame->type != FF_BUFFER_TYPE_USER)
+   {
+      avcodec_default_release_buffer(codec_context, frame);
+      return;
+   }
+
+   index = avcodec_dr_held_find(module, buffer);
+   if (vcos_verify(index >= 0))
+   {
+      /* Buffers which were never sent to the client (e.g. discarded or
+       * reference-only frames) are made available for decoding again */
+      if (!module->held[index].sent)
+         mmal_queue_put(module->queue_out, buffer);
+      module->held[index] = module->held[--module->held_num];
+   }
+
+   for (i = 0; i < 4; i++)
+      frame->data[i] = NULL;
+   frame->opaque = NULL;
+}
+
 /** Set format on a port */
 static MMAL_STATUS_T avcodec_input_port_set_format(MMAL_PORT_T *port)
 {
@@ -138,6 +268,28 @@ static MMAL_STATUS_T avcodec_input_port_set_format(MMAL_PORT_T *port)
    if (codec->capabilities & CODEC_CAP_TRUNCATED)
       module->codec_context->flags |= CODEC_FLAG_TRUNCATED;
 
+   /* Spread the decoding work across the available cores. Exposing both
+    * threading types lets avcodec pick whichever the codec supports, with
+    * slice threading preferred since it does not add any decode delay. */
+#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT( 52, 111, 0 )
+   module->codec_context->thread_count = module->thread_count;
+   module->codec_context->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+#else
+   if (module->thread_count > 1)
+      avcodec_thread_init(module->codec_context, module->thread_count);
+#endif
+
+   /* Decode directly into our output buffers when the codec allows it.
+    * CODEC_FLAG_EMU_EDGE is needed since our buffers have no edge padding. */
+   if (codec->capabilities & CODEC_CAP_DR1)
+   {
+      module->codec_context->opaque = component;
+      module->codec_context->flags |= CODEC_FLAG_EMU_EDGE;
+      module->codec_context->get_buffer = avcodec_video_get_buffer;
+      module->codec_context->release_buffer = avcodec_video_release_buffer;
+      module->direct_rendering = MMAL_TRUE;
+   }
+
    if (avcodec_open(module->codec_context, codec) < 0)
    {
       LOG_ERROR("could not open codec");
@@ -170,6 +322,7 @@ static MMAL_STATUS_T avcodec_output_port_set_format(MMAL_PORT_T *port)
 {
    MMAL_COMPONENT_T *component = port->component;
    MMAL_COMPONENT_MODULE_T *module = component->priv->module;
+   unsigned int i;
 
    /* Format can only be set to what is output by the codec */
    if (pixfmt_to_encoding(module->codec_context->pix_fmt) != port->format->encoding)
@@ -189,6 +342,13 @@ static MMAL_STATUS_T avcodec_output_port_set_format(MMAL_PORT_T *port)
       if (!module->layout.data[module->planes++])
          break;
 
+   /* Direct rendering requires every plane to start and stride on a
+    * 16-byte boundary */
+   module->layout_supports_dr = module->direct_rendering;
+   for (i = 0; i < module->planes; i++)
+      if (((size_t)module->layout.data[i] & 15) || (module->layout.linesize[i] & 15))
+         module->layout_supports_dr = MMAL_FALSE;
+
    port->buffer_size_min = module->frame_size;
    port->component->priv->module->output_needs_configuring = 0;
    mmal_component_action_trigger(port->component);
@@ -213,7 +373,13 @@ static MMAL_STATUS_T avcodec_port_flush(MMAL_PORT_T *port)
    MMAL_QUEUE_T *queue;
 
    if(port->type == MMAL_PORT_TYPE_OUTPUT)
+   {
       queue = module->queue_out;
+      /* Get the codec to release the output buffers it holds on to so they
+       * can be returned to the client as well */
+      if (module->direct_rendering && module->codec_context->codec)
+         avcodec_flush_buffers(module->codec_context);
+   }
    else if(port->type == MMAL_PORT_TYPE_INPUT)
       queue = module->queue_in;
    else
@@ -305,19 +471,34 @@ static MMAL_STATUS_T avcodec_send_picture(MMAL_COMPONENT_T *component, MMAL_PORT
       return MMAL_EAGAIN;
    }
 
-   out = mmal_queue_get(module->queue_out);
-   if (!out)
-      return MMAL_EAGAIN;
-
-   size = avpicture_layout((AVPicture *)module->picture, module->pix_fmt,
-                           module->width, module->height, out->data, out->alloc_size);
-   if (size < 0)
+   if (module->picture->type == FF_BUFFER_TYPE_USER && module->picture->opaque)
    {
-      mmal_queue_put_back(module->queue_out, out);
-      LOG_ERROR("avpicture_layout failed: %i, %i, %i, %i",module->pix_fmt,
-                module->width, module->height, out->alloc_size );
-      mmal_event_error_send(component, MMAL_EINVAL);
-      return MMAL_EINVAL;
+      /* The picture was decoded directly into one of our output buffers
+       * so it can be sent as is */
+      int index;
+
+      out = (MMAL_BUFFER_HEADER_T *)module->picture->opaque;
+      index = avcodec_dr_held_find(module, out);
+      if (vcos_verify(index >= 0))
+         module->held[index].sent = MMAL_TRUE;
+      size = module->frame_size;
+   }
+   else
+   {
+      out = mmal_queue_get(module->queue_out);
+      if (!out)
+         return MMAL_EAGAIN;
+
+      size = avpicture_layout((AVPicture *)module->picture, module->pix_fmt,
+                              module->width, module->height, out->data, out->alloc_size);
+      if (size < 0)
+      {
+         mmal_queue_put_back(module->queue_out, out);
+         LOG_ERROR("avpicture_layout failed: %i, %i, %i, %i",module->pix_fmt,
+                   module->width, module->height, out->alloc_size );
+         mmal_event_error_send(component, MMAL_EINVAL);
+         return MMAL_EINVAL;
+      }
    }
 
    out->length = size;
@@ -445,6 +626,30 @@ static MMAL_STATUS_T avcodec_port_send(MMAL_PORT_T *port, MMAL_BUFFER_HEADER_T *
    return MMAL_SUCCESS;
 }
 
+/** Set a parameter on the input port */
+static MMAL_STATUS_T avcodec_input_port_parameter_set(MMAL_PORT_T *port, const MMAL_PARAMETER_HEADER_T *param)
+{
+   MMAL_COMPONENT_MODULE_T *module = port->component->priv->module;
+
+   switch (param->id)
+   {
+   case MMAL_PARAMETER_VIDEO_DECODE_THREAD_COUNT:
+      {
+         const MMAL_PARAMETER_UINT32_T *p = (const MMAL_PARAMETER_UINT32_T *)param;
+         if (param->size < sizeof(*p) || p->value > DECODE_THREADS_MAX)
+            return MMAL_EINVAL;
+         /* Too late to apply once the codec has been opened */
+         if (module->codec_context->codec)
+            return MMAL_EINVAL;
+         module->thread_count = p->value;
+      }
+      return MMAL_SUCCESS;
+
+   default:
+      return MMAL_ENOSYS;
+   }
+}
+
 /** Create an instance of a component  */
 static MMAL_STATUS_T mmal_component_create_avcodec(const char *name, MMAL_COMPONENT_T *component)
 {
@@ -480,6 +685,7 @@ static MMAL_STATUS_T mmal_component_create_avcodec(const char *name, MMAL_COMPON
    component->input[0]->priv->pf_disable = avcodec_port_disable;
    component->input[0]->priv->pf_flush = avcodec_port_flush;
    component->input[0]->priv->pf_send = avcodec_port_send;
+   component->input[0]->priv->pf_parameter_set = avcodec_input_port_parameter_set;
    component->input[0]->buffer_num_min = INPUT_MIN_BUFFER_NUM;
    component->input[0]->buffer_num_recommended = INPUT_RECOMMENDED_BUFFER_NUM;
    component->input[0]->buffer_size_min = INPUT_MIN_BUFFER_SIZE;
@@ -136,6 +136,7 @@ typedef struct MMAL_COMPONENT_MODULE_T
    MMAL_CLOCK_UPDATE_THRESHOLD_T  update_threshold;
    MMAL_CLOCK_DISCONT_THRESHOLD_T discont_threshold;
    MMAL_CLOCK_REQUEST_THRESHOLD_T request_threshold;
+   MMAL_CLOCK_REQUEST_TOLERANCE_T request_tolerance;
 
    /** Clock port events */
    struct
@@ -347,6 +348,7 @@ static void clock_start_clocks(MMAL_COMPONENT_T *component, TIME_T media_time)
          mmal_port_clock_update_threshold_set(port, &module->update_threshold);
          mmal_port_clock_discont_threshold_set(port, &module->discont_threshold);
          mmal_port_clock_request_threshold_set(port, &module->request_threshold);
+         mmal_port_clock_request_tolerance_set(port, &module->request_tolerance);
          mmal_port_clock_active_set(port, MMAL_TRUE);
       }
    }
@@ -666,6 +668,17 @@ static void clock_process_request_threshold_event(MMAL_COMPONENT_T *component, c
       mmal_port_clock_request_threshold_set(component->clock[i], threshold);
 }
 
+/** Handler for request tolerance events */
+static void clock_process_request_tolerance_event(MMAL_COMPONENT_T *component, const MMAL_CLOCK_REQUEST_TOLERANCE_T *tolerance)
+{
+   unsigned i;
+
+   component->priv->module->request_tolerance = *tolerance;
+
+   for (i = 0; i < component->clock_num; ++i)
+      mmal_port_clock_request_tolerance_set(component->clock[i], tolerance);
+}
+
 /** Handler for latency events */
 static void clock_process_latency_event(MMAL_COMPONENT_T *component, const MMAL_CLOCK_LATENCY_T *latency)
 {
@@ -742,6 +755,9 @@ static MMAL_BOOL_T clock_do_processing(MMAL_COMPONENT_T *component)
    case MMAL_CLOCK_EVENT_REQUEST_THRESHOLD:
       clock_process_request_threshold_event(component, &port_event.event.data.request_threshold);
       break;
+   case MMAL_CLOCK_EVENT_REQUEST_TOLERANCE:
+      clock_process_request_tolerance_event(component, &port_event.event.data.request_tolerance);
+      break;
    case MMAL_CLOCK_EVENT_LATENCY:
       clock_process_latency_event(component, &port_event.event.data.latency);
       break;
@@ -883,6 +899,7 @@ static MMAL_STATUS_T mmal_component_create_clock(const char *name, MMAL_COMPONEN
    mmal_port_clock_update_threshold_get(component->clock[0], &module->update_threshold);
    mmal_port_clock_discont_threshold_get(component->clock[0], &module->discont_threshold);
    mmal_port_clock_request_threshold_get(component->clock[0], &module->request_threshold);
+   mmal_port_clock_request_tolerance_get(component->clock[0], &module->request_tolerance);
 
    return status;
 
@@ -44,8 +44,24 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define READER_RECOMMENDED_BUFFER_SIZE (32*1024)
 #define READER_RECOMMENDED_BUFFER_NUM 10
 
+/* Demux lookahead. Packets are pre-read from the container by a dedicated
+ * thread into a ring of slots, so that slow container IO stalls the demux
+ * thread instead of the action thread which services the ports. */
+#define READER_LOOKAHEAD_SLOTS 8
+#define READER_LOOKAHEAD_SLOT_SIZE READER_RECOMMENDED_BUFFER_SIZE
+
 /*****************************************************************************/
 
+/** A pre-read packet held in the demux lookahead ring */
+typedef struct READER_PACKET_SLOT_T
+{
+   VC_CONTAINER_PACKET_T info;      /**< Packet info, with data pointing at the payload */
+   VC_CONTAINER_STATUS_T cstatus;   /**< Status of the read which produced this slot */
+   uint32_t consumed;               /**< Bytes already copied out to port buffers */
+   uint8_t payload[READER_LOOKAHEAD_SLOT_SIZE];
+
+} READER_PACKET_SLOT_T;
+
 /** Private context for this component */
 typedef struct MMAL_COMPONENT_MODULE_T
 {
@@ -57,7 +73,14 @@ typedef struct MMAL_COMPONENT_MODULE_T
    MMAL_BOOL_T error;
 
    /* Reader specific */
-   MMAL_BOOL_T packet_logged;
+   READER_PACKET_SLOT_T *slots;         /**< Demux lookahead ring */
+   volatile unsigned int slot_head;     /**< Next slot to deliver, owned by the action thread */
+   volatile unsigned int slot_tail;     /**< Next slot to fill, owned by the demux thread */
+   VCOS_MUTEX_T demux_lock;             /**< Serialises container access between demux and seek */
+   VCOS_EVENT_T slot_free;              /**< Signalled when a slot is consumed or discarded */
+   VCOS_THREAD_T demux_thread;
+   MMAL_BOOL_T demux_thread_running;
+   volatile MMAL_BOOL_T demux_quit;
 
    /* Writer specific */
    unsigned int port_last_used;
@@ -336,55 +359,125 @@ static MMAL_STATUS_T mmal_to_container_format(VC_CONTAINER_ES_FORMAT_T *containe
 }
 
 /*****************************************************************************/
-static void reader_do_processing(MMAL_COMPONENT_T *component)
+/** Demux thread. Pre-reads packets from the container into the lookahead
+ * ring, so the action thread never blocks on container IO. The ring is
+ * bounded, so the thread simply waits once it is far enough ahead. */
+static void *reader_demux_thread(void *arg)
 {
+   MMAL_COMPONENT_T *component = (MMAL_COMPONENT_T *)arg;
    MMAL_COMPONENT_MODULE_T *module = component->priv->module;
-   MMAL_BUFFER_HEADER_T *buffer;
-   VC_CONTAINER_STATUS_T cstatus;
-   VC_CONTAINER_PACKET_T packet;
-   MMAL_STATUS_T status;
-   unsigned int i;
 
-   memset(&packet, 0, sizeof(packet));
-
-   while(1)
+   while(!module->demux_quit)
    {
-      cstatus = vc_container_read(module->container, &packet, VC_CONTAINER_READ_FLAG_INFO);
+      READER_PACKET_SLOT_T *slot;
+      VC_CONTAINER_STATUS_T cstatus;
+      unsigned int i;
+
+      /* Wait for a free slot in the ring */
+      if(module->slot_tail - module->slot_head == READER_LOOKAHEAD_SLOTS)
+      {
+         vcos_event_wait(&module->slot_free);
+         continue;
+      }
+
+      slot = &module->slots[module->slot_tail % READER_LOOKAHEAD_SLOTS];
+      memset(&slot->info, 0, sizeof(slot->info));
+      slot->consumed = 0;
+
+      /* The container is read, and the slot published, under the demux lock
+       * so that a concurrent seek cannot slip in between the two and leave a
+       * packet from the old position in the ring. */
+      vcos_mutex_lock(&module->demux_lock);
+      cstatus = vc_container_read(module->container, &slot->info, VC_CONTAINER_READ_FLAG_INFO);
+      if(cstatus == VC_CONTAINER_SUCCESS)
+      {
+         /* Skip tracks which have no port */
+         for(i = 0; i < module->ports; i++)
+            if(component->output[i]->priv->module->track == slot->info.track)
+               break;
+         if(i == module->ports)
+         {
+            vc_container_read(module->container, 0, VC_CONTAINER_READ_FLAG_SKIP);
+            vcos_mutex_unlock(&module->demux_lock);
+            continue;
+         }
+
+         slot->info.data = slot->payload;
+         slot->info.buffer_size = sizeof(slot->payload);
+         slot->info.size = 0;
+         cstatus = vc_container_read(module->container, &slot->info, 0);
+      }
       if(cstatus == VC_CONTAINER_ERROR_CONTINUE)
+      {
+         vcos_mutex_unlock(&module->demux_lock);
          continue;
+      }
+      slot->cstatus = cstatus;
+      module->slot_tail++;
+      vcos_mutex_unlock(&module->demux_lock);
+
+      if(cstatus == VC_CONTAINER_SUCCESS)
+         LOG_DEBUG("packet info: track %i, size %i/%i, pts %"PRId64"%s, dts %"PRId64"%s, flags %x%s",
+                   slot->info.track, slot->info.size, slot->info.frame_size,
+                   slot->info.pts == VC_CONTAINER_TIME_UNKNOWN ? 0 : slot->info.pts,
+                   slot->info.pts == VC_CONTAINER_TIME_UNKNOWN ? ":unknown" : "",
+                   slot->info.dts == VC_CONTAINER_TIME_UNKNOWN ? 0 : slot->info.dts,
+                   slot->info.dts == VC_CONTAINER_TIME_UNKNOWN ? ":unknown" : "",
+                   slot->info.flags, (slot->info.flags & VC_CONTAINER_PACKET_FLAG_KEYFRAME) ? " (keyframe)" : "");
+      else
+         LOG_DEBUG("READ EOF (%i)", cstatus);
+
+      mmal_component_action_trigger(component);
+
       if(cstatus != VC_CONTAINER_SUCCESS)
       {
-         LOG_DEBUG("READ EOF (%i)", cstatus);
-         break;
+         /* Nothing more will come out of the container until a seek discards
+          * the lookahead, so park until a slot is freed. The terminal slot
+          * stays at the head of the ring in the meantime. */
+         vcos_event_wait(&module->slot_free);
       }
+   }
 
-      if (!module->packet_logged)
-         LOG_DEBUG("packet info: track %i, size %i/%i, pts %"PRId64"%s, dts %"PRId64"%s, flags %x%s",
-                   packet.track, packet.size, packet.frame_size,
-                   packet.pts == VC_CONTAINER_TIME_UNKNOWN ? 0 : packet.pts,
-                   packet.pts == VC_CONTAINER_TIME_UNKNOWN ? ":unknown" : "",
-                   packet.dts == VC_CONTAINER_TIME_UNKNOWN ? 0 : packet.dts,
-                   packet.dts == VC_CONTAINER_TIME_UNKNOWN ? ":unknown" : "",
-                   packet.flags, (packet.flags & VC_CONTAINER_PACKET_FLAG_KEYFRAME) ? " (keyframe)" : "");
+   return NULL;
+}
+
+/*****************************************************************************/
+static void reader_do_processing(MMAL_COMPONENT_T *component)
+{
+   MMAL_COMPONENT_MODULE_T *module = component->priv->module;
+   MMAL_BUFFER_HEADER_T *buffer;
+   READER_PACKET_SLOT_T *slot = NULL;
+   VC_CONTAINER_STATUS_T cstatus = VC_CONTAINER_SUCCESS;
+   MMAL_STATUS_T status;
+   unsigned int i;
+
+   /* Deliver pre-read packets from the lookahead ring to the ports. This
+    * never touches the container itself, so it cannot be stalled by IO. */
+   while(module->slot_head != module->slot_tail)
+   {
+      uint32_t copy, space;
+
+      slot = &module->slots[module->slot_head % READER_LOOKAHEAD_SLOTS];
+      cstatus = slot->cstatus;
+      if(cstatus != VC_CONTAINER_SUCCESS)
+         break; /* Terminal slot, handled below. It is left in the ring. */
 
       /* Find the port corresponding to that track */
       for(i = 0; i < module->ports; i++)
-         if(component->output[i]->priv->module->track == packet.track)
+         if(component->output[i]->priv->module->track == slot->info.track)
             break;
       if(i == module->ports)
       {
-         vc_container_read(module->container, 0, VC_CONTAINER_READ_FLAG_SKIP);
+         /* Track was unmapped after the packet was read (e.g. port disabled) */
+         module->slot_head++;
+         vcos_event_signal(&module->slot_free);
          continue;
       }
 
       /* Get a buffer from this port */
       buffer = mmal_queue_get(component->output[i]->priv->module->queue);
       if(!buffer)
-      {
-         module->packet_logged = 1;
-         break; /* Try again next time */
-      }
-      module->packet_logged = 0;
+         return; /* Try again when the port is given a buffer */
 
       if(component->output[i]->priv->module->flush)
       {
@@ -392,37 +485,39 @@ static void reader_do_processing(MMAL_COMPONENT_T *component)
          component->output[i]->priv->module->flush = MMAL_FALSE;
       }
 
+      copy = slot->info.size - slot->consumed;
+      space = buffer->alloc_size - buffer->length;
+      if(copy > space)
+         copy = space;
+
       mmal_buffer_header_mem_lock(buffer);
-      packet.data = buffer->data + buffer->length;
-      packet.buffer_size = buffer->alloc_size - buffer->length;
-      packet.size = 0;
-      cstatus = vc_container_read(module->container, &packet, 0);
+      memcpy(buffer->data + buffer->length, slot->payload + slot->consumed, copy);
       mmal_buffer_header_mem_unlock(buffer);
-      if(cstatus != VC_CONTAINER_SUCCESS)
-      {
-         LOG_DEBUG("TEST read status: %i", cstatus);
-         mmal_queue_put_back(component->output[i]->priv->module->queue, buffer);
-         break;
-      }
 
       if(!buffer->length)
       {
-         buffer->pts = packet.pts == VC_CONTAINER_TIME_UNKNOWN ? MMAL_TIME_UNKNOWN : packet.pts;
-         buffer->dts = packet.dts == VC_CONTAINER_TIME_UNKNOWN ? MMAL_TIME_UNKNOWN : packet.dts;
+         buffer->pts = slot->info.pts == VC_CONTAINER_TIME_UNKNOWN ? MMAL_TIME_UNKNOWN : slot->info.pts;
+         buffer->dts = slot->info.dts == VC_CONTAINER_TIME_UNKNOWN ? MMAL_TIME_UNKNOWN : slot->info.dts;
          buffer->flags = 0;
-         if(packet.flags & VC_CONTAINER_PACKET_FLAG_KEYFRAME)
+         if(slot->info.flags & VC_CONTAINER_PACKET_FLAG_KEYFRAME)
             buffer->flags |= MMAL_BUFFER_HEADER_FLAG_KEYFRAME;
-         if(packet.flags & VC_CONTAINER_PACKET_FLAG_FRAME_START)
+         if(slot->info.flags & VC_CONTAINER_PACKET_FLAG_FRAME_START)
             buffer->flags |= MMAL_BUFFER_HEADER_FLAG_FRAME_START;
       }
-      if(packet.flags & VC_CONTAINER_PACKET_FLAG_FRAME_END)
-         buffer->flags |= MMAL_BUFFER_HEADER_FLAG_FRAME_END;
+      buffer->length += copy;
+      slot->consumed += copy;
+
+      if(slot->consumed == slot->info.size)
+      {
+         if(slot->info.flags & VC_CONTAINER_PACKET_FLAG_FRAME_END)
+            buffer->flags |= MMAL_BUFFER_HEADER_FLAG_FRAME_END;
 #ifdef VC_CONTAINER_PACKET_FLAG_CONFIG
-      if(packet.flags & VC_CONTAINER_PACKET_FLAG_CONFIG)
-         buffer->flags |= MMAL_BUFFER_HEADER_FLAG_CONFIG;
+         if(slot->info.flags & VC_CONTAINER_PACKET_FLAG_CONFIG)
+            buffer->flags |= MMAL_BUFFER_HEADER_FLAG_CONFIG;
 #endif
-
-      buffer->length += packet.size;
+         module->slot_head++;
+         vcos_event_signal(&module->slot_free);
+      }
 
       if((component->output[i]->format->flags & MMAL_ES_FORMAT_FLAG_FRAMED) &&
          buffer->length != buffer->alloc_size &&
@@ -436,6 +531,9 @@ static void reader_do_processing(MMAL_COMPONENT_T *component)
       mmal_port_buffer_header_callback(component->output[i], buffer);
    }
 
+   if(module->slot_head == module->slot_tail)
+      return; /* Lookahead drained, wait for the demux thread to refill it */
+
    if(cstatus == VC_CONTAINER_ERROR_EOS)
    {
       /* Send an empty EOS buffer for each port */
@@ -610,6 +708,19 @@ static MMAL_STATUS_T container_component_destroy(MMAL_COMPONENT_T *component)
    MMAL_COMPONENT_MODULE_T *module = component->priv->module;
    unsigned int i;
 
+   if(module->demux_thread_running)
+   {
+      module->demux_quit = MMAL_TRUE;
+      vcos_event_signal(&module->slot_free);
+      vcos_thread_join(&module->demux_thread, NULL);
+   }
+   if(module->slots)
+   {
+      vcos_event_delete(&module->slot_free);
+      vcos_mutex_delete(&module->demux_lock);
+      vcos_free(module->slots);
+   }
+
    if(module->container)
       vc_container_close(module->container);
 
@@ -797,6 +908,32 @@ static MMAL_STATUS_T reader_container_open(MMAL_COMPONENT_T *component, const ch
       component->output[i]->format->encoding = MMAL_ENCODING_UNKNOWN;
    }
 
+   /* Start the demux lookahead */
+   module->slots = vcos_malloc(READER_LOOKAHEAD_SLOTS * sizeof(*module->slots),
+                               "mmal reader lookahead");
+   if(!module->slots)
+      return MMAL_ENOMEM;
+   if(vcos_mutex_create(&module->demux_lock, "mmal reader demux") != VCOS_SUCCESS)
+   {
+      vcos_free(module->slots);
+      module->slots = NULL;
+      return MMAL_ENOMEM;
+   }
+   if(vcos_event_create(&module->slot_free, "mmal reader slots") != VCOS_SUCCESS)
+   {
+      vcos_mutex_delete(&module->demux_lock);
+      vcos_free(module->slots);
+      module->slots = NULL;
+      return MMAL_ENOMEM;
+   }
+   if(vcos_thread_create(&module->demux_thread, "mmal reader demux", NULL,
+                         reader_demux_thread, component) != VCOS_SUCCESS)
+   {
+      LOG_ERROR("failed to create demux thread");
+      return MMAL_ENOMEM;
+   }
+   module->demux_thread_running = MMAL_TRUE;
+
    return MMAL_SUCCESS;
 }
 
@@ -814,12 +951,18 @@ static MMAL_STATUS_T reader_container_seek(MMAL_COMPONENT_T *component, const MM
       flags |= VC_CONTAINER_SEEK_FLAG_FORWARD;
 
    mmal_component_action_lock(component);
+   vcos_mutex_lock(&module->demux_lock);
    for(i = 0; i < component->output_num; i++)
    {
       component->output[i]->priv->module->eos = MMAL_FALSE;
       component->output[i]->priv->module->flush = MMAL_TRUE;
    }
    cstatus = vc_container_seek( module->container, &offset, VC_CONTAINER_SEEK_MODE_TIME, flags);
+   /* The lookahead was read at the old position, so discard it */
+   module->slot_head = module->slot_tail;
+   module->error = MMAL_FALSE;
+   vcos_mutex_unlock(&module->demux_lock);
+   vcos_event_signal(&module->slot_free);
    mmal_component_action_unlock(component);
    return container_map_to_mmal_status(cstatus);
 }
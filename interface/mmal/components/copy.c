@@ -30,11 +30,32 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "core/mmal_port_private.h"
 #include "mmal_logging.h"
 
+#ifdef __ARM_NEON__
+# include <arm_neon.h>
+#endif
+
 /*****************************************************************************/
+
+/** Plane layout of a frame, worked out from the committed format.
+ * When the layout is known, the copy only moves the visible rows and columns
+ * of each plane instead of the whole buffer including its padding. */
+typedef struct COPY_PLANES_T
+{
+   unsigned int num;          /**< Number of planes, 0 when the layout is not known */
+   size_t offset[3];          /**< Offset of each plane into the buffer */
+   unsigned int pitch[3];     /**< Bytes between the start of two consecutive rows */
+   unsigned int row_bytes[3]; /**< Bytes worth of visible data in a row */
+   unsigned int rows[3];      /**< Number of visible rows */
+   size_t frame_size;         /**< Size of a whole frame in the buffer */
+
+} COPY_PLANES_T;
+
 typedef struct MMAL_COMPONENT_MODULE_T
 {
    MMAL_STATUS_T status; /**< current status of the component */
 
+   COPY_PLANES_T planes; /**< plane layout of the committed format */
+
 } MMAL_COMPONENT_MODULE_T;
 
 typedef struct MMAL_PORT_MODULE_T
@@ -46,6 +67,117 @@ typedef struct MMAL_PORT_MODULE_T
 
 /*****************************************************************************/
 
+/** Copies a block of memory.
+ * On ARM the bulk is done with NEON loads and stores, which noticeably beat
+ * the libc memcpy for the large, cache-cold buffers moved here. */
+static void copy_block(uint8_t *dest, const uint8_t *src, size_t size)
+{
+#ifdef __ARM_NEON__
+   while (size >= 64)
+   {
+      uint8x16_t d0 = vld1q_u8(src);
+      uint8x16_t d1 = vld1q_u8(src + 16);
+      uint8x16_t d2 = vld1q_u8(src + 32);
+      uint8x16_t d3 = vld1q_u8(src + 48);
+      __builtin_prefetch(src + 256);
+      vst1q_u8(dest, d0);
+      vst1q_u8(dest + 16, d1);
+      vst1q_u8(dest + 32, d2);
+      vst1q_u8(dest + 48, d3);
+      src += 64;
+      dest += 64;
+      size -= 64;
+   }
+   if (size)
+      memcpy(dest, src, size);
+#else
+   memcpy(dest, src, size);
+#endif
+}
+
+/** Works out the plane layout of a frame from the committed format.
+ * Only the planar YUV encodings commonly shuffled between codecs are
+ * recognised; anything else gets a flat copy of the whole buffer. */
+static void copy_configure_planes(MMAL_COMPONENT_MODULE_T *module, MMAL_ES_FORMAT_T *format)
+{
+   MMAL_VIDEO_FORMAT_T *video = &format->es->video;
+   COPY_PLANES_T *planes = &module->planes;
+   unsigned int width = video->width, height = video->height;
+   unsigned int crop_width = video->crop.width, crop_height = video->crop.height;
+
+   planes->num = 0;
+
+   if (format->type != MMAL_ES_TYPE_VIDEO || !width || !height)
+      return;
+
+   /* A crop offset would make the layout dependent on the consumer so only
+    * the common case of cropping on the right / bottom is dealt with */
+   if (!crop_width || video->crop.x)
+      crop_width = width;
+   if (!crop_height || video->crop.y)
+      crop_height = height;
+
+   planes->offset[0] = 0;
+   planes->pitch[0] = width;
+   planes->row_bytes[0] = crop_width;
+   planes->rows[0] = crop_height;
+
+   switch (format->encoding)
+   {
+   case MMAL_ENCODING_I420:
+   case MMAL_ENCODING_YV12:
+      planes->num = 3;
+      planes->offset[1] = (size_t)width * height;
+      planes->offset[2] = planes->offset[1] + (size_t)(width / 2) * (height / 2);
+      planes->pitch[1] = planes->pitch[2] = width / 2;
+      planes->row_bytes[1] = planes->row_bytes[2] = (crop_width + 1) / 2;
+      planes->rows[1] = planes->rows[2] = (crop_height + 1) / 2;
+      planes->frame_size = planes->offset[2] + (size_t)(width / 2) * (height / 2);
+      break;
+   case MMAL_ENCODING_NV12:
+   case MMAL_ENCODING_NV21:
+      planes->num = 2;
+      planes->offset[1] = (size_t)width * height;
+      planes->pitch[1] = width;
+      planes->row_bytes[1] = ((crop_width + 1) / 2) * 2;
+      planes->rows[1] = (crop_height + 1) / 2;
+      planes->frame_size = planes->offset[1] + (size_t)width * (height / 2);
+      break;
+   default:
+      break;
+   }
+}
+
+/** Copies a frame from one buffer to the other, plane by plane when the
+ * layout is known so that the padding rows and columns are not moved */
+static void copy_frame(MMAL_COMPONENT_MODULE_T *module,
+   MMAL_BUFFER_HEADER_T *out, MMAL_BUFFER_HEADER_T *in)
+{
+   COPY_PLANES_T *planes = &module->planes;
+   unsigned int i, j;
+
+   /* Partial frames cannot be copied plane by plane */
+   if (!planes->num || in->offset || in->length != planes->frame_size)
+   {
+      copy_block(out->data, in->data + in->offset, in->length);
+      return;
+   }
+
+   for (i = 0; i < planes->num; i++)
+   {
+      uint8_t *dest = out->data + planes->offset[i];
+      const uint8_t *src = in->data + planes->offset[i];
+
+      if (planes->row_bytes[i] == planes->pitch[i])
+      {
+         copy_block(dest, src, (size_t)planes->pitch[i] * planes->rows[i]);
+         continue;
+      }
+      for (j = 0; j < planes->rows[i]; j++, dest += planes->pitch[i], src += planes->pitch[i])
+         copy_block(dest, src, planes->row_bytes[i]);
+   }
+}
+
 /** Actual processing function */
 static MMAL_BOOL_T copy_do_processing(MMAL_COMPONENT_T *component)
 {
@@ -112,7 +244,7 @@ static MMAL_BOOL_T copy_do_processing(MMAL_COMPONENT_T *component)
 
    mmal_buffer_header_mem_lock(out);
    mmal_buffer_header_mem_lock(in);
-   memcpy(out->data, in->data + in->offset, in->length);
+   copy_frame(module, out, in);
    mmal_buffer_header_mem_unlock(in);
    mmal_buffer_header_mem_unlock(out);
    out->length     = in->length;
@@ -210,6 +342,9 @@ static MMAL_STATUS_T copy_input_port_format_commit(MMAL_PORT_T *in)
    MMAL_BUFFER_HEADER_T *buffer;
    MMAL_STATUS_T status;
 
+   /* Select the copy strategy matching the new format */
+   copy_configure_planes(component->priv->module, in->format);
+
    /* Check if there's anything to propagate to the output port */
    /* The format of the output port needs to match the input port */
    if (!mmal_format_compare(in->format, out->format) &&
@@ -32,6 +32,101 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #define NULLSINK_PORTS_NUM 1
 
+/** Number of bins of the inter-arrival histogram.
+ * Bin N counts intervals of less than (1 << N) milliseconds (and at least
+ * (1 << (N-1)) milliseconds for N > 0). The last bin also counts anything
+ * larger. */
+#define NULLSINK_STATS_BINS 8
+
+#define NULLSINK_FRAME_MAGIC MMAL_FOURCC('A','C','A','M')
+
+/** Measurement header optionally embedded at the start of a frame by a
+ * benchmarking source (see artificial_camera.c for the layout rationale) */
+typedef struct NULLSINK_FRAME_HEADER_T
+{
+   uint32_t magic;    /**< set to \ref NULLSINK_FRAME_MAGIC */
+   uint32_t sequence; /**< sequence number of the frame */
+   uint32_t pts_low;  /**< low 32 bits of the frame timestamp (microseconds) */
+   uint32_t pts_high; /**< high 32 bits of the frame timestamp (microseconds) */
+   uint32_t checksum; /**< 32-bit sum of the payload words following the header */
+
+} NULLSINK_FRAME_HEADER_T;
+
+/*****************************************************************************/
+typedef struct MMAL_PORT_MODULE_T
+{
+   uint32_t buffer_count;      /**< total number of buffers received */
+   uint32_t frame_count;       /**< number of buffers carrying a payload */
+   uint32_t header_count;      /**< number of frames with a measurement header */
+   uint32_t checksum_failures; /**< frames whose payload did not match their checksum */
+   uint32_t sequence_gaps;     /**< discontinuities in the embedded sequence numbers */
+   uint32_t next_sequence;     /**< expected sequence number of the next frame */
+   uint32_t max_frame_bytes;   /**< largest payload received */
+   int64_t total_bytes;        /**< total number of payload bytes received */
+   MMAL_BOOL_T eos_seen;
+
+   int64_t first_arrival;      /**< arrival wall-time of the first frame */
+   int64_t last_arrival;       /**< arrival wall-time of the latest frame */
+   int64_t latency_sum;        /**< summed source-to-sink latency of stamped frames */
+   int64_t latency_max;        /**< worst source-to-sink latency of stamped frames */
+   uint32_t intervals[NULLSINK_STATS_BINS];
+                               /**< histogram of frame inter-arrival times */
+
+} MMAL_PORT_MODULE_T;
+
+/*****************************************************************************/
+/* Verify a frame carrying a measurement header and update the measurement
+ * counters. Returns the embedded timestamp through pts. */
+static MMAL_BOOL_T null_sink_verify_frame(MMAL_PORT_MODULE_T *module,
+   MMAL_BUFFER_HEADER_T *buffer, int64_t *pts)
+{
+   const NULLSINK_FRAME_HEADER_T *header =
+      (const NULLSINK_FRAME_HEADER_T *)(buffer->data + buffer->offset);
+   const uint32_t *word = (const uint32_t *)(buffer->data + buffer->offset + sizeof(*header));
+   uint32_t words = (buffer->length - sizeof(*header)) / sizeof(*word);
+   uint32_t checksum = 0;
+
+   *pts = ((int64_t)header->pts_high << 32) | header->pts_low;
+
+   if (module->header_count++ && header->sequence != module->next_sequence)
+      module->sequence_gaps++;
+   module->next_sequence = header->sequence + 1;
+
+   while (words--)
+      checksum += *word++;
+
+   return checksum == header->checksum;
+}
+
+/* Log a summary of everything measured on a port */
+static void null_sink_stats_log(MMAL_PORT_T *port)
+{
+   MMAL_PORT_MODULE_T *module = port->priv->module;
+   int64_t duration = module->last_arrival - module->first_arrival;
+   unsigned int i;
+
+   if (!module->frame_count)
+      return;
+
+   LOG_INFO("%s: %u buffers, %u frames, %"PRIi64" bytes, %u max frame bytes",
+            port->name, module->buffer_count, module->frame_count,
+            module->total_bytes, module->max_frame_bytes);
+   if (duration > 0)
+      LOG_INFO("%s: %u frames/s, %u bytes/s", port->name,
+               (uint32_t)(module->frame_count * INT64_C(1000000) / duration),
+               (uint32_t)(module->total_bytes * INT64_C(1000000) / duration));
+   if (module->header_count)
+      LOG_INFO("%s: %u stamped frames, %u checksum failures, %u sequence gaps, "
+               "latency avg %"PRIi64"us max %"PRIi64"us", port->name,
+               module->header_count, module->checksum_failures,
+               module->sequence_gaps, module->latency_sum / module->header_count,
+               module->latency_max);
+   for (i = 0; i < NULLSINK_STATS_BINS; i++)
+      if (module->intervals[i])
+         LOG_INFO("%s: interval < %ums: %u", port->name, 1 << i,
+                  module->intervals[i]);
+}
+
 /** Destroy a previously created component */
 static MMAL_STATUS_T null_sink_component_destroy(MMAL_COMPONENT_T *component)
 {
@@ -58,14 +153,63 @@ static MMAL_STATUS_T null_sink_port_flush(MMAL_PORT_T *port)
 /** Disable processing on a port */
 static MMAL_STATUS_T null_sink_port_disable(MMAL_PORT_T *port)
 {
-   MMAL_PARAM_UNUSED(port);
+   null_sink_stats_log(port);
    return MMAL_SUCCESS;
 }
 
 /** Send a buffer header to a port */
 static MMAL_STATUS_T null_sink_port_send(MMAL_PORT_T *port, MMAL_BUFFER_HEADER_T *buffer)
 {
+   MMAL_PORT_MODULE_T *module = port->priv->module;
    MMAL_BOOL_T eos = buffer->flags & MMAL_BUFFER_HEADER_FLAG_EOS;
+   int64_t now = vcos_getmicrosecs64();
+
+   module->buffer_count++;
+   module->eos_seen |= eos;
+
+   if (buffer->length)
+   {
+      module->frame_count++;
+      module->total_bytes += buffer->length;
+      if (buffer->length > module->max_frame_bytes)
+         module->max_frame_bytes = buffer->length;
+
+      /* Update the inter-arrival histogram */
+      if (module->first_arrival)
+      {
+         uint32_t interval_ms = (uint32_t)((now - module->last_arrival) / 1000);
+         unsigned int bin = 0;
+         while (interval_ms && bin < NULLSINK_STATS_BINS - 1)
+         {
+            interval_ms >>= 1;
+            bin++;
+         }
+         module->intervals[bin]++;
+      }
+      else
+         module->first_arrival = now;
+      module->last_arrival = now;
+
+      /* Verify frames stamped by a benchmarking source */
+      if (buffer->length >= sizeof(NULLSINK_FRAME_HEADER_T) &&
+          mmal_buffer_header_mem_lock(buffer) == MMAL_SUCCESS)
+      {
+         if (((NULLSINK_FRAME_HEADER_T *)(buffer->data + buffer->offset))->magic ==
+             NULLSINK_FRAME_MAGIC)
+         {
+            int64_t pts, latency;
+
+            if (!null_sink_verify_frame(module, buffer, &pts))
+               module->checksum_failures++;
+
+            latency = now - pts;
+            module->latency_sum += latency;
+            if (latency > module->latency_max)
+               module->latency_max = latency;
+         }
+         mmal_buffer_header_mem_unlock(buffer);
+      }
+   }
 
    /* Send buffer back */
    buffer->length = 0;
@@ -85,6 +229,49 @@ static MMAL_STATUS_T null_sink_port_format_commit(MMAL_PORT_T *port)
    return MMAL_SUCCESS;
 }
 
+/** Set parameter on a port */
+static MMAL_STATUS_T null_sink_port_parameter_set(MMAL_PORT_T *port, const MMAL_PARAMETER_HEADER_T *param)
+{
+   MMAL_PORT_MODULE_T *module = port->priv->module;
+
+   switch (param->id)
+   {
+   case MMAL_PARAMETER_STATISTICS:
+      /* Setting the statistics resets all the measurement counters */
+      memset(module, 0, sizeof(*module));
+      return MMAL_SUCCESS;
+   default:
+      return MMAL_ENOSYS;
+   }
+}
+
+/** Get parameter on a port */
+static MMAL_STATUS_T null_sink_port_parameter_get(MMAL_PORT_T *port, MMAL_PARAMETER_HEADER_T *param)
+{
+   MMAL_PORT_MODULE_T *module = port->priv->module;
+
+   switch (param->id)
+   {
+   case MMAL_PARAMETER_STATISTICS:
+      {
+         MMAL_PARAMETER_STATISTICS_T *stats = (MMAL_PARAMETER_STATISTICS_T *)param;
+         if (param->size < sizeof(*stats))
+            return MMAL_EINVAL;
+         stats->buffer_count = module->buffer_count;
+         stats->frame_count = module->frame_count;
+         stats->frames_skipped = module->sequence_gaps;
+         stats->frames_discarded = module->checksum_failures;
+         stats->eos_seen = module->eos_seen;
+         stats->maximum_frame_bytes = module->max_frame_bytes;
+         stats->total_bytes = module->total_bytes;
+         stats->corrupt_macroblocks = 0;
+      }
+      return MMAL_SUCCESS;
+   default:
+      return MMAL_ENOSYS;
+   }
+}
+
 /** Create an instance of a component  */
 static MMAL_STATUS_T mmal_component_create_null_sink(const char *name, MMAL_COMPONENT_T *component)
 {
@@ -95,7 +282,8 @@ static MMAL_STATUS_T mmal_component_create_null_sink(const char *name, MMAL_COMP
    component->priv->pf_destroy = null_sink_component_destroy;
 
    /* Allocate all the ports for this component */
-   component->input = mmal_ports_alloc(component, NULLSINK_PORTS_NUM, MMAL_PORT_TYPE_INPUT, 0);
+   component->input = mmal_ports_alloc(component, NULLSINK_PORTS_NUM, MMAL_PORT_TYPE_INPUT,
+                                       sizeof(MMAL_PORT_MODULE_T));
    if(!component->input)
       goto error;
    component->input_num = NULLSINK_PORTS_NUM;
@@ -107,6 +295,8 @@ static MMAL_STATUS_T mmal_component_create_null_sink(const char *name, MMAL_COMP
       component->input[i]->priv->pf_flush = null_sink_port_flush;
       component->input[i]->priv->pf_send = null_sink_port_send;
       component->input[i]->priv->pf_set_format = null_sink_port_format_commit;
+      component->input[i]->priv->pf_parameter_set = null_sink_port_parameter_set;
+      component->input[i]->priv->pf_parameter_get = null_sink_port_parameter_get;
       component->input[i]->buffer_num_min = 1;
       component->input[i]->buffer_num_recommended = 1;
    }
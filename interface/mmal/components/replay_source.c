@@ -0,0 +1,470 @@
+/*
+Copyright (c) 2012, Broadcom Europe Ltd
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/** Replay source component.
+ *
+ * Plays back a capture produced by the record tap of mmal_connection (see
+ * MMAL_CONNECTION_RECORD in util/mmal_connection.c), reproducing the arrival
+ * schedule of the original buffers so timing-sensitive problems seen in the
+ * field can be investigated on a bench machine without the original pipeline.
+ *
+ * The capture is a version 2 simple container file with arrival times, as
+ * described in containers/simple/simple_common.h. The file is parsed directly
+ * rather than through the containers library because arrival times have no
+ * equivalent in the container packet API. A capture without arrival times is
+ * still accepted and replayed as fast as buffers are made available.
+ */
+
+#include <stdio.h>
+
+#include "mmal.h"
+#include "core/mmal_component_private.h"
+#include "core/mmal_port_private.h"
+#include "mmal_logging.h"
+
+#include "containers/containers.h"
+#include "containers/simple/simple_common.h"
+
+/* Buffering requirements */
+#define OUTPUT_MIN_BUFFER_NUM 1
+#define OUTPUT_RECOMMENDED_BUFFER_NUM 4
+
+/** Maximum size of a line of the capture header */
+#define REPLAY_MAX_LINE 512
+
+/** Maximum time the processing loop will sleep for while waiting for the
+ * next record to become due (milliseconds) */
+#define SLEEP_TIME_MAX 10
+
+/** Decoded form of a record table entry */
+typedef struct REPLAY_RECORD_T
+{
+   uint64_t offset;          /**< offset relative to the payload region */
+   uint32_t size;
+   uint32_t track;
+   int64_t pts;
+   uint32_t flags;           /**< VC_CONTAINER_PACKET_FLAG_* values */
+   uint32_t arrival;         /**< arrival time relative to the first record (us) */
+
+} REPLAY_RECORD_T;
+
+/*****************************************************************************/
+typedef struct MMAL_PORT_MODULE_T
+{
+   MMAL_QUEUE_T *queue;
+
+} MMAL_PORT_MODULE_T;
+
+typedef struct MMAL_COMPONENT_MODULE_T
+{
+   MMAL_STATUS_T status;
+
+   FILE *file;               /**< capture file */
+   uint64_t payload_offset;  /**< start of the payload region in the file */
+
+   REPLAY_RECORD_T *records;
+   uint32_t records_num;
+   uint32_t next;            /**< index of the next record to replay */
+
+   MMAL_BOOL_T has_arrival;  /**< the capture carries arrival times */
+   int64_t start_time;       /**< wall-time at which the replay started */
+   MMAL_BOOL_T eos_sent;
+
+} MMAL_COMPONENT_MODULE_T;
+
+/*****************************************************************************/
+static uint32_t replay_u32( const uint8_t *p )
+{
+   return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint64_t replay_u64( const uint8_t *p )
+{
+   return replay_u32(p) | ((uint64_t)replay_u32(p + 4) << 32);
+}
+
+/** Read one line of the capture header, stripping the line terminator */
+static MMAL_BOOL_T replay_read_line(FILE *file, char *line, size_t size)
+{
+   size_t bytes;
+
+   if (!fgets(line, size, file))
+      return MMAL_FALSE;
+
+   bytes = strlen(line);
+   while (bytes && (line[bytes-1] == '\n' || line[bytes-1] == '\r'))
+      line[--bytes] = 0;
+   return MMAL_TRUE;
+}
+
+/** Parse the capture file and set the output port format from its track
+ * description. Only single track captures are supported, which is all the
+ * record tap ever produces. */
+static MMAL_STATUS_T replay_open(MMAL_COMPONENT_T *component, const char *uri)
+{
+   MMAL_COMPONENT_MODULE_T *module = component->priv->module;
+   MMAL_PORT_T *port = component->output[0];
+   char line[REPLAY_MAX_LINE];
+   uint8_t record[SIMPLE_V2_RECORD_SIZE];
+   uint32_t i, fourcc, records_num = 0, max_size = 0;
+   int matches, value, width, height, channels, samplerate, bps, blockalign;
+   MMAL_BOOL_T track_seen = MMAL_FALSE;
+
+   module->file = fopen(uri, "rb");
+   if (!module->file)
+   {
+      LOG_ERROR("error opening file %s", uri);
+      return MMAL_ENOENT;
+   }
+
+   if (!replay_read_line(module->file, line, sizeof(line)) ||
+       strcmp(line, SIGNATURE_STRING))
+   {
+      LOG_ERROR("%s is not a simple container file", uri);
+      return MMAL_EINVAL;
+   }
+
+   while (replay_read_line(module->file, line, sizeof(line)))
+   {
+      if (!strcmp(line, SIGNATURE_END_STRING))
+         break;
+
+      if (!memcmp(line, "TRACK ", sizeof("TRACK ")-1))
+      {
+         if (track_seen)
+         {
+            LOG_ERROR("%s has more than one track", uri);
+            return MMAL_EINVAL;
+         }
+         track_seen = MMAL_TRUE;
+
+         if ((matches = sscanf(line, "TRACK video, %4c, %i, %i",
+                 (char *)&fourcc, &width, &height)) > 0)
+         {
+            port->format->type = MMAL_ES_TYPE_VIDEO;
+            port->format->encoding = fourcc;
+            if (matches > 1) port->format->es->video.width = width;
+            if (matches > 2) port->format->es->video.height = height;
+         }
+         else if ((matches = sscanf(line, "TRACK audio, %4c, %i, %i, %i, %i",
+                 (char *)&fourcc, &channels, &samplerate, &bps,
+                 &blockalign)) > 0)
+         {
+            port->format->type = MMAL_ES_TYPE_AUDIO;
+            port->format->encoding = fourcc;
+            if (matches > 1) port->format->es->audio.channels = channels;
+            if (matches > 2) port->format->es->audio.sample_rate = samplerate;
+            if (matches > 3) port->format->es->audio.bits_per_sample = bps;
+            if (matches > 4) port->format->es->audio.block_align = blockalign;
+         }
+         else if (sscanf(line, "TRACK unknown, %4c", (char *)&fourcc) == 1)
+            port->format->encoding = fourcc;
+         continue;
+      }
+
+      if (sscanf(line, CONFIG_RECORDS" %u", &records_num) == 1)
+         continue;
+      if (sscanf(line, CONFIG_ARRIVAL" %i", &value) == 1)
+         module->has_arrival = value != 0;
+      /* Anything else is of no interest to the replay */
+   }
+
+   if (!records_num || records_num > SIMPLE_V2_MAX_RECORDS)
+   {
+      LOG_ERROR("%s does not have a valid record table (%u)", uri, records_num);
+      return MMAL_EINVAL;
+   }
+
+   module->records = vcos_malloc(records_num * sizeof(*module->records),
+                                 "mmal replay records");
+   if (!module->records)
+      return MMAL_ENOMEM;
+
+   for (i = 0; i < records_num; i++)
+   {
+      REPLAY_RECORD_T *rec = &module->records[i];
+
+      if (fread(record, 1, sizeof(record), module->file) != sizeof(record))
+      {
+         LOG_ERROR("%s: record table truncated at %u/%u", uri, i, records_num);
+         return MMAL_EINVAL;
+      }
+      rec->offset = replay_u64(record);
+      rec->size = replay_u32(record + 8);
+      rec->track = replay_u32(record + 12);
+      rec->pts = (int64_t)replay_u64(record + 16);
+      rec->flags = replay_u32(record + 24);
+      rec->arrival = module->has_arrival ? replay_u32(record + 28) : 0;
+
+      if (rec->size > max_size)
+         max_size = rec->size;
+   }
+   module->records_num = records_num;
+   module->payload_offset = ftell(module->file);
+
+   port->buffer_num_min = OUTPUT_MIN_BUFFER_NUM;
+   port->buffer_num_recommended = OUTPUT_RECOMMENDED_BUFFER_NUM;
+   port->buffer_size_min = port->buffer_size_recommended = max_size;
+
+   LOG_INFO("replaying %u buffers from %s (%4.4s, %ums)%s", records_num, uri,
+            (char *)&port->format->encoding,
+            (unsigned)(module->records[records_num-1].arrival / 1000),
+            module->has_arrival ? "" : " without arrival times");
+   return MMAL_SUCCESS;
+}
+
+/** Send one buffer worth of payload, following the recorded schedule */
+static void replay_do_processing(MMAL_COMPONENT_T *component)
+{
+   MMAL_COMPONENT_MODULE_T *module = component->priv->module;
+   MMAL_PORT_T *port = component->output[0];
+   MMAL_PORT_MODULE_T *port_module = port->priv->module;
+   int64_t now = vcos_getmicrosecs64();
+   MMAL_BUFFER_HEADER_T *buffer;
+   REPLAY_RECORD_T *rec;
+   size_t bytes = 0;
+
+   if (module->status != MMAL_SUCCESS || !module->records || module->eos_sent)
+      return;
+
+   /* The schedule starts when the first buffer becomes available */
+   if (!module->start_time)
+      module->start_time = now;
+
+   /* Replay everything which is due, then wait for the next record */
+   while (module->next < module->records_num)
+   {
+      rec = &module->records[module->next];
+
+      if (module->has_arrival &&
+          now < module->start_time + rec->arrival - module->records[0].arrival)
+      {
+         /* Not due yet. Sleep towards the due time and try again; the action
+          * has to retrigger itself as nothing else will run it otherwise. */
+         int64_t wait = module->start_time + rec->arrival -
+            module->records[0].arrival - now;
+         if (wait > SLEEP_TIME_MAX * 1000)
+            wait = SLEEP_TIME_MAX * 1000;
+         mmal_component_action_trigger(component);
+         vcos_sleep(MMAL_MAX((uint32_t)(wait / 1000), 1));
+         return;
+      }
+
+      buffer = mmal_queue_get(port_module->queue);
+      if (!buffer)
+         return;
+
+      if (buffer->alloc_size < rec->size)
+      {
+         LOG_ERROR("buffer too small (%i/%i)",
+                   (int)buffer->alloc_size, (int)rec->size);
+         module->status = MMAL_EINVAL;
+         mmal_queue_put_back(port_module->queue, buffer);
+         mmal_event_error_send(component, module->status);
+         return;
+      }
+      module->status = mmal_buffer_header_mem_lock(buffer);
+      if (module->status != MMAL_SUCCESS)
+      {
+         LOG_ERROR("invalid buffer (%p, %p)", buffer, buffer->data);
+         mmal_queue_put_back(port_module->queue, buffer);
+         mmal_event_error_send(component, module->status);
+         return;
+      }
+
+      if (rec->size)
+      {
+         fseek(module->file, (long)(module->payload_offset + rec->offset), SEEK_SET);
+         bytes = fread(buffer->data, 1, rec->size, module->file);
+         /* A metadata only capture can be short of payload, the replay then
+          * pads with zeroes so at least the sizes and timing are faithful */
+         if (bytes < rec->size)
+            memset(buffer->data + bytes, 0, rec->size - bytes);
+      }
+
+      buffer->offset = 0;
+      buffer->length = rec->size;
+      buffer->pts = rec->pts == (int64_t)VC_CONTAINER_TIME_UNKNOWN ?
+         MMAL_TIME_UNKNOWN : rec->pts;
+      buffer->dts = MMAL_TIME_UNKNOWN;
+      buffer->flags = 0;
+      if (rec->flags & VC_CONTAINER_PACKET_FLAG_KEYFRAME)
+         buffer->flags |= MMAL_BUFFER_HEADER_FLAG_KEYFRAME;
+      if (rec->flags & VC_CONTAINER_PACKET_FLAG_FRAME_START)
+         buffer->flags |= MMAL_BUFFER_HEADER_FLAG_FRAME_START;
+      if (rec->flags & VC_CONTAINER_PACKET_FLAG_FRAME_END)
+         buffer->flags |= MMAL_BUFFER_HEADER_FLAG_FRAME_END;
+      if (rec->flags & VC_CONTAINER_PACKET_FLAG_DISCONTINUITY)
+         buffer->flags |= MMAL_BUFFER_HEADER_FLAG_DISCONTINUITY;
+      if (rec->flags & VC_CONTAINER_PACKET_FLAG_CONFIG)
+         buffer->flags |= MMAL_BUFFER_HEADER_FLAG_CONFIG;
+
+      mmal_buffer_header_mem_unlock(buffer);
+      mmal_port_buffer_header_callback(port, buffer);
+      module->next++;
+      now = vcos_getmicrosecs64();
+   }
+
+   /* End of the capture */
+   buffer = mmal_queue_get(port_module->queue);
+   if (!buffer)
+      return;
+   buffer->offset = buffer->length = 0;
+   buffer->pts = buffer->dts = MMAL_TIME_UNKNOWN;
+   buffer->flags = MMAL_BUFFER_HEADER_FLAG_EOS;
+   mmal_port_buffer_header_callback(port, buffer);
+   module->eos_sent = MMAL_TRUE;
+}
+
+/** Destroy a previously created component */
+static MMAL_STATUS_T replay_component_destroy(MMAL_COMPONENT_T *component)
+{
+   MMAL_COMPONENT_MODULE_T *module = component->priv->module;
+   unsigned int i;
+
+   if (module->file)
+      fclose(module->file);
+   if (module->records)
+      vcos_free(module->records);
+
+   for (i = 0; i < component->output_num; i++)
+      if (component->output[i]->priv->module->queue)
+         mmal_queue_destroy(component->output[i]->priv->module->queue);
+   if (component->output_num)
+      mmal_ports_free(component->output, component->output_num);
+
+   vcos_free(module);
+   return MMAL_SUCCESS;
+}
+
+/** Enable processing on a port */
+static MMAL_STATUS_T replay_port_enable(MMAL_PORT_T *port, MMAL_PORT_BH_CB_T cb)
+{
+   MMAL_COMPONENT_MODULE_T *module = port->component->priv->module;
+   MMAL_PARAM_UNUSED(cb);
+
+   if (!module->records)
+      return MMAL_EINVAL;
+   return MMAL_SUCCESS;
+}
+
+/** Flush a port */
+static MMAL_STATUS_T replay_port_flush(MMAL_PORT_T *port)
+{
+   MMAL_PORT_MODULE_T *port_module = port->priv->module;
+   MMAL_BUFFER_HEADER_T *buffer;
+
+   buffer = mmal_queue_get(port_module->queue);
+   while (buffer)
+   {
+      buffer->length = 0;
+      mmal_port_buffer_header_callback(port, buffer);
+      buffer = mmal_queue_get(port_module->queue);
+   }
+
+   return MMAL_SUCCESS;
+}
+
+/** Disable processing on a port */
+static MMAL_STATUS_T replay_port_disable(MMAL_PORT_T *port)
+{
+   return replay_port_flush(port);
+}
+
+/** Send a buffer header to a port */
+static MMAL_STATUS_T replay_port_send(MMAL_PORT_T *port, MMAL_BUFFER_HEADER_T *buffer)
+{
+   mmal_queue_put(port->priv->module->queue, buffer);
+   mmal_component_action_trigger(port->component);
+   return MMAL_SUCCESS;
+}
+
+/** Set parameter on the component's control port */
+static MMAL_STATUS_T replay_parameter_set(MMAL_PORT_T *port, const MMAL_PARAMETER_HEADER_T *param)
+{
+   MMAL_COMPONENT_T *component = port->component;
+   MMAL_COMPONENT_MODULE_T *module = component->priv->module;
+
+   switch (param->id)
+   {
+   case MMAL_PARAMETER_URI:
+      if (module->file)
+         return MMAL_EINVAL;
+
+      return replay_open(component, ((const MMAL_PARAMETER_URI_T *)param)->uri);
+
+   default:
+      return MMAL_ENOSYS;
+   }
+}
+
+/** Create an instance of a component  */
+static MMAL_STATUS_T mmal_component_create_replay_source(const char *name, MMAL_COMPONENT_T *component)
+{
+   MMAL_STATUS_T status = MMAL_ENOMEM;
+   MMAL_PARAM_UNUSED(name);
+
+   /* Allocate our module context */
+   component->priv->module = vcos_calloc(1, sizeof(*component->priv->module), "mmal module");
+   if (!component->priv->module)
+      return MMAL_ENOMEM;
+
+   component->priv->pf_destroy = replay_component_destroy;
+
+   /* Allocate the output port for this component */
+   component->output = mmal_ports_alloc(component, 1, MMAL_PORT_TYPE_OUTPUT,
+                                        sizeof(MMAL_PORT_MODULE_T));
+   if (!component->output)
+      goto error;
+   component->output_num = 1;
+
+   component->output[0]->priv->pf_enable = replay_port_enable;
+   component->output[0]->priv->pf_disable = replay_port_disable;
+   component->output[0]->priv->pf_flush = replay_port_flush;
+   component->output[0]->priv->pf_send = replay_port_send;
+   component->output[0]->priv->module->queue = mmal_queue_create();
+   if (!component->output[0]->priv->module->queue)
+      goto error;
+
+   component->control->priv->pf_parameter_set = replay_parameter_set;
+
+   status = mmal_component_action_register(component, replay_do_processing);
+   if (status != MMAL_SUCCESS)
+      goto error;
+
+   return MMAL_SUCCESS;
+
+ error:
+   replay_component_destroy(component);
+   return status;
+}
+
+MMAL_CONSTRUCTOR(mmal_register_component_replay_source);
+void mmal_register_component_replay_source(void)
+{
+   mmal_component_supplier_register("replay_source", mmal_component_create_replay_source);
+}
@@ -36,6 +36,10 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define SDL_WIDTH 800
 #define SDL_HEIGHT 600
 
+/* Number of overlays cycled through by the presentation thread. Three are
+ * enough to have one being displayed, one queued and one being filled in. */
+#define OVERLAYS_NUM 3
+
 /* Buffering requirements */
 #define INPUT_MIN_BUFFER_NUM 1
 #define INPUT_RECOMMENDED_BUFFER_NUM 4
@@ -43,7 +47,9 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 /****************************/
 typedef struct MMAL_COMPONENT_MODULE_T
 {
-   SDL_Overlay *sdl_overlay;
+   SDL_Overlay *sdl_overlay[OVERLAYS_NUM];
+   SDL_Rect overlay_rect[OVERLAYS_NUM];
+   unsigned int overlay_num; /**< number of overlays actually created */
    SDL_Surface *sdl_surface;
    unsigned int width;
    unsigned int height;
@@ -54,6 +60,21 @@ typedef struct MMAL_COMPONENT_MODULE_T
 
    SDL_Thread *thread;
    MMAL_BOOL_T quit;
+
+   /* Overlays rotate between the action thread (filling) and the
+    * presentation thread (displaying). The rings below are protected by
+    * \ref lock while the semaphores count the overlays in each state. */
+   VCOS_MUTEX_T lock;
+   VCOS_SEMAPHORE_T sem_free;
+   VCOS_SEMAPHORE_T sem_ready;
+   uint8_t overlay_free[OVERLAYS_NUM];
+   unsigned int free_first, free_num;
+   uint8_t overlay_ready[OVERLAYS_NUM];
+   unsigned int ready_first, ready_num;
+   MMAL_BOOL_T sync_created;
+
+   SDL_Thread *present_thread;
+   MMAL_BOOL_T present_quit;
 } MMAL_COMPONENT_MODULE_T;
 
 static MMAL_STATUS_T sdl_port_parameter_set(MMAL_PORT_T *port, const MMAL_PARAMETER_HEADER_T *param)
@@ -84,19 +105,32 @@ static MMAL_STATUS_T sdl_component_destroy(MMAL_COMPONENT_T *component)
 {
    MMAL_COMPONENT_MODULE_T *module = component->priv->module;
    SDL_Event event = {SDL_QUIT};
+   unsigned int i;
 
    module->quit = MMAL_TRUE;
    SDL_PushEvent(&event);
    if(module->thread)
       SDL_WaitThread(module->thread, NULL);
-   if(module->sdl_overlay)
-      SDL_FreeYUVOverlay(module->sdl_overlay);
+   if(module->present_thread)
+   {
+      module->present_quit = MMAL_TRUE;
+      vcos_semaphore_post(&module->sem_ready);
+      SDL_WaitThread(module->present_thread, NULL);
+   }
+   for(i = 0; i < module->overlay_num; i++)
+      SDL_FreeYUVOverlay(module->sdl_overlay[i]);
    if(module->sdl_surface)
       SDL_FreeSurface(module->sdl_surface);
    SDL_QuitSubSystem(SDL_INIT_VIDEO);
 
    if(component->input_num) mmal_ports_free(component->input, 1);
    if(module->queue) mmal_queue_destroy(module->queue);
+   if(module->sync_created)
+   {
+      vcos_semaphore_delete(&module->sem_free);
+      vcos_semaphore_delete(&module->sem_ready);
+      vcos_mutex_delete(&module->lock);
+   }
    vcos_free(module);
    return MMAL_SUCCESS;
 }
@@ -131,6 +165,7 @@ static MMAL_STATUS_T sdl_port_set_format(MMAL_PORT_T *port)
    MMAL_COMPONENT_T *component = port->component;
    MMAL_COMPONENT_MODULE_T *module = component->priv->module;
    MMAL_STATUS_T status;
+   unsigned int i;
 
    if ((status=mmal_sdl_create_surface(module)) != MMAL_SUCCESS)
       return status;
@@ -139,25 +174,48 @@ static MMAL_STATUS_T sdl_port_set_format(MMAL_PORT_T *port)
    if (port->format->encoding != MMAL_ENCODING_I420)
       return MMAL_ENOSYS;
 
-   /* Check if we need to re-create an overlay */
-   if (module->sdl_overlay &&
+   /* Check if we need to re-create the overlays */
+   if (module->overlay_num == OVERLAYS_NUM &&
        module->width == port->format->es->video.width &&
        module->height == port->format->es->video.height)
       return MMAL_SUCCESS; /* Nothing to do */
 
-   if (module->sdl_overlay)
-      SDL_FreeYUVOverlay(module->sdl_overlay);
+   /* Wait for the presentation thread to be done with the current overlays
+    * before recycling them */
+   for (i = 0; i < module->overlay_num; i++)
+      vcos_semaphore_wait(&module->sem_free);
+   for (i = 0; i < module->overlay_num; i++)
+      SDL_FreeYUVOverlay(module->sdl_overlay[i]);
+   module->overlay_num = 0;
 
-   /* Create overlay */
-   module->sdl_overlay =
-      SDL_CreateYUVOverlay(port->format->es->video.width,
-                           port->format->es->video.height,
-                           SDL_YV12_OVERLAY, module->sdl_surface);
-   if (!module->sdl_overlay)
+   /* Create the overlays */
+   for (i = 0; i < OVERLAYS_NUM; i++)
    {
-      LOG_ERROR("cannot create SDL overlay");
+      module->sdl_overlay[i] =
+         SDL_CreateYUVOverlay(port->format->es->video.width,
+                              port->format->es->video.height,
+                              SDL_YV12_OVERLAY, module->sdl_surface);
+      if (!module->sdl_overlay[i])
+         break;
+   }
+   if (i != OVERLAYS_NUM)
+   {
+      LOG_ERROR("cannot create SDL overlays");
+      while (i--)
+         SDL_FreeYUVOverlay(module->sdl_overlay[i]);
       return MMAL_ENOSPC;
    }
+
+   /* All the overlays start off free */
+   module->overlay_num = OVERLAYS_NUM;
+   module->free_first = module->free_num = 0;
+   module->ready_first = module->ready_num = 0;
+   for (i = 0; i < OVERLAYS_NUM; i++)
+   {
+      module->overlay_free[module->free_num++] = i;
+      vcos_semaphore_post(&module->sem_free);
+   }
+
    module->width = port->format->es->video.width;
    module->height = port->format->es->video.height;
 
@@ -196,6 +254,42 @@ static MMAL_STATUS_T sdl_port_flush(MMAL_PORT_T *port)
    return MMAL_SUCCESS;
 }
 
+/** Presentation thread. Displaying an overlay can block for a long time when
+ * the display is contended so it is kept off the action thread, which only
+ * fills overlays in and can return input buffers straight away. */
+static int sdl_present_thread(void *arg)
+{
+   MMAL_COMPONENT_T *component = (MMAL_COMPONENT_T *)arg;
+   MMAL_COMPONENT_MODULE_T *module = component->priv->module;
+   unsigned int slot;
+
+   while (1)
+   {
+      vcos_semaphore_wait(&module->sem_ready);
+      if (module->present_quit)
+         break;
+
+      vcos_mutex_lock(&module->lock);
+      slot = module->overlay_ready[module->ready_first];
+      module->ready_first = (module->ready_first + 1) % OVERLAYS_NUM;
+      module->ready_num--;
+      vcos_mutex_unlock(&module->lock);
+
+      SDL_DisplayYUVOverlay(module->sdl_overlay[slot], &module->overlay_rect[slot]);
+
+      vcos_mutex_lock(&module->lock);
+      module->overlay_free[(module->free_first + module->free_num) % OVERLAYS_NUM] = slot;
+      module->free_num++;
+      vcos_mutex_unlock(&module->lock);
+      vcos_semaphore_post(&module->sem_free);
+
+      /* An overlay just became available for the next frame */
+      mmal_component_action_trigger(component);
+   }
+
+   return 0;
+}
+
 static MMAL_BOOL_T sdl_do_processing(MMAL_COMPONENT_T *component)
 {
    MMAL_PORT_T *port = component->input[0];
@@ -203,6 +297,8 @@ static MMAL_BOOL_T sdl_do_processing(MMAL_COMPONENT_T *component)
    unsigned int width = port->format->es->video.width;
    unsigned int height = port->format->es->video.height;
    MMAL_BUFFER_HEADER_T *buffer;
+   SDL_Overlay *overlay;
+   unsigned int slot;
    uint8_t *src_plane[3];
    uint32_t *src_pitch;
    unsigned int i, line;
@@ -249,27 +345,42 @@ static MMAL_BOOL_T sdl_do_processing(MMAL_COMPONENT_T *component)
 
    // FIXME: sanity check the size of the buffer
 
+   /* Grab a free overlay to blit into. If they are all in the hands of the
+    * presentation thread, hold on to the buffer; we'll be triggered again
+    * as soon as an overlay is released. */
+   if (vcos_semaphore_trywait(&module->sem_free) != VCOS_SUCCESS)
+   {
+      mmal_queue_put_back(module->queue, buffer);
+      return 0;
+   }
+   vcos_mutex_lock(&module->lock);
+   slot = module->overlay_free[module->free_first];
+   module->free_first = (module->free_first + 1) % OVERLAYS_NUM;
+   module->free_num--;
+   vcos_mutex_unlock(&module->lock);
+   overlay = module->sdl_overlay[slot];
+
    /* Blit the buffer onto the overlay. */
    src_pitch = buffer->type->video.pitch;
    src_plane[0] = buffer->data + buffer->type->video.offset[0];
    src_plane[1] = buffer->data + buffer->type->video.offset[2];
    src_plane[2] = buffer->data + buffer->type->video.offset[1];
 
-   SDL_LockYUVOverlay(module->sdl_overlay);
+   SDL_LockYUVOverlay(overlay);
    for (i=0; i<3; i++)
    {
       uint8_t *src = src_plane[i];
-      uint8_t *dst = module->sdl_overlay->pixels[i];
+      uint8_t *dst = overlay->pixels[i];
 
       if(i == 1) {width /= 2; height /= 2;}
       for(line = 0; line < height; line++)
       {
          memcpy(dst, src, width);
          src += src_pitch[i];
-         dst += module->sdl_overlay->pitches[i];
+         dst += overlay->pitches[i];
       }
    }
-   SDL_UnlockYUVOverlay(module->sdl_overlay);
+   SDL_UnlockYUVOverlay(overlay);
 
    width = port->format->es->video.width;
    height = port->format->es->video.height;
@@ -278,8 +389,14 @@ static MMAL_BOOL_T sdl_do_processing(MMAL_COMPONENT_T *component)
    height = rect.w * height / width;
    rect.y = module->display_region.y + (module->display_region.height - height) / 2;
    rect.h = height;
+   module->overlay_rect[slot] = rect;
 
-   SDL_DisplayYUVOverlay(module->sdl_overlay, &rect);
+   /* Queue the overlay for display */
+   vcos_mutex_lock(&module->lock);
+   module->overlay_ready[(module->ready_first + module->ready_num) % OVERLAYS_NUM] = slot;
+   module->ready_num++;
+   vcos_mutex_unlock(&module->lock);
+   vcos_semaphore_post(&module->sem_ready);
 
  end:
    buffer->offset = buffer->length = 0;
@@ -353,6 +470,21 @@ static MMAL_STATUS_T mmal_component_create_sdl(const char *name, MMAL_COMPONENT_
    module->queue = mmal_queue_create();
    if(!module->queue) goto error;
 
+   if(vcos_mutex_create(&module->lock, "sdl lock") != VCOS_SUCCESS)
+      goto error;
+   if(vcos_semaphore_create(&module->sem_free, "sdl free", 0) != VCOS_SUCCESS)
+   {
+      vcos_mutex_delete(&module->lock);
+      goto error;
+   }
+   if(vcos_semaphore_create(&module->sem_ready, "sdl ready", 0) != VCOS_SUCCESS)
+   {
+      vcos_semaphore_delete(&module->sem_free);
+      vcos_mutex_delete(&module->lock);
+      goto error;
+   }
+   module->sync_created = MMAL_TRUE;
+
    /* Allocate the ports for this component */
    component->input = mmal_ports_alloc(component, 1, MMAL_PORT_TYPE_INPUT, 0);
    if(!component->input) goto error;
@@ -376,6 +508,10 @@ static MMAL_STATUS_T mmal_component_create_sdl(const char *name, MMAL_COMPONENT_
    /* Create a thread to monitor SDL events */
    module->thread = SDL_CreateThread(sdl_event_thread, component);
 
+   /* Create the presentation thread */
+   module->present_thread = SDL_CreateThread(sdl_present_thread, component);
+   if(!module->present_thread) goto error;
+
    status = mmal_component_action_register(component, sdl_do_processing_loop);
    if (status != MMAL_SUCCESS)
       goto error;
@@ -40,6 +40,13 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define OUTPUT_MIN_BUFFER_SIZE SPDIF_FRAME_SIZE
 #define OUTPUT_MIN_BUFFER_NUM 2
 
+/** Number of output payloads tracked by the padding zero-cache */
+#define SPDIF_ZERO_CACHE_SIZE 8
+
+/** IEC61937 burst preamble (Pa, Pb, Pc) for AC3, in little endian.
+ * The bsmod bits and the burst length (Pd) are patched in per frame. */
+static const uint8_t spdif_burst_preamble[6] = {0x72,0xF8,0x1F,0x4E,0x1, 0};
+
 /*****************************************************************************/
 typedef struct MMAL_COMPONENT_MODULE_T
 {
@@ -52,9 +59,50 @@ typedef struct MMAL_PORT_MODULE_T
    MMAL_QUEUE_T *queue; /**< queue for the buffers sent to the ports */
    MMAL_BOOL_T needs_configuring; /**< port is waiting for a format commit */
 
+   uint8_t preamble[8]; /**< preformatted burst preamble for the current format */
+
+   /** Cache of the output payloads whose padding region is known to still be
+    * zero from the last time they were used, so recycled buffers only need
+    * the bytes overwritten since then cleared. Only valid for one S/PDIF
+    * frame size; reset whenever the output format is committed. */
+   struct
+   {
+      uint8_t *data;            /**< payload the entry refers to */
+      unsigned int zeroed_from; /**< offset from which the payload is zero */
+   } zero_cache[SPDIF_ZERO_CACHE_SIZE];
+   unsigned int zero_cache_next; /**< next slot to recycle on a cache miss */
+
 } MMAL_PORT_MODULE_T;
 
 /*****************************************************************************/
+/* Zero the padding region [start, end) of an output payload, skipping the
+ * part which is known to still be zero from the last use of the same
+ * payload */
+static void spdif_zero_pad(MMAL_PORT_MODULE_T *module, uint8_t *data,
+   unsigned int start, unsigned int end)
+{
+   unsigned int i;
+
+   for (i = 0; i < SPDIF_ZERO_CACHE_SIZE; i++)
+      if (module->zero_cache[i].data == data)
+         break;
+
+   if (i < SPDIF_ZERO_CACHE_SIZE)
+   {
+      if (module->zero_cache[i].zeroed_from < end)
+         end = module->zero_cache[i].zeroed_from;
+   }
+   else
+   {
+      i = module->zero_cache_next;
+      module->zero_cache_next = (i + 1 == SPDIF_ZERO_CACHE_SIZE) ? 0 : i + 1;
+      module->zero_cache[i].data = data;
+   }
+
+   if (start < end)
+      memset(data + start, 0, end - start);
+   module->zero_cache[i].zeroed_from = start;
+}
 
 /*****************************************************************************/
 
@@ -97,10 +145,10 @@ static MMAL_STATUS_T spdif_send_event_format_changed(MMAL_COMPONENT_T *component
 /** Actual processing function */
 static MMAL_BOOL_T spdif_do_processing(MMAL_COMPONENT_T *component)
 {
-   static const uint8_t ac3_spdif_header[6] = {0x72,0xF8,0x1F,0x4E,0x1, 0};
    MMAL_COMPONENT_MODULE_T *module = component->priv->module;
    MMAL_PORT_T *port_in = component->input[0];
    MMAL_PORT_T *port_out = component->output[0];
+   MMAL_PORT_MODULE_T *out_module = port_out->priv->module;
    MMAL_BUFFER_HEADER_T *in, *out;
    unsigned int i, sample_rate, frame_size, spdif_frame_size;
    uint8_t *in_data;
@@ -236,7 +284,7 @@ static MMAL_BOOL_T spdif_do_processing(MMAL_COMPONENT_T *component)
       LOG_ERROR("frame too big, truncating (%i/%i bytes)",
          in->length, spdif_frame_size - 8);
    frame_size = MMAL_MIN(in->length, spdif_frame_size - 8) / 2;
-   memcpy(out->data, ac3_spdif_header, sizeof(ac3_spdif_header));
+   memcpy(out->data, out_module->preamble, sizeof(out_module->preamble));
    out->data[5] = in_data[5] & 0x7; /* bsmod */
    out->data[6] = frame_size & 0xFF;
    out->data[7] = frame_size >> 8;
@@ -253,9 +301,9 @@ static MMAL_BOOL_T spdif_do_processing(MMAL_COMPONENT_T *component)
    else
       memcpy(out->data + 8, in_data, in->length);
 
-   /* The S/PDIF frame needs to be padded */
-   memset(out->data + 8 + frame_size * 2, 0,
-      spdif_frame_size - frame_size * 2 - 8);
+   /* The S/PDIF frame needs to be padded. Output buffers get recycled so
+    * most of the padding region will still be zero from the last frame. */
+   spdif_zero_pad(out_module, out->data, 8 + frame_size * 2, spdif_frame_size);
    mmal_buffer_header_mem_unlock(in);
    mmal_buffer_header_mem_unlock(out);
    out->length     = spdif_frame_size;
@@ -415,6 +463,14 @@ static MMAL_STATUS_T spdif_output_port_format_commit(MMAL_PORT_T *out)
       return MMAL_EINVAL;
    }
 
+   /* Rebuild the preformatted burst preamble and invalidate the padding
+    * zero-cache since the S/PDIF frame size might just have changed */
+   memcpy(out->priv->module->preamble, spdif_burst_preamble,
+      sizeof(spdif_burst_preamble));
+   out->priv->module->preamble[6] = out->priv->module->preamble[7] = 0;
+   memset(out->priv->module->zero_cache, 0,
+      sizeof(out->priv->module->zero_cache));
+
    out->priv->module->needs_configuring = 0;
    mmal_component_action_trigger(out->component);
    return MMAL_SUCCESS;
@@ -461,6 +517,8 @@ static MMAL_STATUS_T mmal_component_create_spdif(const char *name, MMAL_COMPONEN
    component->output[0]->priv->module->queue = mmal_queue_create();
    if(!component->output[0]->priv->module->queue)
       goto error;
+   memcpy(component->output[0]->priv->module->preamble, spdif_burst_preamble,
+      sizeof(spdif_burst_preamble));
 
    status = mmal_component_action_register(component, spdif_do_processing_loop);
    if (status != MMAL_SUCCESS)
@@ -44,6 +44,9 @@ typedef struct MMAL_COMPONENT_MODULE_T
 typedef struct MMAL_PORT_MODULE_T
 {
    MMAL_QUEUE_T *queue; /**< queue for the buffers sent to the ports */
+   MMAL_BOOL_T writable; /**< the client will modify the payloads it receives on
+                              this output port so it cannot share them with the
+                              other outputs and needs its own copy */
 
 } MMAL_PORT_MODULE_T;
 
@@ -143,10 +146,36 @@ static MMAL_STATUS_T splitter_send_output(MMAL_BUFFER_HEADER_T *buffer, MMAL_POR
    if (!out)
       return MMAL_EAGAIN;
 
-   /* Copy our input buffer header */
-   status = mmal_buffer_header_replicate(out, buffer);
-   if (status != MMAL_SUCCESS)
-      goto error;
+   if (out_port->priv->module->writable)
+   {
+      /* The payload is shared between all the other outputs, so a port whose
+       * client declared it will modify the data gets its own copy */
+      if (out->alloc_size < buffer->length)
+      {
+         status = MMAL_ENOSPC;
+         goto error;
+      }
+      mmal_buffer_header_mem_lock(out);
+      mmal_buffer_header_mem_lock(buffer);
+      memcpy(out->data, buffer->data + buffer->offset, buffer->length);
+      mmal_buffer_header_mem_unlock(buffer);
+      mmal_buffer_header_mem_unlock(out);
+      out->cmd    = buffer->cmd;
+      out->offset = 0;
+      out->length = buffer->length;
+      out->flags  = buffer->flags;
+      out->pts    = buffer->pts;
+      out->dts    = buffer->dts;
+      *out->type  = *buffer->type;
+   }
+   else
+   {
+      /* Replicate our input buffer header so the payload is carried through
+       * by reference instead of being copied */
+      status = mmal_buffer_header_replicate(out, buffer);
+      if (status != MMAL_SUCCESS)
+         goto error;
+   }
 
    /* Send buffer back */
    mmal_port_buffer_header_callback(out_port, out);
@@ -272,6 +301,13 @@ static MMAL_STATUS_T splitter_port_parameter_set(MMAL_PORT_T *port, const MMAL_P
       }
       return MMAL_SUCCESS;
 
+   case MMAL_PARAMETER_WRITABLE_OUTPUT:
+      if (port->type != MMAL_PORT_TYPE_OUTPUT ||
+          param->size < sizeof(MMAL_PARAMETER_BOOLEAN_T))
+         return MMAL_EINVAL;
+      port->priv->module->writable = !!((const MMAL_PARAMETER_BOOLEAN_T *)param)->enable;
+      return MMAL_SUCCESS;
+
    default:
       return MMAL_ENOSYS;
    }
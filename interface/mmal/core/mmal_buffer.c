@@ -28,6 +28,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "mmal.h"
 #include "mmal_buffer.h"
 #include "core/mmal_buffer_private.h"
+#include "interface/vcos/vcos.h"
 #include "mmal_logging.h"
 
 #define ROUND_UP(s,align) ((((unsigned long)(s)) & ~((align)-1)) + (align))
@@ -186,3 +187,16 @@ void mmal_buffer_header_pre_release_cb_set(MMAL_BUFFER_HEADER_T *header, MMAL_BH
    header->priv->pf_pre_release = cb;
    header->priv->pre_release_userdata = userdata;
 }
+
+int mmal_buffer_trace_enabled;
+
+/** Record an owner transition in the buffer header's trace ring */
+void mmal_buffer_header_trace(MMAL_BUFFER_HEADER_T *header, void *owner)
+{
+   MMAL_BUFFER_HEADER_PRIVATE_T *priv = header->priv;
+   MMAL_BUFFER_TRACE_ENTRY_T *entry =
+      &priv->trace[priv->trace_index++ & (MMAL_BUFFER_TRACE_ENTRIES - 1)];
+
+   entry->owner = owner;
+   entry->time = vcos_getmicrosecs();
+}
@@ -31,16 +31,30 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 /** Typedef for the private area the framework reserves for the driver / communication layer */
 typedef struct MMAL_DRIVER_BUFFER_T MMAL_DRIVER_BUFFER_T;
 
+/** Number of owner transitions remembered per buffer header when buffer
+ * provenance tracing is enabled. Must be a power of 2. */
+#define MMAL_BUFFER_TRACE_ENTRIES 8
+
+/** One owner transition of a buffer header */
+typedef struct MMAL_BUFFER_TRACE_ENTRY_T
+{
+   void *owner;   /**< Port the buffer was sent to / returned by, or the pool
+                       it was released back to */
+   uint32_t time; /**< Time of the transition (microseconds) */
+} MMAL_BUFFER_TRACE_ENTRY_T;
+
 /** Size of the private area the framework reserves for the driver / communication layer */
 #define MMAL_DRIVER_BUFFER_SIZE 32
 
-/** Typedef for the framework's private area in the buffer header */
+/** Typedef for the framework's private area in the buffer header.
+ * The fields touched every time a buffer header is acquired / released are
+ * grouped at the start of the structure so they share as few cache lines as
+ * possible, with the fields only accessed when a header is (re)initialised
+ * or its payload freed relegated to the end. */
 typedef struct MMAL_BUFFER_HEADER_PRIVATE_T
 {
-   /** Callback invoked just prior to actually releasing the buffer header. Returns TRUE if
-    * release should be delayed. */
-   MMAL_BH_PRE_RELEASE_CB_T pf_pre_release;
-   void *pre_release_userdata;
+   int32_t refcount;          /**< Reference count of the buffer header. When it reaches 0,
+                                   the release callback will be called. */
 
    /** Callback used to release / recycle the buffer header. This needs to be set by
     * whoever allocates the buffer header. */
@@ -48,11 +62,16 @@ typedef struct MMAL_BUFFER_HEADER_PRIVATE_T
    void *owner;               /**< Context set by the allocator of the buffer header and passed
                                    during the release callback */
 
-   int32_t refcount;          /**< Reference count of the buffer header. When it reaches 0,
-                                   the release callback will be called. */
+   /** Callback invoked just prior to actually releasing the buffer header. Returns TRUE if
+    * release should be delayed. */
+   MMAL_BH_PRE_RELEASE_CB_T pf_pre_release;
+   void *pre_release_userdata;
 
    MMAL_BUFFER_HEADER_T *reference; /**< Reference to another acquired buffer header. */
 
+   void *component_data;      /**< Field reserved for use by the component */
+   void *payload_handle;      /**< Field reserved for mmal_buffer_header_mem_lock */
+
    /** Callback used to free the payload associated with this buffer header. This is only
     * used if the buffer header was created by MMAL with a payload associated with it. */
    void   (*pf_payload_free)(void *payload_context, void *payload);
@@ -60,11 +79,14 @@ typedef struct MMAL_BUFFER_HEADER_PRIVATE_T
    void    *payload_context;  /**< Pointer to the context of the payload allocator */
    uint32_t payload_size;     /**< Allocated size in bytes of payload buffer */
 
-   void *component_data;      /**< Field reserved for use by the component */
-   void *payload_handle;      /**< Field reserved for mmal_buffer_header_mem_lock */
-
    uint8_t driver_area[MMAL_DRIVER_BUFFER_SIZE];
 
+   /** Ring of the last owner transitions of this header. Only written when
+    * buffer provenance tracing has been enabled, so it is kept at the end of
+    * the structure away from the hot fields. */
+   MMAL_BUFFER_TRACE_ENTRY_T trace[MMAL_BUFFER_TRACE_ENTRIES];
+   uint32_t trace_index; /**< Next slot to write in the trace ring */
+
 } MMAL_BUFFER_HEADER_PRIVATE_T;
 
 /** Get the size in bytes of a fully initialised MMAL_BUFFER_HEADER_T */
@@ -83,4 +105,14 @@ MMAL_DRIVER_BUFFER_T *mmal_buffer_header_driver_data(MMAL_BUFFER_HEADER_T *);
  */
 MMAL_BUFFER_HEADER_T *mmal_buffer_header_reference(MMAL_BUFFER_HEADER_T *header);
 
+/** Global switch for buffer provenance tracing, toggled with
+ * \ref mmal_pool_trace_enable. Callers check it before calling
+ * \ref mmal_buffer_header_trace so tracing costs a single test
+ * on the hot path when disabled. */
+extern int mmal_buffer_trace_enabled;
+
+/** Record an owner transition in the buffer header's trace ring.
+ */
+void mmal_buffer_header_trace(MMAL_BUFFER_HEADER_T *header, void *owner);
+
 #endif /* MMAL_BUFFER_PRIVATE_H */
@@ -75,6 +75,10 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  * time span for detecting discontinuous requests. */
 #define CLOCK_DISCONT_DURATION   1000000  /* microseconds */
 
+/* Default tolerance within which pending requests are coalesced into a single
+ * timer wakeup. Zero preserves one wakeup per request. */
+#define CLOCK_REQUEST_TOLERANCE  0  /* microseconds */
+
 /* Absolute value macro */
 #define ABS_VALUE(v)  (((v) < 0) ? -(v) : (v))
 
@@ -126,7 +130,7 @@ typedef struct MMAL_CLOCK_PRIVATE_T
    int64_t  media_time;       /**< current local media-time in microseconds */
    uint32_t media_time_frac;  /**< media-time fraction in microseconds (Q24 format) */
    int64_t  wall_time;        /**< current local wall-time (microseconds) */
-   uint32_t rtc_at_update;    /**< real-time clock value at local time update (microseconds) */
+   uint32_t rtc_at_update;    /**< monotonic clock value at local time update (microseconds) */
    int64_t  media_time_at_timer;
                               /**< media-time when the timer was last set */
 
@@ -143,6 +147,10 @@ typedef struct MMAL_CLOCK_PRIVATE_T
    int64_t  request_threshold;/**< Threshold after which frames exceeding the media-time are
                                    dropped (microseconds) */
    MMAL_BOOL_T request_threshold_enable;/**< Enable the request threshold */
+   int64_t  request_tolerance;/**< Pending requests this close to one being serviced are
+                                   serviced in the same wakeup (microseconds) */
+   MMAL_CLOCK_DELIVERY_STATS_T delivery_stats;
+                              /**< Histogram of early/late request deliveries */
    int64_t  update_threshold_lower;
                               /**< Time differences below this threshold are ignored */
    int64_t  update_threshold_upper;
@@ -156,6 +164,8 @@ typedef struct MMAL_CLOCK_PRIVATE_T
       MMAL_CLOCK_REQUEST_T pool[CLOCK_REQUEST_SLOTS];
    } request;
 
+   MMAL_CLOCK_PAGE_T page;    /**< lock-free published copy of the time reference */
+
 } MMAL_CLOCK_PRIVATE_T;
 
 
@@ -226,10 +236,26 @@ static inline void mmal_clock_timer_cancel(MMAL_TIMER_T *timer)
 /*****************************************************************************
  * Clock module private functions
  *****************************************************************************/
+/* Republish the time reference to the lock-free clock page. Must be called
+ * with the clock lock held so there is only ever one writer. */
+static void mmal_clock_page_publish_locked(MMAL_CLOCK_PRIVATE_T *private)
+{
+   MMAL_CLOCK_PAGE_T *page = &private->page;
+
+   page->sequence++;
+   __sync_synchronize();
+   page->media_time = private->media_time;
+   page->rtc_at_update = private->rtc_at_update;
+   page->scale = private->scale;
+   page->is_active = private->is_active;
+   __sync_synchronize();
+   page->sequence++;
+}
+
 /* Update the internal wall-time and media-time */
 static void mmal_clock_update_local_time_locked(MMAL_CLOCK_PRIVATE_T *private)
 {
-   uint32_t time_now = vcos_getmicrosecs();
+   uint32_t time_now = vcos_getmonotonicmicrosecs();
    uint32_t time_diff = (time_now > private->rtc_at_update) ? (time_now - private->rtc_at_update) : 0;
 
    private->wall_time += time_diff;
@@ -243,6 +269,8 @@ static void mmal_clock_update_local_time_locked(MMAL_CLOCK_PRIVATE_T *private)
    private->media_time_frac = media_diff & ((1<<24)-1);
 
    private->rtc_at_update = time_now;
+
+   mmal_clock_page_publish_locked(private);
 }
 
 /* Return the current local media-time */
@@ -319,6 +347,27 @@ static MMAL_STATUS_T mmal_clock_request_flush_locked(MMAL_CLOCK_PRIVATE_T *priva
    return MMAL_SUCCESS;
 }
 
+/* Record how early/late a request was serviced relative to the media-time
+ * requested by the client */
+static void mmal_clock_delivery_stats_update(MMAL_CLOCK_PRIVATE_T *private, int64_t delta)
+{
+   uint32_t *bins = private->delivery_stats.late;
+   unsigned int i;
+
+   if (delta < 0)
+   {
+      bins = private->delivery_stats.early;
+      delta = -delta;
+   }
+
+   /* Bin N covers deliveries off by less than (1 << N) milliseconds,
+    * with the last bin collecting everything else */
+   for (i = 0; i < MMAL_CLOCK_DELIVERY_STATS_BINS - 1; ++i)
+      if (delta < (1000 << i))
+         break;
+   bins[i]++;
+}
+
 /* Process all pending requests */
 static void mmal_clock_process_requests(MMAL_CLOCK_PRIVATE_T *private)
 {
@@ -364,14 +413,18 @@ static void mmal_clock_process_requests(MMAL_CLOCK_PRIVATE_T *private)
          private->discont_expiry = 0;
 
       /* Fire the request if it matches the pending discontinuity or if its requested media time
-       * has been reached. */
+       * has been reached. Requests falling within the coalescing tolerance of this wakeup are
+       * also fired now rather than re-arming the timer for each of them individually. */
       if ((private->discont_expiry != 0 &&
            next->media_time_adj >= private->discont_start &&
            next->media_time_adj < private->discont_end) ||
-          (private->scale > 0 && ((media_time_now + MIN_TIMER_DELAY) >= next->media_time_adj)) ||
-          (private->scale < 0 && ((media_time_now - MIN_TIMER_DELAY) <= next->media_time_adj)))
+          (private->scale > 0 &&
+           ((media_time_now + MIN_TIMER_DELAY + private->request_tolerance) >= next->media_time_adj)) ||
+          (private->scale < 0 &&
+           ((media_time_now - MIN_TIMER_DELAY - private->request_tolerance) <= next->media_time_adj)))
       {
          LOG_TRACE("servicing request: next %"PRIi64" now %"PRIi64, next->media_time_adj, media_time_now);
+         mmal_clock_delivery_stats_update(private, media_time_now - next->media_time);
          /* Inform the client */
          next->cb(&private->clock, media_time_now, next->cb_data, next->priv);
          /* Recycle the request slot */
@@ -514,7 +567,10 @@ static void mmal_clock_start(MMAL_CLOCK_T *clock)
 {
    MMAL_CLOCK_PRIVATE_T *private = (MMAL_CLOCK_PRIVATE_T*)clock;
 
+   LOCK(private);
    private->is_active = MMAL_TRUE;
+   mmal_clock_page_publish_locked(private);
+   UNLOCK(private);
 
    mmal_clock_wake_thread(private);
 }
@@ -524,7 +580,10 @@ static void mmal_clock_stop(MMAL_CLOCK_T *clock)
 {
    MMAL_CLOCK_PRIVATE_T *private = (MMAL_CLOCK_PRIVATE_T*)clock;
 
+   LOCK(private);
    private->is_active = MMAL_FALSE;
+   mmal_clock_page_publish_locked(private);
+   UNLOCK(private);
 
    mmal_clock_wake_thread(private);
 }
@@ -570,6 +629,7 @@ MMAL_STATUS_T mmal_clock_create(MMAL_CLOCK_T **clock)
    private->discont_duration       = CLOCK_DISCONT_DURATION;
    private->request_threshold      = 0;
    private->request_threshold_enable = MMAL_FALSE;
+   private->request_tolerance      = CLOCK_REQUEST_TOLERANCE;
 
    /* Default scale = 1.0, i.e. normal playback speed */
    mmal_clock_scale_set(&private->clock, scale);
@@ -679,11 +739,12 @@ MMAL_STATUS_T mmal_clock_media_time_set(MMAL_CLOCK_T *clock, int64_t media_time)
 
    if (!private->is_active)
    {
-      uint32_t time_now = vcos_getmicrosecs();
+      uint32_t time_now = vcos_getmonotonicmicrosecs();
       private->wall_time = time_now;
       private->media_time = media_time;
       private->media_time_frac = 0;
       private->rtc_at_update = time_now;
+      mmal_clock_page_publish_locked(private);
 
       UNLOCK(private);
       return MMAL_SUCCESS;
@@ -727,6 +788,8 @@ MMAL_STATUS_T mmal_clock_media_time_set(MMAL_CLOCK_T *clock, int64_t media_time)
       }
    }
 
+   mmal_clock_page_publish_locked(private);
+
    UNLOCK(private);
 
    if (wake_thread)
@@ -754,6 +817,8 @@ MMAL_STATUS_T mmal_clock_scale_set(MMAL_CLOCK_T *clock, MMAL_RATIONAL_T scale)
    else
       private->scale_inv = Q16_ONE; /* clock is paused */
 
+   mmal_clock_page_publish_locked(private);
+
    UNLOCK(private);
 
    mmal_clock_wake_thread(private);
@@ -798,6 +863,42 @@ int64_t mmal_clock_media_time_get(MMAL_CLOCK_T *clock)
    return media_time;
 }
 
+/* Get the lock-free clock page of the clock */
+const MMAL_CLOCK_PAGE_T *mmal_clock_page_get(MMAL_CLOCK_T *clock)
+{
+   return &((MMAL_CLOCK_PRIVATE_T*)clock)->page;
+}
+
+/* Derive the current media-time from a clock page without taking any lock */
+int64_t mmal_clock_page_media_time(const MMAL_CLOCK_PAGE_T *page)
+{
+   uint32_t sequence;
+   int64_t media_time;
+   uint32_t rtc_at_update, time_diff, time_now;
+   int32_t scale;
+   MMAL_BOOL_T is_active;
+
+   do
+   {
+      sequence = page->sequence;
+      __sync_synchronize();
+      media_time = page->media_time;
+      rtc_at_update = page->rtc_at_update;
+      scale = page->scale;
+      is_active = page->is_active;
+      __sync_synchronize();
+   } while ((sequence & 1) || sequence != page->sequence);
+
+   if (!is_active || !scale)
+      return media_time;
+
+   /* Extrapolate from the published reference in the same way as
+    * mmal_clock_update_local_time_locked, minus the fractional carry */
+   time_now = vcos_getmonotonicmicrosecs();
+   time_diff = (time_now > rtc_at_update) ? (time_now - rtc_at_update) : 0;
+   return media_time + ((((int64_t)time_diff) * (int64_t)(scale << 8)) >> 24);
+}
+
 /* Get the clock's state */
 MMAL_BOOL_T mmal_clock_is_active(MMAL_CLOCK_T *clock)
 {
@@ -890,3 +991,48 @@ MMAL_STATUS_T mmal_clock_request_threshold_set(MMAL_CLOCK_T *clock, const MMAL_C
 
    return MMAL_SUCCESS;
 }
+
+/* Get the clock's request coalescing tolerance */
+MMAL_STATUS_T mmal_clock_request_tolerance_get(MMAL_CLOCK_T *clock, MMAL_CLOCK_REQUEST_TOLERANCE_T *tolerance)
+{
+   MMAL_CLOCK_PRIVATE_T *private = (MMAL_CLOCK_PRIVATE_T *)clock;
+
+   LOCK(private);
+   tolerance->tolerance = private->request_tolerance;
+   UNLOCK(private);
+
+   return MMAL_SUCCESS;
+}
+
+/* Set the clock's request coalescing tolerance */
+MMAL_STATUS_T mmal_clock_request_tolerance_set(MMAL_CLOCK_T *clock, const MMAL_CLOCK_REQUEST_TOLERANCE_T *tolerance)
+{
+   MMAL_CLOCK_PRIVATE_T *private = (MMAL_CLOCK_PRIVATE_T *)clock;
+
+   if (tolerance->tolerance < 0)
+      return MMAL_EINVAL;
+
+   LOG_TRACE("new clock request tolerance: %"PRIi64,
+         tolerance->tolerance);
+
+   LOCK(private);
+   private->request_tolerance = tolerance->tolerance;
+   UNLOCK(private);
+
+   /* A larger tolerance can make pending requests due immediately */
+   mmal_clock_wake_thread(private);
+
+   return MMAL_SUCCESS;
+}
+
+/* Get the clock's request delivery statistics */
+MMAL_STATUS_T mmal_clock_delivery_stats_get(MMAL_CLOCK_T *clock, MMAL_CLOCK_DELIVERY_STATS_T *stats)
+{
+   MMAL_CLOCK_PRIVATE_T *private = (MMAL_CLOCK_PRIVATE_T *)clock;
+
+   LOCK(private);
+   *stats = private->delivery_stats;
+   UNLOCK(private);
+
+   return MMAL_SUCCESS;
+}
@@ -58,6 +58,44 @@ MMAL_STATUS_T mmal_clock_create(MMAL_CLOCK_T **clock);
  */
 MMAL_STATUS_T mmal_clock_destroy(MMAL_CLOCK_T *clock);
 
+/** Lock-free snapshot of the time reference of a clock.
+ * The clock republishes this page every time its time reference changes, so
+ * any number of readers can derive the current media-time from it without
+ * taking the clock lock or exchanging clock event messages. Consistency is
+ * guaranteed by the sequence counter which is odd while an update is in
+ * progress; readers should use \ref mmal_clock_page_media_time rather than
+ * access the fields directly. */
+typedef struct MMAL_CLOCK_PAGE_T
+{
+   volatile uint32_t sequence; /**< incremented before and after every update */
+   int64_t media_time;        /**< media-time at the last reference update (microseconds) */
+   uint32_t rtc_at_update;    /**< monotonic clock value at the last reference update */
+   int32_t scale;             /**< media-time scale factor (Q16 format), 0 when paused */
+   MMAL_BOOL_T is_active;     /**< TRUE -> media-time is advancing */
+
+} MMAL_CLOCK_PAGE_T;
+
+/** Get the clock page of a clock.
+ * The returned page remains valid (and is kept up to date by the clock) until
+ * the clock is destroyed.
+ *
+ * @param clock      The clock to query
+ *
+ * @return Pointer to the clock page
+ */
+const MMAL_CLOCK_PAGE_T *mmal_clock_page_get(MMAL_CLOCK_T *clock);
+
+/** Derive the current media-time from a clock page.
+ * This is equivalent to \ref mmal_clock_media_time_get but entirely lock-free
+ * and message-free, at the cost of the small extrapolation error accumulated
+ * since the clock last republished its time reference.
+ *
+ * @param page       The clock page to read
+ *
+ * @return Current media-time in microseconds
+ */
+int64_t mmal_clock_page_media_time(const MMAL_CLOCK_PAGE_T *page);
+
 /** Definition of a clock request callback.
  * This is invoked when the media-time requested by the client is reached.
  *
@@ -197,6 +235,35 @@ MMAL_STATUS_T mmal_clock_request_threshold_get(MMAL_CLOCK_T *clock, MMAL_CLOCK_R
  */
 MMAL_STATUS_T mmal_clock_request_threshold_set(MMAL_CLOCK_T *clock, const MMAL_CLOCK_REQUEST_THRESHOLD_T *req);
 
+/** Get the clock's request coalescing tolerance.
+ *
+ * @param clock      The clock
+ * @param tolerance  Pointer to clock request tolerance values to fill
+ *
+ * @return MMAL_SUCCESS on success
+ */
+MMAL_STATUS_T mmal_clock_request_tolerance_get(MMAL_CLOCK_T *clock, MMAL_CLOCK_REQUEST_TOLERANCE_T *tolerance);
+
+/** Set the clock's request coalescing tolerance.
+ * Pending requests with media-times within the tolerance of a request being
+ * serviced are serviced by the same timer wakeup.
+ *
+ * @param clock      The clock
+ * @param tolerance  Pointer to new clock request tolerance values
+ *
+ * @return MMAL_SUCCESS on success
+ */
+MMAL_STATUS_T mmal_clock_request_tolerance_set(MMAL_CLOCK_T *clock, const MMAL_CLOCK_REQUEST_TOLERANCE_T *tolerance);
+
+/** Get the clock's request delivery statistics.
+ *
+ * @param clock      The clock
+ * @param stats      Pointer to clock delivery statistics to fill
+ *
+ * @return MMAL_SUCCESS on success
+ */
+MMAL_STATUS_T mmal_clock_delivery_stats_get(MMAL_CLOCK_T *clock, MMAL_CLOCK_DELIVERY_STATS_T *stats);
+
 #ifdef __cplusplus
 }
 #endif
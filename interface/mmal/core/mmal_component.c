@@ -34,6 +34,18 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 /* Minimum number of buffers that will be available on the control port */
 #define MMAL_CONTROL_PORT_BUFFERS_MIN 4
 
+/* Number of threads shared by all the components to run their actions */
+#define MMAL_ACTION_POOL_THREADS 4
+
+/** Scheduling state of the action registered by a component */
+typedef enum MMAL_ACTION_STATE_T
+{
+   MMAL_ACTION_IDLE = 0,   /**< Nothing to do */
+   MMAL_ACTION_QUEUED,     /**< Waiting for a thread of the pool to pick it up */
+   MMAL_ACTION_RUNNING,    /**< Currently running on a thread of the pool */
+   MMAL_ACTION_RETRIGGER   /**< Running, and triggered again since it started */
+} MMAL_ACTION_STATE_T;
+
 /** Definition of the core private context. */
 typedef struct
 {
@@ -42,17 +54,34 @@ typedef struct
    /** Action registered by component and run when buffers are received by any of the ports */
    void (*pf_action)(MMAL_COMPONENT_T *component);
 
-   /** Action thread */
-   VCOS_THREAD_T action_thread;
-   VCOS_EVENT_T action_event;
+   /** Action scheduling. Actions are run by a pool of threads shared between
+    * all the components rather than by a thread per component. */
+   MMAL_ACTION_STATE_T action_state;
+   MMAL_COMPONENT_T *action_next; /**< Next component in the queue of pending actions */
+   VCOS_EVENT_T action_idle;      /**< Signalled when the action goes back to idle */
    VCOS_MUTEX_T action_mutex;
-   MMAL_BOOL_T action_quit;
 
    VCOS_MUTEX_T lock; /**< Used to lock access to the component */
    MMAL_BOOL_T destruction_pending;
 
 } MMAL_COMPONENT_CORE_PRIVATE_T;
 
+/** Pool of threads shared by all the components to run their actions.
+ * Serialisation is per-component: an action is only ever running on one
+ * thread of the pool at a time, and a trigger received while it runs just
+ * queues it again. */
+typedef struct
+{
+   VCOS_THREAD_T thread[MMAL_ACTION_POOL_THREADS];
+   VCOS_MUTEX_T lock;      /**< Protects the queue and the action states */
+   VCOS_SEMAPHORE_T sema;  /**< Counts the queued actions */
+   MMAL_COMPONENT_T *head; /**< Queue of components with a pending action */
+   MMAL_COMPONENT_T *tail;
+   MMAL_BOOL_T quit;
+   unsigned int threads;   /**< Number of threads successfully created */
+   unsigned int users;     /**< Number of actions currently registered */
+} MMAL_ACTION_POOL_T;
+
 /*****************************************************************************/
 static void mmal_core_init(void);
 static void mmal_core_deinit(void);
@@ -542,65 +571,162 @@ MMAL_STATUS_T mmal_port_release(MMAL_PORT_T *port)
  * Actions support
  *****************************************************************************/
 
-/** Registers an action with the core */
+static MMAL_ACTION_POOL_T mmal_action_pool;
+
+/** Runs the queued actions on one of the threads of the pool */
 static void *mmal_component_action_thread_func(void *arg)
 {
-   MMAL_COMPONENT_T *component = (MMAL_COMPONENT_T *)arg;
-   MMAL_COMPONENT_CORE_PRIVATE_T *private = (MMAL_COMPONENT_CORE_PRIVATE_T *)component->priv;
-   VCOS_STATUS_T status;
+   MMAL_ACTION_POOL_T *pool = (MMAL_ACTION_POOL_T *)arg;
 
    while (1)
    {
-      status = vcos_event_wait(&private->action_event);
+      MMAL_COMPONENT_CORE_PRIVATE_T *private;
+      MMAL_COMPONENT_T *component;
 
-      if (status == VCOS_EAGAIN)
-         continue;
-      if (private->action_quit)
-         break;
-      if (!vcos_verify(status == VCOS_SUCCESS))
+      vcos_semaphore_wait(&pool->sema);
+      if (pool->quit)
          break;
 
+      vcos_mutex_lock(&pool->lock);
+      component = pool->head;
+      if (!component)
+      {
+         /* The pending action was cancelled by a deregister */
+         vcos_mutex_unlock(&pool->lock);
+         continue;
+      }
+      private = (MMAL_COMPONENT_CORE_PRIVATE_T *)component->priv;
+      pool->head = private->action_next;
+      if (!pool->head)
+         pool->tail = NULL;
+      private->action_state = MMAL_ACTION_RUNNING;
+      vcos_mutex_unlock(&pool->lock);
+
       vcos_mutex_lock(&private->action_mutex);
       private->pf_action(component);
       vcos_mutex_unlock(&private->action_mutex);
+
+      vcos_mutex_lock(&pool->lock);
+      if (private->action_state == MMAL_ACTION_RETRIGGER)
+      {
+         /* The action was triggered again while it was running */
+         private->action_state = MMAL_ACTION_QUEUED;
+         private->action_next = NULL;
+         if (pool->tail)
+            ((MMAL_COMPONENT_CORE_PRIVATE_T *)pool->tail->priv)->action_next = component;
+         else
+            pool->head = component;
+         pool->tail = component;
+         vcos_semaphore_post(&pool->sema);
+      }
+      else
+      {
+         private->action_state = MMAL_ACTION_IDLE;
+         vcos_event_signal(&private->action_idle);
+      }
+      vcos_mutex_unlock(&pool->lock);
    }
    return 0;
 }
 
+/** Takes a reference on the pool of action threads, creating it on first use */
+static MMAL_STATUS_T mmal_component_action_pool_acquire(void)
+{
+   MMAL_ACTION_POOL_T *pool = &mmal_action_pool;
+   unsigned int i, threads = 0;
+
+   vcos_mutex_lock(&mmal_core_lock);
+   if (pool->users++)
+   {
+      vcos_mutex_unlock(&mmal_core_lock);
+      return MMAL_SUCCESS;
+   }
+
+   pool->head = pool->tail = NULL;
+   pool->quit = 0;
+   if (vcos_mutex_create(&pool->lock, "mmal actions") != VCOS_SUCCESS)
+      goto error;
+   if (vcos_semaphore_create(&pool->sema, "mmal actions", 0) != VCOS_SUCCESS)
+   {
+      vcos_mutex_delete(&pool->lock);
+      goto error;
+   }
+
+   for (i = 0; i < MMAL_ACTION_POOL_THREADS; i++, threads++)
+      if (vcos_thread_create(&pool->thread[i], "mmal actions", NULL,
+                             mmal_component_action_thread_func, pool) != VCOS_SUCCESS)
+         break;
+   if (!threads)
+   {
+      vcos_semaphore_delete(&pool->sema);
+      vcos_mutex_delete(&pool->lock);
+      goto error;
+   }
+   /* Running with fewer threads than requested only costs performance */
+   pool->threads = threads;
+
+   vcos_mutex_unlock(&mmal_core_lock);
+   return MMAL_SUCCESS;
+
+ error:
+   pool->users--;
+   vcos_mutex_unlock(&mmal_core_lock);
+   return MMAL_ENOMEM;
+}
+
+/** Releases a reference on the pool of action threads */
+static void mmal_component_action_pool_release(void)
+{
+   MMAL_ACTION_POOL_T *pool = &mmal_action_pool;
+   unsigned int i;
+
+   vcos_mutex_lock(&mmal_core_lock);
+   if (--pool->users)
+   {
+      vcos_mutex_unlock(&mmal_core_lock);
+      return;
+   }
+
+   pool->quit = 1;
+   for (i = 0; i < pool->threads; i++)
+      vcos_semaphore_post(&pool->sema);
+   for (i = 0; i < pool->threads; i++)
+      vcos_thread_join(&pool->thread[i], NULL);
+   vcos_semaphore_delete(&pool->sema);
+   vcos_mutex_delete(&pool->lock);
+   vcos_mutex_unlock(&mmal_core_lock);
+}
+
 /** Registers an action with the core */
 MMAL_STATUS_T mmal_component_action_register(MMAL_COMPONENT_T *component,
                                              void (*pf_action)(MMAL_COMPONENT_T *) )
 {
    MMAL_COMPONENT_CORE_PRIVATE_T *private = (MMAL_COMPONENT_CORE_PRIVATE_T *)component->priv;
-   VCOS_THREAD_ATTR_T attrs;
    VCOS_STATUS_T status;
 
    if (private->pf_action)
       return MMAL_EINVAL;
 
-   status = vcos_event_create(&private->action_event, component->name);
+   status = vcos_event_create(&private->action_idle, component->name);
    if (status != VCOS_SUCCESS)
       return MMAL_ENOMEM;
 
    status = vcos_mutex_create(&private->action_mutex, component->name);
    if (status != VCOS_SUCCESS)
    {
-      vcos_event_delete(&private->action_event);
+      vcos_event_delete(&private->action_idle);
       return MMAL_ENOMEM;
    }
 
-   vcos_thread_attr_init(&attrs);
-   vcos_thread_attr_setpriority(&attrs,
-                                private->private.priority);
-   status = vcos_thread_create(&private->action_thread, component->name, &attrs,
-                               mmal_component_action_thread_func, component);
-   if (status != VCOS_SUCCESS)
+   if (mmal_component_action_pool_acquire() != MMAL_SUCCESS)
    {
       vcos_mutex_delete(&private->action_mutex);
-      vcos_event_delete(&private->action_event);
+      vcos_event_delete(&private->action_idle);
       return MMAL_ENOMEM;
    }
 
+   private->action_state = MMAL_ACTION_IDLE;
+   private->action_next = NULL;
    private->pf_action = pf_action;
    return MMAL_SUCCESS;
 }
@@ -609,17 +735,43 @@ MMAL_STATUS_T mmal_component_action_register(MMAL_COMPONENT_T *component,
 MMAL_STATUS_T mmal_component_action_deregister(MMAL_COMPONENT_T *component)
 {
    MMAL_COMPONENT_CORE_PRIVATE_T *private = (MMAL_COMPONENT_CORE_PRIVATE_T *)component->priv;
+   MMAL_ACTION_POOL_T *pool = &mmal_action_pool;
 
    if (!private->pf_action)
       return MMAL_EINVAL;
 
-   private->action_quit = 1;
-   vcos_event_signal(&private->action_event);
-   vcos_thread_join(&private->action_thread, NULL);
-   vcos_event_delete(&private->action_event);
-   vcos_mutex_delete(&private->action_mutex);
+   /* Cancel the action if it is pending and wait for it if it is running */
+   while (1)
+   {
+      vcos_mutex_lock(&pool->lock);
+      if (private->action_state == MMAL_ACTION_QUEUED)
+      {
+         MMAL_COMPONENT_T **prev = &pool->head, *last = NULL;
+         while (*prev != component)
+         {
+            last = *prev;
+            prev = &((MMAL_COMPONENT_CORE_PRIVATE_T *)(*prev)->priv)->action_next;
+         }
+         *prev = private->action_next;
+         if (pool->tail == component)
+            pool->tail = last;
+         private->action_state = MMAL_ACTION_IDLE;
+      }
+      else if (private->action_state == MMAL_ACTION_RETRIGGER)
+         private->action_state = MMAL_ACTION_RUNNING;
+      if (private->action_state == MMAL_ACTION_IDLE)
+      {
+         vcos_mutex_unlock(&pool->lock);
+         break;
+      }
+      vcos_mutex_unlock(&pool->lock);
+      vcos_event_wait(&private->action_idle);
+   }
+
    private->pf_action = NULL;
-   private->action_quit = 0;
+   vcos_event_delete(&private->action_idle);
+   vcos_mutex_delete(&private->action_mutex);
+   mmal_component_action_pool_release();
    return MMAL_SUCCESS;
 }
 
@@ -627,11 +779,26 @@ MMAL_STATUS_T mmal_component_action_deregister(MMAL_COMPONENT_T *component)
 MMAL_STATUS_T mmal_component_action_trigger(MMAL_COMPONENT_T *component)
 {
    MMAL_COMPONENT_CORE_PRIVATE_T *private = (MMAL_COMPONENT_CORE_PRIVATE_T *)component->priv;
+   MMAL_ACTION_POOL_T *pool = &mmal_action_pool;
 
    if (!private->pf_action)
       return MMAL_EINVAL;
 
-   vcos_event_signal(&private->action_event);
+   vcos_mutex_lock(&pool->lock);
+   if (private->action_state == MMAL_ACTION_IDLE)
+   {
+      private->action_state = MMAL_ACTION_QUEUED;
+      private->action_next = NULL;
+      if (pool->tail)
+         ((MMAL_COMPONENT_CORE_PRIVATE_T *)pool->tail->priv)->action_next = component;
+      else
+         pool->head = component;
+      pool->tail = component;
+      vcos_semaphore_post(&pool->sema);
+   }
+   else if (private->action_state == MMAL_ACTION_RUNNING)
+      private->action_state = MMAL_ACTION_RETRIGGER;
+   vcos_mutex_unlock(&pool->lock);
    return MMAL_SUCCESS;
 }
 
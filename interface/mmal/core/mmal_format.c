@@ -39,6 +39,7 @@ typedef struct MMAL_ES_FORMAT_PRIVATE_T
    MMAL_ES_SPECIFIC_FORMAT_T es;
 
    uint32_t magic;
+   int refcount;
 
    unsigned int extradata_size;
    uint8_t *extradata;
@@ -57,6 +58,7 @@ MMAL_ES_FORMAT_T *mmal_format_alloc(void)
    memset(private, 0, sizeof(*private));
 
    private->magic = MMAL_ES_FORMAT_MAGIC;
+   private->refcount = 1;
    private->format.es = (void *)&private->es;
    private->extradata_size = EXTRADATA_SIZE_DEFAULT;
 
@@ -68,10 +70,30 @@ void mmal_format_free(MMAL_ES_FORMAT_T *format)
 {
    MMAL_ES_FORMAT_PRIVATE_T *private = (MMAL_ES_FORMAT_PRIVATE_T *)format;
    vcos_assert(private->magic == MMAL_ES_FORMAT_MAGIC);
+   vcos_assert(private->refcount == 1);
    if(private->extradata) vcos_free(private->extradata);
    vcos_free(private);
 }
 
+/** Acquire a reference to a format structure */
+void mmal_format_acquire(MMAL_ES_FORMAT_T *format)
+{
+   MMAL_ES_FORMAT_PRIVATE_T *private = (MMAL_ES_FORMAT_PRIVATE_T *)format;
+   vcos_assert(private->magic == MMAL_ES_FORMAT_MAGIC);
+   private->refcount++;
+}
+
+/** Release a reference to a format structure */
+void mmal_format_release(MMAL_ES_FORMAT_T *format)
+{
+   MMAL_ES_FORMAT_PRIVATE_T *private = (MMAL_ES_FORMAT_PRIVATE_T *)format;
+   vcos_assert(private->magic == MMAL_ES_FORMAT_MAGIC);
+   if(--private->refcount)
+      return;
+   private->refcount = 1;
+   mmal_format_free(format);
+}
+
 /** Copy a format structure */
 void mmal_format_copy(MMAL_ES_FORMAT_T *fmt_dst, MMAL_ES_FORMAT_T *fmt_src)
 {
@@ -86,6 +108,9 @@ void mmal_format_copy(MMAL_ES_FORMAT_T *fmt_dst, MMAL_ES_FORMAT_T *fmt_src)
 /** Full copy of a format structure (including extradata) */
 MMAL_STATUS_T mmal_format_full_copy(MMAL_ES_FORMAT_T *fmt_dst, MMAL_ES_FORMAT_T *fmt_src)
 {
+   if (fmt_dst == fmt_src)
+      return MMAL_SUCCESS;
+
    mmal_format_copy(fmt_dst, fmt_src);
 
    if (fmt_src->extradata_size)
@@ -105,6 +130,9 @@ uint32_t mmal_format_compare(MMAL_ES_FORMAT_T *fmt1, MMAL_ES_FORMAT_T *fmt2)
    MMAL_VIDEO_FORMAT_T *video1, *video2;
    uint32_t result = 0;
 
+   if (fmt1 == fmt2)
+      return 0;
+
    if (fmt1->type != fmt2->type)
       return MMAL_ES_FORMAT_COMPARE_FLAG_TYPE;
 
@@ -116,7 +144,8 @@ uint32_t mmal_format_compare(MMAL_ES_FORMAT_T *fmt1, MMAL_ES_FORMAT_T *fmt2)
       result |= MMAL_ES_FORMAT_COMPARE_FLAG_FLAGS;
    if (fmt1->extradata_size != fmt2->extradata_size ||
        (fmt1->extradata_size && (!fmt1->extradata || !fmt2->extradata)) ||
-       memcmp(fmt1->extradata, fmt2->extradata, fmt1->extradata_size))
+       (fmt1->extradata != fmt2->extradata &&
+        memcmp(fmt1->extradata, fmt2->extradata, fmt1->extradata_size)))
       result |= MMAL_ES_FORMAT_COMPARE_FLAG_EXTRADATA;
 
    /* Compare the ES specific information */
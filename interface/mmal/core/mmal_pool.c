@@ -28,7 +28,25 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "mmal.h"
 #include "mmal_pool.h"
 #include "core/mmal_buffer_private.h"
+#include "interface/vcos/vcos.h"
 #include "mmal_logging.h"
+#include <stdio.h>
+
+/** Extra slab of buffer headers appended to a pool by mmal_pool_grow */
+typedef struct MMAL_POOL_SLAB_T
+{
+   struct MMAL_POOL_SLAB_T *next;
+
+} MMAL_POOL_SLAB_T;
+
+/** Pointer array superseded by a grow operation. Readers might still be
+ * walking the old array so it is only freed when the pool is destroyed. */
+typedef struct MMAL_POOL_RETIRED_ARRAY_T
+{
+   struct MMAL_POOL_RETIRED_ARRAY_T *next;
+   MMAL_BUFFER_HEADER_T **array;
+
+} MMAL_POOL_RETIRED_ARRAY_T;
 
 /** Definition of a pool */
 typedef struct MMAL_POOL_PRIVATE_T
@@ -47,13 +65,30 @@ typedef struct MMAL_POOL_PRIVATE_T
 
    unsigned int headers_alloc_num; /**< Number of buffer headers allocated as part of the private structure */
 
+   void *headers_slab;   /**< Original allocation holding the pointer array and first headers */
+   VCOS_MUTEX_T grow_lock; /**< Serialises grow operations against each other */
+   MMAL_POOL_SLAB_T *slabs; /**< Extra slabs of buffer headers appended by grow operations */
+   MMAL_POOL_RETIRED_ARRAY_T *retired; /**< Pointer arrays superseded by grow operations */
+
 } MMAL_POOL_PRIVATE_T;
 
 #define ROUND_UP(s,align) ((((unsigned long)(s)) & ~((align)-1)) + (align))
 #define ALIGN  8
+/** Buffer headers are laid out in the slab one per cache line so headers
+ * recycled by different threads never share a line. 64 bytes covers the
+ * ARM cores we run on (the VideoCore L1 line is 32). */
+#define MMAL_POOL_CACHE_LINE 64
 
 static void mmal_pool_buffer_header_release(MMAL_BUFFER_HEADER_T *header);
 
+/** Returns the address of the first buffer header in the slab. The headers
+ * sit after the array of pointers, starting on a cache line boundary. */
+static MMAL_BUFFER_HEADER_T *mmal_pool_first_header(MMAL_POOL_T *pool, unsigned int headers)
+{
+   return (MMAL_BUFFER_HEADER_T *)ROUND_UP((unsigned long)pool->header +
+                                           sizeof(void *) * headers, MMAL_POOL_CACHE_LINE);
+}
+
 static void *mmal_pool_allocator_default_alloc(void *context, uint32_t size)
 {
    MMAL_PARAM_UNUSED(context);
@@ -66,48 +101,59 @@ static void mmal_pool_allocator_default_free(void *context, void *mem)
    vcos_free(mem);
 }
 
+/** Allocates a payload for an initialised buffer header and sets up the
+ * private fields which tie the header to its pool */
+static MMAL_STATUS_T mmal_pool_setup_buffer_header(MMAL_POOL_T *pool, MMAL_BUFFER_HEADER_T *header)
+{
+   MMAL_POOL_PRIVATE_T *private = (MMAL_POOL_PRIVATE_T *)pool;
+   uint8_t *payload = NULL;
+
+   if (private->payload_size && private->allocator_alloc)
+   {
+      LOG_TRACE("allocating %u bytes for payload", private->payload_size);
+      payload = (uint8_t*)private->allocator_alloc(private->allocator_context, private->payload_size);
+      if (! payload)
+         return MMAL_ENOMEM;
+   }
+   header->data = payload;
+   header->alloc_size = private->payload_size;
+   header->priv->pf_release = mmal_pool_buffer_header_release;
+   header->priv->owner = (void *)pool;
+   header->priv->refcount = 1;
+   header->priv->payload = payload;
+   header->priv->payload_context = private->allocator_context;
+   header->priv->pf_payload_free = private->allocator_free;
+   header->priv->payload_size = private->payload_size;
+
+   return MMAL_SUCCESS;
+}
+
 static MMAL_STATUS_T mmal_pool_initialise_buffer_headers(MMAL_POOL_T *pool, unsigned int headers,
                                                          MMAL_BOOL_T reinitialise)
 {
    MMAL_POOL_PRIVATE_T *private = (MMAL_POOL_PRIVATE_T *)pool;
    MMAL_BUFFER_HEADER_T *header;
-   uint8_t *payload = NULL;
    unsigned int i;
 
-   header = (MMAL_BUFFER_HEADER_T *)((uint8_t *)pool->header + ROUND_UP(sizeof(void *)*headers,ALIGN));
+   header = mmal_pool_first_header(pool, headers);
 
    for (i = 0; i < headers; i++)
    {
       if (reinitialise)
          header = mmal_buffer_header_initialise(header, private->header_size);
 
-      if (private->payload_size && private->allocator_alloc)
+      if (!(private->payload_size && private->allocator_alloc) &&
+          header->priv->pf_payload_free && header->priv->payload && header->priv->payload_size)
       {
-         LOG_TRACE("allocating %u bytes for payload %u/%u", private->payload_size, i, headers);
-         payload = (uint8_t*)private->allocator_alloc(private->allocator_context, private->payload_size);
-         if (! payload)
-         {
-            LOG_ERROR("failed to allocate payload %u/%u", i, headers);
-            return MMAL_ENOMEM;
-         }
+         LOG_TRACE("freeing %u bytes for payload %u/%u", header->priv->payload_size, i, headers);
+         header->priv->pf_payload_free(header->priv->payload_context, header->priv->payload);
       }
-      else
+
+      if (mmal_pool_setup_buffer_header(pool, header) != MMAL_SUCCESS)
       {
-         if (header->priv->pf_payload_free && header->priv->payload && header->priv->payload_size)
-         {
-            LOG_TRACE("freeing %u bytes for payload %u/%u", header->priv->payload_size, i, headers);
-            header->priv->pf_payload_free(header->priv->payload_context, header->priv->payload);
-         }
+         LOG_ERROR("failed to allocate payload %u/%u", i, headers);
+         return MMAL_ENOMEM;
       }
-      header->data = payload;
-      header->alloc_size = private->payload_size;
-      header->priv->pf_release = mmal_pool_buffer_header_release;
-      header->priv->owner = (void *)pool;
-      header->priv->refcount = 1;
-      header->priv->payload = payload;
-      header->priv->payload_context = private->allocator_context;
-      header->priv->pf_payload_free = private->allocator_free;
-      header->priv->payload_size = private->payload_size;
       pool->header[i] = header;
       pool->headers_num = i+1;
       header = (MMAL_BUFFER_HEADER_T *)((uint8_t*)header + private->header_size);
@@ -141,10 +187,12 @@ MMAL_POOL_T *mmal_pool_create_with_allocator(unsigned int headers, uint32_t payl
       return NULL;
    }
 
-   /* Calculate how much memory we need */
+   /* Calculate how much memory we need. Each header is rounded up to a whole
+    * number of cache lines and the array is given enough slack to place the
+    * first header on a cache line boundary. */
    pool_size = ROUND_UP(sizeof(MMAL_POOL_PRIVATE_T),ALIGN);
-   headers_array_size = ROUND_UP(sizeof(void *)*headers,ALIGN);
-   header_size = ROUND_UP(mmal_buffer_header_size(0),ALIGN);
+   headers_array_size = ROUND_UP(sizeof(void *)*headers,ALIGN) + MMAL_POOL_CACHE_LINE;
+   header_size = ROUND_UP(mmal_buffer_header_size(0),MMAL_POOL_CACHE_LINE);
 
    LOG_TRACE("allocating %u + %u + %u * %u bytes for pool",
              pool_size, headers_array_size, header_size, headers);
@@ -158,9 +206,18 @@ MMAL_POOL_T *mmal_pool_create_with_allocator(unsigned int headers, uint32_t payl
       mmal_queue_destroy(queue);
       return NULL;
    }
+   if (vcos_mutex_create(&private->grow_lock, "MMAL pool lock") != VCOS_SUCCESS)
+   {
+      LOG_ERROR("failed to create pool lock");
+      vcos_free(private);
+      vcos_free(array);
+      mmal_queue_destroy(queue);
+      return NULL;
+   }
    pool = &private->pool;
    pool->queue = queue;
    pool->header = (MMAL_BUFFER_HEADER_T **)array;
+   private->headers_slab = array;
    private->header_size = header_size;
    private->payload_size = payload_size;
    private->headers_alloc_num = headers;
@@ -194,6 +251,7 @@ MMAL_POOL_T *mmal_pool_create_with_allocator(unsigned int headers, uint32_t payl
 /** Destroy a pool of MMAL_BUFFER_HEADER_T */
 void mmal_pool_destroy(MMAL_POOL_T *pool)
 {
+   MMAL_POOL_PRIVATE_T *private = (MMAL_POOL_PRIVATE_T *)pool;
    unsigned int i;
 
    if (!pool)
@@ -209,10 +267,28 @@ void mmal_pool_destroy(MMAL_POOL_T *pool)
          priv->pf_payload_free(priv->payload_context, priv->payload);
    }
 
-   if (pool->header)
+   while (private->slabs)
+   {
+      MMAL_POOL_SLAB_T *slab = private->slabs;
+      private->slabs = slab->next;
+      vcos_free(slab);
+   }
+   while (private->retired)
+   {
+      MMAL_POOL_RETIRED_ARRAY_T *retired = private->retired;
+      private->retired = retired->next;
+      if ((void *)retired->array != private->headers_slab)
+         vcos_free(retired->array);
+      vcos_free(retired);
+   }
+
+   if (pool->header && (void *)pool->header != private->headers_slab)
       vcos_free(pool->header);
+   if (private->headers_slab)
+      vcos_free(private->headers_slab);
 
    if(pool->queue) mmal_queue_destroy(pool->queue);
+   vcos_mutex_delete(&private->grow_lock);
    vcos_free(pool);
 }
 
@@ -225,6 +301,11 @@ MMAL_STATUS_T mmal_pool_resize(MMAL_POOL_T *pool, unsigned int headers, uint32_t
    if (!private || !headers)
       return MMAL_EINVAL;
 
+   /* Resizing relies on all the buffer headers living in a single slab which
+    * is no longer the case once the pool has been grown */
+   if (private->slabs)
+      return MMAL_ENOSYS;
+
    /* Check if anything needs to be done */
    if (headers == pool->headers_num && payload_size == private->payload_size)
       return MMAL_SUCCESS;
@@ -244,11 +325,13 @@ MMAL_STATUS_T mmal_pool_resize(MMAL_POOL_T *pool, unsigned int headers, uint32_t
       private->headers_alloc_num = 0;
       if (pool->header)
          vcos_free(pool->header);
+      private->headers_slab = NULL;
       pool->header =
-         vcos_calloc(private->header_size * headers + ROUND_UP(sizeof(void *)*headers,ALIGN),
-                     1, "MMAL buffer headers");
+         vcos_calloc(private->header_size * headers + ROUND_UP(sizeof(void *)*headers,ALIGN) +
+                     MMAL_POOL_CACHE_LINE, 1, "MMAL buffer headers");
       if (!pool->header)
          return MMAL_ENOMEM;
+      private->headers_slab = pool->header;
       private->headers_alloc_num = headers;
    }
 
@@ -263,6 +346,82 @@ MMAL_STATUS_T mmal_pool_resize(MMAL_POOL_T *pool, unsigned int headers, uint32_t
    return MMAL_SUCCESS;
 }
 
+/** Grow a pool of MMAL_BUFFER_HEADER_T */
+MMAL_STATUS_T mmal_pool_grow(MMAL_POOL_T *pool, unsigned int headers)
+{
+   MMAL_POOL_PRIVATE_T *private = (MMAL_POOL_PRIVATE_T *)pool;
+   MMAL_POOL_RETIRED_ARRAY_T *retired;
+   MMAL_BUFFER_HEADER_T **array;
+   MMAL_BUFFER_HEADER_T *header;
+   MMAL_POOL_SLAB_T *slab;
+   unsigned int i, total;
+
+   if (!private || !headers)
+      return MMAL_EINVAL;
+
+   vcos_mutex_lock(&private->grow_lock);
+   total = pool->headers_num + headers;
+
+   /* The new buffer headers live in their own slab so the ones already in
+    * flight are left untouched. The array of pointers however needs to cover
+    * the whole pool so a bigger copy of it is made. */
+   slab = vcos_calloc(ROUND_UP(sizeof(*slab),ALIGN) + MMAL_POOL_CACHE_LINE +
+                      private->header_size * headers, 1, "MMAL pool slab");
+   array = vcos_calloc(sizeof(void *) * total, 1, "MMAL buffer headers");
+   retired = vcos_calloc(sizeof(*retired), 1, "MMAL pool retired array");
+   if (!slab || !array || !retired)
+   {
+      LOG_ERROR("failed to allocate %u extra headers", headers);
+      goto error;
+   }
+
+   header = (MMAL_BUFFER_HEADER_T *)ROUND_UP((unsigned long)slab + sizeof(*slab),
+                                             MMAL_POOL_CACHE_LINE);
+   for (i = 0; i < headers; i++)
+   {
+      header = mmal_buffer_header_initialise(header, private->header_size);
+      if (mmal_pool_setup_buffer_header(pool, header) != MMAL_SUCCESS)
+      {
+         LOG_ERROR("failed to allocate payload %u/%u", i, headers);
+         while (i--)
+         {
+            MMAL_BUFFER_HEADER_PRIVATE_T *priv = array[pool->headers_num + i]->priv;
+            if (priv->pf_payload_free && priv->payload && priv->payload_size)
+               priv->pf_payload_free(priv->payload_context, priv->payload);
+         }
+         goto error;
+      }
+      array[pool->headers_num + i] = header;
+      header = (MMAL_BUFFER_HEADER_T *)((uint8_t*)header + private->header_size);
+   }
+
+   memcpy(array, pool->header, sizeof(void *) * pool->headers_num);
+
+   /* Swap in the new array with a single pointer write so concurrent readers
+    * see either the old array or the new fully populated one. The old array
+    * might still be getting walked so it is only retired, not freed. */
+   retired->array = pool->header;
+   retired->next = private->retired;
+   private->retired = retired;
+   slab->next = private->slabs;
+   private->slabs = slab;
+   pool->header = array;
+   pool->headers_num = total;
+
+   for (i = 0; i < headers; i++)
+      mmal_queue_put(pool->queue, array[total - headers + i]);
+
+   vcos_mutex_unlock(&private->grow_lock);
+   return MMAL_SUCCESS;
+
+ error:
+   if (slab) vcos_free(slab);
+   if (array) vcos_free(array);
+   if (retired) vcos_free(retired);
+   vcos_mutex_unlock(&private->grow_lock);
+   return MMAL_ENOMEM;
+}
+
 /** Buffer header release callback.
  * Call out to a further client callback and put the buffer back in the queue
  * so it can be reused, unless the client callback prevents it. */
@@ -273,6 +432,8 @@ static void mmal_pool_buffer_header_release(MMAL_BUFFER_HEADER_T *header)
    MMAL_BOOL_T queue_buffer = 1;
 
    header->priv->refcount = 1;
+   if (mmal_buffer_trace_enabled)
+      mmal_buffer_header_trace(header, pool);
    if(private->cb)
       queue_buffer = private->cb(pool, header, private->userdata);
    if (queue_buffer)
@@ -291,13 +452,46 @@ void mmal_pool_callback_set(MMAL_POOL_T *pool, MMAL_POOL_BH_CB_T cb, void *userd
 void mmal_pool_pre_release_callback_set(MMAL_POOL_T *pool, MMAL_BH_PRE_RELEASE_CB_T cb, void *userdata)
 {
    unsigned int i;
-   MMAL_POOL_PRIVATE_T *private = (MMAL_POOL_PRIVATE_T *)pool;
-   MMAL_BUFFER_HEADER_T *header =
-         (MMAL_BUFFER_HEADER_T*)((uint8_t*)pool->header + ROUND_UP(sizeof(void*)*pool->headers_num,ALIGN));
 
+   /* The headers of a grown pool span several slabs so they can only be
+    * reached through the pointer array, not with a fixed stride */
    for (i = 0; i < pool->headers_num; ++i)
+      mmal_buffer_header_pre_release_cb_set(pool->header[i], cb, userdata);
+}
+
+/* Enable or disable buffer provenance tracing */
+void mmal_pool_trace_enable(MMAL_BOOL_T enable)
+{
+   mmal_buffer_trace_enabled = enable;
+}
+
+/* Log the recorded owner transitions of every buffer header in a pool */
+void mmal_pool_trace_dump(MMAL_POOL_T *pool)
+{
+   uint32_t now = vcos_getmicrosecs();
+   unsigned int i, j;
+
+   for (i = 0; i < pool->headers_num; i++)
    {
-      mmal_buffer_header_pre_release_cb_set(header, cb, userdata);
-      header = (MMAL_BUFFER_HEADER_T *)((uint8_t*)header + private->header_size);
+      MMAL_BUFFER_HEADER_PRIVATE_T *priv = pool->header[i]->priv;
+      char line[MMAL_BUFFER_TRACE_ENTRIES * 32];
+      size_t offset = 0;
+
+      /* Walk the ring oldest entry first */
+      for (j = 0; j < MMAL_BUFFER_TRACE_ENTRIES; j++)
+      {
+         MMAL_BUFFER_TRACE_ENTRY_T *entry =
+            &priv->trace[(priv->trace_index + j) & (MMAL_BUFFER_TRACE_ENTRIES - 1)];
+
+         if (!entry->owner)
+            continue;
+         offset += snprintf(line + offset, sizeof(line) - offset, " %p@-%uus",
+                            entry->owner, (unsigned int)(now - entry->time));
+         if (offset >= sizeof(line))
+            break;
+      }
+
+      LOG_INFO("buffer %p refcount %i:%s", pool->header[i], (int)priv->refcount,
+               offset ? line : " no transitions recorded");
    }
 }
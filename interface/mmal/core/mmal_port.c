@@ -27,9 +27,11 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "mmal.h"
 #include "util/mmal_util.h"
+#include "core/mmal_buffer_private.h"
 #include "core/mmal_component_private.h"
 #include "core/mmal_port_private.h"
 #include "interface/vcos/vcos.h"
+#include "interface/vcos/vcos_usdt.h"
 #include "mmal_logging.h"
 #include "interface/mmal/util/mmal_util.h"
 #include "interface/mmal/mmal_parameters.h"
@@ -48,6 +50,11 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 # define MMAL_COLLECT_PORT_STATS_ENABLED 0
 #endif
 
+/* Process-wide counters on the shared vcos telemetry page, registered
+ * lazily on first use so idle clients never map the page */
+static volatile uint32_t *telemetry_buffers_sent;
+static volatile uint32_t *telemetry_send_failures;
+
 static MMAL_STATUS_T mmal_port_private_parameter_get(MMAL_PORT_T *port,
                                                      MMAL_PARAMETER_HEADER_T *param);
 
@@ -57,6 +64,32 @@ static MMAL_STATUS_T mmal_port_private_parameter_set(MMAL_PORT_T *port,
 /* Define this if you want to log all buffer transfers */
 //#define ENABLE_MMAL_EXTRA_LOGGING
 
+/** Step and ceiling used when growing a component's event pool on demand.
+ * Event buffers are small so the ceiling is mostly a safeguard against a
+ * component which leaks its events. */
+#define MMAL_CONTROL_PORT_BUFFERS_GROW 4
+#define MMAL_CONTROL_PORT_BUFFERS_MAX 64
+
+/** Alignment used for the payloads carved out of a payload slab when the
+ * port does not request anything stricter */
+#define MMAL_PORT_PAYLOAD_SLAB_ALIGN 32
+
+/** Definition of a payload slab. A single large allocation out of which
+ * per-buffer payloads are carved. The underlying memory is freed once the
+ * slab has been released and all its payloads freed. */
+struct MMAL_PORT_PAYLOAD_SLAB_T
+{
+   struct MMAL_PORT_PAYLOAD_SLAB_T *next;
+
+   uint8_t *mem;              /**< Underlying allocation */
+   uint32_t mem_size;         /**< Size of the underlying allocation */
+   uint32_t payload_size;     /**< Size of the payloads served by this slab */
+   uint32_t stride;           /**< Aligned distance between consecutive payloads */
+   unsigned int available;    /**< Number of payloads which can still be carved */
+   unsigned int carved;       /**< Number of payloads carved so far */
+   unsigned int refcount;     /**< Outstanding payloads plus the creation reference */
+};
+
 /** Definition of the core's private structure for a port. */
 typedef struct MMAL_PORT_PRIVATE_CORE_T
 {
@@ -70,9 +103,12 @@ typedef struct MMAL_PORT_PRIVATE_CORE_T
 
    /** Keeps track of the number of buffer headers currently in transit in this port */
    int32_t transit_buffer_headers;
-   VCOS_MUTEX_T transit_lock;
    VCOS_SEMAPHORE_T transit_sema;
 
+   /** Client guarantees it sends buffers from a single thread and never
+    * concurrently with a disable, so the send lock can be elided */
+   MMAL_BOOL_T single_producer;
+
    /** Copy of the public port format pointer, to detect accidental overwrites */
    MMAL_ES_FORMAT_T* format_ptr_copy;
 
@@ -95,6 +131,13 @@ typedef struct MMAL_PORT_PRIVATE_CORE_T
    /** Per-port statistics collected directly by the MMAL core */
    MMAL_CORE_PORT_STATISTICS_T stats;
 
+   /** Always-on port counters, maintained with atomic operations on the
+    * per-buffer hot path and read without locking */
+   MMAL_PORT_STATS_T counters;
+
+   /** List of payload slabs created on this port */
+   MMAL_PORT_PAYLOAD_SLAB_T *slabs;
+
    char *name; /**< Port name */
    unsigned int name_size; /** Size of the memory area reserved for the name string */
 } MMAL_PORT_PRIVATE_CORE_T;
@@ -117,6 +160,7 @@ static MMAL_BOOL_T mmal_port_connected_pool_cb(MMAL_POOL_T *pool, MMAL_BUFFER_HE
 
 static void mmal_port_name_update(MMAL_PORT_T *port);
 static void mmal_port_update_port_stats(MMAL_PORT_T *port, MMAL_CORE_STATS_DIR direction);
+static void mmal_port_counter_max(volatile uint32_t *counter, uint32_t value);
 
 /*****************************************************************************/
 
@@ -133,17 +177,18 @@ static void mmal_port_update_port_stats(MMAL_PORT_T *port, MMAL_CORE_STATS_DIR d
 #define UNLOCK_CONNECTION(a) vcos_mutex_unlock(&(a)->priv->core->connection_lock);
 
 /* Macros used to make mmal_port_disable() blocking until all
- * the buffers have been sent back to the client */
+ * the buffers have been sent back to the client.
+ * The counter is maintained with atomic ops since sends and buffer
+ * callbacks happen on different threads and this is on the per-buffer
+ * hot path. The semaphore is taken by whoever brings the counter away
+ * from zero and given back by whoever brings it back to zero, so waiting
+ * on it amounts to waiting for the count to drop to zero. */
 #define IN_TRANSIT_INCREMENT(a) \
-   vcos_mutex_lock(&(a)->priv->core->transit_lock); \
-   if (!(a)->priv->core->transit_buffer_headers++) \
-      vcos_semaphore_wait(&(a)->priv->core->transit_sema); \
-   vcos_mutex_unlock(&(a)->priv->core->transit_lock)
+   if (!__sync_fetch_and_add(&(a)->priv->core->transit_buffer_headers, 1)) \
+      vcos_semaphore_wait(&(a)->priv->core->transit_sema)
 #define IN_TRANSIT_DECREMENT(a) \
-   vcos_mutex_lock(&(a)->priv->core->transit_lock); \
-   if (!--(a)->priv->core->transit_buffer_headers) \
-      vcos_semaphore_post(&(a)->priv->core->transit_sema); \
-   vcos_mutex_unlock(&(a)->priv->core->transit_lock)
+   if (!__sync_sub_and_fetch(&(a)->priv->core->transit_buffer_headers, 1)) \
+      vcos_semaphore_post(&(a)->priv->core->transit_sema)
 #define IN_TRANSIT_WAIT(a) \
    vcos_semaphore_wait(&(a)->priv->core->transit_sema); \
    vcos_semaphore_post(&(a)->priv->core->transit_sema)
@@ -162,7 +207,7 @@ MMAL_PORT_T *mmal_port_alloc(MMAL_COMPONENT_T *component, MMAL_PORT_TYPE_T type,
    unsigned int name_size = strlen(component->name) + sizeof(PORT_NAME_FORMAT);
    unsigned int size = sizeof(*port) + sizeof(MMAL_PORT_PRIVATE_T) +
       sizeof(MMAL_PORT_PRIVATE_CORE_T) + name_size + extra_size;
-   MMAL_BOOL_T lock = 0, lock_send = 0, lock_transit = 0, sema_transit = 0;
+   MMAL_BOOL_T lock = 0, lock_send = 0, sema_transit = 0;
    MMAL_BOOL_T lock_stats = 0, lock_connection = 0;
 
    LOG_TRACE("component:%s type:%u extra:%u", component->name, type, extra_size);
@@ -189,15 +234,14 @@ MMAL_PORT_T *mmal_port_alloc(MMAL_COMPONENT_T *component, MMAL_PORT_TYPE_T type,
 
    lock = vcos_mutex_create(&port->priv->core->lock, "mmal port lock") == VCOS_SUCCESS;
    lock_send = vcos_mutex_create(&port->priv->core->send_lock, "mmal port send lock") == VCOS_SUCCESS;
-   lock_transit = vcos_mutex_create(&port->priv->core->transit_lock, "mmal port transit lock") == VCOS_SUCCESS;
    sema_transit = vcos_semaphore_create(&port->priv->core->transit_sema, "mmal port transit sema", 1) == VCOS_SUCCESS;
    lock_stats = vcos_mutex_create(&port->priv->core->stats_lock, "mmal stats lock") == VCOS_SUCCESS;
    lock_connection = vcos_mutex_create(&port->priv->core->connection_lock, "mmal connection lock") == VCOS_SUCCESS;
 
-   if (!lock || !lock_send || !lock_transit || !sema_transit || !lock_stats || !lock_connection)
+   if (!lock || !lock_send || !sema_transit || !lock_stats || !lock_connection)
    {
-      LOG_ERROR("%s: failed to create sync objects (%u,%u,%u,%u,%u,%u)",
-            port->name, lock, lock_send, lock_transit, sema_transit, lock_stats, lock_connection);
+      LOG_ERROR("%s: failed to create sync objects (%u,%u,%u,%u,%u)",
+            port->name, lock, lock_send, sema_transit, lock_stats, lock_connection);
       goto error;
    }
 
@@ -215,7 +259,6 @@ MMAL_PORT_T *mmal_port_alloc(MMAL_COMPONENT_T *component, MMAL_PORT_TYPE_T type,
  error:
    if (lock) vcos_mutex_delete(&port->priv->core->lock);
    if (lock_send) vcos_mutex_delete(&port->priv->core->send_lock);
-   if (lock_transit) vcos_mutex_delete(&port->priv->core->transit_lock);
    if (sema_transit) vcos_semaphore_delete(&port->priv->core->transit_sema);
    if (lock_stats) vcos_mutex_delete(&port->priv->core->stats_lock);
    if (lock_connection) vcos_mutex_delete(&port->priv->core->connection_lock);
@@ -237,7 +280,6 @@ void mmal_port_free(MMAL_PORT_T *port)
    vcos_mutex_delete(&port->priv->core->connection_lock);
    vcos_mutex_delete(&port->priv->core->stats_lock);
    vcos_semaphore_delete(&port->priv->core->transit_sema);
-   vcos_mutex_delete(&port->priv->core->transit_lock);
    vcos_mutex_delete(&port->priv->core->send_lock);
    vcos_mutex_delete(&port->priv->core->lock);
    vcos_free(port);
@@ -710,6 +752,8 @@ MMAL_STATUS_T mmal_port_send_buffer(MMAL_PORT_T *port,
    MMAL_BUFFER_HEADER_T *buffer)
 {
    MMAL_STATUS_T status = MMAL_SUCCESS;
+   MMAL_BOOL_T lock_sending;
+   uint32_t bytes;
 
    if (!port || !port->priv)
    {
@@ -733,11 +777,19 @@ MMAL_STATUS_T mmal_port_send_buffer(MMAL_PORT_T *port,
    if (!port->priv->pf_send)
       return MMAL_ENOSYS;
 
-   LOCK_SENDING(port);
+   /* Clients which have declared themselves as single producers guarantee
+    * that sends never race each other or a disable, so the send lock can
+    * be elided. It is still taken in the rare paused case since pausing
+    * flushes the internal queue from another thread. */
+   lock_sending = !port->priv->core->single_producer;
+
+   if (lock_sending)
+      LOCK_SENDING(port);
 
    if (!port->is_enabled)
    {
-      UNLOCK_SENDING(port);
+      if (lock_sending)
+         UNLOCK_SENDING(port);
       return MMAL_EINVAL;
    }
 
@@ -747,10 +799,22 @@ MMAL_STATUS_T mmal_port_send_buffer(MMAL_PORT_T *port,
       buffer->length = 0;
    }
 
+   /* The component owns the buffer once it has been sent, so sample the
+    * payload size and record provenance now */
+   bytes = buffer->length;
+   if (mmal_buffer_trace_enabled)
+      mmal_buffer_header_trace(buffer, port);
+
    /* coverity[lock] transit_sema is used for signalling, and is not a lock */
    /* coverity[lock_order] since transit_sema is not a lock, there is no ordering conflict */
    IN_TRANSIT_INCREMENT(port);
 
+   if (port->priv->core->is_paused && !lock_sending)
+   {
+      LOCK_SENDING(port);
+      lock_sending = 1;
+   }
+
    if (port->priv->core->is_paused)
    {
       /* Add buffer to our internal queue */
@@ -768,13 +832,164 @@ MMAL_STATUS_T mmal_port_send_buffer(MMAL_PORT_T *port,
    {
       IN_TRANSIT_DECREMENT(port);
       LOG_ERROR("%s: send failed: %s", port->name, mmal_status_to_string(status));
+      if (!telemetry_send_failures)
+         telemetry_send_failures = vcos_telemetry_counter("mmal.send_failures");
+      vcos_telemetry_add(telemetry_send_failures, 1);
    }
    else
    {
+      VCOS_PROBE3(mmal, buffer_send, port, buffer, bytes);
+      __sync_fetch_and_add(&port->priv->core->counters.buffers_rx, 1);
+      __sync_fetch_and_add(&port->priv->core->counters.bytes_rx, bytes);
+      mmal_port_counter_max(&port->priv->core->counters.transit_high_water,
+                            IN_TRANSIT_COUNT(port));
       mmal_port_update_port_stats(port, MMAL_CORE_STATS_RX);
+      if (!telemetry_buffers_sent)
+         telemetry_buffers_sent = vcos_telemetry_counter("mmal.buffers_sent");
+      vcos_telemetry_add(telemetry_buffers_sent, 1);
    }
 
-   UNLOCK_SENDING(port);
+   if (lock_sending)
+      UNLOCK_SENDING(port);
+   return status;
+}
+
+/** Send a list of buffer headers to a port */
+MMAL_STATUS_T mmal_port_send_buffer_list(MMAL_PORT_T *port,
+   MMAL_BUFFER_HEADER_T **buffers, unsigned int num)
+{
+   MMAL_STATUS_T status = MMAL_SUCCESS;
+   MMAL_BOOL_T lock_sending;
+   unsigned int i, sent = 0;
+   uint32_t bytes_sent = 0;
+
+   if (!port || !port->priv || !buffers)
+   {
+      LOG_ERROR("invalid port");
+      return MMAL_EINVAL;
+   }
+
+   if (!num)
+      return MMAL_SUCCESS;
+
+   /* Validate the whole list upfront so we do not stop half-way through.
+    * This is also the last point where we are guaranteed to own all the
+    * buffers, so sample the payload sizes for the port counters now. */
+   for (i = 0; i < num; i++)
+   {
+      if (!buffers[i] ||
+          (!buffers[i]->data && !(port->capabilities & MMAL_PORT_CAPABILITY_PASSTHROUGH)))
+      {
+         LOG_ERROR("%s(%p) received invalid buffer header", port->name, port);
+         return MMAL_EINVAL;
+      }
+      bytes_sent += buffers[i]->length;
+   }
+
+   if (!port->priv->pf_send)
+      return MMAL_ENOSYS;
+
+   /* See mmal_port_send_buffer for the single producer lock elision */
+   lock_sending = !port->priv->core->single_producer;
+
+   if (lock_sending)
+      LOCK_SENDING(port);
+
+   if (!port->is_enabled)
+   {
+      if (lock_sending)
+         UNLOCK_SENDING(port);
+      return MMAL_EINVAL;
+   }
+
+   if (port->priv->core->is_paused && !lock_sending)
+   {
+      LOCK_SENDING(port);
+      lock_sending = 1;
+   }
+
+   if (port->type == MMAL_PORT_TYPE_OUTPUT)
+   {
+      for (i = 0; i < num; i++)
+      {
+         if (buffers[i]->length)
+         {
+            LOG_DEBUG("given an output buffer with length != 0");
+            buffers[i]->length = 0;
+         }
+      }
+      bytes_sent = 0;
+   }
+
+   if (mmal_buffer_trace_enabled)
+      for (i = 0; i < num; i++)
+         mmal_buffer_header_trace(buffers[i], port);
+
+   if (port->priv->core->is_paused)
+   {
+      /* Add buffers to our internal queue */
+      for (sent = 0; sent < num; sent++)
+      {
+         IN_TRANSIT_INCREMENT(port);
+         buffers[sent]->next = NULL;
+         *port->priv->core->queue_last = buffers[sent];
+         port->priv->core->queue_last = &buffers[sent]->next;
+      }
+   }
+   else if (port->priv->pf_send_list)
+   {
+      /* Let the component submit the whole list in one transaction */
+      for (i = 0; i < num; i++)
+         IN_TRANSIT_INCREMENT(port);
+      status = port->priv->pf_send_list(port, buffers, num, &sent);
+      for (i = sent; i < num; i++)
+         IN_TRANSIT_DECREMENT(port);
+   }
+   else
+   {
+      /* Send buffers to the component one at a time */
+      for (sent = 0; sent < num; sent++)
+      {
+         IN_TRANSIT_INCREMENT(port);
+         status = port->priv->pf_send(port, buffers[sent]);
+         if (status != MMAL_SUCCESS)
+         {
+            IN_TRANSIT_DECREMENT(port);
+            break;
+         }
+      }
+   }
+
+   if (status != MMAL_SUCCESS)
+      LOG_ERROR("%s: send failed: %s", port->name, mmal_status_to_string(status));
+
+   /* Buffers which were not sent are still ours, so their payload sizes can
+    * safely be deducted from the upfront sample */
+   for (i = sent; i < num; i++)
+      bytes_sent -= buffers[i]->length;
+
+   if (sent)
+   {
+      __sync_fetch_and_add(&port->priv->core->counters.buffers_rx, sent);
+      __sync_fetch_and_add(&port->priv->core->counters.bytes_rx, bytes_sent);
+      mmal_port_counter_max(&port->priv->core->counters.transit_high_water,
+                            IN_TRANSIT_COUNT(port));
+      if (!telemetry_buffers_sent)
+         telemetry_buffers_sent = vcos_telemetry_counter("mmal.buffers_sent");
+      vcos_telemetry_add(telemetry_buffers_sent, sent);
+   }
+   if (status != MMAL_SUCCESS)
+   {
+      if (!telemetry_send_failures)
+         telemetry_send_failures = vcos_telemetry_counter("mmal.send_failures");
+      vcos_telemetry_add(telemetry_send_failures, 1);
+   }
+
+   for (i = 0; i < sent; i++)
+      mmal_port_update_port_stats(port, MMAL_CORE_STATS_RX);
+
+   if (lock_sending)
+      UNLOCK_SENDING(port);
    return status;
 }
 
@@ -895,6 +1110,9 @@ MMAL_STATUS_T mmal_port_parameter_get(MMAL_PORT_T *port,
 /** Buffer header callback. */
 void mmal_port_buffer_header_callback(MMAL_PORT_T *port, MMAL_BUFFER_HEADER_T *buffer)
 {
+   uint32_t bytes = buffer->length;
+   unsigned int stc = 0;
+
 #ifdef ENABLE_MMAL_EXTRA_LOGGING
    LOG_TRACE("%s(%i:%i) port %p, buffer %p (%i,%p,%i,%i)",
              port->component->name, (int)port->type, (int)port->index, port, buffer,
@@ -908,10 +1126,21 @@ void mmal_port_buffer_header_callback(MMAL_PORT_T *port, MMAL_BUFFER_HEADER_T *b
    if (MMAL_COLLECT_PORT_STATS_ENABLED)
    {
       mmal_port_update_port_stats(port, MMAL_CORE_STATS_TX);
+      stc = vcos_getmicrosecs();
    }
 
+   VCOS_PROBE3(mmal, buffer_callback, port, buffer, bytes);
+   if (mmal_buffer_trace_enabled)
+      mmal_buffer_header_trace(buffer, port);
+   __sync_fetch_and_add(&port->priv->core->counters.buffers_tx, 1);
+   __sync_fetch_and_add(&port->priv->core->counters.bytes_tx, bytes);
+
    port->priv->core->buffer_header_callback(port, buffer);
 
+   if (MMAL_COLLECT_PORT_STATS_ENABLED)
+      mmal_port_counter_max(&port->priv->core->counters.callback_max_us,
+                            vcos_getmicrosecs() - stc);
+
    IN_TRANSIT_DECREMENT(port);
 }
 
@@ -1080,9 +1309,45 @@ end:
    return status;
 }
 
+/** Allocate payload memory straight from the port's allocator (or the heap).
+ * Must be called with the port lock held when the port provides an allocator. */
+static uint8_t *mmal_port_payload_alloc_mem(MMAL_PORT_T *port, uint32_t payload_size)
+{
+   if (!port->priv->pf_payload_alloc)
+   {
+      /* Revert to using the heap */
+#ifdef _VIDEOCORE
+      return (void *)mem_alloc(payload_size, 32, MEM_FLAG_DIRECT, port->name);
+#else
+      return vcos_malloc(payload_size, "mmal payload");
+#endif
+   }
+
+   return port->priv->pf_payload_alloc(port, payload_size);
+}
+
+/** Free payload memory allocated by mmal_port_payload_alloc_mem.
+ * Must be called with the port lock held when the port provides an allocator. */
+static void mmal_port_payload_free_mem(MMAL_PORT_T *port, uint8_t *payload)
+{
+   if (!port->priv->pf_payload_alloc)
+   {
+      /* Revert to using the heap */
+#ifdef _VIDEOCORE
+      mem_release((MEM_HANDLE_T)payload);
+#else
+      vcos_free(payload);
+#endif
+      return;
+   }
+
+   port->priv->pf_payload_free(port, payload);
+}
+
 /** Allocate a payload buffer */
 uint8_t *mmal_port_payload_alloc(MMAL_PORT_T *port, uint32_t payload_size)
 {
+   MMAL_PORT_PAYLOAD_SLAB_T *slab;
    uint8_t *mem;
 
    if (!port || !port->priv)
@@ -1096,22 +1361,26 @@ uint8_t *mmal_port_payload_alloc(MMAL_PORT_T *port, uint32_t payload_size)
 
    /* TODO: keep track of the allocs so we can free them when the component is destroyed */
 
-   if (!port->priv->pf_payload_alloc)
+   LOCK_PORT(port);
+
+   /* Carve the payload out of a slab whenever one has been set up for
+    * allocations of this size */
+   for (slab = port->priv->core->slabs; slab; slab = slab->next)
+      if (slab->payload_size == payload_size && slab->available)
+         break;
+   if (slab)
    {
-      /* Revert to using the heap */
-#ifdef _VIDEOCORE
-      mem = (void *)mem_alloc(payload_size, 32, MEM_FLAG_DIRECT, port->name);
-#else
-      mem = vcos_malloc(payload_size, "mmal payload");
-#endif
-      goto end;
+      mem = slab->mem + (uint32_t)slab->carved++ * slab->stride;
+      slab->available--;
+      slab->refcount++;
+   }
+   else
+   {
+      mem = mmal_port_payload_alloc_mem(port, payload_size);
    }
 
-   LOCK_PORT(port);
-   mem = port->priv->pf_payload_alloc(port, payload_size);
    UNLOCK_PORT(port);
 
- end:
    /* Acquire the port if the allocation was successful.
     * This will ensure that the component is not destroyed until the payload has been freed. */
    if (mem)
@@ -1122,30 +1391,130 @@ uint8_t *mmal_port_payload_alloc(MMAL_PORT_T *port, uint32_t payload_size)
 /** Free a payload buffer */
 void mmal_port_payload_free(MMAL_PORT_T *port, uint8_t *payload)
 {
+   MMAL_PORT_PAYLOAD_SLAB_T *slab, **prev;
+
    if (!port || !port->priv)
       return;
 
    LOG_TRACE("%s(%i:%i) port %p, payload %p", port->component->name,
              (int)port->type, (int)port->index, port, payload);
 
-   if (!port->priv->pf_payload_alloc)
+   LOCK_PORT(port);
+
+   /* Payloads which were carved out of a slab just drop their reference on
+    * it. The underlying memory is freed with the last reference. */
+   for (prev = &port->priv->core->slabs; (slab = *prev) != NULL; prev = &slab->next)
+      if (payload >= slab->mem && payload < slab->mem + slab->mem_size)
+         break;
+   if (slab)
    {
-      /* Revert to using the heap */
-#ifdef _VIDEOCORE
-      mem_release((MEM_HANDLE_T)payload);
-#else
-      vcos_free(payload);
-#endif
+      if (!--slab->refcount)
+      {
+         *prev = slab->next;
+         mmal_port_payload_free_mem(port, slab->mem);
+         UNLOCK_PORT(port);
+         vcos_free(slab);
+         mmal_port_release(port); /* Release for the slab memory itself */
+      }
+      else
+      {
+         UNLOCK_PORT(port);
+      }
       mmal_port_release(port);
       return;
    }
 
-   LOCK_PORT(port);
-   port->priv->pf_payload_free(port, payload);
+   mmal_port_payload_free_mem(port, payload);
    UNLOCK_PORT(port);
    mmal_port_release(port);
 }
 
+/** Create a payload slab */
+MMAL_PORT_PAYLOAD_SLAB_T *mmal_port_payload_slab_create(MMAL_PORT_T *port,
+   uint32_t payload_size, unsigned int num)
+{
+   MMAL_PORT_PAYLOAD_SLAB_T *slab;
+   uint32_t align, stride;
+
+   if (!port || !port->priv || !payload_size || !num)
+      return NULL;
+
+   LOG_TRACE("%s(%i:%i) port %p, size %i, num %u", port->component->name,
+             (int)port->type, (int)port->index, port, (int)payload_size, num);
+
+   /* Ports which deal in handles rather than plain memory (e.g. shared
+    * memory or opaque buffers) allocate their payloads one by one */
+   if (port->priv->payload_slab_unsupported ||
+       port->format->encoding == MMAL_ENCODING_OPAQUE)
+      return NULL;
+
+   align = port->buffer_alignment_min;
+   if (align < MMAL_PORT_PAYLOAD_SLAB_ALIGN)
+      align = MMAL_PORT_PAYLOAD_SLAB_ALIGN;
+   stride = (payload_size + align - 1) / align * align;
+
+   /* Watch out for overflows on huge requests */
+   if (stride < payload_size || stride > UINT32_MAX / num)
+      return NULL;
+
+   slab = vcos_calloc(1, sizeof(*slab), "mmal payload slab");
+   if (!slab)
+      return NULL;
+
+   slab->payload_size = payload_size;
+   slab->stride = stride;
+   slab->mem_size = stride * num;
+   slab->available = num;
+   slab->refcount = 1; /* Creation reference, dropped on release */
+
+   LOCK_PORT(port);
+   slab->mem = mmal_port_payload_alloc_mem(port, slab->mem_size);
+   if (!slab->mem)
+   {
+      UNLOCK_PORT(port);
+      LOG_ERROR("%s(%i:%i) could not allocate %i bytes for slab", port->component->name,
+                (int)port->type, (int)port->index, (int)slab->mem_size);
+      vcos_free(slab);
+      return NULL;
+   }
+   slab->next = port->priv->core->slabs;
+   port->priv->core->slabs = slab;
+   UNLOCK_PORT(port);
+
+   /* Keep the component alive while the slab memory is */
+   mmal_port_acquire(port);
+   return slab;
+}
+
+/** Release a payload slab */
+void mmal_port_payload_slab_release(MMAL_PORT_T *port, MMAL_PORT_PAYLOAD_SLAB_T *slab)
+{
+   MMAL_PORT_PAYLOAD_SLAB_T **prev;
+
+   if (!port || !port->priv || !slab)
+      return;
+
+   LOG_TRACE("%s(%i:%i) port %p, slab %p", port->component->name,
+             (int)port->type, (int)port->index, port, slab);
+
+   LOCK_PORT(port);
+   slab->available = 0; /* No more payloads will be carved out of it */
+   if (!--slab->refcount)
+   {
+      for (prev = &port->priv->core->slabs; *prev; prev = &(*prev)->next)
+         if (*prev == slab)
+            break;
+      if (vcos_verify(*prev))
+         *prev = slab->next;
+      mmal_port_payload_free_mem(port, slab->mem);
+      UNLOCK_PORT(port);
+      vcos_free(slab);
+      mmal_port_release(port);
+      return;
+   }
+   UNLOCK_PORT(port);
+}
+
 MMAL_STATUS_T mmal_port_event_get(MMAL_PORT_T *port, MMAL_BUFFER_HEADER_T **buffer, uint32_t event)
 {
    if (!port || !port->priv || !buffer)
@@ -1154,8 +1523,18 @@ MMAL_STATUS_T mmal_port_event_get(MMAL_PORT_T *port, MMAL_BUFFER_HEADER_T **buff
    LOG_TRACE("%s(%i:%i) port %p, event %4.4s", port->component->name,
              (int)port->type, (int)port->index, port, (char *)&event);
 
-   /* Get an event buffer from our event pool */
-   *buffer = mmal_queue_get(port->component->priv->event_pool->queue);
+   /* Get an event buffer from our event pool. The pool is only sized for the
+    * steady state so bursts of events (e.g. when switching streams) can
+    * exhaust it; grow it on demand rather than have the component stall
+    * retrying. */
+   while (!(*buffer = mmal_queue_get(port->component->priv->event_pool->queue)))
+   {
+      MMAL_POOL_T *pool = port->component->priv->event_pool;
+
+      if (pool->headers_num >= MMAL_CONTROL_PORT_BUFFERS_MAX ||
+          mmal_pool_grow(pool, MMAL_CONTROL_PORT_BUFFERS_GROW) != MMAL_SUCCESS)
+         break;
+   }
    if (!*buffer)
    {
       LOG_ERROR("%s(%i:%i) port %p, no event buffer left for %4.4s", port->component->name,
@@ -1437,6 +1816,44 @@ static void mmal_port_update_port_stats(MMAL_PORT_T *port, MMAL_CORE_STATS_DIR d
    vcos_mutex_unlock(&core->stats_lock);
 }
 
+/** Atomically raise a counter to a new maximum. Used on the per-buffer hot
+ * path so it must not take a lock. */
+static void mmal_port_counter_max(volatile uint32_t *counter, uint32_t value)
+{
+   uint32_t seen = *counter;
+
+   while (value > seen)
+   {
+      uint32_t current = __sync_val_compare_and_swap(counter, seen, value);
+      if (current == seen)
+         break;
+      seen = current;
+   }
+}
+
+MMAL_STATUS_T mmal_port_stats_get(MMAL_PORT_T *port, MMAL_PORT_STATS_T *stats)
+{
+   if (!port || !port->priv || !stats)
+      return MMAL_EINVAL;
+
+   *stats = port->priv->core->counters;
+   return MMAL_SUCCESS;
+}
+
+void mmal_port_stats_dump(MMAL_PORT_T *port)
+{
+   MMAL_PORT_STATS_T stats;
+
+   if (mmal_port_stats_get(port, &stats) != MMAL_SUCCESS)
+      return;
+
+   LOG_INFO("%s: rx %u buffers / %u bytes, tx %u buffers / %u bytes, "
+            "%u in transit at most, longest callback %uus",
+            port->name, (unsigned int)stats.buffers_rx, (unsigned int)stats.bytes_rx,
+            (unsigned int)stats.buffers_tx, (unsigned int)stats.bytes_tx,
+            (unsigned int)stats.transit_high_water, (unsigned int)stats.callback_max_us);
+}
+
 static MMAL_STATUS_T mmal_port_private_parameter_get(MMAL_PORT_T *port,
                                                      MMAL_PARAMETER_HEADER_T *param)
 {
@@ -1444,6 +1861,14 @@ static MMAL_STATUS_T mmal_port_private_parameter_get(MMAL_PORT_T *port,
    {
    case MMAL_PARAMETER_CORE_STATISTICS:
       return mmal_port_get_core_stats(port, param);
+   case MMAL_PARAMETER_SINGLE_PRODUCER:
+      {
+         MMAL_PARAMETER_BOOLEAN_T *p = (MMAL_PARAMETER_BOOLEAN_T *)param;
+         if (param->size < sizeof(*p))
+            return MMAL_EINVAL;
+         p->enable = port->priv->core->single_producer;
+      }
+      return MMAL_SUCCESS;
    default:
       return MMAL_ENOSYS;
    }
@@ -1452,9 +1877,20 @@ static MMAL_STATUS_T mmal_port_private_parameter_get(MMAL_PORT_T *port,
 static MMAL_STATUS_T mmal_port_private_parameter_set(MMAL_PORT_T *port,
                                                      const MMAL_PARAMETER_HEADER_T *param)
 {
-   (void)port;
    switch (param->id)
    {
+   case MMAL_PARAMETER_SINGLE_PRODUCER:
+      {
+         const MMAL_PARAMETER_BOOLEAN_T *p = (const MMAL_PARAMETER_BOOLEAN_T *)param;
+         if (param->size < sizeof(*p))
+            return MMAL_EINVAL;
+         /* The guarantee is negotiated before the port is enabled. Changing
+          * it while buffers might be in flight would race with the senders. */
+         if (port->is_enabled)
+            return MMAL_EINVAL;
+         port->priv->core->single_producer = !!p->enable;
+      }
+      return MMAL_SUCCESS;
    default:
       return MMAL_ENOSYS;
    }
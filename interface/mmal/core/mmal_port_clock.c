@@ -141,6 +141,9 @@ static MMAL_STATUS_T mmal_port_clock_process_buffer(MMAL_PORT_T *port, MMAL_BUFF
    case MMAL_CLOCK_EVENT_REQUEST_THRESHOLD:
       status = mmal_clock_request_threshold_set(priv_clock->clock, &event.data.request_threshold);
       break;
+   case MMAL_CLOCK_EVENT_REQUEST_TOLERANCE:
+      status = mmal_clock_request_tolerance_set(priv_clock->clock, &event.data.request_tolerance);
+      break;
    case MMAL_CLOCK_EVENT_INPUT_BUFFER_INFO:
    case MMAL_CLOCK_EVENT_OUTPUT_BUFFER_INFO:
       /* nothing to do - just forward to the client */
@@ -264,6 +267,14 @@ static MMAL_STATUS_T mmal_port_clock_parameter_set(MMAL_PORT_T *port, const MMAL
          port->priv->clock->buffer_info_reporting = p->enable;
          return MMAL_SUCCESS;
       }
+      case MMAL_PARAMETER_CLOCK_REQUEST_TOLERANCE:
+      {
+         const MMAL_PARAMETER_CLOCK_REQUEST_TOLERANCE_T *p = (const MMAL_PARAMETER_CLOCK_REQUEST_TOLERANCE_T *)param;
+         status = mmal_port_clock_request_tolerance_set(port, &p->value);
+         event.id = MMAL_CLOCK_EVENT_REQUEST_TOLERANCE;
+         event.data.request_tolerance = p->value;
+      }
+      break;
       default:
          LOG_ERROR("unsupported clock parameter 0x%x", param->id);
          return MMAL_ENOSYS;
@@ -331,6 +342,18 @@ static MMAL_STATUS_T mmal_port_clock_parameter_get(MMAL_PORT_T *port, MMAL_PARAM
          p->enable = priv_clock->buffer_info_reporting;
       }
       break;
+      case MMAL_PARAMETER_CLOCK_REQUEST_TOLERANCE:
+      {
+         MMAL_PARAMETER_CLOCK_REQUEST_TOLERANCE_T *p = (MMAL_PARAMETER_CLOCK_REQUEST_TOLERANCE_T *)param;
+         status = mmal_clock_request_tolerance_get(priv_clock->clock, &p->value);
+      }
+      break;
+      case MMAL_PARAMETER_CLOCK_DELIVERY_STATS:
+      {
+         MMAL_PARAMETER_CLOCK_DELIVERY_STATS_T *p = (MMAL_PARAMETER_CLOCK_DELIVERY_STATS_T *)param;
+         status = mmal_clock_delivery_stats_get(priv_clock->clock, &p->value);
+      }
+      break;
       default:
          LOG_ERROR("unsupported clock parameter 0x%x", param->id);
          return MMAL_ENOSYS;
@@ -476,6 +499,19 @@ static MMAL_STATUS_T mmal_port_clock_forward_request_threshold(MMAL_PORT_T *port
    return mmal_port_clock_forward_event(port, &event);
 }
 
+/* Send a clock request tolerance to a connected port */
+static MMAL_STATUS_T mmal_port_clock_forward_request_tolerance(MMAL_PORT_T *port,
+      const MMAL_CLOCK_REQUEST_TOLERANCE_T *tolerance)
+{
+   MMAL_CLOCK_EVENT_T event;
+
+   event.id = MMAL_CLOCK_EVENT_REQUEST_TOLERANCE;
+   event.magic = MMAL_CLOCK_EVENT_MAGIC;
+   event.data.request_tolerance = *tolerance;
+
+   return mmal_port_clock_forward_event(port, &event);
+}
+
 /* Send information regarding an input buffer to connected port */
 static MMAL_STATUS_T mmal_port_clock_forward_input_buffer_info(MMAL_PORT_T *port, const MMAL_CLOCK_BUFFER_INFO_T *info)
 {
@@ -718,6 +754,12 @@ int64_t mmal_port_clock_media_time_get(MMAL_PORT_T *port)
    return mmal_clock_media_time_get(port->priv->clock->clock);
 }
 
+/* Get the lock-free clock page of the clock port */
+const MMAL_CLOCK_PAGE_T *mmal_port_clock_page_get(MMAL_PORT_T *port)
+{
+   return mmal_clock_page_get(port->priv->clock->clock);
+}
+
 /* Set the clock port's update threshold */
 MMAL_STATUS_T mmal_port_clock_update_threshold_set(MMAL_PORT_T *port,
                                                    const MMAL_CLOCK_UPDATE_THRESHOLD_T *threshold)
@@ -787,6 +829,29 @@ MMAL_STATUS_T mmal_port_clock_request_threshold_get(MMAL_PORT_T *port,
    return mmal_clock_request_threshold_get(port->priv->clock->clock, threshold);
 }
 
+/* Set the clock port's request coalescing tolerance */
+MMAL_STATUS_T mmal_port_clock_request_tolerance_set(MMAL_PORT_T *port,
+                                                    const MMAL_CLOCK_REQUEST_TOLERANCE_T *tolerance)
+{
+   MMAL_STATUS_T status;
+
+   status = mmal_clock_request_tolerance_set(port->priv->clock->clock, tolerance);
+   if (status != MMAL_SUCCESS)
+      return status;
+
+   if (port->priv->clock->is_reference)
+      status = mmal_port_clock_forward_request_tolerance(port, tolerance);
+
+   return status;
+}
+
+/* Get the clock port's request coalescing tolerance */
+MMAL_STATUS_T mmal_port_clock_request_tolerance_get(MMAL_PORT_T *port,
+                                           MMAL_CLOCK_REQUEST_TOLERANCE_T *tolerance)
+{
+   return mmal_clock_request_tolerance_get(port->priv->clock->clock, tolerance);
+}
+
 /* Provide input buffer information */
 void mmal_port_clock_input_buffer_info(MMAL_PORT_T *port, const MMAL_CLOCK_BUFFER_INFO_T *info)
 {
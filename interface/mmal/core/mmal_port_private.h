@@ -30,6 +30,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "interface/mmal/mmal.h"
 #include "interface/mmal/mmal_clock.h"
+#include "interface/mmal/core/mmal_clock_private.h"
 #include "interface/mmal/core/mmal_events_private.h"
 
 #ifdef __cplusplus
@@ -50,6 +51,10 @@ typedef struct MMAL_PORT_PRIVATE_T
    MMAL_STATUS_T (*pf_enable)(MMAL_PORT_T *port, MMAL_PORT_BH_CB_T);
    MMAL_STATUS_T (*pf_disable)(MMAL_PORT_T *port);
    MMAL_STATUS_T (*pf_send)(MMAL_PORT_T *port, MMAL_BUFFER_HEADER_T *);
+   /** Optional. Ports which can coalesce several buffer headers into a single
+    * transaction can provide this entry point. Falls back to pf_send otherwise. */
+   MMAL_STATUS_T (*pf_send_list)(MMAL_PORT_T *port, MMAL_BUFFER_HEADER_T **, unsigned int num,
+                                 unsigned int *num_sent);
    MMAL_STATUS_T (*pf_flush)(MMAL_PORT_T *port);
    MMAL_STATUS_T (*pf_parameter_set)(MMAL_PORT_T *port, const MMAL_PARAMETER_HEADER_T *param);
    MMAL_STATUS_T (*pf_parameter_get)(MMAL_PORT_T *port, MMAL_PARAMETER_HEADER_T *param);
@@ -58,6 +63,11 @@ typedef struct MMAL_PORT_PRIVATE_T
    uint8_t *(*pf_payload_alloc)(MMAL_PORT_T *port, uint32_t payload_size);
    void     (*pf_payload_free)(MMAL_PORT_T *port, uint8_t *payload);
 
+   /** Set by ports whose payloads are not plain contiguous memory (e.g.
+    * shared memory or opaque image handles). Such payloads cannot be carved
+    * out of a payload slab and must be allocated one by one. */
+   MMAL_BOOL_T payload_slab_unsupported;
+
 } MMAL_PORT_PRIVATE_T;
 
 /** Callback called by components when a \ref MMAL_BUFFER_HEADER_T needs to be sent back to the
@@ -184,6 +194,12 @@ MMAL_RATIONAL_T mmal_port_clock_scale_get(MMAL_PORT_T *port);
 MMAL_STATUS_T mmal_port_clock_media_time_set(MMAL_PORT_T *port, int64_t media_time);
 int64_t mmal_port_clock_media_time_get(MMAL_PORT_T *port);
 
+/** Get the lock-free clock page of the clock port.
+ * Components can derive the current media-time from the page with
+ * \ref mmal_clock_page_media_time instead of requesting periodic clock
+ * update events. */
+const MMAL_CLOCK_PAGE_T *mmal_port_clock_page_get(MMAL_PORT_T *port);
+
 /** Get/set the clock port's update threshold */
 MMAL_STATUS_T mmal_port_clock_update_threshold_set(MMAL_PORT_T *port,
                                                    const MMAL_CLOCK_UPDATE_THRESHOLD_T *threshold);
@@ -202,6 +218,12 @@ MMAL_STATUS_T mmal_port_clock_request_threshold_set(MMAL_PORT_T *port,
 MMAL_STATUS_T mmal_port_clock_request_threshold_get(MMAL_PORT_T *port,
                                                     MMAL_CLOCK_REQUEST_THRESHOLD_T *threshold);
 
+/** Get/set the clock port's request coalescing tolerance */
+MMAL_STATUS_T mmal_port_clock_request_tolerance_set(MMAL_PORT_T *port,
+                                                    const MMAL_CLOCK_REQUEST_TOLERANCE_T *tolerance);
+MMAL_STATUS_T mmal_port_clock_request_tolerance_get(MMAL_PORT_T *port,
+                                                    MMAL_CLOCK_REQUEST_TOLERANCE_T *tolerance);
+
 /** Provide information regarding a buffer received on the component's input/output port */
 void mmal_port_clock_input_buffer_info(MMAL_PORT_T *port, const MMAL_CLOCK_BUFFER_INFO_T *info);
 void mmal_port_clock_output_buffer_info(MMAL_PORT_T *port, const MMAL_CLOCK_BUFFER_INFO_T *info);
@@ -36,6 +36,15 @@ struct MMAL_QUEUE_T
    MMAL_BUFFER_HEADER_T *first;
    MMAL_BUFFER_HEADER_T **last;
    VCOS_SEMAPHORE_T semaphore;
+
+   uint32_t flags;
+   /* Lock-free MPSC state. Producers push buffers onto an atomic LIFO stack
+    * (mpsc_in) and the single consumer drains the whole stack in one atomic
+    * exchange, reversing it into a private FIFO list (mpsc_first/mpsc_last)
+    * which only the consumer ever touches. */
+   MMAL_BUFFER_HEADER_T * volatile mpsc_in;
+   MMAL_BUFFER_HEADER_T *mpsc_first;
+   volatile int waiters;
 };
 
 static void mmal_queue_sanity_check(MMAL_QUEUE_T *queue, MMAL_BUFFER_HEADER_T *buffer)
@@ -50,8 +59,51 @@ static void mmal_queue_sanity_check(MMAL_QUEUE_T *queue, MMAL_BUFFER_HEADER_T *b
   vcos_assert(len == queue->length && !q);
 }
 
+/** Move all the buffers pushed by producers into the consumer's private FIFO
+ * list. Only ever called from the (single) consumer thread. */
+static void mmal_queue_mpsc_drain(MMAL_QUEUE_T *queue)
+{
+   MMAL_BUFFER_HEADER_T *chain, *next, *first = 0;
+
+   /* Grab the whole producer stack in one go and reverse it (producers push
+    * in LIFO order) to preserve the FIFO semantics of the queue */
+   chain = (MMAL_BUFFER_HEADER_T *)__sync_lock_test_and_set(&queue->mpsc_in, NULL);
+   while (chain)
+   {
+      next = chain->next;
+      chain->next = first;
+      first = chain;
+      chain = next;
+   }
+
+   /* Append to the back of the private list */
+   if (first)
+   {
+      MMAL_BUFFER_HEADER_T **last = &queue->mpsc_first;
+      while (*last) last = &(*last)->next;
+      *last = first;
+   }
+}
+
+/** Lock-free dequeue. Only ever called from the (single) consumer thread. */
+static MMAL_BUFFER_HEADER_T *mmal_queue_mpsc_get(MMAL_QUEUE_T *queue)
+{
+   MMAL_BUFFER_HEADER_T *buffer;
+
+   if (!queue->mpsc_first)
+      mmal_queue_mpsc_drain(queue);
+
+   buffer = queue->mpsc_first;
+   if (!buffer)
+      return 0;
+
+   queue->mpsc_first = buffer->next;
+   __sync_sub_and_fetch(&queue->length, 1);
+   return buffer;
+}
+
 /** Create a QUEUE of MMAL_BUFFER_HEADER_T */
-MMAL_QUEUE_T *mmal_queue_create(void)
+MMAL_QUEUE_T *mmal_queue_create_ex(uint32_t flags)
 {
    MMAL_QUEUE_T *queue;
 
@@ -75,18 +127,42 @@ MMAL_QUEUE_T *mmal_queue_create(void)
    queue->length = 0;
    queue->first = 0;
    queue->last = &queue->first;
+   queue->flags = flags;
+   queue->mpsc_in = 0;
+   queue->mpsc_first = 0;
+   queue->waiters = 0;
    mmal_queue_sanity_check(queue, NULL);
    /* gratuitous unlock for coverity */ vcos_mutex_unlock(&queue->lock);
 
    return queue;
 }
 
+/** Create a QUEUE of MMAL_BUFFER_HEADER_T */
+MMAL_QUEUE_T *mmal_queue_create(void)
+{
+   return mmal_queue_create_ex(0);
+}
+
 /** Put a MMAL_BUFFER_HEADER_T into a QUEUE */
 void mmal_queue_put(MMAL_QUEUE_T *queue, MMAL_BUFFER_HEADER_T *buffer)
 {
    vcos_assert(queue && buffer);
    if(!queue || !buffer) return;
 
+   if (queue->flags & MMAL_QUEUE_FLAG_MPSC)
+   {
+      MMAL_BUFFER_HEADER_T *old;
+      do {
+         old = queue->mpsc_in;
+         buffer->next = old;
+      } while (!__sync_bool_compare_and_swap(&queue->mpsc_in, old, buffer));
+      __sync_add_and_fetch(&queue->length, 1);
+      /* Only pay for the semaphore when a consumer is actually blocked */
+      if (queue->waiters)
+         vcos_semaphore_post(&queue->semaphore);
+      return;
+   }
+
 	vcos_mutex_lock(&queue->lock);
    mmal_queue_sanity_check(queue, buffer);
    queue->length++;
@@ -102,6 +178,18 @@ void mmal_queue_put_back(MMAL_QUEUE_T *queue, MMAL_BUFFER_HEADER_T *buffer)
 {
    if(!queue || !buffer) return;
 
+   if (queue->flags & MMAL_QUEUE_FLAG_MPSC)
+   {
+      /* Putting back is a consumer side operation so the private list can be
+       * accessed without any synchronisation */
+      buffer->next = queue->mpsc_first;
+      queue->mpsc_first = buffer;
+      __sync_add_and_fetch(&queue->length, 1);
+      if (queue->waiters)
+         vcos_semaphore_post(&queue->semaphore);
+      return;
+   }
+
 	vcos_mutex_lock(&queue->lock);
   mmal_queue_sanity_check(queue, buffer);
    queue->length++;
@@ -120,6 +208,9 @@ MMAL_BUFFER_HEADER_T *mmal_queue_get(MMAL_QUEUE_T *queue)
    vcos_assert(queue);
 	if(!queue) return 0;
 
+   if (queue->flags & MMAL_QUEUE_FLAG_MPSC)
+      return mmal_queue_mpsc_get(queue);
+
    vcos_mutex_lock(&queue->lock);
    mmal_queue_sanity_check(queue, NULL);
    buffer = queue->first;
@@ -146,6 +237,24 @@ MMAL_BUFFER_HEADER_T *mmal_queue_wait(MMAL_QUEUE_T *queue)
 {
 	if(!queue) return 0;
 
+   if (queue->flags & MMAL_QUEUE_FLAG_MPSC)
+   {
+      MMAL_BUFFER_HEADER_T *buffer;
+      while (!(buffer = mmal_queue_mpsc_get(queue)))
+      {
+         /* Advertise ourselves as blocked and recheck the queue to avoid
+          * missing a wakeup from a producer which didn't see the waiter */
+         __sync_add_and_fetch(&queue->waiters, 1);
+         buffer = mmal_queue_mpsc_get(queue);
+         if (!buffer)
+            vcos_semaphore_wait(&queue->semaphore);
+         __sync_sub_and_fetch(&queue->waiters, 1);
+         if (buffer)
+            break;
+      }
+      return buffer;
+   }
+
 	vcos_semaphore_wait(&queue->semaphore);
    vcos_semaphore_post(&queue->semaphore);
    return mmal_queue_get(queue);
@@ -157,6 +266,22 @@ MMAL_BUFFER_HEADER_T *mmal_queue_timedwait(MMAL_QUEUE_T *queue, VCOS_UNSIGNED ti
     if (!queue)
         return NULL;
 
+    if (queue->flags & MMAL_QUEUE_FLAG_MPSC)
+    {
+       MMAL_BUFFER_HEADER_T *buffer = mmal_queue_mpsc_get(queue);
+       if (buffer)
+          return buffer;
+       __sync_add_and_fetch(&queue->waiters, 1);
+       buffer = mmal_queue_mpsc_get(queue);
+       if (!buffer)
+       {
+          if (vcos_semaphore_wait_timeout(&queue->semaphore, timeout) == VCOS_SUCCESS)
+             buffer = mmal_queue_mpsc_get(queue);
+       }
+       __sync_sub_and_fetch(&queue->waiters, 1);
+       return buffer;
+    }
+
     ret = vcos_semaphore_wait_timeout(&queue->semaphore, timeout);
 
     if (ret != VCOS_SUCCESS)
@@ -166,6 +291,74 @@ MMAL_BUFFER_HEADER_T *mmal_queue_timedwait(MMAL_QUEUE_T *queue, VCOS_UNSIGNED ti
     return mmal_queue_get(queue);
 }
 
+/** Drain up to num buffers from a QUEUE in one go. */
+unsigned int mmal_queue_get_all(MMAL_QUEUE_T *queue,
+   MMAL_BUFFER_HEADER_T **buffers, unsigned int num)
+{
+   unsigned int count = 0;
+
+   vcos_assert(queue && buffers);
+   if(!queue || !buffers || !num) return 0;
+
+   if (queue->flags & MMAL_QUEUE_FLAG_MPSC)
+   {
+      MMAL_BUFFER_HEADER_T *buffer;
+      while (count < num && (buffer = mmal_queue_mpsc_get(queue)) != NULL)
+         buffers[count++] = buffer;
+      return count;
+   }
+
+   vcos_mutex_lock(&queue->lock);
+   mmal_queue_sanity_check(queue, NULL);
+   while (count < num && queue->first)
+   {
+      MMAL_BUFFER_HEADER_T *buffer = queue->first;
+
+      /* coverity[lock] This semaphore isn't being used as a mutex */
+      vcos_semaphore_wait(&queue->semaphore); /* Will always succeed */
+
+      queue->first = buffer->next;
+      queue->length--;
+      buffers[count++] = buffer;
+   }
+   if(!queue->first) queue->last = &queue->first;
+   vcos_mutex_unlock(&queue->lock);
+
+   return count;
+}
+
+/** Wait for at least one MMAL_BUFFER_HEADER_T, then drain up to num. */
+unsigned int mmal_queue_timedwait_batch(MMAL_QUEUE_T *queue,
+   MMAL_BUFFER_HEADER_T **buffers, unsigned int num, VCOS_UNSIGNED timeout)
+{
+   unsigned int count;
+
+   if (!queue || !buffers || !num)
+      return 0;
+
+   if (queue->flags & MMAL_QUEUE_FLAG_MPSC)
+   {
+      count = mmal_queue_get_all(queue, buffers, num);
+      if (count)
+         return count;
+      __sync_add_and_fetch(&queue->waiters, 1);
+      count = mmal_queue_get_all(queue, buffers, num);
+      if (!count)
+      {
+         if (vcos_semaphore_wait_timeout(&queue->semaphore, timeout) == VCOS_SUCCESS)
+            count = mmal_queue_get_all(queue, buffers, num);
+      }
+      __sync_sub_and_fetch(&queue->waiters, 1);
+      return count;
+   }
+
+   if (vcos_semaphore_wait_timeout(&queue->semaphore, timeout) != VCOS_SUCCESS)
+      return 0;
+
+   vcos_semaphore_post(&queue->semaphore);
+   return mmal_queue_get_all(queue, buffers, num);
+}
+
 /** Get the number of MMAL_BUFFER_HEADER_T currently in a QUEUE */
 unsigned int mmal_queue_length(MMAL_QUEUE_T *queue)
 {
@@ -95,6 +95,9 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 /** Clock latency setting */
 #define MMAL_CLOCK_EVENT_LATENCY             MMAL_FOURCC('C','L','A','T')
 
+/** Clock request tolerance */
+#define MMAL_CLOCK_EVENT_REQUEST_TOLERANCE   MMAL_FOURCC('C','R','T','O')
+
 /** Clock event not valid */
 #define MMAL_CLOCK_EVENT_INVALID   0
 
@@ -131,6 +134,34 @@ typedef struct MMAL_CLOCK_REQUEST_THRESHOLD_T
    MMAL_BOOL_T threshold_enable;
 } MMAL_CLOCK_REQUEST_THRESHOLD_T;
 
+/** Tolerance applied when scheduling client callback requests.
+ * Requests with media-times falling within the tolerance of each other are
+ * serviced with a single timer wakeup instead of one wakeup per request. */
+typedef struct MMAL_CLOCK_REQUEST_TOLERANCE_T
+{
+   /** Requests up to this far in the future are serviced alongside the
+    * request which triggered the wakeup (microseconds). Zero disables
+    * request coalescing. */
+   int64_t tolerance;
+} MMAL_CLOCK_REQUEST_TOLERANCE_T;
+
+/** Number of bins in the request delivery histograms.
+ * Bin N counts deliveries with an error of less than (1 << N) milliseconds
+ * (and at least (1 << (N-1)) milliseconds for N > 0). The last bin also
+ * counts anything larger. */
+#define MMAL_CLOCK_DELIVERY_STATS_BINS  8
+
+/** Histogram of client callback request delivery times relative to their
+ * requested media-times. */
+typedef struct MMAL_CLOCK_DELIVERY_STATS_T
+{
+   /** Requests serviced ahead of their requested media-time */
+   uint32_t early[MMAL_CLOCK_DELIVERY_STATS_BINS];
+
+   /** Requests serviced at or after their requested media-time */
+   uint32_t late[MMAL_CLOCK_DELIVERY_STATS_BINS];
+} MMAL_CLOCK_DELIVERY_STATS_T;
+
 /** Structure for passing buffer information to a clock port */
 typedef struct MMAL_CLOCK_BUFFER_INFO_T
 {
@@ -183,6 +214,9 @@ typedef struct MMAL_CLOCK_EVENT_T
       /** client callback request threshold */
       MMAL_CLOCK_REQUEST_THRESHOLD_T request_threshold;
 
+      /** client callback request tolerance */
+      MMAL_CLOCK_REQUEST_TOLERANCE_T request_tolerance;
+
       /** input/output buffer information */
       MMAL_CLOCK_BUFFER_INFO_T buffer;
 
@@ -159,6 +159,22 @@ MMAL_ES_FORMAT_T *mmal_format_alloc(void);
  */
 void mmal_format_free(MMAL_ES_FORMAT_T *format);
 
+/** Acquire a reference to a \ref MMAL_ES_FORMAT_T structure.
+ * Acquiring a reference means that the format will not be destroyed until
+ * the reference is released with \ref mmal_format_release. This allows
+ * clients to hold on to a format without having to make a full copy of it.
+ *
+ * @param format the \ref MMAL_ES_FORMAT_T structure to acquire
+ */
+void mmal_format_acquire(MMAL_ES_FORMAT_T *format);
+
+/** Release a reference to a \ref MMAL_ES_FORMAT_T structure.
+ * Releasing the last reference to a format will destroy it.
+ *
+ * @param format the \ref MMAL_ES_FORMAT_T structure to release
+ */
+void mmal_format_release(MMAL_ES_FORMAT_T *format);
+
 /** Allocate the extradata buffer in \ref MMAL_ES_FORMAT_T.
  * This buffer will be freed automatically when the format is destroyed or
  * another allocation is done.
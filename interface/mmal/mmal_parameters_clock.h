@@ -51,6 +51,8 @@ enum
    MMAL_PARAMETER_CLOCK_ENABLE_BUFFER_INFO, /**< Takes a MMAL_PARAMETER_BOOLEAN_T */
    MMAL_PARAMETER_CLOCK_FRAME_RATE,         /**< Takes a MMAL_PARAMETER_RATIONAL_T */
    MMAL_PARAMETER_CLOCK_LATENCY,            /**< Takes a MMAL_PARAMETER_CLOCK_LATENCY_T */
+   MMAL_PARAMETER_CLOCK_REQUEST_TOLERANCE,  /**< Takes a MMAL_PARAMETER_CLOCK_REQUEST_TOLERANCE_T */
+   MMAL_PARAMETER_CLOCK_DELIVERY_STATS,     /**< Takes a MMAL_PARAMETER_CLOCK_DELIVERY_STATS_T */
 };
 
 /** Media-time update thresholds */
@@ -85,4 +87,20 @@ typedef struct MMAL_PARAMETER_CLOCK_LATENCY_T
    MMAL_CLOCK_LATENCY_T value;
 } MMAL_PARAMETER_CLOCK_LATENCY_T;
 
+/** Request coalescing tolerance settings */
+typedef struct MMAL_PARAMETER_CLOCK_REQUEST_TOLERANCE_T
+{
+   MMAL_PARAMETER_HEADER_T hdr;
+
+   MMAL_CLOCK_REQUEST_TOLERANCE_T value;
+} MMAL_PARAMETER_CLOCK_REQUEST_TOLERANCE_T;
+
+/** Request delivery statistics (read-only) */
+typedef struct MMAL_PARAMETER_CLOCK_DELIVERY_STATS_T
+{
+   MMAL_PARAMETER_HEADER_T hdr;
+
+   MMAL_CLOCK_DELIVERY_STATS_T value;
+} MMAL_PARAMETER_CLOCK_DELIVERY_STATS_T;
+
 #endif /* MMAL_PARAMETERS_CLOCK_H */
@@ -74,7 +74,23 @@ enum {
    MMAL_PARAMETER_LOGGING,                /**< Takes a MMAL_PARAMETER_LOGGING_T */
    MMAL_PARAMETER_SYSTEM_TIME,            /**< Takes a MMAL_PARAMETER_UINT64_T */
    MMAL_PARAMETER_NO_IMAGE_PADDING,       /**< Takes a MMAL_PARAMETER_BOOLEAN_T */
-   MMAL_PARAMETER_LOCKSTEP_ENABLE         /**< Takes a MMAL_PARAMETER_BOOLEAN_T */
+   MMAL_PARAMETER_LOCKSTEP_ENABLE,        /**< Takes a MMAL_PARAMETER_BOOLEAN_T */
+   MMAL_PARAMETER_WRITABLE_OUTPUT,        /**< Takes a MMAL_PARAMETER_BOOLEAN_T.
+                                               Set on an output port to declare that the client will
+                                               modify the payload of the buffers it receives.
+                                               Components which fan the same payload out to several
+                                               ports will hand this port a private copy instead. */
+   MMAL_PARAMETER_PORT_PRIORITY,          /**< Takes a MMAL_PARAMETER_UINT32_T.
+                                               Scheduling priority of a port relative to the other
+                                               ports of the same component. Components which
+                                               multiplex several ports into one serve ports with
+                                               higher values first. */
+   MMAL_PARAMETER_SINGLE_PRODUCER         /**< Takes a MMAL_PARAMETER_BOOLEAN_T.
+                                               Set before enabling a port to declare that the client
+                                               will only ever send buffers to the port from a single
+                                               thread at a time, and never concurrently with a port
+                                               disable. This lets the core elide the locking it would
+                                               otherwise need on the buffer send path. */
 };
 
 /**@}*/
@@ -99,6 +99,10 @@ enum {
    MMAL_PARAMETER_VIDEO_RENDER_STATS,           /**< Take a @ref MMAL_PARAMETER_VIDEO_RENDER_STATS_T. */
    MMAL_PARAMETER_VIDEO_INTERLACE_TYPE,           /**< Take a @ref MMAL_PARAMETER_VIDEO_INTERLACE_TYPE_T. */
    MMAL_PARAMETER_VIDEO_INTERPOLATE_TIMESTAMPS,         /**< Takes a @ref MMAL_PARAMETER_BOOLEAN_T */
+   MMAL_PARAMETER_VIDEO_DECODE_THREAD_COUNT,    /**< Takes a @ref MMAL_PARAMETER_UINT32_T.
+                                                     Number of threads a software decoder may use.
+                                                     Zero selects the decoder's default. Must be set
+                                                     before the input port format is committed. */
 };
 
 /** Display transformations.
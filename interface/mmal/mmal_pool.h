@@ -128,6 +128,20 @@ void mmal_pool_destroy(MMAL_POOL_T *pool);
  */
 MMAL_STATUS_T mmal_pool_resize(MMAL_POOL_T *pool, unsigned int headers, uint32_t payload_size);
 
+/** Grow a pool of MMAL_BUFFER_HEADER_T by appending new buffer headers.
+ * Unlike mmal_pool_resize(), this does not require the pool to be quiesced: the
+ * new buffer headers are allocated as an additional slab and added to the pool's
+ * queue while existing buffer headers remain in flight. The payload size and
+ * allocator are the ones the pool was created with.
+ * A pool which has been grown can no longer be resized with mmal_pool_resize().
+ *
+ * @param pool         Pointer to the pool
+ * @param headers      Number of buffer headers to append to the pool.
+ *                     It is not valid to pass zero for the number of buffers.
+ * @return MMAL_SUCCESS or an error on failure.
+ */
+MMAL_STATUS_T mmal_pool_grow(MMAL_POOL_T *pool, unsigned int headers);
+
 /** Definition of the callback used by a pool to signal back to the user that a buffer header
  * has been released back to the pool.
  *
@@ -158,6 +172,27 @@ void mmal_pool_callback_set(MMAL_POOL_T *pool, MMAL_POOL_BH_CB_T cb, void *userd
  */
 void mmal_pool_pre_release_callback_set(MMAL_POOL_T *pool, MMAL_BH_PRE_RELEASE_CB_T cb, void *userdata);
 
+/** Enable or disable buffer provenance tracing.
+ * When enabled, every buffer header records its last few owner transitions
+ * (the port it was sent to or returned by, or the pool it was released back
+ * to, with a timestamp) in a small fixed ring inside the header, with no
+ * allocation on the buffer path. The switch is global to the process and
+ * costs a single test per buffer when disabled.
+ *
+ * @param enable  Whether to enable tracing
+ */
+void mmal_pool_trace_enable(MMAL_BOOL_T enable);
+
+/** Log the recorded owner transitions of every buffer header in a pool.
+ * Each header is reported on one line, oldest transition first, as
+ * owner pointer / age pairs. An owner equal to the pool pointer marks a
+ * release back to the pool, so the last entry of a stuck buffer points
+ * at whoever is sitting on it.
+ *
+ * @param pool  Pool to report on
+ */
+void mmal_pool_trace_dump(MMAL_POOL_T *pool);
+
 /* @} */
 
 #ifdef __cplusplus
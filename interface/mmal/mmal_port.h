@@ -216,6 +216,27 @@ MMAL_STATUS_T mmal_port_parameter_get(MMAL_PORT_T *port,
 MMAL_STATUS_T mmal_port_send_buffer(MMAL_PORT_T *port,
    MMAL_BUFFER_HEADER_T *buffer);
 
+/** Send a list of buffer headers to a port in one go.
+ *
+ * This is equivalent to calling \ref mmal_port_send_buffer on each buffer
+ * header in turn but allows the port to coalesce the whole list into fewer
+ * transactions with the component (e.g. a single IPC transaction for ports
+ * implemented on the VideoCore). Buffer headers are submitted in the order
+ * they appear in the list and completions are still reported individually
+ * through the port callback.
+ *
+ * On failure, the returned status refers to the first buffer header which
+ * could not be submitted; that buffer header and all the following ones in
+ * the list are still owned by the caller.
+ *
+ * @param port The port to which the buffer headers are to be sent.
+ * @param buffers The list of buffer headers to send.
+ * @param num Number of buffer headers in the list.
+ * @return MMAL_SUCCESS on success
+ */
+MMAL_STATUS_T mmal_port_send_buffer_list(MMAL_PORT_T *port,
+   MMAL_BUFFER_HEADER_T **buffers, unsigned int num);
+
 /** Connect an output port to an input port.
  *
  * When connected and enabled, buffers will automatically progress from the
@@ -268,6 +289,71 @@ uint8_t *mmal_port_payload_alloc(MMAL_PORT_T *port, uint32_t payload_size);
  */
 void mmal_port_payload_free(MMAL_PORT_T *port, uint8_t *payload);
 
+/** Definition of a payload slab. A slab is a single large allocation which
+ * subsequent calls to \ref mmal_port_payload_alloc carve per-buffer payloads
+ * out of. */
+typedef struct MMAL_PORT_PAYLOAD_SLAB_T MMAL_PORT_PAYLOAD_SLAB_T;
+
+/** Create a payload slab on a port.
+ * This pre-allocates, in a single allocation, enough memory for a given number
+ * of payload buffers. Subsequent calls to \ref mmal_port_payload_alloc for the
+ * same payload size will be carved out of the slab until it is exhausted.
+ * This is much quicker than allocating each payload separately and, for ports
+ * which allocate shared memory, uses a single shared memory handle for the
+ * whole slab.
+ * The memory is returned to the system once every carved payload has been
+ * freed with \ref mmal_port_payload_free and the slab has been released.
+ *
+ * @param port         Port responsible for allocating the memory.
+ * @param payload_size Size of each payload buffer which will be allocated.
+ * @param num          Number of payload buffers the slab should provide for.
+ *
+ * @return Pointer to the slab (or NULL on failure, in which case payload
+ * allocations simply revert to being made individually).
+ */
+MMAL_PORT_PAYLOAD_SLAB_T *mmal_port_payload_slab_create(MMAL_PORT_T *port,
+   uint32_t payload_size, unsigned int num);
+
+/** Release a payload slab.
+ * No further payload allocations will be carved out of the slab. The slab's
+ * memory is freed once all the payloads previously carved out of it have
+ * been freed as well.
+ *
+ * @param port         Port which the slab was created on.
+ * @param slab         Slab to release.
+ */
+void mmal_port_payload_slab_release(MMAL_PORT_T *port, MMAL_PORT_PAYLOAD_SLAB_T *slab);
+
+/** Per-port counters collected by the core on the buffer hot path.
+ * Unlike \ref MMAL_PARAMETER_CORE_STATISTICS these are always collected:
+ * they are maintained with atomic operations and involve no locking or
+ * time queries, so the cost per buffer is negligible. */
+typedef struct MMAL_PORT_STATS_T
+{
+   uint32_t buffers_rx;         /**< Number of buffers received by the port */
+   uint32_t buffers_tx;         /**< Number of buffers sent back to the client */
+   uint32_t bytes_rx;           /**< Payload bytes received by the port */
+   uint32_t bytes_tx;           /**< Payload bytes sent back to the client */
+   uint32_t transit_high_water; /**< Highest number of buffers in transit at any one time */
+   uint32_t callback_max_us;    /**< Longest time (in microseconds) spent in the client
+                                     buffer callback. Only collected when built with
+                                     MMAL_COLLECT_PORT_STATS since it involves time queries. */
+} MMAL_PORT_STATS_T;
+
+/** Get a snapshot of the counters collected by the core for a port.
+ *
+ * @param port  The port to query.
+ * @param stats Filled in with a snapshot of the port counters.
+ * @return MMAL_SUCCESS on success
+ */
+MMAL_STATUS_T mmal_port_stats_get(MMAL_PORT_T *port, MMAL_PORT_STATS_T *stats);
+
+/** Log a one-line summary of the counters collected by the core for a port.
+ *
+ * @param port The port to dump the counters of.
+ */
+void mmal_port_stats_dump(MMAL_PORT_T *port);
+
 /** Get an empty event buffer header from a port
  *
  * @param port The port from which to get the event buffer header.
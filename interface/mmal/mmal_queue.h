@@ -42,12 +42,33 @@ extern "C" {
 
 typedef struct MMAL_QUEUE_T MMAL_QUEUE_T;
 
+/** \name Queue creation flags
+ * \anchor queueflags
+ * The following flags can be used at creation time to alter the behaviour
+ * of a queue. */
+/* @{ */
+/** The queue will be used by multiple producers but only ever a single
+ * consumer (i.e. only one thread at a time will call \ref mmal_queue_get,
+ * \ref mmal_queue_wait, \ref mmal_queue_timedwait or \ref mmal_queue_put_back).
+ * Enqueueing and dequeueing are then lock-free, and the queue only falls back
+ * to its semaphore when a consumer actually blocks waiting for a buffer. */
+#define MMAL_QUEUE_FLAG_MPSC 0x1
+/* @} */
+
 /** Create a queue of MMAL_BUFFER_HEADER_T
  *
  * @return Pointer to the newly created queue or NULL on failure.
  */
 MMAL_QUEUE_T *mmal_queue_create(void);
 
+/** Create a queue of MMAL_BUFFER_HEADER_T with non-default behaviour
+ *
+ * @param flags A bitwise combination of \ref queueflags "Queue creation flags"
+ *
+ * @return Pointer to the newly created queue or NULL on failure.
+ */
+MMAL_QUEUE_T *mmal_queue_create_ex(uint32_t flags);
+
 /** Put a MMAL_BUFFER_HEADER_T into a queue
  *
  * @param queue  Pointer to a queue
@@ -93,6 +114,36 @@ MMAL_BUFFER_HEADER_T *mmal_queue_wait(MMAL_QUEUE_T *queue);
  */
 MMAL_BUFFER_HEADER_T *mmal_queue_timedwait(MMAL_QUEUE_T *queue, VCOS_UNSIGNED timeout);
 
+/** Drain up to num buffer headers from a queue in one go.
+ * This is equivalent to repeated calls to \ref mmal_queue_get but the whole
+ * batch is dequeued under a single lock acquisition, so loops which drain
+ * several ready buffers (e.g. render pumps) do not pay per-buffer locking.
+ *
+ * @param queue   Pointer to a queue
+ * @param buffers Array to receive the dequeued buffer headers
+ * @param num     Size of the buffers array
+ *
+ * @return number of buffer headers dequeued (0 if the queue is empty).
+ */
+unsigned int mmal_queue_get_all(MMAL_QUEUE_T *queue,
+   MMAL_BUFFER_HEADER_T **buffers, unsigned int num);
+
+/** Wait for at least one buffer header, then drain up to num of them.
+ * This is the same as \ref mmal_queue_timedwait except that all the buffer
+ * headers which are ready by the time the wait completes are dequeued in
+ * one go, up to the size of the supplied array.
+ *
+ * @param queue   Pointer to a queue
+ * @param buffers Array to receive the dequeued buffer headers
+ * @param num     Size of the buffers array
+ * @param timeout Number of milliseconds to wait before
+ *                returning if no buffer becomes available.
+ *
+ * @return number of buffer headers dequeued (0 on timeout).
+ */
+unsigned int mmal_queue_timedwait_batch(MMAL_QUEUE_T *queue,
+   MMAL_BUFFER_HEADER_T **buffers, unsigned int num, VCOS_UNSIGNED timeout);
+
 /** Get the number of MMAL_BUFFER_HEADER_T currently in a queue.
  *
  * @param queue  Pointer to a queue
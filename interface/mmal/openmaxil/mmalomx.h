@@ -49,6 +49,22 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define MAX_MARKS_NUM 2
 #define MAX_ENCODINGS_NUM 20
 
+/** Number of entries in the parameter translation cache */
+#define MMALOMX_PARAM_CACHE_SIZE 8
+/** Biggest translated parameter blob held in the cache (header + payload) */
+#define MMALOMX_PARAM_CACHE_BLOB_MAX 272
+
+/** Entry of the parameter translation cache.
+ * Holds the last translated blob successfully set on a port so redundant
+ * sets can be elided before they trigger a VideoCore round trip. */
+typedef struct MMALOMX_PARAM_CACHE_ENTRY_T
+{
+   MMAL_PORT_T *port; /**< Port the blob was set on, NULL when empty */
+   uint32_t size;     /**< Size of the cached blob in bytes */
+   uint8_t blob[MMALOMX_PARAM_CACHE_BLOB_MAX]; /**< Translated MMAL parameter */
+
+} MMALOMX_PARAM_CACHE_ENTRY_T;
+
 /** Per-port context data */
 typedef struct MMALOMX_PORT_T
 {
@@ -111,6 +127,10 @@ typedef struct MMALOMX_COMPONENT_T {
    MMAL_BOOL_T cmd_thread_used;
    VCOS_SEMAPHORE_T cmd_sema;
 
+   /** Cache of the last parameter blobs set on the component's ports,
+    * protected by the component lock */
+   MMALOMX_PARAM_CACHE_ENTRY_T param_cache[MMALOMX_PARAM_CACHE_SIZE];
+
    VCOS_MUTEX_T lock; /**< Used to protect component state */
    VCOS_MUTEX_T lock_port; /**< Used to protect port state */
 
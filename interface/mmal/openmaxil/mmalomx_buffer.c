@@ -34,16 +34,21 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <util/mmal_util.h>
 
 /*****************************************************************************/
-OMX_ERRORTYPE mmalomx_buffer_send(
+OMX_ERRORTYPE mmalomx_buffer_send_list(
    MMALOMX_COMPONENT_T *component,
-   OMX_BUFFERHEADERTYPE *omx_buffer,
-   OMX_DIRTYPE direction)
+   OMX_BUFFERHEADERTYPE **omx_buffers,
+   unsigned int num_buffers,
+   OMX_DIRTYPE direction,
+   unsigned int *num_sent)
 {
    OMX_ERRORTYPE status = OMX_ErrorNone;
    MMAL_BUFFER_HEADER_T *mmal_buffer;
    MMAL_STATUS_T mmal_status;
    MMALOMX_PORT_T *port;
-   unsigned int index;
+   unsigned int index, i, sent = 0;
+
+   if (num_sent)
+      *num_sent = 0;
 
    /* Sanity checks */
    if (!component)
@@ -51,11 +56,32 @@ OMX_ERRORTYPE mmalomx_buffer_send(
    if (component->state == OMX_StateInvalid)
       return OMX_ErrorInvalidState;
 
-   if (!omx_buffer || omx_buffer->nSize != sizeof(OMX_BUFFERHEADERTYPE) ||
-       omx_buffer->nOffset + omx_buffer->nFilledLen > omx_buffer->nAllocLen)
+   if (!num_buffers || !omx_buffers)
       return OMX_ErrorBadParameter;
 
-   index = direction == OMX_DirInput ? omx_buffer->nInputPortIndex : omx_buffer->nOutputPortIndex;
+   /* Validate the whole list upfront so the send loop cannot fail on a
+    * malformed header halfway through a batch */
+   for (i = 0; i < num_buffers; i++)
+   {
+      OMX_BUFFERHEADERTYPE *omx_buffer = omx_buffers[i];
+
+      if (!omx_buffer || omx_buffer->nSize != sizeof(OMX_BUFFERHEADERTYPE) ||
+          omx_buffer->nOffset + omx_buffer->nFilledLen > omx_buffer->nAllocLen)
+         return OMX_ErrorBadParameter;
+   }
+
+   /* All the buffers of a batch have to target the same port */
+   index = direction == OMX_DirInput ?
+      omx_buffers[0]->nInputPortIndex : omx_buffers[0]->nOutputPortIndex;
+   for (i = 1; i < num_buffers; i++)
+   {
+      unsigned int buffer_index = direction == OMX_DirInput ?
+         omx_buffers[i]->nInputPortIndex : omx_buffers[i]->nOutputPortIndex;
+
+      if (buffer_index != index)
+         return OMX_ErrorBadParameter;
+   }
+
    if (index >= component->ports_num)
       return OMX_ErrorBadPortIndex;
 
@@ -72,35 +98,51 @@ OMX_ERRORTYPE mmalomx_buffer_send(
    if (status != OMX_ErrorNone)
       goto error;
 
-   mmal_buffer = mmal_queue_get( port->pool->queue );
-   if (!vcos_verify(mmal_buffer)) /* Should never happen */
+   for (i = 0; i < num_buffers; i++)
    {
-      status = OMX_ErrorUndefined;
-      goto error;
-   }
+      OMX_BUFFERHEADERTYPE *omx_buffer = omx_buffers[i];
 
-   mmalomx_mark_process_incoming(component, port, omx_buffer);
+      mmal_buffer = mmal_queue_get( port->pool->queue );
+      if (!vcos_verify(mmal_buffer)) /* Should never happen */
+      {
+         status = OMX_ErrorUndefined;
+         goto error;
+      }
 
-   mmal_buffer->user_data = (void *)omx_buffer;
-   mmalil_buffer_header_to_mmal(mmal_buffer, omx_buffer);
+      mmalomx_mark_process_incoming(component, port, omx_buffer);
+
+      mmal_buffer->user_data = (void *)omx_buffer;
+      mmalil_buffer_header_to_mmal(mmal_buffer, omx_buffer);
+
+      mmal_status = mmal_port_send_buffer(port->mmal, mmal_buffer);
+      if (!vcos_verify(mmal_status == MMAL_SUCCESS))
+      {
+         LOG_ERROR("failed to send buffer on %s", port->mmal->name);
+         mmal_queue_put_back( port->pool->queue, mmal_buffer );
+         status = mmalil_error_to_omx(mmal_status);
+         goto error;
+      }
 
-   mmal_status = mmal_port_send_buffer(port->mmal, mmal_buffer);
-   if (!vcos_verify(mmal_status == MMAL_SUCCESS))
-   {
-      LOG_ERROR("failed to send buffer on %s", port->mmal->name);
-      mmal_queue_put_back( port->pool->queue, mmal_buffer );
-      status = mmalil_error_to_omx(mmal_status);
-   }
-   else
-   {
       port->buffers_in_transit++;
+      sent++;
    }
 
 error:
    MMALOMX_UNLOCK_PORT(component, port);
+   if (num_sent)
+      *num_sent = sent;
    return status;
 }
 
+/*****************************************************************************/
+OMX_ERRORTYPE mmalomx_buffer_send(
+   MMALOMX_COMPONENT_T *component,
+   OMX_BUFFERHEADERTYPE *omx_buffer,
+   OMX_DIRTYPE direction)
+{
+   return mmalomx_buffer_send_list(component, &omx_buffer, 1, direction, NULL);
+}
+
 /*****************************************************************************/
 static void mmalomx_buffer_event(
    MMALOMX_PORT_T *port,
@@ -184,47 +226,60 @@ static void mmalomx_buffer_event(
 }
 
 /*****************************************************************************/
-OMX_ERRORTYPE mmalomx_buffer_return(
+OMX_ERRORTYPE mmalomx_buffer_return_list(
    MMALOMX_PORT_T *port,
-   MMAL_BUFFER_HEADER_T *mmal_buffer)
+   MMAL_BUFFER_HEADER_T **mmal_buffers,
+   unsigned int num_buffers)
 {
    MMALOMX_COMPONENT_T *component = port->component;
-   OMX_BUFFERHEADERTYPE *omx_buffer = (OMX_BUFFERHEADERTYPE *)mmal_buffer->user_data;
    MMAL_BOOL_T signal;
+   unsigned int i, returned = 0;
 
-   if (mmal_buffer->cmd)
+   for (i = 0; i < num_buffers; i++)
    {
-      mmalomx_buffer_event(port, mmal_buffer);
+      MMAL_BUFFER_HEADER_T *mmal_buffer = mmal_buffers[i];
+      OMX_BUFFERHEADERTYPE *omx_buffer = (OMX_BUFFERHEADERTYPE *)mmal_buffer->user_data;
+
+      if (mmal_buffer->cmd)
+      {
+         mmalomx_buffer_event(port, mmal_buffer);
+         mmal_buffer_header_release(mmal_buffer);
+         continue;
+      }
+
+      if (ENABLE_MMAL_EXTRA_LOGGING)
+         LOG_TRACE("hComponent %p, port %i, pBuffer %p", component,
+                   port->index, omx_buffer);
+
+      vcos_assert(omx_buffer->pBuffer == mmal_buffer->data);
+      mmalil_buffer_header_to_omx(omx_buffer, mmal_buffer);
       mmal_buffer_header_release(mmal_buffer);
-      return OMX_ErrorNone;
-   }
 
-   if (ENABLE_MMAL_EXTRA_LOGGING)
-      LOG_TRACE("hComponent %p, port %i, pBuffer %p", component,
-                port->index, omx_buffer);
+      if ((omx_buffer->nFlags & OMX_BUFFERFLAG_EOS) && port->direction == OMX_DirOutput)
+      {
+         mmalomx_callback_event_handler(component, OMX_EventBufferFlag,
+                                        port->index, omx_buffer->nFlags, NULL);
+      }
 
-   vcos_assert(omx_buffer->pBuffer == mmal_buffer->data);
-   mmalil_buffer_header_to_omx(omx_buffer, mmal_buffer);
-   mmal_buffer_header_release(mmal_buffer);
+      mmalomx_mark_process_outgoing(component, port, omx_buffer);
 
-   if ((omx_buffer->nFlags & OMX_BUFFERFLAG_EOS) && port->direction == OMX_DirOutput)
-   {
-      mmalomx_callback_event_handler(component, OMX_EventBufferFlag,
-                                     port->index, omx_buffer->nFlags, NULL);
-   }
+      if (port->direction == OMX_DirInput)
+         component->callbacks.EmptyBufferDone((OMX_HANDLETYPE)&component->omx,
+            component->callbacks_data, omx_buffer );
+      else
+         component->callbacks.FillBufferDone((OMX_HANDLETYPE)&component->omx,
+            component->callbacks_data, omx_buffer );
 
-   mmalomx_mark_process_outgoing(component, port, omx_buffer);
+      returned++;
+   }
 
-   if (port->direction == OMX_DirInput)
-      component->callbacks.EmptyBufferDone((OMX_HANDLETYPE)&component->omx,
-         component->callbacks_data, omx_buffer );
-   else
-      component->callbacks.FillBufferDone((OMX_HANDLETYPE)&component->omx,
-         component->callbacks_data, omx_buffer );
+   if (!returned)
+      return OMX_ErrorNone;
 
+   /* Account for the whole batch with a single lock acquisition */
    MMALOMX_LOCK_PORT(component, port);
    signal = port->actions & MMALOMX_ACTION_CHECK_FLUSHED;
-   port->buffers_in_transit--;
+   port->buffers_in_transit -= returned;
    MMALOMX_UNLOCK_PORT(component, port);
 
    if (signal)
@@ -233,3 +288,11 @@ OMX_ERRORTYPE mmalomx_buffer_return(
    return OMX_ErrorNone;
 }
 
+/*****************************************************************************/
+OMX_ERRORTYPE mmalomx_buffer_return(
+   MMALOMX_PORT_T *port,
+   MMAL_BUFFER_HEADER_T *mmal_buffer)
+{
+   return mmalomx_buffer_return_list(port, &mmal_buffer, 1);
+}
+
@@ -34,6 +34,24 @@ OMX_ERRORTYPE mmalomx_buffer_send(
    OMX_BUFFERHEADERTYPE *omx_buffer,
    OMX_DIRTYPE direction);
 
+/** Send a whole list of buffers to the same port with a single port lock
+ * acquisition. Processing stops at the first buffer which fails, with the
+ * number of buffers actually sent reported through num_sent (optional). */
+OMX_ERRORTYPE mmalomx_buffer_send_list(
+   MMALOMX_COMPONENT_T *component,
+   OMX_BUFFERHEADERTYPE **omx_buffers,
+   unsigned int num_buffers,
+   OMX_DIRTYPE direction,
+   unsigned int *num_sent);
+
 OMX_ERRORTYPE mmalomx_buffer_return(
    MMALOMX_PORT_T *port,
    MMAL_BUFFER_HEADER_T *mmal_buffer);
+
+/** Return a whole list of buffers from the same port to their client
+ * callbacks, batching the in-transit accounting into a single port lock
+ * acquisition. */
+OMX_ERRORTYPE mmalomx_buffer_return_list(
+   MMALOMX_PORT_T *port,
+   MMAL_BUFFER_HEADER_T **mmal_buffers,
+   unsigned int num_buffers);
@@ -63,6 +63,79 @@ typedef struct MMALOMX_PARAM_MMAL_GENERIC_T
    uint8_t data[MMALOMX_PARAM_GENERIC_MAX];
 } MMALOMX_PARAM_MMAL_GENERIC_T;
 
+/** Parameters which trigger an action on the component rather than just
+ * holding a value must always reach it, even when the blob is unchanged. */
+static MMAL_BOOL_T mmalomx_param_set_cacheable(uint32_t id)
+{
+   return id != MMAL_PARAMETER_CAPTURE;
+}
+
+static MMALOMX_PARAM_CACHE_ENTRY_T *mmalomx_param_cache_entry(
+   MMALOMX_COMPONENT_T *component, MMAL_PORT_T *mmal_port, uint32_t id)
+{
+   unsigned int index =
+      (id ^ (unsigned int)((uintptr_t)mmal_port >> 6)) & (MMALOMX_PARAM_CACHE_SIZE - 1);
+   return &component->param_cache[index];
+}
+
+/** Drop any cached blob for the given parameter. Needed when a parameter is
+ * set through one of the paths which bypass the translation cache. */
+static void mmalomx_param_cache_invalidate(MMALOMX_COMPONENT_T *component,
+   MMAL_PORT_T *mmal_port, uint32_t id)
+{
+   MMALOMX_PARAM_CACHE_ENTRY_T *entry =
+      mmalomx_param_cache_entry(component, mmal_port, id);
+
+   MMALOMX_LOCK(component);
+   if (entry->port == mmal_port && entry->size >= sizeof(MMAL_PARAMETER_HEADER_T) &&
+       ((MMAL_PARAMETER_HEADER_T *)entry->blob)->id == id)
+      entry->port = NULL;
+   MMALOMX_UNLOCK(component);
+}
+
+/** Set a parameter on a port unless an identical blob was already set, in
+ * which case the VideoCore round trip is skipped entirely. */
+static MMAL_STATUS_T mmalomx_port_parameter_set_cached(MMALOMX_COMPONENT_T *component,
+   MMAL_PORT_T *mmal_port, MMAL_PARAMETER_HEADER_T *mmal_header)
+{
+   MMALOMX_PARAM_CACHE_ENTRY_T *entry = NULL;
+   MMAL_STATUS_T status;
+
+   if (mmal_header->size <= MMALOMX_PARAM_CACHE_BLOB_MAX &&
+       mmalomx_param_set_cacheable(mmal_header->id))
+   {
+      MMAL_BOOL_T hit;
+
+      entry = mmalomx_param_cache_entry(component, mmal_port, mmal_header->id);
+      MMALOMX_LOCK(component);
+      hit = entry->port == mmal_port && entry->size == mmal_header->size &&
+         !memcmp(entry->blob, mmal_header, mmal_header->size);
+      MMALOMX_UNLOCK(component);
+      if (hit)
+         return MMAL_SUCCESS;
+   }
+
+   status = mmal_port_parameter_set(mmal_port, mmal_header);
+
+   if (entry)
+   {
+      MMALOMX_LOCK(component);
+      if (status == MMAL_SUCCESS)
+      {
+         entry->port = mmal_port;
+         entry->size = mmal_header->size;
+         memcpy(entry->blob, mmal_header, mmal_header->size);
+      }
+      else if (entry->port == mmal_port)
+      {
+         entry->port = NULL;
+      }
+      MMALOMX_UNLOCK(component);
+   }
+
+   return status;
+}
+
 static OMX_ERRORTYPE mmalomx_parameter_set_xlat(MMALOMX_COMPONENT_T *component,
    OMX_INDEXTYPE nParamIndex, OMX_PTR pParam)
 {
@@ -98,7 +171,7 @@ static OMX_ERRORTYPE mmalomx_parameter_set_xlat(MMALOMX_COMPONENT_T *component,
       mmal_generic.header = *mmal_header;
       mmal_header->size = omx_header->nSize - (xlat->portless ? 0 : 4);
       mmal_header->id = xlat->mmal_id;
-      status = mmal_port_parameter_set(mmal_port, mmal_header);
+      status = mmalomx_port_parameter_set_cached(component, mmal_port, mmal_header);
       *mmal_header = mmal_generic.header;
       return mmalil_error_to_omx(status);
    }
@@ -122,7 +195,7 @@ static OMX_ERRORTYPE mmalomx_parameter_set_xlat(MMALOMX_COMPONENT_T *component,
    if (status != MMAL_SUCCESS)
       goto error;
 
-   status = mmal_port_parameter_set(mmal_port, mmal_header);
+   status = mmalomx_port_parameter_set_cached(component, mmal_port, mmal_header);
 
  error:
    return mmalil_error_to_omx(status);
@@ -469,6 +542,10 @@ static OMX_ERRORTYPE mmalomx_set_video_param(MMALOMX_PORT_T *port,
           intraperiod) != MMAL_SUCCESS)
       return OMX_ErrorBadParameter;
 
+   /* This parameter can also be reached through the translated path, so
+    * make sure no stale blob is left in the cache */
+   mmalomx_param_cache_invalidate(port->component, port->mmal, MMAL_PARAMETER_INTRAPERIOD);
+
    mmal_param.profile[0].profile = (MMAL_VIDEO_PROFILE_T)
       mmalil_omx_video_profile_to_mmal(profile, coding);
    mmal_param.profile[0].level = (MMAL_VIDEO_LEVEL_T)
@@ -476,6 +553,8 @@ static OMX_ERRORTYPE mmalomx_set_video_param(MMALOMX_PORT_T *port,
    if (mmal_port_parameter_set(port->mmal, &mmal_param.hdr) != MMAL_SUCCESS)
       return OMX_ErrorBadParameter;
 
+   mmalomx_param_cache_invalidate(port->component, port->mmal, MMAL_PARAMETER_PROFILE);
+
    return OMX_ErrorNone;
 }
 
@@ -0,0 +1,178 @@
+/*
+Copyright (c) 2012, Broadcom Europe Ltd
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "mmal.h"
+#include "util/mmal_async.h"
+#include "mmal_logging.h"
+
+typedef enum MMAL_ASYNC_OP_T
+{
+   MMAL_ASYNC_COMPONENT_CREATE,
+   MMAL_ASYNC_PORT_ENABLE,
+   MMAL_ASYNC_CONNECTION_ENABLE
+} MMAL_ASYNC_OP_T;
+
+struct MMAL_ASYNC_T
+{
+   VCOS_THREAD_T thread;
+   MMAL_ASYNC_OP_T op;
+   MMAL_ASYNC_CB_T cb;
+   void *userdata;
+   MMAL_STATUS_T status;
+
+   /* Arguments of the underlying call */
+   const char *name;
+   MMAL_COMPONENT_T **component;
+   MMAL_PORT_T *port;
+   MMAL_PORT_BH_CB_T buffer_cb;
+   MMAL_CONNECTION_T *connection;
+};
+
+/*****************************************************************************/
+static void *mmal_async_worker(void *arg)
+{
+   MMAL_ASYNC_T *async = (MMAL_ASYNC_T *)arg;
+
+   switch (async->op)
+   {
+   case MMAL_ASYNC_COMPONENT_CREATE:
+      async->status = mmal_component_create(async->name, async->component);
+      break;
+   case MMAL_ASYNC_PORT_ENABLE:
+      async->status = mmal_port_enable(async->port, async->buffer_cb);
+      break;
+   case MMAL_ASYNC_CONNECTION_ENABLE:
+      async->status = mmal_connection_enable(async->connection);
+      break;
+   }
+
+   if (async->cb)
+      async->cb(async->status, async->userdata);
+
+   return NULL;
+}
+
+/** Allocates an operation */
+static MMAL_ASYNC_T *mmal_async_alloc(MMAL_ASYNC_OP_T op, MMAL_ASYNC_CB_T cb, void *userdata)
+{
+   MMAL_ASYNC_T *async;
+
+   async = vcos_calloc(1, sizeof(*async), "mmal async op");
+   if (!async)
+   {
+      LOG_ERROR("failed to allocate async operation");
+      return NULL;
+   }
+
+   async->op = op;
+   async->cb = cb;
+   async->userdata = userdata;
+   async->status = MMAL_EINVAL;
+   return async;
+}
+
+/** Hands the filled-in operation over to its thread */
+static MMAL_STATUS_T mmal_async_run(MMAL_ASYNC_T *async, MMAL_ASYNC_T **handle)
+{
+   if (vcos_thread_create(&async->thread, "mmal async", NULL,
+                          mmal_async_worker, async) != VCOS_SUCCESS)
+   {
+      LOG_ERROR("failed to create async thread");
+      vcos_free(async);
+      *handle = NULL;
+      return MMAL_ENOSPC;
+   }
+
+   return MMAL_SUCCESS;
+}
+
+/*****************************************************************************/
+MMAL_STATUS_T mmal_component_create_async(const char *name, MMAL_COMPONENT_T **component,
+   MMAL_ASYNC_CB_T cb, void *userdata, MMAL_ASYNC_T **op)
+{
+   MMAL_ASYNC_T *async;
+
+   if (!name || !component || !op)
+      return MMAL_EINVAL;
+
+   async = mmal_async_alloc(MMAL_ASYNC_COMPONENT_CREATE, cb, userdata);
+   if (!async)
+      return MMAL_ENOMEM;
+
+   async->name = name;
+   async->component = component;
+   return mmal_async_run(async, op);
+}
+
+/*****************************************************************************/
+MMAL_STATUS_T mmal_port_enable_async(MMAL_PORT_T *port, MMAL_PORT_BH_CB_T buffer_cb,
+   MMAL_ASYNC_CB_T cb, void *userdata, MMAL_ASYNC_T **op)
+{
+   MMAL_ASYNC_T *async;
+
+   if (!port || !op)
+      return MMAL_EINVAL;
+
+   async = mmal_async_alloc(MMAL_ASYNC_PORT_ENABLE, cb, userdata);
+   if (!async)
+      return MMAL_ENOMEM;
+
+   async->port = port;
+   async->buffer_cb = buffer_cb;
+   return mmal_async_run(async, op);
+}
+
+/*****************************************************************************/
+MMAL_STATUS_T mmal_connection_enable_async(MMAL_CONNECTION_T *connection,
+   MMAL_ASYNC_CB_T cb, void *userdata, MMAL_ASYNC_T **op)
+{
+   MMAL_ASYNC_T *async;
+
+   if (!connection || !op)
+      return MMAL_EINVAL;
+
+   async = mmal_async_alloc(MMAL_ASYNC_CONNECTION_ENABLE, cb, userdata);
+   if (!async)
+      return MMAL_ENOMEM;
+
+   async->connection = connection;
+   return mmal_async_run(async, op);
+}
+
+/*****************************************************************************/
+MMAL_STATUS_T mmal_async_wait(MMAL_ASYNC_T *op)
+{
+   MMAL_STATUS_T status;
+
+   if (!op)
+      return MMAL_EINVAL;
+
+   vcos_thread_join(&op->thread, NULL);
+   status = op->status;
+   vcos_free(op);
+   return status;
+}
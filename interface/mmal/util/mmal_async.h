@@ -0,0 +1,110 @@
+/*
+Copyright (c) 2012, Broadcom Europe Ltd
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef MMAL_ASYNC_H
+#define MMAL_ASYNC_H
+
+#include "util/mmal_connection.h"
+
+/** \defgroup MmalAsync Asynchronous variants of blocking MMAL calls
+ * Component creation and port enabling block on a round trip to VC. When
+ * building a graph of components these latencies add up, so these helpers run
+ * the blocking call on a thread of its own, allowing several calls to be
+ * issued concurrently and their round trips to be overlapped. */
+/* @{ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Handle to an in-flight asynchronous operation */
+typedef struct MMAL_ASYNC_T MMAL_ASYNC_T;
+
+/** Definition of the callback used to signal the completion of an asynchronous
+ * operation. The callback is invoked from the thread running the operation.
+ *
+ * @param status   Status of the completed operation
+ * @param userdata User specific data passed in when starting the operation
+ */
+typedef void (*MMAL_ASYNC_CB_T)(MMAL_STATUS_T status, void *userdata);
+
+/** Asynchronous variant of mmal_component_create().
+ *
+ * @param name      Name of the component to create. The string must stay valid
+ *                  until the operation completes.
+ * @param component Returned component. Must stay valid until the operation
+ *                  completes and is only safe to use once it has.
+ * @param cb        Callback invoked on completion (optional)
+ * @param userdata  User specific data passed back with the callback
+ * @param op        Returned handle to the operation. The caller must reap the
+ *                  operation with mmal_async_wait().
+ * @return MMAL_SUCCESS if the operation was started
+ */
+MMAL_STATUS_T mmal_component_create_async(const char *name, MMAL_COMPONENT_T **component,
+   MMAL_ASYNC_CB_T cb, void *userdata, MMAL_ASYNC_T **op);
+
+/** Asynchronous variant of mmal_port_enable().
+ *
+ * @param port      Port to enable
+ * @param buffer_cb Callback for when buffers are returned by the port
+ * @param cb        Callback invoked on completion (optional)
+ * @param userdata  User specific data passed back with the callback
+ * @param op        Returned handle to the operation. The caller must reap the
+ *                  operation with mmal_async_wait().
+ * @return MMAL_SUCCESS if the operation was started
+ */
+MMAL_STATUS_T mmal_port_enable_async(MMAL_PORT_T *port, MMAL_PORT_BH_CB_T buffer_cb,
+   MMAL_ASYNC_CB_T cb, void *userdata, MMAL_ASYNC_T **op);
+
+/** Asynchronous variant of mmal_connection_enable().
+ *
+ * @param connection Connection to enable
+ * @param cb         Callback invoked on completion (optional)
+ * @param userdata   User specific data passed back with the callback
+ * @param op         Returned handle to the operation. The caller must reap the
+ *                   operation with mmal_async_wait().
+ * @return MMAL_SUCCESS if the operation was started
+ */
+MMAL_STATUS_T mmal_connection_enable_async(MMAL_CONNECTION_T *connection,
+   MMAL_ASYNC_CB_T cb, void *userdata, MMAL_ASYNC_T **op);
+
+/** Waits for an asynchronous operation to complete and releases it.
+ * This must be called exactly once for every started operation, whether a
+ * completion callback was supplied or not.
+ *
+ * @param op Operation to wait for
+ * @return Status of the completed operation
+ */
+MMAL_STATUS_T mmal_async_wait(MMAL_ASYNC_T *op);
+
+#ifdef __cplusplus
+}
+#endif
+
+/* @} */
+
+#endif /* MMAL_ASYNC_H */
@@ -366,3 +366,66 @@ MMAL_STATUS_T mmal_wrapper_buffer_get_full(MMAL_PORT_T *port, MMAL_BUFFER_HEADER
 
    return wrapper->status == MMAL_SUCCESS && !*buffer ? MMAL_EAGAIN : wrapper->status;
 }
+
+/** Wait for a buffer to be available on any of a set of ports */
+MMAL_STATUS_T mmal_wrapper_wait_any(MMAL_WRAPPER_T *wrapper,
+   MMAL_PORT_T **ports, uint32_t *flags, unsigned int num,
+   MMAL_PORT_T **port, MMAL_BUFFER_HEADER_T **buffer)
+{
+   MMAL_WRAPPER_PRIVATE_T *private = (MMAL_WRAPPER_PRIVATE_T *)wrapper;
+   unsigned int i;
+
+   LOG_TRACE("%p, %u ports", wrapper, num);
+
+   if (!ports || !flags || !num || !port || !buffer)
+      return MMAL_EINVAL;
+
+   /* Sanity check the list of ports upfront so we can't end up blocking
+    * forever on an invalid request */
+   for (i = 0; i < num; i++)
+   {
+      if (!ports[i] || ports[i]->userdata != (void *)wrapper ||
+          (ports[i]->type != MMAL_PORT_TYPE_INPUT &&
+           ports[i]->type != MMAL_PORT_TYPE_OUTPUT))
+         return MMAL_EINVAL;
+      if ((flags[i] & MMAL_WRAPPER_FLAG_FULL) &&
+          ports[i]->type != MMAL_PORT_TYPE_OUTPUT)
+         return MMAL_EINVAL;
+   }
+
+   while (wrapper->status == MMAL_SUCCESS)
+   {
+      /* All the buffer returns post the same semaphore so a single scan of
+       * the ports after each wakeup is enough */
+      for (i = 0; i < num; i++)
+      {
+         MMAL_PORT_T *p = ports[i];
+
+         if (flags[i] & MMAL_WRAPPER_FLAG_EMPTY)
+         {
+            MMAL_POOL_T *pool = p->type == MMAL_PORT_TYPE_INPUT ?
+               wrapper->input_pool[p->index] : wrapper->output_pool[p->index];
+            if ((*buffer = mmal_queue_get(pool->queue)) != NULL)
+            {
+               *port = p;
+               return MMAL_SUCCESS;
+            }
+         }
+
+         if (flags[i] & MMAL_WRAPPER_FLAG_FULL)
+         {
+            if ((*buffer = mmal_queue_get(wrapper->output_queue[p->index])) != NULL)
+            {
+               *port = p;
+               return MMAL_SUCCESS;
+            }
+         }
+      }
+
+      vcos_semaphore_wait(&private->sema);
+   }
+
+   *port = 0;
+   *buffer = 0;
+   return wrapper->status;
+}
@@ -98,6 +98,10 @@ MMAL_STATUS_T mmal_wrapper_create(MMAL_WRAPPER_T **wrapper, const char *name);
 #define MMAL_WRAPPER_FLAG_PAYLOAD_ALLOCATE 2
 /** The port will use shared memory payloads */
 #define MMAL_WRAPPER_FLAG_PAYLOAD_USE_SHARED_MEMORY 4
+/** Wait for an empty buffer from the port's pool (\ref mmal_wrapper_wait_any) */
+#define MMAL_WRAPPER_FLAG_EMPTY 8
+/** Wait for a full buffer from the port's output queue (\ref mmal_wrapper_wait_any) */
+#define MMAL_WRAPPER_FLAG_FULL 16
 /* @} */
 
 /** Enable a port on a component wrapper.
@@ -133,6 +137,26 @@ MMAL_STATUS_T mmal_wrapper_buffer_get_empty(MMAL_PORT_T *port, MMAL_BUFFER_HEADE
  */
 MMAL_STATUS_T mmal_wrapper_buffer_get_full(MMAL_PORT_T *port, MMAL_BUFFER_HEADER_T **buffer, uint32_t flags);
 
+/** Wait for a buffer to be available on any of a set of ports.
+ * This allows a single thread to pump all the ports of a component instead
+ * of needing a blocking call (and therefore a thread) per port.
+ * The call blocks until one of the requested buffers is available or an
+ * error is reported by the component.
+ *
+ * @param wrapper wrapper the ports belong to
+ * @param ports   array of ports to wait on
+ * @param flags   array of flags, one per port, specifying which buffers to
+ *                wait for on that port (MMAL_WRAPPER_FLAG_EMPTY and / or
+ *                MMAL_WRAPPER_FLAG_FULL)
+ * @param num     number of ports in the array
+ * @param port    points to the port which returned the buffer on return
+ * @param buffer  points to the retrieved buffer on return
+ * @return MMAL_SUCCESS on success.
+ */
+MMAL_STATUS_T mmal_wrapper_wait_any(MMAL_WRAPPER_T *wrapper,
+   MMAL_PORT_T **ports, uint32_t *flags, unsigned int num,
+   MMAL_PORT_T **port, MMAL_BUFFER_HEADER_T **buffer);
+
 /** Cancel any ongoing blocking operation on a component wrapper.
  *
  * @param wrapper The wrapper on which to cancel operations.
@@ -27,12 +27,53 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "mmal.h"
 #include "util/mmal_util.h"
+#include "util/mmal_util_params.h"
 #include "util/mmal_connection.h"
 #include "mmal_logging.h"
+/* Included for the packet flag values and the simple container v2 layout
+ * used by the record tap. Constants only, we do not link with the
+ * containers library. */
+#include "containers/containers.h"
+#include "containers/simple/simple_common.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <inttypes.h>
 
 #define CONNECTION_NAME_FORMAT "%s:%.2222s:%i/%s:%.2222s:%i"
 
+/** Number of pool exhaustion events needed before an auto-tuned connection
+ * grows its pool */
+#define CONNECTION_TUNE_THRESHOLD 4
+
+/** Initial size of the record table of the record tap (entries). The table
+ * doubles on demand up to SIMPLE_V2_MAX_RECORDS. */
+#define CONNECTION_RECORD_TABLE_SIZE 512
+
+/** State of the record tap of a connection. When the MMAL_CONNECTION_RECORD
+ * environment variable is set to a filename prefix, every connection captures
+ * the buffers flowing through it to "<prefix><n>.smpl", a version 2 simple
+ * container file with arrival times (see containers/simple/simple_common.h).
+ * The capture can then be fed to the "replay_source" component to reproduce
+ * the exact delivery schedule without the original pipeline.
+ * Setting MMAL_CONNECTION_RECORD_PAYLOAD to 0 captures timing and metadata
+ * only; the payload region is then left as a hole in the file so it still
+ * reads back as a valid (all zeroes) payload without using disk space. */
+typedef struct
+{
+   FILE *payload;            /**< temporary file receiving the payload region */
+   char *filename;           /**< final name of the capture file */
+   char *tmpname;            /**< name of the temporary payload file */
+   uint8_t *records;         /**< record table, SIMPLE_V2_RECORD_SIZE each */
+   uint32_t records_num;     /**< number of records captured so far */
+   uint32_t records_alloc;   /**< capacity of the record table */
+   uint64_t payload_offset;  /**< current size of the payload region */
+   int64_t start_time;       /**< wall-time of the first captured buffer */
+   MMAL_BOOL_T with_payload; /**< false when only timing / metadata is kept */
+   MMAL_BOOL_T failed;       /**< capture abandoned after a write failure */
+
+} MMAL_CONNECTION_RECORD_T;
+
 typedef struct
 {
    MMAL_CONNECTION_T connection; /**< Must be the first member! */
@@ -41,8 +82,274 @@ typedef struct
    /** Reference counting */
    int refcount;
 
+   /* Buffer count auto-tuning state. The counter is only a heuristic so it
+    * is updated without locking; a race can at worst delay an adjustment. */
+   uint32_t tune_max;     /**< upper bound for the number of buffers, 0 when off */
+   uint32_t tune_starved; /**< pool exhaustion events since the last adjustment */
+
+   MMAL_CONNECTION_RECORD_T *record; /**< record tap state, NULL when off */
+
 } MMAL_CONNECTION_PRIVATE_T;
 
+/*****************************************************************************/
+static void mmal_connection_record_u32(uint8_t *p, uint32_t value)
+{
+   p[0] = (uint8_t)value; p[1] = (uint8_t)(value >> 8);
+   p[2] = (uint8_t)(value >> 16); p[3] = (uint8_t)(value >> 24);
+}
+
+static void mmal_connection_record_u64(uint8_t *p, uint64_t value)
+{
+   mmal_connection_record_u32(p, (uint32_t)value);
+   mmal_connection_record_u32(p + 4, (uint32_t)(value >> 32));
+}
+
+/** Start capturing a connection if the environment asks for it.
+ * The payload goes to a temporary file while the record table accumulates in
+ * memory, since the table has to precede the payload region in the final
+ * file but its size is only known once the capture ends. */
+static void mmal_connection_record_start(MMAL_CONNECTION_PRIVATE_T *private)
+{
+   static int record_sequence; /* one file per connection, in creation order */
+   MMAL_CONNECTION_T *connection = &private->connection;
+   const char *prefix = getenv("MMAL_CONNECTION_RECORD");
+   const char *payload = getenv("MMAL_CONNECTION_RECORD_PAYLOAD");
+   MMAL_CONNECTION_RECORD_T *record;
+   unsigned int name_size;
+
+   if (!prefix)
+      return;
+
+   record = vcos_calloc(1, sizeof(*record), "mmal connection record");
+   if (!record)
+      return;
+
+   name_size = strlen(prefix) + 32;
+   record->filename = vcos_malloc(name_size, "mmal connection record name");
+   record->tmpname = vcos_malloc(name_size, "mmal connection record name");
+   if (!record->filename || !record->tmpname)
+      goto error;
+   snprintf(record->filename, name_size, "%s%i.smpl", prefix,
+            __sync_fetch_and_add(&record_sequence, 1));
+   snprintf(record->tmpname, name_size, "%s.tmp", record->filename);
+
+   record->payload = fopen(record->tmpname, "w+b");
+   if (!record->payload)
+   {
+      LOG_ERROR("could not open %s to record %s", record->tmpname,
+                connection->name);
+      goto error;
+   }
+
+   record->with_payload = !payload || atoi(payload);
+   private->record = record;
+   LOG_INFO("recording connection %s to %s%s", connection->name,
+            record->filename, record->with_payload ? "" : " (metadata only)");
+   return;
+
+ error:
+   if (record->filename) vcos_free(record->filename);
+   if (record->tmpname) vcos_free(record->tmpname);
+   vcos_free(record);
+}
+
+/** Capture one buffer. Called from the output port callback, so it only ever
+ * runs on one thread at a time for a given connection. */
+static void mmal_connection_record_buffer(MMAL_CONNECTION_PRIVATE_T *private,
+   MMAL_BUFFER_HEADER_T *buffer)
+{
+   MMAL_CONNECTION_RECORD_T *record = private->record;
+   int64_t now = vcos_getmicrosecs64();
+   uint32_t flags = 0;
+   uint8_t *rec;
+
+   /* Only data packets are captured, events are not part of the stream */
+   if (record->failed || buffer->cmd ||
+       record->records_num >= SIMPLE_V2_MAX_RECORDS)
+      return;
+
+   if (record->records_num == record->records_alloc)
+   {
+      uint32_t alloc = record->records_alloc ?
+         record->records_alloc * 2 : CONNECTION_RECORD_TABLE_SIZE;
+      uint8_t *table = vcos_malloc(alloc * SIMPLE_V2_RECORD_SIZE,
+                                   "mmal connection record table");
+      if (!table)
+      {
+         record->failed = MMAL_TRUE;
+         return;
+      }
+      if (record->records)
+      {
+         memcpy(table, record->records,
+                record->records_num * SIMPLE_V2_RECORD_SIZE);
+         vcos_free(record->records);
+      }
+      record->records = table;
+      record->records_alloc = alloc;
+   }
+
+   if (!record->records_num)
+      record->start_time = now;
+
+   if (buffer->flags & MMAL_BUFFER_HEADER_FLAG_KEYFRAME)
+      flags |= VC_CONTAINER_PACKET_FLAG_KEYFRAME;
+   if (buffer->flags & MMAL_BUFFER_HEADER_FLAG_FRAME_START)
+      flags |= VC_CONTAINER_PACKET_FLAG_FRAME_START;
+   if (buffer->flags & MMAL_BUFFER_HEADER_FLAG_FRAME_END)
+      flags |= VC_CONTAINER_PACKET_FLAG_FRAME_END;
+   if (buffer->flags & MMAL_BUFFER_HEADER_FLAG_DISCONTINUITY)
+      flags |= VC_CONTAINER_PACKET_FLAG_DISCONTINUITY;
+   if (buffer->flags & MMAL_BUFFER_HEADER_FLAG_CONFIG)
+      flags |= VC_CONTAINER_PACKET_FLAG_CONFIG;
+
+   rec = record->records + record->records_num * SIMPLE_V2_RECORD_SIZE;
+   mmal_connection_record_u64(rec, record->payload_offset);
+   mmal_connection_record_u32(rec + 8, buffer->length);
+   mmal_connection_record_u32(rec + 12, 0 /* track */);
+   mmal_connection_record_u64(rec + 16, buffer->pts == MMAL_TIME_UNKNOWN ?
+                              (uint64_t)VC_CONTAINER_TIME_UNKNOWN : (uint64_t)buffer->pts);
+   mmal_connection_record_u32(rec + 24, flags);
+   mmal_connection_record_u32(rec + 28, (uint32_t)(now - record->start_time));
+
+   if (record->with_payload && buffer->length)
+   {
+      MMAL_BOOL_T ok = MMAL_FALSE;
+      if (mmal_buffer_header_mem_lock(buffer) == MMAL_SUCCESS)
+      {
+         ok = fwrite(buffer->data + buffer->offset, 1, buffer->length,
+                     record->payload) == buffer->length;
+         mmal_buffer_header_mem_unlock(buffer);
+      }
+      if (!ok)
+      {
+         LOG_ERROR("failed to record %s, capture abandoned",
+                   private->connection.name);
+         record->failed = MMAL_TRUE;
+         return;
+      }
+   }
+   else if (buffer->length)
+   {
+      /* Metadata only. Skip over the payload instead of writing it so the
+       * offsets stay valid but the file stays sparse. */
+      if (fseek(record->payload, buffer->length, SEEK_CUR))
+      {
+         record->failed = MMAL_TRUE;
+         return;
+      }
+   }
+
+   record->payload_offset += buffer->length;
+   record->records_num++;
+}
+
+/** Finalise a capture, assembling header, record table and payload into the
+ * final file. Called with the connection disabled so no more buffers flow. */
+static void mmal_connection_record_stop(MMAL_CONNECTION_PRIVATE_T *private)
+{
+   MMAL_CONNECTION_RECORD_T *record = private->record;
+   MMAL_CONNECTION_T *connection = &private->connection;
+   MMAL_ES_FORMAT_T *format = connection->out->format;
+   FILE *out = NULL;
+
+   if (!record)
+      return;
+   private->record = NULL;
+
+   if (record->failed || !record->records_num)
+      goto cleanup;
+
+   out = fopen(record->filename, "wb");
+   if (!out)
+   {
+      LOG_ERROR("could not open %s", record->filename);
+      goto cleanup;
+   }
+
+   fprintf(out, "%s\n", SIGNATURE_STRING);
+   switch (format->type)
+   {
+   case MMAL_ES_TYPE_VIDEO:
+      fprintf(out, "TRACK video, %4.4s, %i, %i\n", (char *)&format->encoding,
+              (int)format->es->video.width, (int)format->es->video.height);
+      break;
+   case MMAL_ES_TYPE_AUDIO:
+      fprintf(out, "TRACK audio, %4.4s, %i, %i, %i, %i\n",
+              (char *)&format->encoding,
+              (int)format->es->audio.channels,
+              (int)format->es->audio.sample_rate,
+              (int)format->es->audio.bits_per_sample,
+              (int)format->es->audio.block_align);
+      break;
+   default:
+      fprintf(out, "TRACK unknown, %4.4s\n", (char *)&format->encoding);
+      break;
+   }
+   fprintf(out, "%s %u\n", CONFIG_RECORDS, record->records_num);
+   fprintf(out, "%s 1\n", CONFIG_ARRIVAL);
+   fprintf(out, "%s\n", SIGNATURE_END_STRING);
+
+   if (fwrite(record->records, SIMPLE_V2_RECORD_SIZE, record->records_num,
+              out) == record->records_num)
+   {
+      long payload_start = ftell(out);
+      uint8_t copy[4096];
+      size_t bytes;
+
+      /* Append the payload region. The temporary file can be shorter than
+       * the payload region when the capture was metadata only, in which case
+       * the truncation below extends the hole to its full size. */
+      rewind(record->payload);
+      while ((bytes = fread(copy, 1, sizeof(copy), record->payload)) > 0)
+         if (fwrite(copy, 1, bytes, out) != bytes)
+            break;
+      fflush(out);
+      if (ftruncate(fileno(out), payload_start + record->payload_offset))
+         LOG_ERROR("failed to extend %s", record->filename);
+
+      LOG_INFO("recorded %u buffers (%"PRIu64" bytes) from %s to %s",
+               record->records_num, record->payload_offset, connection->name,
+               record->filename);
+   }
+
+ cleanup:
+   if (out) fclose(out);
+   fclose(record->payload);
+   remove(record->tmpname);
+   if (record->records) vcos_free(record->records);
+   vcos_free(record->filename);
+   vcos_free(record->tmpname);
+   vcos_free(record);
+}
+
+/** Grow the pool of a connection which keeps running out of buffers. */
+static void mmal_connection_tune_starved(MMAL_CONNECTION_PRIVATE_T *private)
+{
+   MMAL_CONNECTION_T *connection = &private->connection;
+   MMAL_POOL_T *pool = connection->pool;
+
+   if (++private->tune_starved < CONNECTION_TUNE_THRESHOLD ||
+       pool->headers_num >= private->tune_max)
+      return;
+
+   /* If the output queue is holding on to most of the buffers, the consumer
+    * is the bottleneck and extra buffers would only add latency */
+   if (mmal_queue_length(connection->queue) + 1 >= pool->headers_num)
+   {
+      private->tune_starved = 0;
+      return;
+   }
+
+   if (mmal_pool_grow(pool, 1) != MMAL_SUCCESS)
+      return;
+
+   private->tune_starved = 0;
+   connection->out->buffer_num = connection->in->buffer_num = pool->headers_num;
+   LOG_DEBUG("connection %s grown to %u buffers", connection->name,
+             pool->headers_num);
+}
+
 /** Callback from a clock port. Buffer is immediately sent to next component. */
 static void mmal_connection_bh_clock_cb(MMAL_PORT_T *port, MMAL_BUFFER_HEADER_T *buffer)
 {
@@ -80,9 +387,13 @@ static void mmal_connection_bh_in_cb(MMAL_PORT_T *port, MMAL_BUFFER_HEADER_T *bu
 static void mmal_connection_bh_out_cb(MMAL_PORT_T *port, MMAL_BUFFER_HEADER_T *buffer)
 {
    MMAL_CONNECTION_T *connection = (MMAL_CONNECTION_T *)port->userdata;
+   MMAL_CONNECTION_PRIVATE_T *private = (MMAL_CONNECTION_PRIVATE_T *)connection;
 
    LOG_TRACE("(%s)%p,%p,%p,%i", port->name, port, buffer, buffer->data, (int)buffer->length);
 
+   if (private->record)
+      mmal_connection_record_buffer(private, buffer);
+
    /* Queue the buffer produced by the output port */
    mmal_queue_put(connection->queue, buffer);
 
@@ -95,7 +406,12 @@ static MMAL_BOOL_T mmal_connection_bh_release_cb(MMAL_POOL_T *pool, MMAL_BUFFER_
    void *userdata)
 {
    MMAL_CONNECTION_T *connection = (MMAL_CONNECTION_T *)userdata;
-   MMAL_PARAM_UNUSED(pool);
+   MMAL_CONNECTION_PRIVATE_T *private = (MMAL_CONNECTION_PRIVATE_T *)connection;
+
+   /* A buffer coming back to an empty pool means the output port has been
+    * starved of buffers in the meantime */
+   if (private->tune_max && !mmal_queue_length(pool->queue))
+      mmal_connection_tune_starved(private);
 
    /* Queue the buffer produced by the output port */
    mmal_queue_put(pool->queue, buffer);
@@ -127,6 +443,7 @@ static MMAL_STATUS_T mmal_connection_destroy_internal(MMAL_CONNECTION_T *connect
    }
 
    /* Cleanup resources */
+   mmal_connection_record_stop((MMAL_CONNECTION_PRIVATE_T *)connection);
    if (connection->pool)
       mmal_pool_destroy(connection->pool);
    if (connection->queue)
@@ -227,6 +544,22 @@ MMAL_STATUS_T mmal_connection_create(MMAL_CONNECTION_T **cx,
       goto done;
    }
 
+   /* In zero-copy mode the payload is allocated in shared memory so the 2 ports
+    * only ever exchange buffer headers, never the payload itself. Both ports
+    * need to agree to this before the pool is created. */
+   if (connection->flags & MMAL_CONNECTION_FLAG_ZERO_COPY)
+   {
+      status = mmal_port_parameter_set_boolean(out, MMAL_PARAMETER_ZERO_COPY, MMAL_TRUE);
+      if (status == MMAL_SUCCESS || status == MMAL_ENOSYS)
+         status = mmal_port_parameter_set_boolean(in, MMAL_PARAMETER_ZERO_COPY, MMAL_TRUE);
+      if (status != MMAL_SUCCESS && status != MMAL_ENOSYS)
+      {
+         LOG_ERROR("failed to enable zero-copy on connection %s", name);
+         goto error;
+      }
+      status = MMAL_SUCCESS;
+   }
+
    /* Create empty pool of buffer headers for now (will be resized later on) */
    private->pool_port = (in->capabilities & MMAL_PORT_CAPABILITY_ALLOCATION) ? in : out;
    if (flags & MMAL_CONNECTION_FLAG_ALLOCATION_ON_INPUT)
@@ -376,6 +709,16 @@ MMAL_STATUS_T mmal_connection_enable(MMAL_CONNECTION_T *connection)
  done:
    connection->time_enable = vcos_getmicrosecs() - connection->time_enable;
    connection->is_enabled = status == MMAL_SUCCESS;
+
+   /* Start the record tap if requested. Tunnelled connections exchange their
+    * buffers entirely on the component side so there is nothing to capture.
+    * A re-enabled connection keeps appending to its existing capture. */
+   if (connection->is_enabled && !(connection->flags & MMAL_CONNECTION_FLAG_TUNNELLING))
+   {
+      MMAL_CONNECTION_PRIVATE_T *private = (MMAL_CONNECTION_PRIVATE_T *)connection;
+      if (!private->record)
+         mmal_connection_record_start(private);
+   }
    return status;
 }
 
@@ -383,7 +726,8 @@ MMAL_STATUS_T mmal_connection_enable(MMAL_CONNECTION_T *connection)
 MMAL_STATUS_T mmal_connection_disable(MMAL_CONNECTION_T *connection)
 {
    MMAL_STATUS_T status;
-   MMAL_BUFFER_HEADER_T *buffer;
+   MMAL_BUFFER_HEADER_T *buffers[16];
+   unsigned int num;
 
    LOG_TRACE("%p, %s", connection, connection->name);
 
@@ -418,12 +762,13 @@ MMAL_STATUS_T mmal_connection_disable(MMAL_CONNECTION_T *connection)
       goto done;
    }
 
-   /* Flush the queue */
-   buffer = mmal_queue_get(connection->queue);
-   while (buffer)
+   /* Flush the queue, a batch at a time */
+   while ((num = mmal_queue_get_all(connection->queue, buffers,
+                                    MMAL_COUNTOF(buffers))) != 0)
    {
-      mmal_buffer_header_release(buffer);
-      buffer = mmal_queue_get(connection->queue);
+      unsigned int i;
+      for (i = 0; i < num; i++)
+         mmal_buffer_header_release(buffers[i]);
    }
    vcos_assert(mmal_queue_length(connection->pool->queue) == connection->pool->headers_num);
 
@@ -433,6 +778,24 @@ MMAL_STATUS_T mmal_connection_disable(MMAL_CONNECTION_T *connection)
    return status;
 }
 
+/*****************************************************************************/
+MMAL_STATUS_T mmal_connection_auto_tune(MMAL_CONNECTION_T *connection,
+   uint32_t buffer_num_max)
+{
+   MMAL_CONNECTION_PRIVATE_T *private = (MMAL_CONNECTION_PRIVATE_T *)connection;
+
+   LOG_TRACE("%p, %s, max %u", connection, connection->name, buffer_num_max);
+
+   /* Tunnelled connections exchange their buffers entirely on the component
+    * side so there is no pool to tune */
+   if (connection->flags & MMAL_CONNECTION_FLAG_TUNNELLING)
+      return MMAL_ENOSYS;
+
+   private->tune_starved = 0;
+   private->tune_max = buffer_num_max;
+   return MMAL_SUCCESS;
+}
+
 /*****************************************************************************/
 static MMAL_STATUS_T mmal_connection_reconfigure(MMAL_CONNECTION_T *connection, MMAL_ES_FORMAT_T *format)
 {
@@ -100,6 +100,11 @@ extern "C" {
  * the connection itself but is used by the the graph utility to specify that
  * the buffer should be sent to the input port from with the port callback. */
 #define MMAL_CONNECTION_FLAG_DIRECT 0x10
+/** The connection should be zero-copy. The payload of the buffers used by the
+ * connection will be allocated in shared memory so only buffer headers transit
+ * between the 2 ports, without any copy of the payload itself. Both ports must
+ * support the \ref MMAL_PARAMETER_ZERO_COPY parameter for this to take effect. */
+#define MMAL_CONNECTION_FLAG_ZERO_COPY 0x20
 /* @} */
 
 /** Forward type definition for a connection */
@@ -208,6 +213,27 @@ MMAL_STATUS_T mmal_connection_enable(MMAL_CONNECTION_T *connection);
  */
 MMAL_STATUS_T mmal_connection_disable(MMAL_CONNECTION_T *connection);
 
+/** Enable runtime auto-tuning of the number of buffers of a connection.
+ * When armed, the connection monitors its own buffer flow and grows its pool
+ * of buffers (using \ref mmal_pool_grow) whenever the output port is found to
+ * be repeatedly starved of buffers, without the connection having to be
+ * disabled and re-enabled. The number of buffers never exceeds the given
+ * maximum and never goes below what was allocated when the connection was
+ * enabled, since buffers in flight cannot be safely reclaimed from a live
+ * pool. No adjustment is made while the output queue is backed up as the
+ * bottleneck is then on the consumer side and extra buffers would only add
+ * latency.
+ * This is not supported on tunnelled connections since their buffers are not
+ * exchanged on the host side.
+ *
+ * @param connection The connection to auto-tune.
+ * @param buffer_num_max Upper bound for the number of buffers, or 0 to
+ *                       disable auto-tuning.
+ * @return MMAL_SUCCESS on success.
+ */
+MMAL_STATUS_T mmal_connection_auto_tune(MMAL_CONNECTION_T *connection,
+   uint32_t buffer_num_max);
+
 /** Apply a format changed event to the connection.
  * This function can be used when the client is processing buffer headers and receives
  * a format changed event (\ref MMAL_EVENT_FORMAT_CHANGED). The connection is
@@ -25,9 +25,12 @@ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
 SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+#include <string.h>
+
 #include "mmal.h"
 #include "util/mmal_util.h"
 #include "util/mmal_graph.h"
+#include "util/mmal_async.h"
 #include "core/mmal_component_private.h"
 #include "core/mmal_port_private.h"
 #include "mmal_logging.h"
@@ -67,6 +70,9 @@ typedef struct MMAL_COMPONENT_MODULE_T
    MMAL_GRAPH_EVENT_CB event_cb; /**< callback for sending control port events to the client */
    void *event_cb_data;          /**< callback data supplied by the client */
 
+   MMAL_BOOL_T plan_buffers;     /**< plan the buffer budget of the connections before enabling them */
+   uint32_t latency_target[GRAPH_CONNECTIONS_MAX]; /**< latency target of each connection (in microseconds) */
+
 } MMAL_GRAPH_PRIVATE_T;
 
 typedef MMAL_GRAPH_PRIVATE_T MMAL_COMPONENT_MODULE_T;
@@ -76,6 +82,8 @@ static MMAL_STATUS_T mmal_component_create_from_graph(const char *name, MMAL_COM
 static MMAL_BOOL_T graph_do_processing(MMAL_GRAPH_PRIVATE_T *graph);
 static void graph_process_buffer(MMAL_GRAPH_PRIVATE_T *graph_private,
    MMAL_CONNECTION_T *connection, MMAL_BUFFER_HEADER_T *buffer);
+static MMAL_BOOL_T graph_component_topology_ports_linked(MMAL_GRAPH_PRIVATE_T *graph,
+   MMAL_PORT_T *port1, MMAL_PORT_T *port2);
 
 /*****************************************************************************/
 static void graph_control_cb(MMAL_PORT_T *port, MMAL_BUFFER_HEADER_T *buffer)
@@ -379,10 +387,142 @@ MMAL_STATUS_T mmal_graph_new_connection(MMAL_GRAPH_T *graph, MMAL_PORT_T *out, M
    return MMAL_SUCCESS;
 }
 
+/*****************************************************************************/
+/** Apply a latency target to a connection and to all the connections
+ * downstream of it */
+static void graph_latency_target_propagate(MMAL_GRAPH_PRIVATE_T *graph,
+   MMAL_CONNECTION_T *cx, uint32_t latency)
+{
+   MMAL_COMPONENT_T *component = cx->in->component;
+   unsigned int i, j;
+
+   for (i = 0; i < graph->connection_num; i++)
+      if (graph->connection[i] == cx)
+         break;
+   if (!vcos_verify(i < graph->connection_num))
+      return;
+
+   graph->latency_target[i] = latency;
+
+   /* Walk down the branch */
+   for (j = 0; j < graph->connection_num; j++)
+   {
+      if (j == i || graph->connection[j]->out->component != component)
+         continue;
+      if (graph->latency_target[j] == latency)
+         continue; /* Already visited (also guards against cycles) */
+      if (!graph_component_topology_ports_linked(graph, cx->in, graph->connection[j]->out))
+         continue; /* Ports are independent */
+      graph_latency_target_propagate(graph, graph->connection[j], latency);
+   }
+}
+
+/*****************************************************************************/
+MMAL_STATUS_T mmal_graph_latency_target(MMAL_GRAPH_T *graph, MMAL_PORT_T *port,
+   uint32_t latency)
+{
+   MMAL_GRAPH_PRIVATE_T *private = (MMAL_GRAPH_PRIVATE_T *)graph;
+   MMAL_BOOL_T found = MMAL_FALSE;
+   unsigned int i;
+
+   LOG_TRACE("graph: %p, port: %s(%p), latency: %uus", graph,
+             port ? port->name : 0, port, latency);
+
+   if (!port)
+   {
+      /* Graph-wide default */
+      for (i = 0; i < private->connection_num; i++)
+         private->latency_target[i] = latency;
+      private->plan_buffers = MMAL_TRUE;
+      return MMAL_SUCCESS;
+   }
+
+   for (i = 0; i < private->connection_num; i++)
+   {
+      if (private->connection[i]->out != port && private->connection[i]->in != port)
+         continue;
+      graph_latency_target_propagate(private, private->connection[i], latency);
+      found = MMAL_TRUE;
+   }
+
+   if (!found)
+      return MMAL_EINVAL; /* Port is not part of any of our connections */
+
+   private->plan_buffers = MMAL_TRUE;
+   return MMAL_SUCCESS;
+}
+
+/*****************************************************************************/
+/** Work out the minimum number of buffers a connection needs to sustain its
+ * latency target */
+static uint32_t graph_connection_buffers_needed(MMAL_CONNECTION_T *cx, uint32_t latency)
+{
+   MMAL_ES_FORMAT_T *format = cx->out->format;
+   uint32_t num = MMAL_MAX(cx->out->buffer_num_min, cx->in->buffer_num_min);
+
+   if (!num)
+      num = 1;
+
+   /* One extra buffer in transit between the 2 ports so neither ever sits
+    * idle waiting for the other to release one */
+   num++;
+
+   /* Enough buffering to absorb the requested latency at the rate the
+    * producer runs at */
+   if (latency && format->type == MMAL_ES_TYPE_VIDEO &&
+       format->es->video.frame_rate.num > 0 && format->es->video.frame_rate.den > 0)
+   {
+      uint64_t period = (uint64_t)format->es->video.frame_rate.den * 1000000;
+      num += (uint32_t)(((uint64_t)latency * format->es->video.frame_rate.num +
+                         period - 1) / period);
+   }
+
+   return num;
+}
+
+/*****************************************************************************/
+/** Plan the buffer budget of all our connections.
+ * The default behaviour of mmal_connection_enable is to use each port's
+ * recommended buffering which adds up to far more memory than a whole graph
+ * actually needs. Instead we work out the minimum safe number of buffers for
+ * each connection from the ports requirements and the latency targets
+ * declared by the client. */
+static void graph_buffer_plan(MMAL_GRAPH_PRIVATE_T *graph)
+{
+   unsigned int i;
+
+   for (i = 0; i < graph->connection_num; i++)
+   {
+      MMAL_CONNECTION_T *cx = graph->connection[i];
+      uint32_t buffer_num, buffer_size;
+
+      if (cx->flags & (MMAL_CONNECTION_FLAG_TUNNELLING |
+                       MMAL_CONNECTION_FLAG_KEEP_BUFFER_REQUIREMENTS))
+         continue; /* The ports / the client are already in charge of the budget */
+
+      buffer_num = graph_connection_buffers_needed(cx, graph->latency_target[i]);
+      buffer_size = MMAL_MAX(cx->out->buffer_size, cx->in->buffer_size);
+      buffer_size = MMAL_MAX(buffer_size, cx->out->buffer_size_min);
+      buffer_size = MMAL_MAX(buffer_size, cx->in->buffer_size_min);
+
+      LOG_DEBUG("%s: planned %u buffers of %u bytes (recommended %u/%u)",
+                cx->name, buffer_num, buffer_size,
+                cx->out->buffer_num_recommended, cx->in->buffer_num_recommended);
+
+      cx->out->buffer_num = cx->in->buffer_num = buffer_num;
+      cx->out->buffer_size = cx->in->buffer_size = buffer_size;
+
+      /* Stop mmal_connection_enable from overriding the plan with the
+       * (much larger) recommended values */
+      cx->flags |= MMAL_CONNECTION_FLAG_KEEP_BUFFER_REQUIREMENTS;
+   }
+}
+
 /*****************************************************************************/
 MMAL_STATUS_T mmal_graph_enable(MMAL_GRAPH_T *graph, MMAL_GRAPH_EVENT_CB cb, void *cb_data)
 {
    MMAL_GRAPH_PRIVATE_T *private = (MMAL_GRAPH_PRIVATE_T *)graph;
+   MMAL_ASYNC_T *async[GRAPH_CONNECTIONS_MAX];
    MMAL_STATUS_T status = MMAL_SUCCESS;
    unsigned int i;
 
@@ -398,16 +538,29 @@ MMAL_STATUS_T mmal_graph_enable(MMAL_GRAPH_T *graph, MMAL_GRAPH_EVENT_CB cb, voi
    private->event_cb = cb;
    private->event_cb_data = cb_data;
 
-   /* Enable all control ports */
+   /* Enable all control ports. The enables are issued concurrently so the
+    * round trips to VC overlap instead of adding up. */
    for (i = 0; i < private->component_num; i++)
    {
       private->component[i]->control->userdata = (void *)private;
-      status = mmal_port_enable(private->component[i]->control, graph_control_cb);
+      if (mmal_port_enable_async(private->component[i]->control, graph_control_cb,
+                                 NULL, NULL, &async[i]) != MMAL_SUCCESS)
+         async[i] = NULL; /* Fall back to enabling the port synchronously */
+   }
+   for (i = 0; i < private->component_num; i++)
+   {
+      status = async[i] ? mmal_async_wait(async[i]) :
+         mmal_port_enable(private->component[i]->control, graph_control_cb);
       if (status != MMAL_SUCCESS)
          LOG_ERROR("could not enable port %s", private->component[i]->control->name);
    }
+   status = MMAL_SUCCESS;
 
-   /* Enable all our connections */
+   /* Apply the buffer budget before the connections allocate their pools */
+   if (private->plan_buffers)
+      graph_buffer_plan(private);
+
+   /* Enable all our connections, concurrently as well */
    for (i = 0; i < private->connection_num; i++)
    {
       MMAL_CONNECTION_T *cx = private->connection[i];
@@ -415,10 +568,18 @@ MMAL_STATUS_T mmal_graph_enable(MMAL_GRAPH_T *graph, MMAL_GRAPH_EVENT_CB cb, voi
       cx->callback = graph_connection_cb;
       cx->user_data = private;
 
-      status = mmal_connection_enable(cx);
-      if (status != MMAL_SUCCESS)
-         goto error;
+      if (mmal_connection_enable_async(cx, NULL, NULL, &async[i]) != MMAL_SUCCESS)
+         async[i] = NULL;
+   }
+   for (i = 0; i < private->connection_num; i++)
+   {
+      MMAL_STATUS_T cx_status = async[i] ? mmal_async_wait(async[i]) :
+         mmal_connection_enable(private->connection[i]);
+      if (cx_status != MMAL_SUCCESS && status == MMAL_SUCCESS)
+         status = cx_status;
    }
+   if (status != MMAL_SUCCESS)
+      goto error;
 
    /* Trigger the worker thread to populate the output ports with empty buffers */
    vcos_semaphore_post(&private->sema);
@@ -451,6 +612,117 @@ MMAL_STATUS_T mmal_graph_disable(MMAL_GRAPH_T *graph)
    return status;
 }
 
+/*****************************************************************************/
+MMAL_STATUS_T mmal_graph_stats_dump(MMAL_GRAPH_T *graph)
+{
+   MMAL_GRAPH_PRIVATE_T *private = (MMAL_GRAPH_PRIVATE_T *)graph;
+   unsigned int i, j;
+
+   for (i = 0; i < private->component_num; i++)
+   {
+      MMAL_COMPONENT_T *component = private->component[i];
+
+      for (j = 0; j < component->port_num; j++)
+         mmal_port_stats_dump(component->port[j]);
+   }
+
+   return MMAL_SUCCESS;
+}
+
+/*****************************************************************************/
+#if MMAL_GRAPH_SNAPSHOT_ENTRIES_MAX < GRAPH_CONNECTIONS_MAX
+# error "MMAL_GRAPH_SNAPSHOT_ENTRIES_MAX cannot hold GRAPH_CONNECTIONS_MAX entries"
+#endif
+
+static uint32_t graph_snapshot_component_index(MMAL_GRAPH_PRIVATE_T *private,
+   MMAL_PORT_T *port)
+{
+   unsigned int i;
+
+   for (i = 0; i < private->component_num; i++)
+      if (private->component[i] == port->component)
+         return i;
+
+   return 0xffffffff;
+}
+
+static void graph_snapshot_port(MMAL_GRAPH_PRIVATE_T *private, MMAL_PORT_T *port,
+   MMAL_GRAPH_PORT_SNAPSHOT_T *snap)
+{
+   MMAL_ES_FORMAT_T *format = port->format;
+
+   snap->component = graph_snapshot_component_index(private, port);
+   snap->type = port->type;
+   snap->index = port->index;
+   snap->is_enabled = port->is_enabled;
+   snap->buffer_num = port->buffer_num;
+   snap->buffer_size = port->buffer_size;
+
+   snap->es_type = format->type;
+   snap->encoding = format->encoding;
+   snap->encoding_variant = format->encoding_variant;
+   snap->bitrate = format->bitrate;
+   if (format->type == MMAL_ES_TYPE_VIDEO)
+   {
+      snap->width = format->es->video.width;
+      snap->height = format->es->video.height;
+      snap->frame_rate = format->es->video.frame_rate;
+   }
+   else if (format->type == MMAL_ES_TYPE_AUDIO)
+   {
+      snap->sample_rate = format->es->audio.sample_rate;
+      snap->channels = format->es->audio.channels;
+   }
+}
+
+MMAL_STATUS_T mmal_graph_snapshot(MMAL_GRAPH_T *graph, MMAL_GRAPH_SNAPSHOT_T *snapshot)
+{
+   MMAL_GRAPH_PRIVATE_T *private = (MMAL_GRAPH_PRIVATE_T *)graph;
+   unsigned int i;
+
+   LOG_TRACE("graph: %p, snapshot: %p", graph, snapshot);
+
+   if (!snapshot)
+      return MMAL_EINVAL;
+
+   memset(snapshot, 0, sizeof(*snapshot));
+
+   snapshot->component_num = private->component_num;
+   for (i = 0; i < private->component_num; i++)
+   {
+      MMAL_COMPONENT_T *component = private->component[i];
+      MMAL_GRAPH_COMPONENT_SNAPSHOT_T *snap = &snapshot->component[i];
+
+      strncpy(snap->name, component->name, sizeof(snap->name) - 1);
+      snap->is_enabled = component->is_enabled;
+      snap->port_num = component->port_num;
+   }
+
+   snapshot->connection_num = private->connection_num;
+   for (i = 0; i < private->connection_num; i++)
+   {
+      MMAL_CONNECTION_T *connection = private->connection[i];
+      MMAL_GRAPH_CONNECTION_SNAPSHOT_T *snap = &snapshot->connection[i];
+
+      graph_snapshot_port(private, connection->out, &snap->out);
+      graph_snapshot_port(private, connection->in, &snap->in);
+      snap->flags = connection->flags;
+      snap->is_enabled = connection->is_enabled;
+   }
+
+   snapshot->input_num = private->input_num;
+   for (i = 0; i < private->input_num; i++)
+      graph_snapshot_port(private, private->input[i], &snapshot->input[i]);
+   snapshot->output_num = private->output_num;
+   for (i = 0; i < private->output_num; i++)
+      graph_snapshot_port(private, private->output[i], &snapshot->output[i]);
+   snapshot->clock_num = private->clock_num;
+   for (i = 0; i < private->clock_num; i++)
+      graph_snapshot_port(private, private->clock[i], &snapshot->clock[i]);
+
+   return MMAL_SUCCESS;
+}
+
 /*****************************************************************************/
 MMAL_STATUS_T mmal_graph_build(MMAL_GRAPH_T *graph,
    const char *name, MMAL_COMPONENT_T **component)
@@ -171,6 +171,25 @@ MMAL_STATUS_T mmal_graph_new_component(MMAL_GRAPH_T *graph, const char *name,
 MMAL_STATUS_T mmal_graph_new_connection(MMAL_GRAPH_T *graph, MMAL_PORT_T *out, MMAL_PORT_T *in,
    uint32_t flags, MMAL_CONNECTION_T **connection);
 
+/** Declare a latency target for a branch of the graph.
+ * This arms the buffer budget planner of the graph. When the graph is enabled,
+ * each connection is given the minimum safe number of buffers to sustain its
+ * latency target instead of the (usually much larger) buffering recommended
+ * by its ports. The target applies to the connections attached to the given
+ * port and to every connection downstream of them.
+ * Connections created with \ref MMAL_CONNECTION_FLAG_KEEP_BUFFER_REQUIREMENTS
+ * are left untouched by the planner.
+ *
+ * @param graph   instance of the graph
+ * @param port    port identifying the branch, or NULL to set the graph-wide
+ *                default
+ * @param latency amount of buffering the branch should be able to absorb
+ *                (in microseconds)
+ * @return MMAL_SUCCESS on success
+ */
+MMAL_STATUS_T mmal_graph_latency_target(MMAL_GRAPH_T *graph, MMAL_PORT_T *port,
+   uint32_t latency);
+
 /** Definition of the callback used by a graph to send events to the client.
  *
  * @param graph   the graph sending the event
@@ -193,6 +212,93 @@ MMAL_STATUS_T mmal_graph_enable(MMAL_GRAPH_T *graph, MMAL_GRAPH_EVENT_CB cb, voi
 
 MMAL_STATUS_T mmal_graph_disable(MMAL_GRAPH_T *graph);
 
+/** Log a summary of the core port counters of every component in a graph.
+ * This logs one line per port using \ref mmal_port_stats_dump, giving a
+ * quick overview of the buffer flow through the whole graph without the
+ * client having to query each port individually.
+ *
+ * @param graph graph instance
+ * @return MMAL_SUCCESS on success
+ */
+MMAL_STATUS_T mmal_graph_stats_dump(MMAL_GRAPH_T *graph);
+
+/** Maximum number of entries of each kind reported in a graph snapshot */
+#define MMAL_GRAPH_SNAPSHOT_ENTRIES_MAX 16
+/** Size of the component name field of a graph snapshot */
+#define MMAL_GRAPH_SNAPSHOT_NAME_MAX 32
+
+/** Description of one port in a graph snapshot.
+ * The format summary is copied from the host-side view of the port format. */
+typedef struct MMAL_GRAPH_PORT_SNAPSHOT_T
+{
+   uint32_t component;         /**< index of the owning component in the snapshot, or
+                                 * 0xffffffff if the port does not belong to the graph */
+   MMAL_PORT_TYPE_T type;      /**< type of the port */
+   uint32_t index;             /**< index of the port within its type */
+   MMAL_BOOL_T is_enabled;     /**< whether the port is currently enabled */
+   uint32_t buffer_num;        /**< actual number of buffers set on the port */
+   uint32_t buffer_size;       /**< actual size of the buffers set on the port */
+
+   MMAL_ES_TYPE_T es_type;     /**< type of the elementary stream */
+   MMAL_FOURCC_T encoding;     /**< encoding of the elementary stream */
+   MMAL_FOURCC_T encoding_variant; /**< encoding variant of the elementary stream */
+   uint32_t bitrate;           /**< bitrate in bits per second */
+   uint32_t width;             /**< frame width (video streams only) */
+   uint32_t height;            /**< frame height (video streams only) */
+   MMAL_RATIONAL_T frame_rate; /**< frame rate (video streams only) */
+   uint32_t sample_rate;       /**< sample rate (audio streams only) */
+   uint32_t channels;          /**< number of channels (audio streams only) */
+
+} MMAL_GRAPH_PORT_SNAPSHOT_T;
+
+/** Description of one component in a graph snapshot */
+typedef struct MMAL_GRAPH_COMPONENT_SNAPSHOT_T
+{
+   char name[MMAL_GRAPH_SNAPSHOT_NAME_MAX]; /**< name of the component (truncated if too long) */
+   MMAL_BOOL_T is_enabled;     /**< whether the component is currently enabled */
+   uint32_t port_num;          /**< total number of ports of the component */
+
+} MMAL_GRAPH_COMPONENT_SNAPSHOT_T;
+
+/** Description of one internal connection in a graph snapshot */
+typedef struct MMAL_GRAPH_CONNECTION_SNAPSHOT_T
+{
+   MMAL_GRAPH_PORT_SNAPSHOT_T out; /**< output port of the connection */
+   MMAL_GRAPH_PORT_SNAPSHOT_T in;  /**< input port of the connection */
+   uint32_t flags;             /**< flags the connection was created with */
+   MMAL_BOOL_T is_enabled;     /**< whether the connection is currently enabled */
+
+} MMAL_GRAPH_CONNECTION_SNAPSHOT_T;
+
+/** Self-contained description of the current state of a graph.
+ * The structure contains no pointers so it can be copied or serialised as-is. */
+typedef struct MMAL_GRAPH_SNAPSHOT_T
+{
+   uint32_t component_num;     /**< number of components in the graph */
+   MMAL_GRAPH_COMPONENT_SNAPSHOT_T component[MMAL_GRAPH_SNAPSHOT_ENTRIES_MAX];
+   uint32_t connection_num;    /**< number of internal connections in the graph */
+   MMAL_GRAPH_CONNECTION_SNAPSHOT_T connection[MMAL_GRAPH_SNAPSHOT_ENTRIES_MAX];
+   uint32_t input_num;         /**< number of input ports exposed by the graph */
+   MMAL_GRAPH_PORT_SNAPSHOT_T input[MMAL_GRAPH_SNAPSHOT_ENTRIES_MAX];
+   uint32_t output_num;        /**< number of output ports exposed by the graph */
+   MMAL_GRAPH_PORT_SNAPSHOT_T output[MMAL_GRAPH_SNAPSHOT_ENTRIES_MAX];
+   uint32_t clock_num;         /**< number of clock ports exposed by the graph */
+   MMAL_GRAPH_PORT_SNAPSHOT_T clock[MMAL_GRAPH_SNAPSHOT_ENTRIES_MAX];
+
+} MMAL_GRAPH_SNAPSHOT_T;
+
+/** Take a snapshot of the topology and port formats of a graph.
+ * The snapshot is built entirely from the state which the graph and the ports
+ * already maintain on the host side, so taking one does not generate any
+ * traffic to the component side and is cheap enough to be used for periodic
+ * health checks of a running graph.
+ *
+ * @param graph    graph instance
+ * @param snapshot filled with the description of the graph
+ * @return MMAL_SUCCESS on success
+ */
+MMAL_STATUS_T mmal_graph_snapshot(MMAL_GRAPH_T *graph, MMAL_GRAPH_SNAPSHOT_T *snapshot);
+
 /** Find a port in the graph.
  *
  * @param graph graph instance
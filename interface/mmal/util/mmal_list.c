@@ -219,3 +219,67 @@ void mmal_list_insert(MMAL_LIST_T *list, MMAL_LIST_ELEMENT_T *element, MMAL_LIST
    mmal_list_unlock(list);
    mmal_list_push_back(list, element);
 }
+
+/* Move elements from one list to the back of another. */
+unsigned int mmal_list_splice_back(MMAL_LIST_T *dest, MMAL_LIST_T *src,
+   unsigned int num)
+{
+   MMAL_LIST_ELEMENT_T *first, *last;
+   unsigned int moved;
+
+   /* Detach the elements from the source list first. The chain is carried
+    * across unlocked so each list is only locked once, whatever the number
+    * of elements moved, and no 2 list locks are ever held together. */
+   mmal_list_lock(src);
+
+   first = src->first;
+   if (first == NULL)
+   {
+      mmal_list_unlock(src);
+      return 0;
+   }
+
+   if (num != 0 && num < src->length)
+   {
+      unsigned int i;
+
+      last = first;
+      for (i = 1; i < num; i++)
+         last = last->next;
+
+      src->first = last->next;
+      src->first->prev = NULL;
+      src->length -= num;
+      moved = num;
+   }
+   else
+   {
+      last = src->last;
+      moved = src->length;
+      src->first = NULL;
+      src->last = NULL;
+      src->length = 0;
+   }
+
+   first->prev = NULL;
+   last->next = NULL;
+
+   mmal_list_unlock(src);
+
+   /* Append the whole chain to the destination list */
+   mmal_list_lock(dest);
+
+   dest->length += moved;
+
+   first->prev = dest->last;
+   if (dest->last)
+      dest->last->next = first;
+   else
+      dest->first = first; /* list was empty */
+
+   dest->last = last;
+
+   mmal_list_unlock(dest);
+
+   return moved;
+}
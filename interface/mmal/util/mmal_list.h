@@ -118,6 +118,20 @@ typedef int (*MMAL_LIST_COMPARE_T)(MMAL_LIST_ELEMENT_T *lhs, MMAL_LIST_ELEMENT_T
  */
 void mmal_list_insert(MMAL_LIST_T *list, MMAL_LIST_ELEMENT_T *element, MMAL_LIST_COMPARE_T compare);
 
+/** Move elements from one list to the back of another.
+ * All the elements are moved in a single lock acquisition on each list,
+ * making this much cheaper than popping and pushing the elements one at
+ * a time when recycling a burst of them.
+ *
+ * @param dest    List to add the elements to
+ * @param src     List to remove the elements from
+ * @param num     Maximum number of elements to move (0 to move them all)
+ *
+ * @return Number of elements moved
+ */
+unsigned int mmal_list_splice_back(MMAL_LIST_T *dest, MMAL_LIST_T *src,
+   unsigned int num);
+
 /* @} */
 
 #ifdef __cplusplus
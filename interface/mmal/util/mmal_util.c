@@ -213,16 +213,30 @@ void mmal_buffer_header_copy_header(MMAL_BUFFER_HEADER_T *dest, const MMAL_BUFFE
 /** Create a pool of MMAL_BUFFER_HEADER_T */
 MMAL_POOL_T *mmal_port_pool_create(MMAL_PORT_T *port, unsigned int headers, uint32_t payload_size)
 {
+   MMAL_PORT_PAYLOAD_SLAB_T *slab = NULL;
+   MMAL_POOL_T *pool;
+
    if (!port || !port->priv)
       return NULL;
 
    LOG_TRACE("%s(%i:%i) port %p, headers %u, size %i", port->component->name,
              (int)port->type, (int)port->index, port, headers, (int)payload_size);
 
+   /* We know upfront how much memory the pool needs, so get it all in one go
+    * and have the payload allocator carve it up. If the slab cannot be
+    * created the payloads just get allocated individually as before. */
+   if (headers > 1 && payload_size)
+      slab = mmal_port_payload_slab_create(port, payload_size, headers);
+
    /* Create a pool and ask the port for some memory */
-   return mmal_pool_create_with_allocator(headers, payload_size, (void *)port,
+   pool = mmal_pool_create_with_allocator(headers, payload_size, (void *)port,
                                           (mmal_pool_allocator_alloc_t)mmal_port_payload_alloc,
                                           (mmal_pool_allocator_free_t)mmal_port_payload_free);
+
+   if (slab)
+      mmal_port_payload_slab_release(port, slab);
+
+   return pool;
 }
 
 /** Destroy a pool of MMAL_BUFFER_HEADER_T */
@@ -55,6 +55,14 @@ typedef enum MMAL_PORT_FLUSH_CHECK_T
    PORT_FLUSH_INCOMPATIBLE
 } MMAL_PORT_FLUSH_CHECK_T;
 
+/** Cached copy of a parameter successfully set on a port. Used to elide the
+ * round trip to VC when a parameter is set again to its current value. */
+typedef struct MMAL_VC_PARAM_CACHE_T
+{
+   struct MMAL_VC_PARAM_CACHE_T *next;
+   MMAL_PARAMETER_HEADER_T param;   /**< Copy of the parameter, allocated to param.size */
+} MMAL_VC_PARAM_CACHE_T;
+
 typedef struct MMAL_PORT_MODULE_T
 {
    uint32_t magic;
@@ -72,6 +80,8 @@ typedef struct MMAL_PORT_MODULE_T
    MMAL_BOOL_T sent_data_on_port;
 
    MMAL_PORT_T *connected;           /**< Connected port if any */
+
+   MMAL_VC_PARAM_CACHE_T *param_cache; /**< Write-through cache of the parameters set on the port */
 } MMAL_PORT_MODULE_T;
 
 typedef struct MMAL_COMPONENT_MODULE_T
@@ -92,6 +102,7 @@ typedef struct MMAL_COMPONENT_MODULE_T
  *****************************************************************************/
 static void mmal_vc_do_callback(MMAL_COMPONENT_T *component);
 static MMAL_STATUS_T mmal_vc_port_info_get(MMAL_PORT_T *port);
+static void mmal_vc_port_param_cache_flush(MMAL_PORT_MODULE_T *module);
 
 /*****************************************************************************/
 MMAL_STATUS_T mmal_vc_get_version(uint32_t *major, uint32_t *minor, uint32_t *minimum)
@@ -202,6 +213,21 @@ static MMAL_STATUS_T mmal_vc_port_requirements_get(MMAL_PORT_T *port)
    return MMAL_SUCCESS;
 }
 
+/** Associate our vc client context to an event buffer.
+ * The whole event pool is stamped in one go when the first port is enabled, but
+ * the pool can grow while the component is running so buffers added since then
+ * are dealt with here. */
+void mmal_vc_event_buffer_prepare(MMAL_PORT_T *port, MMAL_BUFFER_HEADER_T *buffer)
+{
+   MMAL_DRIVER_BUFFER_T *drv = mmal_buffer_header_driver_data(buffer);
+
+   if (drv->magic == MMAL_MAGIC && drv->client_context)
+      return;
+
+   drv->client_context = &port->component->priv->module->event_ctx;
+   drv->magic = MMAL_MAGIC;
+}
+
 /** Enable processing on a port */
 static MMAL_STATUS_T mmal_vc_port_enable(MMAL_PORT_T *port, MMAL_PORT_BH_CB_T cb)
 {
@@ -787,6 +813,12 @@ static MMAL_STATUS_T mmal_vc_component_destroy(MMAL_COMPONENT_T *component)
       goto fail;
    }
 
+   {
+      unsigned int i;
+      for (i = 0; i < component->priv->module->ports_num; i++)
+         mmal_vc_port_param_cache_flush(component->priv->module->ports[i]);
+   }
+
    if(component->input_num)
       mmal_ports_free(component->input, component->input_num);
    if(component->output_num)
@@ -1057,6 +1089,100 @@ static MMAL_STATUS_T mmal_vc_port_info_set(MMAL_PORT_T *port)
 }
 
 /** Set format on a port */
+/** The cache may only elide parameters known to purely hold state.
+ * Parameters which trigger an action on the component (capture, I-frame
+ * requests, seeks, ...) must always reach it, even when the blob is
+ * unchanged, so anything not explicitly listed here is never cached.
+ * Missing an entry only costs a redundant round trip. */
+static MMAL_BOOL_T mmal_vc_port_param_cacheable(uint32_t id)
+{
+   switch (id)
+   {
+   case MMAL_PARAMETER_ZERO_COPY:
+   case MMAL_PARAMETER_ROTATION:
+   case MMAL_PARAMETER_MIRROR:
+   case MMAL_PARAMETER_SATURATION:
+   case MMAL_PARAMETER_SHARPNESS:
+   case MMAL_PARAMETER_CONTRAST:
+   case MMAL_PARAMETER_BRIGHTNESS:
+   case MMAL_PARAMETER_ISO:
+   case MMAL_PARAMETER_EXPOSURE_COMP:
+   case MMAL_PARAMETER_EXPOSURE_MODE:
+   case MMAL_PARAMETER_EXP_METERING_MODE:
+   case MMAL_PARAMETER_AWB_MODE:
+   case MMAL_PARAMETER_IMAGE_EFFECT:
+   case MMAL_PARAMETER_FLICKER_AVOID:
+   case MMAL_PARAMETER_VIDEO_STABILISATION:
+   case MMAL_PARAMETER_FPS_RANGE:
+      return MMAL_TRUE;
+   default:
+      return MMAL_FALSE;
+   }
+}
+
+/** Checks whether a parameter is already set to the requested value.
+ * The caller is expected to hold the port lock. */
+static MMAL_BOOL_T mmal_vc_port_param_cache_hit(MMAL_PORT_MODULE_T *module,
+   const MMAL_PARAMETER_HEADER_T *param)
+{
+   MMAL_VC_PARAM_CACHE_T *entry;
+
+   if (!mmal_vc_port_param_cacheable(param->id))
+      return MMAL_FALSE;
+
+   for (entry = module->param_cache; entry; entry = entry->next)
+      if (entry->param.id == param->id)
+         return entry->param.size == param->size &&
+                !memcmp(&entry->param, param, param->size);
+
+   return MMAL_FALSE;
+}
+
+/** Stores the value of a parameter which was successfully set on VC.
+ * Failing to allocate a cache entry is harmless so isn't reported. */
+static void mmal_vc_port_param_cache_store(MMAL_PORT_MODULE_T *module,
+   const MMAL_PARAMETER_HEADER_T *param)
+{
+   MMAL_VC_PARAM_CACHE_T **prev, *entry;
+
+   if (!mmal_vc_port_param_cacheable(param->id))
+      return;
+
+   for (prev = &module->param_cache; (entry = *prev) != NULL; prev = &entry->next)
+      if (entry->param.id == param->id)
+         break;
+
+   if (entry && entry->param.size != param->size)
+   {
+      *prev = entry->next;
+      vcos_free(entry);
+      entry = NULL;
+   }
+
+   if (!entry)
+   {
+      entry = vcos_malloc(MMAL_OFFSET(MMAL_VC_PARAM_CACHE_T, param) + param->size,
+                          "mmal_vc param cache");
+      if (!entry)
+         return;
+      entry->next = module->param_cache;
+      module->param_cache = entry;
+   }
+
+   memcpy(&entry->param, param, param->size);
+}
+
+/** Discards all the cached parameter values of a port */
+static void mmal_vc_port_param_cache_flush(MMAL_PORT_MODULE_T *module)
+{
+   while (module->param_cache)
+   {
+      MMAL_VC_PARAM_CACHE_T *entry = module->param_cache;
+      module->param_cache = entry->next;
+      vcos_free(entry);
+   }
+}
+
 static MMAL_STATUS_T mmal_vc_port_set_format(MMAL_PORT_T *port)
 {
    MMAL_COMPONENT_T *component = port->component;
@@ -1064,6 +1190,11 @@ static MMAL_STATUS_T mmal_vc_port_set_format(MMAL_PORT_T *port)
    MMAL_STATUS_T status;
    unsigned int i;
 
+   /* Committing a format can change the value of any parameter on any port of
+    * the component so the cached ones are all stale */
+   for (i = 0; i < module->ports_num; i++)
+      mmal_vc_port_param_cache_flush(module->ports[i]);
+
    status = mmal_vc_port_info_set(port);
    if (status != MMAL_SUCCESS)
    {
@@ -1108,7 +1239,6 @@ static MMAL_STATUS_T mmal_vc_port_parameter_set(MMAL_PORT_T *port, const MMAL_PA
    MMAL_PORT_MODULE_T *module = port->priv->module;
    MMAL_STATUS_T status;
    mmal_worker_port_param_set msg;
-   size_t msglen = MMAL_OFFSET(mmal_worker_port_param_set, param) + param->size;
    mmal_worker_reply reply;
    size_t replylen = sizeof(reply);
 
@@ -1124,16 +1254,27 @@ static MMAL_STATUS_T mmal_vc_port_parameter_set(MMAL_PORT_T *port, const MMAL_PA
    {
       module->is_zero_copy = !!((MMAL_PARAMETER_BOOLEAN_T *)param)->enable;
       module->zero_copy_workaround = ((MMAL_PARAMETER_BOOLEAN_T *)param)->enable == 0xBEEF;
+      /* Zero copy payloads are tracked individually by the shared memory
+       * service so they cannot be carved out of a payload slab */
+      port->priv->payload_slab_unsupported = module->is_zero_copy;
       LOG_DEBUG("%s zero copy on port %p", module->is_zero_copy ? "enable" : "disable", port);
    }
 
+   /* Setting a parameter to the value it already has does not need the round
+    * trip to VC. Clients like the camera control code set their whole list of
+    * parameters on every configuration pass. */
+   if (mmal_vc_port_param_cache_hit(module, param))
+      return MMAL_SUCCESS;
+
    msg.component_handle = module->component_handle;
    msg.port_handle = module->port_handle;
-   /* coverity[overrun-buffer-arg] */
-   memcpy(&msg.param, param, param->size);
 
-   status = mmal_vc_sendwait_message(mmal_vc_get_client(), &msg.header, msglen,
-                                     MMAL_WORKER_PORT_PARAMETER_SET, &reply, &replylen, MMAL_FALSE);
+   /* The parameter is sent as a second scatter element rather than being
+    * copied into the message */
+   status = mmal_vc_sendwait_message_v(mmal_vc_get_client(), &msg.header,
+                                       MMAL_OFFSET(mmal_worker_port_param_set, param),
+                                       param, param->size,
+                                       MMAL_WORKER_PORT_PARAMETER_SET, &reply, &replylen);
 
    if (status == MMAL_SUCCESS)
    {
@@ -1147,6 +1288,8 @@ static MMAL_STATUS_T mmal_vc_port_parameter_set(MMAL_PORT_T *port, const MMAL_PA
       return status;
    }
 
+   mmal_vc_port_param_cache_store(module, param);
+
    if (param->id == MMAL_PARAMETER_BUFFER_REQUIREMENTS)
    {
       /* This might have changed the buffer requirements of other ports so fetch them all */
@@ -1167,7 +1310,6 @@ static MMAL_STATUS_T mmal_vc_port_parameter_get(MMAL_PORT_T *port, MMAL_PARAMETE
    MMAL_PORT_MODULE_T *module = port->priv->module;
    MMAL_STATUS_T status;
    mmal_worker_port_param_get msg;
-   size_t msglen = MMAL_OFFSET(mmal_worker_port_param_get, param) + param->size;
    mmal_worker_port_param_get_reply reply;
    size_t replylen = MMAL_OFFSET(mmal_worker_port_param_get_reply, param) + param->size;
 
@@ -1180,10 +1322,13 @@ static MMAL_STATUS_T mmal_vc_port_parameter_get(MMAL_PORT_T *port, MMAL_PARAMETE
 
    msg.component_handle = module->component_handle;
    msg.port_handle = module->port_handle;
-   memcpy(&msg.param, param, param->size);
 
-   status = mmal_vc_sendwait_message(mmal_vc_get_client(), &msg.header, msglen,
-                                     MMAL_WORKER_PORT_PARAMETER_GET, &reply, &replylen, MMAL_FALSE);
+   /* The parameter is sent as a second scatter element rather than being
+    * copied into the message */
+   status = mmal_vc_sendwait_message_v(mmal_vc_get_client(), &msg.header,
+                                       MMAL_OFFSET(mmal_worker_port_param_get, param),
+                                       param, param->size,
+                                       MMAL_WORKER_PORT_PARAMETER_GET, &reply, &replylen);
    if (status == MMAL_SUCCESS)
    {
       status = reply.status;
@@ -1286,6 +1431,21 @@ static uint8_t *mmal_vc_port_payload_alloc(MMAL_PORT_T *port, uint32_t payload_s
    return ret;
 }
 
+uint8_t *mmal_vc_payload_import(uint32_t vcsm_handle)
+{
+   return mmal_vc_shm_import(vcsm_handle);
+}
+
+uint32_t mmal_vc_payload_export(uint8_t *mem)
+{
+   return mmal_vc_shm_export(mem);
+}
+
+MMAL_STATUS_T mmal_vc_payload_release(uint8_t *mem)
+{
+   return mmal_vc_shm_free(mem);
+}
+
 static void mmal_vc_port_payload_free(MMAL_PORT_T *port, uint8_t *payload)
 {
    MMAL_PORT_MODULE_T *module = port->priv->module;
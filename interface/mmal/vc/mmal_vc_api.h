@@ -154,6 +154,36 @@ MMAL_STATUS_T mmal_vc_release(void);
 MMAL_STATUS_T mmal_vc_get_version(uint32_t *major, uint32_t *minor, uint32_t *minimum);
 MMAL_STATUS_T mmal_vc_get_stats(MMAL_VC_STATS_T *stats, int reset);
 
+/** Number of buckets in a host-observed IPC latency histogram */
+#define MMAL_VC_LATENCY_BUCKETS 8
+
+/** Host-observed latency histogram for one message type, recorded around
+ * the reply wait of every waiting control transaction. */
+typedef struct MMAL_VC_MSG_LATENCY_T
+{
+   uint32_t count[MMAL_VC_LATENCY_BUCKETS];    /**< Number of calls per latency bucket */
+   uint32_t bound_us[MMAL_VC_LATENCY_BUCKETS]; /**< Upper bound of each bucket in
+                                                    microseconds (0 means unbounded) */
+   uint32_t max_us;                            /**< Slowest call observed (us) */
+} MMAL_VC_MSG_LATENCY_T;
+
+/** Return the latency histogram the client has recorded for a message type.
+ *
+ * @param msgid  Message type (one of the MMAL_WORKER_xxx message ids)
+ * @param stats  Updated with the histogram for this message type
+ * @return MMAL_SUCCESS, or MMAL_EINVAL for an out of range message id.
+ */
+MMAL_STATUS_T mmal_vc_msg_latency_get(uint32_t msgid, MMAL_VC_MSG_LATENCY_T *stats);
+
+/** Set the slow control call threshold. Any waiting control transaction
+ * taking at least this long is logged as an error along with its message
+ * name. The threshold can also be set with the MMAL_VC_SLOW_MSG_US
+ * environment variable; it defaults to 0, which disables the logging.
+ *
+ * @param threshold_us Threshold in microseconds (0 to disable).
+ */
+void mmal_vc_msg_latency_threshold(uint32_t threshold_us);
+
 /** Return the MMAL core statistics for a given component/port.
  *
  * @param stats         Updated with given port statistics
@@ -186,6 +216,38 @@ MMAL_STATUS_T mmal_vc_get_core_stats(MMAL_CORE_STATISTICS_T *stats,
  */
 MMAL_STATUS_T mmal_vc_host_log(const char *msg);
 
+/** Import memory allocated with the vcsm allocator as a port payload.
+ * This allows buffers produced outside of MMAL (e.g. rendered by the GPU)
+ * to be sent on a port which has zero copy enabled without any staging
+ * copy: set the returned pointer as the data field of a buffer header.
+ * Ownership of the handle stays with the caller, who must keep it
+ * allocated until \ref mmal_vc_payload_release has been called.
+ *
+ * @param vcsm_handle  Handle of the vcsm allocation to import.
+ * @return Pointer to use as a buffer header payload (or NULL on failure).
+ */
+uint8_t *mmal_vc_payload_import(uint32_t vcsm_handle);
+
+/** Export the vcsm handle backing a port payload.
+ * This allows payloads allocated by a port with zero copy enabled (e.g. with
+ * \ref mmal_port_payload_alloc or \ref mmal_port_pool_create) to be handed
+ * to other users of shared memory, such as the GPU, without a copy.
+ * The handle remains owned by the port payload and must not be freed.
+ *
+ * @param mem  Payload memory allocated by a port.
+ * @return The vcsm handle backing the payload, or 0 if the payload is not
+ * backed by shared memory.
+ */
+uint32_t mmal_vc_payload_export(uint8_t *mem);
+
+/** Release a payload previously imported with \ref mmal_vc_payload_import.
+ * The underlying vcsm handle is not freed and stays with its owner.
+ *
+ * @param mem  Payload previously returned by \ref mmal_vc_payload_import.
+ * @return MMAL_SUCCESS or MMAL_EINVAL if the payload is not known.
+ */
+MMAL_STATUS_T mmal_vc_payload_release(uint8_t *mem);
+
 /* For backwards compatibility in builds */
 #define MMAL_VC_API_HAVE_HOST_LOG
 
@@ -31,19 +31,23 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "mmal_vc_api.h"
 #include "mmal_vc_client_priv.h"
 #include "interface/vcos/vcos.h"
+#include "interface/vcos/vcos_usdt.h"
 #include "vchiq_util.h"
 #include "interface/mmal/core/mmal_buffer_private.h"
 #include "interface/mmal/core/mmal_component_private.h"
 #include "interface/mmal/core/mmal_port_private.h"
 #include "interface/mmal/util/mmal_list.h"
 #include "interface/mmal/util/mmal_util.h"
+#include "mmal_vc_msgnames.h"
 
 #define VCOS_LOG_CATEGORY (&mmal_ipc_log_category)
 #include "interface/mmal/mmal_logging.h"
 
 #include <stdio.h>
+#include <stdlib.h>
 
-#define MAX_WAITERS 16
+#define MAX_WAITERS 16        /* default waitpool size */
+#define MAX_WAITERS_LIMIT 128 /* upper bound for MMAL_VC_WAITERS */
 static VCOS_ONCE_T once = VCOS_ONCE_INIT;
 static VCHIQ_INSTANCE_T mmal_vchiq_instance;
 static VCOS_LOG_CAT_T mmal_ipc_log_category;
@@ -53,6 +57,7 @@ static VCOS_LOG_CAT_T mmal_ipc_log_category;
  */
 typedef struct MMAL_WAITER_T
 {
+   struct MMAL_WAITER_T *next;   /**< Next waiter in the free list */
    VCOS_SEMAPHORE_T sem;
    unsigned inuse;
    void *dest;                   /**< Where to write reply */
@@ -63,10 +68,20 @@ typedef struct MMAL_WAITER_T
   * threads. They can be released back to the pool in any order.
   * If there are none free, the calling thread will block until
   * one becomes available.
+  * Free waiters are kept in a LIFO under the pool's own lock so that
+  * grabbing and releasing one is O(1) and does not contend with the
+  * other users of the client lock. Every control transaction goes
+  * through here so this is on the critical path of small messages.
+  * The pool size defaults to MAX_WAITERS but can be raised with the
+  * MMAL_VC_WAITERS environment variable for processes running many
+  * pipelines, where the default is enough to stall control callers.
   */
-typedef struct 
+typedef struct
 {
-   MMAL_WAITER_T waiters[MAX_WAITERS];
+   MMAL_WAITER_T *waiters;
+   unsigned size;
+   MMAL_WAITER_T *free_list;
+   VCOS_MUTEX_T lock;
    VCOS_SEMAPHORE_T sem;
 } MMAL_WAITPOOL_T;
 
@@ -87,6 +102,70 @@ struct MMAL_CLIENT_T
  */
 static MMAL_CLIENT_T client;
 
+/** Host-observed IPC latency histograms, one per message type, recorded
+ * around the reply wait in mmal_vc_sendwait_message. Bucket counters are
+ * updated with atomic increments since control calls can come from several
+ * threads; the max is updated without locking, which is acceptable for
+ * diagnostics. */
+static const uint32_t latency_bound_us[MMAL_VC_LATENCY_BUCKETS - 1] =
+   { 100, 500, 1000, 5000, 10000, 50000, 100000 };
+static struct
+{
+   uint32_t count[MMAL_WORKER_MSG_LAST][MMAL_VC_LATENCY_BUCKETS];
+   uint32_t max_us[MMAL_WORKER_MSG_LAST];
+   uint32_t slow_threshold_us;
+   int slow_threshold_set;
+} latency_stats;
+
+/** Record the host-observed duration of one control transaction */
+static void mmal_vc_record_latency(uint32_t msgid, uint32_t duration)
+{
+   unsigned int i;
+
+   if (msgid >= MMAL_WORKER_MSG_LAST)
+      return;
+
+   for (i = 0; i < MMAL_VC_LATENCY_BUCKETS - 1; i++)
+      if (duration < latency_bound_us[i])
+         break;
+   __sync_fetch_and_add(&latency_stats.count[msgid][i], 1);
+   if (duration > latency_stats.max_us[msgid])
+      latency_stats.max_us[msgid] = duration;
+
+   if (!latency_stats.slow_threshold_set)
+   {
+      const char *env = getenv("MMAL_VC_SLOW_MSG_US");
+      latency_stats.slow_threshold_us = env ? atoi(env) : 0;
+      latency_stats.slow_threshold_set = 1;
+   }
+   if (latency_stats.slow_threshold_us &&
+       duration >= latency_stats.slow_threshold_us)
+      LOG_ERROR("slow control call: %s took %u us",
+                mmal_msgname(msgid), duration);
+}
+
+MMAL_STATUS_T mmal_vc_msg_latency_get(uint32_t msgid, MMAL_VC_MSG_LATENCY_T *stats)
+{
+   unsigned int i;
+
+   if (msgid >= MMAL_WORKER_MSG_LAST || !stats)
+      return MMAL_EINVAL;
+
+   for (i = 0; i < MMAL_VC_LATENCY_BUCKETS; i++)
+      stats->count[i] = latency_stats.count[msgid][i];
+   for (i = 0; i < MMAL_VC_LATENCY_BUCKETS - 1; i++)
+      stats->bound_us[i] = latency_bound_us[i];
+   stats->bound_us[MMAL_VC_LATENCY_BUCKETS - 1] = 0;
+   stats->max_us = latency_stats.max_us[msgid];
+   return MMAL_SUCCESS;
+}
+
+void mmal_vc_msg_latency_threshold(uint32_t threshold_us)
+{
+   latency_stats.slow_threshold_us = threshold_us;
+   latency_stats.slow_threshold_set = 1;
+}
+
 static void init_once(void)
 {
    vcos_mutex_create(&client.lock, VCOS_FUNCTION);
@@ -97,20 +176,44 @@ static void init_once(void)
 static MMAL_STATUS_T create_waitpool(MMAL_WAITPOOL_T *waitpool)
 {
    MMAL_STATUS_T status;
+   const char *env = getenv("MMAL_VC_WAITERS");
+   int num = env ? atoi(env) : 0;
    int i;
 
-   status = vcos_semaphore_create(&waitpool->sem, VCOS_FUNCTION,
-                                  MAX_WAITERS);
+   if (num <= 0)
+      num = MAX_WAITERS;
+   if (num > MAX_WAITERS_LIMIT)
+      num = MAX_WAITERS_LIMIT;
+
+   waitpool->waiters = vcos_calloc(num, sizeof(MMAL_WAITER_T), "mmal waiters");
+   if (!waitpool->waiters)
+      return MMAL_ENOMEM;
+   waitpool->size = num;
+
+   status = vcos_semaphore_create(&waitpool->sem, VCOS_FUNCTION, num);
    if (status != MMAL_SUCCESS)
+   {
+      vcos_free(waitpool->waiters);
       return status;
+   }
+
+   if (vcos_mutex_create(&waitpool->lock, "mmal waitpool") != VCOS_SUCCESS)
+   {
+      vcos_semaphore_delete(&waitpool->sem);
+      vcos_free(waitpool->waiters);
+      return MMAL_ENOSPC;
+   }
 
-   for (i=0; i<MAX_WAITERS; i++)
+   waitpool->free_list = NULL;
+   for (i=0; i<num; i++)
    {
       waitpool->waiters[i].inuse = 0;
       status = vcos_semaphore_create(&waitpool->waiters[i].sem,
                                      "mmal waiter", 0);
       if (status != MMAL_SUCCESS)
          break;
+      waitpool->waiters[i].next = waitpool->free_list;
+      waitpool->free_list = &waitpool->waiters[i];
    }
 
    if (status != MMAL_SUCCESS)
@@ -122,18 +225,22 @@ static MMAL_STATUS_T create_waitpool(MMAL_WAITPOOL_T *waitpool)
          vcos_semaphore_delete(&waitpool->waiters[i].sem);
          i--;
       }
+      vcos_mutex_delete(&waitpool->lock);
       vcos_semaphore_delete(&waitpool->sem);
+      vcos_free(waitpool->waiters);
    }
    return status;
 }
 
 static void destroy_waitpool(MMAL_WAITPOOL_T *waitpool)
 {
-   int i;
-   for (i=0; i<MAX_WAITERS; i++)
+   unsigned i;
+   for (i=0; i<waitpool->size; i++)
       vcos_semaphore_delete(&waitpool->waiters[i].sem);
 
+   vcos_mutex_delete(&waitpool->lock);
    vcos_semaphore_delete(&waitpool->sem);
+   vcos_free(waitpool->waiters);
 }
 
 /** Grab a waiter from the pool. Return immediately if one already
@@ -141,22 +248,17 @@ static void destroy_waitpool(MMAL_WAITPOOL_T *waitpool)
   */
 static MMAL_WAITER_T *get_waiter(MMAL_CLIENT_T *client)
 {
-   int i;
-   MMAL_WAITER_T *waiter = NULL;
+   MMAL_WAITER_T *waiter;
    vcos_semaphore_wait(&client->waitpool.sem);
-   vcos_mutex_lock(&client->lock);
-   for (i=0; i<MAX_WAITERS; i++)
-   {
-      if (client->waitpool.waiters[i].inuse == 0)
-         break;
-   }
+   vcos_mutex_lock(&client->waitpool.lock);
+   waiter = client->waitpool.free_list;
    /* If this fails, the semaphore is not working */
-   if (vcos_verify(i != MAX_WAITERS))
+   if (vcos_verify(waiter))
    {
-      waiter = client->waitpool.waiters+i;
+      client->waitpool.free_list = waiter->next;
       waiter->inuse = 1;
    }
-   vcos_mutex_unlock(&client->lock);
+   vcos_mutex_unlock(&client->waitpool.lock);
 
    return waiter;
 }
@@ -169,6 +271,10 @@ static void release_waiter(MMAL_CLIENT_T *client, MMAL_WAITER_T *waiter)
    vcos_assert(waiter);
    vcos_assert(waiter->inuse);
    waiter->inuse = 0;
+   vcos_mutex_lock(&client->waitpool.lock);
+   waiter->next = client->waitpool.free_list;
+   client->waitpool.free_list = waiter;
+   vcos_mutex_unlock(&client->waitpool.lock);
    vcos_semaphore_post(&client->waitpool.sem);
 }
 
@@ -229,6 +335,10 @@ static void mmal_vc_handle_event_msg(VCHIQ_HEADER_T *vchiq_header,
    }
    buffer->length = msg->length;
 
+   /* The event pool can grow on demand, in which case the buffer we just got
+    * might not have been stamped with our client context yet */
+   mmal_vc_event_buffer_prepare(port, buffer);
+
    /* Sanity check that the event buffers have the proper vc client context */
    if (!vcos_verify(mmal_buffer_header_driver_data(buffer)->magic == MMAL_MAGIC &&
           mmal_buffer_header_driver_data(buffer)->client_context &&
@@ -427,6 +537,7 @@ static VCHIQ_STATUS_T mmal_vc_vchiq_callback(VCHIQ_REASON_T reason,
             waiter->destlen = len;
             LOG_TRACE("copying payload @%p to %p len %d", waiter->dest, msg, len);
             memcpy(waiter->dest, msg, len);
+            VCOS_PROBE3(mmal_vc, msg_complete, msg, msg->msgid, len);
             vchiq_release_message(service, vchiq_header);
             vcos_semaphore_post(&waiter->sem);
          }
@@ -510,27 +621,37 @@ static VCHIQ_STATUS_T mmal_vc_vchiq_callback(VCHIQ_REASON_T reason,
 }
 
 /** Send a message and wait for a reply.
+  *
+  * The message is queued as two scatter elements, header then optional
+  * payload, so callers with out of line payloads don't have to assemble
+  * them into one contiguous buffer first.
   *
   * @param client       client to send message for
   * @param msg_header   message vchiq_header to send
   * @param size         length of message, including header
+  * @param payload      data to append to the message, can be NULL
+  * @param payload_size length of payload
   * @param msgid        message id
   * @param dest         destination for reply
   * @param destlen      size of destination, updated with actual length
   * @param send_dummy_bulk whether to send a dummy bulk transfer
   */
-MMAL_STATUS_T mmal_vc_sendwait_message(struct MMAL_CLIENT_T *client,
-                                       mmal_worker_msg_header *msg_header,
-                                       size_t size,
-                                       uint32_t msgid,
-                                       void *dest,
-                                       size_t *destlen,
-                                       MMAL_BOOL_T send_dummy_bulk)
+static MMAL_STATUS_T mmal_vc_sendwait_internal(struct MMAL_CLIENT_T *client,
+                                               mmal_worker_msg_header *msg_header,
+                                               size_t size,
+                                               const void *payload,
+                                               size_t payload_size,
+                                               uint32_t msgid,
+                                               void *dest,
+                                               size_t *destlen,
+                                               MMAL_BOOL_T send_dummy_bulk)
 {
    MMAL_STATUS_T ret;
    MMAL_WAITER_T *waiter;
    VCHIQ_STATUS_T vst;
-   VCHIQ_ELEMENT_T elems[] = {{msg_header, size}};
+   VCHIQ_ELEMENT_T elems[2] = {{msg_header, size}, {payload, payload_size}};
+   int elem_count = payload_size ? 2 : 1;
+   unsigned int send_time;
 
    vcos_assert(size >= sizeof(mmal_worker_msg_header));
    vcos_assert(dest);
@@ -554,7 +675,9 @@ MMAL_STATUS_T mmal_vc_sendwait_message(struct MMAL_CLIENT_T *client,
    LOG_TRACE("wait %p, reply to %p", waiter, dest);
    mmal_vc_use_internal(client);
 
-   vst = vchiq_queue_message(client->service, elems, 1);
+   send_time = vcos_getmicrosecs();
+   VCOS_PROBE3(mmal_vc, msg_send, msg_header, msgid, size);
+   vst = vchiq_queue_message(client->service, elems, elem_count);
 
    if (vst != VCHIQ_SUCCESS)
    {
@@ -592,6 +715,8 @@ MMAL_STATUS_T mmal_vc_sendwait_message(struct MMAL_CLIENT_T *client,
    /* coverity[lock] This semaphore isn't being used as a mutex */
    vcos_semaphore_wait(&waiter->sem);
 
+   mmal_vc_record_latency(msgid, vcos_getmicrosecs() - send_time);
+
    mmal_vc_release_internal(client);
    LOG_TRACE("got reply (len %i/%i)", (int)*destlen, (int)waiter->destlen);
    *destlen = waiter->destlen;
@@ -606,6 +731,31 @@ fail_msg:
    return ret;
 }
 
+MMAL_STATUS_T mmal_vc_sendwait_message(struct MMAL_CLIENT_T *client,
+                                       mmal_worker_msg_header *msg_header,
+                                       size_t size,
+                                       uint32_t msgid,
+                                       void *dest,
+                                       size_t *destlen,
+                                       MMAL_BOOL_T send_dummy_bulk)
+{
+   return mmal_vc_sendwait_internal(client, msg_header, size, NULL, 0,
+                                    msgid, dest, destlen, send_dummy_bulk);
+}
+
+MMAL_STATUS_T mmal_vc_sendwait_message_v(struct MMAL_CLIENT_T *client,
+                                         mmal_worker_msg_header *msg_header,
+                                         size_t size,
+                                         const void *payload,
+                                         size_t payload_size,
+                                         uint32_t msgid,
+                                         void *dest,
+                                         size_t *destlen)
+{
+   return mmal_vc_sendwait_internal(client, msg_header, size, payload, payload_size,
+                                    msgid, dest, destlen, MMAL_FALSE);
+}
+
 /** Send a message and do not wait for a reply.
   *
   * @note
@@ -641,6 +791,7 @@ MMAL_STATUS_T mmal_vc_send_message(MMAL_CLIENT_T *client,
    msg_header->msgid  = msgid;
    msg_header->magic  = MMAL_MAGIC;
 
+   VCOS_PROBE3(mmal_vc, msg_send, msg_header, msgid, size);
    vst = vchiq_queue_message(client->service, elems, 1);
 
    if (vst != VCHIQ_SUCCESS)
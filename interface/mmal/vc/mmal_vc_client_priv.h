@@ -63,6 +63,10 @@ typedef struct MMAL_VC_CLIENT_BUFFER_CONTEXT_T
 
 MMAL_CLIENT_T *mmal_vc_get_client(void);
 
+/** Associate the vc client context with an event buffer which was added to the
+ * event pool after the pool was stamped at port enable time. */
+void mmal_vc_event_buffer_prepare(MMAL_PORT_T *port, MMAL_BUFFER_HEADER_T *buffer);
+
 MMAL_STATUS_T mmal_vc_sendwait_message(MMAL_CLIENT_T *client,
                                        mmal_worker_msg_header *header,
                                        size_t size,
@@ -71,6 +75,19 @@ MMAL_STATUS_T mmal_vc_sendwait_message(MMAL_CLIENT_T *client,
                                        size_t *destlen,
                                        MMAL_BOOL_T send_dummy_bulk);
 
+/** Variant of @ref mmal_vc_sendwait_message which sends the message as two
+ * scatter elements, header followed by payload, saving the caller from
+ * assembling them into one contiguous buffer. The bytes on the wire are
+ * identical to a contiguous send of size + payload_size. */
+MMAL_STATUS_T mmal_vc_sendwait_message_v(MMAL_CLIENT_T *client,
+                                         mmal_worker_msg_header *header,
+                                         size_t size,
+                                         const void *payload,
+                                         size_t payload_size,
+                                         uint32_t msgid,
+                                         void *dest,
+                                         size_t *destlen);
+
 MMAL_STATUS_T mmal_vc_send_message(MMAL_CLIENT_T *client,
                                    mmal_worker_msg_header *header, size_t size,
                                    uint8_t *data, size_t data_size,
@@ -57,6 +57,7 @@ struct cmd {
 
 static int do_commands(int argc, const char **argv);
 static int do_version(int argc, const char **argv);
+static int do_latency(int argc, const char **argv);
 static int do_stats(int argc, const char **argv);
 static int do_usage(int argc, const char **argv);
 static int do_create(int argc, const char **argv);
@@ -73,6 +74,7 @@ static int do_host_log_write(int argc, const char **argv);
 static struct cmd cmds[] = {
    { "help",       do_usage, "give this help", 0 },
    { "version",    do_version, "report VC MMAL server version number", CONNECT },
+   { "latency",    do_latency, "[iterations] measure host-observed IPC latency", CONNECT },
    { "stats",      do_stats, "report VC MMAL statistics", CONNECT },
    { "reset",      do_stats, "reset VC MMAL statistics", CONNECT },
    { "commands",   do_commands, "list available commands", CONNECT },
@@ -179,6 +181,50 @@ static int do_version(int argc, const char **argv)
    }
 }
 
+static int do_latency(int argc, const char **argv)
+{
+   MMAL_VC_MSG_LATENCY_T stats;
+   unsigned int i, iterations = 1000;
+   uint32_t msgid;
+
+   if (argc > 1)
+      iterations = atoi(argv[1]);
+
+   /* Generate a burst of trivial control transactions so there is something
+    * to report even on an otherwise idle connection */
+   for (i = 0; i < iterations; i++)
+   {
+      uint32_t maj, min, minimum;
+      MMAL_STATUS_T st = mmal_vc_get_version(&maj, &min, &minimum);
+      if (st != MMAL_SUCCESS)
+      {
+         fprintf(stderr, "error getting version (%i:%s)\n", st, mmal_status_to_string(st));
+         return -1;
+      }
+   }
+
+   for (msgid = 0; mmal_vc_msg_latency_get(msgid, &stats) == MMAL_SUCCESS; msgid++)
+   {
+      uint64_t total = 0;
+
+      for (i = 0; i < MMAL_VC_LATENCY_BUCKETS; i++)
+         total += stats.count[i];
+      if (!total)
+         continue;
+
+      printf("%s: %u calls, slowest %u us\n",
+             mmal_msgname(msgid), (unsigned int)total, stats.max_us);
+      for (i = 0; i < MMAL_VC_LATENCY_BUCKETS; i++)
+      {
+         if (stats.bound_us[i])
+            printf("   < %6u us: %u\n", stats.bound_us[i], stats.count[i]);
+         else
+            printf("  >= %6u us: %u\n", stats.bound_us[i - 1], stats.count[i]);
+      }
+   }
+   return 0;
+}
+
 #define STATS_FIELD(x) { #x, offsetof(MMAL_VC_STATS_T, x) }
 
 static struct {
@@ -42,6 +42,7 @@ typedef struct MMAL_VC_PAYLOAD_ELEM_T
    void *handle;
    void *vc_handle;
    uint8_t *mem;
+   MMAL_BOOL_T imported; /**< handle is owned by the client, not by us */
    MMAL_BOOL_T in_use;
 } MMAL_VC_PAYLOAD_ELEM_T;
 
@@ -82,6 +83,7 @@ static void mmal_vc_payload_list_release(MMAL_VC_PAYLOAD_ELEM_T *elem)
    vcos_mutex_lock(&mmal_vc_payload_list.lock);
    elem->handle = elem->vc_handle = 0;
    elem->mem = 0;
+   elem->imported = 0;
    elem->in_use = 0;
    vcos_mutex_unlock(&mmal_vc_payload_list.lock);
 }
@@ -186,6 +188,58 @@ uint8_t *mmal_vc_shm_alloc(uint32_t size)
    return mem;
 }
 
+/** Import a shared memory buffer allocated by the client */
+uint8_t *mmal_vc_shm_import(uint32_t vcsm_handle)
+{
+#ifdef ENABLE_MMAL_VCSM
+   MMAL_VC_PAYLOAD_ELEM_T *payload_elem;
+   unsigned int vc_handle;
+   uint8_t *mem;
+
+   payload_elem = mmal_vc_payload_list_get();
+   if (!payload_elem)
+   {
+      LOG_ERROR("could not get a free slot in the payload list");
+      return NULL;
+   }
+
+   vc_handle = vcsm_vc_hdl_from_hdl(vcsm_handle);
+   mem = (uint8_t *)vcsm_lock(vcsm_handle);
+   if (!mem || !vc_handle)
+   {
+      LOG_ERROR("could not import shared memory handle %x", vcsm_handle);
+      if (mem)
+         vcsm_unlock_hdl(vcsm_handle);
+      mmal_vc_payload_list_release(payload_elem);
+      return NULL;
+   }
+
+   /* The memory area is automatically mem-locked by vcsm's fault
+    * handler when it is next used. So leave it unlocked until it
+    * is needed.
+    */
+   vcsm_unlock_hdl(vcsm_handle);
+
+   payload_elem->mem = mem;
+   payload_elem->handle = (void *)vcsm_handle;
+   payload_elem->vc_handle = (void *)vc_handle;
+   payload_elem->imported = MMAL_TRUE;
+   return mem;
+#else /* ENABLE_MMAL_VCSM */
+   MMAL_PARAM_UNUSED(vcsm_handle);
+   return NULL;
+#endif /* ENABLE_MMAL_VCSM */
+}
+
+/** Export the shared memory handle backing a buffer */
+uint32_t mmal_vc_shm_export(uint8_t *mem)
+{
+   MMAL_VC_PAYLOAD_ELEM_T *payload_elem = mmal_vc_payload_list_find_mem(mem);
+   if (!payload_elem)
+      return 0;
+   return (uint32_t)(uintptr_t)payload_elem->handle;
+}
+
 /** Free a shared memory buffer */
 MMAL_STATUS_T mmal_vc_shm_free(uint8_t *mem)
 {
@@ -193,7 +247,9 @@ MMAL_STATUS_T mmal_vc_shm_free(uint8_t *mem)
    if (payload_elem)
    {
 #ifdef ENABLE_MMAL_VCSM
-      vcsm_free((unsigned int)payload_elem->handle);
+      /* Imported handles stay with their owner */
+      if (!payload_elem->imported)
+         vcsm_free((unsigned int)payload_elem->handle);
 #endif /* ENABLE_MMAL_VCSM */
       mmal_vc_payload_list_release(payload_elem);
       return MMAL_SUCCESS;
@@ -45,7 +45,26 @@ MMAL_STATUS_T mmal_vc_shm_init(void);
 /** Allocate a shared memory buffer */
 uint8_t *mmal_vc_shm_alloc(uint32_t size);
 
-/** Free a shared memory buffer */
+/** Import a shared memory buffer allocated by the client.
+ * The memory is tracked like one of our own allocations so it can be used
+ * as a zero copy payload, but ownership of the handle stays with the client.
+ *
+ * @param vcsm_handle Handle (from the vcsm allocator) of the memory to import.
+ * @return Pointer to the mapped memory (or NULL on failure).
+ */
+uint8_t *mmal_vc_shm_import(uint32_t vcsm_handle);
+
+/** Export the shared memory handle backing a buffer.
+ *
+ * @param mem Pointer to the shared memory buffer.
+ * @return Handle (from the vcsm allocator) backing the memory,
+ * or 0 if the memory is not shared memory we track.
+ */
+uint32_t mmal_vc_shm_export(uint8_t *mem);
+
+/** Free a shared memory buffer.
+ * For imported buffers this only stops tracking the memory; the underlying
+ * handle is left for its owner to free. */
 MMAL_STATUS_T mmal_vc_shm_free(uint8_t *mem);
 
 /** Lock a shared memory buffer */
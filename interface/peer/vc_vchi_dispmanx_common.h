@@ -78,6 +78,7 @@ typedef enum  {
    EDispmanSnapshot,
    EDispmanSetPalette,
    EDispmanVsyncCallback,
+   EDispmanSnapshotRegion,
 
    EDispmanMaxFunction
 } DISPMANX_COMMAND_T;
@@ -375,10 +375,28 @@ static int buttons_poll_keypad(buttons_t *buttons,
                     uint32_t *keys_released );
 
 
+/* Messages are split into two rings so that floods of bulk traffic
+ * (touchscreen coordinate events) cannot head-of-line block the much rarer
+ * control messages (buttons, timers, host requests).  The dispatcher always
+ * drains the control ring first. */
 static PLT_msg message_q[256];
 static int start_p = 0, end_p = 0;
+static PLT_msg control_q[64];
+static int control_start_p = 0, control_end_p = 0;
 static VCOS_MUTEX_T msg_latch;
 static VCOS_SEMAPHORE_T msg_semaphore;
+
+/* Hash-indexed handler table.  Handlers registered here are called directly
+ * by the dispatcher; anything else falls back to the application's
+ * host_app_message_handler switch. */
+#define MSG_HANDLER_SLOTS 32  /*< power of two, larger than PLATFORM_MSG_USER */
+
+typedef struct {
+  long msg;
+  message_handler_fn *handler;
+} msg_handler_slot_t;
+
+static msg_handler_slot_t msg_handlers[MSG_HANDLER_SLOTS];
 #ifndef WIN32
 static VCOS_THREAD_T button_thread, touch_thread;
 #endif
@@ -1085,18 +1103,86 @@ message_queue_init ()
 #endif
 }
 
+/* Knuth multiplicative hash, folded into the table size */
+static TS_INLINE unsigned
+msg_handler_hash (long msg)
+{
+  return ((unsigned long)msg * 2654435761u) & (MSG_HANDLER_SLOTS - 1);
+}
+
+/* Look a message type up in the handler table.  Open addressing with linear
+ * probing; an empty slot ends the probe chain, so unregistered messages cost
+ * one or two reads. */
+static TS_INLINE message_handler_fn *
+msg_handler_lookup (long msg)
+{
+  unsigned slot = msg_handler_hash (msg);
+  unsigned probes;
+  for (probes = 0; probes < MSG_HANDLER_SLOTS; probes++)
+    {
+      if (msg_handlers[slot].handler == NULL)
+        return NULL;
+      if (msg_handlers[slot].msg == msg)
+        return msg_handlers[slot].handler;
+      slot = (slot + 1) & (MSG_HANDLER_SLOTS - 1);
+    }
+  return NULL;
+}
+
+int
+message_handler_register (long msg, message_handler_fn *handler)
+{
+  unsigned slot = msg_handler_hash (msg);
+  unsigned probes;
+  int rc = -1;
+
+  vcos_mutex_lock (&msg_latch);
+  for (probes = 0; probes < MSG_HANDLER_SLOTS; probes++)
+    {
+      if (msg_handlers[slot].handler == NULL ||
+          msg_handlers[slot].msg == msg)
+        {
+          msg_handlers[slot].msg = msg;
+          msg_handlers[slot].handler = handler;
+          rc = 0;
+          break;
+        }
+      slot = (slot + 1) & (MSG_HANDLER_SLOTS - 1);
+    }
+  vcos_mutex_unlock (&msg_latch);
+
+  vcos_assert (rc == 0);  /* Handler table full! */
+  return rc;
+}
+
 void
 add_message (long msg, long param1, long param2)
 {
   vcos_mutex_lock (&msg_latch);
-  int i = end_p + 1;
-  vcos_assert (i != start_p);  /* Overlapping messages! */
-  if (i == countof(message_q))
-    i = 0;
-  message_q[i].msg = msg;
-  message_q[i].param1 = param1;
-  message_q[i].param2 = param2;
-  end_p = i;
+  if (msg == PLATFORM_MSG_TOUCHSCREEN_EVENT)
+    {
+      /* Bulk traffic - touchscreen coordinate floods go in the big ring */
+      int i = end_p + 1;
+      vcos_assert (i != start_p);  /* Overlapping messages! */
+      if (i == countof(message_q))
+        i = 0;
+      message_q[i].msg = msg;
+      message_q[i].param1 = param1;
+      message_q[i].param2 = param2;
+      end_p = i;
+    }
+  else
+    {
+      /* Control traffic - dispatched ahead of anything in the bulk ring */
+      int i = control_end_p + 1;
+      vcos_assert (i != control_start_p);  /* Overlapping messages! */
+      if (i == countof(control_q))
+        i = 0;
+      control_q[i].msg = msg;
+      control_q[i].param1 = param1;
+      control_q[i].param2 = param2;
+      control_end_p = i;
+    }
   vcos_mutex_unlock (&msg_latch);
   vcos_semaphore_post(&msg_semaphore);
 }
@@ -1106,18 +1192,38 @@ dispatch_messages ()
 {
   while (1)
     {
+      PLT_msg msg;
+      message_handler_fn *handler;
+
       vcos_semaphore_wait(&msg_semaphore);
       vcos_mutex_lock (&msg_latch);
-      vcos_assert(start_p != end_p);
-      start_p++;
-      if (start_p == countof(message_q))
-        start_p = 0;
+      /* Copy the message out while the latch is held - a producer may wrap
+         and reuse the slot as soon as it is released.  Control messages jump
+         the queue ahead of bulk traffic. */
+      if (control_start_p != control_end_p)
+        {
+          control_start_p++;
+          if (control_start_p == countof(control_q))
+            control_start_p = 0;
+          msg = control_q[control_start_p];
+        }
+      else
+        {
+          vcos_assert(start_p != end_p);
+          start_p++;
+          if (start_p == countof(message_q))
+            start_p = 0;
+          msg = message_q[start_p];
+        }
+      handler = msg_handler_lookup (msg.msg);
       vcos_mutex_unlock (&msg_latch);
 
-      /* Call the handler routine */
-      host_app_message_handler (message_q[start_p].msg,
-                                message_q[start_p].param1,
-                                message_q[start_p].param2);
+      /* Call the handler routine.  Messages with a registered handler are
+         routed directly; the rest fall back to the application's switch. */
+      if (handler)
+        handler (msg.msg, msg.param1, msg.param2);
+      else
+        host_app_message_handler (msg.msg, msg.param1, msg.param2);
     }
 }
 
@@ -50,4 +50,27 @@ add_message (long msg, long param1, long param2);
 void
 dispatch_messages (void);
 
+/**
+  * Type of a message handler registered with message_handler_register.
+  *
+  * @param msg     Type of the message.
+  * @param param1  The first parameter.
+  * @param param2  The second parameter.
+  */
+typedef void message_handler_fn (long msg, long param1, long param2);
+
+/**
+  * Register a handler for one message type.  Messages of that type are then
+  * routed directly to the handler by dispatch_messages instead of going
+  * through host_app_message_handler.  Registering again for the same type
+  * replaces the previous handler.  Call after message_queue_init.
+  *
+  * @param msg      Type of the message.
+  * @param handler  The handler to call for messages of that type.
+  *
+  * @return 0 on success, -1 if the handler table is full.
+  */
+int
+message_handler_register (long msg, message_handler_fn *handler);
+
 #endif /* _MESSAGE_DISPATCH_H */
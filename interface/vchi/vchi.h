@@ -351,6 +351,15 @@ extern int32_t vchi_bulk_queue_transmit( VCHI_SERVICE_HANDLE_T handle,
                                          VCHI_FLAGS_T flags,
                                          void *transfer_handle );
 
+// Scatter-gather version of vchi_bulk_queue_transmit - the vector elements
+// are gathered in order into a single bulk transfer, avoiding a staging copy
+// for data (e.g. multi-plane images) that is not contiguous in memory
+extern int32_t vchi_bulk_queue_transmitv( VCHI_SERVICE_HANDLE_T handle,
+                                          VCHI_MSG_VECTOR_T *vector,
+                                          uint32_t count,
+                                          VCHI_FLAGS_T flags,
+                                          void *transfer_handle );
+
 
 /******************************************************************************
  Configuration plumbing
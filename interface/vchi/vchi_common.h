@@ -114,6 +114,10 @@ typedef enum
    VCHI_SERVICE_OPTION_TRACE,
    VCHI_SERVICE_OPTION_SYNCHRONOUS,
 
+   // Deliver a single MSG_AVAILABLE callback per burst of messages instead
+   // of one per message; the callback should then dequeue until empty
+   VCHI_SERVICE_OPTION_COALESCE_CALLBACKS,
+
    VCHI_SERVICE_OPTION_MAX
 } VCHI_SERVICE_OPTION_T;
 
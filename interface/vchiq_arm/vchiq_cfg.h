@@ -44,6 +44,12 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 /* The version that made it safe to use SYNCHRONOUS mode */
 #define VCHIQ_VERSION_SYNCHRONOUS_MODE 8
 
+/* The version that introduced the VCHIQ_IOC_REGISTER_MEMORY ioctls */
+#define VCHIQ_VERSION_REGISTER_MEMORY 9
+
+/* The version that introduced the VCHIQ_IOC_QUEUE_BULK_TRANSMIT_V ioctl */
+#define VCHIQ_VERSION_BULK_TRANSMIT_VECTORED 9
+
 #define VCHIQ_MAX_STATES         2
 #define VCHIQ_MAX_SERVICES       4096
 #define VCHIQ_MAX_SLOTS          128
@@ -169,6 +169,10 @@ extern VCHIQ_STATUS_T vchiq_bulk_transmit_handle(VCHIQ_SERVICE_HANDLE_T service,
 extern VCHIQ_STATUS_T vchiq_bulk_receive_handle(VCHIQ_SERVICE_HANDLE_T service,
    VCHI_MEM_HANDLE_T handle, void *offset, int size, void *userdata,
    VCHIQ_BULK_MODE_T mode, int (*copy_pagelist)());
+extern VCHIQ_STATUS_T vchiq_bulk_register_memory(VCHIQ_SERVICE_HANDLE_T service,
+   void *base, int size, VCHI_MEM_HANDLE_T *memhandle);
+extern VCHIQ_STATUS_T vchiq_bulk_unregister_memory(VCHIQ_SERVICE_HANDLE_T service,
+   VCHI_MEM_HANDLE_T memhandle);
 extern int   vchiq_get_client_id(VCHIQ_SERVICE_HANDLE_T service);
 extern void *vchiq_get_service_userdata(VCHIQ_SERVICE_HANDLE_T service);
 extern int   vchiq_get_service_fourcc(VCHIQ_SERVICE_HANDLE_T service);
@@ -93,6 +93,30 @@ typedef struct {
    size_t    num_bytes;
 } VCHIQ_DUMP_MEM_T;
 
+typedef struct {
+   unsigned int handle;       /* service handle */
+   void *data;                /* start of the region to register */
+   unsigned int size;         /* size of the region in bytes */
+   unsigned int memhandle;    /* OUT (never 0, which is VCHI_MEM_HANDLE_INVALID) */
+} VCHIQ_REGISTER_MEMORY_T;
+
+typedef struct {
+   unsigned int handle;
+   unsigned int memhandle;    /* region returned by VCHIQ_IOC_REGISTER_MEMORY */
+   unsigned int offset;       /* offset into the registered region */
+   unsigned int size;
+   void *userdata;
+   VCHIQ_BULK_MODE_T mode;
+} VCHIQ_QUEUE_BULK_TRANSFER_MH_T;
+
+typedef struct {
+   unsigned int handle;
+   const VCHIQ_ELEMENT_T *elements; /* gathered in order into a single transfer */
+   unsigned int count;
+   void *userdata;
+   VCHIQ_BULK_MODE_T mode;
+} VCHIQ_QUEUE_BULK_TRANSFER_V_T;
+
 #define VCHIQ_IOC_CONNECT              _IO(VCHIQ_IOC_MAGIC,   0)
 #define VCHIQ_IOC_SHUTDOWN             _IO(VCHIQ_IOC_MAGIC,   1)
 #define VCHIQ_IOC_CREATE_SERVICE       _IOWR(VCHIQ_IOC_MAGIC, 2, VCHIQ_CREATE_SERVICE_T)
@@ -111,6 +135,11 @@ typedef struct {
 #define VCHIQ_IOC_DUMP_PHYS_MEM        _IOW(VCHIQ_IOC_MAGIC,  15, VCHIQ_DUMP_MEM_T)
 #define VCHIQ_IOC_LIB_VERSION          _IO(VCHIQ_IOC_MAGIC,   16)
 #define VCHIQ_IOC_CLOSE_DELIVERED      _IO(VCHIQ_IOC_MAGIC,   17)
-#define VCHIQ_IOC_MAX                  17
+#define VCHIQ_IOC_REGISTER_MEMORY      _IOWR(VCHIQ_IOC_MAGIC, 18, VCHIQ_REGISTER_MEMORY_T)
+#define VCHIQ_IOC_UNREGISTER_MEMORY    _IO(VCHIQ_IOC_MAGIC,   19)
+#define VCHIQ_IOC_QUEUE_BULK_TRANSMIT_MH _IOWR(VCHIQ_IOC_MAGIC, 20, VCHIQ_QUEUE_BULK_TRANSFER_MH_T)
+#define VCHIQ_IOC_QUEUE_BULK_RECEIVE_MH  _IOWR(VCHIQ_IOC_MAGIC, 21, VCHIQ_QUEUE_BULK_TRANSFER_MH_T)
+#define VCHIQ_IOC_QUEUE_BULK_TRANSMIT_V  _IOWR(VCHIQ_IOC_MAGIC, 22, VCHIQ_QUEUE_BULK_TRANSFER_V_T)
+#define VCHIQ_IOC_MAX                  22
 
 #endif
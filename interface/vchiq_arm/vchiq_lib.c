@@ -29,6 +29,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <fcntl.h>
 #include <sys/ioctl.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 #include "vchiq.h"
 #include "vchiq_cfg.h"
@@ -36,11 +37,26 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "interface/vchi/vchi.h"
 #include "interface/vchi/common/endian.h"
 #include "interface/vcos/vcos.h"
+#include "interface/vcos/vcos_usdt.h"
 
 #define IS_POWER_2(x) ((x & (x - 1)) == 0)
+
+/* Process-wide counters on the shared vcos telemetry page, registered
+ * lazily so processes which never touch vchiq don't map the page */
+static volatile uint32_t *telemetry_msgs_queued;
+static volatile uint32_t *telemetry_bulks_queued;
 #define VCHIQ_MAX_INSTANCE_SERVICES 32
 #define MSGBUF_SIZE (VCHIQ_MAX_MSG_SIZE + sizeof(VCHIQ_HEADER_T))
 
+/* Number of completions drained from the driver in one ioctl */
+#define VCHIQ_COMPLETION_BATCH_SIZE 64
+
+/* Optional pool of threads dispatching completion callbacks, sized with the
+ * VCHIQ_COMPLETION_WORKERS environment variable (0, the default, dispatches
+ * from the completion thread as before) */
+#define VCHIQ_COMPLETION_WORKERS_MAX 4
+#define VCHIQ_WORKER_QUEUE_SIZE 64
+
 #define RETRY(r,x) do { r = x; } while ((r == -1) && (errno == EINTR))
 
 #define VCOS_LOG_CATEGORY (&vchiq_lib_log_category)
@@ -56,20 +72,42 @@ typedef struct vchiq_service_struct
    int peek_size;
    int client_id;
    char is_client;
+   char in_use;   /* Slot ownership, guarded by the instance mutex */
+   char coalesce; /* Coalesce MSG_AVAILABLE callbacks into one per burst */
+   volatile int msg_doorbell; /* Set once a coalesced callback is in flight */
 } VCHIQ_SERVICE_T;
 
 typedef struct vchiq_service_struct VCHI_SERVICE_T;
 
+/* A worker thread and its queue of pending completions. The queue has a
+ * single producer (the completion thread) and a single consumer (the worker)
+ * so the 2 counting semaphores are all the synchronisation it needs. */
+typedef struct vchiq_completion_worker_struct
+{
+   struct vchiq_instance_struct *instance;
+   VCOS_THREAD_T thread;
+   VCOS_SEMAPHORE_T space;    /* counts free slots in the queue */
+   VCOS_SEMAPHORE_T work;     /* counts pending completions */
+   unsigned int insert;
+   unsigned int remove;
+   int stop;
+   VCHIQ_COMPLETION_DATA_T queue[VCHIQ_WORKER_QUEUE_SIZE];
+} VCHIQ_COMPLETION_WORKER_T;
+
 struct vchiq_instance_struct
 {
    int fd;
    int initialised;
    int connected;
    int use_close_delivered;
+   int use_register_memory;
+   int use_vectored_bulk;
    VCOS_THREAD_T completion_thread;
    VCOS_MUTEX_T mutex;
    int used_services;
    VCHIQ_SERVICE_T services[VCHIQ_MAX_INSTANCE_SERVICES];
+   int worker_num;
+   VCHIQ_COMPLETION_WORKER_T workers[VCHIQ_COMPLETION_WORKERS_MAX];
 } vchiq_instance;
 
 typedef struct vchiq_instance_struct VCHI_STATE_T;
@@ -82,6 +120,7 @@ static void *free_msgbufs;
 static unsigned int handle_seq;
 
 vcos_static_assert(IS_POWER_2(VCHIQ_MAX_INSTANCE_SERVICES));
+vcos_static_assert(IS_POWER_2(VCHIQ_WORKER_QUEUE_SIZE));
 
 /* Local utility functions */
 static VCHIQ_INSTANCE_T
@@ -89,6 +128,15 @@ vchiq_lib_init(void);
 
 static void *completion_thread(void *);
 
+static void
+completion_cpuset_apply(VCOS_THREAD_ATTR_T *attrs);
+
+static void
+completion_workers_start(VCHIQ_INSTANCE_T instance);
+
+static void
+completion_workers_stop(VCHIQ_INSTANCE_T instance);
+
 static VCHIQ_STATUS_T
 create_service(VCHIQ_INSTANCE_T instance,
    const VCHIQ_SERVICE_PARAMS_T *params,
@@ -118,19 +166,45 @@ handle_to_service(VCHIQ_SERVICE_HANDLE_T handle)
    return &vchiq_instance.services[handle & (VCHIQ_MAX_INSTANCE_SERVICES - 1)];
 }
 
+/* Lock-free lookup. A service slot only carries a valid lib_handle once it
+ * is fully initialised (see create_service) and the handle is cleared again
+ * before the slot is torn down, so matching the handle is all the
+ * synchronisation the read path needs. Stale handles always mismatch since
+ * handle_seq never repeats a value for a slot. */
 static VCHIQ_SERVICE_T *
 find_service_by_handle(VCHIQ_SERVICE_HANDLE_T handle)
 {
    VCHIQ_SERVICE_T *service;
 
    service = handle_to_service(handle);
-   if (service && (service->lib_handle != handle))
-      service = NULL;
+   if (service && (service->lib_handle == handle))
+   {
+      /* Pairs with the barrier before the handle is published, so the
+       * service fields are visible once the handle check succeeds */
+      __sync_synchronize();
+      return service;
+   }
 
-   if (!service)
-      vcos_log_info("Invalid service handle 0x%x", handle);
+   vcos_log_info("Invalid service handle 0x%x", handle);
+
+   return NULL;
+}
+
+/* A message dequeue came back empty: re-arm the coalesced doorbell, if in
+ * use, and report whether the caller should poll the queue once more. A
+ * completion which arrived while the doorbell was already rung was swallowed,
+ * so its message can only be picked up by this re-poll or by a later
+ * completion ringing the re-armed doorbell. */
+static int
+msg_doorbell_rearm(VCHIQ_SERVICE_T *service)
+{
+   if (!service->coalesce || !service->msg_doorbell)
+      return 0;
+
+   service->msg_doorbell = 0;
+   __sync_synchronize();
 
-   return service;
+   return 1;
 }
 
 /*
@@ -172,10 +246,7 @@ vchiq_shutdown(VCHIQ_INSTANCE_T instance)
       for (i = 0; i < instance->used_services; i++)
       {
          if (instance->services[i].lib_handle != VCHIQ_SERVICE_HANDLE_INVALID)
-         {
             vchiq_remove_service(instance->services[i].lib_handle);
-            instance->services[i].lib_handle = VCHIQ_SERVICE_HANDLE_INVALID;
-         }
       }
 
       if (instance->connected)
@@ -184,6 +255,7 @@ vchiq_shutdown(VCHIQ_INSTANCE_T instance)
          RETRY(ret, ioctl(instance->fd, VCHIQ_IOC_SHUTDOWN, 0));
          vcos_assert(ret == 0);
          vcos_thread_join(&instance->completion_thread, NULL);
+         completion_workers_stop(instance);
          instance->connected = 0;
       }
 
@@ -236,10 +308,14 @@ vchiq_connect(VCHIQ_INSTANCE_T instance)
       goto out;
    }
 
+   completion_workers_start(instance);
+
    vcos_thread_attr_init(&attrs);
+   completion_cpuset_apply(&attrs);
    if (vcos_thread_create(&instance->completion_thread, "VCHIQ completion",
                           &attrs, completion_thread, instance) != VCOS_SUCCESS)
    {
+      completion_workers_stop(instance);
       status = VCHIQ_ERROR;
       goto out;
    }
@@ -326,10 +402,18 @@ vchiq_close_service(VCHIQ_SERVICE_HANDLE_T handle)
    if (!service)
       return VCHIQ_ERROR;
 
+   if (service->is_client)
+   {
+      /* Unpublish the handle before tearing the service down so that no
+       * new lookup can return a service in mid-removal */
+      service->lib_handle = VCHIQ_SERVICE_HANDLE_INVALID;
+      __sync_synchronize();
+   }
+
    RETRY(ret,ioctl(service->fd, VCHIQ_IOC_CLOSE_SERVICE, service->handle));
 
    if (service->is_client)
-      service->lib_handle = VCHIQ_SERVICE_HANDLE_INVALID;
+      service->in_use = 0;
 
    if (ret != 0)
       return VCHIQ_ERROR;
@@ -348,9 +432,14 @@ vchiq_remove_service(VCHIQ_SERVICE_HANDLE_T handle)
    if (!service)
       return VCHIQ_ERROR;
 
+   /* Unpublish the handle before tearing the service down so that no new
+    * lookup can return a service in mid-removal */
+   service->lib_handle = VCHIQ_SERVICE_HANDLE_INVALID;
+   __sync_synchronize();
+
    RETRY(ret,ioctl(service->fd, VCHIQ_IOC_REMOVE_SERVICE, service->handle));
 
-   service->lib_handle = VCHIQ_SERVICE_HANDLE_INVALID;
+   service->in_use = 0;
 
    if (ret != 0)
       return VCHIQ_ERROR;
@@ -377,6 +466,10 @@ vchiq_queue_message(VCHIQ_SERVICE_HANDLE_T handle,
    args.count = count;
    RETRY(ret, ioctl(service->fd, VCHIQ_IOC_QUEUE_MESSAGE, &args));
 
+   if (!telemetry_msgs_queued)
+      telemetry_msgs_queued = vcos_telemetry_counter("vchiq.msgs_queued");
+   vcos_telemetry_add(telemetry_msgs_queued, 1);
+
    return (ret >= 0) ? VCHIQ_SUCCESS : VCHIQ_ERROR;
 }
 
@@ -409,8 +502,13 @@ vchiq_queue_bulk_transmit(VCHIQ_SERVICE_HANDLE_T handle,
    args.size = size;
    args.userdata = userdata;
    args.mode = VCHIQ_BULK_MODE_CALLBACK;
+   VCOS_PROBE3(vchiq, bulk_transmit_start, service->lib_handle, data, size);
    RETRY(ret, ioctl(service->fd, VCHIQ_IOC_QUEUE_BULK_TRANSMIT, &args));
 
+   if (!telemetry_bulks_queued)
+      telemetry_bulks_queued = vcos_telemetry_counter("vchiq.bulks_queued");
+   vcos_telemetry_add(telemetry_bulks_queued, 1);
+
    return (ret >= 0) ? VCHIQ_SUCCESS : VCHIQ_ERROR;
 }
 
@@ -434,8 +532,13 @@ vchiq_queue_bulk_receive(VCHIQ_SERVICE_HANDLE_T handle,
    args.size = size;
    args.userdata = userdata;
    args.mode = VCHIQ_BULK_MODE_CALLBACK;
+   VCOS_PROBE3(vchiq, bulk_receive_start, service->lib_handle, data, size);
    RETRY(ret, ioctl(service->fd, VCHIQ_IOC_QUEUE_BULK_RECEIVE, &args));
 
+   if (!telemetry_bulks_queued)
+      telemetry_bulks_queued = vcos_telemetry_counter("vchiq.bulks_queued");
+   vcos_telemetry_add(telemetry_bulks_queued, 1);
+
    return (ret >= 0) ? VCHIQ_SUCCESS : VCHIQ_ERROR;
 }
 
@@ -446,11 +549,13 @@ vchiq_queue_bulk_transmit_handle(VCHIQ_SERVICE_HANDLE_T handle,
    int size,
    void *userdata)
 {
-   vcos_assert(memhandle == VCHI_MEM_HANDLE_INVALID);
-
    vcos_log_trace( "%s called service handle = 0x%08x", __func__, (uint32_t)handle );
 
-   return vchiq_queue_bulk_transmit(handle, offset, size, userdata);
+   if (memhandle == VCHI_MEM_HANDLE_INVALID)
+      return vchiq_queue_bulk_transmit(handle, offset, size, userdata);
+
+   return vchiq_bulk_transmit_handle(handle, memhandle, offset, size, userdata,
+      VCHIQ_BULK_MODE_CALLBACK);
 }
 
 VCHIQ_STATUS_T
@@ -460,11 +565,13 @@ vchiq_queue_bulk_receive_handle(VCHIQ_SERVICE_HANDLE_T handle,
    int size,
    void *userdata)
 {
-   vcos_assert(memhandle == VCHI_MEM_HANDLE_INVALID);
-
    vcos_log_trace( "%s called service handle = 0x%08x", __func__, (uint32_t)handle );
 
-   return vchiq_queue_bulk_receive(handle, offset, size, userdata);
+   if (memhandle == VCHI_MEM_HANDLE_INVALID)
+      return vchiq_queue_bulk_receive(handle, offset, size, userdata);
+
+   return vchiq_bulk_receive_handle(handle, memhandle, offset, size, userdata,
+      VCHIQ_BULK_MODE_CALLBACK, NULL);
 }
 
 VCHIQ_STATUS_T
@@ -511,9 +618,31 @@ vchiq_bulk_transmit_handle(VCHIQ_SERVICE_HANDLE_T handle,
    void *userdata,
    VCHIQ_BULK_MODE_T mode)
 {
-   vcos_assert(memhandle == VCHI_MEM_HANDLE_INVALID);
+   VCHIQ_SERVICE_T *service;
+   VCHIQ_QUEUE_BULK_TRANSFER_MH_T args;
+   int ret;
 
-   return vchiq_bulk_transmit(handle, offset, size, userdata, mode);
+   if (memhandle == VCHI_MEM_HANDLE_INVALID)
+      return vchiq_bulk_transmit(handle, offset, size, userdata, mode);
+
+   service = find_service_by_handle(handle);
+
+   vcos_log_trace( "%s called service handle = 0x%08x", __func__, (uint32_t)handle );
+
+   if (!service)
+      return VCHIQ_ERROR;
+
+   /* The region is already pinned so the transfer just references it by
+    * handle and offset */
+   args.handle = service->handle;
+   args.memhandle = (unsigned int)memhandle;
+   args.offset = (unsigned int)(uintptr_t)offset;
+   args.size = size;
+   args.userdata = userdata;
+   args.mode = mode;
+   RETRY(ret, ioctl(service->fd, VCHIQ_IOC_QUEUE_BULK_TRANSMIT_MH, &args));
+
+   return (ret >= 0) ? VCHIQ_SUCCESS : VCHIQ_ERROR;
 }
 
 VCHIQ_STATUS_T
@@ -527,15 +656,29 @@ vchiq_bulk_receive_handle(VCHIQ_SERVICE_HANDLE_T handle,
 {
    VCHIQ_SERVICE_T *service = find_service_by_handle(handle);
    VCHIQ_QUEUE_BULK_TRANSFER_T args;
+   VCHIQ_QUEUE_BULK_TRANSFER_MH_T args_mh;
    int ret;
 
-   vcos_assert(memhandle == VCHI_MEM_HANDLE_INVALID);
-
    vcos_log_trace( "%s called service handle = 0x%08x", __func__, (uint32_t)handle );
 
    if (!service)
       return VCHIQ_ERROR;
 
+   if (memhandle != VCHI_MEM_HANDLE_INVALID)
+   {
+      /* The region is already pinned so the transfer just references it by
+       * handle and offset */
+      args_mh.handle = service->handle;
+      args_mh.memhandle = (unsigned int)memhandle;
+      args_mh.offset = (unsigned int)(uintptr_t)offset;
+      args_mh.size = size;
+      args_mh.userdata = userdata;
+      args_mh.mode = mode;
+      RETRY(ret, ioctl(service->fd, VCHIQ_IOC_QUEUE_BULK_RECEIVE_MH, &args_mh));
+
+      return (ret >= 0) ? VCHIQ_SUCCESS : VCHIQ_ERROR;
+   }
+
    args.handle = service->handle;
    args.data = offset;
    args.size = size;
@@ -546,6 +689,57 @@ vchiq_bulk_receive_handle(VCHIQ_SERVICE_HANDLE_T handle,
    return (ret >= 0) ? VCHIQ_SUCCESS : VCHIQ_ERROR;
 }
 
+VCHIQ_STATUS_T
+vchiq_bulk_register_memory(VCHIQ_SERVICE_HANDLE_T handle,
+   void *base,
+   int size,
+   VCHI_MEM_HANDLE_T *memhandle)
+{
+   VCHIQ_SERVICE_T *service = find_service_by_handle(handle);
+   VCHIQ_REGISTER_MEMORY_T args;
+   int ret;
+
+   vcos_log_trace( "%s called service handle = 0x%08x", __func__, (uint32_t)handle );
+
+   if (!service || !base || size <= 0 || !memhandle)
+      return VCHIQ_ERROR;
+
+   *memhandle = VCHI_MEM_HANDLE_INVALID;
+
+   /* The driver advertises support through its config version */
+   if (!vchiq_instance.use_register_memory)
+      return VCHIQ_ERROR;
+
+   args.handle = service->handle;
+   args.data = base;
+   args.size = size;
+   args.memhandle = 0;
+   RETRY(ret, ioctl(service->fd, VCHIQ_IOC_REGISTER_MEMORY, &args));
+   if (ret < 0)
+      return VCHIQ_ERROR;
+
+   *memhandle = (VCHI_MEM_HANDLE_T)args.memhandle;
+
+   return VCHIQ_SUCCESS;
+}
+
+VCHIQ_STATUS_T
+vchiq_bulk_unregister_memory(VCHIQ_SERVICE_HANDLE_T handle,
+   VCHI_MEM_HANDLE_T memhandle)
+{
+   VCHIQ_SERVICE_T *service = find_service_by_handle(handle);
+   int ret;
+
+   vcos_log_trace( "%s called service handle = 0x%08x", __func__, (uint32_t)handle );
+
+   if (!service || memhandle == VCHI_MEM_HANDLE_INVALID)
+      return VCHIQ_ERROR;
+
+   RETRY(ret, ioctl(service->fd, VCHIQ_IOC_UNREGISTER_MEMORY, memhandle));
+
+   return (ret >= 0) ? VCHIQ_SUCCESS : VCHIQ_ERROR;
+}
+
 int
 vchiq_get_client_id(VCHIQ_SERVICE_HANDLE_T handle)
 {
@@ -881,6 +1075,110 @@ vchi_bulk_queue_transmit( VCHI_SERVICE_HANDLE_T handle,
    return ret;
 }
 
+/***********************************************************
+ * Name: vchi_bulk_queue_transmitv
+ *
+ * Arguments:  VCHI_SERVICE_HANDLE_T handle,
+ *             VCHI_MSG_VECTOR_T *vector,
+ *             uint32_t count,
+ *             VCHI_FLAGS_T flags,
+ *             void *bulk_handle
+ *
+ * Description: Routine to transmit scattered data as a single bulk
+ *              transfer, gathering the vector elements in order. Saves
+ *              the caller coalescing multi-plane data into a staging
+ *              buffer. Without driver support the gather is performed
+ *              here instead, in which case only the blocking flags are
+ *              accepted (the staging copy is released on return).
+ *
+ * Returns: int32_t - success == 0
+ *
+ ***********************************************************/
+int32_t
+vchi_bulk_queue_transmitv( VCHI_SERVICE_HANDLE_T handle,
+   VCHI_MSG_VECTOR_T * vector,
+   uint32_t count,
+   VCHI_FLAGS_T flags,
+   void * bulk_handle )
+{
+   VCHI_SERVICE_T *service = find_service_by_handle(handle);
+   VCHIQ_BULK_MODE_T mode = VCHIQ_BULK_MODE_BLOCKING;
+   int ret;
+
+   if (!service)
+      return VCHIQ_ERROR;
+
+   switch ((int)flags) {
+   case VCHI_FLAGS_CALLBACK_WHEN_OP_COMPLETE | VCHI_FLAGS_BLOCK_UNTIL_QUEUED:
+      mode = VCHIQ_BULK_MODE_CALLBACK;
+      break;
+   case VCHI_FLAGS_BLOCK_UNTIL_DATA_READ:
+   case VCHI_FLAGS_BLOCK_UNTIL_OP_COMPLETE:
+      mode = VCHIQ_BULK_MODE_BLOCKING;
+      break;
+   case VCHI_FLAGS_BLOCK_UNTIL_QUEUED:
+   case VCHI_FLAGS_NONE:
+      mode = VCHIQ_BULK_MODE_NOCALLBACK;
+      break;
+   default:
+      vcos_assert(0);
+      break;
+   }
+
+   if (vchiq_instance.use_vectored_bulk)
+   {
+      VCHIQ_QUEUE_BULK_TRANSFER_V_T args;
+
+      args.handle = service->handle;
+      args.elements = (const VCHIQ_ELEMENT_T *)vector;
+      args.count = count;
+      args.userdata = bulk_handle;
+      args.mode = mode;
+      RETRY(ret, ioctl(service->fd, VCHIQ_IOC_QUEUE_BULK_TRANSMIT_V, &args));
+   }
+   else
+   {
+      VCHIQ_QUEUE_BULK_TRANSFER_T args;
+      uint32_t total = 0, i;
+      char *staging;
+
+      /* The staging buffer is freed as soon as the ioctl returns, so the
+         transfer must have completed by then */
+      if (!vcos_verify(mode == VCHIQ_BULK_MODE_BLOCKING))
+         return VCHIQ_ERROR;
+
+      for (i = 0; i < count; i++)
+      {
+         /* Nested vectors are not gathered here */
+         if (!vcos_verify(vector[i].vec_len >= 0))
+            return VCHIQ_ERROR;
+         total += vector[i].vec_len;
+      }
+
+      staging = malloc(total);
+      if (!staging)
+         return VCHIQ_ERROR;
+
+      total = 0;
+      for (i = 0; i < count; i++)
+      {
+         memcpy(staging + total, vector[i].vec_base, vector[i].vec_len);
+         total += vector[i].vec_len;
+      }
+
+      args.handle = service->handle;
+      args.data = staging;
+      args.size = total;
+      args.userdata = bulk_handle;
+      args.mode = mode;
+      RETRY(ret, ioctl(service->fd, VCHIQ_IOC_QUEUE_BULK_TRANSMIT, &args));
+
+      free(staging);
+   }
+
+   return ret;
+}
+
 /***********************************************************
  * Name: vchi_msg_dequeue
  *
@@ -933,7 +1231,9 @@ vchi_msg_dequeue( VCHI_SERVICE_HANDLE_T handle,
       args.blocking = (flags == VCHI_FLAGS_BLOCK_UNTIL_OP_COMPLETE);
       args.bufsize = max_data_size_to_read;
       args.buf = data;
-      RETRY(ret, ioctl(service->fd, VCHIQ_IOC_DEQUEUE_MESSAGE, &args));
+      do {
+         RETRY(ret, ioctl(service->fd, VCHIQ_IOC_DEQUEUE_MESSAGE, &args));
+      } while ((ret < 0) && (errno == EWOULDBLOCK) && msg_doorbell_rearm(service));
       if (ret >= 0)
       {
          *actual_msg_size = ret;
@@ -1208,10 +1508,18 @@ vchi_service_close( const VCHI_SERVICE_HANDLE_T handle )
    if (!service)
       return VCHIQ_ERROR;
 
+   if (service->is_client)
+   {
+      /* Unpublish the handle before tearing the service down so that no
+       * new lookup can return a service in mid-removal */
+      service->lib_handle = VCHIQ_SERVICE_HANDLE_INVALID;
+      __sync_synchronize();
+   }
+
    RETRY(ret,ioctl(service->fd, VCHIQ_IOC_CLOSE_SERVICE, service->handle));
 
    if (service->is_client)
-      service->lib_handle = VCHIQ_SERVICE_HANDLE_INVALID;
+      service->in_use = 0;
 
    return ret;
 }
@@ -1225,9 +1533,14 @@ vchi_service_destroy( const VCHI_SERVICE_HANDLE_T handle )
    if (!service)
       return VCHIQ_ERROR;
 
+   /* Unpublish the handle before tearing the service down so that no new
+    * lookup can return a service in mid-removal */
+   service->lib_handle = VCHIQ_SERVICE_HANDLE_INVALID;
+   __sync_synchronize();
+
    RETRY(ret,ioctl(service->fd, VCHIQ_IOC_REMOVE_SERVICE, service->handle));
 
-   service->lib_handle = VCHIQ_SERVICE_HANDLE_INVALID;
+   service->in_use = 0;
 
    return ret;
 }
@@ -1349,6 +1662,13 @@ int32_t vchi_service_set_option( const VCHI_SERVICE_HANDLE_T handle,
    case VCHI_SERVICE_OPTION_TRACE:
       args.option = VCHIQ_SERVICE_OPTION_TRACE;
       break;
+   case VCHI_SERVICE_OPTION_COALESCE_CALLBACKS:
+      /* Handled entirely within this library - no ioctl needed */
+      if (!service)
+         return VCHIQ_ERROR;
+      service->coalesce = (value != 0);
+      service->msg_doorbell = 0;
+      return 0;
    default:
       service = NULL;
       break;
@@ -1444,6 +1764,8 @@ vchiq_lib_init(void)
             {
                instance->used_services = 0;
                instance->use_close_delivered = (config.version >= VCHIQ_VERSION_CLOSE_DELIVERED);
+               instance->use_register_memory = (config.version >= VCHIQ_VERSION_REGISTER_MEMORY);
+               instance->use_vectored_bulk = (config.version >= VCHIQ_VERSION_BULK_TRANSMIT_VECTORED);
                vcos_mutex_create(&instance->mutex, "VCHIQ instance");
                instance->initialised = 1;
             }
@@ -1478,13 +1800,11 @@ vchiq_lib_init(void)
    return instance;
 }
 
-static void *
-completion_thread(void *arg)
+/* Dispatch a single completion to the service's callback */
+static void
+completion_dispatch(VCHIQ_INSTANCE_T instance, VCHIQ_COMPLETION_DATA_T *completion)
 {
-   VCHIQ_INSTANCE_T instance = (VCHIQ_INSTANCE_T)arg;
-   VCHIQ_AWAIT_COMPLETION_T args;
-   VCHIQ_COMPLETION_DATA_T completions[8];
-   void *msgbufs[8];
+   VCHIQ_SERVICE_T *service = (VCHIQ_SERVICE_T *)completion->service_userdata;
 
    static const VCHI_CALLBACK_REASON_T vchiq_reason_to_vchi[] =
    {
@@ -1497,6 +1817,167 @@ completion_thread(void *arg)
       VCHI_CALLBACK_BULK_RECEIVE_ABORTED,  // VCHIQ_BULK_RECEIVE_ABORTED
    };
 
+   /* Coalesced doorbell mode: only the first message of a burst triggers a
+    * callback, the consumer is expected to dequeue until empty, which
+    * re-arms the doorbell. Restricted to vchi services as vchiq callbacks
+    * carry the message itself and so can't be elided. */
+   if ((completion->reason == VCHIQ_MESSAGE_AVAILABLE) && service->coalesce &&
+      !service->base.callback)
+   {
+      if (__sync_lock_test_and_set(&service->msg_doorbell, 1))
+         return;
+   }
+
+   if (completion->reason == VCHIQ_BULK_TRANSMIT_DONE)
+      VCOS_PROBE2(vchiq, bulk_transmit_done, service->lib_handle, completion->bulk_userdata);
+   else if (completion->reason == VCHIQ_BULK_RECEIVE_DONE)
+      VCOS_PROBE2(vchiq, bulk_receive_done, service->lib_handle, completion->bulk_userdata);
+
+   if (service->base.callback)
+   {
+      vcos_log_trace( "callback(%x, %x, %x(%x,%x), %x)",
+         completion->reason, (uint32_t)completion->header,
+         (uint32_t)&service->base, (uint32_t)service->lib_handle, (uint32_t)service->base.userdata, (uint32_t)completion->bulk_userdata );
+      service->base.callback(completion->reason, completion->header,
+         service->lib_handle, completion->bulk_userdata);
+   }
+   else if (service->vchi_callback)
+   {
+      VCHI_CALLBACK_REASON_T vchi_reason =
+         vchiq_reason_to_vchi[completion->reason];
+      service->vchi_callback(service->base.userdata, vchi_reason, completion->bulk_userdata);
+   }
+
+   if ((completion->reason == VCHIQ_SERVICE_CLOSED) &&
+       instance->use_close_delivered)
+   {
+      int ret;
+      RETRY(ret,ioctl(service->fd, VCHIQ_IOC_CLOSE_DELIVERED, service->handle));
+   }
+}
+
+/* Worker thread dispatching the completions queued by the completion thread */
+static void *
+completion_worker_thread(void *arg)
+{
+   VCHIQ_COMPLETION_WORKER_T *worker = (VCHIQ_COMPLETION_WORKER_T *)arg;
+
+   while (1)
+   {
+      VCHIQ_COMPLETION_DATA_T completion;
+
+      vcos_semaphore_wait(&worker->work);
+      if (worker->stop && worker->remove == worker->insert)
+         break;
+
+      completion = worker->queue[worker->remove++ & (VCHIQ_WORKER_QUEUE_SIZE - 1)];
+      vcos_semaphore_post(&worker->space);
+
+      completion_dispatch(worker->instance, &completion);
+   }
+
+   return NULL;
+}
+
+/* Queue a completion on the worker owning the service. Completions for a
+ * given service always go to the same worker so their relative order is
+ * preserved. */
+static void
+completion_worker_post(VCHIQ_INSTANCE_T instance, VCHIQ_COMPLETION_DATA_T *completion)
+{
+   VCHIQ_SERVICE_T *service = (VCHIQ_SERVICE_T *)completion->service_userdata;
+   VCHIQ_COMPLETION_WORKER_T *worker =
+      &instance->workers[(unsigned int)(service - instance->services) % instance->worker_num];
+
+   vcos_semaphore_wait(&worker->space);
+   worker->queue[worker->insert++ & (VCHIQ_WORKER_QUEUE_SIZE - 1)] = *completion;
+   vcos_semaphore_post(&worker->work);
+}
+
+/* Pin the completion path to the cpus given in VCHIQ_COMPLETION_CPUS (a
+ * bitmask, e.g. 0x4 to dedicate core 2 to IPC completion). Unset or zero
+ * leaves the threads free to run anywhere. */
+static void
+completion_cpuset_apply(VCOS_THREAD_ATTR_T *attrs)
+{
+   const char *env = getenv("VCHIQ_COMPLETION_CPUS");
+   unsigned long cpuset = env ? strtoul(env, NULL, 0) : 0;
+
+   if (cpuset)
+      vcos_thread_attr_setcpuset(attrs, (VCOS_UNSIGNED)cpuset);
+}
+
+static void
+completion_workers_start(VCHIQ_INSTANCE_T instance)
+{
+   const char *env = getenv("VCHIQ_COMPLETION_WORKERS");
+   int num = env ? atoi(env) : 0;
+   VCOS_THREAD_ATTR_T attrs;
+   int i;
+
+   if (num <= 0)
+      return;
+   if (num > VCHIQ_COMPLETION_WORKERS_MAX)
+      num = VCHIQ_COMPLETION_WORKERS_MAX;
+
+   vcos_thread_attr_init(&attrs);
+   completion_cpuset_apply(&attrs);
+
+   for (i = 0; i < num; i++)
+   {
+      VCHIQ_COMPLETION_WORKER_T *worker = &instance->workers[i];
+
+      worker->instance = instance;
+      worker->insert = worker->remove = 0;
+      worker->stop = 0;
+      if (vcos_semaphore_create(&worker->space, "VCHIQ worker space",
+                                VCHIQ_WORKER_QUEUE_SIZE) != VCOS_SUCCESS)
+         break;
+      if (vcos_semaphore_create(&worker->work, "VCHIQ worker work", 0) != VCOS_SUCCESS)
+      {
+         vcos_semaphore_delete(&worker->space);
+         break;
+      }
+      if (vcos_thread_create(&worker->thread, "VCHIQ worker", &attrs,
+                             completion_worker_thread, worker) != VCOS_SUCCESS)
+      {
+         vcos_semaphore_delete(&worker->work);
+         vcos_semaphore_delete(&worker->space);
+         break;
+      }
+   }
+
+   instance->worker_num = i;
+}
+
+static void
+completion_workers_stop(VCHIQ_INSTANCE_T instance)
+{
+   int i;
+
+   for (i = 0; i < instance->worker_num; i++)
+   {
+      VCHIQ_COMPLETION_WORKER_T *worker = &instance->workers[i];
+
+      /* The extra post wakes the worker once its queue has been drained */
+      worker->stop = 1;
+      vcos_semaphore_post(&worker->work);
+      vcos_thread_join(&worker->thread, NULL);
+      vcos_semaphore_delete(&worker->work);
+      vcos_semaphore_delete(&worker->space);
+   }
+
+   instance->worker_num = 0;
+}
+
+static void *
+completion_thread(void *arg)
+{
+   VCHIQ_INSTANCE_T instance = (VCHIQ_INSTANCE_T)arg;
+   VCHIQ_AWAIT_COMPLETION_T args;
+   VCHIQ_COMPLETION_DATA_T completions[VCHIQ_COMPLETION_BATCH_SIZE];
+   void *msgbufs[VCHIQ_COMPLETION_BATCH_SIZE];
+
    args.count = vcos_countof(completions);
    args.buf = completions;
    args.msgbufsize = MSGBUF_SIZE;
@@ -1529,27 +2010,11 @@ completion_thread(void *arg)
       for (i = 0; i < ret; i++)
       {
          VCHIQ_COMPLETION_DATA_T *completion = &completions[i];
-         VCHIQ_SERVICE_T *service = (VCHIQ_SERVICE_T *)completion->service_userdata;
-         if (service->base.callback)
-         {
-            vcos_log_trace( "callback(%x, %x, %x(%x,%x), %x)",
-               completion->reason, (uint32_t)completion->header,
-               (uint32_t)&service->base, (uint32_t)service->lib_handle, (uint32_t)service->base.userdata, (uint32_t)completion->bulk_userdata );
-            service->base.callback(completion->reason, completion->header,
-               service->lib_handle, completion->bulk_userdata);
-         }
-         else if (service->vchi_callback)
-         {
-            VCHI_CALLBACK_REASON_T vchi_reason =
-               vchiq_reason_to_vchi[completion->reason];
-            service->vchi_callback(service->base.userdata, vchi_reason, completion->bulk_userdata);
-         }
 
-         if ((completion->reason == VCHIQ_SERVICE_CLOSED) &&
-             instance->use_close_delivered)
-         {
-            RETRY(ret,ioctl(service->fd, VCHIQ_IOC_CLOSE_DELIVERED, service->handle));
-         }
+         if (instance->worker_num)
+            completion_worker_post(instance, completion);
+         else
+            completion_dispatch(instance, completion);
       }
    }
 
@@ -1570,6 +2035,7 @@ create_service(VCHIQ_INSTANCE_T instance,
    VCHIQ_SERVICE_HANDLE_T *phandle)
 {
    VCHIQ_SERVICE_T *service = NULL;
+   VCHIQ_SERVICE_HANDLE_T lib_handle = VCHIQ_SERVICE_HANDLE_INVALID;
    VCHIQ_STATUS_T status = VCHIQ_SUCCESS;
    int i;
 
@@ -1584,7 +2050,7 @@ create_service(VCHIQ_INSTANCE_T instance,
       /* Find a free service */
       for (i = 0; i < instance->used_services; i++)
       {
-         if (instance->services[i].lib_handle == VCHIQ_SERVICE_HANDLE_INVALID)
+         if (!instance->services[i].in_use)
          {
             service = &instance->services[i];
             break;
@@ -1596,7 +2062,7 @@ create_service(VCHIQ_INSTANCE_T instance,
       for (i = (instance->used_services - 1); i >= 0; i--)
       {
          VCHIQ_SERVICE_T *srv = &instance->services[i];
-         if (srv->lib_handle == VCHIQ_SERVICE_HANDLE_INVALID)
+         if (!srv->in_use)
          {
             service = srv;
          }
@@ -1627,17 +2093,14 @@ create_service(VCHIQ_INSTANCE_T instance,
    {
       if (!handle_seq)
          handle_seq = VCHIQ_MAX_INSTANCE_SERVICES;
-      service->lib_handle = handle_seq | (service - instance->services);
+      lib_handle = handle_seq | (service - instance->services);
       handle_seq += VCHIQ_MAX_INSTANCE_SERVICES;
-   }
-
-   vcos_mutex_unlock(&instance->mutex);
-
-   if (service)
-   {
-      VCHIQ_CREATE_SERVICE_T args;
-      int ret;
 
+      /* Claim the slot and initialise it while still under the mutex, but
+       * don't publish the handle yet. Lookups are lock-free so a handle must
+       * never resolve to a half-built service. */
+      service->in_use = 1;
+      service->lib_handle = VCHIQ_SERVICE_HANDLE_INVALID;
       service->base.fourcc = params->fourcc;
       service->base.callback = params->callback;
       service->vchi_callback = vchi_callback;
@@ -1646,6 +2109,16 @@ create_service(VCHIQ_INSTANCE_T instance,
       service->peek_size = -1;
       service->peek_buf = NULL;
       service->is_client = is_open;
+      service->coalesce = 0;
+      service->msg_doorbell = 0;
+   }
+
+   vcos_mutex_unlock(&instance->mutex);
+
+   if (service)
+   {
+      VCHIQ_CREATE_SERVICE_T args;
+      int ret;
 
       args.params = *params;
       args.params.userdata = service;
@@ -1661,15 +2134,22 @@ create_service(VCHIQ_INSTANCE_T instance,
 
    if (status == VCHIQ_SUCCESS)
    {
-      *phandle = service->lib_handle;
+      /* Publish the handle. The barrier pairs with the one in
+       * find_service_by_handle: a lookup which sees the new handle also
+       * sees the initialised service. */
+      __sync_synchronize();
+      service->lib_handle = lib_handle;
+
+      *phandle = lib_handle;
       vcos_log_info("service handle %x lib_handle %x using fourcc 0x%x",
-         service->handle, service->lib_handle, params->fourcc);
+         service->handle, lib_handle, params->fourcc);
    }
    else
    {
       vcos_mutex_lock(&instance->mutex);
 
-      service->lib_handle = VCHIQ_SERVICE_HANDLE_INVALID;
+      if (service)
+         service->in_use = 0;
 
       vcos_mutex_unlock(&instance->mutex);
 
@@ -1700,7 +2180,9 @@ fill_peek_buf(VCHI_SERVICE_T *service,
          args.bufsize = MSGBUF_SIZE;
          args.buf = service->peek_buf;
 
-         RETRY(ret, ioctl(service->fd, VCHIQ_IOC_DEQUEUE_MESSAGE, &args));
+         do {
+            RETRY(ret, ioctl(service->fd, VCHIQ_IOC_DEQUEUE_MESSAGE, &args));
+         } while ((ret < 0) && (errno == EWOULDBLOCK) && msg_doorbell_rearm(service));
 
          if (ret >= 0)
          {
@@ -30,6 +30,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <string.h>
 
 #include "vchiq_test.h"
+#include "vchiq_cfg.h"
 #ifndef USE_VCHIQ_ARM
 #define USE_VCHIQ_ARM
 #endif
@@ -92,10 +93,14 @@ static VCHIQ_STATUS_T vchiq_ctrl_test(void);
 static VCHIQ_STATUS_T vchiq_functional_test(void);
 static VCHIQ_STATUS_T vchiq_ping_test(void);
 static VCHIQ_STATUS_T vchiq_signal_test(void);
+static VCHIQ_STATUS_T vchiq_benchmark_test(void);
 
 static VCHIQ_STATUS_T do_functional_test(void);
 static void do_ping_test(VCHIQ_SERVICE_HANDLE_T service, int size, int async, int oneway, int iters);
 static void do_vchi_ping_test(VCHI_SERVICE_HANDLE_T service, int size, int async, int oneway, int iters);
+static void do_bench_msg_rate(VCHIQ_SERVICE_HANDLE_T service, int size, int iters);
+static void do_bench_bulk_bandwidth(VCHIQ_SERVICE_HANDLE_T service, int size, int iters);
+static void do_bench_latency(VCHIQ_SERVICE_HANDLE_T service, int size, int iters);
 
 static VCHIQ_STATUS_T func_data_test(VCHIQ_SERVICE_HANDLE_T service, int size, int align, int server_align);
 
@@ -162,6 +167,7 @@ static int vchiq_test(int argc, char **argv)
    int run_functional_test = 0;
    int run_ping_test = 0;
    int run_signal_test = 0;
+   int run_benchmark_test = 0;
    int verbose = 0;
    int argn;
  
@@ -188,6 +194,11 @@ static int vchiq_test(int argc, char **argv)
          run_bulk_test = 1;
          g_params.blocksize = atoi(argv[argn++]);
       }
+      else if (strcmp(arg, "-B") == 0)
+      {
+         run_benchmark_test = 1;
+         g_params.iters = 1000;
+      }
       else if (strcmp(arg, "-c") == 0)
       {
          run_ctrl_test = 1;
@@ -281,7 +292,7 @@ static int vchiq_test(int argc, char **argv)
       }
    }
 
-   if ((run_ctrl_test + run_bulk_test + run_functional_test + run_ping_test + run_signal_test) != 1)
+   if ((run_ctrl_test + run_bulk_test + run_functional_test + run_ping_test + run_signal_test + run_benchmark_test) != 1)
       usage();
 
    if (argn < argc)
@@ -328,6 +339,8 @@ static int vchiq_test(int argc, char **argv)
       status = vchiq_ping_test();
    else if (run_signal_test)
       status = vchiq_signal_test();
+   else if (run_benchmark_test)
+      status = vchiq_benchmark_test();
 
    return (status == VCHIQ_SUCCESS) ? 0 : -1;
 }
@@ -752,6 +765,209 @@ vchiq_signal_test(void)
    return VCHIQ_SUCCESS;
 }
 
+static int
+bench_compare_u32(const void *a, const void *b)
+{
+   uint32_t ua = *(const uint32_t *)a, ub = *(const uint32_t *)b;
+   return (ua < ub) ? -1 : (ua > ub) ? 1 : 0;
+}
+
+static uint32_t
+bench_percentile(const uint32_t *samples, int count, int percent)
+{
+   int idx = (count * percent) / 100;
+   if (idx >= count)
+      idx = count - 1;
+   return samples[idx];
+}
+
+static VCHIQ_STATUS_T
+vchiq_benchmark_test(void)
+{
+   /* Emit machine-readable throughput and latency figures for the current
+      slot configuration */
+   VCHIQ_INSTANCE_T vchiq_instance;
+   VCHIQ_SERVICE_HANDLE_T vchiq_service;
+   VCHIQ_SERVICE_PARAMS_T vchiq_service_params;
+   int fourcc;
+
+   static int msg_sizes[] = { 0, 64, 1024, 2048, VCHIQ_MAX_MSG_SIZE };
+   int bulk_size;
+   unsigned int i;
+
+   fourcc = VCHIQ_MAKE_FOURCC(g_servname[0], g_servname[1], g_servname[2], g_servname[3]);
+
+   printf("Benchmark - service:%s, iters:%d, version %d\n", g_servname, g_params.iters, VCHIQ_TEST_VER);
+
+#ifdef ANDROID
+   if (g_timeout_ms)
+   {
+      setup_auto_kill(g_timeout_ms);
+   }
+#endif
+
+   if (vchiq_initialise(&vchiq_instance) != VCHIQ_SUCCESS)
+   {
+      printf("* failed to open vchiq instance\n");
+      return VCHIQ_ERROR;
+   }
+
+   vchiq_connect(vchiq_instance);
+
+   INIT_PARAMS(&vchiq_service_params, fourcc, clnt_callback, "clnt userdata", VCHIQ_TEST_VER);
+   if (vchiq_open_service(vchiq_instance, &vchiq_service_params, &vchiq_service) != VCHIQ_SUCCESS)
+   {
+      printf("* failed to open service - already in use?\n");
+      return VCHIQ_ERROR;
+   }
+
+   /* The slot configuration is fixed at build time - record it with the
+      results so runs against different configurations can be compared */
+   printf("config,slot_size,max_slots,max_slots_per_side,current_bulks,service_bulks\n");
+   printf("config,%d,%d,%d,%d,%d\n", VCHIQ_SLOT_SIZE, VCHIQ_MAX_SLOTS,
+          VCHIQ_MAX_SLOTS_PER_SIDE, VCHIQ_NUM_CURRENT_BULKS, VCHIQ_NUM_SERVICE_BULKS);
+
+   printf("msg_rate,size,iters,usecs,msgs_per_sec\n");
+   for (i = 0; i < vcos_countof(msg_sizes); i++)
+      do_bench_msg_rate(vchiq_service, msg_sizes[i], g_params.iters);
+
+   printf("bulk,size,iters,usecs,mbytes_per_sec\n");
+   for (bulk_size = PAGE_SIZE; bulk_size <= BULK_SIZE; bulk_size <<= 1)
+      do_bench_bulk_bandwidth(vchiq_service, bulk_size, vcos_max(g_params.iters/10, 1));
+
+   printf("latency,size,iters,min,p50,p90,p99,max\n");
+   for (i = 0; i < vcos_countof(msg_sizes); i++)
+      do_bench_latency(vchiq_service, msg_sizes[i], g_params.iters);
+
+   vchiq_close_service(vchiq_service);
+
+   return VCHIQ_SUCCESS;
+}
+
+static void
+do_bench_msg_rate(VCHIQ_SERVICE_HANDLE_T service, int size, int iters)
+{
+   uint32_t start, end;
+   char *ping_buf = malloc(size + sizeof(struct test_params));
+   struct test_params *params = (struct test_params *)ping_buf;
+   VCHIQ_ELEMENT_T element;
+   int i;
+
+   element.data = ping_buf;
+
+   /* Set up the quotas for messages */
+   *params = g_params;
+   params->magic = MSG_CONFIG;
+   params->blocksize = 0;
+   element.size = sizeof(*params);
+   vchiq_queue_message(service, &element, 1);
+   vcos_event_wait(&g_server_reply);
+   vchiq_set_service_option(service, VCHIQ_SERVICE_OPTION_MESSAGE_QUOTA, params->client_message_quota);
+
+   /* Allow enough room for the type header */
+   element.size = (size < 4) ? 4 : size;
+
+   /* One-way messages generate no reply, so fence with a sync message to
+      ensure everything has been consumed before stopping the clock */
+   start = vcos_getmicrosecs();
+   params->magic = MSG_ONEWAY;
+   for (i = 0; i < iters; i++)
+      vchiq_queue_message(service, &element, 1);
+   params->magic = MSG_SYNC;
+   vchiq_queue_message(service, &element, 1);
+   vcos_event_wait(&g_server_reply);
+   end = vcos_getmicrosecs();
+
+   printf("msg_rate,%d,%d,%u,%f\n", size, iters, end - start,
+          (iters + 1) * 1000000.0f / (end - start));
+
+   free(ping_buf);
+
+   vcos_sleep(20);
+}
+
+static void
+do_bench_bulk_bandwidth(VCHIQ_SERVICE_HANDLE_T service, int size, int iters)
+{
+   uint32_t start, end;
+   char *bulk_buf = malloc(size + sizeof(struct test_params));
+   struct test_params *params = (struct test_params *)bulk_buf;
+   VCHIQ_ELEMENT_T element;
+   int i;
+
+   element.data = bulk_buf;
+
+   *params = g_params;
+   params->magic = MSG_CONFIG;
+   params->blocksize = size;
+   params->iters = iters;
+   params->verify = 0;
+   params->echo = 0;
+   element.size = sizeof(*params);
+   vchiq_queue_message(service, &element, 1);
+   vcos_event_wait(&g_server_reply);
+
+   vcos_sleep(30);
+
+   start = vcos_getmicrosecs();
+   for (i = 0; i < iters; i++)
+      vchiq_bulk_transmit(service, bulk_buf, size, 0, VCHIQ_BULK_MODE_BLOCKING);
+   end = vcos_getmicrosecs();
+
+   printf("bulk,%d,%d,%u,%f\n", size, iters, end - start,
+          ((float)size * iters) / (end - start));
+
+   free(bulk_buf);
+
+   vcos_sleep(40);
+}
+
+static void
+do_bench_latency(VCHIQ_SERVICE_HANDLE_T service, int size, int iters)
+{
+   uint32_t *samples = malloc(iters * sizeof(uint32_t));
+   char *ping_buf = malloc(size + sizeof(struct test_params));
+   struct test_params *params = (struct test_params *)ping_buf;
+   VCHIQ_ELEMENT_T element;
+   int i;
+
+   element.data = ping_buf;
+
+   *params = g_params;
+   params->magic = MSG_CONFIG;
+   params->blocksize = 0;
+   element.size = sizeof(*params);
+   vchiq_queue_message(service, &element, 1);
+   vcos_event_wait(&g_server_reply);
+
+   element.size = (size < 4) ? 4 : size;
+   params->magic = MSG_SYNC;
+
+   /* Time each round trip individually so the full distribution is
+      available, not just the mean */
+   for (i = 0; i < iters; i++)
+   {
+      uint32_t start = vcos_getmicrosecs();
+      vchiq_queue_message(service, &element, 1);
+      vcos_event_wait(&g_server_reply);
+      samples[i] = vcos_getmicrosecs() - start;
+   }
+
+   qsort(samples, iters, sizeof(uint32_t), bench_compare_u32);
+
+   printf("latency,%d,%d,%u,%u,%u,%u,%u\n", size, iters,
+          samples[0],
+          bench_percentile(samples, iters, 50),
+          bench_percentile(samples, iters, 90),
+          bench_percentile(samples, iters, 99),
+          samples[iters - 1]);
+
+   free(ping_buf);
+   free(samples);
+
+   vcos_sleep(20);
+}
+
 static VCHIQ_STATUS_T
 do_functional_test(void)
 {
@@ -1603,6 +1819,7 @@ static void usage(void)
    printf("  and <mode> is one of:\n");
    printf("    -c <size>   control test (size in bytes)\n");
    printf("    -b <size>   bulk test (size in kilobytes)\n");
+   printf("    -B          benchmark (CSV output)\n");
    printf("    -f          functional test\n");
    printf("    -p          ping test\n");
    printf("    -t          check the timer\n");
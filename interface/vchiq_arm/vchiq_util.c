@@ -81,16 +81,48 @@ void vchiu_queue_push(VCHIU_QUEUE_T *queue, VCHIQ_HEADER_T *header)
 
    queue->storage[queue->write & (queue->size - 1)] = header;
 
+   /* Make the content visible before publishing the new write index,
+    * the consumer side only synchronises on the indices */
+   __sync_synchronize();
+
    queue->write++;
 
    vcos_event_signal(&queue->push);
 }
 
+void vchiu_queue_push_n(VCHIU_QUEUE_T *queue, VCHIQ_HEADER_T **headers, int num)
+{
+   int i;
+
+   for (i = 0; i < num; i++)
+   {
+      while (queue->write == queue->read + queue->size)
+      {
+         /* Wake the consumer before blocking, or it could be left asleep
+          * while the elements already pushed are waiting for it */
+         vcos_event_signal(&queue->push);
+         vcos_event_wait(&queue->pop);
+      }
+
+      queue->storage[queue->write & (queue->size - 1)] = headers[i];
+
+      __sync_synchronize();
+
+      queue->write++;
+   }
+
+   /* A single wakeup for the whole batch */
+   vcos_event_signal(&queue->push);
+}
+
 VCHIQ_HEADER_T *vchiu_queue_peek(VCHIU_QUEUE_T *queue)
 {
    while (queue->write == queue->read)
       vcos_event_wait(&queue->push);
 
+   /* Don't read the content before the write index which published it */
+   __sync_synchronize();
+
    return queue->storage[queue->read & (queue->size - 1)];
 }
 
@@ -101,11 +133,42 @@ VCHIQ_HEADER_T *vchiu_queue_pop(VCHIU_QUEUE_T *queue)
    while (queue->write == queue->read)
       vcos_event_wait(&queue->push);
 
+   /* Don't read the content before the write index which published it */
+   __sync_synchronize();
+
    header = queue->storage[queue->read & (queue->size - 1)];
 
+   /* Finish reading the content before freeing the slot for the producer */
+   __sync_synchronize();
+
    queue->read++;
 
    vcos_event_signal(&queue->pop);
 
    return header;
 }
+
+int vchiu_queue_pop_n(VCHIU_QUEUE_T *queue, VCHIQ_HEADER_T **headers, int num)
+{
+   int i = 0;
+
+   while (queue->write == queue->read)
+      vcos_event_wait(&queue->push);
+
+   __sync_synchronize();
+
+   /* Drain whatever is available without blocking again */
+   while (i < num && queue->read != queue->write)
+   {
+      headers[i++] = queue->storage[queue->read & (queue->size - 1)];
+
+      __sync_synchronize();
+
+      queue->read++;
+   }
+
+   /* A single wakeup for the whole batch */
+   vcos_event_signal(&queue->pop);
+
+   return i;
+}
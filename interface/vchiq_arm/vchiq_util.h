@@ -49,9 +49,18 @@ extern int vchiu_queue_is_empty(VCHIU_QUEUE_T *queue);
 extern int vchiu_queue_is_full(VCHIU_QUEUE_T *queue);
 
 extern void vchiu_queue_push(VCHIU_QUEUE_T *queue, VCHIQ_HEADER_T *header);
+/* Push a batch of elements with a single consumer wakeup. Blocks while the
+   queue is full. */
+extern void vchiu_queue_push_n(VCHIU_QUEUE_T *queue, VCHIQ_HEADER_T **headers,
+   int num);
 
 extern VCHIQ_HEADER_T *vchiu_queue_peek(VCHIU_QUEUE_T *queue);
 extern VCHIQ_HEADER_T *vchiu_queue_pop(VCHIU_QUEUE_T *queue);
+/* Pop up to num elements with a single producer wakeup. Blocks until at least
+   one element is available, then drains what is there without blocking again.
+   Returns the number of elements popped. */
+extern int vchiu_queue_pop_n(VCHIU_QUEUE_T *queue, VCHIQ_HEADER_T **headers,
+   int num);
 
 #endif
 
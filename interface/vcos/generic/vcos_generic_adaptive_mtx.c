@@ -0,0 +1,106 @@
+/*
+Copyright (c) 2012, Broadcom Europe Ltd
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*=============================================================================
+VideoCore OS Abstraction Layer - adaptive-spin mutexes from regular ones.
+=============================================================================*/
+
+#include "interface/vcos/vcos.h"
+
+/* Bounds for the per-mutex spin limit. The limit doubles when spinning
+ * acquired the lock and halves when we had to sleep anyway, so a mutex
+ * protecting a nanosecond-scale critical section settles near the upper
+ * bound and one held for long periods stops spinning almost entirely.
+ */
+#define ADAPTIVE_MUTEX_MIN_SPINS  4
+#define ADAPTIVE_MUTEX_MAX_SPINS  1024
+#define ADAPTIVE_MUTEX_INITIAL_SPINS 32
+
+VCOS_STATUS_T vcos_generic_adaptive_mutex_create(VCOS_ADAPTIVE_MUTEX_T *m, const char *name)
+{
+   m->spin_limit = ADAPTIVE_MUTEX_INITIAL_SPINS;
+   memset(&m->stats, 0, sizeof(m->stats));
+   return vcos_mutex_create(&m->mutex, name);
+}
+
+void vcos_generic_adaptive_mutex_delete(VCOS_ADAPTIVE_MUTEX_T *m)
+{
+   vcos_mutex_delete(&m->mutex);
+}
+
+void vcos_generic_adaptive_mutex_lock(VCOS_ADAPTIVE_MUTEX_T *m)
+{
+   if (vcos_mutex_trylock(&m->mutex) != VCOS_SUCCESS)
+   {
+      uint32_t start = vcos_getmicrosecs();
+      uint32_t limit = m->spin_limit;
+      uint32_t spins = 0;
+
+      while (spins < limit &&
+            vcos_mutex_trylock(&m->mutex) != VCOS_SUCCESS)
+         spins++;
+
+      if (spins >= limit)
+      {
+         /* Spinning didn't pay off - sleep, and spin less next time */
+         vcos_mutex_lock(&m->mutex);
+         if (m->spin_limit > ADAPTIVE_MUTEX_MIN_SPINS)
+            m->spin_limit = m->spin_limit / 2;
+      }
+      else
+      {
+         /* Holder let go while we spun - be more patient next time */
+         if (m->spin_limit < ADAPTIVE_MUTEX_MAX_SPINS)
+            m->spin_limit = m->spin_limit * 2;
+      }
+
+      /* Updated while holding the mutex, so plain increments are safe */
+      m->stats.contended++;
+      m->stats.total_wait_us += vcos_getmicrosecs() - start;
+   }
+   m->stats.acquisitions++;
+}
+
+VCOS_STATUS_T vcos_generic_adaptive_mutex_trylock(VCOS_ADAPTIVE_MUTEX_T *m)
+{
+   VCOS_STATUS_T st = vcos_mutex_trylock(&m->mutex);
+   if (st == VCOS_SUCCESS)
+      m->stats.acquisitions++;
+   return st;
+}
+
+void vcos_generic_adaptive_mutex_unlock(VCOS_ADAPTIVE_MUTEX_T *m)
+{
+   vcos_mutex_unlock(&m->mutex);
+}
+
+void vcos_generic_adaptive_mutex_get_stats(VCOS_ADAPTIVE_MUTEX_T *m, VCOS_ADAPTIVE_MUTEX_STATS_T *stats)
+{
+   /* A racy read; good enough for diagnostics and doesn't perturb the
+    * lock being observed */
+   *stats = m->stats;
+}
@@ -0,0 +1,122 @@
+/*
+Copyright (c) 2012, Broadcom Europe Ltd
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*=============================================================================
+VideoCore OS Abstraction Layer - adaptive-spin mutexes from regular ones.
+=============================================================================*/
+
+#ifndef VCOS_GENERIC_ADAPTIVE_MUTEX_H
+#define VCOS_GENERIC_ADAPTIVE_MUTEX_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "interface/vcos/vcos_types.h"
+
+/**
+ * \file
+ *
+ * Adaptive-spin Mutexes from regular ones.
+ *
+ */
+
+/** Contention statistics for an adaptive mutex. Counters are updated
+ * while the mutex is held, so readers see a consistent-enough snapshot
+ * without taking the lock themselves.
+ */
+typedef struct VCOS_ADAPTIVE_MUTEX_STATS_T
+{
+   /** Number of successful acquisitions */
+   uint32_t acquisitions;
+   /** Acquisitions that found the mutex already held */
+   uint32_t contended;
+   /** Total time spent waiting (spinning or sleeping), in microseconds */
+   uint32_t total_wait_us;
+} VCOS_ADAPTIVE_MUTEX_STATS_T;
+
+typedef struct VCOS_ADAPTIVE_MUTEX_T
+{
+   VCOS_MUTEX_T mutex;
+   /** Current spin limit, adapted from recent acquisition history */
+   uint32_t spin_limit;
+   VCOS_ADAPTIVE_MUTEX_STATS_T stats;
+} VCOS_ADAPTIVE_MUTEX_T;
+
+/* Extern definitions of functions that do the actual work */
+
+VCOSPRE_ VCOS_STATUS_T VCOSPOST_ vcos_generic_adaptive_mutex_create(VCOS_ADAPTIVE_MUTEX_T *m, const char *name);
+
+VCOSPRE_ void VCOSPOST_ vcos_generic_adaptive_mutex_delete(VCOS_ADAPTIVE_MUTEX_T *m);
+
+VCOSPRE_ void VCOSPOST_ vcos_generic_adaptive_mutex_lock(VCOS_ADAPTIVE_MUTEX_T *m);
+
+VCOSPRE_ VCOS_STATUS_T VCOSPOST_ vcos_generic_adaptive_mutex_trylock(VCOS_ADAPTIVE_MUTEX_T *m);
+
+VCOSPRE_ void VCOSPOST_ vcos_generic_adaptive_mutex_unlock(VCOS_ADAPTIVE_MUTEX_T *m);
+
+VCOSPRE_ void VCOSPOST_ vcos_generic_adaptive_mutex_get_stats(VCOS_ADAPTIVE_MUTEX_T *m, VCOS_ADAPTIVE_MUTEX_STATS_T *stats);
+
+/* Inline forwarding functions */
+
+#if defined(VCOS_INLINE_BODIES)
+
+VCOS_INLINE_IMPL
+VCOS_STATUS_T vcos_adaptive_mutex_create(VCOS_ADAPTIVE_MUTEX_T *m, const char *name) {
+   return vcos_generic_adaptive_mutex_create(m,name);
+}
+
+VCOS_INLINE_IMPL
+void vcos_adaptive_mutex_delete(VCOS_ADAPTIVE_MUTEX_T *m) {
+   vcos_generic_adaptive_mutex_delete(m);
+}
+
+VCOS_INLINE_IMPL
+void vcos_adaptive_mutex_lock(VCOS_ADAPTIVE_MUTEX_T *m) {
+   vcos_generic_adaptive_mutex_lock(m);
+}
+
+VCOS_INLINE_IMPL
+VCOS_STATUS_T vcos_adaptive_mutex_trylock(VCOS_ADAPTIVE_MUTEX_T *m) {
+   return vcos_generic_adaptive_mutex_trylock(m);
+}
+
+VCOS_INLINE_IMPL
+void vcos_adaptive_mutex_unlock(VCOS_ADAPTIVE_MUTEX_T *m) {
+   vcos_generic_adaptive_mutex_unlock(m);
+}
+
+VCOS_INLINE_IMPL
+void vcos_adaptive_mutex_get_stats(VCOS_ADAPTIVE_MUTEX_T *m, VCOS_ADAPTIVE_MUTEX_STATS_T *stats) {
+   vcos_generic_adaptive_mutex_get_stats(m, stats);
+}
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+#endif
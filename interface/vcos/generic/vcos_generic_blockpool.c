@@ -145,7 +145,6 @@ VCOS_STATUS_T vcos_generic_blockpool_init(VCOS_BLOCKPOOL_T *pool,
    VCOS_STATUS_T status = VCOS_SUCCESS;
 
    vcos_unused(name);
-   vcos_unused(flags);
 
    vcos_log_trace(
          "%s: pool %p num_blocks %d block_size %d start %p pool_size %d name %p",
@@ -191,6 +190,21 @@ VCOS_STATUS_T vcos_generic_blockpool_init(VCOS_BLOCKPOOL_T *pool,
    pool->num_subpools = 1;
    pool->num_extension_blocks = 0;
    pool->align = align;
+   pool->flags = flags;
+   pool->magazines = NULL;
+   pool->magazine_refills = 0;
+
+   if (flags & VCOS_BLOCKPOOL_FLAG_THREAD_CACHE)
+   {
+      /* Degrade to plain locked operation if no TLS key is available */
+      if (vcos_tls_create(&pool->magazine_tls) != VCOS_SUCCESS)
+      {
+         vcos_log_warn("%s: failed to create TLS key for thread cache",
+               VCOS_FUNCTION);
+         pool->flags &= ~VCOS_BLOCKPOOL_FLAG_THREAD_CACHE;
+      }
+   }
+
    memset(pool->subpools, 0, sizeof(pool->subpools));
 
    vcos_generic_blockpool_subpool_init(pool, &pool->subpools[0], start,
@@ -261,15 +275,13 @@ VCOS_STATUS_T vcos_generic_blockpool_extend(VCOS_BLOCKPOOL_T *pool,
    return VCOS_SUCCESS;
 }
 
-void *vcos_generic_blockpool_alloc(VCOS_BLOCKPOOL_T *pool)
+/** Allocate a block from the subpools. Called with the pool mutex held. */
+static void *vcos_generic_blockpool_alloc_locked(VCOS_BLOCKPOOL_T *pool)
 {
    VCOS_UNSIGNED i;
    void* ret = NULL;
    VCOS_BLOCKPOOL_SUBPOOL_T *subpool = NULL;
 
-   ASSERT_POOL(pool);
-   vcos_mutex_lock(&pool->mutex);
-
    /* Starting with the main pool try and find a free block */
    for (i = 0; i < pool->num_subpools; ++i)
    {
@@ -325,7 +337,6 @@ void *vcos_generic_blockpool_alloc(VCOS_BLOCKPOOL_T *pool)
       ret = nb + 1; /* Return pointer to block data */
       --(subpool->available_blocks);
    }
-   vcos_mutex_unlock(&pool->mutex);
    VCOS_BLOCKPOOL_DEBUG_LOG("pool %p subpool %p ret %p", pool, subpool, ret);
 
    if (ret)
@@ -336,6 +347,112 @@ void *vcos_generic_blockpool_alloc(VCOS_BLOCKPOOL_T *pool)
    return ret;
 }
 
+/** Return a block to the subpool free lists. Called with the pool mutex
+ * held. */
+static void vcos_generic_blockpool_free_locked(VCOS_BLOCKPOOL_T *pool,
+      void *block)
+{
+   VCOS_BLOCKPOOL_HEADER_T* hdr = (VCOS_BLOCKPOOL_HEADER_T*) block - 1;
+   VCOS_BLOCKPOOL_SUBPOOL_T *subpool = hdr->owner.subpool;
+
+   ASSERT_SUBPOOL(subpool);
+   vcos_assert((unsigned) subpool->available_blocks < subpool->num_blocks);
+
+   /* Change ownership of block to be the free list */
+   hdr->owner.next = subpool->free_list;
+   subpool->free_list = hdr;
+   ++(subpool->available_blocks);
+
+   if (VCOS_BLOCKPOOL_OVERWRITE_ON_FREE)
+      memset(block, 0xBD, pool->block_data_size); /* For debugging */
+
+   if ( (subpool->flags & VCOS_BLOCKPOOL_SUBPOOL_FLAG_EXTENSION) &&
+         subpool->available_blocks == subpool->num_blocks)
+   {
+      VCOS_BLOCKPOOL_DEBUG_LOG("%s: freeing subpool %p mem %p", VCOS_FUNCTION,
+            subpool, subpool->mem);
+      /* Free the sub-pool if it was dynamically allocated */
+      vcos_free(subpool->mem);
+      subpool->mem = NULL;
+      subpool->start = NULL;
+   }
+}
+
+/** Return the calling thread's magazine for this pool, creating it on first
+ * use. Returns NULL if the magazine can't be allocated; callers then fall
+ * back to the shared pool. */
+static VCOS_BLOCKPOOL_MAGAZINE_T *vcos_generic_blockpool_get_magazine(
+      VCOS_BLOCKPOOL_T *pool)
+{
+   VCOS_BLOCKPOOL_MAGAZINE_T *magazine = vcos_tls_get(pool->magazine_tls);
+
+   if (! magazine)
+   {
+      magazine = vcos_malloc(sizeof(*magazine), "vcos blockpool magazine");
+      if (! magazine)
+         return NULL;
+
+      magazine->count = 0;
+      if (vcos_tls_set(pool->magazine_tls, magazine) != VCOS_SUCCESS)
+      {
+         vcos_free(magazine);
+         return NULL;
+      }
+
+      /* Chain onto the pool so delete can reclaim it; there is no TLS
+       * destructor support so this is the only owner list. */
+      vcos_mutex_lock(&pool->mutex);
+      magazine->next = pool->magazines;
+      pool->magazines = magazine;
+      vcos_mutex_unlock(&pool->mutex);
+   }
+   return magazine;
+}
+
+void *vcos_generic_blockpool_alloc(VCOS_BLOCKPOOL_T *pool)
+{
+   void *ret;
+
+   ASSERT_POOL(pool);
+
+   if (pool->flags & VCOS_BLOCKPOOL_FLAG_THREAD_CACHE)
+   {
+      VCOS_BLOCKPOOL_MAGAZINE_T *magazine =
+         vcos_generic_blockpool_get_magazine(pool);
+
+      if (magazine)
+      {
+         if (magazine->count == 0)
+         {
+            /* Batch refill from the shared pool under a single lock
+             * acquisition. Cached blocks keep their headers pointing at
+             * their subpool, so they count as in-use until spilled back. */
+            vcos_mutex_lock(&pool->mutex);
+            while (magazine->count < VCOS_BLOCKPOOL_MAGAZINE_SIZE / 2)
+            {
+               void *block = vcos_generic_blockpool_alloc_locked(pool);
+               if (! block)
+                  break;
+               magazine->blocks[magazine->count++] = block;
+            }
+            if (magazine->count)
+               ++(pool->magazine_refills);
+            vcos_mutex_unlock(&pool->mutex);
+         }
+
+         if (magazine->count)
+            return magazine->blocks[--(magazine->count)];
+         return NULL; /* Pool genuinely exhausted */
+      }
+      /* Fall back to the shared pool if the magazine couldn't be created */
+   }
+
+   vcos_mutex_lock(&pool->mutex);
+   ret = vcos_generic_blockpool_alloc_locked(pool);
+   vcos_mutex_unlock(&pool->mutex);
+   return ret;
+}
+
 void *vcos_generic_blockpool_calloc(VCOS_BLOCKPOOL_T *pool)
 {
    void* ret = vcos_generic_blockpool_alloc(pool);
@@ -357,27 +474,35 @@ void vcos_generic_blockpool_free(void *block)
       pool = subpool->owner;
       ASSERT_POOL(pool);
 
-      vcos_mutex_lock(&pool->mutex);
-      vcos_assert((unsigned) subpool->available_blocks < subpool->num_blocks);
+      if (pool->flags & VCOS_BLOCKPOOL_FLAG_THREAD_CACHE)
+      {
+         VCOS_BLOCKPOOL_MAGAZINE_T *magazine =
+            vcos_generic_blockpool_get_magazine(pool);
 
-      /* Change ownership of block to be the free list */
-      hdr->owner.next = subpool->free_list;
-      subpool->free_list = hdr;
-      ++(subpool->available_blocks);
+         if (magazine)
+         {
+            if (magazine->count == VCOS_BLOCKPOOL_MAGAZINE_SIZE)
+            {
+               /* Spill the whole magazine back to the shared pool under a
+                * single lock acquisition */
+               vcos_mutex_lock(&pool->mutex);
+               while (magazine->count)
+                  vcos_generic_blockpool_free_locked(pool,
+                        magazine->blocks[--(magazine->count)]);
+               vcos_mutex_unlock(&pool->mutex);
+            }
 
-      if (VCOS_BLOCKPOOL_OVERWRITE_ON_FREE)
-         memset(block, 0xBD, pool->block_data_size); /* For debugging */
+            if (VCOS_BLOCKPOOL_OVERWRITE_ON_FREE)
+               memset(block, 0xBD, pool->block_data_size); /* For debugging */
 
-      if ( (subpool->flags & VCOS_BLOCKPOOL_SUBPOOL_FLAG_EXTENSION) &&
-            subpool->available_blocks == subpool->num_blocks)
-      {
-         VCOS_BLOCKPOOL_DEBUG_LOG("%s: freeing subpool %p mem %p", VCOS_FUNCTION,
-               subpool, subpool->mem);
-         /* Free the sub-pool if it was dynamically allocated */
-         vcos_free(subpool->mem);
-         subpool->mem = NULL;
-         subpool->start = NULL;
+            magazine->blocks[magazine->count++] = block;
+            return;
+         }
+         /* Fall back to the shared pool if the magazine couldn't be created */
       }
+
+      vcos_mutex_lock(&pool->mutex);
+      vcos_generic_blockpool_free_locked(pool, block);
       vcos_mutex_unlock(&pool->mutex);
    }
 }
@@ -432,6 +557,22 @@ void vcos_generic_blockpool_delete(VCOS_BLOCKPOOL_T *pool)
       VCOS_UNSIGNED i;
 
       ASSERT_POOL(pool);
+
+      if (pool->flags & VCOS_BLOCKPOOL_FLAG_THREAD_CACHE)
+      {
+         /* Reclaim all per-thread magazines. Any blocks still parked in them
+          * are discarded along with the subpool memory below. */
+         VCOS_BLOCKPOOL_MAGAZINE_T *magazine = pool->magazines;
+         while (magazine)
+         {
+            VCOS_BLOCKPOOL_MAGAZINE_T *next = magazine->next;
+            vcos_free(magazine);
+            magazine = next;
+         }
+         pool->magazines = NULL;
+         vcos_tls_delete(pool->magazine_tls);
+      }
+
       for (i = 0; i < pool->num_subpools; ++i)
       {
          VCOS_BLOCKPOOL_SUBPOOL_T *subpool = &pool->subpools[i];
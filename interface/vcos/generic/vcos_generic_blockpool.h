@@ -69,6 +69,16 @@ extern "C" {
 #define VCOS_BLOCKPOOL_INVALID_HANDLE 0
 #define VCOS_BLOCKPOOL_ALIGN_DEFAULT sizeof(unsigned long)
 #define VCOS_BLOCKPOOL_FLAG_NONE 0
+/** Cache a small per-thread magazine of blocks so the alloc/free fast path
+ * does not take the pool lock. Magazines are refilled from (and spilled back
+ * to) the shared pool in batches under a single lock acquisition. Blocks
+ * parked in a magazine count as in-use for the pool statistics and keep
+ * extension subpools alive; magazines are reclaimed when the pool is
+ * deleted. */
+#define VCOS_BLOCKPOOL_FLAG_THREAD_CACHE (1 << 0)
+
+/** Number of blocks in a per-thread magazine */
+#define VCOS_BLOCKPOOL_MAGAZINE_SIZE 8
 
 typedef struct VCOS_BLOCKPOOL_HEADER_TAG
 {
@@ -81,6 +91,17 @@ typedef struct VCOS_BLOCKPOOL_HEADER_TAG
    } owner;
 } VCOS_BLOCKPOOL_HEADER_T;
 
+/** Small per-thread cache of blocks (see VCOS_BLOCKPOOL_FLAG_THREAD_CACHE) */
+typedef struct VCOS_BLOCKPOOL_MAGAZINE_TAG
+{
+   /** Chain of all magazines of this pool, for reclaim on delete */
+   struct VCOS_BLOCKPOOL_MAGAZINE_TAG *next;
+   /** Number of cached blocks */
+   VCOS_UNSIGNED count;
+   /** The cached blocks (block data pointers) */
+   void *blocks[VCOS_BLOCKPOOL_MAGAZINE_SIZE];
+} VCOS_BLOCKPOOL_MAGAZINE_T;
+
 typedef struct VCOS_BLOCKPOOL_SUBPOOL_TAG
 {
    /** VCOS_BLOCKPOOL_SUBPOOL_MAGIC */
@@ -118,6 +139,12 @@ typedef struct VCOS_BLOCKPOOL_TAG
    size_t block_size;
    /** Name for debugging */
    const char *name;
+   /** TLS key for the per-thread magazine (VCOS_BLOCKPOOL_FLAG_THREAD_CACHE) */
+   VCOS_TLS_KEY_T magazine_tls;
+   /** All magazines ever handed out, so delete can reclaim them */
+   VCOS_BLOCKPOOL_MAGAZINE_T *magazines;
+   /** Debug statistic: number of batch refills from the shared pool */
+   uint32_t magazine_refills;
    /* The number of subpools that may be used */
    VCOS_UNSIGNED num_subpools;
    /** Number of blocks in each dynamically allocated subpool */
@@ -34,8 +34,20 @@ VideoCore OS Abstraction Layer - event flags implemented via mutexes
 
 #include <stddef.h>
 
+/** Membership of one waiter in one per-bit bucket. Doubly linked so a
+  * satisfied waiter can be unlinked from all its buckets in O(1) each.
+  */
+typedef struct VCOS_EVENT_WAITER_LINK_T
+{
+   struct VCOS_EVENT_WAITER_T *waiter;
+   struct VCOS_EVENT_WAITER_LINK_T *prev;
+   struct VCOS_EVENT_WAITER_LINK_T *next;
+} VCOS_EVENT_WAITER_LINK_T;
+
 /** A structure created by a thread that waits on the event flags
-  * for a particular combination of flags to arrive.
+  * for a particular combination of flags to arrive. It is enrolled in the
+  * bucket of every bit it requested, so setters only ever visit waiters
+  * which are actually interested in the bits they set.
   */
 typedef struct VCOS_EVENT_WAITER_T
 {
@@ -45,7 +57,8 @@ typedef struct VCOS_EVENT_WAITER_T
    VCOS_STATUS_T return_status;     /**< The return status the waiter should pass back */
    VCOS_EVENT_FLAGS_T *flags;       /**< Pointer to the original 'flags' structure */
    VCOS_THREAD_T *thread;           /**< Thread waiting */
-   struct VCOS_EVENT_WAITER_T *next;
+   int queued;                      /**< Still enrolled in the buckets */
+   VCOS_EVENT_WAITER_LINK_T links[VCOS_EVENT_FLAGS_BUCKETS]; /**< One link per requested bit */
 } VCOS_EVENT_WAITER_T;
 
 #ifndef NDEBUG
@@ -53,16 +66,74 @@ static int waiter_list_valid(VCOS_EVENT_FLAGS_T *flags);
 #endif
 static void event_flags_timer_expired(void *cxt);
 
+/** Enroll a waiter in the bucket of each bit it requested. Tail append
+  * keeps FIFO order within a bucket. Called with the lock held.
+  */
+static void event_flags_enqueue_waiter(VCOS_EVENT_FLAGS_T *flags, VCOS_EVENT_WAITER_T *waiter)
+{
+   VCOS_UNSIGNED bits = waiter->requested_events;
+   unsigned bit;
+
+   for (bit = 0; bits; bit++, bits >>= 1)
+   {
+      VCOS_EVENT_WAITER_LINK_T *link = &waiter->links[bit];
+
+      if (!(bits & 1))
+         continue;
+
+      link->waiter = waiter;
+      link->prev = flags->buckets[bit].tail;
+      link->next = NULL;
+      if (link->prev)
+         link->prev->next = link;
+      else
+         flags->buckets[bit].head = link;
+      flags->buckets[bit].tail = link;
+   }
+   waiter->queued = 1;
+}
+
+/** Remove a waiter from all the buckets it is enrolled in. Called with the
+  * lock held.
+  */
+static void event_flags_dequeue_waiter(VCOS_EVENT_FLAGS_T *flags, VCOS_EVENT_WAITER_T *waiter)
+{
+   VCOS_UNSIGNED bits = waiter->requested_events;
+   unsigned bit;
+
+   for (bit = 0; bits; bit++, bits >>= 1)
+   {
+      VCOS_EVENT_WAITER_LINK_T *link = &waiter->links[bit];
+
+      if (!(bits & 1))
+         continue;
+
+      if (link->prev)
+         link->prev->next = link->next;
+      else
+         flags->buckets[bit].head = link->next;
+      if (link->next)
+         link->next->prev = link->prev;
+      else
+         flags->buckets[bit].tail = link->prev;
+   }
+   waiter->queued = 0;
+}
+
 VCOS_STATUS_T vcos_generic_event_flags_create(VCOS_EVENT_FLAGS_T *flags, const char *name)
 {
    VCOS_STATUS_T rc;
+   unsigned bit;
+
    if ((rc=vcos_mutex_create(&flags->lock, name)) != VCOS_SUCCESS)
    {
       return rc;
    }
 
    flags->events = 0;
-   flags->waiters.head = flags->waiters.tail = 0;
+   flags->waiter_count = 0;
+   for (bit = 0; bit < VCOS_EVENT_FLAGS_BUCKETS; bit++)
+      flags->buckets[bit].head = flags->buckets[bit].tail = 0;
    return rc;
 }
 
@@ -71,77 +142,94 @@ void vcos_generic_event_flags_set(VCOS_EVENT_FLAGS_T *flags,
                                   VCOS_OPTION op)
 {
    vcos_assert(flags);
-   vcos_mutex_lock(&flags->lock);
+
+   /* Update the flag word atomically, without taking the lock. Getters
+    * advertise themselves in waiter_count (with a full barrier) before they
+    * examine the flag word, so if no waiter is visible after our update
+    * there is nobody to wake and the lock can be skipped entirely. If a
+    * waiter is visible we fall into the locked wakeup walk, which the lock
+    * orders against the waiter going to sleep.
+    */
    if (op == VCOS_OR)
    {
-      flags->events |= bitmask;
+      __sync_fetch_and_or(&flags->events, bitmask);
    }
    else if (op == VCOS_AND)
    {
-      flags->events &= bitmask;
+      __sync_fetch_and_and(&flags->events, bitmask);
    }
    else
    {
       vcos_assert(0);
    }
 
-   /* Now wake up any threads that have now become signalled. */
-   if (flags->waiters.head != NULL)
+   /* Clearing bits can never newly satisfy a waiter (satisfaction is a
+    * monotonic function of the set bits), so only OR sets need a wakeup
+    * walk. */
+   if (op != VCOS_OR || flags->waiter_count == 0)
+   {
+      return;
+   }
+
+   vcos_mutex_lock(&flags->lock);
+
+   /* Now wake up any threads that have now become signalled. Only the
+    * buckets of the bits we set can contain them, so the walk is
+    * proportional to the waiters affected rather than all waiters. */
    {
       VCOS_UNSIGNED consumed_events = 0;
-      VCOS_EVENT_WAITER_T **pcurrent_waiter = &flags->waiters.head;
-      VCOS_EVENT_WAITER_T *prev_waiter = NULL;
+      VCOS_UNSIGNED bits = bitmask;
+      unsigned bit;
 
-      /* Walk the chain of tasks suspend on this event flag group to determine
-       * if any of their requests can be satisfied.
-       */
-      while ((*pcurrent_waiter) != NULL)
+      for (bit = 0; bits; bit++, bits >>= 1)
       {
-         VCOS_EVENT_WAITER_T *curr_waiter = *pcurrent_waiter;
+         VCOS_EVENT_WAITER_LINK_T *link, *next;
 
-         /* Determine if this request has been satisfied */
+         if (!(bits & 1))
+            continue;
 
-         /* First, find the event flags in common. */
-         VCOS_UNSIGNED waiter_satisfied = flags->events & curr_waiter->requested_events;
-
-         /* Second, determine if all the event flags must match */
-         if (curr_waiter->op & VCOS_AND)
+         for (link = flags->buckets[bit].head; link != NULL; link = next)
          {
-            /* All requested events must be present */
-            waiter_satisfied = (waiter_satisfied == curr_waiter->requested_events);
-         }
+            VCOS_EVENT_WAITER_T *curr_waiter = link->waiter;
+            VCOS_UNSIGNED waiter_satisfied;
 
-         /* Wake this one up? */
-         if (waiter_satisfied)
-         {
+            /* A satisfied waiter is unlinked from every bucket, so grab the
+             * successor in this one first */
+            next = link->next;
 
-            if (curr_waiter->op & VCOS_CONSUME)
+            /* Determine if this request has been satisfied */
+
+            /* First, find the event flags in common. */
+            waiter_satisfied = flags->events & curr_waiter->requested_events;
+
+            /* Second, determine if all the event flags must match */
+            if (curr_waiter->op & VCOS_AND)
             {
-               consumed_events |= curr_waiter->requested_events;
+               /* All requested events must be present */
+               waiter_satisfied = (waiter_satisfied == curr_waiter->requested_events);
             }
 
-            /* remove this block from the list, taking care at the end */
-            *pcurrent_waiter = curr_waiter->next;
-            if (curr_waiter->next == NULL)
-               flags->waiters.tail = prev_waiter;
+            /* Wake this one up? */
+            if (waiter_satisfied)
+            {
+               if (curr_waiter->op & VCOS_CONSUME)
+               {
+                  consumed_events |= curr_waiter->requested_events;
+               }
 
-            vcos_assert(waiter_list_valid(flags));
+               event_flags_dequeue_waiter(flags, curr_waiter);
 
-            curr_waiter->return_status = VCOS_SUCCESS;
-            curr_waiter->actual_events = flags->events;
+               vcos_assert(waiter_list_valid(flags));
 
-            _vcos_thread_sem_post(curr_waiter->thread);
-         }
-         else
-         {
-            /* move to next element in the list */
-            prev_waiter = *pcurrent_waiter;
-            pcurrent_waiter = &(curr_waiter->next);
+               curr_waiter->return_status = VCOS_SUCCESS;
+               curr_waiter->actual_events = flags->events;
+
+               _vcos_thread_sem_post(curr_waiter->thread);
+            }
          }
       }
 
-      flags->events &= ~consumed_events;
-
+      __sync_fetch_and_and(&flags->events, ~consumed_events);
    }
 
    vcos_mutex_unlock(&flags->lock);
@@ -167,6 +255,12 @@ extern VCOS_STATUS_T vcos_generic_event_flags_get(VCOS_EVENT_FLAGS_T *flags,
    /* default retrieved bits to 0 */
    *retrieved_bits = 0;
 
+   /* advertise ourselves before examining the flag word, so that a setter
+    * updating it lock-free either sees us and takes its wakeup walk, or we
+    * see its update -- see vcos_generic_event_flags_set
+    */
+   __sync_fetch_and_add(&flags->waiter_count, 1);
+
    vcos_mutex_lock(&flags->lock);
    switch (op & VCOS_EVENT_FLAG_OP_MASK)
    {
@@ -177,7 +271,7 @@ extern VCOS_STATUS_T vcos_generic_event_flags_get(VCOS_EVENT_FLAGS_T *flags,
          rc = VCOS_SUCCESS;
          satisfied = 1;
          if (op & VCOS_CONSUME)
-            flags->events &= ~bitmask;
+            __sync_fetch_and_and(&flags->events, ~bitmask);
       }
       break;
 
@@ -188,7 +282,7 @@ extern VCOS_STATUS_T vcos_generic_event_flags_get(VCOS_EVENT_FLAGS_T *flags,
          rc = VCOS_SUCCESS;
          satisfied = 1;
          if (op & VCOS_CONSUME)
-            flags->events &= ~bitmask;
+            __sync_fetch_and_and(&flags->events, ~bitmask);
       }
       break;
 
@@ -202,7 +296,7 @@ extern VCOS_STATUS_T vcos_generic_event_flags_get(VCOS_EVENT_FLAGS_T *flags,
    {
       /* Have to go to sleep.
        *
-       * Append to tail so we get FIFO ordering.
+       * Appending to the bucket tails gives FIFO ordering per bucket.
        */
       waitreq.requested_events = bitmask;
       waitreq.op = op;
@@ -210,9 +304,8 @@ extern VCOS_STATUS_T vcos_generic_event_flags_get(VCOS_EVENT_FLAGS_T *flags,
       waitreq.flags = flags;
       waitreq.actual_events = 0;
       waitreq.thread = vcos_thread_current();
-      waitreq.next = 0;
       vcos_assert(waitreq.thread != (VCOS_THREAD_T*)-1);
-      VCOS_QUEUE_APPEND_TAIL(&flags->waiters, &waitreq);
+      event_flags_enqueue_waiter(flags, &waitreq);
 
       if (suspend != (VCOS_UNSIGNED)-1)
          _vcos_task_timer_set(event_flags_timer_expired, &waitreq, suspend);
@@ -237,6 +330,8 @@ extern VCOS_STATUS_T vcos_generic_event_flags_get(VCOS_EVENT_FLAGS_T *flags,
       vcos_mutex_unlock(&flags->lock);
    }
 
+   __sync_fetch_and_sub(&flags->waiter_count, 1);
+
    return rc;
 }
 
@@ -248,39 +343,19 @@ static void event_flags_timer_expired(void *cxt)
 {
    VCOS_EVENT_WAITER_T *waitreq = (VCOS_EVENT_WAITER_T *)cxt;
    VCOS_EVENT_FLAGS_T *flags = waitreq->flags;
-   VCOS_EVENT_WAITER_T **plist;
-   VCOS_EVENT_WAITER_T *prev = NULL;
    VCOS_THREAD_T *thread = 0;
 
    vcos_assert(flags);
 
    vcos_mutex_lock(&flags->lock);
 
-   /* walk the list of waiting threads on this event group, and remove
-    * the one that has expired.
-    *
-    * FIXME: could use doubly-linked list if lots of threads are found
-    * to be waiting on a single event flag instance.
+   /* Only dequeue and wake if the waiter is still enrolled - a setter may
+    * have satisfied it just before the timer fired.
     */
-   plist = &flags->waiters.head;
-   while (*plist != NULL)
+   if (waitreq->queued)
    {
-      if (*plist == waitreq)
-      {
-         int at_end;
-         /* found it */
-         thread = (*plist)->thread;
-         at_end = ((*plist)->next == NULL);
-
-         /* link past */
-         *plist = (*plist)->next;
-         if (at_end)
-            flags->waiters.tail = prev;
-
-         break;
-      }
-      prev = *plist;
-      plist = &(*plist)->next;
+      event_flags_dequeue_waiter(flags, waitreq);
+      thread = waitreq->thread;
    }
    vcos_assert(waiter_list_valid(flags));
 
@@ -296,23 +371,31 @@ static void event_flags_timer_expired(void *cxt)
 
 static int waiter_list_valid(VCOS_EVENT_FLAGS_T *flags)
 {
-   int valid;
-   /* Either both head and tail are NULL, or neither are NULL */
-   if (flags->waiters.head == NULL)
-   {
-      valid = (flags->waiters.tail == NULL);
-   }
-   else
-   {
-      valid = (flags->waiters.tail != NULL);
-   }
+   int valid = 1;
+   unsigned bit;
 
-   /* If head and tail point at the same non-NULL element, then there
-    * is only one element in the list.
-    */
-   if (flags->waiters.head && (flags->waiters.head == flags->waiters.tail))
+   for (bit = 0; bit < VCOS_EVENT_FLAGS_BUCKETS; bit++)
    {
-      valid = (flags->waiters.head->next == NULL);
+      VCOS_EVENT_WAITER_LINK_T *head = flags->buckets[bit].head;
+      VCOS_EVENT_WAITER_LINK_T *tail = flags->buckets[bit].tail;
+
+      /* Either both head and tail are NULL, or neither are NULL */
+      if (head == NULL)
+      {
+         valid = valid && (tail == NULL);
+      }
+      else
+      {
+         valid = valid && (tail != NULL);
+      }
+
+      /* If head and tail point at the same non-NULL element, then there
+       * is only one element in the bucket.
+       */
+      if (head && (head == tail))
+      {
+         valid = valid && (head->next == NULL);
+      }
    }
    return valid;
 }
@@ -60,16 +60,23 @@ extern "C" {
   */
 
 struct VCOS_EVENT_WAITER_T;
+struct VCOS_EVENT_WAITER_LINK_T;
+
+/** Number of waiter buckets, one per bit of the flag word */
+#define VCOS_EVENT_FLAGS_BUCKETS (sizeof(VCOS_UNSIGNED)*8)
 
 typedef struct VCOS_EVENT_FLAGS_T
 {
-   VCOS_UNSIGNED events;      /**< Events currently set */
-   VCOS_MUTEX_T lock;         /**< Serialize access */
+   VCOS_UNSIGNED events;      /**< Events currently set, updated atomically */
+   volatile VCOS_UNSIGNED waiter_count; /**< Threads inside a get call; lets setters skip the lock when nobody can be waiting */
+   VCOS_MUTEX_T lock;         /**< Serialize access to the waiter buckets */
+   /** Waiters are indexed by the flag bits they requested, so a setter only
+     * walks the buckets of the bits it set rather than every waiter */
    struct
    {
-      struct VCOS_EVENT_WAITER_T *head;   /**< List of threads waiting */
-      struct VCOS_EVENT_WAITER_T *tail;   /**< List of threads waiting */
-   } waiters;
+      struct VCOS_EVENT_WAITER_LINK_T *head;
+      struct VCOS_EVENT_WAITER_LINK_T *tail;
+   } buckets[VCOS_EVENT_FLAGS_BUCKETS];
 } VCOS_EVENT_FLAGS_T;
 
 #define VCOS_OR      1
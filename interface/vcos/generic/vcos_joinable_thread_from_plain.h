@@ -163,6 +163,20 @@ void vcos_thread_attr_setaffinity(VCOS_THREAD_ATTR_T *attrs, VCOS_UNSIGNED affin
    attrs->ta_affinity = affinity;
 }
 
+VCOS_INLINE_IMPL
+void vcos_thread_attr_setschedpolicy(VCOS_THREAD_ATTR_T *attrs, VCOS_UNSIGNED policy) {
+   /* no kernel scheduler classes here */
+   vcos_unused(attrs);
+   vcos_unused(policy);
+}
+
+VCOS_INLINE_IMPL
+void vcos_thread_attr_setcpuset(VCOS_THREAD_ATTR_T *attrs, VCOS_UNSIGNED cpuset) {
+   /* no per-cpu scheduling here */
+   vcos_unused(attrs);
+   vcos_unused(cpuset);
+}
+
 VCOS_INLINE_IMPL
 void vcos_thread_attr_settimeslice(VCOS_THREAD_ATTR_T *attrs, VCOS_UNSIGNED ts) {
    attrs->ta_timeslice = ts;
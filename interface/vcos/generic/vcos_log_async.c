@@ -0,0 +1,320 @@
+/*
+Copyright (c) 2012, Broadcom Europe Ltd
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*=============================================================================
+VCOS - asynchronous (ring-buffered) logging backend.
+=============================================================================*/
+
+#include "interface/vcos/vcos.h"
+#include "interface/vcos/vcos_string.h"
+#include "interface/vcos/generic/vcos_log_async.h"
+
+#include <string.h>
+
+/** Number of records in the ring. Must be a power of two. */
+#define LOG_ASYNC_RECORDS        512
+
+/** Maximum number of captured argument words in deferred mode */
+#define LOG_ASYNC_MAX_ARGS       8
+
+/** Size of the inline text area for preformatted records */
+#define LOG_ASYNC_TEXT_SIZE      128
+
+/** How long the drain thread sleeps (ms) when woken spuriously or while a
+ * producer is mid-publish */
+#define LOG_ASYNC_DRAIN_WAIT_MS  10
+
+#define LOG_ASYNC_WAKE_EVENT     1
+
+typedef struct LOG_ASYNC_RECORD_T
+{
+   /** claim ticket + 1 once the record is published, 0 once consumed */
+   volatile uint32_t seq;
+   const VCOS_LOG_CAT_T *cat;
+   VCOS_LOG_LEVEL_T level;
+   /** Format for deferred rendering, or NULL if text[] is preformatted */
+   const char *fmt;
+   /** Captured argument words for deferred rendering */
+   unsigned long args[LOG_ASYNC_MAX_ARGS];
+   /** Preformatted message text, when deferring was not possible */
+   char text[LOG_ASYNC_TEXT_SIZE];
+} LOG_ASYNC_RECORD_T;
+
+static LOG_ASYNC_RECORD_T log_async_ring[LOG_ASYNC_RECORDS];
+
+/** Next ticket to claim; advanced by producers with compare-and-swap */
+static volatile uint32_t log_async_head;
+/** Next ticket to consume; written only by the drain thread */
+static volatile uint32_t log_async_tail;
+/** Records discarded because the ring was full */
+static volatile uint32_t log_async_dropped;
+
+static VCOS_EVENT_FLAGS_T log_async_wake;
+static VCOS_THREAD_T log_async_thread;
+static volatile int log_async_running;
+static int log_async_inited;
+
+/** Decide whether a format can be rendered later from captured argument
+ * words. Rejects conversions whose arguments are not a single word on the
+ * hot path (floating point, long long) and indirect widths, as well as %s
+ * which only captures a pointer: the string itself can be gone by the time
+ * the drain thread renders the record. Counts the arguments so the capture
+ * loop knows how many words to save.
+ */
+static int log_async_fmt_deferrable(const char *fmt, unsigned *nargs)
+{
+   unsigned n = 0;
+   const char *p = fmt;
+
+   while ((p = strchr(p, '%')) != NULL)
+   {
+      p++;
+      if (*p == '%')
+      {
+         p++;
+         continue;
+      }
+
+      while (*p == '-' || *p == '+' || *p == ' ' || *p == '#' || *p == '0')
+         p++;
+      if (*p == '*')
+         return 0;
+      while (*p >= '0' && *p <= '9')
+         p++;
+      if (*p == '.')
+      {
+         p++;
+         if (*p == '*')
+            return 0;
+         while (*p >= '0' && *p <= '9')
+            p++;
+      }
+
+      if (*p == 'l')
+      {
+         p++;
+         if (*p == 'l')
+            return 0;
+      }
+      else if (*p == 'h')
+      {
+         p++;
+         if (*p == 'h')
+            p++;
+      }
+      else if (*p == 'z' || *p == 't')
+      {
+         p++;
+      }
+      else if (*p == 'j' || *p == 'q' || *p == 'L')
+      {
+         return 0;
+      }
+
+      switch (*p)
+      {
+      case 'd': case 'i': case 'u': case 'o': case 'x': case 'X':
+      case 'c': case 'p':
+         n++;
+         p++;
+         break;
+      default:
+         /* Includes %s: deferring it would capture the pointer but not the
+          * characters, and transient strings are the common case */
+         return 0;
+      }
+   }
+
+   if (n > LOG_ASYNC_MAX_ARGS)
+      return 0;
+
+   *nargs = n;
+   return 1;
+}
+
+/** varargs shim so the drain thread can hand rendered or deferred records
+ * to the default backend */
+static void log_async_emit(const VCOS_LOG_CAT_T *cat, VCOS_LOG_LEVEL_T level,
+                           const char *fmt, ...)
+{
+   va_list ap;
+   va_start(ap, fmt);
+   vcos_vlog_default_impl(cat, level, fmt, ap);
+   va_end(ap);
+}
+
+static void log_async_render(LOG_ASYNC_RECORD_T *rec)
+{
+   if (rec->fmt)
+   {
+      /* Passing all argument slots is harmless; the format consumes only
+       * what it declares. Word-sized conversions were guaranteed when the
+       * record was captured. */
+      log_async_emit(rec->cat, rec->level, rec->fmt,
+            rec->args[0], rec->args[1], rec->args[2], rec->args[3],
+            rec->args[4], rec->args[5], rec->args[6], rec->args[7]);
+   }
+   else
+   {
+      log_async_emit(rec->cat, rec->level, "%s", rec->text);
+   }
+}
+
+static void *log_async_drain_thread(void *arg)
+{
+   uint32_t reported_drops = 0;
+
+   vcos_unused(arg);
+
+   while (1)
+   {
+      VCOS_UNSIGNED events;
+      uint32_t drops;
+
+      while (log_async_tail != log_async_head)
+      {
+         LOG_ASYNC_RECORD_T *rec =
+            &log_async_ring[log_async_tail & (LOG_ASYNC_RECORDS - 1)];
+
+         if (rec->seq != log_async_tail + 1)
+            break; /* producer still mid-publish - come back shortly */
+
+         log_async_render(rec);
+         rec->seq = 0;
+         __sync_synchronize();
+         log_async_tail++;
+      }
+
+      drops = log_async_dropped;
+      if (drops != reported_drops)
+      {
+         log_async_emit(vcos_log_get_default_category(), VCOS_LOG_WARN,
+               "vcos_log_async: dropped %u messages",
+               (unsigned)(drops - reported_drops));
+         reported_drops = drops;
+      }
+
+      if (!log_async_running && log_async_tail == log_async_head)
+         break;
+
+      vcos_event_flags_get(&log_async_wake, LOG_ASYNC_WAKE_EVENT,
+            VCOS_OR_CONSUME, LOG_ASYNC_DRAIN_WAIT_MS, &events);
+   }
+
+   return NULL;
+}
+
+static void vcos_vlog_async_impl(const VCOS_LOG_CAT_T *cat,
+                                 VCOS_LOG_LEVEL_T _level,
+                                 const char *fmt, va_list args)
+{
+   LOG_ASYNC_RECORD_T *rec;
+   uint32_t ticket;
+   unsigned nargs = 0;
+   unsigned i;
+   int deferred = log_async_fmt_deferrable(fmt, &nargs);
+
+   /* Claim a slot; drop rather than block or overwrite unread records */
+   do
+   {
+      ticket = log_async_head;
+      if (ticket - log_async_tail >= LOG_ASYNC_RECORDS)
+      {
+         __sync_fetch_and_add(&log_async_dropped, 1);
+         return;
+      }
+   } while (!__sync_bool_compare_and_swap(&log_async_head, ticket, ticket + 1));
+
+   rec = &log_async_ring[ticket & (LOG_ASYNC_RECORDS - 1)];
+   rec->cat = cat;
+   rec->level = _level;
+
+   if (deferred)
+   {
+      rec->fmt = fmt;
+      for (i = 0; i < nargs; i++)
+         rec->args[i] = va_arg(args, unsigned long);
+   }
+   else
+   {
+      rec->fmt = NULL;
+      vcos_vsnprintf(rec->text, sizeof(rec->text), fmt, args);
+   }
+
+   /* Publish: the record contents must be visible before the sequence */
+   __sync_synchronize();
+   rec->seq = ticket + 1;
+
+   vcos_event_flags_set(&log_async_wake, LOG_ASYNC_WAKE_EVENT, VCOS_OR);
+}
+
+VCOS_STATUS_T vcos_log_async_init(void)
+{
+   VCOS_STATUS_T status;
+
+   if (log_async_inited)
+      return VCOS_SUCCESS;
+
+   memset(log_async_ring, 0, sizeof(log_async_ring));
+   log_async_head = log_async_tail = log_async_dropped = 0;
+
+   status = vcos_event_flags_create(&log_async_wake, "vcos_log_async");
+   if (status != VCOS_SUCCESS)
+      goto fail_flags;
+
+   log_async_running = 1;
+   status = vcos_thread_create(&log_async_thread, "vcos_logd", NULL,
+         log_async_drain_thread, NULL);
+   if (status != VCOS_SUCCESS)
+      goto fail_thread;
+
+   vcos_set_vlog_impl(vcos_vlog_async_impl);
+   log_async_inited = 1;
+   return status;
+
+fail_thread:
+   log_async_running = 0;
+   vcos_event_flags_delete(&log_async_wake);
+fail_flags:
+   return status;
+}
+
+void vcos_log_async_deinit(void)
+{
+   if (!log_async_inited)
+      return;
+
+   /* Route new messages synchronously again, then flush the backlog */
+   vcos_set_vlog_impl(NULL);
+
+   log_async_running = 0;
+   vcos_event_flags_set(&log_async_wake, LOG_ASYNC_WAKE_EVENT, VCOS_OR);
+   vcos_thread_join(&log_async_thread, NULL);
+
+   vcos_event_flags_delete(&log_async_wake);
+   log_async_inited = 0;
+}
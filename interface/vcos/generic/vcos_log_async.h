@@ -0,0 +1,81 @@
+/*
+Copyright (c) 2012, Broadcom Europe Ltd
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*=============================================================================
+VCOS - asynchronous (ring-buffered) logging backend.
+=============================================================================*/
+
+#ifndef VCOS_LOG_ASYNC_H
+#define VCOS_LOG_ASYNC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "interface/vcos/vcos_types.h"
+
+/**
+ * \file
+ *
+ * An asynchronous backend for vcos logging. The default backend formats
+ * and writes on the calling thread, which costs enough that enabling
+ * trace logging on a hot path (e.g. mmal_port) perturbs the timing being
+ * investigated. This backend instead stores records in a lock-free ring
+ * buffer and hands them to a background drain thread which renders and
+ * writes the text using the default backend.
+ *
+ * Where the format string allows it, only the format pointer and argument
+ * words are captured and formatting itself is deferred to the drain
+ * thread, so the hot-path cost is a slot claim and a few word copies.
+ * Formats using floating point, 64-bit or indirect-width conversions are
+ * formatted on the calling thread into the record instead, but the write
+ * is still deferred.
+ *
+ * Caveats of deferred formatting:
+ *  - format strings must outlive the drain (string literals always do);
+ *  - %s arguments must remain valid until drained - in practice records
+ *    are drained within a few milliseconds;
+ *  - timestamps/ordering reflect when a record was drained, not logged.
+ *
+ * If producers outrun the drain thread, records are dropped rather than
+ * blocking the caller; the drain thread reports how many were lost.
+ */
+
+/** Install the asynchronous backend. Starts the drain thread and routes
+ * vcos_log_impl/vcos_vlog_impl through the ring buffer.
+ */
+VCOSPRE_ VCOS_STATUS_T VCOSPOST_ vcos_log_async_init(void);
+
+/** Drain any outstanding records, restore the default synchronous
+ * backend and stop the drain thread.
+ */
+VCOSPRE_ void VCOSPOST_ vcos_log_async_deinit(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* VCOS_LOG_ASYNC_H */
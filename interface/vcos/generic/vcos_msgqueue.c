@@ -183,6 +183,48 @@ void vcos_msg_send_helper(VCOS_MSG_WAITER_T *waiter,
    vcos_semaphore_post(&dest->sem);
 }
 
+void vcos_msgq_send_batch(VCOS_MSGQUEUE_T *dest,
+                          uint32_t code,
+                          VCOS_MSG_T **msgs,
+                          VCOS_UNSIGNED count)
+{
+   VCOS_UNSIGNED i;
+
+   vcos_assert(dest);
+   vcos_assert(msgs || count == 0);
+
+   if (count == 0)
+      return;
+
+   /* Link the whole batch onto the queue under one lock acquisition */
+   vcos_mutex_lock(&dest->lock);
+   for (i = 0; i < count; i++)
+   {
+      VCOS_MSG_T *msg = msgs[i];
+      vcos_assert(msg && msg->magic == MAGIC);
+
+      msg->code = code;
+      msg->next = NULL;
+      msg->src_thread = vcos_thread_current();
+
+      if (dest->head == NULL)
+      {
+         dest->head = dest->tail = msg;
+      }
+      else
+      {
+         dest->tail->next = msg;
+         dest->tail = msg;
+      }
+   }
+   vcos_mutex_unlock(&dest->lock);
+
+   /* The semaphore counts messages, so it still needs one post per
+    * message; a receiver in vcos_msgq_receive_batch only sleeps once. */
+   for (i = 0; i < count; i++)
+      vcos_semaphore_post(&dest->sem);
+}
+
 /* wait on a queue for a message */
 VCOS_MSG_T *vcos_msg_wait(VCOS_MSGQUEUE_T *queue)
 {
@@ -201,6 +243,42 @@ VCOS_MSG_T *vcos_msg_wait(VCOS_MSGQUEUE_T *queue)
    return msg;
 }
 
+VCOS_UNSIGNED vcos_msgq_receive_batch(VCOS_MSGQUEUE_T *queue,
+                                      VCOS_MSG_T **msgs,
+                                      VCOS_UNSIGNED max_msgs)
+{
+   VCOS_UNSIGNED n = 0;
+
+   vcos_assert(msgs);
+   vcos_assert(max_msgs > 0);
+
+   /* Block for the first message only */
+   vcos_semaphore_wait(&queue->sem);
+   vcos_mutex_lock(&queue->lock);
+
+   do
+   {
+      VCOS_MSG_T *msg = queue->head;
+      vcos_assert(msg);    /* should always be a message here! */
+
+      queue->head = msg->next;
+      if (queue->head == NULL)
+         queue->tail = NULL;
+
+      msgs[n++] = msg;
+
+      /* keep the semaphore count consistent while draining the backlog */
+
+      /* coverity[lock_order]
+       * the semaphore must have a non-zero count so cannot block here.
+       */
+   } while (n < max_msgs && queue->head &&
+         vcos_semaphore_trywait(&queue->sem) == VCOS_SUCCESS);
+
+   vcos_mutex_unlock(&queue->lock);
+   return n;
+}
+
 /* peek on a queue for a message */
 VCOS_MSG_T *vcos_msg_peek(VCOS_MSGQUEUE_T *queue)
 {
@@ -277,6 +355,14 @@ void vcos_msg_reply(VCOS_MSG_T *msg)
    }
 }
 
+void vcos_msg_set_payload(VCOS_MSG_T *msg, void *payload, size_t size)
+{
+   vcos_assert(msg);
+   vcos_assert(msg->magic == MAGIC);
+   msg->payload = payload;
+   msg->payload_size = payload ? size : 0;
+}
+
 void vcos_msg_set_source(VCOS_MSG_T *msg, VCOS_MSGQUEUE_T *queue)
 {
    vcos_assert(msg);
@@ -386,4 +472,6 @@ void vcos_msg_init(VCOS_MSG_T *msg)
    msg->next = NULL;
    msg->waiter = NULL;
    msg->pool = NULL;
+   msg->payload = NULL;
+   msg->payload_size = 0;
 }
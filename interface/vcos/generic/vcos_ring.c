@@ -0,0 +1,196 @@
+/*
+Copyright (c) 2012, Broadcom Europe Ltd
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*=============================================================================
+VCOS - bounded lock-free multi-producer multi-consumer ring of pointers.
+
+The slot-sequence scheme: slot i starts with seq == i. A producer may
+fill position pos when its slot's seq == pos, and publishes by setting
+seq = pos + 1. A consumer may empty position pos when seq == pos + 1,
+and releases the slot for the next lap by setting seq = pos + slots.
+Positions are claimed with a compare-and-swap on the shared cursor, so
+producers never wait on consumers (or vice versa) and neither takes a
+lock.
+=============================================================================*/
+
+#include "interface/vcos/vcos.h"
+#include "interface/vcos/vcos_ring.h"
+
+#include <string.h>
+
+static int is_pow2(VCOS_UNSIGNED n)
+{
+   return n != 0 && (n & (n - 1)) == 0;
+}
+
+VCOS_STATUS_T vcos_ring_create(VCOS_RING_T *ring,
+                               VCOS_UNSIGNED slots,
+                               const char *name)
+{
+   VCOS_UNSIGNED i;
+
+   vcos_assert(ring);
+   if (!is_pow2(slots))
+      return VCOS_EINVAL;
+
+   ring->cells = vcos_malloc(slots * sizeof(VCOS_RING_CELL_T), name);
+   if (!ring->cells)
+      return VCOS_ENOMEM;
+
+   for (i = 0; i < slots; i++)
+   {
+      ring->cells[i].seq = i;
+      ring->cells[i].data = NULL;
+   }
+
+   ring->mask = slots - 1;
+   ring->enqueue_pos = 0;
+   ring->dequeue_pos = 0;
+   ring->event = NULL;
+
+   return VCOS_SUCCESS;
+}
+
+void vcos_ring_delete(VCOS_RING_T *ring)
+{
+   vcos_assert(ring);
+   vcos_free(ring->cells);
+   memset(ring, 0, sizeof(*ring));
+}
+
+void vcos_ring_set_event(VCOS_RING_T *ring, VCOS_EVENT_T *event)
+{
+   ring->event = event;
+}
+
+VCOS_STATUS_T vcos_ring_push(VCOS_RING_T *ring, void *elem)
+{
+   VCOS_RING_CELL_T *cell;
+   uint32_t pos;
+
+   for (;;)
+   {
+      uint32_t seq;
+      pos = ring->enqueue_pos;
+      cell = &ring->cells[pos & ring->mask];
+      seq = cell->seq;
+
+      if (seq == pos)
+      {
+         if (__sync_bool_compare_and_swap(&ring->enqueue_pos, pos, pos + 1))
+            break;
+         /* another producer took this position - retry */
+      }
+      else if ((int32_t)(seq - pos) < 0)
+      {
+         /* the slot is still full from the previous lap */
+         return VCOS_ENOSPC;
+      }
+      /* else the cursor moved under us - reload and retry */
+   }
+
+   cell->data = elem;
+   /* publish: the data must be visible before the sequence advances */
+   __sync_synchronize();
+   cell->seq = pos + 1;
+
+   if (ring->event)
+      vcos_event_signal(ring->event);
+
+   return VCOS_SUCCESS;
+}
+
+void *vcos_ring_pop(VCOS_RING_T *ring)
+{
+   VCOS_RING_CELL_T *cell;
+   uint32_t pos;
+   void *elem;
+
+   for (;;)
+   {
+      uint32_t seq;
+      pos = ring->dequeue_pos;
+      cell = &ring->cells[pos & ring->mask];
+      seq = cell->seq;
+
+      if (seq == pos + 1)
+      {
+         if (__sync_bool_compare_and_swap(&ring->dequeue_pos, pos, pos + 1))
+            break;
+         /* another consumer took this position - retry */
+      }
+      else if ((int32_t)(seq - (pos + 1)) < 0)
+      {
+         /* nothing published here yet */
+         return NULL;
+      }
+      /* else the cursor moved under us - reload and retry */
+   }
+
+   elem = cell->data;
+   /* release the slot for the producers' next lap */
+   __sync_synchronize();
+   cell->seq = pos + ring->mask + 1;
+
+   return elem;
+}
+
+VCOS_UNSIGNED vcos_ring_push_batch(VCOS_RING_T *ring,
+                                   void **elems,
+                                   VCOS_UNSIGNED count)
+{
+   VCOS_UNSIGNED n;
+
+   for (n = 0; n < count; n++)
+   {
+      if (vcos_ring_push(ring, elems[n]) != VCOS_SUCCESS)
+         break;
+   }
+   return n;
+}
+
+VCOS_UNSIGNED vcos_ring_pop_batch(VCOS_RING_T *ring,
+                                  void **elems,
+                                  VCOS_UNSIGNED max_elems)
+{
+   VCOS_UNSIGNED n;
+
+   for (n = 0; n < max_elems; n++)
+   {
+      void *elem = vcos_ring_pop(ring);
+      if (!elem)
+         break;
+      elems[n] = elem;
+   }
+   return n;
+}
+
+VCOS_UNSIGNED vcos_ring_count(VCOS_RING_T *ring)
+{
+   uint32_t count = ring->enqueue_pos - ring->dequeue_pos;
+   return count <= ring->mask + 1 ? count : 0;
+}
@@ -122,11 +122,9 @@ typedef struct
 
 typedef struct VCOS_TIMER_T
 {
-   pthread_t thread;                      /**< id of the timer thread */
-
-   pthread_mutex_t lock;                  /**< lock protecting all other members of the struct */
-   pthread_cond_t settings_changed;       /**< cond. var. for informing the timer thread about changes*/
-   int quit;                              /**< non-zero if the timer thread is requested to quit*/
+   struct VCOS_TIMER_T *next;             /**< next timer on the armed list, or NULL */
+   struct VCOS_TIMER_T *prev;             /**< previous timer on the armed list, or NULL */
+   int armed;                             /**< non-zero while on the armed list */
 
    struct timespec expires;               /**< absolute time of next expiration, or 0 if disarmed*/
 
@@ -146,6 +144,8 @@ typedef struct VCOS_THREAD_ATTR_T
    VCOS_UNSIGNED ta_affinity;
    VCOS_UNSIGNED ta_timeslice;
    VCOS_UNSIGNED legacy;
+   VCOS_UNSIGNED ta_schedpolicy; /**< VCOS_THREAD_SCHED_xxx scheduling class */
+   VCOS_UNSIGNED ta_cpuset;      /**< Bitmask of cpus to run on, 0 = any */
 } VCOS_THREAD_ATTR_T;
 
 /** Called at thread exit.
@@ -355,6 +355,7 @@ VCOS_STATUS_T vcos_semaphore_post(VCOS_SEMAPHORE_T *sem) {
 extern VCOS_THREAD_T *vcos_dummy_thread_create(void);
 extern pthread_key_t _vcos_thread_current_key;
 extern uint64_t vcos_getmicrosecs64_internal(void);
+extern uint64_t vcos_getmonotonicmicrosecs64_internal(void);
 
 VCOS_INLINE_IMPL
 uint32_t vcos_getmicrosecs(void) { return (uint32_t)vcos_getmicrosecs64_internal(); }
@@ -362,6 +363,12 @@ uint32_t vcos_getmicrosecs(void) { return (uint32_t)vcos_getmicrosecs64_internal
 VCOS_INLINE_IMPL
 uint64_t vcos_getmicrosecs64(void) { return vcos_getmicrosecs64_internal(); }
 
+VCOS_INLINE_IMPL
+uint32_t vcos_getmonotonicmicrosecs(void) { return (uint32_t)vcos_getmonotonicmicrosecs64_internal(); }
+
+VCOS_INLINE_IMPL
+uint64_t vcos_getmonotonicmicrosecs64(void) { return vcos_getmonotonicmicrosecs64_internal(); }
+
 VCOS_INLINE_IMPL
 VCOS_THREAD_T *vcos_thread_current(void) {
    void *ret = pthread_getspecific(_vcos_thread_current_key);
@@ -429,6 +436,16 @@ void vcos_thread_attr_setaffinity(VCOS_THREAD_ATTR_T *attrs, VCOS_UNSIGNED affin
    attrs->ta_affinity = affinity;
 }
 
+VCOS_INLINE_IMPL
+void vcos_thread_attr_setschedpolicy(VCOS_THREAD_ATTR_T *attrs, VCOS_UNSIGNED policy) {
+   attrs->ta_schedpolicy = policy;
+}
+
+VCOS_INLINE_IMPL
+void vcos_thread_attr_setcpuset(VCOS_THREAD_ATTR_T *attrs, VCOS_UNSIGNED cpuset) {
+   attrs->ta_cpuset = cpuset;
+}
+
 VCOS_INLINE_IMPL
 void vcos_thread_attr_settimeslice(VCOS_THREAD_ATTR_T *attrs, VCOS_UNSIGNED ts) {
    attrs->ta_timeslice = ts;
@@ -720,6 +737,7 @@ VCOS_INLINE_DECL void _vcos_thread_sem_post(VCOS_THREAD_T *);
 #define VCOS_APPLICATION_ARGV          vcos_get_argv()
 
 #include "interface/vcos/generic/vcos_generic_reentrant_mtx.h"
+#include "interface/vcos/generic/vcos_generic_adaptive_mtx.h"
 #include "interface/vcos/generic/vcos_generic_named_sem.h"
 #include "interface/vcos/generic/vcos_generic_quickslow_mutex.h"
 #include "interface/vcos/generic/vcos_common.h"
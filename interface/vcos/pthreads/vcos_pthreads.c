@@ -33,6 +33,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <stdlib.h>
 #include <stdio.h>
 #include <sys/time.h>
+#include <sched.h>
 #include <linux/param.h>
 
 /* Cygwin doesn't always have prctl.h and it doesn't have PR_SET_NAME */
@@ -199,6 +200,46 @@ VCOS_STATUS_T vcos_thread_create(VCOS_THREAD_T *thread,
 
    /* pthread_attr_setpriority(&pt_attrs, local_attrs->ta_priority); */
 
+   if (local_attrs->ta_schedpolicy != VCOS_THREAD_SCHED_DEFAULT)
+   {
+      struct sched_param sp;
+      int policy;
+      switch (local_attrs->ta_schedpolicy)
+      {
+      case VCOS_THREAD_SCHED_FIFO: policy = SCHED_FIFO;  break;
+      case VCOS_THREAD_SCHED_RR:   policy = SCHED_RR;    break;
+      default:                     policy = SCHED_OTHER; break;
+      }
+      memset(&sp, 0, sizeof(sp));
+      if (policy != SCHED_OTHER)
+      {
+         /* Map ta_priority onto the policy's priority range */
+         int lo = sched_get_priority_min(policy);
+         int hi = sched_get_priority_max(policy);
+         int pri = (int)local_attrs->ta_priority;
+         sp.sched_priority = pri < lo ? lo : pri > hi ? hi : pri;
+      }
+      pthread_attr_setinheritsched(&pt_attrs, PTHREAD_EXPLICIT_SCHED);
+      pthread_attr_setschedpolicy(&pt_attrs, policy);
+      pthread_attr_setschedparam(&pt_attrs, &sp);
+   }
+
+#ifndef ANDROID
+   /* Bionic has no pthread_attr_setaffinity_np */
+   if (local_attrs->ta_cpuset)
+   {
+      cpu_set_t cpus;
+      unsigned i;
+      CPU_ZERO(&cpus);
+      for (i = 0; i < 8*sizeof(local_attrs->ta_cpuset); i++)
+      {
+         if (local_attrs->ta_cpuset & (1u << i))
+            CPU_SET(i, &cpus);
+      }
+      pthread_attr_setaffinity_np(&pt_attrs, sizeof(cpus), &cpus);
+   }
+#endif
+
    vcos_assert(local_attrs->ta_stackaddr == 0); /* Not possible */
 
    thread->entry = entry;
@@ -211,12 +252,21 @@ VCOS_STATUS_T vcos_thread_create(VCOS_THREAD_T *thread,
 
    rc = pthread_create(&thread->thread, &pt_attrs, vcos_thread_entry, thread);
 
+   if (rc != 0 && local_attrs->ta_schedpolicy != VCOS_THREAD_SCHED_DEFAULT)
+   {
+      /* Probably lacking privilege for a realtime class (EPERM). Fall back
+       * to the inherited policy rather than failing the create.
+       */
+      pthread_attr_setinheritsched(&pt_attrs, PTHREAD_INHERIT_SCHED);
+      rc = pthread_create(&thread->thread, &pt_attrs, vcos_thread_entry, thread);
+   }
+
    pthread_attr_destroy(&pt_attrs);
 
-   if (rc < 0)
+   if (rc != 0)
    {
       vcos_semaphore_delete(&thread->suspend);
-      return VCOS_ENOMEM;
+      return vcos_pthreads_map_error(rc);
    }
    else
    {
@@ -270,6 +320,26 @@ uint64_t vcos_getmicrosecs64_internal(void)
    return tm;
 }
 
+uint64_t vcos_getmonotonicmicrosecs64_internal(void)
+{
+   struct timespec ts;
+   uint64_t tm = 0;
+
+   /* MONOTONIC_RAW is also immune to NTP slewing; settle for MONOTONIC
+    * where the libc predates it. Either way the read goes through the
+    * vDSO, so there is no system call. */
+#ifdef CLOCK_MONOTONIC_RAW
+   if (!clock_gettime(CLOCK_MONOTONIC_RAW, &ts))
+#else
+   if (!clock_gettime(CLOCK_MONOTONIC, &ts))
+#endif
+   {
+      tm = (ts.tv_sec * 1000000LL) + (ts.tv_nsec / 1000);
+   }
+
+   return tm;
+}
+
 #ifdef ANDROID
 
 static int log_prio[] =
@@ -673,15 +743,19 @@ VCOS_THREAD_T *vcos_dummy_thread_create(void)
  * they work incorrectly with CLOCK_MONOTONIC, so we have to
  * use CLOCK_REALTIME (and hope that no one will change the time
  * significantly after the timer has been set up
+ *
+ * All timers share one dispatcher thread rather than spawning a thread
+ * per timer; armed timers sit on a doubly-linked list so arming and
+ * cancelling are O(1), and the dispatcher wakes a shade late so that
+ * timers due within the coalescing window share a single wakeup.
  */
 #define NSEC_IN_SEC  (1000*1000*1000)
 #define MSEC_IN_SEC  (1000)
 #define NSEC_IN_MSEC (1000*1000)
 
-static int _timespec_is_zero(struct timespec *ts)
-{
-   return ((ts->tv_sec == 0) && (ts->tv_nsec == 0));
-}
+/* Timers due within this interval of each other fire off the same wakeup.
+ * Timers are never fired early. */
+#define TIMER_COALESCE_NSEC NSEC_IN_MSEC
 
 static void _timespec_set_zero(struct timespec *ts)
 {
@@ -708,33 +782,107 @@ static int _timespec_is_larger(struct timespec *left, struct timespec *right)
       return left->tv_nsec > right->tv_nsec;
 }
 
-static void* _timer_thread(void *arg)
+/* Shared timer dispatcher state. The wheel lock protects the armed list
+ * and the firing marker; the manager lock serializes starting and
+ * stopping the dispatcher thread and is always taken outside it.
+ */
+static pthread_mutex_t timer_manager_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t timer_wheel_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t timer_wheel_cond = PTHREAD_COND_INITIALIZER;
+static VCOS_TIMER_T *timer_armed_list;    /* unsorted doubly-linked list */
+static VCOS_TIMER_T *timer_firing;        /* timer whose routine is running */
+static pthread_t timer_wheel_thread_id;
+static int timer_wheel_running;
+static unsigned timer_refs;               /* number of created timers */
+
+/* Remove a timer from the armed list. Called with the wheel lock held. */
+static void _timer_wheel_remove(VCOS_TIMER_T *timer)
 {
-   VCOS_TIMER_T *timer = (VCOS_TIMER_T*)arg;
+   if (timer->prev)
+      timer->prev->next = timer->next;
+   else
+      timer_armed_list = timer->next;
+   if (timer->next)
+      timer->next->prev = timer->prev;
+   timer->next = timer->prev = NULL;
+   timer->armed = 0;
+}
+
+static void* _timer_dispatch_thread(void *arg)
+{
+   (void)arg;
 
-   pthread_mutex_lock(&timer->lock);
-   while (!timer->quit)
+   pthread_mutex_lock(&timer_wheel_lock);
+   while (timer_wheel_running)
    {
-      struct timespec now;
+      struct timespec now, deadline;
+      VCOS_TIMER_T *timer;
+      int have_deadline = 0;
+
+      /* Find the earliest expiry among the armed timers */
+      for (timer = timer_armed_list; timer; timer = timer->next)
+      {
+         if (!have_deadline || _timespec_is_larger(&deadline, &timer->expires))
+         {
+            deadline = timer->expires;
+            have_deadline = 1;
+         }
+      }
+
+      if (!have_deadline)
+      {
+         pthread_cond_wait(&timer_wheel_cond, &timer_wheel_lock);
+         continue;
+      }
 
-      /* Wait until next expiry time, or until timer's settings are changed */
-      if (_timespec_is_zero(&timer->expires))
-         pthread_cond_wait(&timer->settings_changed, &timer->lock);
-      else
-         pthread_cond_timedwait(&timer->settings_changed, &timer->lock, &timer->expires);
+      /* Deliberately oversleep by the coalescing window so that timers
+       * due close together are serviced off a single wakeup. Timers are
+       * only ever fired once genuinely due.
+       */
+      deadline.tv_nsec += TIMER_COALESCE_NSEC;
+      if (deadline.tv_nsec >= NSEC_IN_SEC)
+      {
+         deadline.tv_nsec -= NSEC_IN_SEC;
+         deadline.tv_sec++;
+      }
 
-      /* See if the timer has expired - reloop if it didn't */
       clock_gettime(CLOCK_REALTIME, &now);
-      if (_timespec_is_zero(&timer->expires) || _timespec_is_larger(&timer->expires, &now))
+      if (_timespec_is_larger(&deadline, &now))
+      {
+         /* Reloop after the wait - the armed list may have changed */
+         pthread_cond_timedwait(&timer_wheel_cond, &timer_wheel_lock, &deadline);
          continue;
+      }
 
-      /* The timer has expired. Clear the expiry time and call the
-       * expiration routine
+      /* Fire everything that is due. The lock is dropped around each
+       * expiration routine, so restart the scan afterwards; fired timers
+       * have left the list, guaranteeing progress.
        */
-      _timespec_set_zero(&timer->expires);
-      timer->orig_expiration_routine(timer->orig_context);
+      timer = timer_armed_list;
+      while (timer)
+      {
+         if (_timespec_is_larger(&timer->expires, &now))
+         {
+            timer = timer->next;
+            continue;
+         }
+
+         _timer_wheel_remove(timer);
+         _timespec_set_zero(&timer->expires);
+
+         timer_firing = timer;
+         pthread_mutex_unlock(&timer_wheel_lock);
+         timer->orig_expiration_routine(timer->orig_context);
+         pthread_mutex_lock(&timer_wheel_lock);
+         timer_firing = NULL;
+
+         /* Wake anyone in cancel/delete waiting for the routine to finish */
+         pthread_cond_broadcast(&timer_wheel_cond);
+
+         timer = timer_armed_list;
+      }
    }
-   pthread_mutex_unlock(&timer->lock);
+   pthread_mutex_unlock(&timer_wheel_lock);
 
    return NULL;
 }
@@ -749,11 +897,7 @@ VCOS_STATUS_T vcos_timer_create(VCOS_TIMER_T *timer,
                                 void (*expiration_routine)(void *context),
                                 void *context)
 {
-   pthread_mutexattr_t lock_attr;
    VCOS_STATUS_T result = VCOS_SUCCESS;
-   int settings_changed_initialized = 0;
-   int lock_attr_initialized = 0;
-   int lock_initialized = 0;
 
    (void)name;
 
@@ -765,64 +909,23 @@ VCOS_STATUS_T vcos_timer_create(VCOS_TIMER_T *timer,
    timer->orig_expiration_routine = expiration_routine;
    timer->orig_context = context;
 
-   /* Create conditional variable for notifying the timer's thread
-    * when settings change.
-    */
-   if (result == VCOS_SUCCESS)
-   {
-      int rc = pthread_cond_init(&timer->settings_changed, NULL);
-      if (rc == 0)
-         settings_changed_initialized = 1;
-      else
-         result = vcos_pthreads_map_error(rc);
-   }
-
-   /* Create attributes for the lock (we want it to be recursive) */
-   if (result == VCOS_SUCCESS)
+   /* Start the shared dispatcher thread when the first timer is created */
+   pthread_mutex_lock(&timer_manager_lock);
+   if (timer_refs == 0)
    {
-      int rc = pthread_mutexattr_init(&lock_attr);
-      if (rc == 0)
-      {
-         pthread_mutexattr_settype(&lock_attr, PTHREAD_MUTEX_RECURSIVE);
-         lock_attr_initialized = 1;
-      }
-      else
+      int rc;
+      timer_wheel_running = 1;
+      rc = pthread_create(&timer_wheel_thread_id, NULL,
+                          _timer_dispatch_thread, NULL);
+      if (rc != 0)
       {
+         timer_wheel_running = 0;
          result = vcos_pthreads_map_error(rc);
       }
    }
-
-   /* Create lock for the timer structure */
-   if (result == VCOS_SUCCESS)
-   {
-      int rc = pthread_mutex_init(&timer->lock, &lock_attr);
-      if (rc == 0)
-         lock_initialized = 1;
-      else
-         result = vcos_pthreads_map_error(rc);
-   }
-
-   /* Lock attributes are no longer needed */
-   if (lock_attr_initialized)
-      pthread_mutexattr_destroy(&lock_attr);
-
-   /* Create the underlying thread */
    if (result == VCOS_SUCCESS)
-   {
-      int rc = pthread_create(&timer->thread, NULL, _timer_thread, timer);
-      if (rc != 0)
-         result = vcos_pthreads_map_error(rc);
-   }
-
-   /* Clean up if anything went wrong */
-   if (result != VCOS_SUCCESS)
-   {
-      if (lock_initialized)
-         pthread_mutex_destroy(&timer->lock);
-
-      if (settings_changed_initialized)
-         pthread_cond_destroy(&timer->settings_changed);
-   }
+      timer_refs++;
+   pthread_mutex_unlock(&timer_manager_lock);
 
    return result;
 }
@@ -840,7 +943,7 @@ void vcos_timer_set(VCOS_TIMER_T *timer, VCOS_UNSIGNED delay_ms)
    if (delay_ms == 0)
       return;
 
-   pthread_mutex_lock(&timer->lock);
+   pthread_mutex_lock(&timer_wheel_lock);
 
    /* Calculate the new absolute expiry time */
    clock_gettime(CLOCK_REALTIME, &now);
@@ -848,22 +951,42 @@ void vcos_timer_set(VCOS_TIMER_T *timer, VCOS_UNSIGNED delay_ms)
    timer->expires.tv_nsec = (delay_ms % MSEC_IN_SEC) * NSEC_IN_MSEC;
    _timespec_add(&timer->expires, &now);
 
-   /* Notify the timer's thread about the change */
-   pthread_cond_signal(&timer->settings_changed);
+   if (!timer->armed)
+   {
+      /* Push onto the armed list */
+      timer->prev = NULL;
+      timer->next = timer_armed_list;
+      if (timer_armed_list)
+         timer_armed_list->prev = timer;
+      timer_armed_list = timer;
+      timer->armed = 1;
+   }
+
+   /* Notify the dispatcher thread about the change */
+   pthread_cond_broadcast(&timer_wheel_cond);
 
-   pthread_mutex_unlock(&timer->lock);
+   pthread_mutex_unlock(&timer_wheel_lock);
 }
 
 void vcos_timer_cancel(VCOS_TIMER_T *timer)
 {
    vcos_assert(timer);
 
-   pthread_mutex_lock(&timer->lock);
+   pthread_mutex_lock(&timer_wheel_lock);
 
+   if (timer->armed)
+      _timer_wheel_remove(timer);
    _timespec_set_zero(&timer->expires);
-   pthread_cond_signal(&timer->settings_changed);
 
-   pthread_mutex_unlock(&timer->lock);
+   /* As with the old per-timer lock, don't return while the expiration
+    * routine is mid-flight - unless this is the expiration routine
+    * cancelling its own timer, which must not deadlock.
+    */
+   while (timer_firing == timer &&
+         !pthread_equal(pthread_self(), timer_wheel_thread_id))
+      pthread_cond_wait(&timer_wheel_cond, &timer_wheel_lock);
+
+   pthread_mutex_unlock(&timer_wheel_lock);
 }
 
 void vcos_timer_reset(VCOS_TIMER_T *timer, VCOS_UNSIGNED delay_ms)
@@ -875,28 +998,29 @@ void vcos_timer_delete(VCOS_TIMER_T *timer)
 {
    vcos_assert(timer);
 
-   pthread_mutex_lock(&timer->lock);
-
    /* Other implementation of this function (e.g. ThreadX)
     * disallow it being called from the expiration routine
     */
-   vcos_assert(pthread_self() != timer->thread);
-
-   /* Stop the timer and set flag telling the timer thread to quit */
-   _timespec_set_zero(&timer->expires);
-   timer->quit = 1;
+   vcos_assert(!pthread_equal(pthread_self(), timer_wheel_thread_id));
 
-   /* Notify the timer's thread about the change */
-   pthread_cond_signal(&timer->settings_changed);
+   /* Disarm and wait out any in-flight expiration routine */
+   vcos_timer_cancel(timer);
 
-   /* Release the lock, so that the timer's thread can quit */
-   pthread_mutex_unlock(&timer->lock);
+   /* Stop the dispatcher thread when the last timer goes away */
+   pthread_mutex_lock(&timer_manager_lock);
+   vcos_assert(timer_refs > 0);
+   if (--timer_refs == 0)
+   {
+      pthread_mutex_lock(&timer_wheel_lock);
+      timer_wheel_running = 0;
+      pthread_cond_broadcast(&timer_wheel_cond);
+      pthread_mutex_unlock(&timer_wheel_lock);
 
-   /* Wait for the timer thread to finish */
-   pthread_join(timer->thread, NULL);
+      pthread_join(timer_wheel_thread_id, NULL);
+   }
+   pthread_mutex_unlock(&timer_manager_lock);
 
-   /* Free resources used by the timer */
-   pthread_mutex_destroy(&timer->lock);
-   pthread_cond_destroy(&timer->settings_changed);
+   timer->orig_expiration_routine = NULL;
+   timer->orig_context = NULL;
 }
 
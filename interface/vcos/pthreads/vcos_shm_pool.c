@@ -0,0 +1,294 @@
+/*
+Copyright (c) 2012, Broadcom Europe Ltd
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*=============================================================================
+VCOS - named shared-memory pools, over POSIX shared memory.
+
+The free list is a lock-free stack of block indices kept in the segment
+itself. Links are indices rather than pointers because each process maps
+the segment at a different address; a free block's first word holds the
+index (plus one, so 0 means end-of-list) of the next free block. The
+head word additionally carries a generation tag in its top 32 bits,
+bumped on every pop, so the compare-and-swap cannot be fooled by a block
+that was freed and re-pushed between our read and our swap (the ABA
+problem).
+=============================================================================*/
+
+#include "interface/vcos/vcos.h"
+#include "interface/vcos/vcos_shm_pool.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stdio.h>
+
+#define SHM_POOL_MAGIC 0x56534d50 /* 'VSMP' */
+
+/* Blocks are at least a link word and eight-byte aligned, matching the
+ * alignment vcos_malloc guarantees. */
+#define SHM_POOL_ROUND(s) (((s) + 7) & ~7u)
+
+/* The head word packs (generation << 32) | (index + 1). */
+#define SHM_POOL_HEAD_IDX1(h)    ((uint32_t)(h))
+#define SHM_POOL_HEAD_NEXT(h, i1) ((((h) >> 32) + 1) << 32 | (i1))
+
+static VCOS_STATUS_T shm_pool_map_error(int err)
+{
+   switch (err)
+   {
+   case EEXIST: return VCOS_EEXIST;
+   case ENOENT: return VCOS_ENOENT;
+   case EACCES: return VCOS_EACCESS;
+   case ENOMEM: return VCOS_ENOMEM;
+   default:     return VCOS_EINVAL;
+   }
+}
+
+/* shm_open wants a name starting with exactly one slash */
+static VCOS_STATUS_T shm_pool_name(char *buf, size_t buflen, const char *name)
+{
+   if (!name || strchr(name, '/') ||
+       (size_t)snprintf(buf, buflen, "/%s", name) >= buflen)
+      return VCOS_EINVAL;
+   return VCOS_SUCCESS;
+}
+
+static void *shm_pool_block_ptr(VCOS_SHM_POOL_HDR_T *hdr, uint32_t idx)
+{
+   return (uint8_t *)hdr + hdr->data_offset + idx * hdr->block_size;
+}
+
+VCOS_STATUS_T vcos_shm_pool_create(VCOS_SHM_POOL_T *pool,
+                                   const char *name,
+                                   VCOS_UNSIGNED num_blocks,
+                                   VCOS_UNSIGNED block_size)
+{
+   VCOS_STATUS_T st;
+   VCOS_SHM_POOL_HDR_T *hdr;
+   size_t map_size;
+   uint32_t i;
+   char shm_name[VCOS_SHM_POOL_NAMELEN + 1];
+   int fd;
+
+   vcos_assert(pool);
+   if (num_blocks < 1 || block_size < 1)
+      return VCOS_EINVAL;
+
+   st = shm_pool_name(shm_name, sizeof(shm_name), name);
+   if (st != VCOS_SUCCESS)
+      return st;
+
+   block_size = SHM_POOL_ROUND(block_size);
+   map_size = SHM_POOL_ROUND(sizeof(VCOS_SHM_POOL_HDR_T)) +
+      (size_t)num_blocks * block_size;
+
+   fd = shm_open(shm_name, O_RDWR | O_CREAT | O_EXCL, 0600);
+   if (fd < 0)
+      return shm_pool_map_error(errno);
+
+   if (ftruncate(fd, map_size) < 0)
+   {
+      st = shm_pool_map_error(errno);
+      goto fail_sized;
+   }
+
+   hdr = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   if (hdr == MAP_FAILED)
+   {
+      st = shm_pool_map_error(errno);
+      goto fail_sized;
+   }
+
+   hdr->block_size = block_size;
+   hdr->num_blocks = num_blocks;
+   hdr->data_offset = SHM_POOL_ROUND(sizeof(VCOS_SHM_POOL_HDR_T));
+
+   /* Chain every block onto the free list: block i links to block i+1,
+    * the last block links to 0 (end-of-list). */
+   for (i = 0; i < num_blocks; i++)
+      *(uint32_t *)shm_pool_block_ptr(hdr, i) = (i + 1 < num_blocks) ? i + 2 : 0;
+   hdr->free_head = 1; /* generation 0, first block */
+
+   /* Openers check the magic, so it must be the last thing to appear */
+   __sync_synchronize();
+   hdr->magic = SHM_POOL_MAGIC;
+
+   pool->hdr = hdr;
+   pool->map_size = map_size;
+   pool->fd = fd;
+   pool->owner = 1;
+   strncpy(pool->name, shm_name, sizeof(pool->name));
+   pool->name[sizeof(pool->name) - 1] = '\0';
+
+   return VCOS_SUCCESS;
+
+fail_sized:
+   close(fd);
+   shm_unlink(shm_name);
+   return st;
+}
+
+VCOS_STATUS_T vcos_shm_pool_open(VCOS_SHM_POOL_T *pool,
+                                 const char *name)
+{
+   VCOS_STATUS_T st;
+   VCOS_SHM_POOL_HDR_T *hdr;
+   struct stat sb;
+   char shm_name[VCOS_SHM_POOL_NAMELEN + 1];
+   int fd;
+
+   vcos_assert(pool);
+
+   st = shm_pool_name(shm_name, sizeof(shm_name), name);
+   if (st != VCOS_SUCCESS)
+      return st;
+
+   fd = shm_open(shm_name, O_RDWR, 0);
+   if (fd < 0)
+      return shm_pool_map_error(errno);
+
+   if (fstat(fd, &sb) < 0 || (size_t)sb.st_size < sizeof(VCOS_SHM_POOL_HDR_T))
+   {
+      st = VCOS_EINVAL;
+      goto fail_map;
+   }
+
+   hdr = mmap(NULL, sb.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   if (hdr == MAP_FAILED)
+   {
+      st = shm_pool_map_error(errno);
+      goto fail_map;
+   }
+
+   /* The creator publishes the magic last, so seeing it means the rest
+    * of the header is valid. */
+   if (hdr->magic != SHM_POOL_MAGIC ||
+       (size_t)sb.st_size < hdr->data_offset +
+          (size_t)hdr->num_blocks * hdr->block_size)
+   {
+      munmap(hdr, sb.st_size);
+      st = VCOS_EINVAL;
+      goto fail_map;
+   }
+
+   pool->hdr = hdr;
+   pool->map_size = sb.st_size;
+   pool->fd = fd;
+   pool->owner = 0;
+   strncpy(pool->name, shm_name, sizeof(pool->name));
+   pool->name[sizeof(pool->name) - 1] = '\0';
+
+   return VCOS_SUCCESS;
+
+fail_map:
+   close(fd);
+   return st;
+}
+
+void vcos_shm_pool_close(VCOS_SHM_POOL_T *pool)
+{
+   vcos_assert(pool && pool->hdr);
+   munmap(pool->hdr, pool->map_size);
+   close(pool->fd);
+   if (pool->owner)
+      shm_unlink(pool->name);
+   memset(pool, 0, sizeof(*pool));
+   pool->fd = -1;
+}
+
+void *vcos_shm_pool_alloc(VCOS_SHM_POOL_T *pool)
+{
+   VCOS_SHM_POOL_HDR_T *hdr = pool->hdr;
+   void *block;
+
+   for (;;)
+   {
+      uint64_t head = hdr->free_head;
+      uint32_t idx1 = SHM_POOL_HEAD_IDX1(head);
+      uint32_t next;
+      if (!idx1)
+         return NULL; /* exhausted */
+      block = shm_pool_block_ptr(hdr, idx1 - 1);
+      next = *(volatile uint32_t *)block;
+      if (__sync_bool_compare_and_swap(&hdr->free_head, head,
+                                       SHM_POOL_HEAD_NEXT(head, next)))
+         return block;
+      /* lost the race - reload and retry */
+   }
+}
+
+void vcos_shm_pool_free(VCOS_SHM_POOL_T *pool, void *block)
+{
+   VCOS_SHM_POOL_HDR_T *hdr = pool->hdr;
+   uint32_t idx1 = vcos_shm_pool_offset(pool, block);
+
+   vcos_assert(idx1 != (uint32_t)-1);
+   idx1 = (idx1 - hdr->data_offset) / hdr->block_size + 1;
+
+   for (;;)
+   {
+      uint64_t head = hdr->free_head;
+      *(volatile uint32_t *)block = SHM_POOL_HEAD_IDX1(head);
+      /* the link must be visible before the block becomes the head */
+      __sync_synchronize();
+      if (__sync_bool_compare_and_swap(&hdr->free_head, head,
+                                       SHM_POOL_HEAD_NEXT(head, idx1)))
+         return;
+   }
+}
+
+uint32_t vcos_shm_pool_offset(VCOS_SHM_POOL_T *pool, void *block)
+{
+   VCOS_SHM_POOL_HDR_T *hdr = pool->hdr;
+   size_t off = (uint8_t *)block - (uint8_t *)hdr;
+
+   if (off < hdr->data_offset || off >= pool->map_size ||
+       (off - hdr->data_offset) % hdr->block_size != 0)
+   {
+      vcos_assert(0); /* not a block of this pool */
+      return (uint32_t)-1;
+   }
+   return (uint32_t)off;
+}
+
+void *vcos_shm_pool_block(VCOS_SHM_POOL_T *pool, uint32_t offset)
+{
+   VCOS_SHM_POOL_HDR_T *hdr = pool->hdr;
+
+   if (offset < hdr->data_offset || offset >= pool->map_size ||
+       (offset - hdr->data_offset) % hdr->block_size != 0)
+      return NULL;
+   return (uint8_t *)hdr + offset;
+}
+
+VCOS_UNSIGNED vcos_shm_pool_block_size(VCOS_SHM_POOL_T *pool)
+{
+   return pool->hdr->block_size;
+}
@@ -0,0 +1,161 @@
+/*
+Copyright (c) 2012, Broadcom Europe Ltd
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*=============================================================================
+VCOS - shared telemetry counter page, over POSIX shared memory.
+
+Slot claiming is lock-free and works across processes: a writer
+compare-and-swaps a FREE slot to CLAIMED, fills in the name, then
+publishes it by storing LIVE. Readers and other writers ignore slots
+which are not LIVE, so a half written name is never observed. The page
+header is initialised idempotently - every creator writes the same
+constants - so no cross-process locking is needed there either.
+=============================================================================*/
+
+#include "interface/vcos/vcos.h"
+#include "interface/vcos/vcos_telemetry.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdio.h>
+
+/** How long to poll a CLAIMED slot before giving up on its owner. The
+ * publish window is one strncpy, so this is generous; it only needs to be
+ * finite in case the owning process died mid-publish. */
+#define VCOS_TELEMETRY_CLAIM_SPINS  100000
+
+static VCOS_ONCE_T telemetry_once = VCOS_ONCE_INIT;
+static VCOS_TELEMETRY_PAGE_T *telemetry_page;
+
+/* Used when the shared segment can't be mapped (no /dev/shm, no
+ * permissions); counters then stay process local but keep working. */
+static VCOS_TELEMETRY_PAGE_T telemetry_local_page;
+
+static void telemetry_init(void)
+{
+   VCOS_TELEMETRY_PAGE_T *page;
+   struct stat st;
+   int fd;
+
+   fd = shm_open("/" VCOS_TELEMETRY_SHM_NAME, O_CREAT | O_RDWR, 0644);
+   if (fd < 0)
+      goto fallback;
+
+   /* Size the object if we're first; ftruncate zero-fills, and doing it
+    * from several processes at once is harmless */
+   if (fstat(fd, &st) < 0 ||
+       (st.st_size < (off_t)sizeof(*page) && ftruncate(fd, sizeof(*page)) < 0))
+   {
+      close(fd);
+      goto fallback;
+   }
+
+   page = mmap(NULL, sizeof(*page), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   close(fd);
+   if (page == MAP_FAILED)
+      goto fallback;
+
+   if (page->magic != VCOS_TELEMETRY_MAGIC)
+   {
+      page->version = 1;
+      page->num_slots = VCOS_TELEMETRY_SLOTS;
+      __sync_val_compare_and_swap(&page->magic, 0, VCOS_TELEMETRY_MAGIC);
+   }
+
+   telemetry_page = page;
+   return;
+
+fallback:
+   telemetry_local_page.magic = VCOS_TELEMETRY_MAGIC;
+   telemetry_local_page.version = 1;
+   telemetry_local_page.num_slots = VCOS_TELEMETRY_SLOTS;
+   telemetry_page = &telemetry_local_page;
+}
+
+volatile uint32_t *vcos_telemetry_counter(const char *name)
+{
+   VCOS_TELEMETRY_PAGE_T *page;
+   unsigned i;
+
+   if (!name)
+      return NULL;
+
+   vcos_once(&telemetry_once, telemetry_init);
+   page = telemetry_page;
+
+   for (i = 0; i < VCOS_TELEMETRY_SLOTS; i++)
+   {
+      VCOS_TELEMETRY_SLOT_T *slot = &page->slots[i];
+
+      if (slot->state == VCOS_TELEMETRY_SLOT_FREE &&
+          __sync_val_compare_and_swap(&slot->state, VCOS_TELEMETRY_SLOT_FREE,
+             VCOS_TELEMETRY_SLOT_CLAIMED) == VCOS_TELEMETRY_SLOT_FREE)
+      {
+         strncpy(slot->name, name, VCOS_TELEMETRY_NAMELEN - 1);
+         slot->name[VCOS_TELEMETRY_NAMELEN - 1] = '\0';
+         __sync_synchronize();
+         slot->state = VCOS_TELEMETRY_SLOT_LIVE;
+         return &slot->value;
+      }
+
+      /* A slot being CLAIMED right now by someone else might be getting
+       * our name; the window is one strncpy so wait it out briefly. The
+       * owner may however have died between CLAIMED and LIVE - this is a
+       * cross-process page - so the wait must be bounded: after that,
+       * skip the slot rather than hang every caller forever. The worst
+       * case for skipping is a duplicate slot for the same name. */
+      if (slot->state == VCOS_TELEMETRY_SLOT_CLAIMED)
+      {
+         unsigned spins = 0;
+         while (slot->state == VCOS_TELEMETRY_SLOT_CLAIMED &&
+                ++spins < VCOS_TELEMETRY_CLAIM_SPINS)
+            ;
+         if (slot->state == VCOS_TELEMETRY_SLOT_CLAIMED)
+            continue;
+      }
+
+      if (slot->state == VCOS_TELEMETRY_SLOT_LIVE &&
+          strncmp(slot->name, name, VCOS_TELEMETRY_NAMELEN - 1) == 0)
+         return &slot->value;
+   }
+
+   return NULL; /* page full */
+}
+
+void vcos_telemetry_add(volatile uint32_t *counter, uint32_t n)
+{
+   if (counter)
+      __sync_fetch_and_add(counter, n);
+}
+
+const VCOS_TELEMETRY_PAGE_T *vcos_telemetry_page(void)
+{
+   return telemetry_page;
+}
@@ -159,10 +159,22 @@ VideoCore OS Abstraction Layer - public header file
 #include "interface/vcos/vcos_reentrant_mutex.h"
 #endif
 
+#ifndef VCOS_ADAPTIVE_MUTEX_H
+#include "interface/vcos/vcos_adaptive_mutex.h"
+#endif
+
 #ifndef VCOS_NAMED_SEMAPHORE_H
 #include "interface/vcos/vcos_named_semaphore.h"
 #endif
 
+#ifndef VCOS_SHM_POOL_H
+#include "interface/vcos/vcos_shm_pool.h"
+#endif
+
+#ifndef VCOS_TELEMETRY_H
+#include "interface/vcos/vcos_telemetry.h"
+#endif
+
 #ifndef VCOS_QUICKSLOW_MUTEX_H
 #include "interface/vcos/vcos_quickslow_mutex.h"
 #endif
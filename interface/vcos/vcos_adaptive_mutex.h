@@ -0,0 +1,106 @@
+/*
+Copyright (c) 2012, Broadcom Europe Ltd
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*=============================================================================
+VideoCore OS Abstraction Layer - adaptive mutex public header file
+=============================================================================*/
+
+#ifndef VCOS_ADAPTIVE_MUTEX_H
+#define VCOS_ADAPTIVE_MUTEX_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "interface/vcos/vcos_types.h"
+#include "vcos_platform.h"
+
+/**
+ * \file
+ *
+ * Adaptive Mutex API. Like a regular mutex, but a contended lock spins
+ * briefly before sleeping, with the spin duration adapted from how the
+ * mutex has recently behaved. Worth using for locks that are held for
+ * very short periods (queue and pool locks); pointless for locks held
+ * across blocking operations.
+ *
+ * Contention counters are kept per mutex and can be read at any time to
+ * find out which locks actually hurt.
+ *
+ * \sa vcos_mutex.h
+ *
+ */
+
+/** Create an adaptive mutex.
+  *
+  * @param m      Filled in with mutex on return
+  * @param name   A non-null name for the mutex, used for diagnostics.
+  *
+  * @return VCOS_SUCCESS if mutex was created, or error code.
+  */
+VCOS_INLINE_DECL
+VCOS_STATUS_T vcos_adaptive_mutex_create(VCOS_ADAPTIVE_MUTEX_T *m, const char *name);
+
+/** Delete the mutex.
+  */
+VCOS_INLINE_DECL
+void vcos_adaptive_mutex_delete(VCOS_ADAPTIVE_MUTEX_T *m);
+
+/** Wait to claim the mutex, spinning briefly first if it is contended.
+  */
+VCOS_INLINE_DECL
+void vcos_adaptive_mutex_lock(VCOS_ADAPTIVE_MUTEX_T *m);
+
+/** Obtain the mutex if possible.
+  *
+  * @param m  the mutex to try to obtain
+  *
+  * @return VCOS_SUCCESS if mutex is succesfully obtained, or VCOS_EAGAIN
+  * if it is already in use by another thread.
+  */
+VCOS_INLINE_DECL
+VCOS_STATUS_T vcos_adaptive_mutex_trylock(VCOS_ADAPTIVE_MUTEX_T *m);
+
+/** Release the mutex.
+  */
+VCOS_INLINE_DECL
+void vcos_adaptive_mutex_unlock(VCOS_ADAPTIVE_MUTEX_T *m);
+
+/** Read the contention counters. The snapshot is taken without claiming
+  * the mutex, so it may be slightly stale, but reading it does not
+  * perturb the lock being observed.
+  *
+  * @param m      the mutex to query
+  * @param stats  filled in with the counters on return
+  */
+VCOS_INLINE_DECL
+void vcos_adaptive_mutex_get_stats(VCOS_ADAPTIVE_MUTEX_T *m, VCOS_ADAPTIVE_MUTEX_STATS_T *stats);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -72,6 +72,13 @@ extern "C" {
   */
 #define VCOS_MSG_DATA(_msg) (void*)((_msg)->data)
 
+/** Map the payload of a message, whether it lives inline after the
+ * message header or in caller-owned memory attached with
+ * vcos_msg_set_payload().
+ */
+#define VCOS_MSG_PAYLOAD(_msg) \
+   ((_msg)->payload ? (_msg)->payload : VCOS_MSG_DATA(_msg))
+
 /** Standard message ids - FIXME - these need to be done properly! */
 #define VCOS_MSG_N_QUIT            1
 #define VCOS_MSG_N_OPEN            2
@@ -122,13 +129,15 @@ typedef struct VCOS_MSG_T
    VCOS_THREAD_T *src_thread;          /**< for debug */
    struct VCOS_MSG_WAITER_T *waiter;   /**< client waiter structure */
    struct VCOS_MSGQ_POOL_T *pool;      /**< Pool allocated from, or NULL */
+   void *payload;                      /**< Caller-owned payload, or NULL if inline */
+   size_t payload_size;                /**< Size of the caller-owned payload */
 } VCOS_MSG_T;
 
 #define MSG_REPLY_BIT (1<<31)
 
 /** Initialize a VCOS_MSG_T. Can also use vcos_msg_init().
  */
-#define VCOS_MSG_INITIALIZER {VCOS_MSGQ_MAGIC, 0, NULL, NULL, NULL, 0}
+#define VCOS_MSG_INITIALIZER {VCOS_MSGQ_MAGIC, 0, NULL, NULL, NULL, 0, NULL, 0}
 
 /** A pool of messages. This contains its own waiter and
  * semaphore, as well as a blockpool for the actual memory
@@ -178,10 +187,39 @@ VCOSPRE_ void VCOSPOST_ vcos_msg_send(VCOS_MSGQUEUE_T *dest, uint32_t code, VCOS
  */
 VCOSPRE_ VCOS_STATUS_T VCOSPOST_ vcos_msg_sendwait(VCOS_MSGQUEUE_T *queue, uint32_t code, VCOS_MSG_T *msg);
 
+/** Send several messages in one go. The queue lock is taken once for the
+ * whole batch rather than once per message, so a dispatcher draining its
+ * own backlog wakes the receiver far less often.
+ *
+ * @param dest    Destination message queue
+ * @param code    Message code, applied to every message in the batch.
+ * @param msgs    Array of messages to send. The same lifetime rules apply
+ *                as for vcos_msg_send().
+ * @param count   Number of messages in the array.
+ */
+VCOSPRE_ void VCOSPOST_ vcos_msgq_send_batch(VCOS_MSGQUEUE_T *dest,
+                                             uint32_t code,
+                                             VCOS_MSG_T **msgs,
+                                             VCOS_UNSIGNED count);
+
 /** Wait for a message on a queue.
   */
 VCOSPRE_ VCOS_MSG_T * VCOSPOST_ vcos_msg_wait(VCOS_MSGQUEUE_T *queue);
 
+/** Wait for at least one message, then drain up to max_msgs from the
+ * queue under a single lock acquisition. Blocks only for the first
+ * message; any further messages already queued are returned without
+ * additional wakeups.
+ *
+ * @param queue     Queue to receive from.
+ * @param msgs      Array to fill with received messages.
+ * @param max_msgs  Capacity of the array.
+ * @return The number of messages received (at least 1).
+ */
+VCOSPRE_ VCOS_UNSIGNED VCOSPOST_ vcos_msgq_receive_batch(VCOS_MSGQUEUE_T *queue,
+                                                         VCOS_MSG_T **msgs,
+                                                         VCOS_UNSIGNED max_msgs);
+
 /** Peek for a message on this thread's endpoint. If a message is not
  * available, NULL is returned. If a message is available it will be
  * removed from the endpoint and returned.
@@ -200,6 +238,24 @@ VCOSPRE_ void VCOSPOST_ vcos_msg_reply(VCOS_MSG_T *msg);
  */
 VCOSPRE_ void VCOSPOST_ vcos_msg_set_source(VCOS_MSG_T *msg, VCOS_MSGQUEUE_T *queue);
 
+/** Attach a caller-owned payload to a message. The message then carries
+ * only the pointer; nothing is copied into the inline payload area, so
+ * pool messages can stay at their minimum size. The caller must keep the
+ * payload memory valid until the message is replied-to or freed -
+ * typically it lives in a pool owned by the sender.
+ *
+ * Receivers should use VCOS_MSG_PAYLOAD() rather than VCOS_MSG_DATA() to
+ * see either form of payload.
+ *
+ * @param msg      Message
+ * @param payload  Caller-owned payload memory, or NULL to revert to the
+ *                 inline payload area.
+ * @param size     Size of the payload in bytes.
+ */
+VCOSPRE_ void VCOSPOST_ vcos_msg_set_payload(VCOS_MSG_T *msg,
+                                             void *payload,
+                                             size_t size);
+
 /** Initialise a newly allocated message. This only needs to be called
  * for messages allocated on the stack, heap or statically. It is not
  * needed for messages allocated from a pool.
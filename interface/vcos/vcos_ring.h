@@ -0,0 +1,135 @@
+/*
+Copyright (c) 2012, Broadcom Europe Ltd
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*=============================================================================
+VCOS - bounded lock-free multi-producer multi-consumer ring of pointers.
+=============================================================================*/
+
+#ifndef VCOS_RING_H
+#define VCOS_RING_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "vcos_types.h"
+#include "vcos_platform.h"
+
+/**
+ * \file
+ *
+ * A bounded lock-free multi-producer multi-consumer ring of pointers,
+ * intended as the one queue the buffer-passing layers share instead of
+ * each hand-rolling a mutex-protected linked list.
+ *
+ * Each slot carries a sequence number so producers and consumers claim
+ * positions with a single compare-and-swap and never touch a lock; full
+ * and empty are detected from the sequence without separate counters.
+ *
+ * Waiting is decoupled from the ring itself: a consumer that wants to
+ * sleep attaches a VCOS_EVENT_T with vcos_ring_set_event() and each push
+ * signals it. Pure polling users attach nothing and pay nothing.
+ */
+
+/** One ring slot: the sequence tracks whose turn the slot is. */
+typedef struct VCOS_RING_CELL_T
+{
+   volatile uint32_t seq;
+   void *data;
+} VCOS_RING_CELL_T;
+
+typedef struct VCOS_RING_T
+{
+   VCOS_RING_CELL_T *cells;      /**< slot array, slots entries */
+   uint32_t mask;                /**< slots - 1; slots is a power of two */
+   volatile uint32_t enqueue_pos;/**< next position producers claim */
+   volatile uint32_t dequeue_pos;/**< next position consumers claim */
+   VCOS_EVENT_T *event;          /**< signalled after each push, or NULL */
+} VCOS_RING_T;
+
+/** Create a ring.
+  *
+  * @param ring   Filled in with the ring on return.
+  * @param slots  Capacity; must be a power of two.
+  * @param name   A non-null name for the ring, used for diagnostics.
+  *
+  * @return VCOS_SUCCESS if the ring was created, or error code.
+  */
+VCOSPRE_ VCOS_STATUS_T VCOSPOST_ vcos_ring_create(VCOS_RING_T *ring,
+                                                  VCOS_UNSIGNED slots,
+                                                  const char *name);
+
+/** Delete a ring. The caller must ensure no thread is still using it.
+  */
+VCOSPRE_ void VCOSPOST_ vcos_ring_delete(VCOS_RING_T *ring);
+
+/** Attach (or detach, with NULL) an event signalled after each push, so
+  * consumers can sleep rather than poll. Call before the ring is shared.
+  */
+VCOSPRE_ void VCOSPOST_ vcos_ring_set_event(VCOS_RING_T *ring,
+                                            VCOS_EVENT_T *event);
+
+/** Push one element. Elements must be non-NULL, since pop uses NULL to
+  * mean empty.
+  *
+  * @return VCOS_SUCCESS, or VCOS_ENOSPC if the ring is full.
+  */
+VCOSPRE_ VCOS_STATUS_T VCOSPOST_ vcos_ring_push(VCOS_RING_T *ring, void *elem);
+
+/** Pop one element.
+  *
+  * @return The element, or NULL if the ring is empty.
+  */
+VCOSPRE_ void * VCOSPOST_ vcos_ring_pop(VCOS_RING_T *ring);
+
+/** Push several elements. Not atomic as a whole: each element is pushed
+  * individually and other threads' operations may interleave.
+  *
+  * @return The number of elements pushed; less than count only if the
+  * ring filled up.
+  */
+VCOSPRE_ VCOS_UNSIGNED VCOSPOST_ vcos_ring_push_batch(VCOS_RING_T *ring,
+                                                      void **elems,
+                                                      VCOS_UNSIGNED count);
+
+/** Pop up to max_elems elements. Not atomic as a whole.
+  *
+  * @return The number of elements popped.
+  */
+VCOSPRE_ VCOS_UNSIGNED VCOSPOST_ vcos_ring_pop_batch(VCOS_RING_T *ring,
+                                                     void **elems,
+                                                     VCOS_UNSIGNED max_elems);
+
+/** Return an instantaneous (and immediately stale) element count; useful
+  * for diagnostics only.
+  */
+VCOSPRE_ VCOS_UNSIGNED VCOSPOST_ vcos_ring_count(VCOS_RING_T *ring);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,145 @@
+/*
+Copyright (c) 2012, Broadcom Europe Ltd
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*=============================================================================
+VCOS - named shared-memory pools
+=============================================================================*/
+
+#ifndef VCOS_SHM_POOL_H
+#define VCOS_SHM_POOL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "vcos_types.h"
+#include "vcos_platform.h"
+
+/**
+ * \file
+ *
+ * A named pool of fixed-size blocks in shared memory, so two processes
+ * can exchange buffers without copying them through a socket. One
+ * process creates the pool, the others open it by name; blocks are
+ * handed between processes as offsets (each process maps the segment at
+ * its own address, so raw pointers do not travel).
+ *
+ * The free list lives in the segment itself and is lock-free, so an
+ * allocation in one process never blocks behind a free in another.
+ *
+ * Only available where the platform has cross-process shared memory;
+ * the pthreads implementation uses POSIX shm_open().
+ */
+
+/** Name length limit, matching VCOS_NAMED_SEMAPHORE_NAMELEN. */
+#define VCOS_SHM_POOL_NAMELEN 64
+
+/** The part of the pool that lives in the shared segment, at its start.
+  * Do not access the members directly.
+  */
+typedef struct VCOS_SHM_POOL_HDR_T
+{
+   uint32_t magic;              /**< For checking we opened what we expected */
+   uint32_t block_size;         /**< Rounded-up size of each block */
+   uint32_t num_blocks;         /**< Number of blocks in the pool */
+   uint32_t data_offset;        /**< Offset of the first block in the segment */
+   volatile uint64_t free_head; /**< Tagged head of the lock-free free list */
+} VCOS_SHM_POOL_HDR_T;
+
+/** Per-process pool handle. Do not access the members directly.
+  */
+typedef struct VCOS_SHM_POOL_T
+{
+   VCOS_SHM_POOL_HDR_T *hdr;    /**< The mapped segment */
+   size_t map_size;             /**< Total size of the mapping */
+   int fd;                      /**< The shared memory object */
+   int owner;                   /**< Non-zero in the creating process */
+   char name[VCOS_SHM_POOL_NAMELEN];
+} VCOS_SHM_POOL_T;
+
+/** Create a named pool of fixed-size blocks in shared memory. Fails if a
+  * pool of this name already exists.
+  *
+  * @param pool       Filled in with the pool handle on return.
+  * @param name       A name for the pool; other processes open it with this.
+  * @param num_blocks Number of blocks in the pool.
+  * @param block_size Size of each block; rounded up for alignment.
+  *
+  * @return VCOS_SUCCESS if the pool was created, or error code.
+  */
+VCOSPRE_ VCOS_STATUS_T VCOSPOST_ vcos_shm_pool_create(VCOS_SHM_POOL_T *pool,
+                                                      const char *name,
+                                                      VCOS_UNSIGNED num_blocks,
+                                                      VCOS_UNSIGNED block_size);
+
+/** Open an existing named pool created by another process.
+  *
+  * @param pool Filled in with the pool handle on return.
+  * @param name The name the pool was created with.
+  *
+  * @return VCOS_SUCCESS if the pool was opened, or error code.
+  */
+VCOSPRE_ VCOS_STATUS_T VCOSPOST_ vcos_shm_pool_open(VCOS_SHM_POOL_T *pool,
+                                                    const char *name);
+
+/** Close a pool handle, unmapping the segment. The creator's close also
+  * unlinks the name; blocks still mapped by other processes stay valid
+  * until they too close.
+  */
+VCOSPRE_ void VCOSPOST_ vcos_shm_pool_close(VCOS_SHM_POOL_T *pool);
+
+/** Allocate a block from the pool.
+  *
+  * @return The block, or NULL if the pool is exhausted.
+  */
+VCOSPRE_ void * VCOSPOST_ vcos_shm_pool_alloc(VCOS_SHM_POOL_T *pool);
+
+/** Return a block to the pool. Any process with the pool open may free a
+  * block, not just the one that allocated it.
+  */
+VCOSPRE_ void VCOSPOST_ vcos_shm_pool_free(VCOS_SHM_POOL_T *pool, void *block);
+
+/** Convert a block to its segment offset, for sending to another process.
+  */
+VCOSPRE_ uint32_t VCOSPOST_ vcos_shm_pool_offset(VCOS_SHM_POOL_T *pool,
+                                                 void *block);
+
+/** Convert a segment offset received from another process back into a
+  * pointer within this process's mapping. Returns NULL if the offset
+  * does not denote a block of this pool.
+  */
+VCOSPRE_ void * VCOSPOST_ vcos_shm_pool_block(VCOS_SHM_POOL_T *pool,
+                                              uint32_t offset);
+
+/** Return the usable size of each block.
+  */
+VCOSPRE_ VCOS_UNSIGNED VCOSPOST_ vcos_shm_pool_block_size(VCOS_SHM_POOL_T *pool);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,132 @@
+/*
+Copyright (c) 2012, Broadcom Europe Ltd
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*=============================================================================
+VCOS - shared telemetry counter page
+=============================================================================*/
+
+#ifndef VCOS_TELEMETRY_H
+#define VCOS_TELEMETRY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "vcos_types.h"
+/* Needed before vcos_platform.h so this header also works standalone,
+ * e.g. for monitoring tools which only want the page layout */
+#include "vcos_assert.h"
+#include "vcos_platform.h"
+
+/**
+ * \file
+ *
+ * A single page of named counters in shared memory, so the different
+ * subsystems in a process (and different processes) publish into one
+ * place and a monitoring tool gets the whole picture from one mapping.
+ *
+ * Publishers register a counter by name once and then bump it with an
+ * atomic add; the registration cost is a linear scan of the page so
+ * callers are expected to cache the returned pointer. Readers map the
+ * segment read-only and walk the slots - no library calls needed, the
+ * layout below is the wire format.
+ *
+ * Counters are 32 bit and wrap; readers interested in rates should
+ * sample and difference them. If two processes register the same name
+ * at the same instant the name can end up in two slots, so readers
+ * should sum slots with equal names.
+ *
+ * Only available where the platform has cross-process shared memory;
+ * the pthreads implementation uses POSIX shm_open().
+ */
+
+/** Name of the shared memory object the page lives in, without the
+  * leading slash shm_open() wants. */
+#define VCOS_TELEMETRY_SHM_NAME "vcos-telemetry"
+
+/** Counter names are truncated to this, including the terminator. */
+#define VCOS_TELEMETRY_NAMELEN 24
+
+/** Number of counter slots in the page. */
+#define VCOS_TELEMETRY_SLOTS 127
+
+/** Slot states, lifecycle is FREE -> CLAIMED -> LIVE. A reader should
+  * ignore any slot which is not LIVE. */
+#define VCOS_TELEMETRY_SLOT_FREE    0
+#define VCOS_TELEMETRY_SLOT_CLAIMED 1
+#define VCOS_TELEMETRY_SLOT_LIVE    2
+
+#define VCOS_TELEMETRY_MAGIC 0x56435459 /* 'VCTY' */
+
+/** One named counter. */
+typedef struct VCOS_TELEMETRY_SLOT_T
+{
+   volatile uint32_t state;              /**< VCOS_TELEMETRY_SLOT_XXX */
+   char name[VCOS_TELEMETRY_NAMELEN];    /**< Zero terminated counter name */
+   volatile uint32_t value;              /**< The counter itself, wraps */
+} VCOS_TELEMETRY_SLOT_T;
+
+/** The whole shared page. */
+typedef struct VCOS_TELEMETRY_PAGE_T
+{
+   uint32_t magic;                       /**< VCOS_TELEMETRY_MAGIC once initialised */
+   uint32_t version;                     /**< Layout version, currently 1 */
+   uint32_t num_slots;                   /**< VCOS_TELEMETRY_SLOTS of the writer */
+   uint32_t pad;
+   VCOS_TELEMETRY_SLOT_T slots[VCOS_TELEMETRY_SLOTS];
+} VCOS_TELEMETRY_PAGE_T;
+
+/** Find or create the counter with the given name.
+  *
+  * The shared page is mapped on first use; if that fails the counters
+  * silently fall back to a process-local page so call sites never have
+  * to care.
+  *
+  * @param name  counter name, conventionally "subsystem.what"
+  *
+  * @return pointer to the counter, valid for the life of the process,
+  *         or NULL if the page is full
+  */
+VCOSPRE_ volatile uint32_t * VCOSPOST_ vcos_telemetry_counter(const char *name);
+
+/** Atomically add to a counter returned by vcos_telemetry_counter().
+  * A NULL counter is ignored, so callers need not check registration
+  * succeeded on their fast path.
+  */
+VCOSPRE_ void VCOSPOST_ vcos_telemetry_add(volatile uint32_t *counter, uint32_t n);
+
+/** Return the mapped page, for in-process readers. NULL if the shared
+  * segment could not be mapped and nothing has registered a counter
+  * (the process-local fallback page is returned once it exists).
+  */
+VCOSPRE_ const VCOS_TELEMETRY_PAGE_T * VCOSPOST_ vcos_telemetry_page(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VCOS_TELEMETRY_H */
@@ -220,6 +220,20 @@ uint32_t vcos_getmicrosecs(void);
 VCOS_INLINE_DECL
 uint64_t vcos_getmicrosecs64(void);
 
+/**
+  * \brief Return the value of a monotonic microsecond counter.
+  *
+  * Unlike vcos_getmicrosecs() this does not move with settimeofday() or
+  * NTP adjustment, so it is the one to use for stamping buffers and
+  * measuring intervals on hot paths. Where the platform has a vDSO the
+  * read stays in user space, so it is also the cheapest clock available.
+  */
+VCOS_INLINE_DECL
+uint32_t vcos_getmonotonicmicrosecs(void);
+
+VCOS_INLINE_DECL
+uint64_t vcos_getmonotonicmicrosecs64(void);
+
 #define vcos_get_ms() (vcos_getmicrosecs()/1000)
 
 /**
@@ -75,6 +75,31 @@ void vcos_thread_attr_setpriority(VCOS_THREAD_ATTR_T *attrs, VCOS_UNSIGNED pri);
 VCOS_INLINE_DECL
 void vcos_thread_attr_setaffinity(VCOS_THREAD_ATTR_T *attrs, VCOS_UNSIGNED aff);
 
+/** Scheduling classes for vcos_thread_attr_setschedpolicy(). Only honoured
+  * by platforms with a kernel scheduler (the pthreads backend maps these to
+  * SCHED_OTHER/SCHED_FIFO/SCHED_RR); elsewhere they are ignored.
+  */
+#define VCOS_THREAD_SCHED_DEFAULT 0  /**< inherit the creator's policy */
+#define VCOS_THREAD_SCHED_OTHER   1  /**< normal timesharing */
+#define VCOS_THREAD_SCHED_FIFO    2  /**< realtime, run to block */
+#define VCOS_THREAD_SCHED_RR      3  /**< realtime, round robin */
+
+/** Set the scheduling class. If not set, the thread inherits its creator's.
+  * For the realtime classes the priority set with
+  * vcos_thread_attr_setpriority() is mapped onto the policy's priority
+  * range. Creating a realtime thread usually needs privilege; if that is
+  * missing the thread is created with the inherited policy instead.
+  */
+VCOS_INLINE_DECL
+void vcos_thread_attr_setschedpolicy(VCOS_THREAD_ATTR_T *attrs, VCOS_UNSIGNED policy);
+
+/** Restrict the thread to a set of cpus, given as a bitmask with bit n
+  * meaning cpu n. 0 (the default) leaves the thread free to run anywhere.
+  * Only honoured by platforms with per-cpu scheduling; elsewhere ignored.
+  */
+VCOS_INLINE_DECL
+void vcos_thread_attr_setcpuset(VCOS_THREAD_ATTR_T *attrs, VCOS_UNSIGNED cpuset);
+
 /** Set the timeslice. If not set the default will be used.
   */
 VCOS_INLINE_DECL
@@ -0,0 +1,72 @@
+/*
+Copyright (c) 2012, Broadcom Europe Ltd
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*=============================================================================
+VideoCore OS Abstraction Layer - statically-defined userspace tracepoints
+=============================================================================*/
+
+#ifndef VCOS_USDT_H
+#define VCOS_USDT_H
+
+/**
+ * \file vcos_usdt.h
+ *
+ * Statically-defined userspace tracepoints (USDT).
+ *
+ * When the build defines VCOS_WANT_USDT, these macros compile to USDT probe
+ * sites which tracers such as bpftrace, perf or systemtap can attach to on a
+ * live process. A probe site is a single nop instruction until a tracer
+ * attaches, so probes can be left on per-buffer hot paths with no
+ * steady-state cost, unlike log calls which always format their arguments.
+ * Without VCOS_WANT_USDT the macros compile to nothing at all.
+ *
+ * Requires the systemtap sys/sdt.h header at build time when enabled.
+ */
+
+#ifdef VCOS_WANT_USDT
+
+#include <sys/sdt.h>
+
+#define VCOS_PROBE1(provider, name, a) \
+   DTRACE_PROBE1(provider, name, a)
+#define VCOS_PROBE2(provider, name, a, b) \
+   DTRACE_PROBE2(provider, name, a, b)
+#define VCOS_PROBE3(provider, name, a, b, c) \
+   DTRACE_PROBE3(provider, name, a, b, c)
+#define VCOS_PROBE4(provider, name, a, b, c, d) \
+   DTRACE_PROBE4(provider, name, a, b, c, d)
+
+#else /* VCOS_WANT_USDT */
+
+#define VCOS_PROBE1(provider, name, a) (void)0
+#define VCOS_PROBE2(provider, name, a, b) (void)0
+#define VCOS_PROBE3(provider, name, a, b, c) (void)0
+#define VCOS_PROBE4(provider, name, a, b, c, d) (void)0
+
+#endif /* VCOS_WANT_USDT */
+
+#endif /* VCOS_USDT_H */
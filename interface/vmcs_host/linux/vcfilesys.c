@@ -88,6 +88,18 @@ struct fs_dir
    DIR *dhandle;
    int pathlen;
    char pathbuf[PATH_MAX];
+
+   /* Bulk enumeration: the whole directory is scanned in one pass into a
+      packed record array the first time it is read, and every subsequent
+      entry is served from memory. The firmware still asks for entries one
+      message at a time (the wire protocol is fixed), but each request now
+      costs a lookup instead of a readdir plus a stat on the media. A
+      completed iteration discards the scan, so the next pass sees fresh
+      contents, as the old rewinddir behaviour did. */
+   struct fs_dirent *entries;
+   int num_entries;
+   int max_entries;
+   int next_entry;      /* -1 until a scan has run */
 };
 
 /*
@@ -509,6 +521,8 @@ int vc_hostfs_closedir(void *dhandle)
    {
       (void)closedir(fsdir->dhandle);
       fsdir->dhandle = NULL;
+      if (fsdir->entries)
+         free(fsdir->entries);
       free(fsdir);
       ret = 0;
    }
@@ -731,6 +745,10 @@ void *vc_hostfs_opendir(const char *dirname)
          {
             fsdir->pathlen = len;
             fsdir->dhandle = dhandle;
+            fsdir->entries = NULL;
+            fsdir->num_entries = 0;
+            fsdir->max_entries = 0;
+            fsdir->next_entry = -1;
          }
          else
          {
@@ -762,6 +780,56 @@ RETURNS
    End of directory stream: NULL
 ******************************************************************************/
 
+/* One-pass scan of the whole directory into the packed record array of
+   fsdir, growing the array as needed. Entries which cannot be stat'ed are
+   skipped, as before. */
+static void fs_dir_scan(struct fs_dir *fsdir)
+{
+   struct dirent *dent;
+
+   fsdir->num_entries = 0;
+   rewinddir(fsdir->dhandle);
+
+   while ((dent = readdir(fsdir->dhandle)) != NULL)
+   {
+      struct stat statbuf;
+      struct fs_dirent *entry;
+      int ret;
+
+      /* Append the filename, and stat the resulting path */
+      fsdir->pathbuf[fsdir->pathlen] = '/';
+      vcos_safe_strcpy(fsdir->pathbuf, dent->d_name, sizeof(fsdir->pathbuf), fsdir->pathlen + 1);
+      ret = stat(fsdir->pathbuf, &statbuf);
+      fsdir->pathbuf[fsdir->pathlen] = '\0';
+
+      if (ret != 0)
+         continue;
+
+      if (fsdir->num_entries == fsdir->max_entries)
+      {
+         int max = fsdir->max_entries ? fsdir->max_entries * 2 : 256;
+         struct fs_dirent *entries = (struct fs_dirent *)realloc(fsdir->entries, max * sizeof(*entries));
+         if (!entries)
+            break; /* serve what we have */
+         fsdir->entries = entries;
+         fsdir->max_entries = max;
+      }
+
+      entry = &fsdir->entries[fsdir->num_entries++];
+      vcos_safe_strcpy(entry->d_name, dent->d_name, sizeof(entry->d_name), 0);
+      entry->d_size = (statbuf.st_size <= 0xffffffff) ? (unsigned int)statbuf.st_size : 0xffffffff;
+      entry->d_attrib = ATTR_NORMAL;
+      if ((statbuf.st_mode & S_IWUSR) == 0)
+         entry->d_attrib |= ATTR_RDONLY;
+      if (statbuf.st_mode & S_IFDIR)
+         entry->d_attrib |= ATTR_DIRENT;
+      entry->d_creatime = statbuf.st_ctime;
+      entry->d_modtime = statbuf.st_mtime;
+   }
+
+   fsdir->next_entry = 0;
+}
+
 struct fs_dirent *vc_hostfs_readdir_r(void *dhandle, struct fs_dirent *result)
 {
    struct fs_dir *fsdir = (struct fs_dir *)dhandle;
@@ -770,39 +838,20 @@ struct fs_dirent *vc_hostfs_readdir_r(void *dhandle, struct fs_dirent *result)
 
    if (fsdir && result)
    {
-      struct dirent *dent;
+      if (fsdir->next_entry < 0)
+         fs_dir_scan(fsdir);
 
-      while ((dent = readdir(fsdir->dhandle)) != NULL)
+      if (fsdir->next_entry < fsdir->num_entries)
       {
-         struct stat statbuf;
-         int ret;
-
-         /* Append the filename, and stat the resulting path */
-         fsdir->pathbuf[fsdir->pathlen] = '/';
-         vcos_safe_strcpy(fsdir->pathbuf, dent->d_name, sizeof(fsdir->pathbuf), fsdir->pathlen + 1);
-         ret = stat(fsdir->pathbuf, &statbuf);
-         fsdir->pathbuf[fsdir->pathlen] = '\0';
-
-         if (ret == 0)
-         {
-            vcos_safe_strcpy(result->d_name, dent->d_name, sizeof(result->d_name), 0);
-            result->d_size = (statbuf.st_size <= 0xffffffff) ? (unsigned int)statbuf.st_size : 0xffffffff;
-            result->d_attrib = ATTR_NORMAL;
-            if ((statbuf.st_mode & S_IWUSR) == 0)
-               result->d_attrib |= ATTR_RDONLY;
-            if (statbuf.st_mode & S_IFDIR)
-               result->d_attrib |= ATTR_DIRENT;
-            result->d_creatime = statbuf.st_ctime;
-            result->d_modtime = statbuf.st_mtime;
-            DEBUG_MINOR( "vc_hostfs_readdir_r() = '%s', %x, %x", result->d_name, result->d_size, result->d_attrib );
-            break;
-         }
+         *result = fsdir->entries[fsdir->next_entry++];
+         DEBUG_MINOR( "vc_hostfs_readdir_r() = '%s', %x, %x", result->d_name, result->d_size, result->d_attrib );
       }
-
-      if (!dent)
+      else
       {
          DEBUG_MINOR( "vc_hostfs_readdir_r() = NULL" );
-         rewinddir(fsdir->dhandle);
+         /* End of the iteration - rescan on the next call, so a further
+            pass sees fresh contents, as the old rewinddir behaviour did */
+         fsdir->next_entry = -1;
          result = NULL;
       }
    }
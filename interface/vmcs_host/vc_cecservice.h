@@ -73,6 +73,19 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 typedef void (*CECSERVICE_CALLBACK_T)(void *callback_data, uint32_t reason, uint32_t param1, uint32_t param2, uint32_t param3, uint32_t param4);
 
+/**
+ * Completion callback for <DFN>vc_cec_send_message_async</DFN>.
+ *
+ * @param callback_data is the context passed in by the user when the message was queued
+ *
+ * @param status is the command response from CEC service (zero means the
+ *               message was accepted for transmission; the usual Tx
+ *               notification still follows to report the acknowledgement)
+ *
+ * @return void
+ */
+typedef void (*CECSERVICE_SEND_CALLBACK_T)(void *callback_data, int32_t status);
+
 //API at application start time
 /**
  * Call <DFN>vc_vchi_cec_init</DFN> to initialise the CEC service for use.
@@ -189,6 +202,36 @@ VCHPRE_ int VCHPOST_ vc_cec_send_message(const uint32_t follower,
                                          const uint8_t *payload,
                                          uint32_t length,
                                          vcos_bool_t is_reply);
+
+/**
+ * <DFN>vc_cec_send_message_async</DFN> queues a CEC message for
+ * transmission and returns immediately, without waiting for the command
+ * response from CEC service. The message is sent from a dedicated task
+ * and the outcome reported via the optional completion callback, so
+ * callers sharing a thread with display management are never stalled.
+ * The queue is bounded: if it is full the message is NOT queued and the
+ * caller should retry or fall back to <DFN>vc_cec_send_message</DFN>.
+ *
+ * @param Follower's logical address
+ *
+ * @param Message payload WITHOUT the header byte (can be NULL)
+ *
+ * @param Payload length WITHOUT the header byte (can be zero)
+ *
+ * @param VC_TRUE if the message is a reply to an incoming message
+ *
+ * @param completion callback (can be NULL)
+ *
+ * @param context passed to the completion callback
+ *
+ * @return zero if the message was queued, non-zero otherwise (e.g. queue full)
+ ***********************************************************/
+VCHPRE_ int VCHPOST_ vc_cec_send_message_async(const uint32_t follower,
+                                               const uint8_t *payload,
+                                               uint32_t length,
+                                               vcos_bool_t is_reply,
+                                               CECSERVICE_SEND_CALLBACK_T callback,
+                                               void *callback_data);
 /**
  * <DFN>vc_cec_get_logical_address</DFN> gets the logical address, 
  * If one is being allocated 0xF (unregistered) will be set.
@@ -51,6 +51,8 @@ VCHPRE_ DISPMANX_RESOURCE_HANDLE_T VCHPOST_ vc_dispmanx_resource_create( VC_IMAG
 // Write the bitmap data to VideoCore memory
 VCHPRE_ int VCHPOST_ vc_dispmanx_resource_write_data( DISPMANX_RESOURCE_HANDLE_T res, VC_IMAGE_TYPE_T src_type, int src_pitch, void * src_address, const VC_RECT_T * rect );
 VCHPRE_ int VCHPOST_ vc_dispmanx_resource_write_data_handle( DISPMANX_RESOURCE_HANDLE_T res, VC_IMAGE_TYPE_T src_type, int src_pitch, VCHI_MEM_HANDLE_T handle, uint32_t offset, const VC_RECT_T * rect );
+// Read the bitmap data straight into a relocatable buffer (e.g. shared memory)
+VCHPRE_ int VCHPOST_ vc_dispmanx_resource_read_data_handle( DISPMANX_RESOURCE_HANDLE_T res, const VC_RECT_T * rect, VCHI_MEM_HANDLE_T handle, uint32_t offset, uint32_t dst_pitch );
 VCHPRE_ int VCHPOST_ vc_dispmanx_resource_read_data(
                               DISPMANX_RESOURCE_HANDLE_T handle,
                               const VC_RECT_T* p_rect,
@@ -101,6 +103,10 @@ VCHPRE_ int VCHPOST_ vc_dispmanx_element_remove( DISPMANX_UPDATE_HANDLE_T update
 VCHPRE_ int VCHPOST_ vc_dispmanx_update_submit( DISPMANX_UPDATE_HANDLE_T update, DISPMANX_CALLBACK_FUNC_T cb_func, void *cb_arg );
 // End an update and wait for it to complete
 VCHPRE_ int VCHPOST_ vc_dispmanx_update_submit_sync( DISPMANX_UPDATE_HANDLE_T update );
+// Start recording element operations client-side instead of sending each one separately
+VCHPRE_ int VCHPOST_ vc_dispmanx_batch_start( void );
+// Send everything recorded since vc_dispmanx_batch_start in one go
+VCHPRE_ int VCHPOST_ vc_dispmanx_batch_submit( void );
 // Query the image formats supported in the VMCS build
 VCHPRE_ int VCHPOST_ vc_dispmanx_query_image_formats( uint32_t *supported_formats );
 
@@ -124,10 +130,19 @@ VCHPRE_ void VCHPOST_ vc_vchi_dispmanx_init (VCHI_INSTANCE_T initialise_instance
 // Take a snapshot of a display in its current state.
 // This call may block for a time; when it completes, the snapshot is ready.
 // only transform=0 is supported
-VCHPRE_ int VCHPOST_ vc_dispmanx_snapshot( DISPMANX_DISPLAY_HANDLE_T display, 
-                                           DISPMANX_RESOURCE_HANDLE_T snapshot_resource, 
+VCHPRE_ int VCHPOST_ vc_dispmanx_snapshot( DISPMANX_DISPLAY_HANDLE_T display,
+                                           DISPMANX_RESOURCE_HANDLE_T snapshot_resource,
                                            DISPMANX_TRANSFORM_T transform );
 
+// Take a snapshot of just a region of a display into the matching region
+// of the resource, so repeated captures into a persistent resource only
+// pay for the pixels that changed.
+// only transform=0 is supported
+VCHPRE_ int VCHPOST_ vc_dispmanx_snapshot_region( DISPMANX_DISPLAY_HANDLE_T display,
+                                                  DISPMANX_RESOURCE_HANDLE_T snapshot_resource,
+                                                  const VC_RECT_T *rect,
+                                                  DISPMANX_TRANSFORM_T transform );
+
 // Set the resource palette (for VC_IMAGE_4BPP and VC_IMAGE_8BPP)
 VCHPRE_ int VCHPOST_ vc_dispmanx_resource_set_palette( DISPMANX_RESOURCE_HANDLE_T handle, 
                                                       void * src_address, int offset, int size);
@@ -81,6 +81,39 @@ static VCOS_EVENT_T cecservice_notify_available_event;
 static VCOS_THREAD_T cecservice_notify_task;
 static uint32_t cecservice_log_initialised = 0;
 
+//Notifications are first drained from the VCHI fifo into this ring and
+//only then dispatched to the registered callback, so a TV power-on flood
+//does not back up the fifo while a slow callback runs. Consecutive
+//identical events (button auto-repeat etc.) are coalesced into one entry.
+//The ring is only ever touched by the notify task, so it needs no lock.
+#define CECSERVICE_EVENT_RING_SIZE 32
+typedef struct {
+   uint32_t reason;
+   uint32_t param1;
+   uint32_t param2;
+   uint32_t param3;
+   uint32_t param4;
+   uint32_t repeats; //number of further identical events coalesced into this one
+} CECSERVICE_EVENT_T;
+static CECSERVICE_EVENT_T cecservice_event_ring[CECSERVICE_EVENT_RING_SIZE];
+
+//Asynchronous transmit queue. Producers only take the short tx lock to
+//claim a slot; the blocking send (and the wait for the command response)
+//happens on the dedicated tx task, which then reports the outcome via the
+//per-message completion callback.
+#define CECSERVICE_TX_RING_SIZE 16
+typedef struct {
+   CEC_SEND_MSG_PARAM_T param;
+   CECSERVICE_SEND_CALLBACK_T callback;
+   void *callback_data;
+} CECSERVICE_TX_REQ_T;
+static CECSERVICE_TX_REQ_T cecservice_tx_ring[CECSERVICE_TX_RING_SIZE];
+static volatile uint32_t cecservice_tx_head; //next request to send, owned by the tx task
+static volatile uint32_t cecservice_tx_tail; //next free slot, owned by senders under the tx lock
+static VCOS_MUTEX_T cecservice_tx_lock;
+static VCOS_EVENT_T cecservice_tx_available_event;
+static VCOS_THREAD_T cecservice_tx_task;
+
 //Command strings - must match what's in vc_cecservice_defs.h
 static char* cecservice_command_strings[] = {
    "register_cmd",
@@ -185,6 +218,7 @@ static int32_t cecservice_send_command_reply( uint32_t command, void *buffer, ui
                                               void *response, uint32_t max_length);
 
 static void *cecservice_notify_func(void *arg);
+static void *cecservice_tx_func(void *arg);
 
 static void cecservice_logging_init(void);
 
@@ -232,6 +266,11 @@ VCHPRE_ void VCHPOST_ vc_vchi_cec_init(VCHI_INSTANCE_T initialise_instance, VCHI
    vcos_assert(status == VCOS_SUCCESS);
    status = vcos_event_create(&cecservice_notify_available_event, "HCEC");
    vcos_assert(status == VCOS_SUCCESS);
+   status = vcos_mutex_create(&cecservice_tx_lock, "HCEC Tx");
+   vcos_assert(status == VCOS_SUCCESS);
+   status = vcos_event_create(&cecservice_tx_available_event, "HCEC Tx");
+   vcos_assert(status == VCOS_SUCCESS);
+   cecservice_tx_head = cecservice_tx_tail = 0;
 
    cecservice_client.topology = vcos_malloc_aligned(sizeof(VC_CEC_TOPOLOGY_T), 16, "HCEC topology");
    vcos_assert(cecservice_client.topology);
@@ -291,6 +330,9 @@ VCHPRE_ void VCHPOST_ vc_vchi_cec_init(VCHI_INSTANCE_T initialise_instance, VCHI
    status = vcos_thread_create(&cecservice_notify_task, "HCEC Notify", &attrs, cecservice_notify_func, &cecservice_client);
    vcos_assert(status == VCOS_SUCCESS);
 
+   status = vcos_thread_create(&cecservice_tx_task, "HCEC Tx", &attrs, cecservice_tx_func, &cecservice_client);
+   vcos_assert(status == VCOS_SUCCESS);
+
    cecservice_client.initialised = 1;
    vc_cec_log_info("CEC service initialised");
 }
@@ -333,9 +375,13 @@ VCHPRE_ void VCHPOST_ vc_vchi_cec_stop( void ) {
       cecservice_client.to_exit = 1;
       vcos_event_signal(&cecservice_notify_available_event);
       vcos_thread_join(&cecservice_notify_task, &dummy);
+      vcos_event_signal(&cecservice_tx_available_event);
+      vcos_thread_join(&cecservice_tx_task, &dummy);
       vcos_mutex_delete(&cecservice_client.lock);
       vcos_event_delete(&cecservice_message_available_event);
       vcos_event_delete(&cecservice_notify_available_event);
+      vcos_mutex_delete(&cecservice_tx_lock);
+      vcos_event_delete(&cecservice_tx_available_event);
       vcos_free(cecservice_client.topology);
       vc_cec_log_info("CEC service stopped");
    }
@@ -558,72 +604,138 @@ static void *cecservice_notify_func(void *arg) {
    vc_cec_log_info("CEC service async thread started");
    while(1) {
       VCOS_STATUS_T status = vcos_event_wait(&cecservice_notify_available_event);
-      uint32_t cb_reason_str_idx = max_notify_strings - 1;
+      uint32_t num_events, i;
       if(status != VCOS_SUCCESS || !state->initialised || state->to_exit)
          break;
 
       do {
-         uint32_t reason, param1, param2, param3, param4;
-         //Get all notifications in the queue
-         success = vchi_msg_dequeue( state->notify_handle[0], state->notify_buffer, sizeof(state->notify_buffer), &state->notify_length, VCHI_FLAGS_NONE );
-         if(success != 0 || state->notify_length < sizeof(uint32_t)*5 ) { //reason + 4x32-bit parameter
-            continue;
+         //First drain the fifo into the event ring, coalescing consecutive
+         //identical events, so the fifo is freed up before any callback runs
+         num_events = 0;
+         do {
+            CECSERVICE_EVENT_T event;
+            success = vchi_msg_dequeue( state->notify_handle[0], state->notify_buffer, sizeof(state->notify_buffer), &state->notify_length, VCHI_FLAGS_NONE );
+            if(success != 0 || state->notify_length < sizeof(uint32_t)*5 ) { //reason + 4x32-bit parameter
+               break;
+            }
+
+            //All notifications are of format: reason, param1, param2, param3, param4 (all 32-bit unsigned int)
+            event.reason = VC_VTOH32(state->notify_buffer[0]);
+            event.param1 = VC_VTOH32(state->notify_buffer[1]);
+            event.param2 = VC_VTOH32(state->notify_buffer[2]);
+            event.param3 = VC_VTOH32(state->notify_buffer[3]);
+            event.param4 = VC_VTOH32(state->notify_buffer[4]);
+            event.repeats = 0;
+
+            if(num_events > 0) {
+               CECSERVICE_EVENT_T *prev = &cecservice_event_ring[num_events - 1];
+               if(prev->reason == event.reason && prev->param1 == event.param1 &&
+                  prev->param2 == event.param2 && prev->param3 == event.param3 &&
+                  prev->param4 == event.param4) {
+                  prev->repeats++;
+                  continue;
+               }
+            }
+            cecservice_event_ring[num_events++] = event;
+         } while(num_events < CECSERVICE_EVENT_RING_SIZE);
+
+         //Now dispatch the batch
+         for(i = 0; i < num_events; i++) {
+            CECSERVICE_EVENT_T *event = &cecservice_event_ring[i];
+            uint32_t cb_reason_str_idx = max_notify_strings - 1;
+
+            //Store away physical/logical addresses
+            if(CEC_CB_REASON(event->reason) == VC_CEC_LOGICAL_ADDR) {
+               state->logical_address = (CEC_DEVICE_TYPE_T) event->param1;
+               state->physical_address = (uint16_t) (event->param2 & 0xFFFF);
+            }
+
+            switch(CEC_CB_REASON(event->reason)) {
+            case VC_CEC_NOTIFY_NONE:
+               cb_reason_str_idx = 0; break;
+            case VC_CEC_TX:
+               cb_reason_str_idx = 1; break;
+            case VC_CEC_RX:
+               cb_reason_str_idx = 2; break;
+            case VC_CEC_BUTTON_PRESSED:
+               cb_reason_str_idx = 3; break;
+            case VC_CEC_BUTTON_RELEASE:
+               cb_reason_str_idx = 4; break;
+            case VC_CEC_REMOTE_PRESSED:
+               cb_reason_str_idx = 5; break;
+            case VC_CEC_REMOTE_RELEASE:
+               cb_reason_str_idx = 6; break;
+            case VC_CEC_LOGICAL_ADDR:
+               cb_reason_str_idx = 7; break;
+            case VC_CEC_TOPOLOGY:
+               cb_reason_str_idx = 8; break;
+            case VC_CEC_LOGICAL_ADDR_LOST:
+               cb_reason_str_idx = 9; break;
+            }
+
+            vc_cec_log_info("CEC service callback [%s]: 0x%x, 0x%x, 0x%x, 0x%x",
+                            cecservice_notify_strings[cb_reason_str_idx],
+                            event->param1, event->param2, event->param3, event->param4);
+            if(event->repeats)
+               vc_cec_log_info("CEC service callback [%s]: coalesced %d identical events",
+                               cecservice_notify_strings[cb_reason_str_idx], event->repeats);
+
+            if(state->notify_fn) {
+               (*state->notify_fn)(state->notify_data, event->reason,
+                                   event->param1, event->param2, event->param3, event->param4);
+            } else {
+               vc_cec_log_info("CEC service: No callback handler specified, callback [%s] swallowed",
+                               cecservice_notify_strings[cb_reason_str_idx]);
+            }
          }
+      } while(num_events == CECSERVICE_EVENT_RING_SIZE); //ring filled - the fifo may hold more
+   } //while (1)
 
-         //if(lock_obtain() != 0)
-         //   break;
-         //All notifications are of format: reason, param1, param2, param3, param4 (all 32-bit unsigned int)
-         reason = VC_VTOH32(state->notify_buffer[0]);
-         param1 = VC_VTOH32(state->notify_buffer[1]);
-         param2 = VC_VTOH32(state->notify_buffer[2]);
-         param3 = VC_VTOH32(state->notify_buffer[3]);
-         param4 = VC_VTOH32(state->notify_buffer[4]);
-         //lock_release();
-
-         //Store away physical/logical addresses
-         if(CEC_CB_REASON(reason) == VC_CEC_LOGICAL_ADDR) {
-            state->logical_address = (CEC_DEVICE_TYPE_T) param1;
-            state->physical_address = (uint16_t) (param2 & 0xFFFF);
-         }
-         
-         switch(CEC_CB_REASON(reason)) {
-         case VC_CEC_NOTIFY_NONE:
-            cb_reason_str_idx = 0; break;
-         case VC_CEC_TX:
-            cb_reason_str_idx = 1; break;
-         case VC_CEC_RX:
-            cb_reason_str_idx = 2; break;
-         case VC_CEC_BUTTON_PRESSED:
-            cb_reason_str_idx = 3; break;
-         case VC_CEC_BUTTON_RELEASE:
-            cb_reason_str_idx = 4; break;
-         case VC_CEC_REMOTE_PRESSED:
-            cb_reason_str_idx = 5; break;
-         case VC_CEC_REMOTE_RELEASE:
-            cb_reason_str_idx = 6; break;
-         case VC_CEC_LOGICAL_ADDR:
-            cb_reason_str_idx = 7; break;
-         case VC_CEC_TOPOLOGY:
-            cb_reason_str_idx = 8; break;
-         case VC_CEC_LOGICAL_ADDR_LOST:
-            cb_reason_str_idx = 9; break;
-         }
+   if(state->to_exit)
+      vc_cec_log_info("CEC service async thread exiting");
 
-         vc_cec_log_info("CEC service callback [%s]: 0x%x, 0x%x, 0x%x, 0x%x",
-                         cecservice_notify_strings[cb_reason_str_idx], param1, param2, param3, param4);
+   return 0;
+}
 
-         if(state->notify_fn) {
-            (*state->notify_fn)(state->notify_data, reason, param1, param2, param3, param4);
-         } else {
-            vc_cec_log_info("CEC service: No callback handler specified, callback [%s] swallowed",
-                            cecservice_notify_strings[cb_reason_str_idx]);
-         }
+/***********************************************************
+ * Name: cecservice_tx_func
+ *
+ * Arguments: CEC service state
+ *
+ * Description: This task drains the asynchronous transmit queue.
+ *              The blocking send (and the wait for the command
+ *              response) happens here rather than on the caller's
+ *              thread; the outcome is reported via the per-message
+ *              completion callback
+ *
+ * Returns: does not return
+ *
+ ***********************************************************/
+static void *cecservice_tx_func(void *arg) {
+   CECSERVICE_HOST_STATE_T *state = (CECSERVICE_HOST_STATE_T *) arg;
 
-      } while(success == 0 && state->notify_length >= sizeof(uint32_t)*5); //read the next message if any
-   } //while (1)
+   vc_cec_log_info("CEC service tx thread started");
+   while(1) {
+      VCOS_STATUS_T status = vcos_event_wait(&cecservice_tx_available_event);
+      if(status != VCOS_SUCCESS || !state->initialised || state->to_exit)
+         break;
 
-   if(state->to_exit)
-      vc_cec_log_info("CEC service async thread exiting");
+      while(cecservice_tx_head != cecservice_tx_tail) {
+         CECSERVICE_TX_REQ_T *req = &cecservice_tx_ring[cecservice_tx_head % CECSERVICE_TX_RING_SIZE];
+         int32_t response = cecservice_send_command( VC_CEC_SEND_MSG, &req->param, sizeof(req->param), 1);
+         if(req->callback)
+            (*req->callback)(req->callback_data, response);
+         cecservice_tx_head++; //frees the slot for producers
+      }
+   }
+
+   if(state->to_exit) {
+      if(cecservice_tx_head != cecservice_tx_tail)
+         vc_cec_log_info("CEC service tx thread exiting with %d messages still queued",
+                         cecservice_tx_tail - cecservice_tx_head);
+      else
+         vc_cec_log_info("CEC service tx thread exiting");
+   }
 
    return 0;
 }
@@ -779,6 +891,67 @@ VCHPRE_ int VCHPOST_ vc_cec_send_message(const uint32_t follower,
    return success;
 }
 
+/***********************************************************
+ * Name: vc_cec_send_message_async
+ *
+ * Arguments:
+ *       Follower's logical address
+ *       Message payload WITHOUT the header byte (can be NULL)
+ *       Payload length WITHOUT the header byte (can be zero)
+ *       VC_TRUE if the message is a reply to an incoming message
+ *       Completion callback (can be NULL) and its context
+ *
+ * Description
+ *       As vc_cec_send_message, but the message is queued and sent from
+ *       a dedicated task so the caller never blocks on the transport.
+ *       The command response is reported via the completion callback;
+ *       the usual Tx notification still follows in due course
+ *
+ * Returns: zero if the message was queued, non-zero otherwise (e.g.
+ *          queue full - the message is NOT queued in that case)
+ ***********************************************************/
+VCHPRE_ int VCHPOST_ vc_cec_send_message_async(const uint32_t follower,
+                                               const uint8_t *payload,
+                                               uint32_t length,
+                                               vcos_bool_t is_reply,
+                                               CECSERVICE_SEND_CALLBACK_T callback,
+                                               void *callback_data) {
+   CECSERVICE_TX_REQ_T *req;
+   if(!vcos_verify(length <= CEC_MAX_XMIT_LENGTH))
+      return -1;
+   if(!cecservice_client.initialised)
+      return -1;
+
+   if(vcos_mutex_lock(&cecservice_tx_lock) != VCOS_SUCCESS)
+      return -1;
+
+   if(cecservice_tx_tail - cecservice_tx_head >= CECSERVICE_TX_RING_SIZE) {
+      vcos_mutex_unlock(&cecservice_tx_lock);
+      vc_cec_log_error("CEC async tx queue full, message (0x%02X) not queued",
+                       (payload)? payload[0] : 0xFF);
+      return -1;
+   }
+
+   req = &cecservice_tx_ring[cecservice_tx_tail % CECSERVICE_TX_RING_SIZE];
+   req->param.follower = VC_HTOV32(follower);
+   req->param.length = VC_HTOV32(length);
+   req->param.is_reply = VC_HTOV32(is_reply);
+   vcos_memset(req->param.payload, 0, sizeof(req->param.payload));
+   if(length > 0 && vcos_verify(payload))
+      vcos_memcpy(req->param.payload, payload, _min(length, CEC_MAX_XMIT_LENGTH));
+   req->callback = callback;
+   req->callback_data = callback_data;
+   cecservice_tx_tail++;
+   vcos_mutex_unlock(&cecservice_tx_lock);
+
+   vc_cec_log_info("CEC service queued CEC message (%d->%d) (0x%02X) length %d%s",
+                   cecservice_client.logical_address, follower,
+                   (payload)? payload[0] : 0xFF, length, (is_reply)? " as reply" : "");
+
+   vcos_event_signal(&cecservice_tx_available_event);
+   return 0;
+}
+
 /***********************************************************
  * Name: vc_cec_get_logical_address
  *
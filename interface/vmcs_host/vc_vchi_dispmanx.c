@@ -66,9 +66,18 @@ typedef struct {
    void *vsync_callback_param;
    int vsync_enabled;
 
+   //Client-side command batching
+   int batching;
+   uint8_t *batch_buffer;
+   uint32_t batch_capacity;
+   uint32_t batch_length;
+
    int initialised;
 } DISPMANX_SERVICE_T;
 
+//Initial size of the batch command buffer - grown on demand
+#define DISPMANX_BATCH_BUFFER_SIZE 4096
+
 /******************************************************************************
 Static data.
 ******************************************************************************/
@@ -126,6 +135,10 @@ static int32_t dispmanx_send_command_reply(  uint32_t command, void *buffer, uin
 
 static uint32_t dispmanx_get_handle(  uint32_t command, void *buffer, uint32_t length);
 
+static int32_t dispmanx_batch_record( uint32_t command, const void *buffer, uint32_t length);
+
+static int32_t dispmanx_batch_flush_locked( void );
+
 static void *dispmanx_notify_func( void *arg );
 
 
@@ -254,6 +267,14 @@ VCHPRE_ void VCHPOST_ vc_dispmanx_stop( void ) {
    vcos_mutex_delete(&dispmanx_client.lock);
    vcos_event_delete(&dispmanx_message_available_event);
    vcos_event_delete(&dispmanx_notify_available_event);
+
+   if (dispmanx_client.batch_buffer) {
+      vcos_free(dispmanx_client.batch_buffer);
+      dispmanx_client.batch_buffer = NULL;
+      dispmanx_client.batch_capacity = 0;
+      dispmanx_client.batch_length = 0;
+      dispmanx_client.batching = 0;
+   }
 }
 
 /***********************************************************
@@ -495,6 +516,60 @@ VCHPRE_ int VCHPOST_ vc_dispmanx_resource_write_data_handle( DISPMANX_RESOURCE_H
    }
    return (int) success;
 }
+
+/***********************************************************
+ * Name: vc_dispmanx_resource_read_data_handle
+ *
+ * Arguments:
+ *       DISPMANX_RESOURCE_HANDLE_T res
+ *       const VC_RECT_T * rect
+ *       MEM_HANDLE_T handle
+ *       uint32_t offset
+ *       uint32_t dst_pitch
+ *
+ * Description: Copy the bitmap data from VideoCore memory straight into
+ *              a relocatable buffer (e.g. shared memory), avoiding an
+ *              intermediate host-side copy
+ *
+ * Returns: 0 or failure
+ *
+ ***********************************************************/
+VCHPRE_ int VCHPOST_ vc_dispmanx_resource_read_data_handle( DISPMANX_RESOURCE_HANDLE_T handle,
+                                                            const VC_RECT_T * rect,
+                                                            VCHI_MEM_HANDLE_T mem_handle, uint32_t offset,
+                                                            uint32_t dst_pitch ) {
+   int32_t bulk_len;
+   uint32_t param[3];
+   uint32_t success = 0;
+
+   if ( rect == 0 || dst_pitch == 0 )
+   {
+      return -1;
+   }
+
+   //Note that x coordinate of the rect is NOT used
+   //Address of data in the destination buffer
+   offset += dst_pitch * rect->y;
+   bulk_len = (int32_t)dst_pitch * rect->height;
+
+   //Now send the bulk transfer across
+   //command parameters: resource handle, source y, bulk length
+   param[0] = VC_HTOV32(handle);
+   param[1] = VC_HTOV32(rect->y);
+   param[2] = VC_HTOV32(bulk_len);
+   success = dispmanx_send_command(  EDispmanBulkRead | DISPMANX_NO_REPLY_MASK, param, sizeof(param));
+   if(success == 0)
+   {
+      lock_obtain();
+      success = vchi_bulk_queue_receive_reloc( dispmanx_client.client_handle[0],
+                                               mem_handle, offset,
+                                               bulk_len,
+                                               VCHI_FLAGS_BLOCK_UNTIL_OP_COMPLETE,
+                                               NULL );
+      lock_release();
+   }
+   return (int) success;
+}
 #endif
 
 /***********************************************************
@@ -1003,6 +1078,42 @@ VCHPRE_ int VCHPOST_ vc_dispmanx_snapshot( DISPMANX_DISPLAY_HANDLE_T display,
    return success;
 }
 
+/***********************************************************
+ * Name: vc_dispmanx_snapshot_region
+ *
+ * Arguments:
+ *       DISPMANX_DISPLAY_HANDLE_T display
+ *       DISPMANX_RESOURCE_HANDLE_T snapshot_resource
+ *       const VC_RECT_T *rect
+ *       DISPMANX_TRANSFORM_T transform
+ *
+ * Description: Capture only the given region of a display into the
+ *              matching region of a (persistent) resource, so repeated
+ *              captures need only pay for the pixels that changed
+ *
+ * Returns:
+ *
+ ***********************************************************/
+VCHPRE_ int VCHPOST_ vc_dispmanx_snapshot_region( DISPMANX_DISPLAY_HANDLE_T display,
+                                                  DISPMANX_RESOURCE_HANDLE_T snapshot_resource,
+                                                  const VC_RECT_T *rect,
+                                                  DISPMANX_TRANSFORM_T transform )
+{
+   uint32_t display_snapshot_param[] = {
+      VC_HTOV32(display),
+      VC_HTOV32(snapshot_resource),
+      VC_HTOV32(transform),
+      VC_HTOV32(rect->x),
+      VC_HTOV32(rect->y),
+      VC_HTOV32(rect->width),
+      VC_HTOV32(rect->height)};
+
+   int success = (int) dispmanx_send_command( EDispmanSnapshotRegion,
+                                              display_snapshot_param,
+                                              sizeof(display_snapshot_param));
+   return success;
+}
+
 /***********************************************************
  * Name: vc_dispmanx_resource_set_palette
  *
@@ -1183,8 +1294,18 @@ static int32_t dispmanx_send_command(  uint32_t command, void *buffer, uint32_t
    VCHI_MSG_VECTOR_T vector[] = { {&command, sizeof(command)},
                                   {buffer, length} };
    int32_t success = 0, response = -1;
+   if (dispmanx_client.batching && (command & DISPMANX_NO_REPLY_MASK)) {
+      vcos_mutex_lock( &dispmanx_client.lock );
+      success = dispmanx_batch_record(command, buffer, length);
+      vcos_mutex_unlock( &dispmanx_client.lock );
+      if (success == 0)
+         return 0;
+      //Could not be recorded - flush and send directly to preserve ordering
+   }
    lock_obtain();
-   success = vchi_msg_queuev( dispmanx_client.client_handle[0],
+   success = dispmanx_batch_flush_locked();
+   if (success == 0)
+      success = vchi_msg_queuev( dispmanx_client.client_handle[0],
                               vector, sizeof(vector)/sizeof(vector[0]),
                               VCHI_FLAGS_BLOCK_UNTIL_QUEUED, NULL );
    if(success == 0 && !(command & DISPMANX_NO_REPLY_MASK)) {
@@ -1222,7 +1343,9 @@ static int32_t dispmanx_send_command_reply(  uint32_t command, void *buffer, uin
 
    int32_t success = 0;
    lock_obtain();
-   success = vchi_msg_queuev( dispmanx_client.client_handle[0],
+   success = dispmanx_batch_flush_locked();
+   if(success == 0)
+      success = vchi_msg_queuev( dispmanx_client.client_handle[0],
                                vector, sizeof(vector)/sizeof(vector[0]),
                                VCHI_FLAGS_BLOCK_UNTIL_QUEUED, NULL );
    if(success == 0)
@@ -1255,7 +1378,9 @@ static uint32_t dispmanx_get_handle(  uint32_t command, void *buffer, uint32_t l
    uint32_t success = 0;
    uint32_t response = 0;
    lock_obtain();
-   success += vchi_msg_queuev( dispmanx_client.client_handle[0],
+   success += (uint32_t)dispmanx_batch_flush_locked();
+   if(success == 0)
+      success += vchi_msg_queuev( dispmanx_client.client_handle[0],
                                vector, sizeof(vector)/sizeof(vector[0]),
                                VCHI_FLAGS_BLOCK_UNTIL_QUEUED, NULL );
    if(success == 0)
@@ -1265,6 +1390,136 @@ static uint32_t dispmanx_get_handle(  uint32_t command, void *buffer, uint32_t l
    return VC_VTOH32(response);
 }
 
+/***********************************************************
+ * Name: dispmanx_batch_record
+ *
+ * Arguments: command, parameter buffer, parameter length
+ *
+ * Description: append a no-reply command to the client-side batch
+ *              buffer instead of sending it. Must be called with the
+ *              client lock held.
+ *
+ * Returns: error code
+ *
+ ***********************************************************/
+static int32_t dispmanx_batch_record( uint32_t command, const void *buffer, uint32_t length) {
+   uint32_t record_length = 2*sizeof(uint32_t) + length;
+   uint8_t *record;
+
+   if (dispmanx_client.batch_length + record_length > dispmanx_client.batch_capacity) {
+      uint32_t new_capacity = dispmanx_client.batch_capacity ?
+         dispmanx_client.batch_capacity : DISPMANX_BATCH_BUFFER_SIZE;
+      uint8_t *new_buffer;
+      while (dispmanx_client.batch_length + record_length > new_capacity)
+         new_capacity *= 2;
+      new_buffer = vcos_malloc(new_capacity, "dispmanx batch buffer");
+      if (!new_buffer)
+         return -1;
+      if (dispmanx_client.batch_buffer) {
+         memcpy(new_buffer, dispmanx_client.batch_buffer, dispmanx_client.batch_length);
+         vcos_free(dispmanx_client.batch_buffer);
+      }
+      dispmanx_client.batch_buffer = new_buffer;
+      dispmanx_client.batch_capacity = new_capacity;
+   }
+
+   //Each record is the message as it will appear on the wire (command word
+   //followed by the parameters), preceded by its length
+   record = dispmanx_client.batch_buffer + dispmanx_client.batch_length;
+   memcpy(record, &record_length, sizeof(uint32_t));
+   memcpy(record + sizeof(uint32_t), &command, sizeof(uint32_t));
+   memcpy(record + 2*sizeof(uint32_t), buffer, length);
+   dispmanx_client.batch_length += record_length;
+
+   return 0;
+}
+
+/***********************************************************
+ * Name: dispmanx_batch_flush_locked
+ *
+ * Arguments: -
+ *
+ * Description: send all recorded commands back-to-back within a single
+ *              service use/release span. Must be called with the
+ *              service lock held (lock_obtain). A no-op when nothing
+ *              has been recorded.
+ *
+ * Returns: error code
+ *
+ ***********************************************************/
+static int32_t dispmanx_batch_flush_locked( void ) {
+   uint32_t offset = 0;
+   int32_t success = 0;
+
+   while (offset < dispmanx_client.batch_length) {
+      uint8_t *record = dispmanx_client.batch_buffer + offset;
+      uint32_t record_length;
+      VCHI_MSG_VECTOR_T vector[1];
+
+      memcpy(&record_length, record, sizeof(uint32_t));
+      vector[0].vec_base = record + sizeof(uint32_t);
+      vector[0].vec_len = record_length - sizeof(uint32_t);
+
+      success = vchi_msg_queuev( dispmanx_client.client_handle[0],
+                                 vector, 1,
+                                 VCHI_FLAGS_BLOCK_UNTIL_QUEUED, NULL );
+      if (success != 0)
+         break;
+
+      offset += record_length;
+   }
+
+   dispmanx_client.batch_length = 0;
+   return success;
+}
+
+/***********************************************************
+ * Name: vc_dispmanx_batch_start
+ *
+ * Arguments: -
+ *
+ * Description: start recording no-reply commands (element adds, removes
+ *              and attribute changes, update submits) client-side
+ *              instead of sending each one separately. The batch is
+ *              sent by vc_dispmanx_batch_submit, or implicitly before
+ *              any command which needs a reply.
+ *
+ * Returns: error code
+ *
+ ***********************************************************/
+VCHPRE_ int VCHPOST_ vc_dispmanx_batch_start( void ) {
+   if (!dispmanx_client.initialised)
+      return -1;
+   vcos_mutex_lock( &dispmanx_client.lock );
+   dispmanx_client.batching = 1;
+   vcos_mutex_unlock( &dispmanx_client.lock );
+   return 0;
+}
+
+/***********************************************************
+ * Name: vc_dispmanx_batch_submit
+ *
+ * Arguments: -
+ *
+ * Description: stop recording and send everything recorded since
+ *              vc_dispmanx_batch_start in one go. Completion of a
+ *              batched update submit is still reported through the
+ *              callback passed to vc_dispmanx_update_submit.
+ *
+ * Returns: error code
+ *
+ ***********************************************************/
+VCHPRE_ int VCHPOST_ vc_dispmanx_batch_submit( void ) {
+   int32_t success;
+   if (!dispmanx_client.initialised)
+      return -1;
+   lock_obtain();
+   dispmanx_client.batching = 0;
+   success = dispmanx_batch_flush_locked();
+   lock_release();
+   return (int)success;
+}
+
 /***********************************************************
  * Name: dispmanx_notify_handle
  *
@@ -89,6 +89,67 @@ typedef struct {
 
 static FILESYS_SERVICE_T vc_filesys_client;
 
+/* Host-side per-file cache for requests from the co-processor. Sequential
+   reads are served from a readahead buffer and sequential writes are
+   coalesced into a write-behind buffer, so VC-side streaming (e.g. codecs
+   loading assets block by block) does not pay one host syscall per block.
+   Only ever touched from the filesys thread, so no locking is needed. */
+
+#define FILESYS_CACHE_FDS        4
+#define FILESYS_READAHEAD_SIZE   (64*1024)
+#define FILESYS_WRITEBEHIND_SIZE (64*1024)
+
+typedef struct {
+   int      fd;      /* -1 when unused */
+   uint8_t *rbuf;    /* readahead data */
+   uint32_t rlen;    /* valid bytes in rbuf */
+   uint32_t roff;    /* bytes of rbuf already delivered */
+   uint8_t *wbuf;    /* write-behind data, not yet written to the file */
+   uint32_t wlen;
+} FILESYS_FDCACHE_T;
+
+static FILESYS_FDCACHE_T fs_fdcache[FILESYS_CACHE_FDS];
+static int fs_fdcache_victim;
+
+/* Worker pool servicing requests from the co-processor. The dispatch
+   thread only dequeues messages and routes them; the (potentially slow)
+   host filesystem calls run on the workers, so one hanging NFS stat no
+   longer stalls every other request.
+
+   Routing preserves the orderings that matter: everything keyed by an
+   open file descriptor - including the bulk READ/WRITE path, whose bulk
+   transfers must stay in issue order on the single service handle - goes
+   to worker 0; directory-handle and pathname requests are spread over
+   the remaining workers, keyed so that requests on the same handle or
+   path stay in order. Requests on different keys are independent: the
+   co-processor blocks each of its tasks until that task's response
+   arrives, so causally dependent requests are never in flight together.
+
+   Each queue has one producer (the dispatch thread, which owns tail) and
+   one consumer (its worker, which owns head), so the indices need no
+   lock. */
+
+#define FILESYS_NUM_WORKERS   3
+#define FILESYS_WORKER_QUEUE  4
+
+typedef struct {
+   FILESERV_MSG_T msg;
+   uint32_t       nbytes;
+} FILESYS_WORK_ITEM_T;
+
+typedef struct {
+   FILESYS_WORK_ITEM_T queue[FILESYS_WORKER_QUEUE];
+   volatile uint32_t   head;  /* next item to service, owned by the worker */
+   volatile uint32_t   tail;  /* next free slot, owned by the dispatch thread */
+   VCOS_EVENT_T        work_avail;
+   VCOS_EVENT_T        space_avail;
+   VCOS_THREAD_T       thread;
+} FILESYS_WORKER_T;
+
+static FILESYS_WORKER_T fs_workers[FILESYS_NUM_WORKERS];
+static VCOS_MUTEX_T fs_response_lock; /* workers respond on one service handle */
+static VCOS_MUTEX_T fs_fdcache_lock;  /* fdcache is flushed from metadata workers */
+
 
 /******************************************************************************
 Static functions.
@@ -119,6 +180,22 @@ static int vchi_msg_stub_noblock(FILESERV_MSG_T* msg, uint16_t cmd_id, int msg_l
 
 static int vc_fs_message_handler( FILESERV_MSG_T* msg, uint32_t nbytes );
 
+static void vc_fs_service_request( FILESERV_MSG_T* msg, uint32_t nbytes );
+
+static void filesys_dispatch_request( FILESERV_MSG_T* msg, uint32_t nbytes );
+
+static void *filesys_worker_func(void *arg);
+
+static int fs_fdcache_sync(FILESYS_FDCACHE_T *entry);
+static int fs_fdcache_sync_fd(int fd);
+static int fs_fdcache_sync_all(void);
+static int fs_fdcache_flush(int fd);
+static int fs_fdcache_close(int fd);
+static int fs_fdcache_read(int fd, void *buf, unsigned int nbytes);
+static int fs_fdcache_write(int fd, const void *buf, unsigned int nbytes);
+static int fs_fdcache_lseek(int fd, long offset, int whence);
+static int64_t fs_fdcache_lseek64(int fd, int64_t offset, int whence);
+
 static void *filesys_task_func(void *arg);
 
 static void filesys_callback( void *callback_param, VCHI_CALLBACK_REASON_T reason, void *msg_handle );
@@ -162,6 +239,14 @@ int vc_vchi_filesys_init (VCHI_INSTANCE_T initialise_instance, VCHI_CONNECTION_T
    memset( &vc_filesys_client, 0, sizeof(FILESYS_SERVICE_T) );
    vc_filesys_client.num_connections = num_connections;
 
+   {
+      int i;
+      memset( fs_fdcache, 0, sizeof(fs_fdcache) );
+      for (i = 0; i < FILESYS_CACHE_FDS; i++)
+         fs_fdcache[i].fd = -1;
+      fs_fdcache_victim = 0;
+   }
+
    if(!vcos_verify(vc_filesys_client.num_connections < 2))
       return -1;
 
@@ -200,6 +285,26 @@ int vc_vchi_filesys_init (VCHI_INSTANCE_T initialise_instance, VCHI_CONNECTION_T
 
    vc_filesys_client.initialised = 1;
 
+   status = vcos_mutex_create(&fs_response_lock, "HFilesys resp");
+   vcos_assert(status == VCOS_SUCCESS);
+   status = vcos_mutex_create(&fs_fdcache_lock, "HFilesys cache");
+   vcos_assert(status == VCOS_SUCCESS);
+
+   {
+      int i;
+      memset(fs_workers, 0, sizeof(fs_workers));
+      for (i = 0; i < FILESYS_NUM_WORKERS; i++) {
+         char name[16];
+         snprintf(name, sizeof(name), "HFilesys w%d", i);
+         status = vcos_event_create(&fs_workers[i].work_avail, name);
+         vcos_assert(status == VCOS_SUCCESS);
+         status = vcos_event_create(&fs_workers[i].space_avail, name);
+         vcos_assert(status == VCOS_SUCCESS);
+         status = vcos_thread_create(&fs_workers[i].thread, name, &attrs, filesys_worker_func, &fs_workers[i]);
+         vcos_assert(status == VCOS_SUCCESS);
+      }
+   }
+
    status = vcos_thread_create(&vc_filesys_client.filesys_thread, "HFilesys", &attrs, filesys_task_func, NULL);
    vcos_assert(status == VCOS_SUCCESS);
 
@@ -310,12 +415,38 @@ void vc_filesys_stop ()
    vcos_event_signal(&vc_filesys_client.filesys_msg_avail);
    vcos_thread_join(&vc_filesys_client.filesys_thread, &dummy);
 
+   {
+      int i;
+      for (i = 0; i < FILESYS_NUM_WORKERS; i++) {
+         vcos_event_signal(&fs_workers[i].work_avail);
+         vcos_thread_join(&fs_workers[i].thread, &dummy);
+         vcos_event_delete(&fs_workers[i].work_avail);
+         vcos_event_delete(&fs_workers[i].space_avail);
+      }
+   }
+   vcos_mutex_delete(&fs_response_lock);
+   vcos_mutex_delete(&fs_fdcache_lock);
+
    vcos_event_delete(&vc_filesys_client.filesys_msg_avail);
    vcos_event_delete(&vc_filesys_client.response_event);
    vcos_mutex_delete(&vc_filesys_client.filesys_lock);
 
    if(vc_filesys_client.bulk_buffer)
       vcos_free(vc_filesys_client.bulk_buffer);
+
+   {
+      int i;
+      for (i = 0; i < FILESYS_CACHE_FDS; i++) {
+         if (fs_fdcache[i].fd != -1)
+            fs_fdcache_sync(&fs_fdcache[i]);
+         if (fs_fdcache[i].rbuf)
+            vcos_free(fs_fdcache[i].rbuf);
+         if (fs_fdcache[i].wbuf)
+            vcos_free(fs_fdcache[i].wbuf);
+         memset(&fs_fdcache[i], 0, sizeof(fs_fdcache[i]));
+         fs_fdcache[i].fd = -1;
+      }
+   }
 }
 
 /******************************************************************************
@@ -1827,12 +1958,274 @@ static int vc_send_response( FILESERV_MSG_T* msg, uint32_t retval, uint32_t nbyt
    //start with 8 because always xid and retval
    nbytes += 8;
 
-   if(vcos_verify(nbytes <= VCHI_MAX_MSG_SIZE))
+   if(vcos_verify(nbytes <= VCHI_MAX_MSG_SIZE)) {
+      //workers all respond on the one service handle
+      vcos_mutex_lock(&fs_response_lock);
       success = (int) vchi_msg_queue( vc_filesys_client.open_handle, msg, nbytes, VCHI_FLAGS_BLOCK_UNTIL_QUEUED, NULL );
+      vcos_mutex_unlock(&fs_response_lock);
+   }
 
    return success;
 }
 
+/******************************************************************************
+NAME
+   fs_fdcache_sync
+
+SYNOPSIS
+   static int fs_fdcache_sync(FILESYS_FDCACHE_T *entry)
+
+FUNCTION
+   Flush any write-behind data and rewind any readahead, so the file
+   position matches what the co-processor has actually consumed.
+
+RETURNS
+   0 on success
+******************************************************************************/
+static int fs_fdcache_sync(FILESYS_FDCACHE_T *entry)
+{
+   int ret = 0;
+
+   if (entry->wlen) {
+      if (vc_hostfs_write(entry->fd, entry->wbuf, entry->wlen) != (int)entry->wlen)
+         ret = -1;
+      entry->wlen = 0;
+   }
+   if (entry->rlen > entry->roff) {
+      if (vc_hostfs_lseek(entry->fd, -(long)(entry->rlen - entry->roff),
+                          VC_FILESYS_SEEK_CUR) < 0)
+         ret = -1;
+   }
+   entry->rlen = entry->roff = 0;
+
+   return ret;
+}
+
+static FILESYS_FDCACHE_T *fs_fdcache_find(int fd)
+{
+   int i;
+   for (i = 0; i < FILESYS_CACHE_FDS; i++) {
+      if (fs_fdcache[i].fd == fd)
+         return &fs_fdcache[i];
+   }
+   return NULL;
+}
+
+/* Find the cache entry for a file, claiming (and if necessary evicting) a
+   slot when it does not have one. Returns NULL if the buffers cannot be
+   allocated, in which case the caller falls back to uncached io. */
+static FILESYS_FDCACHE_T *fs_fdcache_get(int fd)
+{
+   FILESYS_FDCACHE_T *entry = fs_fdcache_find(fd);
+   int i;
+
+   if (entry)
+      return entry;
+
+   for (i = 0; i < FILESYS_CACHE_FDS; i++) {
+      if (fs_fdcache[i].fd == -1) {
+         entry = &fs_fdcache[i];
+         break;
+      }
+   }
+
+   if (!entry) {
+      entry = &fs_fdcache[fs_fdcache_victim];
+      fs_fdcache_victim = (fs_fdcache_victim + 1) % FILESYS_CACHE_FDS;
+      fs_fdcache_sync(entry);
+   }
+
+   if (!entry->rbuf)
+      entry->rbuf = vcos_malloc(FILESYS_READAHEAD_SIZE, "HFilesys readahead");
+   if (!entry->wbuf)
+      entry->wbuf = vcos_malloc(FILESYS_WRITEBEHIND_SIZE, "HFilesys writebehind");
+   if (!entry->rbuf || !entry->wbuf) {
+      entry->fd = -1;
+      return NULL;
+   }
+
+   entry->fd = fd;
+   entry->rlen = entry->roff = entry->wlen = 0;
+
+   return entry;
+}
+
+static int fs_fdcache_sync_fd(int fd)
+{
+   FILESYS_FDCACHE_T *entry = fs_fdcache_find(fd);
+   return entry ? fs_fdcache_sync(entry) : 0;
+}
+
+static int fs_fdcache_sync_all(void)
+{
+   int ret = 0;
+   int i;
+   vcos_mutex_lock(&fs_fdcache_lock);
+   for (i = 0; i < FILESYS_CACHE_FDS; i++) {
+      if (fs_fdcache[i].fd != -1 && fs_fdcache_sync(&fs_fdcache[i]) != 0)
+         ret = -1;
+   }
+   vcos_mutex_unlock(&fs_fdcache_lock);
+   return ret;
+}
+
+/* Flush and release the cache slot for a file which is being closed. The
+   buffers are kept for reuse by the next file. */
+static int fs_fdcache_close(int fd)
+{
+   FILESYS_FDCACHE_T *entry;
+   int ret = 0;
+
+   vcos_mutex_lock(&fs_fdcache_lock);
+   entry = fs_fdcache_find(fd);
+   if (entry) {
+      ret = fs_fdcache_sync(entry);
+      entry->fd = -1;
+   }
+   vcos_mutex_unlock(&fs_fdcache_lock);
+   return ret;
+}
+
+/******************************************************************************
+NAME
+   fs_fdcache_read
+
+SYNOPSIS
+   static int fs_fdcache_read(int fd, void *buf, unsigned int nbytes)
+
+FUNCTION
+   Read with readahead - on a cache miss a whole readahead buffer is
+   filled with one host read and subsequent sequential reads are served
+   from it. Large reads bypass the cache.
+
+RETURNS
+   Number of bytes read, or negative on failure
+******************************************************************************/
+static int fs_fdcache_read_internal(int fd, void *buf, unsigned int nbytes)
+{
+   FILESYS_FDCACHE_T *entry;
+   unsigned int total = 0;
+   uint8_t *dst = buf;
+
+   if (nbytes >= FILESYS_READAHEAD_SIZE || (entry = fs_fdcache_get(fd)) == NULL) {
+      if (fs_fdcache_sync_fd(fd) != 0)
+         return -1;
+      return vc_hostfs_read(fd, buf, nbytes);
+   }
+
+   if (entry->wlen && fs_fdcache_sync(entry) != 0)
+      return -1;
+
+   while (total < nbytes) {
+      unsigned int chunk = entry->rlen - entry->roff;
+      int i;
+
+      if (chunk) {
+         if (chunk > nbytes - total)
+            chunk = nbytes - total;
+         memcpy(dst + total, entry->rbuf + entry->roff, chunk);
+         entry->roff += chunk;
+         total += chunk;
+         continue;
+      }
+
+      entry->rlen = entry->roff = 0;
+      i = vc_hostfs_read(fd, entry->rbuf, FILESYS_READAHEAD_SIZE);
+      if (i <= 0)
+         return total ? (int)total : i;
+      entry->rlen = (uint32_t)i;
+   }
+
+   return (int)total;
+}
+
+static int fs_fdcache_read(int fd, void *buf, unsigned int nbytes)
+{
+   int ret;
+   vcos_mutex_lock(&fs_fdcache_lock);
+   ret = fs_fdcache_read_internal(fd, buf, nbytes);
+   vcos_mutex_unlock(&fs_fdcache_lock);
+   return ret;
+}
+
+/******************************************************************************
+NAME
+   fs_fdcache_write
+
+SYNOPSIS
+   static int fs_fdcache_write(int fd, const void *buf, unsigned int nbytes)
+
+FUNCTION
+   Write with write-behind - sequential writes are coalesced in a buffer
+   which is written out with one host write when it fills, or when any
+   other operation needs the file position. Errors from the deferred
+   write surface on the flushing call. Large writes bypass the cache.
+
+RETURNS
+   Number of bytes written, or negative on failure
+******************************************************************************/
+static int fs_fdcache_write_internal(int fd, const void *buf, unsigned int nbytes)
+{
+   FILESYS_FDCACHE_T *entry;
+
+   if (nbytes >= FILESYS_WRITEBEHIND_SIZE || (entry = fs_fdcache_get(fd)) == NULL) {
+      if (fs_fdcache_sync_fd(fd) != 0)
+         return -1;
+      return vc_hostfs_write(fd, buf, nbytes);
+   }
+
+   if (entry->rlen && fs_fdcache_sync(entry) != 0)
+      return -1;
+
+   if (entry->wlen + nbytes > FILESYS_WRITEBEHIND_SIZE &&
+       fs_fdcache_sync(entry) != 0)
+      return -1;
+
+   memcpy(entry->wbuf + entry->wlen, buf, nbytes);
+   entry->wlen += nbytes;
+
+   return (int)nbytes;
+}
+
+static int fs_fdcache_write(int fd, const void *buf, unsigned int nbytes)
+{
+   int ret;
+   vcos_mutex_lock(&fs_fdcache_lock);
+   ret = fs_fdcache_write_internal(fd, buf, nbytes);
+   vcos_mutex_unlock(&fs_fdcache_lock);
+   return ret;
+}
+
+static int fs_fdcache_lseek(int fd, long offset, int whence)
+{
+   int ret = -1;
+   vcos_mutex_lock(&fs_fdcache_lock);
+   if (fs_fdcache_sync_fd(fd) == 0)
+      ret = vc_hostfs_lseek(fd, offset, whence);
+   vcos_mutex_unlock(&fs_fdcache_lock);
+   return ret;
+}
+
+static int64_t fs_fdcache_lseek64(int fd, int64_t offset, int whence)
+{
+   int64_t ret = -1;
+   vcos_mutex_lock(&fs_fdcache_lock);
+   if (fs_fdcache_sync_fd(fd) == 0)
+      ret = vc_hostfs_lseek64(fd, offset, whence);
+   vcos_mutex_unlock(&fs_fdcache_lock);
+   return ret;
+}
+
+/* locked flush of one file's cache, for the request handlers */
+static int fs_fdcache_flush(int fd)
+{
+   int ret;
+   vcos_mutex_lock(&fs_fdcache_lock);
+   ret = fs_fdcache_sync_fd(fd);
+   vcos_mutex_unlock(&fs_fdcache_lock);
+   return ret;
+}
+
 /******************************************************************************
 NAME
    vc_fs_message_handler
@@ -1880,8 +2273,35 @@ static int vc_fs_message_handler( FILESERV_MSG_T* msg, uint32_t nbytes )
       rr = 2;
    }
    else if ((xid & 0x80000000UL) == 0x80000000UL) {
-      /* Process new requests from the co-processor */
+      /* A new request from the co-processor - hand it to the worker pool */
+      filesys_dispatch_request(msg, nbytes);
+      rr = 1;
+   } else {
+      /* A message has been left in the fifo and the host side has been reset.
+         The message needs to be flushed. It would be better to do this by resetting
+         the fifos. */
+   }
+
+   return rr;
+}
+
+/******************************************************************************
+NAME
+   vc_fs_service_request
 
+SYNOPSIS
+   static void vc_fs_service_request( FILESERV_MSG_T* msg, uint32_t nbytes )
+
+FUNCTION
+   Services one request from the co-processor and sends its response.
+   Runs on a worker thread; msg is the worker's private copy of the
+   request message.
+
+RETURNS
+   void
+******************************************************************************/
+static void vc_fs_service_request( FILESERV_MSG_T* msg, uint32_t nbytes )
+{
       uint32_t retval = FILESERV_RESP_OK;
 
       //this is the number of uint32_t param[] + data that we send back to VC in bytes
@@ -1889,12 +2309,14 @@ static int vc_fs_message_handler( FILESERV_MSG_T* msg, uint32_t nbytes )
       uint32_t rlen = 0;
       int i;
 
+      (void)nbytes;
+
       switch (msg->cmd_code) {
 
       case VC_FILESYS_CLOSE:
 
-         i = vc_hostfs_close((int)msg->params[0]);
-         if (i != 0) {
+         i = fs_fdcache_close((int)msg->params[0]);
+         if (vc_hostfs_close((int)msg->params[0]) != 0 || i != 0) {
             retval = FILESERV_RESP_ERROR;
          }
          rlen = 0;
@@ -1911,6 +2333,7 @@ static int vc_fs_message_handler( FILESERV_MSG_T* msg, uint32_t nbytes )
 
       case VC_FILESYS_FORMAT:
 
+         fs_fdcache_sync_all();
          i = vc_hostfs_format((const char *)msg->data);
          if (i != 0) {
             retval = FILESERV_RESP_ERROR;
@@ -1949,6 +2372,7 @@ static int vc_fs_message_handler( FILESERV_MSG_T* msg, uint32_t nbytes )
          {
             fattributes_t attr;
 
+            fs_fdcache_sync_all();
             i = vc_hostfs_get_attr((const char *)msg->data,
                                    &attr);
             if (i != 0) {
@@ -1962,9 +2386,9 @@ static int vc_fs_message_handler( FILESERV_MSG_T* msg, uint32_t nbytes )
          break;
       case VC_FILESYS_LSEEK:
 
-         i = vc_hostfs_lseek( (int)msg->params[0],
-                              (int)msg->params[1],
-                              (int)msg->params[2]);
+         i = fs_fdcache_lseek( (int)msg->params[0],
+                               (int)msg->params[1],
+                               (int)msg->params[2]);
          if (i < 0) {
             retval = FILESERV_RESP_ERROR;
             rlen = 0;
@@ -1979,7 +2403,7 @@ static int vc_fs_message_handler( FILESERV_MSG_T* msg, uint32_t nbytes )
             int64_t offset;
             offset = (((int64_t) msg->params[2]) << 32) + msg->params[1];
 
-            offset = vc_hostfs_lseek64( (int)msg->params[0], offset, (int)msg->params[3]);
+            offset = fs_fdcache_lseek64( (int)msg->params[0], offset, (int)msg->params[3]);
             if (offset < (int64_t)0) {
                retval = FILESERV_RESP_ERROR;
                rlen = 0;
@@ -2044,9 +2468,9 @@ static int vc_fs_message_handler( FILESERV_MSG_T* msg, uint32_t nbytes )
             //perform any seeking
             if ( (uint32_t)0xffffffffUL != offset)
             {
-               i = vc_hostfs_lseek( (int)fd,
-                                    (long int) offset,
-                                    VC_FILESYS_SEEK_SET);
+               i = fs_fdcache_lseek( (int)fd,
+                                     (long int) offset,
+                                     VC_FILESYS_SEEK_SET);
                if ( 0 > i)
                {
                   retval = FILESERV_RESP_ERROR;
@@ -2058,9 +2482,9 @@ static int vc_fs_message_handler( FILESERV_MSG_T* msg, uint32_t nbytes )
 
             //put it all in one msg
             if(total_bytes <= FILESERV_MAX_DATA) {
-               i = vc_hostfs_read( (int)fd,
-                                   msg->data,
-                                   (unsigned int) total_bytes);
+               i = fs_fdcache_read( (int)fd,
+                                    msg->data,
+                                    (unsigned int) total_bytes);
 
                if(i < 0) {
                   retval = FILESERV_RESP_ERROR;
@@ -2082,9 +2506,9 @@ static int vc_fs_message_handler( FILESERV_MSG_T* msg, uint32_t nbytes )
 
                //we send the bytes required for HOST buffer align
                if(nalign_bytes) {
-                  i = vc_hostfs_read( (int)fd,
-                                      msg->data,
-                                      (unsigned int)nalign_bytes);
+                  i = fs_fdcache_read( (int)fd,
+                                       msg->data,
+                                       (unsigned int)nalign_bytes);
                   if(i < 0) {
                      retval = FILESERV_RESP_ERROR;
                      rlen = 16;
@@ -2105,7 +2529,7 @@ static int vc_fs_message_handler( FILESERV_MSG_T* msg, uint32_t nbytes )
                }
 
                //bulk bytes
-               i = vc_hostfs_read((int)fd, vc_filesys_client.bulk_buffer, (unsigned int)total_bytes);
+               i = fs_fdcache_read((int)fd, vc_filesys_client.bulk_buffer, (unsigned int)total_bytes);
 
                if(i < 0) {
                   retval = FILESERV_RESP_ERROR;
@@ -2171,6 +2595,7 @@ static int vc_fs_message_handler( FILESERV_MSG_T* msg, uint32_t nbytes )
 
       case VC_FILESYS_REMOVE:
 
+         fs_fdcache_sync_all();
          i = vc_hostfs_remove((const char *)msg->data);
          if (i != 0) {
             retval = FILESERV_RESP_ERROR;
@@ -2180,6 +2605,7 @@ static int vc_fs_message_handler( FILESERV_MSG_T* msg, uint32_t nbytes )
 
       case VC_FILESYS_RENAME:
 
+         fs_fdcache_sync_all();
          i = (int) strlen((char *)msg->data);
          if (vc_hostfs_rename((const char *)msg->data,
                               (const char *)&msg->data[i+1])
@@ -2191,6 +2617,7 @@ static int vc_fs_message_handler( FILESERV_MSG_T* msg, uint32_t nbytes )
 
       case VC_FILESYS_SETEND:
 
+         fs_fdcache_flush( (int)msg->params[0] );
          i = vc_hostfs_setend( (int)msg->params[0] );
          if (i != 0) {
             retval = FILESERV_RESP_ERROR;
@@ -2200,6 +2627,7 @@ static int vc_fs_message_handler( FILESERV_MSG_T* msg, uint32_t nbytes )
 
       case VC_FILESYS_SET_ATTR:
 
+         fs_fdcache_sync_all();
          i = vc_hostfs_set_attr((const char *)msg->data,
                                 (fattributes_t)msg->params[0]);
          if (i != 0) {
@@ -2265,9 +2693,9 @@ static int vc_fs_message_handler( FILESERV_MSG_T* msg, uint32_t nbytes )
             //everything in one msg
             if(total_bytes <= FILESERV_MAX_DATA)
             {
-               i = vc_hostfs_write( (int)fd,
-                                    msg->data,
-                                    (unsigned int) total_bytes);
+               i = fs_fdcache_write( (int)fd,
+                                     msg->data,
+                                     (unsigned int) total_bytes);
                if (i < 0) {
                   retval = FILESERV_RESP_ERROR;
                } else {
@@ -2289,9 +2717,9 @@ static int vc_fs_message_handler( FILESERV_MSG_T* msg, uint32_t nbytes )
 
                //write bytes required for VC buffer align
                if(nalign_bytes) {
-                  i = vc_hostfs_write( (int)fd,
-                                       msg->data,
-                                       (unsigned int)nalign_bytes);
+                  i = fs_fdcache_write( (int)fd,
+                                        msg->data,
+                                        (unsigned int)nalign_bytes);
                   if(i < 0) {
                      retval = FILESERV_RESP_ERROR;
                      msg->params[0] = 0;
@@ -2314,9 +2742,9 @@ static int vc_fs_message_handler( FILESERV_MSG_T* msg, uint32_t nbytes )
                                           bulk_bytes,
                                           VCHI_FLAGS_BLOCK_UNTIL_OP_COMPLETE,
                                           NULL) != 0 ||
-                  (i = vc_hostfs_write( (int)fd,
-                                        vc_filesys_client.bulk_buffer,
-                                        (unsigned int) bulk_bytes)) < 0)
+                  (i = fs_fdcache_write( (int)fd,
+                                         vc_filesys_client.bulk_buffer,
+                                         (unsigned int) bulk_bytes)) < 0)
                {
                   retval = FILESERV_RESP_ERROR;
                   msg->params[0] = 0;
@@ -2326,9 +2754,9 @@ static int vc_fs_message_handler( FILESERV_MSG_T* msg, uint32_t nbytes )
                total_bytes_written += i;
             
                if(end_bytes) {
-                  i = vc_hostfs_write( (int)fd,
-                                       msg->data+nalign_bytes,
-                                       (unsigned int)end_bytes);
+                  i = fs_fdcache_write( (int)fd,
+                                        msg->data+nalign_bytes,
+                                        (unsigned int)end_bytes);
                
                   total_bytes_written += i;
                }
@@ -2353,16 +2781,107 @@ static int vc_fs_message_handler( FILESERV_MSG_T* msg, uint32_t nbytes )
 
       //convert all to over the wire values and send
       vc_send_response( msg, retval, rlen );
+}
 
-      rr = 1;
+/******************************************************************************
+NAME
+   filesys_dispatch_request
 
-   } else {
-      /* A message has been left in the fifo and the host side has been reset.
-         The message needs to be flushed. It would be better to do this by resetting
-         the fifos. */
+SYNOPSIS
+   static void filesys_dispatch_request( FILESERV_MSG_T* msg, uint32_t nbytes )
+
+FUNCTION
+   Copies a request from the co-processor into the queue of the worker
+   that owns its ordering key, blocking only if that queue is full.
+
+RETURNS
+   void
+******************************************************************************/
+static void filesys_dispatch_request( FILESERV_MSG_T* msg, uint32_t nbytes )
+{
+   FILESYS_WORKER_T *worker;
+   FILESYS_WORK_ITEM_T *item;
+   uint32_t key;
+
+   switch (msg->cmd_code) {
+   /* anything keyed by an open file descriptor, including the bulk
+      READ/WRITE path whose bulk transfers must stay in issue order on
+      the single service handle, is owned by worker 0 */
+   case VC_FILESYS_CLOSE:
+   case VC_FILESYS_LSEEK:
+   case VC_FILESYS_LSEEK64:
+   case VC_FILESYS_READ:
+   case VC_FILESYS_WRITE:
+   case VC_FILESYS_SETEND:
+      key = 0;
+      break;
+   /* directory enumeration is keyed by the directory handle */
+   case VC_FILESYS_CLOSEDIR:
+   case VC_FILESYS_READDIR:
+      key = 1 + msg->params[0] % (FILESYS_NUM_WORKERS - 1);
+      break;
+   /* pathname requests are keyed by the path, so repeated requests on
+      one path stay ordered while requests on others proceed */
+   default:
+      {
+         const char *path = (const char *)msg->data;
+         uint32_t left = (nbytes > 24) ? nbytes - 24 : 0;
+         uint32_t h = 0;
+         while (left-- && *path)
+            h = h * 31 + (uint32_t)*path++;
+         key = 1 + h % (FILESYS_NUM_WORKERS - 1);
+      }
+      break;
    }
 
-   return rr;
+   worker = &fs_workers[key];
+
+   while (worker->tail - worker->head >= FILESYS_WORKER_QUEUE) {
+      if (vcos_event_wait(&worker->space_avail) != VCOS_SUCCESS ||
+          vc_filesys_client.initialised == 0)
+         return;
+   }
+
+   item = &worker->queue[worker->tail % FILESYS_WORKER_QUEUE];
+   if (nbytes > sizeof(item->msg))
+      nbytes = sizeof(item->msg);
+   memcpy(&item->msg, msg, nbytes);
+   item->nbytes = nbytes;
+   worker->tail++;
+   vcos_event_signal(&worker->work_avail);
+}
+
+/******************************************************************************
+NAME
+   filesys_worker_func
+
+SYNOPSIS
+   static void *filesys_worker_func(void *arg)
+
+FUNCTION
+   Worker thread: services the requests queued for it, in order.
+
+RETURNS
+   void
+******************************************************************************/
+static void *filesys_worker_func(void *arg)
+{
+   FILESYS_WORKER_T *worker = (FILESYS_WORKER_T *)arg;
+
+   while (1) {
+      if (vcos_event_wait(&worker->work_avail) != VCOS_SUCCESS ||
+          vc_filesys_client.initialised == 0)
+         break;
+
+      while (worker->head != worker->tail) {
+         FILESYS_WORK_ITEM_T *item = &worker->queue[worker->head % FILESYS_WORKER_QUEUE];
+         vc_fs_service_request(&item->msg, item->nbytes);
+         worker->head++;
+         vcos_event_signal(&worker->space_avail);
+      }
+   }
+
+   return 0;
 }
 
 
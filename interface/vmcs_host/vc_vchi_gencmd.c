@@ -379,6 +379,95 @@ int vc_gencmd(char *response, int maxlen, const char *format, ...) {
    return ret;
 }
 
+/******************************************************************************
+NAME
+   vc_gencmd_send_multi
+
+SYNOPSIS
+   int vc_gencmd_send_multi(const char **commands, int num_commands,
+                            VC_GENCMD_CALLBACK_T callback, void *callback_param)
+
+FUNCTION
+   Pipeline a set of commands in one exchange: every request is queued
+   before any response is read, so the round trip latency is paid once for
+   the whole set rather than per command. The responses are delivered in
+   order through the callback (invoked in the caller's context), with the
+   error code from the first word of each response passed separately.
+
+RETURNS
+   0 if every command was queued and its response delivered
+******************************************************************************/
+int vc_gencmd_send_multi( const char **commands, int num_commands,
+                          VC_GENCMD_CALLBACK_T callback, void *callback_param ) {
+   int success = -1;
+   int queued = 0;
+   int conn = 0;
+   int i;
+
+   if ( !commands || num_commands <= 0 )
+      return -1;
+
+   if(lock_obtain() == 0)
+   {
+      use_gencmd_service();
+
+      for( i=0; i<num_commands; i++ ) {
+         int length = (int) strlen(commands[i]);
+
+         if (length >= GENCMD_MAX_LENGTH) {
+            success = -1;
+            break;
+         }
+
+         if (i == 0) {
+            //As in vc_gencmd_send, only send on one connection - remember
+            //which one accepted the first command and stick with it
+            for( conn=0; conn<gencmd_client.num_connections; conn++ ) {
+               success = vchi_msg_queue( gencmd_client.open_handle[conn],
+                                         commands[i], length+1,
+                                         VCHI_FLAGS_BLOCK_UNTIL_QUEUED, NULL );
+               if(success == 0)
+                  break;
+            }
+         } else {
+            success = vchi_msg_queue( gencmd_client.open_handle[conn],
+                                      commands[i], length+1,
+                                      VCHI_FLAGS_BLOCK_UNTIL_QUEUED, NULL );
+         }
+
+         if(success != 0)
+            break;
+         queued++;
+      }
+
+      //Responses come back in request order on the same connection
+      for( i=0; i<queued; i++ ) {
+         int ret_code;
+
+         do {
+            success = (int) vchi_msg_dequeue( gencmd_client.open_handle[conn], gencmd_client.response_buffer,
+                                              sizeof(gencmd_client.response_buffer), &gencmd_client.response_length, VCHI_FLAGS_NONE);
+         } while(success != 0 && vcos_event_wait(&gencmd_client.message_available_event) == VCOS_SUCCESS);
+
+         if(success != 0)
+            break;
+
+         ret_code = VC_VTOH32( *(int *)gencmd_client.response_buffer );
+         gencmd_client.response_length -= sizeof(int); //first word is error code
+
+         if(callback)
+            callback( callback_param, i, ret_code,
+                      gencmd_client.response_buffer+sizeof(int),
+                      (int) gencmd_client.response_length );
+      }
+
+      release_gencmd_service();
+      lock_release();
+   }
+
+   return success;
+}
+
 /******************************************************************************
 NAME
    vc_gencmd_string_property
@@ -79,6 +79,12 @@ typedef struct {
    int                   initialised;
    int                   to_exit;
 
+   //Cached display state, published seqlock style so readers need no lock:
+   //an odd count means a writer is mid-update and the snapshot may be torn
+   TV_DISPLAY_STATE_T    display_state;
+   uint32_t              display_state_count;
+   uint32_t              display_state_valid;
+
    //TV stuff
    uint32_t              copy_protect;
 
@@ -93,6 +99,13 @@ typedef struct {
    TVSERVICE_MODE_CACHE_T dmt_cache;
    TVSERVICE_MODE_CACHE_T cea_cache;
 
+   //EDID cache, filled on demand by vc_tv_hdmi_ddc_read and invalidated by
+   //hot-plug notifications, so repeat reads skip the round trip to Videocore.
+   //Larger EDIDs fall through to a real read beyond the cached prefix.
+#define TVSERVICE_EDID_CACHE_SIZE (8*128) //8 EDID blocks
+   uint8_t               edid_cache[TVSERVICE_EDID_CACHE_SIZE];
+   uint32_t              edid_cache_length; //Contiguous valid bytes, 0 = empty
+
    //SDTV specific stuff
    SDTV_COLOUR_T         sdtv_current_colour;
    SDTV_MODE_T           sdtv_current_mode;
@@ -186,6 +199,12 @@ static int32_t tvservice_send_command_reply( uint32_t command, void *buffer, uin
 
 static void *tvservice_notify_func(void *arg);
 
+static void tvservice_display_state_publish(const TV_DISPLAY_STATE_T *tvstate);
+
+static void tvservice_display_state_invalidate(void);
+
+static int tvservice_display_state_read(TV_DISPLAY_STATE_T *tvstate);
+
 
 /******************************************************************************
 TV service API
@@ -394,8 +413,11 @@ VCHPRE_ void VCHPOST_ vc_tv_register_callback(TVSERVICE_CALLBACK_T callback, voi
       {
          if(tvservice_client.callbacks[i].notify_fn == NULL)
          {
-            tvservice_client.callbacks[i].notify_fn = callback;
+            //Write the context first so the notify task, which reads the
+            //slots without the lock, never sees the function without it
             tvservice_client.callbacks[i].notify_data = callback_data;
+            __sync_synchronize();
+            tvservice_client.callbacks[i].notify_fn = callback;
             done = 1;
          } // if
       } // for
@@ -428,7 +450,10 @@ VCHPRE_ void VCHPOST_ vc_tv_unregister_callback(TVSERVICE_CALLBACK_T callback)
       {
          if(tvservice_client.callbacks[i].notify_fn == callback)
          {
+            //Retire the function pointer first; a call the notify task
+            //already started may still complete after we return
             tvservice_client.callbacks[i].notify_fn = NULL;
+            __sync_synchronize();
             tvservice_client.callbacks[i].notify_data = NULL;
             done = 1;
          } // if
@@ -464,7 +489,10 @@ VCHPRE_ void VCHPOST_ vc_tv_unregister_callback_full(TVSERVICE_CALLBACK_T callba
          if(tvservice_client.callbacks[i].notify_fn == callback &&
             tvservice_client.callbacks[i].notify_data == callback_data)
          {
+            //Retire the function pointer first; a call the notify task
+            //already started may still complete after we return
             tvservice_client.callbacks[i].notify_fn = NULL;
+            __sync_synchronize();
             tvservice_client.callbacks[i].notify_data = NULL;
             done = 1;
          } // if
@@ -663,6 +691,82 @@ static int32_t tvservice_send_command_reply(  uint32_t command, void *buffer, ui
    return success;
 }
 
+/***********************************************************
+ * Name: tvservice_display_state_publish
+ *
+ * Arguments: display state to cache
+ *
+ * Description: Publish a display state snapshot for lock-free readers.
+ *              Writers are serialised by the host state lock; the count
+ *              is bumped to odd around the copy so a concurrent reader
+ *              can detect a torn snapshot and retry
+ *
+ * Returns: -
+ *
+ ***********************************************************/
+static void tvservice_display_state_publish(const TV_DISPLAY_STATE_T *tvstate) {
+   tvservice_client.display_state_count++;
+   __sync_synchronize();
+   tvservice_client.display_state = *tvstate;
+   tvservice_client.display_state_valid = 1;
+   __sync_synchronize();
+   tvservice_client.display_state_count++;
+}
+
+/***********************************************************
+ * Name: tvservice_display_state_invalidate
+ *
+ * Arguments: -
+ *
+ * Description: Mark the cached display state stale (called with the host
+ *              state lock held, from the notification task). The next
+ *              vc_tv_get_display_state call re-queries and re-publishes
+ *
+ * Returns: -
+ *
+ ***********************************************************/
+static void tvservice_display_state_invalidate(void) {
+   tvservice_client.display_state_count++;
+   __sync_synchronize();
+   tvservice_client.display_state_valid = 0;
+   __sync_synchronize();
+   tvservice_client.display_state_count++;
+}
+
+/***********************************************************
+ * Name: tvservice_display_state_read
+ *
+ * Arguments: Pointer to tvstate structure to fill in
+ *
+ * Description: Copy the cached display state without taking the lock or
+ *              talking to Videocore. Bounded retry - if a writer keeps
+ *              racing us the caller falls back to an IPC query
+ *
+ * Returns: zero if a consistent valid snapshot was copied, non-zero if
+ *          the cache is stale or contended (tvstate may be clobbered)
+ *
+ ***********************************************************/
+static int tvservice_display_state_read(TV_DISPLAY_STATE_T *tvstate) {
+   int tries;
+
+   if(!tvservice_client.initialised)
+      return -1;
+
+   for(tries = 0; tries < 8; tries++) {
+      uint32_t count = tvservice_client.display_state_count;
+      if(count & 1)
+         continue; //Update in progress
+      __sync_synchronize();
+      if(!tvservice_client.display_state_valid)
+         return -1;
+      *tvstate = tvservice_client.display_state;
+      __sync_synchronize();
+      if(count == tvservice_client.display_state_count)
+         return 0;
+   }
+   return -1;
+}
+
 /***********************************************************
  * Name: tvservice_notify_func
  *
@@ -726,6 +830,7 @@ static void *tvservice_notify_func(void *arg) {
             vcos_log_trace("[%s] invalidating caches", VCOS_FUNCTION);
             state->cea_cache.is_valid = state->cea_cache.num_modes = 0;
             state->dmt_cache.is_valid = state->dmt_cache.num_modes = 0;
+            state->edid_cache_length = 0;
             break;
 
          case VC_HDMI_ATTACHED:
@@ -735,6 +840,8 @@ static void *tvservice_notify_func(void *arg) {
             }
             tvstate.state &=  ~(VC_HDMI_HDMI|VC_HDMI_DVI|VC_HDMI_UNPLUGGED|VC_HDMI_HDCP_AUTH);
             tvstate.state |= VC_HDMI_ATTACHED;
+            //A different device may have been plugged in
+            state->edid_cache_length = 0;
             state->hdmi_preferred_group = (HDMI_RES_GROUP_T) param1;
             state->hdmi_preferred_mode = param2;
             break;
@@ -835,17 +942,25 @@ static void *tvservice_notify_func(void *arg) {
             break;
          }
 
+         //Whatever changed, the cached display state no longer matches it
+         tvservice_display_state_invalidate();
+
          tvservice_lock_release();
 
          //Now callback the host app(s)
+         //Slots are published fn-last and retired fn-first, so a non-NULL
+         //fn read here is safe to call with the data read after it
          uint32_t i, called = 0;
          for(i = 0; i < TVSERVICE_MAX_CALLBACKS; i++)
          {
-            if(state->callbacks[i].notify_fn != NULL)
+            TVSERVICE_CALLBACK_T notify_fn = state->callbacks[i].notify_fn;
+            if(notify_fn != NULL)
             {
+               void *notify_data;
+               __sync_synchronize();
+               notify_data = state->callbacks[i].notify_data;
                called++;
-               state->callbacks[i].notify_fn
-                  (state->callbacks[i].notify_data, reason, param1, param2);
+               notify_fn(notify_data, reason, param1, param2);
             } // if
          } // for
          if(called == 0) {
@@ -901,7 +1016,11 @@ VCHPRE_ int VCHPOST_ vc_tv_get_state(TV_GET_STATE_RESP_T *tvstate) {
  * Arguments:
  *       Pointer to tvstate structure
  *
- * Description: Get the current TV display state.
+ * Description: Get the current TV display state. Served from a locally
+ *              cached snapshot when one is valid (a plain memory read -
+ *              no IPC), otherwise queried from Videocore and re-cached.
+ *              Notifications from Videocore invalidate the cache, so
+ *              polling this per frame is cheap in the steady state
  *
  * Returns: if the command is successful (zero) or not (non-zero)
  *          If the command fails to be sent, passed in state is unchanged
@@ -912,8 +1031,18 @@ VCHPRE_ int VCHPOST_ vc_tv_get_display_state(TV_DISPLAY_STATE_T *tvstate) {
 
    vcos_log_trace("[%s]", VCOS_FUNCTION);
    if(vcos_verify(tvstate)) {
+      uint32_t count = tvservice_client.display_state_count;
+      if(tvservice_display_state_read(tvstate) == 0)
+         return 0;
       success = tvservice_send_command_reply( VC_TV_GET_DISPLAY_STATE, NULL, 0,
                                               tvstate, sizeof(TV_DISPLAY_STATE_T));
+      if(success == 0 && tvservice_lock_obtain() == 0) {
+         //Only publish if no notification invalidated the cache while the
+         //query was in flight - the reply could predate that notification
+         if(count == tvservice_client.display_state_count)
+            tvservice_display_state_publish(tvstate);
+         tvservice_lock_release();
+      }
    }
    return success;
 }
@@ -1483,6 +1612,17 @@ VCHPRE_ int VCHPOST_ vc_tv_hdmi_ddc_read(uint32_t offset, uint32_t length, uint8
    /*if(!vcos_verify(buffer && (((uint32_t) buffer) % 16) == 0))
       return -1;*/
 
+   //Serve the read locally if every requested byte is already cached
+   if(tvservice_lock_obtain() == 0) {
+      if(tvservice_client.edid_cache_length &&
+         offset + length <= tvservice_client.edid_cache_length) {
+         memcpy(buffer, tvservice_client.edid_cache + offset, length);
+         tvservice_lock_release();
+         return length;
+      }
+      tvservice_lock_release();
+   }
+
    vchi_service_use(tvservice_client.client_handle[0]);
    success = tvservice_send_command( VC_TV_DDC_READ, &param, sizeof(TV_DDC_READ_PARAM_T), 1);
 
@@ -1490,6 +1630,20 @@ VCHPRE_ int VCHPOST_ vc_tv_hdmi_ddc_read(uint32_t offset, uint32_t length, uint8
       success = tvservice_wait_for_bulk_receive(buffer, length);
    }
    vchi_service_release(tvservice_client.client_handle[0]);
+
+   //Cache the block for subsequent readers. Only contiguous prefixes are
+   //kept so a cache hit never has holes in it.
+   if(success == 0 && offset <= tvservice_client.edid_cache_length &&
+      offset + length <= sizeof(tvservice_client.edid_cache) &&
+      tvservice_lock_obtain() == 0) {
+      if(offset <= tvservice_client.edid_cache_length) {
+         memcpy(tvservice_client.edid_cache + offset, buffer, length);
+         if(offset + length > tvservice_client.edid_cache_length)
+            tvservice_client.edid_cache_length = offset + length;
+      }
+      tvservice_lock_release();
+   }
+
    return (success == 0)? length : 0; //Either return the whole block or nothing
 }
 
@@ -64,6 +64,18 @@ VCHPRE_ int VCHPOST_ vc_gencmd_read_response(char *response, int maxlen);
 /* convenience function to send command and receive the response */
 VCHPRE_ int VCHPOST_ vc_gencmd(char *response, int maxlen, const char *format, ...);
 
+/* Callback for vc_gencmd_send_multi - invoked once per command, in order,
+   with the error code from the first word of the response passed separately */
+typedef void (*VC_GENCMD_CALLBACK_T)(void *callback_param, int command_index,
+                                     int error_code, const char *response,
+                                     int response_length);
+
+/* Pipeline several commands in one exchange - all the requests are queued
+   before any response is read, and the responses are delivered through the
+   callback */
+VCHPRE_ int VCHPOST_ vc_gencmd_send_multi(const char **commands, int num_commands,
+                                          VC_GENCMD_CALLBACK_T callback, void *callback_param);
+
 /* read part of a response from the general command service */
 VCHPRE_ int VCHPOST_ vc_gencmd_read_response_partial(char *response, int nbytes);
 
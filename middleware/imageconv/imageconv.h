@@ -183,6 +183,23 @@ typedef int (*IMAGECONV_NOTIFY)(const IMAGE_CONVERT_CLASS_T *converter,
 typedef void (*IMAGECONV_CANCEL_NOTIFY)(const IMAGE_CONVERT_CLASS_T *converter,
                                         IMAGECONV_DRIVER_IMAGE_T *image);
 
+/* Convert one tile of src to dest.
+ *
+ * The tile rectangle is given in pixels and must be aligned to the tile
+ * granularity reported by imageconv_get_tile_size() for the destination type.
+ * Tiles are independent of each other, so the conversion engine may run this
+ * from several worker cores concurrently for different tiles of the same
+ * frame.
+ *
+ * May be NULL if the converter only supports full-frame conversion, in which
+ * case imageconv_convert_tiled() falls back to IMAGECONV_CONVERT.
+ */
+typedef int (*IMAGECONV_CONVERT_TILE)(const IMAGE_CONVERT_CLASS_T *converter,
+      MEM_HANDLE_T dest, uint32_t dest_offset,
+      MEM_HANDLE_T src, uint32_t src_offset, VC_IMAGE_TYPE_T dest_type,
+      uint32_t tile_x, uint32_t tile_y,
+      uint32_t tile_width, uint32_t tile_height);
+
 typedef enum IMAGECONV_ID_T {
     IMAGECONV_ID_MMAL,        /**< MMAL opaque buffer to Khronos */
     IMAGECONV_ID_KHRONOS,     /**< YV12 to Khronos */
@@ -209,6 +226,9 @@ struct IMAGE_CONVERT_CLASS_T {
     IMAGECONV_NOTIFY                notify;
     IMAGECONV_CANCEL_NOTIFY         cancel_notify;
     IMAGECONV_ID_T                  id;
+    /* New members must be added at the end to keep existing converter class
+     * definitions valid. */
+    IMAGECONV_CONVERT_TILE          convert_tile;
 };
 
 typedef enum IMAGECONV_ERR_T {
@@ -444,5 +464,45 @@ int imageconv_notify(const IMAGE_CONVERT_CLASS_T *converter,
 void imageconv_cancel_notify(const IMAGE_CONVERT_CLASS_T *converter,
                              IMAGECONV_DRIVER_IMAGE_T *image);
 
+/** Get the tile granularity used by imageconv_convert_tiled() for a given
+ * destination type.
+ *
+ * Tile rectangles passed to IMAGECONV_CONVERT_TILE are multiples of this size,
+ * except at the right and bottom edges of the frame.
+ *
+ * @param converter    converter functions for this image
+ * @param dest_type    The desired type of the destination image.
+ * @param tile_width   width of a tile in pixels
+ * @param tile_height  height of a tile in pixels
+ *
+ * @return IMAGECONV_ERR_NOT_SUPPORTED if the converter does not support tiling
+ * @return IMAGECONV_ERR_NONE on success
+ */
+int imageconv_get_tile_size(const IMAGE_CONVERT_CLASS_T *converter,
+                            VC_IMAGE_TYPE_T dest_type,
+                            uint32_t *tile_width, uint32_t *tile_height);
+
+/** Converts the image writing the result to the memory specified at
+ * dst, dst_offset, splitting the frame into tiles which are converted
+ * on the available worker cores in parallel.
+ *
+ * Equivalent to imageconv_convert() if the converter class does not
+ * provide a tile conversion function, or if only one worker is configured.
+ *
+ * @return IMAGECONV_ERR_NOT_SUPPORTED if not implemented by the converter class
+ * @return IMAGECONV_ERR_NONE on success
+ * @return IMAGECONV_ERR_GENERAL on failure
+ */
+int imageconv_convert_tiled(const IMAGE_CONVERT_CLASS_T *converter,
+                            MEM_HANDLE_T dest, uint32_t dest_offset,
+                            MEM_HANDLE_T src, uint32_t src_offset,
+                            VC_IMAGE_TYPE_T dest_type);
+
+/** Set the number of worker cores used by imageconv_convert_tiled().
+ *
+ * @param num_workers  number of workers; 1 forces single-core conversion
+ */
+void imageconv_set_num_workers(uint32_t num_workers);
+
 #endif
 